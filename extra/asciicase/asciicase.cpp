@@ -0,0 +1,159 @@
+// Runtime dispatch and the scalar (SWAR) back end.
+#include "asciicase.h"
+#include "asciicase_kernels.h"
+
+#include "../isa/dispatch.h"
+
+namespace asciicase {
+
+namespace {
+
+struct implementation {
+  backend kind;
+  const char *name;
+  uint32_t required_instruction_sets;
+  const functions &(*table)();
+};
+
+const implementation scalar = {backend::scalar, "scalar", 0,
+                               scalar_functions};
+const implementation avx2 = {backend::avx2, "avx2", instruction_set::AVX2,
+                             avx2_functions};
+const implementation avx512 = {
+    backend::avx512, "avx512",
+    instruction_set::AVX512F | instruction_set::AVX512BW, avx512_functions};
+
+const implementation *const implementations[] = {&avx512, &avx2, &scalar};
+
+const implementation *best() {
+  static const implementation *best =
+      isa::first_supported(implementations, &scalar);
+  return best;
+}
+
+// nullptr if unknown or unsupported
+const implementation *find(backend kind) {
+  if (kind == backend::automatic) {
+    return best();
+  }
+  return isa::find(implementations, kind);
+}
+
+// The functions of each back end, nullptr if unsupported, found once: the
+// strings are often short and the calls many.
+const functions *table(backend kind) {
+  struct tables {
+    const functions *of[4];
+
+    tables() {
+      for (int k = 0; k < 4; k++) {
+        const implementation *impl = find(backend(k));
+        of[k] = impl == nullptr ? nullptr : &impl->table();
+      }
+    }
+  };
+  static const tables t;
+  return unsigned(kind) < 4 ? t.of[unsigned(kind)] : nullptr;
+}
+
+void scalar_to_lower(uint8_t *data, size_t n) {
+  fold_words<to_lower_word>(data, 0, n);
+}
+
+void scalar_to_upper(uint8_t *data, size_t n) {
+  fold_words<to_upper_word>(data, 0, n);
+}
+
+bool scalar_equal(const uint8_t *a, const uint8_t *b, size_t n) {
+  return equal_words(a, b, 0, n);
+}
+
+uint64_t scalar_hash(const uint8_t *data, size_t n, uint64_t seed) {
+  hash_state state(seed);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    state.stripe(to_lower_word(load_word(data + i)),
+                 to_lower_word(load_word(data + i + 8)),
+                 to_lower_word(load_word(data + i + 16)),
+                 to_lower_word(load_word(data + i + 24)));
+  }
+  return state.finish(data, i, n, seed);
+}
+
+// Up to 16 bytes, most header names, without the call through the table:
+// one word, or two that may overlap.
+bool short_equal(const uint8_t *a, const uint8_t *b, size_t n) {
+  if (n < 8) {
+    return to_lower_word(load_partial(a, n)) ==
+           to_lower_word(load_partial(b, n));
+  }
+  return ((to_lower_word(load_word(a)) ^ to_lower_word(load_word(b))) |
+          (to_lower_word(load_word(a + n - 8)) ^
+           to_lower_word(load_word(b + n - 8)))) == 0;
+}
+
+const uint8_t *bytes(const char *p) {
+  return reinterpret_cast<const uint8_t *>(p);
+}
+uint8_t *bytes(char *p) { return reinterpret_cast<uint8_t *>(p); }
+
+} // namespace
+
+const functions &scalar_functions() {
+  static const functions scalar = {scalar_to_lower, scalar_to_upper,
+                                   scalar_equal, scalar_hash};
+  return scalar;
+}
+
+bool backend_supported(backend b) { return find(b) != nullptr; }
+
+backend active_backend() { return best()->kind; }
+
+const char *backend_name(backend b) {
+  if (b == backend::automatic) {
+    return best()->name;
+  }
+  return isa::name_of(implementations, b);
+}
+
+void to_lower(char *data, size_t n, const options &o) {
+  const functions *f = table(o.kernel);
+  if (f != nullptr) {
+    f->to_lower(bytes(data), n);
+  }
+}
+
+void to_upper(char *data, size_t n, const options &o) {
+  const functions *f = table(o.kernel);
+  if (f != nullptr) {
+    f->to_upper(bytes(data), n);
+  }
+}
+
+bool equal_ignore_case(const char *a, size_t na, const char *b, size_t nb,
+                       const options &o) {
+  const functions *f = table(o.kernel);
+  if (f == nullptr || na != nb) {
+    return false;
+  }
+  return na <= 16 ? short_equal(bytes(a), bytes(b), na)
+                  : f->equal(bytes(a), bytes(b), na);
+}
+
+bool starts_with_ignore_case(const char *s, size_t n, const char *prefix,
+                             size_t m, const options &o) {
+  const functions *f = table(o.kernel);
+  if (f == nullptr || m > n) {
+    return false;
+  }
+  return m <= 16 ? short_equal(bytes(s), bytes(prefix), m)
+                 : f->equal(bytes(s), bytes(prefix), m);
+}
+
+uint64_t hash_ignore_case(const char *data, size_t n, uint64_t seed,
+                          const options &o) {
+  const functions *f = table(o.kernel);
+  return f == nullptr ? 0 : f->hash(bytes(data), n, seed);
+}
+
+} // namespace asciicase
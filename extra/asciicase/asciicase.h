@@ -0,0 +1,65 @@
+// ASCII case folding over whole strings with AVX2 or AVX-512, picked at
+// runtime: lower and upper case in place, equality and prefixes ignoring
+// case, and a hash of the lower case.
+//
+// 2020/04/30/tolower.cpp folds 8 bytes at a time in a 64-bit word (SWAR,
+// after Wojciech Muła) and compares strings that way. The scalar back end
+// is that code; the vector back ends fold 32 or 64 bytes at a time. AVX2
+// leaves strings under 32 bytes, and the tail of the hash, to the SWAR
+// code and ends longer strings with a vector that overlaps the one before;
+// AVX-512 ends with masked loads. Only 'A' to 'Z' and 'a' to 'z' change;
+// bytes above 0x7F are compared as they are.
+//
+//   if (asciicase::equal_ignore_case(name, n, "content-length", 14)) ...
+//   asciicase::to_lower(host, size);
+//   uint64_t h = asciicase::hash_ignore_case(name, n);
+#ifndef ASCIICASE_H
+#define ASCIICASE_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace asciicase {
+
+struct functions; // of a back end, in asciicase_kernels.h
+
+enum class backend {
+  automatic, // best supported one
+  scalar,    // SWAR, 8 bytes at a time
+  avx2,
+  avx512
+};
+
+// Whether the back end can run on this processor, and its name.
+bool backend_supported(backend b);
+backend active_backend();
+const char *backend_name(backend b);
+
+struct options {
+  backend kernel = backend::automatic;
+};
+
+// Lower or upper case of data[0, n), in place. An unsupported back end
+// leaves the data as it is.
+void to_lower(char *data, size_t n, const options &o = options());
+void to_upper(char *data, size_t n, const options &o = options());
+
+// Whether a[0, na) and b[0, nb) are the same once in lower case. An
+// unsupported back end gives false.
+bool equal_ignore_case(const char *a, size_t na, const char *b, size_t nb,
+                       const options &o = options());
+
+// Whether s[0, n) starts with prefix[0, m), ignoring case.
+bool starts_with_ignore_case(const char *s, size_t n, const char *prefix,
+                             size_t m, const options &o = options());
+
+// A 64-bit hash of the lower case of data[0, n), the same with every back
+// end: strings equal ignoring case have the same hash. It goes through
+// four accumulators in the manner of XXH64 but does not give the values of
+// XXH64. An unsupported back end gives 0.
+uint64_t hash_ignore_case(const char *data, size_t n, uint64_t seed = 0,
+                          const options &o = options());
+
+} // namespace asciicase
+
+#endif // ASCIICASE_H
@@ -0,0 +1,92 @@
+// The AVX2 back end: 32 bytes at a time. The case functions end with a
+// vector that overlaps the one before (folding twice changes nothing, and
+// comparing twice neither); inputs under 32 bytes, and the words after
+// the last stripe of the hash, go through the SWAR code. Compiled with
+// -mavx2.
+#include "asciicase_kernels.h"
+
+#include <immintrin.h>
+
+namespace asciicase {
+namespace {
+
+// flips bit 5 of the bytes from first to last
+template <char First, char Last> __m256i flip(__m256i v) {
+  // the signed comparison with the bytes moved so that First is -128
+  const __m256i moved =
+      _mm256_add_epi8(v, _mm256_set1_epi8(char(128 - First)));
+  const __m256i inside = _mm256_cmpgt_epi8(
+      _mm256_set1_epi8(char(-128 + (Last - First + 1))), moved);
+  const __m256i bit = _mm256_and_si256(inside, _mm256_set1_epi8(0x20));
+  return _mm256_xor_si256(v, bit);
+}
+
+__m256i load(const uint8_t *p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
+template <char First, char Last, uint64_t (*Fold)(uint64_t)>
+void fold(uint8_t *data, size_t n) {
+  if (n < 32) {
+    fold_words<Fold>(data, 0, n);
+    return;
+  }
+  for (size_t i = 0; i + 32 <= n; i += 32) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(data + i),
+                        flip<First, Last>(load(data + i)));
+  }
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(data + n - 32),
+                      flip<First, Last>(load(data + n - 32)));
+}
+
+void avx2_to_lower(uint8_t *data, size_t n) {
+  fold<'A', 'Z', to_lower_word>(data, n);
+}
+
+void avx2_to_upper(uint8_t *data, size_t n) {
+  fold<'a', 'z', to_upper_word>(data, n);
+}
+
+// whether the 32 bytes at a and b are the same in lower case
+bool same(const uint8_t *a, const uint8_t *b) {
+  const __m256i equal = _mm256_cmpeq_epi8(flip<'A', 'Z'>(load(a)),
+                                          flip<'A', 'Z'>(load(b)));
+  return _mm256_movemask_epi8(equal) == -1;
+}
+
+bool avx2_equal(const uint8_t *a, const uint8_t *b, size_t n) {
+  if (n < 32) {
+    return equal_words(a, b, 0, n);
+  }
+  for (size_t i = 0; i + 32 <= n; i += 32) {
+    if (!same(a + i, b + i)) {
+      return false;
+    }
+  }
+  return same(a + n - 32, b + n - 32);
+}
+
+uint64_t avx2_hash(const uint8_t *data, size_t n, uint64_t seed) {
+  hash_state state(seed);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i lower = flip<'A', 'Z'>(load(data + i));
+    const __m128i low = _mm256_castsi256_si128(lower);
+    const __m128i high = _mm256_extracti128_si256(lower, 1);
+    state.stripe(uint64_t(_mm_cvtsi128_si64(low)),
+                 uint64_t(_mm_extract_epi64(low, 1)),
+                 uint64_t(_mm_cvtsi128_si64(high)),
+                 uint64_t(_mm_extract_epi64(high, 1)));
+  }
+  return state.finish(data, i, n, seed);
+}
+
+} // namespace
+
+const functions &avx2_functions() {
+  static const functions avx2 = {avx2_to_lower, avx2_to_upper, avx2_equal,
+                                 avx2_hash};
+  return avx2;
+}
+
+} // namespace asciicase
@@ -0,0 +1,91 @@
+// The AVX-512 back end: 64 bytes at a time, the last ones with masked
+// loads and stores, so that a string under 64 bytes takes one vector
+// (strings of up to 16 bytes are folded with the SWAR code).
+// Compiled with -mavx512f -mavx512bw.
+#include "asciicase_kernels.h"
+
+#include <immintrin.h>
+
+namespace asciicase {
+namespace {
+
+// flips bit 5 of the bytes from first to last
+template <char First, char Last> __m512i flip(__m512i v) {
+  const __mmask64 inside = _mm512_cmplt_epu8_mask(
+      _mm512_sub_epi8(v, _mm512_set1_epi8(First)),
+      _mm512_set1_epi8(Last - First + 1));
+  const __m512i bit = _mm512_maskz_mov_epi8(inside, _mm512_set1_epi8(0x20));
+  return _mm512_xor_si512(v, bit);
+}
+
+__mmask64 first(size_t count) {
+  return count == 0 ? 0 : ~__mmask64(0) >> (64 - count);
+}
+
+template <char First, char Last, uint64_t (*Fold)(uint64_t)>
+void fold(uint8_t *data, size_t n) {
+  if (n <= 16) {
+    // a masked store costs more than a word or two
+    fold_words<Fold>(data, 0, n);
+    return;
+  }
+  size_t i = 0;
+  for (; i + 64 <= n; i += 64) {
+    _mm512_storeu_si512(data + i,
+                        flip<First, Last>(_mm512_loadu_si512(data + i)));
+  }
+  const __mmask64 rest = first(n - i);
+  _mm512_mask_storeu_epi8(
+      data + i, rest,
+      flip<First, Last>(_mm512_maskz_loadu_epi8(rest, data + i)));
+}
+
+void avx512_to_lower(uint8_t *data, size_t n) {
+  fold<'A', 'Z', to_lower_word>(data, n);
+}
+
+void avx512_to_upper(uint8_t *data, size_t n) {
+  fold<'a', 'z', to_upper_word>(data, n);
+}
+
+bool avx512_equal(const uint8_t *a, const uint8_t *b, size_t n) {
+  size_t i = 0;
+  for (; i + 64 <= n; i += 64) {
+    if (_mm512_cmpneq_epi8_mask(flip<'A', 'Z'>(_mm512_loadu_si512(a + i)),
+                                flip<'A', 'Z'>(_mm512_loadu_si512(b + i)))) {
+      return false;
+    }
+  }
+  const __mmask64 rest = first(n - i);
+  return _mm512_cmpneq_epi8_mask(
+             flip<'A', 'Z'>(_mm512_maskz_loadu_epi8(rest, a + i)),
+             flip<'A', 'Z'>(_mm512_maskz_loadu_epi8(rest, b + i))) == 0;
+}
+
+uint64_t avx512_hash(const uint8_t *data, size_t n, uint64_t seed) {
+  hash_state state(seed);
+  size_t i = 0;
+  uint64_t words[8];
+  for (; i + 64 <= n; i += 64) {
+    _mm512_storeu_si512(words, flip<'A', 'Z'>(_mm512_loadu_si512(data + i)));
+    state.stripe(words[0], words[1], words[2], words[3]);
+    state.stripe(words[4], words[5], words[6], words[7]);
+  }
+  if (i + 32 <= n) {
+    _mm512_storeu_si512(
+        words, flip<'A', 'Z'>(_mm512_maskz_loadu_epi8(first(32), data + i)));
+    state.stripe(words[0], words[1], words[2], words[3]);
+    i += 32;
+  }
+  return state.finish(data, i, n, seed);
+}
+
+} // namespace
+
+const functions &avx512_functions() {
+  static const functions avx512 = {avx512_to_lower, avx512_to_upper,
+                                   avx512_equal, avx512_hash};
+  return avx512;
+}
+
+} // namespace asciicase
@@ -0,0 +1,185 @@
+// The functions of each back end, and the SWAR code of
+// 2020/04/30/tolower.cpp and the hash that all of them share. Only the
+// asciicase*.cpp files include this header.
+#ifndef ASCIICASE_KERNELS_H
+#define ASCIICASE_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "asciicase.h"
+
+namespace asciicase {
+
+struct functions {
+  void (*to_lower)(uint8_t *data, size_t n);
+  void (*to_upper)(uint8_t *data, size_t n);
+  bool (*equal)(const uint8_t *a, const uint8_t *b, size_t n);
+  uint64_t (*hash)(const uint8_t *data, size_t n, uint64_t seed);
+};
+
+const functions &scalar_functions();
+const functions &avx2_functions();
+const functions &avx512_functions();
+
+// In an unnamed namespace: each back end compiles its own copy with its
+// own instruction sets, so that the linker cannot pick the AVX2 copy for
+// the scalar back end.
+namespace {
+
+constexpr uint64_t packed_byte(uint8_t b) {
+  // replicate the byte 8 times
+  return uint64_t(b) * uint64_t(0x0101010101010101);
+}
+
+// 0x80 in the bytes of chars from first to last, from 2020/04/30/tolower.cpp
+inline uint64_t in_range(uint64_t chars, uint8_t first, uint8_t last) {
+  const uint64_t ascii_chars = chars & packed_byte(0x7f);
+  // the sign bit is set from first on, then from last + 1 on
+  const uint64_t from_first = ascii_chars + packed_byte(uint8_t(128 - first));
+  const uint64_t after_last =
+      ascii_chars + packed_byte(uint8_t(128 - last - 1));
+  return (from_first ^ after_last) & ~chars & packed_byte(0x80);
+}
+
+inline uint64_t to_lower_word(uint64_t chars) {
+  return chars ^ (in_range(chars, 'A', 'Z') >> 2);
+}
+
+inline uint64_t to_upper_word(uint64_t chars) {
+  return chars ^ (in_range(chars, 'a', 'z') >> 2);
+}
+
+inline uint64_t load_word(const uint8_t *p) {
+  uint64_t w;
+  memcpy(&w, p, sizeof(w));
+  return w;
+}
+
+// The count < 8 bytes at p, then zeros, and back: in pieces of 4, 2 and 1
+// bytes, since a memcpy of a variable size is a call to the library.
+inline uint64_t load_partial(const uint8_t *p, size_t count) {
+  uint64_t w = 0;
+  size_t k = 0;
+  if (count & 4) {
+    uint32_t x;
+    memcpy(&x, p, sizeof(x));
+    w = x;
+    k = 4;
+  }
+  if (count & 2) {
+    uint16_t x;
+    memcpy(&x, p + k, sizeof(x));
+    w |= uint64_t(x) << (8 * k);
+    k += 2;
+  }
+  if (count & 1) {
+    w |= uint64_t(p[k]) << (8 * k);
+  }
+  return w;
+}
+
+inline void store_partial(uint8_t *p, size_t count, uint64_t w) {
+  size_t k = 0;
+  if (count & 4) {
+    const uint32_t x = uint32_t(w);
+    memcpy(p, &x, sizeof(x));
+    k = 4;
+  }
+  if (count & 2) {
+    const uint16_t x = uint16_t(w >> (8 * k));
+    memcpy(p + k, &x, sizeof(x));
+    k += 2;
+  }
+  if (count & 1) {
+    p[k] = uint8_t(w >> (8 * k));
+  }
+}
+
+// data[i, n) 8 bytes at a time, then the last ones
+template <uint64_t (*Fold)(uint64_t)>
+void fold_words(uint8_t *data, size_t i, size_t n) {
+  for (; i + 8 <= n; i += 8) {
+    const uint64_t w = Fold(load_word(data + i));
+    memcpy(data + i, &w, sizeof(w));
+  }
+  store_partial(data + i, n - i, Fold(load_partial(data + i, n - i)));
+}
+
+inline bool equal_words(const uint8_t *a, const uint8_t *b, size_t i,
+                        size_t n) {
+  for (; i + 8 <= n; i += 8) {
+    if (to_lower_word(load_word(a + i)) != to_lower_word(load_word(b + i))) {
+      return false;
+    }
+  }
+  return to_lower_word(load_partial(a + i, n - i)) ==
+         to_lower_word(load_partial(b + i, n - i));
+}
+
+// The hash: stripes of 32 bytes, as four words, go to four accumulators;
+// the words and bytes after the last stripe go to the merged value.
+
+constexpr uint64_t prime1 = 0x9E3779B185EBCA87;
+constexpr uint64_t prime2 = 0xC2B2AE3D27D4EB4F;
+constexpr uint64_t prime3 = 0x165667B19E3779F9;
+constexpr uint64_t prime4 = 0x85EBCA77C2B2AE63;
+constexpr uint64_t prime5 = 0x27D4EB2F165667C5;
+
+inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline uint64_t round(uint64_t acc, uint64_t word) {
+  return rotl(acc + word * prime2, 31) * prime1;
+}
+
+struct hash_state {
+  uint64_t acc[4];
+
+  explicit hash_state(uint64_t seed)
+      : acc{seed + prime1 + prime2, seed + prime2, seed, seed - prime1} {}
+
+  // the four words of a stripe, in lower case
+  void stripe(uint64_t w0, uint64_t w1, uint64_t w2, uint64_t w3) {
+    acc[0] = round(acc[0], w0);
+    acc[1] = round(acc[1], w1);
+    acc[2] = round(acc[2], w2);
+    acc[3] = round(acc[3], w3);
+  }
+
+  // data[i, n) follows the stripes, with i a multiple of 32 and i + 32 > n
+  uint64_t finish(const uint8_t *data, size_t i, size_t n,
+                  uint64_t seed) const {
+    uint64_t h;
+    if (n >= 32) {
+      h = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) +
+          rotl(acc[3], 18);
+      for (uint64_t a : acc) {
+        h = (h ^ round(0, a)) * prime1 + prime4;
+      }
+    } else {
+      h = seed + prime5;
+    }
+    h += n;
+    for (; i + 8 <= n; i += 8) {
+      h ^= round(0, to_lower_word(load_word(data + i)));
+      h = rotl(h, 27) * prime1 + prime4;
+    }
+    if (i < n) {
+      h ^= to_lower_word(load_partial(data + i, n - i)) * prime5;
+      h = rotl(h, 11) * prime1;
+    }
+    h ^= h >> 33;
+    h *= prime2;
+    h ^= h >> 29;
+    h *= prime3;
+    h ^= h >> 32;
+    return h;
+  }
+};
+
+} // namespace
+
+} // namespace asciicase
+
+#endif // ASCIICASE_KERNELS_H
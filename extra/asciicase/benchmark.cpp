@@ -0,0 +1,202 @@
+// Nanoseconds per string for strings of 8 to 4096 bytes (256 KiB of them
+// per run): equality ignoring case (with strncasecmp as the baseline),
+// lower case in place and the hash, with each back end; then the lookup
+// of HTTP header names in random case among 24 known names, as a proxy
+// does.
+#include "asciicase.h"
+
+#include "../harness/harness.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <strings.h>
+#include <vector>
+
+namespace {
+
+const asciicase::backend backends[] = {asciicase::backend::scalar,
+                                       asciicase::backend::avx2,
+                                       asciicase::backend::avx512};
+
+const char *headers[] = {
+    "accept",          "accept-encoding",   "accept-language",
+    "authorization",   "cache-control",     "connection",
+    "content-encoding", "content-length",   "content-type",
+    "cookie",          "date",              "etag",
+    "expires",         "host",              "if-modified-since",
+    "if-none-match",   "last-modified",     "location",
+    "referer",         "server",            "set-cookie",
+    "transfer-encoding", "user-agent",      "x-forwarded-for"};
+
+std::string random_case(std::string s, std::mt19937_64 &gen) {
+  for (char &c : s) {
+    if (c >= 'a' && c <= 'z' && gen() % 2) {
+      c = char(c - 32);
+    }
+  }
+  return s;
+}
+
+// ns per string of F() over count strings; 0 when not supported
+template <class F>
+double time(const char *name, size_t count, size_t bytes, F f,
+            harness::options &opts, bool *ok) {
+  auto r = harness::run(name, bytes, [&] {
+    const size_t matches = f();
+    *ok = *ok && matches == count;
+    harness::do_not_optimize(matches);
+  }, opts);
+  if (opts.format != HARNESS_TEXT) {
+    r.report();
+  }
+  return r.min() / count;
+}
+
+// "-" where there is no baseline or no back end
+void print(const char *operation, const char *length, const double *ns) {
+  printf("%-10s\t%6s", operation, length);
+  for (int k = 0; k < 4; k++) {
+    if (ns[k] == 0) {
+      printf("\t%8s", "-");
+    } else {
+      printf("\t%8.2f", ns[k]);
+    }
+  }
+  printf("\n");
+}
+
+bool run_lengths(harness::options &opts, std::mt19937_64 &gen) {
+  bool ok = true;
+  const size_t lengths[] = {8, 16, 32, 64, 256, 4096};
+  for (size_t length : lengths) {
+    const size_t count = (256 << 10) / length;
+    std::string a(count * length, '\0');
+    for (char &c : a) {
+      c = char(' ' + gen() % 95);
+    }
+    const std::string b = random_case(a, gen);
+    std::string c = a;
+    double equal[4] = {0, 0, 0, 0}, lower[4] = {0, 0, 0, 0},
+           hash[4] = {0, 0, 0, 0};
+    equal[0] = time("strncasecmp", count, a.size(), [&] {
+      size_t matches = 0;
+      for (size_t k = 0; k < count; k++) {
+        matches += strncasecmp(a.data() + k * length, b.data() + k * length,
+                               length) == 0;
+      }
+      return matches;
+    }, opts, &ok);
+    for (int j = 0; j < 3; j++) {
+      asciicase::options o;
+      o.kernel = backends[j];
+      if (!asciicase::backend_supported(o.kernel)) {
+        continue;
+      }
+      equal[j + 1] = time("equal", count, a.size(), [&] {
+        size_t matches = 0;
+        for (size_t k = 0; k < count; k++) {
+          matches += asciicase::equal_ignore_case(
+              a.data() + k * length, length, b.data() + k * length, length,
+              o);
+        }
+        return matches;
+      }, opts, &ok);
+      lower[j + 1] = time("to_lower", count, a.size(), [&] {
+        for (size_t k = 0; k < count; k++) {
+          asciicase::to_lower(&c[k * length], length, o);
+        }
+        return count;
+      }, opts, &ok);
+      hash[j + 1] = time("hash", count, a.size(), [&] {
+        uint64_t sum = 0;
+        for (size_t k = 0; k < count; k++) {
+          sum += asciicase::hash_ignore_case(b.data() + k * length, length,
+                                             0, o);
+        }
+        harness::do_not_optimize(sum);
+        return count;
+      }, opts, &ok);
+    }
+    if (opts.format == HARNESS_TEXT) {
+      const std::string l = std::to_string(length);
+      print("equal", l.c_str(), equal);
+      print("to_lower", l.c_str(), lower);
+      print("hash", l.c_str(), hash);
+    }
+  }
+  return ok;
+}
+
+bool run_headers(harness::options &opts, std::mt19937_64 &gen) {
+  const size_t known = sizeof(headers) / sizeof(headers[0]);
+  std::vector<std::string> requests;
+  for (int k = 0; k < 10000; k++) {
+    requests.push_back(random_case(headers[gen() % known], gen));
+  }
+  size_t bytes = 0;
+  for (const std::string &r : requests) {
+    bytes += r.size();
+  }
+  std::vector<size_t> lengths;
+  for (const char *h : headers) {
+    lengths.push_back(strlen(h));
+  }
+  bool ok = true;
+  double ns[4] = {0, 0, 0, 0};
+  ns[0] = time("strncasecmp", requests.size(), bytes, [&] {
+    size_t found = 0;
+    for (const std::string &r : requests) {
+      for (size_t h = 0; h < known; h++) {
+        if (r.size() == lengths[h] &&
+            strncasecmp(r.data(), headers[h], r.size()) == 0) {
+          found++;
+          break;
+        }
+      }
+    }
+    return found;
+  }, opts, &ok);
+  for (int j = 0; j < 3; j++) {
+    asciicase::options o;
+    o.kernel = backends[j];
+    if (!asciicase::backend_supported(o.kernel)) {
+      continue;
+    }
+    ns[j + 1] = time("lookup", requests.size(), bytes, [&] {
+      size_t found = 0;
+      for (const std::string &r : requests) {
+        for (size_t h = 0; h < known; h++) {
+          if (asciicase::equal_ignore_case(r.data(), r.size(), headers[h],
+                                           lengths[h], o)) {
+            found++;
+            break;
+          }
+        }
+      }
+      return found;
+    }, opts, &ok);
+  }
+  if (opts.format == HARNESS_TEXT) {
+    print("headers", "-", ns);
+  }
+  return ok;
+}
+
+} // namespace
+
+int main() {
+  std::mt19937_64 gen(1234);
+  harness::options opts = harness::default_options();
+  opts.repeat = 20;
+  printf("ns per string, best back end: %s\n",
+         asciicase::backend_name(asciicase::active_backend()));
+  printf("operation \tlength\tstrncasecmp\tscalar  \tavx2    \tavx512\n");
+  if (!run_lengths(opts, gen) || !run_headers(opts, gen)) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
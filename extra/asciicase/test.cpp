@@ -0,0 +1,187 @@
+// Checks of every back end against plain loops at every length up to 300
+// and on longer strings: the case of all 256 byte values, equality with
+// random changes of case and of one byte (among them the pairs that differ
+// by 0x20 without being letters, such as '@' and '`'), prefixes, and a
+// hash that must not depend on the back end or on case. The back ends
+// this processor lacks, and an unknown one, must do nothing and give false
+// and 0, short strings included.
+#include "asciicase.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const asciicase::backend backends[] = {
+    asciicase::backend::automatic, asciicase::backend::scalar,
+    asciicase::backend::avx2, asciicase::backend::avx512};
+
+std::mt19937_64 gen(1234);
+
+char lower(char c) { return c >= 'A' && c <= 'Z' ? char(c + 32) : c; }
+char upper(char c) { return c >= 'a' && c <= 'z' ? char(c - 32) : c; }
+
+std::string random_string(size_t n) {
+  std::string s(n, '\0');
+  for (char &c : s) {
+    // mostly letters, then any byte
+    c = gen() % 4 == 0 ? char(gen()) : char('A' + gen() % 58);
+  }
+  return s;
+}
+
+// s with the case of its letters changed at random
+std::string shuffle_case(std::string s) {
+  for (char &c : s) {
+    c = gen() % 2 ? lower(c) : upper(c);
+  }
+  return s;
+}
+
+bool check(const std::string &s, asciicase::backend b, uint64_t *hash) {
+  asciicase::options o;
+  o.kernel = b;
+  std::string lowered = s, uppered = s, expected_lower = s,
+              expected_upper = s;
+  for (char &c : expected_lower) {
+    c = lower(c);
+  }
+  for (char &c : expected_upper) {
+    c = upper(c);
+  }
+  asciicase::to_lower(&lowered[0], s.size(), o);
+  asciicase::to_upper(&uppered[0], s.size(), o);
+  const std::string other = shuffle_case(s);
+  bool ok = lowered == expected_lower && uppered == expected_upper &&
+            asciicase::equal_ignore_case(s.data(), s.size(), other.data(),
+                                         other.size(), o);
+  if (!s.empty()) {
+    // one byte changed: equal only if it is the same letter
+    std::string changed = other;
+    const size_t k = gen() % s.size();
+    const char pairs[] = "@`[{]}^~_\x7f";
+    changed[k] = gen() % 2 ? char(gen()) : pairs[gen() % (sizeof(pairs) - 1)];
+    ok = ok && asciicase::equal_ignore_case(s.data(), s.size(),
+                                            changed.data(), changed.size(),
+                                            o) == (lower(changed[k]) ==
+                                                   lower(s[k]));
+    ok = ok && !asciicase::equal_ignore_case(s.data(), s.size(),
+                                             other.data(), s.size() - 1, o);
+    const size_t m = gen() % (s.size() + 1);
+    ok = ok &&
+         asciicase::starts_with_ignore_case(s.data(), s.size(), other.data(),
+                                            m, o) &&
+         asciicase::starts_with_ignore_case(changed.data(), s.size(),
+                                            other.data(), k, o) &&
+         !asciicase::starts_with_ignore_case(s.data(), m, other.data(),
+                                             s.size() + 1, o);
+  }
+  const uint64_t h = asciicase::hash_ignore_case(s.data(), s.size(), 7, o);
+  ok = ok &&
+       h == asciicase::hash_ignore_case(other.data(), other.size(), 7, o) &&
+       h != asciicase::hash_ignore_case(s.data(), s.size(), 8, o);
+  if (b != asciicase::backend::automatic && *hash != h) {
+    ok = false;
+  }
+  if (!ok) {
+    printf("bug: %s, %zu bytes\n", asciicase::backend_name(b), s.size());
+  }
+  return ok;
+}
+
+bool check_all(const std::string &s) {
+  uint64_t hash = asciicase::hash_ignore_case(
+      s.data(), s.size(), 7, asciicase::options());
+  for (asciicase::backend b : backends) {
+    if (asciicase::backend_supported(b) && !check(s, b, &hash)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool check_strings() {
+  std::string every(256, '\0');
+  for (int b = 0; b < 256; b++) {
+    every[b] = char(b);
+  }
+  if (!check_all(every)) {
+    return false;
+  }
+  for (size_t n = 0; n <= 300; n++) {
+    for (int k = 0; k < 20; k++) {
+      if (!check_all(random_string(n))) {
+        return false;
+      }
+    }
+  }
+  for (int k = 0; k < 100; k++) {
+    if (!check_all(random_string(300 + gen() % 10000))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool check_hash() {
+  // a change of one bit or of the length changes the hash
+  const std::string s = random_string(100);
+  for (size_t n = 0; n <= s.size(); n++) {
+    const uint64_t h = asciicase::hash_ignore_case(s.data(), n);
+    if (n > 0 && h == asciicase::hash_ignore_case(s.data(), n - 1)) {
+      return false;
+    }
+    for (size_t k = 0; k < n; k++) {
+      std::string t = s;
+      t[k] ^= 1;
+      if (h == asciicase::hash_ignore_case(t.data(), n)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool check_unsupported() {
+  std::vector<asciicase::backend> missing = {asciicase::backend(7)};
+  for (asciicase::backend b : backends) {
+    if (!asciicase::backend_supported(b)) {
+      missing.push_back(b);
+    }
+  }
+  for (asciicase::backend b : missing) {
+    asciicase::options o;
+    o.kernel = b;
+    for (size_t n : {size_t(0), size_t(5), size_t(16), size_t(100)}) {
+      const std::string s = random_string(n);
+      std::string t = s;
+      asciicase::to_lower(&t[0], n, o);
+      asciicase::to_upper(&t[0], n, o);
+      if (t != s ||
+          asciicase::equal_ignore_case(s.data(), n, s.data(), n, o) ||
+          asciicase::starts_with_ignore_case(s.data(), n, s.data(), n, o) ||
+          asciicase::hash_ignore_case(s.data(), n, 7, o) != 0) {
+        printf("bug: %s, unsupported, %zu bytes\n",
+               asciicase::backend_name(b), n);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main() {
+  printf("best back end: %s\n",
+         asciicase::backend_name(asciicase::active_backend()));
+  if (!check_strings() || !check_hash() || !check_unsupported()) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,210 @@
+// Runtime dispatch and the scalar back end.
+#include "base64.h"
+#include "base64_kernels.h"
+
+#include "../isa/dispatch.h"
+
+namespace base64 {
+
+namespace {
+
+struct implementation {
+  backend kind;
+  const char *name;
+  uint32_t required_instruction_sets;
+  const functions &(*table)();
+};
+
+const implementation scalar = {backend::scalar, "scalar", 0,
+                               scalar_functions};
+const implementation avx2 = {backend::avx2, "avx2", instruction_set::AVX2,
+                             avx2_functions};
+const implementation avx512 = {
+    backend::avx512, "avx512",
+    instruction_set::AVX512 | instruction_set::AVX512VBMI |
+        instruction_set::AVX512VBMI2 | instruction_set::BMI2,
+    avx512_functions};
+
+const implementation *const implementations[] = {&avx512, &avx2, &scalar};
+
+const implementation *best() {
+  static const implementation *best =
+      isa::first_supported(implementations, &scalar);
+  return best;
+}
+
+// nullptr if unknown or unsupported
+const implementation *find(backend kind) {
+  if (kind == backend::automatic) {
+    return best();
+  }
+  return isa::find(implementations, kind);
+}
+
+// The functions of each back end, nullptr if unsupported, found once: a
+// token or a header is short, and the calls many.
+const functions *table(backend kind) {
+  struct function_tables {
+    const functions *of[4];
+
+    function_tables() {
+      for (int k = 0; k < 4; k++) {
+        const implementation *impl = find(backend(k));
+        of[k] = impl == nullptr ? nullptr : &impl->table();
+      }
+    }
+  };
+  static const function_tables t;
+  return unsigned(kind) < 4 ? t.of[unsigned(kind)] : nullptr;
+}
+
+constexpr tables standard_tables(
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/");
+constexpr tables url_tables(
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_");
+
+size_t scalar_decode(const uint8_t *in, size_t n, uint8_t *out,
+                     size_t *written, bool, const tables &t) {
+  const size_t taken = decode_groups(in, 0, n, out, t);
+  *written = taken / 4 * 3;
+  return taken;
+}
+
+size_t scalar_encode(const uint8_t *in, size_t n, char *out,
+                     const tables &t) {
+  return encode_groups(in, 0, n, out, t);
+}
+
+// the whitespace of MIME and of the forgiving-base64 of the WHATWG
+bool is_space(uint8_t c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\f' || c == '\r';
+}
+
+// The first k bytes of a group of k + 1 characters, 6 bits each in bits.
+void write_partial(uint32_t bits, int k, uint8_t *out) {
+  bits <<= 6 * (3 - k); // as if the group were complete
+  for (int b = 0; b < k; b++) {
+    out[b] = uint8_t(bits >> (16 - 8 * b));
+  }
+}
+
+} // namespace
+
+const functions &scalar_functions() {
+  static const functions scalar = {scalar_decode, scalar_encode};
+  return scalar;
+}
+
+bool backend_supported(backend b) { return find(b) != nullptr; }
+
+backend active_backend() { return best()->kind; }
+
+const char *backend_name(backend b) {
+  if (b == backend::automatic) {
+    return best()->name;
+  }
+  return isa::name_of(implementations, b);
+}
+
+// The back end takes the runs of whole groups; what stops it (whitespace
+// it does not skip, padding, the last characters, an error) goes one
+// group at a time here, and the back end takes over again after
+// whitespace.
+result decode(const char *text, size_t n, uint8_t *out, const options &o) {
+  const functions *f = table(o.kernel);
+  if (f == nullptr) {
+    return {false, 0, 0};
+  }
+  const tables &t =
+      o.letters == alphabet::url ? url_tables : standard_tables;
+  const uint8_t *in = reinterpret_cast<const uint8_t *>(text);
+  size_t i = 0;
+  size_t count = 0;
+  for (;;) {
+    size_t written = 0;
+    i += f->decode(in + i, n - i, out + count, &written, o.skip_whitespace,
+                   t);
+    count += written;
+    bool skipped = false;
+    do {
+      // up to 4 characters of the alphabet from i, and what stopped us
+      uint32_t bits = 0;
+      int k = 0;
+      size_t start = n;
+      size_t j = i;
+      for (; j < n && k < 4; j++) {
+        const uint8_t v = t.value[in[j]];
+        if (v < 64) {
+          start = k == 0 ? j : start;
+          bits = bits << 6 | v;
+          k++;
+        } else if (o.skip_whitespace && is_space(in[j])) {
+          skipped = true;
+        } else {
+          break;
+        }
+      }
+      if (k == 4) {
+        write_partial(bits, 3, out + count);
+        count += 3;
+        i = j;
+        continue;
+      }
+      if (j == n) {
+        if (k == 1) {
+          return {false, start, count};
+        }
+        // without padding: 0, 1 or 2 more bytes
+        write_partial(bits, k > 0 ? k - 1 : 0, out + count);
+        count += k > 0 ? k - 1 : 0;
+        return {true, n, count};
+      }
+      if (in[j] != '=' || k < 2) {
+        return {false, j, count};
+      }
+      // 4 - k of '=', then nothing but whitespace
+      int padding = 0;
+      for (; j < n; j++) {
+        if (in[j] == '=' && padding < 4 - k) {
+          padding++;
+        } else if (!(o.skip_whitespace && is_space(in[j]))) {
+          break;
+        }
+      }
+      if (padding < 4 - k) {
+        return {false, j == n ? start : j, count};
+      }
+      write_partial(bits, k - 1, out + count);
+      count += k - 1;
+      return {j == n, j, count};
+    } while (!skipped);
+  }
+}
+
+size_t encode(const uint8_t *in, size_t n, char *out, const options &o) {
+  const functions *f = table(o.kernel);
+  if (f == nullptr) {
+    return 0;
+  }
+  const tables &t =
+      o.letters == alphabet::url ? url_tables : standard_tables;
+  const size_t i = f->encode(in, n, out, t);
+  char *chars = out + i / 3 * 4;
+  if (i + 1 == n) {
+    chars[0] = t.digits[in[i] >> 2];
+    chars[1] = t.digits[(in[i] & 3) << 4];
+  } else if (i + 2 == n) {
+    chars[0] = t.digits[in[i] >> 2];
+    chars[1] = t.digits[(in[i] & 3) << 4 | in[i + 1] >> 4];
+    chars[2] = t.digits[(in[i + 1] & 15) << 2];
+  }
+  if (o.padding && i < n) {
+    chars[3] = '=';
+    if (i + 1 == n) {
+      chars[2] = '=';
+    }
+  }
+  return encoded_length(n, o);
+}
+
+} // namespace base64
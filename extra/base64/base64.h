@@ -0,0 +1,101 @@
+// Base64 text to bytes and back (RFC 4648), for buffers of any length,
+// with AVX2 or AVX-512 picked at runtime: the standard alphabet ('+' and
+// '/') or the URL one ('-' and '_'), padding optional, whitespace skipped
+// if asked, and the offset of the first character that is not valid.
+//
+// The number and hex parsers of this repository (2018/09/30/
+// identifynumbers.c, 2019/04/17/hexparse.cpp) classify characters by
+// their two nibbles with shuffles; base64 is the same problem with 64
+// digits. The AVX2 back end looks each nibble up in a table of bit sets
+// (the character is valid when its two sets do not meet), adds to each
+// character an offset picked by its high nibble, and packs the 6-bit
+// values with two multiply-adds, as Wojciech Muła and Daniel Lemire do
+// ("Faster Base64 Encoding and Decoding Using AVX2 Instructions", 2018).
+// The AVX-512 back end looks the 64 characters of a vector up in a table
+// of the 128 ASCII characters with one byte permutation (VBMI), squeezes
+// whitespace out with vpcompressb (VBMI2), and encodes with a multishift
+// ("Base64 encoding and decoding at almost the speed of a memory copy",
+// 2019). The scalar back end looks characters up in four tables of
+// shifted values, as hex_to_u32_lookup_mayeut does for hex digits, and
+// finishes what the vectors leave: whitespace, padding, the last
+// characters and the errors.
+//
+//   std::vector<uint8_t> bytes(base64::max_decoded_length(n));
+//   base64::result r = base64::decode(text, n, bytes.data());
+//   if (!r.valid) printf("not base64 at %zu\n", r.error);
+//   bytes.resize(r.count);
+#ifndef BASE64_H
+#define BASE64_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace base64 {
+
+struct functions; // of a back end, in base64_kernels.h
+
+enum class backend {
+  automatic, // best supported one
+  scalar,
+  avx2,
+  avx512 // with VBMI and VBMI2 (Ice Lake and up)
+};
+
+// Whether the back end can run on this processor, and its name.
+bool backend_supported(backend b);
+backend active_backend();
+const char *backend_name(backend b);
+
+enum class alphabet {
+  standard, // A-Z a-z 0-9 + /
+  url       // A-Z a-z 0-9 - _
+};
+
+struct options {
+  alphabet letters = alphabet::standard;
+  // '=' up to a multiple of 4 characters when encoding. Decoding takes
+  // text with or without it.
+  bool padding = true;
+  // Whether decoding skips spaces, tabs, line feeds, form feeds and
+  // carriage returns (as in MIME), or takes them as errors.
+  bool skip_whitespace = false;
+  backend kernel = backend::automatic;
+};
+
+struct result {
+  bool valid;
+  // When invalid, the offset of the first character out of place: one
+  // neither of the alphabet nor skipped, padding after fewer than 2
+  // characters of a group, anything but whitespace after the padding; or
+  // of the first character of an incomplete last group (one character,
+  // or padding that stops short). Otherwise n.
+  size_t error;
+  // Bytes written: all of them, or, when invalid, those of the complete
+  // groups of 4 characters before the error.
+  size_t count;
+};
+
+// Room for the bytes of n characters of text.
+inline size_t max_decoded_length(size_t n) { return (n + 3) / 4 * 3; }
+
+// The exact length of n bytes as text.
+inline size_t encoded_length(size_t n, const options &o = options()) {
+  return o.padding ? (n + 2) / 3 * 4 : (4 * n + 2) / 3;
+}
+
+// Decodes in[0, n) into out, 3 bytes for each 4 characters; the trailing
+// bits of a last group of 2 or 3 characters are dropped. out may be in
+// (decoding in place). An unsupported back end writes nothing and gives
+// an error at 0.
+result decode(const char *in, size_t n, uint8_t *out,
+              const options &o = options());
+
+// Encodes in[0, n) into out[0, encoded_length(n)), without a terminating
+// zero, and returns that length. An unsupported back end writes nothing
+// and returns 0.
+size_t encode(const uint8_t *in, size_t n, char *out,
+              const options &o = options());
+
+} // namespace base64
+
+#endif // BASE64_H
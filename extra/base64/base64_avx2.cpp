@@ -0,0 +1,138 @@
+// The AVX2 back end, after Wojciech Muła and Daniel Lemire ("Faster Base64
+// Encoding and Decoding Using AVX2 Instructions", 2018), for either
+// alphabet: the two characters besides letters and digits are compared
+// for, rather than built into the tables. A vector with anything else,
+// whitespace too, goes to the scalar loop from its start, which stops at
+// the exact group; so do the last characters. Compiled with -mavx2.
+#include "base64_kernels.h"
+
+#include <immintrin.h>
+
+namespace base64 {
+namespace {
+
+// The 32 characters of input as 6-bit values, and whether they all are of
+// the alphabet, whose last two digits are special.
+__m256i values_of(__m256i input, __m256i special62, __m256i special63,
+                  bool *valid) {
+  const __m256i mask = _mm256_set1_epi8(0x0f);
+  const __m256i high_nibbles =
+      _mm256_and_si256(_mm256_srli_epi16(input, 4), mask);
+  const __m256i low_nibbles = _mm256_and_si256(input, mask);
+  // A bit for each range of letters and digits that the high nibble
+  // allows, and for each the low nibbles outside it: 0x01 for '0' to '9'
+  // (0x30 to 0x39), 0x02 for 'A' to 'O' and 'a' to 'o' (not 0x40, 0x60),
+  // 0x04 for 'P' to 'Z' and 'p' to 'z' (not from 0x5b, 0x7b on), 0x80 for
+  // the high nibbles of none. A character is a letter or a digit when its
+  // two bit sets do not meet.
+  const __m256i by_high = _mm256_setr_epi8(
+      0x80, 0x80, 0x80, 0x01, 0x02, 0x04, 0x02, 0x04, 0x80, 0x80, 0x80, 0x80,
+      0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x01, 0x02, 0x04, 0x02, 0x04,
+      0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80);
+  const __m256i by_low = _mm256_setr_epi8(
+      0x82, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x81, 0x85,
+      0x85, 0x85, 0x85, 0x85, 0x82, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80,
+      0x80, 0x80, 0x81, 0x85, 0x85, 0x85, 0x85, 0x85);
+  const __m256i letters_digits = _mm256_cmpeq_epi8(
+      _mm256_and_si256(_mm256_shuffle_epi8(by_high, high_nibbles),
+                       _mm256_shuffle_epi8(by_low, low_nibbles)),
+      _mm256_setzero_si256());
+  const __m256i is62 = _mm256_cmpeq_epi8(input, special62);
+  const __m256i is63 = _mm256_cmpeq_epi8(input, special63);
+  *valid = _mm256_movemask_epi8(_mm256_or_si256(
+               letters_digits, _mm256_or_si256(is62, is63))) == -1;
+  // by the high nibble: '0' is 52, 'A' is 0, 'a' is 26
+  const __m256i offsets = _mm256_setr_epi8(
+      0, 0, 0, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 4, -65,
+      -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m256i values = _mm256_add_epi8(
+      input, _mm256_shuffle_epi8(offsets, high_nibbles));
+  return _mm256_blendv_epi8(
+      _mm256_blendv_epi8(values, _mm256_set1_epi8(62), is62),
+      _mm256_set1_epi8(63), is63);
+}
+
+size_t avx2_decode(const uint8_t *in, size_t n, uint8_t *out,
+                   size_t *written, bool, const tables &t) {
+  const __m256i special62 = _mm256_set1_epi8(t.digits[62]);
+  const __m256i special63 = _mm256_set1_epi8(t.digits[63]);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    bool valid;
+    const __m256i values = values_of(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i)),
+        special62, special63, &valid);
+    if (!valid) {
+      break;
+    }
+    // 12 bits in each 16-bit lane, then 24 in each 32-bit one
+    const __m256i merged = _mm256_madd_epi16(
+        _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140)),
+        _mm256_set1_epi32(0x00011000));
+    // the 3 bytes of each, first byte highest: 12 bytes in each 128-bit
+    // lane, then the lanes together
+    const __m256i packed = _mm256_shuffle_epi8(
+        merged, _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1,
+                                 -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14,
+                                 13, 12, -1, -1, -1, -1));
+    const __m256i bytes = _mm256_permutevar8x32_epi32(
+        packed, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+    // exactly 24 bytes: out may be as short as that
+    uint8_t *p = out + i / 4 * 3;
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p),
+                     _mm256_castsi256_si128(bytes));
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(p + 16),
+                     _mm256_extracti128_si256(bytes, 1));
+  }
+  i = decode_groups(in, i, n, out, t);
+  *written = i / 4 * 3;
+  return i;
+}
+
+size_t avx2_encode(const uint8_t *in, size_t n, char *out,
+                   const tables &t) {
+  const __m256i offsets = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(t.encode_offset)));
+  size_t i = 0;
+  // 24 bytes, 12 in each 128-bit lane, read as 16 and 16 bytes
+  for (; i + 28 <= n; i += 24) {
+    const __m256i loaded = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i + 12)), 1);
+    // the 3 bytes of each group as b1 b0 b2 b1 in a 32-bit lane
+    const __m256i input = _mm256_shuffle_epi8(
+        loaded, _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9,
+                                 11, 10, 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7,
+                                 10, 9, 11, 10));
+    // the four 6-bit values of each group in its four bytes, by a
+    // multiplication for the shifts of two of them and another for the
+    // other two
+    const __m256i first = _mm256_mulhi_epu16(
+        _mm256_and_si256(input, _mm256_set1_epi32(0x0fc0fc00)),
+        _mm256_set1_epi32(0x04000040));
+    const __m256i second = _mm256_mullo_epi16(
+        _mm256_and_si256(input, _mm256_set1_epi32(0x003f03f0)),
+        _mm256_set1_epi32(0x01000010));
+    const __m256i values = _mm256_or_si256(first, second);
+    // the class of tables::encode_offset
+    const __m256i above51 = _mm256_subs_epu8(values, _mm256_set1_epi8(51));
+    const __m256i below26 =
+        _mm256_cmpgt_epi8(_mm256_set1_epi8(26), values);
+    const __m256i classes = _mm256_or_si256(
+        above51, _mm256_and_si256(below26, _mm256_set1_epi8(13)));
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i *>(out + i / 3 * 4),
+        _mm256_add_epi8(values, _mm256_shuffle_epi8(offsets, classes)));
+  }
+  return encode_groups(in, i, n, out, t);
+}
+
+} // namespace
+
+const functions &avx2_functions() {
+  static const functions avx2 = {avx2_decode, avx2_encode};
+  return avx2;
+}
+
+} // namespace base64
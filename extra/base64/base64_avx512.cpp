@@ -0,0 +1,176 @@
+// The AVX-512 back end, after Wojciech Muła and Daniel Lemire ("Base64
+// encoding and decoding at almost the speed of a memory copy", 2019):
+// decoding looks each of 64 characters up in a table of the 128 ASCII
+// characters with one byte permutation (VBMI), characters from 0x80 on
+// being errors as they are, and packs the 48 bytes with a multiply-add
+// and another permutation; encoding spreads 48 bytes over 16 lanes of 32
+// bits and cuts out the 6-bit values with a multishift (VBMI). Whitespace
+// is squeezed out with vpcompressb (VBMI2), and the last groups, and
+// those before an error, go through masked loads and stores, so that the
+// scalar loops are left nothing to do. Compiled with -mavx512f -mavx512bw
+// -mavx512vl -mavx512vbmi -mavx512vbmi2 -mbmi2 -mpopcnt.
+#include "base64_kernels.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+
+namespace base64 {
+namespace {
+
+__mmask64 first(size_t count) {
+  return count == 0 ? 0 : ~__mmask64(0) >> (64 - count);
+}
+
+// The values of the 64 characters of input, 0x80 and more for those not
+// of the alphabet, in *error.
+__m512i values_of(__m512i input, __m512i low_table, __m512i high_table,
+                  __mmask64 *error) {
+  const __m512i values =
+      _mm512_permutex2var_epi8(low_table, input, high_table);
+  *error = _mm512_movepi8_mask(_mm512_or_si512(values, input));
+  return values;
+}
+
+// The 48 bytes of 64 values, in the low 48 bytes.
+__m512i pack(__m512i values) {
+  // 12 bits in each 16-bit lane, then 24 in each 32-bit one
+  const __m512i merged = _mm512_madd_epi16(
+      _mm512_maddubs_epi16(values, _mm512_set1_epi32(0x01400140)),
+      _mm512_set1_epi32(0x00011000));
+  // the 3 bytes of each lane, first byte highest
+  const __m512i order = _mm512_setr_epi32(
+      0x06000102, 0x090a0405, 0x0c0d0e08, 0x16101112, 0x191a1415,
+      0x1c1d1e18, 0x26202122, 0x292a2425, 0x2c2d2e28, 0x36303132,
+      0x393a3435, 0x3c3d3e38, 0, 0, 0, 0);
+  return _mm512_permutexvar_epi8(order, merged);
+}
+
+// the whitespace that decoding may skip
+__mmask64 spaces(__m512i input) {
+  return _mm512_cmpeq_epi8_mask(input, _mm512_set1_epi8(' ')) |
+         _mm512_cmpeq_epi8_mask(input, _mm512_set1_epi8('\t')) |
+         _mm512_cmpeq_epi8_mask(input, _mm512_set1_epi8('\n')) |
+         _mm512_cmpeq_epi8_mask(input, _mm512_set1_epi8('\f')) |
+         _mm512_cmpeq_epi8_mask(input, _mm512_set1_epi8('\r'));
+}
+
+// A vector of 64 characters of the alphabet at a time. Otherwise, the
+// digits of the vector before the first character that is neither a digit
+// nor skipped are packed together (VBMI2) and rotated in after the values
+// still waiting in a register; 64 of them make 48 bytes, and those that
+// did not fit wait in turn. So the input goes on 64 characters at a time
+// whatever the whitespace, as in MIME lines. At the end, the whole groups
+// waiting are written, and we go back to the first digit of the
+// incomplete one, if any, for the caller.
+size_t avx512_decode(const uint8_t *in, size_t n, uint8_t *out,
+                     size_t *written, bool skip_whitespace,
+                     const tables &t) {
+  const __m512i low_table = _mm512_loadu_si512(t.value);
+  const __m512i high_table = _mm512_loadu_si512(t.value + 64);
+  const __m512i iota = _mm512_setr_epi32(
+      0x03020100, 0x07060504, 0x0b0a0908, 0x0f0e0d0c, 0x13121110,
+      0x17161514, 0x1b1a1918, 0x1f1e1d1c, 0x23222120, 0x27262524,
+      0x2b2a2928, 0x2f2e2d2c, 0x33323130, 0x37363534, 0x3b3a3938,
+      0x3f3e3d3c);
+  const __mmask64 bytes48 = first(48);
+  __m512i waiting = _mm512_setzero_si512();
+  size_t count = 0; // of waiting
+  size_t i = 0;
+  size_t bytes = 0;
+  for (; i < n; i += 64) {
+    const __mmask64 loaded = first(n - i < 64 ? n - i : 64);
+    const __m512i input = _mm512_maskz_loadu_epi8(loaded, in + i);
+    __mmask64 error;
+    const __m512i values = values_of(input, low_table, high_table, &error);
+    if (error == 0 && count == 0) {
+      _mm512_mask_storeu_epi8(out + bytes, bytes48, pack(values));
+      bytes += 48;
+      continue;
+    }
+    // the bytes not loaded are 0, not digits
+    error &= loaded;
+    const __mmask64 stop =
+        (skip_whitespace ? error & ~spaces(input) : error) | ~loaded;
+    const __mmask64 digits =
+        ~error & (stop == 0 ? loaded : first(size_t(__builtin_ctzll(stop))));
+    // the new values from byte count on, and those past byte 63 from 0 on
+    const __m512i rotated = _mm512_permutexvar_epi8(
+        _mm512_sub_epi8(iota, _mm512_set1_epi8(char(count))),
+        _mm512_maskz_compress_epi8(digits, values));
+    const __m512i merged =
+        _mm512_mask_blend_epi8(~first(count), waiting, rotated);
+    count += size_t(_mm_popcnt_u64(digits));
+    if (count >= 64) {
+      _mm512_mask_storeu_epi8(out + bytes, bytes48, pack(merged));
+      bytes += 48;
+      waiting = rotated;
+      count -= 64;
+    } else {
+      waiting = merged;
+    }
+    if (stop != 0) {
+      i += size_t(__builtin_ctzll(stop));
+      break;
+    }
+  }
+  const size_t groups = count / 4;
+  _mm512_mask_storeu_epi8(out + bytes, first(3 * groups), pack(waiting));
+  bytes += 3 * groups;
+  // only digits and whitespace before i
+  for (size_t left = count % 4; left > 0; left -= t.value[in[i]] < 64) {
+    i--;
+  }
+  *written = bytes;
+  return i;
+}
+
+// The 64 characters of the 48 bytes of input, in the low 48 bytes.
+__m512i encode_vector(__m512i input, __m512i digits) {
+  // the 3 bytes of each group as b1 b0 b2 b1 in a 32-bit lane
+  const __m512i spread = _mm512_permutexvar_epi8(
+      _mm512_setr_epi32(0x01020001, 0x04050304, 0x07080607, 0x0a0b090a,
+                        0x0d0e0c0d, 0x10110f10, 0x13141213, 0x16171516,
+                        0x191a1819, 0x1c1d1b1c, 0x1f201e1f, 0x22232122,
+                        0x25262425, 0x28292728, 0x2b2c2a2b, 0x2e2f2d2e),
+      input);
+  // the 6-bit values at bits 10, 4, 22 and 16 of each lane, in the bytes
+  // of the lane (the permutation ignores the 2 bits above them)
+  const __m512i values = _mm512_multishift_epi64_epi8(
+      _mm512_set1_epi64(0x3036242a1016040a), spread);
+  return _mm512_permutexvar_epi8(values, digits);
+}
+
+size_t avx512_encode(const uint8_t *in, size_t n, char *out,
+                     const tables &t) {
+  const __m512i digits = _mm512_loadu_si512(t.digits);
+  size_t i = 0;
+  for (; i + 64 <= n; i += 48) {
+    _mm512_storeu_si512(out + i / 3 * 4,
+                        encode_vector(_mm512_loadu_si512(in + i), digits));
+  }
+  // then up to 21 groups: 16, and the others
+  if (i + 48 <= n) {
+    _mm512_storeu_si512(
+        out + i / 3 * 4,
+        encode_vector(_mm512_maskz_loadu_epi8(first(48), in + i), digits));
+    i += 48;
+  }
+  const size_t groups = (n - i) / 3;
+  _mm512_mask_storeu_epi8(
+      out + i / 3 * 4, first(4 * groups),
+      encode_vector(_mm512_maskz_loadu_epi8(first(3 * groups), in + i),
+                    digits));
+  return i + 3 * groups;
+}
+
+} // namespace
+
+const functions &avx512_functions() {
+  static const functions avx512 = {avx512_decode, avx512_encode};
+  return avx512;
+}
+
+} // namespace base64
@@ -0,0 +1,124 @@
+// The functions of each back end, the tables of an alphabet and the
+// scalar loops that all of them share. Only the base64*.cpp files include
+// this header.
+#ifndef BASE64_KERNELS_H
+#define BASE64_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "base64.h"
+
+namespace base64 {
+
+// Everything the back ends look up, for one alphabet; built at compile
+// time in base64.cpp.
+struct tables {
+  // the 64 digits, by value, and the 4096 pairs of them, by 12 bits
+  char digits[64];
+  char pairs[4096][2];
+  // the value of each character, 0x80 for those not of the alphabet
+  uint8_t value[256];
+  // The value of each character shifted to its place in a group of 4
+  // characters (24 bits, the first character highest), 1 << 24 for those
+  // not of the alphabet: the 4 lookups of a group are ORed, and a result
+  // from 1 << 24 on means an error. As hex_to_u32_lookup_mayeut of
+  // 2019/04/17/hexparse.cpp.
+  uint32_t shifted[4][256];
+  // Added to a value to make its digit, by the class that encoding with
+  // AVX2 computes: 0 for 26 to 51, 1 to 10 for 52 to 61, 11 and 12 for 62
+  // and 63, 13 for 0 to 25.
+  int8_t encode_offset[16];
+
+  constexpr explicit tables(const char (&alphabet)[65])
+      : digits(), pairs(), value(), shifted(), encode_offset() {
+    for (int c = 0; c < 256; c++) {
+      value[c] = 0x80;
+      for (int k = 0; k < 4; k++) {
+        shifted[k][c] = uint32_t(1) << 24;
+      }
+    }
+    for (int v = 0; v < 64; v++) {
+      const uint8_t c = uint8_t(alphabet[v]);
+      digits[v] = alphabet[v];
+      value[c] = uint8_t(v);
+      for (int k = 0; k < 4; k++) {
+        shifted[k][c] = uint32_t(v) << (18 - 6 * k);
+      }
+    }
+    for (int v = 0; v < 4096; v++) {
+      pairs[v][0] = alphabet[v >> 6];
+      pairs[v][1] = alphabet[v & 63];
+    }
+    encode_offset[0] = int8_t(alphabet[26] - 26);
+    for (int k = 1; k <= 10; k++) {
+      encode_offset[k] = int8_t(alphabet[52] - 52);
+    }
+    encode_offset[11] = int8_t(alphabet[62] - 62);
+    encode_offset[12] = int8_t(alphabet[63] - 63);
+    encode_offset[13] = int8_t(alphabet[0]);
+  }
+};
+
+struct functions {
+  // Whole groups of 4 characters of the alphabet from in[0, n), up to the
+  // first group with anything else, and if skip_whitespace the whitespace
+  // between them (a back end may stop there too): returns the characters
+  // taken, whole groups and whitespace, and writes the 3 bytes of each
+  // group to out and their count to *written.
+  size_t (*decode)(const uint8_t *in, size_t n, uint8_t *out,
+                   size_t *written, bool skip_whitespace, const tables &t);
+  // Whole groups of 3 bytes of in[0, n), all of them: returns the bytes
+  // taken, a multiple of 3, and writes their 4 / 3 characters to out.
+  size_t (*encode)(const uint8_t *in, size_t n, char *out,
+                   const tables &t);
+};
+
+const functions &scalar_functions();
+const functions &avx2_functions();
+const functions &avx512_functions();
+
+// In an unnamed namespace: each back end compiles its own copy with its
+// own instruction sets, so that the linker cannot pick the AVX2 copy for
+// the scalar back end.
+namespace {
+
+// Groups of 4 characters from in[i, n) one at a time, for what the
+// vectors leave and where they found anything else: as the decode
+// function without whitespace, from i, the bytes being i / 4 * 3 on.
+inline size_t decode_groups(const uint8_t *in, size_t i, size_t n,
+                            uint8_t *out, const tables &t) {
+  for (; i + 4 <= n; i += 4) {
+    const uint32_t bits = t.shifted[0][in[i]] | t.shifted[1][in[i + 1]] |
+                          t.shifted[2][in[i + 2]] | t.shifted[3][in[i + 3]];
+    if (bits >= uint32_t(1) << 24) {
+      break;
+    }
+    uint8_t *bytes = out + i / 4 * 3;
+    bytes[0] = uint8_t(bits >> 16);
+    bytes[1] = uint8_t(bits >> 8);
+    bytes[2] = uint8_t(bits);
+  }
+  return i;
+}
+
+// Groups of 3 bytes from in[i, n) one at a time, up to the last whole
+// one; as the encode function, from i.
+inline size_t encode_groups(const uint8_t *in, size_t i, size_t n,
+                            char *out, const tables &t) {
+  for (; i + 3 <= n; i += 3) {
+    const uint32_t bits =
+        uint32_t(in[i]) << 16 | uint32_t(in[i + 1]) << 8 | in[i + 2];
+    char *chars = out + i / 3 * 4;
+    memcpy(chars, t.pairs[bits >> 12], 2);
+    memcpy(chars + 2, t.pairs[bits & 0xfff], 2);
+  }
+  return i;
+}
+
+} // namespace
+
+} // namespace base64
+
+#endif // BASE64_KERNELS_H
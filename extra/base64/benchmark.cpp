@@ -0,0 +1,218 @@
+// Cycles and instructions per 4-character string, as test<F> of
+// 2019/04/17/hexparse.cpp reports them, so that hex and base64 can be
+// compared directly: 4 hexadecimal digits are 2 bytes, 4 base64
+// characters 3. The functions of hexparse.cpp decode one such string
+// with tables (hex_to_u32_lookup, hex_to_u32_lookup_mayeut) or with
+// arithmetic (hex_to_u32_lee, which does not check); their base64
+// counterparts here use a table of values, or four tables of shifted
+// values as the scalar back end does. Then each back end in bulk over the
+// same 4 N characters: decoding them, decoding them as MIME lines of 76
+// characters (whitespace skipped, counted per 4 characters that are not),
+// and encoding the 3 N bytes back. Without the hardware counters, only ns
+// per string.
+#include "base64.h"
+
+#include "../harness/harness.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const base64::backend backends[] = {base64::backend::scalar,
+                                    base64::backend::avx2,
+                                    base64::backend::avx512};
+
+const char hex_digits[] = "0123456789ABCDEF";
+const char base64_digits[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// The tables of hexparse.cpp, built here: digittoval and digittoval32 (the
+// value shifted by 12, 8, 4 and 0 bits at offsets 630, 420, 210 and 0,
+// 0xFFFFFFFF elsewhere); then the same for base64, shifted by 18, 12, 6
+// and 0 bits.
+signed char digittoval[256];
+uint32_t digittoval32[886];
+int32_t base64val[256];
+uint32_t base64val32[4][256];
+
+void init_tables() {
+  memset(digittoval, -1, sizeof(digittoval));
+  memset(digittoval32, 0xff, sizeof(digittoval32));
+  for (const char *d : {"0123456789abcdef", hex_digits}) {
+    for (uint32_t v = 0; v < 16; v++) {
+      const uint8_t c = uint8_t(d[v]);
+      digittoval[c] = (signed char)v;
+      digittoval32[630 + c] = v << 12;
+      digittoval32[420 + c] = v << 8;
+      digittoval32[210 + c] = v << 4;
+      digittoval32[c] = v;
+    }
+  }
+  memset(base64val, -1, sizeof(base64val));
+  memset(base64val32, 0xff, sizeof(base64val32));
+  for (uint32_t v = 0; v < 64; v++) {
+    const uint8_t c = uint8_t(base64_digits[v]);
+    base64val[c] = int32_t(v);
+    for (int k = 0; k < 4; k++) {
+      base64val32[k][c] = v << (18 - 6 * k);
+    }
+  }
+}
+
+// the high 16 bits set if not valid
+uint32_t hex_to_u32_lookup(const uint8_t *src) {
+  uint32_t v1 = digittoval[src[0]];
+  uint32_t v2 = digittoval[src[1]];
+  uint32_t v3 = digittoval[src[2]];
+  uint32_t v4 = digittoval[src[3]];
+  return static_cast<uint32_t>(v1 << 12 | v2 << 8 | v3 << 4 | v4);
+}
+
+uint32_t hex_to_u32_lookup_mayeut(const uint8_t *src) {
+  uint32_t v1 = static_cast<uint32_t>(digittoval32[630 + src[0]]);
+  uint32_t v2 = static_cast<uint32_t>(digittoval32[420 + src[1]]);
+  uint32_t v3 = static_cast<uint32_t>(digittoval32[210 + src[2]]);
+  uint32_t v4 = static_cast<uint32_t>(digittoval32[0 + src[3]]);
+  return v1 | v2 | v3 | v4;
+}
+
+// no error checking
+uint32_t hex_to_u32_lee(const uint8_t *src) {
+  uint32_t val;
+  memcpy(&val, src, 4);
+  val = (val & 0xf0f0f0f) + 9 * (val >> 6 & 0x1010101);
+  val = (val | val << 12) & 0xff00ff00;
+  return (val >> 24 | val) & 0xffff;
+}
+
+// the high 8 bits set if not valid
+uint32_t base64_to_u32_lookup(const uint8_t *src) {
+  uint32_t v1 = uint32_t(base64val[src[0]]);
+  uint32_t v2 = uint32_t(base64val[src[1]]);
+  uint32_t v3 = uint32_t(base64val[src[2]]);
+  uint32_t v4 = uint32_t(base64val[src[3]]);
+  return v1 << 18 | v2 << 12 | v3 << 6 | v4;
+}
+
+uint32_t base64_to_u32_lookup_mayeut(const uint8_t *src) {
+  return base64val32[0][src[0]] | base64val32[1][src[1]] |
+         base64val32[2][src[2]] | base64val32[3][src[3]];
+}
+
+void print(const char *name, const harness::result &r, size_t strings,
+           harness::options &opts) {
+  if (opts.format != HARNESS_TEXT) {
+    r.report();
+    return;
+  }
+  printf("%-28s", name);
+  if (r.available(HARNESS_CYCLES)) {
+    printf("\t%8.3f\t%8.3f", r.min(HARNESS_CYCLES) / strings,
+           r.min(HARNESS_INSTRUCTIONS) / strings);
+  } else {
+    printf("\t%8s\t%8s", "-", "-");
+  }
+  printf("\t%8.3f\n", r.min() / strings);
+}
+
+// As in hexparse.cpp: F over the 4 N characters of x, one string at a
+// time, summed.
+template <uint32_t (*F)(const uint8_t *src)>
+uint64_t test(const char *name, const std::vector<uint8_t> &x,
+              harness::options &opts) {
+  const size_t N = x.size() / 4;
+  uint64_t sum = 0;
+  auto r = harness::run(name, N, [&] {
+    sum = 0;
+    for (size_t i = 0; i < 4 * N; i += 4) {
+      sum += F(x.data() + i);
+    }
+    harness::do_not_optimize(sum);
+  }, opts);
+  print(name, r, N, opts);
+  return sum;
+}
+
+// f() over the N strings of a text, in bulk
+template <class F>
+void test_bulk(const char *name, size_t N, F f, harness::options &opts) {
+  auto r = harness::run(name, N, f, opts);
+  print(name, r, N, opts);
+}
+
+} // namespace
+
+int main() {
+  init_tables();
+  const size_t N = 1000 * 1000;
+  std::mt19937_64 gen(1235);
+  std::vector<uint8_t> hex(4 * N), text(4 * N);
+  for (uint8_t &c : hex) {
+    c = uint8_t(hex_digits[gen() % 16]);
+  }
+  for (uint8_t &c : text) {
+    c = uint8_t(base64_digits[gen() % 64]);
+  }
+  std::string lines;
+  for (size_t i = 0; i < text.size(); i += 76) {
+    lines.append(reinterpret_cast<const char *>(text.data()) + i,
+                 i + 76 <= text.size() ? 76 : text.size() - i);
+    lines += "\r\n";
+  }
+  harness::options opts = harness::default_options();
+  opts.repeat = 50;
+  if (opts.format == HARNESS_TEXT) {
+    printf("per 4-character string, N = %zu, best back end: %s\n", N,
+           base64::backend_name(base64::active_backend()));
+    printf("%-28s\t%8s\t%8s\t%8s\n", "", "cycles", "instr.", "ns");
+  }
+  const uint64_t hex_sum = test<hex_to_u32_lookup>("hex lookup", hex, opts);
+  bool ok = test<hex_to_u32_lookup_mayeut>("hex mayeut", hex, opts) == hex_sum;
+  ok = test<hex_to_u32_lee>("hex lee", hex, opts) == hex_sum && ok;
+  const uint64_t base64_sum =
+      test<base64_to_u32_lookup>("base64 lookup", text, opts);
+  ok = test<base64_to_u32_lookup_mayeut>("base64 mayeut", text, opts) ==
+           base64_sum &&
+       ok;
+  std::vector<uint8_t> reference(3 * N), bytes(3 * N + 64);
+  base64::options scalar;
+  scalar.kernel = base64::backend::scalar;
+  base64::decode(reinterpret_cast<const char *>(text.data()), text.size(),
+                 reference.data(), scalar);
+  std::string encoded(4 * N + 64, 0);
+  for (base64::backend b : backends) {
+    if (!base64::backend_supported(b)) {
+      continue;
+    }
+    base64::options o;
+    o.kernel = b;
+    const std::string name = base64::backend_name(b);
+    base64::result r = {false, 0, 0};
+    test_bulk((name + " decode").c_str(), N, [&] {
+      r = base64::decode(reinterpret_cast<const char *>(text.data()),
+                         text.size(), bytes.data(), o);
+    }, opts);
+    ok = ok && r.valid && r.count == 3 * N &&
+         memcmp(bytes.data(), reference.data(), 3 * N) == 0;
+    o.skip_whitespace = true;
+    test_bulk((name + " decode, MIME lines").c_str(), N, [&] {
+      r = base64::decode(lines.data(), lines.size(), bytes.data(), o);
+    }, opts);
+    ok = ok && r.valid && r.count == 3 * N &&
+         memcmp(bytes.data(), reference.data(), 3 * N) == 0;
+    test_bulk((name + " encode").c_str(), N, [&] {
+      base64::encode(reference.data(), 3 * N, &encoded[0], o);
+    }, opts);
+    ok = ok && memcmp(encoded.data(), text.data(), 4 * N) == 0;
+  }
+  if (!ok) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,320 @@
+// Checks of every back end: the test vectors of RFC 4648 and a few
+// errors by hand, then round trips at every length up to 300 and on
+// longer buffers (both alphabets, with and without padding, in place
+// too, with whitespace skipped, and with an error among whitespace), and
+// every one of the 256 byte values at every offset of texts up to a
+// vector and more, which must give what a plain decoder written here
+// gives: the offset of the error and the bytes before it, or none.
+#include "base64.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const base64::backend backends[] = {
+    base64::backend::automatic, base64::backend::scalar,
+    base64::backend::avx2, base64::backend::avx512};
+
+std::mt19937_64 gen(1234);
+
+// memcmp, but not of the null pointers of empty vectors
+bool same_bytes(const void *x, const void *y, size_t n) {
+  return n == 0 || memcmp(x, y, n) == 0;
+}
+
+const char *digits(base64::alphabet a) {
+  return a == base64::alphabet::url
+             ? "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+               "0123456789-_"
+             : "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"
+               "0123456789+/";
+}
+
+bool is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\f' || c == '\r';
+}
+
+std::string expected_encoding(const std::vector<uint8_t> &bytes,
+                              const base64::options &o) {
+  const char *d = digits(o.letters);
+  std::string s;
+  for (size_t i = 0; i < bytes.size(); i += 3) {
+    const size_t k = bytes.size() - i < 3 ? bytes.size() - i : 3;
+    uint32_t bits = 0;
+    for (size_t b = 0; b < 3; b++) {
+      bits = bits << 8 | (b < k ? bytes[i + b] : 0);
+    }
+    for (size_t c = 0; c <= k; c++) {
+      s += d[(bits >> (18 - 6 * c)) & 63];
+    }
+    if (o.padding) {
+      s.append(3 - k, '=');
+    }
+  }
+  return s;
+}
+
+// The decoder of base64.h, one character at a time.
+base64::result expected_decoding(const std::string &text,
+                                 const base64::options &o,
+                                 std::vector<uint8_t> &out) {
+  const char *d = digits(o.letters);
+  const size_t n = text.size();
+  std::vector<uint32_t> values;
+  std::vector<size_t> offsets;
+  size_t j = 0;
+  for (; j < n; j++) {
+    const char *p = text[j] == 0 ? nullptr : strchr(d, text[j]);
+    if (p != nullptr) {
+      values.push_back(uint32_t(p - d));
+      offsets.push_back(j);
+    } else if (!(o.skip_whitespace && is_space(text[j]))) {
+      break;
+    }
+  }
+  out.clear();
+  size_t g = 0;
+  for (; g + 4 <= values.size(); g += 4) {
+    const uint32_t bits = values[g] << 18 | values[g + 1] << 12 |
+                          values[g + 2] << 6 | values[g + 3];
+    out.push_back(uint8_t(bits >> 16));
+    out.push_back(uint8_t(bits >> 8));
+    out.push_back(uint8_t(bits));
+  }
+  const size_t k = values.size() - g;
+  const size_t start = k > 0 ? offsets[g] : n;
+  const size_t complete = out.size();
+  uint32_t bits = 0;
+  for (size_t c = 0; c < 4; c++) {
+    bits = bits << 6 | (g + c < values.size() ? values[g + c] : 0);
+  }
+  for (size_t b = 0; b + 1 < k; b++) {
+    out.push_back(uint8_t(bits >> (16 - 8 * b)));
+  }
+  if (j == n) {
+    if (k == 1) {
+      return {false, start, complete};
+    }
+    return {true, n, out.size()};
+  }
+  if (text[j] != '=' || k < 2) {
+    return {false, j, complete};
+  }
+  size_t padding = 0;
+  for (; j < n; j++) {
+    if (text[j] == '=' && padding < 4 - k) {
+      padding++;
+    } else if (!(o.skip_whitespace && is_space(text[j]))) {
+      break;
+    }
+  }
+  if (padding < 4 - k) {
+    return {false, j == n ? start : j, complete};
+  }
+  return {j == n, j, out.size()};
+}
+
+bool check_vectors(base64::backend b) {
+  struct example {
+    const char *text;
+    bool skip_whitespace;
+    bool valid;
+    size_t error;
+    const char *bytes;
+  };
+  const example examples[] = {
+      {"", false, true, 0, ""},
+      {"Zg==", false, true, 4, "f"},
+      {"Zm8=", false, true, 4, "fo"},
+      {"Zm9v", false, true, 4, "foo"},
+      {"Zm9vYg==", false, true, 8, "foob"},
+      {"Zm9vYmE=", false, true, 8, "fooba"},
+      {"Zm9vYmFy", false, true, 8, "foobar"},
+      {"Zm9vYg", false, true, 6, "foob"},
+      {"Zm9vYmE", false, true, 7, "fooba"},
+      {"Zm9vY", false, false, 4, "foo"},
+      {"Zm9vYg=", false, false, 4, "foo"},
+      {"Zm9v=", false, false, 4, "foo"},
+      {"Zm9vY===", false, false, 5, "foo"},
+      {"Zg===", false, false, 4, "f"},
+      {"Zg==Zg==", false, false, 4, "f"},
+      {"Zm=9", false, false, 3, ""},
+      {"Zm9v\nYmFy", false, false, 4, "foo"},
+      {"Zm9v\r\nYmFy\r\n", true, true, 12, "foobar"},
+      {" Z g = = ", true, true, 9, "f"},
+      {"Zm9v*mFy", false, false, 4, "foo"},
+      {"Zm9vYm-y", false, false, 6, "foo"}};
+  for (const example &e : examples) {
+    base64::options o;
+    o.kernel = b;
+    o.skip_whitespace = e.skip_whitespace;
+    const size_t n = strlen(e.text);
+    std::vector<uint8_t> out(base64::max_decoded_length(n) + 1);
+    const base64::result r = base64::decode(e.text, n, out.data(), o);
+    if (r.valid != e.valid || r.error != e.error ||
+        r.count != strlen(e.bytes) ||
+        !same_bytes(out.data(), e.bytes, r.count)) {
+      printf("bug: %s, decoding \"%s\" gives %d, error %zu, %zu bytes\n",
+             base64::backend_name(b), e.text, r.valid, r.error, r.count);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool check_round_trip(size_t n, base64::backend b) {
+  std::vector<uint8_t> bytes(n);
+  for (uint8_t &x : bytes) {
+    x = uint8_t(gen());
+  }
+  for (base64::alphabet a : {base64::alphabet::standard,
+                             base64::alphabet::url}) {
+    for (bool padding : {true, false}) {
+      base64::options o;
+      o.kernel = b;
+      o.letters = a;
+      o.padding = padding;
+      const std::string expected = expected_encoding(bytes, o);
+      const size_t length = base64::encoded_length(n, o);
+      std::string text(length + 64, '#');
+      if (length != expected.size() ||
+          base64::encode(bytes.data(), n, &text[0], o) != length ||
+          text.substr(0, length) != expected ||
+          text.find_first_not_of('#', length) != std::string::npos) {
+        printf("bug: encoding %zu bytes, alphabet %d, padding %d\n", n,
+               int(a), padding);
+        return false;
+      }
+      std::vector<uint8_t> out(n + 64, 0xee);
+      base64::result r =
+          base64::decode(expected.data(), length, out.data(), o);
+      bool ok = r.valid && r.error == length && r.count == n &&
+                same_bytes(out.data(), bytes.data(), n) && out[n] == 0xee;
+      // in place
+      std::string copy = expected;
+      r = base64::decode(copy.data(), length,
+                         reinterpret_cast<uint8_t *>(&copy[0]), o);
+      ok = ok && r.valid && same_bytes(copy.data(), bytes.data(), n);
+      // as MIME lines of 76 characters, and with spaces at random
+      std::string lines, spaced;
+      for (size_t i = 0; i < length; i++) {
+        if (i > 0 && i % 76 == 0) {
+          lines += "\r\n";
+        }
+        lines += expected[i];
+        if (gen() % 16 == 0) {
+          spaced += " \t\n\f\r"[gen() % 5];
+        }
+        spaced += expected[i];
+      }
+      o.skip_whitespace = true;
+      for (const std::string &s : {lines, spaced}) {
+        std::fill(out.begin(), out.end(), 0xee);
+        r = base64::decode(s.data(), s.size(), out.data(), o);
+        ok = ok && r.valid && r.error == s.size() && r.count == n &&
+             same_bytes(out.data(), bytes.data(), n) && out[n] == 0xee;
+      }
+      // and with one character that is not valid, at random
+      if (!spaced.empty()) {
+        spaced[gen() % spaced.size()] = "*=.-_+/\x80"[gen() % 8];
+        std::vector<uint8_t> expected;
+        const base64::result e = expected_decoding(spaced, o, expected);
+        std::fill(out.begin(), out.end(), 0xee);
+        r = base64::decode(spaced.data(), spaced.size(), out.data(), o);
+        ok = ok && r.valid == e.valid && r.error == e.error &&
+             r.count == e.count &&
+             same_bytes(out.data(), expected.data(), e.count) &&
+             out[e.count] == 0xee;
+      }
+      if (!ok) {
+        printf("bug: decoding %zu bytes, alphabet %d, padding %d\n", n,
+               int(a), padding);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// c at offset k of random digits of length n, padded at times if n is a
+// multiple of 4
+bool check_error(size_t n, size_t k, uint8_t c, base64::backend b,
+                 bool skip_whitespace) {
+  base64::options o;
+  o.kernel = b;
+  o.letters = gen() % 2 ? base64::alphabet::url : base64::alphabet::standard;
+  o.skip_whitespace = skip_whitespace;
+  std::string text(n, '=');
+  const size_t padding = n % 4 == 0 ? gen() % 3 : 0;
+  for (size_t i = 0; i + padding < n; i++) {
+    text[i] = digits(o.letters)[gen() % 64];
+  }
+  text[k] = char(c);
+  std::vector<uint8_t> out(base64::max_decoded_length(n) + 16, 0xee);
+  std::vector<uint8_t> expected;
+  const base64::result r = base64::decode(text.data(), n, out.data(), o);
+  const base64::result e = expected_decoding(text, o, expected);
+  if (r.valid != e.valid || r.error != e.error || r.count != e.count ||
+      !same_bytes(out.data(), expected.data(), e.count) ||
+      out[e.count] != 0xee) {
+    printf("bug: %s, byte 0x%02x at %zu of %zu gives %d, error %zu, %zu "
+           "bytes, not %d, %zu, %zu\n",
+           base64::backend_name(b), c, k, n, r.valid, r.error, r.count,
+           e.valid, e.error, e.count);
+    return false;
+  }
+  return true;
+}
+
+bool check_backend(base64::backend b) {
+  if (!check_vectors(b)) {
+    return false;
+  }
+  for (size_t n = 0; n <= 300; n++) {
+    if (!check_round_trip(n, b)) {
+      return false;
+    }
+  }
+  for (size_t n : {1000, 4096, 100000}) {
+    if (!check_round_trip(n, b)) {
+      return false;
+    }
+  }
+  for (size_t n = 1; n <= 300; n++) {
+    // every byte value at every offset up to a vector and a bit more, and
+    // around two and four vectors; elsewhere one at random
+    const bool all = n <= 72 || n == 127 || n == 128 || n == 129 ||
+                     n == 255 || n == 256;
+    for (size_t k = 0; k < n; k++) {
+      for (int c = 0; c < 256; c++) {
+        const uint8_t byte = all ? uint8_t(c) : uint8_t(gen());
+        if (!check_error(n, k, byte, b, gen() % 2 == 0)) {
+          return false;
+        }
+        if (!all) {
+          break;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main() {
+  printf("best back end: %s\n", base64::backend_name(base64::active_backend()));
+  for (base64::backend b : backends) {
+    if (base64::backend_supported(b) && !check_backend(b)) {
+      printf("bug!\n");
+      return EXIT_FAILURE;
+    }
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,246 @@
+// Batched lower_bound: K binary searches run in lockstep, so that their
+// cache misses overlap instead of following one another.
+//
+// This is binsearch2..binsearch60 of 2019/09/20/multiplebinarysearch.cpp and
+// branchfree_search2/4/8(_prefetch) of extra/batchbinary.c, written once as
+// a template over the width K. Each step of the branch-free search costs a
+// conditional move per key; before it, we prefetch both cache lines the
+// next step may touch, as branchfree_search8_prefetch does.
+//
+// The best K depends on how many misses the processor keeps in flight. By
+// default it is default_width; it can be measured on the caller's own data
+// (tune_width) or once for the machine (machine_width), on request only,
+// since each measurement takes a fraction of a second. The width is a
+// runtime value in [1, max_width].
+//
+// Header-only, C++20 (std::span and ranges):
+//
+//   std::vector<uint32_t> data = ...; // sorted
+//   std::vector<size_t> out(keys.size());
+//   batchsearch::lower_bound(data, keys, out); // K = default_width
+//   batchsearch::lower_bound(data, keys, out, batchsearch::machine_width());
+//
+// out[i] is the position std::lower_bound would return for keys[i].
+#ifndef BATCHSEARCH_H
+#define BATCHSEARCH_H
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <ranges>
+#include <span>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace batchsearch {
+
+constexpr size_t max_width = 64;
+
+// The width of a 0 argument: within the widths that do best on large
+// arrays, from 12 to 24 on the machines we have measured.
+constexpr size_t default_width = 16;
+
+namespace internal {
+
+// The K searches of a batch, lane k looking for keys[k] in the n values at
+// arrays[k]. With n == 0, every answer is 0.
+template <size_t K, class T, class Compare>
+inline void lower_bound_lanes(const T *const *arrays, size_t n,
+                              const T *keys, size_t *out, Compare less) {
+  if (n == 0) {
+    for (size_t k = 0; k < K; k++) {
+      out[k] = 0;
+    }
+    return;
+  }
+  const T *base[K];
+  T key[K];
+#pragma GCC unroll 64
+  for (size_t k = 0; k < K; k++) {
+    base[k] = arrays[k];
+    key[k] = keys[k];
+  }
+  while (n > 1) {
+    const size_t half = n >> 1;
+    if (K > 1) {
+#pragma GCC unroll 64
+      for (size_t k = 0; k < K; k++) {
+        __builtin_prefetch(base[k] + (half >> 1), 0, 0);
+        __builtin_prefetch(base[k] + half + (half >> 1), 0, 0);
+      }
+    }
+#pragma GCC unroll 64
+    for (size_t k = 0; k < K; k++) {
+      base[k] = less(base[k][half], key[k]) ? base[k] + half : base[k];
+    }
+    n -= half;
+  }
+#pragma GCC unroll 64
+  for (size_t k = 0; k < K; k++) {
+    out[k] = size_t(less(*base[k], key[k])) + size_t(base[k] - arrays[k]);
+  }
+}
+
+// Searches count keys, K at a time; the last count % K keys one at a time.
+// With one array, arrays has a single entry; otherwise one per key.
+template <size_t K, class T, class Compare>
+void lower_bound_batches(const T *const *arrays, bool one_array, size_t n,
+                         const T *keys, size_t count, size_t *out,
+                         Compare less) {
+  const T *lanes[K];
+  size_t i = 0;
+  for (; i + K <= count; i += K) {
+    for (size_t k = 0; k < K; k++) {
+      lanes[k] = one_array ? arrays[0] : arrays[i + k];
+    }
+    lower_bound_lanes<K>(lanes, n, keys + i, out + i, less);
+  }
+  for (; i < count; i++) {
+    const T *lane = one_array ? arrays[0] : arrays[i];
+    lower_bound_lanes<1>(&lane, n, keys + i, out + i, less);
+  }
+}
+
+template <class T, class Compare>
+using batches_function = void (*)(const T *const *, bool, size_t, const T *,
+                                  size_t, size_t *, Compare);
+
+// table[K] = lower_bound_batches<K>, for K in [1, max_width]
+template <class T, class Compare, size_t... K>
+constexpr std::array<batches_function<T, Compare>, sizeof...(K) + 1>
+make_table(std::index_sequence<K...>) {
+  return {nullptr, lower_bound_batches<K + 1, T, Compare>...};
+}
+
+template <class T, class Compare>
+void dispatch(size_t width, const T *const *arrays, bool one_array, size_t n,
+              const T *keys, size_t count, size_t *out, Compare less) {
+  static constexpr auto table = make_table<T, Compare>(
+      std::make_index_sequence<max_width>());
+  width = width == 0 ? default_width : std::min(width, max_width);
+  table[width](arrays, one_array, n, keys, count, out, less);
+}
+
+} // namespace internal
+
+// Widths tried by tune_width. Beyond 32, the lanes no longer fit in
+// registers and the gain stops everywhere we have looked.
+constexpr size_t candidate_widths[] = {1, 2, 4, 6, 8, 12, 16, 24, 32};
+
+// Times every candidate width on 'probes' keys drawn from data and returns
+// the fastest. Meaningful when data is larger than the caches, since this is
+// where batching pays off; on small arrays any width above 1 will do.
+template <std::ranges::contiguous_range Data, class Compare = std::less<>>
+size_t tune_width(const Data &data, size_t probes = 1 << 14,
+                  Compare less = Compare()) {
+  using T = std::ranges::range_value_t<Data>;
+  const size_t n = std::ranges::size(data);
+  if (n == 0) {
+    return 1;
+  }
+  std::vector<T> keys(probes);
+  std::vector<size_t> out(probes);
+  std::mt19937_64 gen(1234);
+  for (auto &key : keys) {
+    key = std::ranges::data(data)[gen() % n];
+  }
+  const T *array = std::ranges::data(data);
+  constexpr size_t candidates = std::size(candidate_widths);
+  double best[candidates];
+  // the best of five rounds, interleaved so that a slow spell of the
+  // machine does not penalize one width only
+  for (int round = 0; round < 5; round++) {
+    for (size_t c = 0; c < candidates; c++) {
+      auto start = std::chrono::steady_clock::now();
+      internal::dispatch(candidate_widths[c], &array, true, n, keys.data(),
+                         keys.size(), out.data(), less);
+      auto finish = std::chrono::steady_clock::now();
+      double t = std::chrono::duration<double>(finish - start).count();
+      best[c] = round == 0 ? t : std::min(best[c], t);
+    }
+  }
+  size_t best_width = candidate_widths[0];
+  double best_time = best[0];
+  for (size_t c = 1; c < candidates; c++) {
+    if (best[c] < best_time) {
+      best_width = candidate_widths[c];
+      best_time = best[c];
+    }
+  }
+  return best_width;
+}
+
+// tune_width on a 64 MiB array, measured on the first call (it takes a
+// fraction of a second) and then cached. Never called unless asked for.
+inline size_t machine_width() {
+  static const size_t width = [] {
+    std::vector<uint32_t> data(size_t(1) << 24);
+    for (size_t i = 0; i < data.size(); i++) {
+      data[i] = uint32_t(2 * i);
+    }
+    return tune_width(data);
+  }();
+  return width;
+}
+
+// out[i] = lower_bound of keys[i] in data, which is sorted according to
+// less. data and keys are contiguous ranges (std::vector, std::span...) of
+// the same type; out must have room for keys.size() entries. width = 0
+// stands for default_width.
+template <std::ranges::contiguous_range Data,
+          std::ranges::contiguous_range Keys, class Compare = std::less<>>
+void lower_bound(const Data &data, const Keys &keys, std::span<size_t> out,
+                 size_t width = 0, Compare less = Compare()) {
+  using T = std::ranges::range_value_t<Data>;
+  static_assert(std::is_same_v<T, std::ranges::range_value_t<Keys>>,
+                "keys and data have the same type");
+  const T *array = std::ranges::data(data);
+  internal::dispatch(width, &array, true, std::ranges::size(data),
+                     std::ranges::data(keys),
+                     std::min(size_t(std::ranges::size(keys)), out.size()),
+                     out.data(), less);
+}
+
+// Same, with the width fixed at compile time.
+template <size_t K, std::ranges::contiguous_range Data,
+          std::ranges::contiguous_range Keys, class Compare = std::less<>>
+void lower_bound_fixed(const Data &data, const Keys &keys,
+                       std::span<size_t> out, Compare less = Compare()) {
+  static_assert(K >= 1, "the width is at least 1");
+  using T = std::ranges::range_value_t<Data>;
+  static_assert(std::is_same_v<T, std::ranges::range_value_t<Keys>>,
+                "keys and data have the same type");
+  const T *array = std::ranges::data(data);
+  internal::lower_bound_batches<K>(
+      &array, true, std::ranges::size(data), std::ranges::data(keys),
+      std::min(size_t(std::ranges::size(keys)), out.size()), out.data(),
+      less);
+}
+
+// Many arrays of n values each: out[i] = lower_bound of keys[i] in
+// arrays[i], as in the binsearchN functions. arrays is a contiguous range
+// of const T *.
+template <std::ranges::contiguous_range Arrays,
+          std::ranges::contiguous_range Keys, class Compare = std::less<>>
+void lower_bound_many(const Arrays &arrays, size_t n, const Keys &keys,
+                      std::span<size_t> out, size_t width = 0,
+                      Compare less = Compare()) {
+  using T = std::ranges::range_value_t<Keys>;
+  static_assert(
+      std::is_convertible_v<std::ranges::range_value_t<Arrays>, const T *>,
+      "arrays holds pointers to the type of the keys");
+  const T *const *lanes = std::ranges::data(arrays);
+  internal::dispatch(width, lanes, false, n, std::ranges::data(keys),
+                     std::min({size_t(std::ranges::size(arrays)),
+                               size_t(std::ranges::size(keys)), out.size()}),
+                     out.data(), less);
+}
+
+} // namespace batchsearch
+
+#endif // BATCHSEARCH_H
@@ -0,0 +1,69 @@
+// Throughput of the batched lower_bound per width, in ns per key, against
+// std::lower_bound, for sorted arrays from L1-resident to far beyond the
+// last-level cache. The keys are random so that, on large arrays, almost
+// every probe misses. The last column is the width tune_width picks for
+// the array.
+#include "batchsearch.h"
+
+#include "../harness/harness.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+int main(int argc, char **argv) {
+  size_t count = argc > 1 ? size_t(atoll(argv[1])) : 1U << 16;
+  std::mt19937_64 gen(1234);
+  printf("default width: %zu\n", batchsearch::default_width);
+  printf("machine width: %zu\n", batchsearch::machine_width());
+  printf("array size\tstd (ns/key)");
+  for (size_t width : batchsearch::candidate_widths) {
+    printf("\tK=%zu", width);
+  }
+  printf("\ttuned K\n");
+  harness::options opts = harness::default_options();
+  for (size_t n = 1 << 10; n <= (1 << 26); n <<= 2) {
+    std::vector<uint32_t> data(n);
+    for (size_t i = 0; i < n; i++) {
+      data[i] = uint32_t(3 * i);
+    }
+    std::vector<uint32_t> keys(count);
+    for (auto &key : keys) {
+      key = uint32_t(gen() % (3 * n));
+    }
+    std::vector<size_t> expected(count), out(count);
+    auto reference = harness::run("std::lower_bound", count, [&] {
+      for (size_t i = 0; i < count; i++) {
+        expected[i] = size_t(
+            std::lower_bound(data.begin(), data.end(), keys[i]) -
+            data.begin());
+      }
+      harness::do_not_optimize(expected.data());
+    }, opts);
+    if (opts.format == HARNESS_TEXT) {
+      printf("%zu\t\t%.1f", n, reference.min() / count);
+    } else {
+      reference.report();
+    }
+    for (size_t width : batchsearch::candidate_widths) {
+      auto batched = harness::run("batched", count, [&] {
+        batchsearch::lower_bound(data, keys, out, width);
+        harness::do_not_optimize(out.data());
+      }, opts);
+      if (out != expected) {
+        printf("bug!\n");
+        return EXIT_FAILURE;
+      }
+      if (opts.format == HARNESS_TEXT) {
+        printf("\t%.1f", batched.min() / count);
+      } else {
+        batched.report();
+      }
+    }
+    if (opts.format == HARNESS_TEXT) {
+      printf("\t%zu\n", batchsearch::tune_width(data));
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,74 @@
+// Compares the batched searches with std::lower_bound, for every width and
+// the default one (0), array sizes that are not powers of two, duplicates
+// and a custom order.
+#include "batchsearch.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+template <class T, class Compare>
+bool check(size_t n, size_t count, Compare less) {
+  std::mt19937_64 gen(n * 31 + count);
+  std::vector<T> data(n);
+  for (auto &x : data) {
+    x = T(gen() % (2 * n + 1)); // with duplicates
+  }
+  std::sort(data.begin(), data.end(), less);
+  std::vector<T> keys(count);
+  for (auto &x : keys) {
+    x = T(gen() % (2 * n + 3));
+  }
+  std::vector<size_t> expected(count);
+  for (size_t i = 0; i < count; i++) {
+    expected[i] = size_t(std::lower_bound(data.begin(), data.end(), keys[i],
+                                          less) -
+                         data.begin());
+  }
+  std::vector<const T *> arrays(count);
+  for (size_t i = 0; i < count; i++) {
+    arrays[i] = data.data();
+  }
+  for (size_t width = 0; width <= batchsearch::max_width; width++) {
+    std::vector<size_t> out(count + 1, size_t(-1));
+    batchsearch::lower_bound(data, keys, std::span<size_t>(out.data(), count),
+                             width, less);
+    std::vector<size_t> many(count + 1, size_t(-1));
+    batchsearch::lower_bound_many(arrays, n, keys,
+                                  std::span<size_t>(many.data(), count),
+                                  width, less);
+    for (size_t i = 0; i < count; i++) {
+      if (out[i] != expected[i] || many[i] != expected[i]) {
+        printf("mismatch n = %zu width = %zu key = %zu\n", n, width, i);
+        return false;
+      }
+    }
+    if (out[count] != size_t(-1) || many[count] != size_t(-1)) {
+      printf("overflow n = %zu width = %zu\n", n, width);
+      return false;
+    }
+  }
+  std::vector<size_t> fixed(count);
+  batchsearch::lower_bound_fixed<7>(data, keys, fixed, less);
+  if (fixed != expected) {
+    printf("mismatch (fixed width) n = %zu\n", n);
+    return false;
+  }
+  return true;
+}
+
+int main() {
+  const size_t sizes[] = {0, 1, 2, 3, 17, 100, 1000, 4097};
+  for (size_t n : sizes) {
+    for (size_t count : {size_t(0), size_t(1), size_t(63), size_t(200)}) {
+      if (!check<uint32_t>(n, count, std::less<>()) ||
+          !check<int64_t>(n, count, std::greater<>()) ||
+          !check<double>(n, count, std::less<>())) {
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
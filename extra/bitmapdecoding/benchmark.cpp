@@ -0,0 +1,71 @@
+// Decoding speed per kernel and bit density, in ns per set bit, for one
+// call over the whole bitmap and for a stream that delivers the indices in
+// a ring of two 4096-entry buffers.
+#include "bitmapdecoding.h"
+
+#include "../harness/harness.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+int main(int argc, char **argv) {
+  size_t words = argc > 1 ? size_t(atoll(argv[1])) : 1U << 14;
+  std::vector<uint64_t> bitmap(words);
+  std::vector<uint32_t> out(words * 64);
+  std::mt19937_64 gen(1234);
+  const bitmapdecoding_kernel kernels[] = {
+      BITMAPDECODING_CTZ, BITMAPDECODING_UNROLLED, BITMAPDECODING_AVX512,
+      BITMAPDECODING_VBMI2};
+  printf("words = %zu, kernels: %s (sparse), %s (dense)\n", words,
+         bitmapdecoding_kernel_name(bitmapdecoding_sparse_kernel()),
+         bitmapdecoding_kernel_name(bitmapdecoding_dense_kernel()));
+  printf("density\tkernel  \tdecode (ns/index)\tstream (ns/index)\n");
+  harness::options opts = harness::default_options();
+  for (int shift = 8; shift >= 0; shift--) {
+    // each bit is set with probability 1 / 2^shift
+    for (auto &w : bitmap) {
+      w = ~uint64_t(0);
+      for (int i = 0; i < shift; i++) {
+        w &= gen();
+      }
+    }
+    const size_t count = bitmapdecoding_count(bitmap.data(), words);
+    for (bitmapdecoding_kernel k : kernels) {
+      if (!bitmapdecoding_kernel_supported(k)) {
+        continue;
+      }
+      auto decode = harness::run("decode", count, [&] {
+        bitmapdecoding_decode_with(k, bitmap.data(), words, out.data());
+      }, opts);
+      bitmapdecoding_options options = bitmapdecoding_default_options();
+      options.mode = BITMAPDECODING_SPARSE;
+      options.sparse_kernel = k;
+      size_t seen = 0;
+      bitmapdecoding::stream s(
+          [&](const uint32_t *p, size_t n) {
+            harness::do_not_optimize(p);
+            seen += n;
+          },
+          4096, 2, options);
+      auto streamed = harness::run("stream", count, [&] {
+        s.push(bitmap.data(), words);
+      }, opts);
+      s.finish();
+      if (seen != count * (opts.warmup + opts.repeat)) {
+        printf("bug!\n");
+        return EXIT_FAILURE;
+      }
+      if (opts.format == HARNESS_TEXT) {
+        printf("1/%d\t%-8s\t%.3f\t\t\t%.3f\n", 1 << shift,
+               bitmapdecoding_kernel_name(k), decode.min() / count,
+               streamed.min() / count);
+      } else {
+        decode.report();
+        streamed.report();
+      }
+    }
+  }
+  return EXIT_SUCCESS;
+}
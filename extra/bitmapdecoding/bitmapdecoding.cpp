@@ -0,0 +1,267 @@
+// Runtime dispatch, with a priority list for sparse bitmaps and one for
+// dense bitmaps, and the streaming decoder.
+#include "bitmapdecoding.h"
+#include "bitmapdecoding_kernels.h"
+
+#include "../isa/dispatch.h"
+
+namespace bitmapdecoding {
+namespace {
+
+struct implementation {
+  bitmapdecoding_kernel kind;
+  const char *name;
+  uint32_t required_instruction_sets;
+  words_function (*words)();
+};
+
+// Every processor with BMI1 has popcnt as well.
+const implementation ctz = {BITMAPDECODING_CTZ, "ctz", 0, ctz_kernel};
+const implementation unrolled = {BITMAPDECODING_UNROLLED, "unrolled",
+                                 instruction_set::BMI1, unrolled_kernel};
+const implementation avx512 = {BITMAPDECODING_AVX512, "avx512",
+                               instruction_set::AVX512F, avx512_kernel};
+const implementation vbmi2 = {BITMAPDECODING_VBMI2, "vbmi2",
+                              instruction_set::AVX512F |
+                                  instruction_set::AVX512BW |
+                                  instruction_set::AVX512VBMI2,
+                              vbmi2_kernel};
+
+const implementation *const sparse_implementations[] = {&unrolled, &ctz};
+const implementation *const dense_implementations[] = {&vbmi2, &avx512,
+                                                       &unrolled, &ctz};
+const implementation *const all_implementations[] = {&ctz, &unrolled,
+                                                     &avx512, &vbmi2};
+
+const implementation *best_sparse() {
+  static const implementation *best =
+      isa::first_supported(sparse_implementations, &ctz);
+  return best;
+}
+
+const implementation *best_dense() {
+  static const implementation *best =
+      isa::first_supported(dense_implementations, &ctz);
+  return best;
+}
+
+// nullptr if unknown or unsupported; AUTO is resolved by the caller
+const implementation *find(bitmapdecoding_kernel kernel) {
+  return isa::find(all_implementations, kernel);
+}
+
+size_t count(const uint64_t *bitmap, size_t words) {
+  return isa::supported(unrolled) ? count_popcnt(bitmap, words)
+                                  : count_portable(bitmap, words);
+}
+
+// Same contract as a words_function, but the kernel is picked for each
+// block of BITMAPDECODING_BLOCK_WORDS words from its population count (the
+// hamming() of 2022/05/10/bitmapdecoding.cpp): a filter bitmap has dense
+// and sparse regions, and no single kernel is best for both.
+size_t decode_adaptive(words_function sparse, words_function dense,
+                       uint32_t threshold, const uint64_t *bitmap,
+                       size_t words, uint32_t index, uint32_t *out,
+                       uint32_t &size, uint32_t room) {
+  const bool has_popcnt = isa::supported(unrolled);
+  size_t k = 0;
+  while (k < words) {
+    const size_t length = words - k < BITMAPDECODING_BLOCK_WORDS
+                              ? words - k
+                              : BITMAPDECODING_BLOCK_WORDS;
+    const size_t bits = has_popcnt ? count_popcnt(bitmap + k, length)
+                                   : count_portable(bitmap + k, length);
+    // a short last block is judged as if it were a full one
+    const words_function f =
+        bits * BITMAPDECODING_BLOCK_WORDS >= size_t(threshold) * length
+            ? dense
+            : sparse;
+    const size_t done =
+        f(bitmap + k, length, index + uint32_t(64 * k), out, size, room);
+    k += done;
+    if (done < length) {
+      break;
+    }
+  }
+  return k;
+}
+
+const uint64_t max_bits = uint64_t(1) << 32;
+
+// Hands the current buffer to the consumer and moves to the next one.
+int deliver(bitmapdecoding_stream *s) {
+  int status = 0;
+  if (s->size > 0) {
+    status = s->consumer(s->context, s->buffers[s->current], s->size);
+    s->current = (s->current + 1) % s->buffer_count;
+    s->size = 0;
+  }
+  return status;
+}
+
+} // namespace
+} // namespace bitmapdecoding
+
+using namespace bitmapdecoding;
+
+extern "C" {
+
+size_t bitmapdecoding_decode_with(bitmapdecoding_kernel kernel,
+                                  const uint64_t *bitmap, size_t words,
+                                  uint32_t *out) {
+  const implementation *impl =
+      kernel == BITMAPDECODING_AUTO ? best_sparse() : find(kernel);
+  if (impl == nullptr) {
+    return size_t(-1);
+  }
+  const words_function f = impl->words();
+  const words_function dense = best_dense()->words();
+  const uint32_t threshold = bitmapdecoding_default_options().dense_threshold;
+  // slices small enough that 'size' fits in 32 bits
+  const size_t slice = size_t(1) << 24;
+  size_t total = 0;
+  for (size_t k = 0; k < words; k += slice) {
+    const size_t length = words - k < slice ? words - k : slice;
+    const uint32_t index = uint32_t(64 * k);
+    const uint32_t room = uint32_t(64 * length);
+    uint32_t size = 0;
+    if (kernel == BITMAPDECODING_AUTO) {
+      decode_adaptive(f, dense, threshold, bitmap + k, length, index,
+                      out + total, size, room);
+    } else {
+      f(bitmap + k, length, index, out + total, size, room);
+    }
+    total += size;
+  }
+  return total;
+}
+
+size_t bitmapdecoding_decode(const uint64_t *bitmap, size_t words,
+                             uint32_t *out) {
+  return bitmapdecoding_decode_with(BITMAPDECODING_AUTO, bitmap, words, out);
+}
+
+size_t bitmapdecoding_count(const uint64_t *bitmap, size_t words) {
+  return count(bitmap, words);
+}
+
+int bitmapdecoding_kernel_supported(bitmapdecoding_kernel kernel) {
+  return kernel == BITMAPDECODING_AUTO || find(kernel) != nullptr;
+}
+
+bitmapdecoding_kernel bitmapdecoding_sparse_kernel(void) {
+  return best_sparse()->kind;
+}
+
+bitmapdecoding_kernel bitmapdecoding_dense_kernel(void) {
+  return best_dense()->kind;
+}
+
+const char *bitmapdecoding_kernel_name(bitmapdecoding_kernel kernel) {
+  if (kernel == BITMAPDECODING_AUTO) {
+    return "auto";
+  }
+  return isa::name_of(all_implementations, kernel);
+}
+
+bitmapdecoding_options bitmapdecoding_default_options(void) {
+  bitmapdecoding_options options;
+  options.mode = BITMAPDECODING_ADAPTIVE;
+  options.sparse_kernel = BITMAPDECODING_AUTO;
+  options.dense_kernel = BITMAPDECODING_AUTO;
+  // half a set bit per word: below, most words are empty and the sparse
+  // kernels skip them for almost nothing
+  options.dense_threshold = BITMAPDECODING_BLOCK_WORDS / 2;
+  return options;
+}
+
+int bitmapdecoding_stream_init(bitmapdecoding_stream *stream,
+                               uint32_t **buffers, size_t buffer_count,
+                               size_t capacity,
+                               bitmapdecoding_consumer consumer,
+                               void *context,
+                               const bitmapdecoding_options *options) {
+  const bitmapdecoding_options o =
+      options == nullptr ? bitmapdecoding_default_options() : *options;
+  const implementation *sparse = o.sparse_kernel == BITMAPDECODING_AUTO
+                                     ? best_sparse()
+                                     : find(o.sparse_kernel);
+  const implementation *dense = o.dense_kernel == BITMAPDECODING_AUTO
+                                    ? best_dense()
+                                    : find(o.dense_kernel);
+  if (buffers == nullptr || buffer_count == 0 ||
+      capacity < 2 * BITMAPDECODING_SLACK || capacity > max_bits - 1 ||
+      consumer == nullptr || sparse == nullptr || dense == nullptr) {
+    return -1;
+  }
+  for (size_t i = 0; i < buffer_count; i++) {
+    if (buffers[i] == nullptr) {
+      return -1;
+    }
+  }
+  stream->buffers = buffers;
+  stream->buffer_count = buffer_count;
+  stream->capacity = capacity;
+  stream->current = 0;
+  stream->size = 0;
+  stream->position = 0;
+  stream->consumer = consumer;
+  stream->context = context;
+  stream->sparse = sparse;
+  stream->dense = dense;
+  stream->mode = o.mode;
+  stream->dense_threshold = o.dense_threshold;
+  stream->status = 0;
+  return 0;
+}
+
+int bitmapdecoding_stream_push(bitmapdecoding_stream *stream,
+                               const uint64_t *words, size_t count) {
+  if (stream->status != 0) {
+    return stream->status;
+  }
+  if (count > (max_bits - stream->position) / 64) {
+    return stream->status = -1;
+  }
+  const words_function sparse =
+      static_cast<const implementation *>(stream->sparse)->words();
+  const words_function dense =
+      static_cast<const implementation *>(stream->dense)->words();
+  size_t k = 0;
+  for (;;) {
+    uint32_t size = uint32_t(stream->size);
+    uint32_t *out = stream->buffers[stream->current];
+    const uint32_t index = uint32_t(stream->position + 64 * k);
+    const uint32_t room = uint32_t(stream->capacity);
+    switch (stream->mode) {
+    case BITMAPDECODING_SPARSE:
+      k += sparse(words + k, count - k, index, out, size, room);
+      break;
+    case BITMAPDECODING_DENSE:
+      k += dense(words + k, count - k, index, out, size, room);
+      break;
+    default:
+      k += decode_adaptive(sparse, dense, stream->dense_threshold, words + k,
+                           count - k, index, out, size, room);
+    }
+    stream->size = size;
+    if (k == count) {
+      break;
+    }
+    // the buffer is nearly full
+    if ((stream->status = deliver(stream)) != 0) {
+      break;
+    }
+  }
+  stream->position += 64 * k;
+  return stream->status;
+}
+
+int bitmapdecoding_stream_finish(bitmapdecoding_stream *stream) {
+  if (stream->status != 0) {
+    return stream->status;
+  }
+  return stream->status = deliver(stream);
+}
+
+} // extern "C"
@@ -0,0 +1,181 @@
+// Decoding of bitmaps into arrays of set-bit indices.
+//
+// The kernels are those of 2018/02/20/bitmapdecode.c (bitmap_decode_ctz)
+// and of 2022/05/10/bitmapdecoding.cpp (faster_decoder, avx512_decoder,
+// vbmi2_decoder_cvtepu8), behind one API. Some kernels win on sparse
+// bitmaps, others on dense ones, and the best of each kind is picked at
+// runtime from the cpuid code of extra/isa/isa.h.
+//
+// Large bitmaps (say 10^9 bits) are decoded by a stream: the bitmap is
+// pushed in chunks of any size and the indices are written into a ring of
+// buffers owned by the caller, which get handed to a callback as they fill
+// up. Memory use is bounded by the ring, whatever the size of the bitmap.
+//
+// Bit i of word k has index 64 * k + i. Indices are 32-bit integers, so a
+// bitmap has at most 2^32 bits.
+//
+// All functions are usable from C and from C++.
+#ifndef BITMAPDECODING_H
+#define BITMAPDECODING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum bitmapdecoding_kernel {
+  BITMAPDECODING_AUTO = 0, // best supported kernel for the density
+  BITMAPDECODING_CTZ,      // one trailing-zero count per set bit
+  BITMAPDECODING_UNROLLED, // ctz unrolled by 8 and 16, needs popcnt
+  BITMAPDECODING_AVX512,   // compress-store of 16 indices at a time
+  BITMAPDECODING_VBMI2     // byte compression of all 64 indices
+} bitmapdecoding_kernel;
+
+typedef enum bitmapdecoding_mode {
+  BITMAPDECODING_ADAPTIVE = 0, // chosen for each block, from its density
+  BITMAPDECODING_SPARSE,
+  BITMAPDECODING_DENSE
+} bitmapdecoding_mode;
+
+// A kernel may write up to this many entries past the last index it
+// produces, so output buffers need that much slack.
+#define BITMAPDECODING_SLACK 64
+
+// In adaptive mode, the sparse or the dense kernel is picked for each block
+// of this many words, from its population count.
+#define BITMAPDECODING_BLOCK_WORDS 64
+
+// Decodes words 64-bit words into out, which must have room for
+// 64 * words entries. Returns the number of indices, or (size_t)-1 if the
+// kernel is not supported by this processor. With BITMAPDECODING_AUTO,
+// the kernels are switched block by block, as in adaptive mode.
+size_t bitmapdecoding_decode_with(bitmapdecoding_kernel kernel,
+                                  const uint64_t *bitmap, size_t words,
+                                  uint32_t *out);
+size_t bitmapdecoding_decode(const uint64_t *bitmap, size_t words,
+                             uint32_t *out);
+
+// Number of set bits.
+size_t bitmapdecoding_count(const uint64_t *bitmap, size_t words);
+
+// Whether the kernel can run on this processor.
+int bitmapdecoding_kernel_supported(bitmapdecoding_kernel kernel);
+
+// Kernels picked by BITMAPDECODING_AUTO for sparse and for dense bitmaps.
+bitmapdecoding_kernel bitmapdecoding_sparse_kernel(void);
+bitmapdecoding_kernel bitmapdecoding_dense_kernel(void);
+const char *bitmapdecoding_kernel_name(bitmapdecoding_kernel kernel);
+
+// Receives 'count' indices (in increasing order) that sit in one of the
+// ring buffers. The buffer stays untouched until buffer_count - 1 more
+// buffers have been delivered, so that a consumer may hand it to another
+// thread. A non-zero return value stops the stream.
+typedef int (*bitmapdecoding_consumer)(void *context, const uint32_t *indices,
+                                       size_t count);
+
+typedef struct bitmapdecoding_options {
+  bitmapdecoding_mode mode;
+  bitmapdecoding_kernel sparse_kernel; // BITMAPDECODING_AUTO: best one
+  bitmapdecoding_kernel dense_kernel;
+  // In adaptive mode, blocks of BITMAPDECODING_BLOCK_WORDS words with at
+  // least this many set bits go to the dense kernel.
+  uint32_t dense_threshold;
+} bitmapdecoding_options;
+
+bitmapdecoding_options bitmapdecoding_default_options(void);
+
+// The state of a stream. The fields are private.
+typedef struct bitmapdecoding_stream {
+  uint32_t **buffers;
+  size_t buffer_count;
+  size_t capacity;
+  size_t current;
+  size_t size;
+  uint64_t position; // bits consumed so far
+  bitmapdecoding_consumer consumer;
+  void *context;
+  const void *sparse;
+  const void *dense;
+  bitmapdecoding_mode mode;
+  uint32_t dense_threshold;
+  int status;
+} bitmapdecoding_stream;
+
+// Sets up a stream over buffer_count buffers of capacity entries each
+// (capacity >= 2 * BITMAPDECODING_SLACK). A delivered buffer holds between
+// capacity - BITMAPDECODING_SLACK + 1 and capacity indices, except for the
+// last one. options may be NULL. Returns 0, or -1 on bad arguments or an
+// unsupported kernel.
+int bitmapdecoding_stream_init(bitmapdecoding_stream *stream,
+                               uint32_t **buffers, size_t buffer_count,
+                               size_t capacity,
+                               bitmapdecoding_consumer consumer,
+                               void *context,
+                               const bitmapdecoding_options *options);
+
+// Decodes the next 'words' words of the bitmap. Returns 0, the non-zero
+// value returned by the consumer, or -1 past 2^32 bits. Once it has
+// returned non-zero, the stream ignores further input.
+int bitmapdecoding_stream_push(bitmapdecoding_stream *stream,
+                               const uint64_t *words, size_t count);
+
+// Delivers the indices that are still buffered. Same return values.
+int bitmapdecoding_stream_finish(bitmapdecoding_stream *stream);
+
+#ifdef __cplusplus
+} // extern "C"
+
+#include <functional>
+#include <vector>
+
+namespace bitmapdecoding {
+
+// Owns its ring and calls a std::function:
+//
+//   bitmapdecoding::stream s([&](const uint32_t *p, size_t n) { ... });
+//   while (...) s.push(chunk, words);
+//   s.finish();
+class stream {
+public:
+  typedef std::function<void(const uint32_t *, size_t)> consumer;
+
+  explicit stream(consumer c, size_t capacity = 4096, size_t buffer_count = 2,
+                  const bitmapdecoding_options &options =
+                      bitmapdecoding_default_options())
+      : storage(buffer_count * capacity), pointers(buffer_count),
+        callback(std::move(c)) {
+    for (size_t i = 0; i < buffer_count; i++) {
+      pointers[i] = storage.data() + i * capacity;
+    }
+    ok = bitmapdecoding_stream_init(&state, pointers.data(), buffer_count,
+                                    capacity, forward, this, &options) == 0;
+  }
+  stream(const stream &) = delete;
+  stream &operator=(const stream &) = delete;
+
+  // false if the options were bad or the bitmap too large
+  bool valid() const { return ok; }
+  bool push(const uint64_t *words, size_t count) {
+    return ok && bitmapdecoding_stream_push(&state, words, count) == 0;
+  }
+  bool finish() { return ok && bitmapdecoding_stream_finish(&state) == 0; }
+
+private:
+  static int forward(void *context, const uint32_t *indices, size_t count) {
+    static_cast<stream *>(context)->callback(indices, count);
+    return 0;
+  }
+  std::vector<uint32_t> storage;
+  std::vector<uint32_t *> pointers;
+  consumer callback;
+  bitmapdecoding_stream state;
+  bool ok;
+};
+
+} // namespace bitmapdecoding
+
+#endif // __cplusplus
+
+#endif // BITMAPDECODING_H
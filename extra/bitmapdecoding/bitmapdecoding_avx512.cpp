@@ -0,0 +1,33 @@
+// avx512_decoder of 2022/05/10/bitmapdecoding.cpp: the 64 indices of a word
+// are four vectors of 16, and each 16-bit slice of the word is the mask of
+// a compress-store. Compiled with -mavx512f -mpopcnt.
+#include "bitmapdecoding_kernels.h"
+
+#include <immintrin.h>
+
+namespace bitmapdecoding {
+namespace {
+
+inline void avx512_decoder(uint32_t *base_ptr, uint32_t &base, uint32_t idx,
+                           uint64_t bits) {
+  if (bits == 0) {
+    return;
+  }
+  const __m512i constant16 = _mm512_set1_epi32(16);
+  __m512i base_index = _mm512_add_epi32(
+      _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+      _mm512_set1_epi32(int(idx)));
+#pragma GCC unroll 4
+  for (int i = 0; i < 4; i++) {
+    const __mmask16 mask = __mmask16(bits >> (16 * i));
+    _mm512_mask_compressstoreu_epi32(base_ptr + base, mask, base_index);
+    base += uint32_t(_mm_popcnt_u32(mask));
+    base_index = _mm512_add_epi32(base_index, constant16);
+  }
+}
+
+} // namespace
+
+words_function avx512_kernel() { return decode_words<avx512_decoder>; }
+
+} // namespace bitmapdecoding
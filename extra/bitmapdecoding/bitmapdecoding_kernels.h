@@ -0,0 +1,60 @@
+// Word decoders shared by the kernels. Only the bitmapdecoding*.cpp files
+// include this header: each kernel lives in a file compiled with its own
+// -m flags.
+//
+// A word decoder has the signature of 2022/05/10/bitmapdecoding.cpp,
+//
+//   void F(uint32_t *base_ptr, uint32_t &base, uint32_t idx, uint64_t bits);
+//
+// it writes idx + i for every bit i set in bits at base_ptr[base...] and
+// advances base. It may write up to BITMAPDECODING_SLACK entries past the
+// new base.
+#ifndef BITMAPDECODING_KERNELS_H
+#define BITMAPDECODING_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "bitmapdecoding.h"
+
+namespace bitmapdecoding {
+
+// Decodes words from bitmap (bit 0 of bitmap[0] has index 'index') into
+// out[size...], as long as a full word is sure to fit below 'room'.
+// Returns the number of words consumed.
+typedef size_t (*words_function)(const uint64_t *bitmap, size_t words,
+                                 uint32_t index, uint32_t *out,
+                                 uint32_t &size, uint32_t room);
+
+template <void (*F)(uint32_t *, uint32_t &, uint32_t, uint64_t)>
+size_t decode_words(const uint64_t *bitmap, size_t words, uint32_t index,
+                    uint32_t *out, uint32_t &size, uint32_t room) {
+  size_t k = 0;
+  while (k < words) {
+    // each word gives at most 64 indices, plus the slack
+    const size_t safe = room - size < BITMAPDECODING_SLACK
+                            ? 0
+                            : (room - size - BITMAPDECODING_SLACK) / 64 + 1;
+    if (safe == 0) {
+      break;
+    }
+    const size_t end = words - k < safe ? words : k + safe;
+    for (; k < end; k++) {
+      F(out, size, index + uint32_t(64 * k), bitmap[k]);
+    }
+  }
+  return k;
+}
+
+// Population counts, with and without the popcnt instruction.
+size_t count_portable(const uint64_t *bitmap, size_t words);
+size_t count_popcnt(const uint64_t *bitmap, size_t words);
+
+words_function ctz_kernel();
+words_function unrolled_kernel();
+words_function avx512_kernel();
+words_function vbmi2_kernel();
+
+} // namespace bitmapdecoding
+
+#endif // BITMAPDECODING_KERNELS_H
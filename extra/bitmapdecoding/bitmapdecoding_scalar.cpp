@@ -0,0 +1,29 @@
+// bitmap_decode_ctz of 2018/02/20/bitmapdecode.c (basic_decoder in
+// 2022/05/10/bitmapdecoding.cpp): one trailing-zero count per set bit. It
+// needs no particular instruction and is hard to beat on sparse bitmaps.
+#include "bitmapdecoding_kernels.h"
+
+namespace bitmapdecoding {
+namespace {
+
+inline void ctz_decoder(uint32_t *base_ptr, uint32_t &base, uint32_t idx,
+                        uint64_t bits) {
+  while (bits != 0) {
+    base_ptr[base++] = idx + uint32_t(__builtin_ctzll(bits));
+    bits = bits & (bits - 1);
+  }
+}
+
+} // namespace
+
+size_t count_portable(const uint64_t *bitmap, size_t words) {
+  size_t count = 0;
+  for (size_t k = 0; k < words; k++) {
+    count += size_t(__builtin_popcountll(bitmap[k]));
+  }
+  return count;
+}
+
+words_function ctz_kernel() { return decode_words<ctz_decoder>; }
+
+} // namespace bitmapdecoding
@@ -0,0 +1,54 @@
+// faster_decoder of 2022/05/10/bitmapdecoding.cpp, after the simdjson
+// decoder: the first 8 (then 16) indices are written without branching on
+// each bit, so that mispredictions only happen once per word. Compiled with
+// -mpopcnt -mbmi.
+#include "bitmapdecoding_kernels.h"
+
+#include <x86intrin.h>
+
+namespace bitmapdecoding {
+namespace {
+
+inline void unrolled_decoder(uint32_t *base_ptr, uint32_t &base,
+                             uint32_t idx, uint64_t bits) {
+  if (bits == 0) {
+    return;
+  }
+  const uint32_t cnt = uint32_t(_mm_popcnt_u64(bits));
+  const uint32_t next_base = base + cnt;
+  uint32_t *out = base_ptr + base;
+#pragma GCC unroll 8
+  for (int i = 0; i < 8; i++) {
+    out[i] = idx + uint32_t(_tzcnt_u64(bits));
+    bits = _blsr_u64(bits);
+  }
+  if (cnt > 8) {
+#pragma GCC unroll 8
+    for (int i = 8; i < 16; i++) {
+      out[i] = idx + uint32_t(_tzcnt_u64(bits));
+      bits = _blsr_u64(bits);
+    }
+  }
+  if (cnt > 16) {
+    out += 16;
+    do {
+      *out++ = idx + uint32_t(_tzcnt_u64(bits));
+      bits = _blsr_u64(bits);
+    } while (bits != 0);
+  }
+  base = next_base;
+}
+
+} // namespace
+
+size_t count_popcnt(const uint64_t *bitmap, size_t words) {
+  size_t count = 0;
+  for (size_t k = 0; k < words; k++) {
+    count += size_t(_mm_popcnt_u64(bitmap[k]));
+  }
+  return count;
+}
+
+words_function unrolled_kernel() { return decode_words<unrolled_decoder>; }
+
+} // namespace bitmapdecoding
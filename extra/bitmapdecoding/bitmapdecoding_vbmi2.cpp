@@ -0,0 +1,46 @@
+// vbmi2_decoder_cvtepu8 of 2022/05/10/bitmapdecoding.cpp (credit to Kim
+// Walisch and Jatin Bhateja): one byte compression gives the positions of
+// all set bits, which are widened to 32 bits by slices of 16. The stores
+// beyond the set bits are wasted but unconditional, which is what we want
+// on dense bitmaps. Compiled with -mavx512f -mavx512bw -mavx512vbmi2
+// -mpopcnt.
+#include "bitmapdecoding_kernels.h"
+
+// GCC 12 warns about _mm512_undefined_epi32 inside its own intrinsics.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+
+namespace bitmapdecoding {
+namespace {
+
+inline void vbmi2_decoder(uint32_t *base_ptr, uint32_t &base, uint32_t idx,
+                          uint64_t bits) {
+  const __m512i indexes = _mm512_maskz_compress_epi8(
+      bits, _mm512_set_epi32(0x3f3e3d3c, 0x3b3a3938, 0x37363534, 0x33323130,
+                             0x2f2e2d2c, 0x2b2a2928, 0x27262524, 0x23222120,
+                             0x1f1e1d1c, 0x1b1a1918, 0x17161514, 0x13121110,
+                             0x0f0e0d0c, 0x0b0a0908, 0x07060504,
+                             0x03020100));
+  const __m512i start_index = _mm512_set1_epi32(int(idx));
+  const __m512i t0 = _mm512_cvtepu8_epi32(_mm512_castsi512_si128(indexes));
+  const __m512i t1 =
+      _mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(indexes, 1));
+  const __m512i t2 =
+      _mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(indexes, 2));
+  const __m512i t3 =
+      _mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(indexes, 3));
+  _mm512_storeu_si512(base_ptr + base, _mm512_add_epi32(t0, start_index));
+  _mm512_storeu_si512(base_ptr + base + 16, _mm512_add_epi32(t1, start_index));
+  _mm512_storeu_si512(base_ptr + base + 32, _mm512_add_epi32(t2, start_index));
+  _mm512_storeu_si512(base_ptr + base + 48, _mm512_add_epi32(t3, start_index));
+  base += uint32_t(_mm_popcnt_u64(bits));
+}
+
+} // namespace
+
+words_function vbmi2_kernel() { return decode_words<vbmi2_decoder>; }
+
+} // namespace bitmapdecoding
@@ -0,0 +1,111 @@
+// Decoding speed on bitmaps that mix dense and sparse regions, in ns per
+// set bit: every kernel alone, then the adaptive decoder, which picks a
+// kernel for each block of 64 words. The bitmaps are those of
+// 2022/05/10/bitmapdecoding.cpp (build_bitmap: the positions of a
+// character, and of the control characters, in nfl.csv) and a synthetic one
+// whose density changes every few blocks.
+#include "bitmapdecoding.h"
+
+#include "../harness/harness.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+std::vector<uint64_t> build_bitmap(const char *filename, char target) {
+  std::ifstream in(filename, std::ios::binary);
+  std::string filedata((std::istreambuf_iterator<char>(in)),
+                       std::istreambuf_iterator<char>());
+  std::vector<uint64_t> data(filedata.size() / 64);
+  for (size_t i = 0; i < data.size() * 64; i++) {
+    if ((filedata[i] == target) || ((unsigned char)filedata[i] < 0x20)) {
+      data[i / 64] |= (UINT64_C(1) << (i % 64));
+    }
+  }
+  return data;
+}
+
+// Runs of 1 to 16 blocks, each with its own density, from 1/256 to 1/1.
+std::vector<uint64_t> build_mixed_bitmap(size_t words) {
+  std::vector<uint64_t> data(words);
+  std::mt19937_64 gen(1234);
+  size_t k = 0;
+  while (k < words) {
+    const size_t end =
+        std::min(words, k + BITMAPDECODING_BLOCK_WORDS * (1 + gen() % 16));
+    const int shift = int(gen() % 9);
+    for (; k < end; k++) {
+      uint64_t w = ~uint64_t(0);
+      for (int i = 0; i < shift; i++) {
+        w &= gen();
+      }
+      data[k] = w;
+    }
+  }
+  return data;
+}
+
+bool bench(const char *name, const std::vector<uint64_t> &bitmap) {
+  const bitmapdecoding_kernel kernels[] = {
+      BITMAPDECODING_CTZ, BITMAPDECODING_UNROLLED, BITMAPDECODING_AVX512,
+      BITMAPDECODING_VBMI2, BITMAPDECODING_AUTO};
+  const size_t words = bitmap.size();
+  const size_t count = bitmapdecoding_count(bitmap.data(), words);
+  std::vector<uint32_t> out(words * 64);
+  std::vector<uint32_t> expected(words * 64);
+  bitmapdecoding_decode_with(BITMAPDECODING_CTZ, bitmap.data(), words,
+                             expected.data());
+  harness::options opts = harness::default_options();
+  for (bitmapdecoding_kernel k : kernels) {
+    if (!bitmapdecoding_kernel_supported(k)) {
+      continue;
+    }
+    auto decode = harness::run(name, count, [&] {
+      bitmapdecoding_decode_with(k, bitmap.data(), words, out.data());
+    }, opts);
+    for (size_t i = 0; i < count; i++) {
+      if (out[i] != expected[i]) {
+        printf("bug!\n");
+        return false;
+      }
+    }
+    if (opts.format == HARNESS_TEXT) {
+      printf("%-8s\t%.3f\t\t%-8s\t%.3f\n", name,
+             double(count) / double(words * 64),
+             k == BITMAPDECODING_AUTO ? "adaptive"
+                                      : bitmapdecoding_kernel_name(k),
+             decode.min() / count);
+    } else {
+      decode.report();
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  const char *filename = argc > 1 ? argv[1] : "../../2022/05/10/nfl.csv";
+  printf("kernels: %s (sparse), %s (dense)\n",
+         bitmapdecoding_kernel_name(bitmapdecoding_sparse_kernel()),
+         bitmapdecoding_kernel_name(bitmapdecoding_dense_kernel()));
+  printf("bitmap  \tdensity\t\tkernel  \tns/index\n");
+  const char targets[] = {',', 'e', '('};
+  for (char target : targets) {
+    std::vector<uint64_t> bitmap = build_bitmap(filename, target);
+    if (bitmap.empty()) {
+      printf("cannot read %s\n", filename);
+      return EXIT_FAILURE;
+    }
+    const std::string name = std::string("nfl '") + target + "'";
+    if (!bench(name.c_str(), bitmap)) {
+      return EXIT_FAILURE;
+    }
+  }
+  if (!bench("mixed", build_mixed_bitmap(1U << 15))) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
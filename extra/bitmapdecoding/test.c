@@ -0,0 +1,240 @@
+// Checks of the bitmap decoders, through the C interface: every kernel on
+// bitmaps of various densities, and streams with small rings, odd chunk
+// sizes and every mode.
+#include "bitmapdecoding.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const bitmapdecoding_kernel kernels[] = {
+    BITMAPDECODING_AUTO, BITMAPDECODING_CTZ, BITMAPDECODING_UNROLLED,
+    BITMAPDECODING_AVX512, BITMAPDECODING_VBMI2};
+
+// Each bit is set with probability 1 / 2^shift (shift = 0: every bit).
+// With shift < 0, the probability changes every few words, so that the
+// adaptive decoder switches kernels within a block and across blocks.
+static void fill(uint64_t *bitmap, size_t words, int shift) {
+  size_t k;
+  int i, j, s = shift;
+  for (k = 0; k < words; k++) {
+    uint64_t w = ~(uint64_t)0;
+    if (shift < 0 && k % 40 == 0) {
+      s = rand() % 9;
+    }
+    for (i = 0; i < s; i++) {
+      uint64_t r = 0;
+      for (j = 0; j < 4; j++) {
+        r = (r << 16) ^ (uint64_t)(rand() & 0xFFFF);
+      }
+      w &= r;
+    }
+    bitmap[k] = w;
+  }
+}
+
+static size_t reference(const uint64_t *bitmap, size_t words,
+                        uint32_t *out) {
+  size_t pos = 0, k;
+  int i;
+  for (k = 0; k < words; k++) {
+    for (i = 0; i < 64; i++) {
+      if ((bitmap[k] >> i) & 1) {
+        out[pos++] = (uint32_t)(k * 64 + (size_t)i);
+      }
+    }
+  }
+  return pos;
+}
+
+static int check_kernels(const uint64_t *bitmap, size_t words,
+                         const uint32_t *expected, size_t count) {
+  uint32_t *out = (uint32_t *)malloc((words * 64 + 1) * sizeof(uint32_t));
+  size_t b, i;
+  int ok = 1;
+  if (bitmapdecoding_count(bitmap, words) != count) {
+    printf("bad count, words = %zu\n", words);
+    ok = 0;
+  }
+  for (b = 0; ok && b < sizeof(kernels) / sizeof(kernels[0]); b++) {
+    if (!bitmapdecoding_kernel_supported(kernels[b])) {
+      continue;
+    }
+    out[words * 64] = 0xdeadbeef;
+    if (bitmapdecoding_decode_with(kernels[b], bitmap, words, out) != count) {
+      printf("%s: bad count, words = %zu\n",
+             bitmapdecoding_kernel_name(kernels[b]), words);
+      ok = 0;
+      break;
+    }
+    for (i = 0; i < count; i++) {
+      if (out[i] != expected[i]) {
+        printf("%s: mismatch at %zu, words = %zu\n",
+               bitmapdecoding_kernel_name(kernels[b]), i, words);
+        ok = 0;
+        break;
+      }
+    }
+    if (out[words * 64] != 0xdeadbeef) {
+      printf("%s: overflow, words = %zu\n",
+             bitmapdecoding_kernel_name(kernels[b]), words);
+      ok = 0;
+    }
+  }
+  free(out);
+  return ok;
+}
+
+typedef struct collector {
+  uint32_t **buffers;
+  size_t buffer_count;
+  size_t capacity;
+  size_t deliveries;
+  uint32_t *indices;
+  size_t count;
+  int ok;
+} collector;
+
+static int collect(void *context, const uint32_t *indices, size_t count) {
+  collector *c = (collector *)context;
+  if (indices != c->buffers[c->deliveries % c->buffer_count] ||
+      count > c->capacity || count == 0) {
+    c->ok = 0;
+  }
+  memcpy(c->indices + c->count, indices, count * sizeof(uint32_t));
+  c->count += count;
+  c->deliveries++;
+  return 0;
+}
+
+static int check_stream(const uint64_t *bitmap, size_t words,
+                        const uint32_t *expected, size_t count,
+                        size_t capacity, size_t buffer_count, size_t chunk,
+                        bitmapdecoding_mode mode) {
+  uint32_t **buffers = (uint32_t **)malloc(buffer_count * sizeof(uint32_t *));
+  bitmapdecoding_options options = bitmapdecoding_default_options();
+  bitmapdecoding_stream stream;
+  collector c;
+  size_t i;
+  int ok = 1;
+  for (i = 0; i < buffer_count; i++) {
+    buffers[i] = (uint32_t *)malloc(capacity * sizeof(uint32_t));
+  }
+  c.buffers = buffers;
+  c.buffer_count = buffer_count;
+  c.capacity = capacity;
+  c.deliveries = 0;
+  c.indices = (uint32_t *)malloc((count + 1) * sizeof(uint32_t));
+  c.count = 0;
+  c.ok = 1;
+  options.mode = mode;
+  if (bitmapdecoding_stream_init(&stream, buffers, buffer_count, capacity,
+                                 collect, &c, &options) != 0) {
+    printf("cannot init the stream\n");
+    ok = 0;
+  }
+  for (i = 0; ok && i < words; i += chunk) {
+    size_t length = words - i < chunk ? words - i : chunk;
+    if (bitmapdecoding_stream_push(&stream, bitmap + i, length) != 0) {
+      printf("push failed\n");
+      ok = 0;
+    }
+  }
+  if (ok && bitmapdecoding_stream_finish(&stream) != 0) {
+    printf("finish failed\n");
+    ok = 0;
+  }
+  if (ok && (!c.ok || c.count != count ||
+             memcmp(c.indices, expected, count * sizeof(uint32_t)) != 0)) {
+    printf("stream mismatch, words = %zu capacity = %zu buffers = %zu "
+           "chunk = %zu mode = %d\n",
+           words, capacity, buffer_count, chunk, (int)mode);
+    ok = 0;
+  }
+  for (i = 0; i < buffer_count; i++) {
+    free(buffers[i]);
+  }
+  free(buffers);
+  free(c.indices);
+  return ok;
+}
+
+// Stopping from the consumer, and the 2^32-bit limit.
+static int check_errors(void) {
+  static uint64_t bitmap[64];
+  uint32_t storage[128];
+  uint32_t *buffers[1];
+  bitmapdecoding_stream stream;
+  collector c;
+  buffers[0] = storage;
+  memset(&c, 0, sizeof(c));
+  c.buffers = buffers;
+  c.buffer_count = 1;
+  c.capacity = 128;
+  if (bitmapdecoding_stream_init(&stream, buffers, 1, 64, collect, &c,
+                                 NULL) != -1) {
+    printf("accepted a tiny buffer\n");
+    return 0;
+  }
+  if (bitmapdecoding_stream_init(&stream, buffers, 1, 128, collect, &c,
+                                 NULL) != 0) {
+    printf("cannot init the stream\n");
+    return 0;
+  }
+  if (bitmapdecoding_stream_push(&stream, bitmap,
+                                 ((size_t)1 << 26) + 1) != -1) {
+    printf("accepted more than 2^32 bits\n");
+    return 0;
+  }
+  if (bitmapdecoding_stream_push(&stream, bitmap, 1) != -1) {
+    printf("the error did not stick\n");
+    return 0;
+  }
+  return 1;
+}
+
+int main(void) {
+  static const size_t lengths[] = {0, 1, 7, 64, 1000, 3000};
+  static const int shifts[] = {0, 1, 3, 6, 10, -1};
+  static const size_t capacities[] = {128, 200, 1000};
+  static const size_t chunks[] = {1, 3, 64, 1000};
+  static const bitmapdecoding_mode modes[] = {
+      BITMAPDECODING_ADAPTIVE, BITMAPDECODING_SPARSE, BITMAPDECODING_DENSE};
+  size_t l, s, c, b, h, m;
+  printf("kernels: %s (sparse), %s (dense)\n",
+         bitmapdecoding_kernel_name(bitmapdecoding_sparse_kernel()),
+         bitmapdecoding_kernel_name(bitmapdecoding_dense_kernel()));
+  for (l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+    for (s = 0; s < sizeof(shifts) / sizeof(shifts[0]); s++) {
+      size_t words = lengths[l];
+      uint64_t *bitmap = (uint64_t *)malloc((words + 1) * sizeof(uint64_t));
+      uint32_t *expected =
+          (uint32_t *)malloc((words * 64 + 1) * sizeof(uint32_t));
+      size_t count;
+      int ok;
+      fill(bitmap, words, shifts[s]);
+      count = reference(bitmap, words, expected);
+      ok = check_kernels(bitmap, words, expected, count);
+      for (c = 0; ok && c < sizeof(capacities) / sizeof(capacities[0]); c++) {
+        for (b = 1; ok && b <= 3; b++) {
+          for (h = 0; ok && h < sizeof(chunks) / sizeof(chunks[0]); h++) {
+            for (m = 0; ok && m < sizeof(modes) / sizeof(modes[0]); m++) {
+              ok = check_stream(bitmap, words, expected, count,
+                                capacities[c], b, chunks[h], modes[m]);
+            }
+          }
+        }
+      }
+      free(bitmap);
+      free(expected);
+      if (!ok) {
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  if (!check_errors()) {
+    return EXIT_FAILURE;
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
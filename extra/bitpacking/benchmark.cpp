@@ -0,0 +1,54 @@
+// Packing and unpacking speed per bit width and back end, in ns per integer.
+#include "bitpacking.h"
+
+#include "../harness/harness.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+int main(int argc, char **argv) {
+  size_t N = argc > 1 ? size_t(atoll(argv[1])) : 1U << 16;
+  std::vector<uint32_t> data(N);
+  std::mt19937 gen(1234);
+  for (auto &x : data) {
+    x = uint32_t(gen());
+  }
+  std::vector<uint32_t> packed(bitpacking_packed_words(N, 32));
+  std::vector<uint32_t> recovered(N);
+  const bitpacking_backend backends[] = {BITPACKING_SCALAR, BITPACKING_SSE41,
+                                         BITPACKING_AVX2, BITPACKING_AVX512};
+  printf("N = %zu, active back end: %s\n", N,
+         bitpacking_backend_name(bitpacking_active_backend()));
+  printf("bits\tback end\tpack (ns/int)\tunpack (ns/int)\n");
+  harness::options opts = harness::default_options();
+  for (uint32_t bit = 1; bit <= 32; bit++) {
+    for (bitpacking_backend b : backends) {
+      if (!bitpacking_backend_supported(b)) {
+        continue;
+      }
+      auto pack = harness::run("pack", N, [&] {
+        bitpacking_pack_with(b, data.data(), N, packed.data(), bit);
+      }, opts);
+      auto unpack = harness::run("unpack", N, [&] {
+        bitpacking_unpack_with(b, packed.data(), N, recovered.data(), bit);
+      }, opts);
+      const uint32_t mask = bit == 32 ? 0xFFFFFFFF : (1U << bit) - 1;
+      for (size_t i = 0; i < N; i++) {
+        if (recovered[i] != (data[i] & mask)) {
+          printf("bug!\n");
+          return EXIT_FAILURE;
+        }
+      }
+      if (opts.format == HARNESS_TEXT) {
+        printf("%u\t%-8s\t%.3f\t\t%.3f\n", bit, bitpacking_backend_name(b),
+               pack.min() / N, unpack.min() / N);
+      } else {
+        pack.report();
+        unpack.report();
+      }
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,253 @@
+// Runtime dispatch and the tail (n % 512) code of the bit-packing codec.
+#include "bitpacking.h"
+#include "bitpacking_kernels.h"
+
+#include "../isa/dispatch.h"
+
+namespace bitpacking {
+namespace {
+
+struct implementation {
+  bitpacking_backend kind;
+  const char *name;
+  uint32_t required_instruction_sets;
+  const block_table &(*table)();
+};
+
+const implementation avx512 = {BITPACKING_AVX512, "avx512",
+                               instruction_set::AVX512F, avx512_table};
+const implementation avx2 = {BITPACKING_AVX2, "avx2", instruction_set::AVX2,
+                             avx2_table};
+const implementation sse41 = {BITPACKING_SSE41, "sse4.1",
+                              instruction_set::SSE41, sse41_table};
+const implementation scalar = {BITPACKING_SCALAR, "scalar", 0, scalar_table};
+
+const implementation *const implementations[] = {&avx512, &avx2, &sse41,
+                                                 &scalar};
+
+const implementation *active() {
+  static const implementation *best =
+      isa::first_supported(implementations, &scalar);
+  return best;
+}
+
+// nullptr if unknown or unsupported
+const implementation *find(bitpacking_backend backend) {
+  if (backend == BITPACKING_AUTO) {
+    return active();
+  }
+  return isa::find(implementations, backend);
+}
+
+// The last n % 512 values: a plain little-endian bit stream.
+size_t pack_tail(const uint32_t *in, size_t n, uint32_t *out, uint32_t bit) {
+  if (bit == 0) {
+    return 0;
+  }
+  const uint64_t mask = (uint64_t(1) << bit) - 1;
+  uint64_t buffer = 0;
+  uint32_t filled = 0;
+  size_t written = 0;
+  for (size_t i = 0; i < n; i++) {
+    buffer |= (in[i] & mask) << filled;
+    filled += bit;
+    if (filled >= 32) {
+      out[written++] = uint32_t(buffer);
+      buffer >>= 32;
+      filled -= 32;
+    }
+  }
+  if (filled > 0) {
+    out[written++] = uint32_t(buffer);
+  }
+  return written;
+}
+
+size_t unpack_tail(const uint32_t *in, size_t n, uint32_t *out,
+                   uint32_t bit) {
+  if (bit == 0) {
+    for (size_t i = 0; i < n; i++) {
+      out[i] = 0;
+    }
+    return 0;
+  }
+  const uint64_t mask = (uint64_t(1) << bit) - 1;
+  const size_t words = (n * bit + 31) / 32;
+  uint64_t buffer = 0;
+  uint32_t filled = 0;
+  size_t read = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (filled < bit) {
+      buffer |= uint64_t(in[read++]) << filled;
+      filled += 32;
+    }
+    out[i] = uint32_t(buffer & mask);
+    buffer >>= bit;
+    filled -= bit;
+  }
+  return words;
+}
+
+uint32_t delta_distance(bitpacking_delta mode) {
+  return mode == BITPACKING_D4 ? 4 : 1;
+}
+
+// Differential coding of the tail, with the last four values before it.
+size_t pack_delta_tail(const uint32_t *in, size_t n, uint32_t *out,
+                       uint32_t bit, const uint32_t *last4,
+                       bitpacking_delta mode) {
+  uint32_t deltas[BITPACKING_BLOCK_SIZE];
+  const uint32_t k = delta_distance(mode);
+  for (size_t i = 0; i < n; i++) {
+    deltas[i] = in[i] - (i >= k ? in[i - k] : last4[4 - k + i]);
+  }
+  return pack_tail(deltas, n, out, bit);
+}
+
+size_t unpack_delta_tail(const uint32_t *in, size_t n, uint32_t *out,
+                         uint32_t bit, const uint32_t *last4,
+                         bitpacking_delta mode) {
+  const uint32_t k = delta_distance(mode);
+  size_t read = unpack_tail(in, n, out, bit);
+  for (size_t i = 0; i < n; i++) {
+    out[i] += (i >= k ? out[i - k] : last4[4 - k + i]);
+  }
+  return read;
+}
+
+} // namespace
+} // namespace bitpacking
+
+using namespace bitpacking;
+
+extern "C" {
+
+size_t bitpacking_packed_words(size_t n, uint32_t bit) {
+  return (n / BITPACKING_BLOCK_SIZE) * block_lanes * bit +
+         ((n % BITPACKING_BLOCK_SIZE) * bit + 31) / 32;
+}
+
+uint32_t bitpacking_max_bits(const uint32_t *in, size_t n) {
+  uint32_t accumulator = 0;
+  for (size_t i = 0; i < n; i++) {
+    accumulator |= in[i];
+  }
+  return accumulator == 0 ? 0 : 32 - __builtin_clz(accumulator);
+}
+
+size_t bitpacking_pack_with(bitpacking_backend backend, const uint32_t *in,
+                            size_t n, uint32_t *out, uint32_t bit) {
+  const implementation *impl = find(backend);
+  if (impl == nullptr || bit > 32) {
+    return size_t(-1);
+  }
+  const size_t blocks = n / BITPACKING_BLOCK_SIZE;
+  size_t written = pack_blocks(impl->table(), in, blocks, out, bit);
+  written += pack_tail(in + blocks * BITPACKING_BLOCK_SIZE,
+                       n % BITPACKING_BLOCK_SIZE, out + written, bit);
+  return written;
+}
+
+size_t bitpacking_unpack_with(bitpacking_backend backend, const uint32_t *in,
+                              size_t n, uint32_t *out, uint32_t bit) {
+  const implementation *impl = find(backend);
+  if (impl == nullptr || bit > 32) {
+    return size_t(-1);
+  }
+  const size_t blocks = n / BITPACKING_BLOCK_SIZE;
+  size_t read = unpack_blocks(impl->table(), in, blocks, out, bit);
+  read += unpack_tail(in + read, n % BITPACKING_BLOCK_SIZE,
+                      out + blocks * BITPACKING_BLOCK_SIZE, bit);
+  return read;
+}
+
+size_t bitpacking_pack(const uint32_t *in, size_t n, uint32_t *out,
+                       uint32_t bit) {
+  return bitpacking_pack_with(BITPACKING_AUTO, in, n, out, bit);
+}
+
+size_t bitpacking_unpack(const uint32_t *in, size_t n, uint32_t *out,
+                         uint32_t bit) {
+  return bitpacking_unpack_with(BITPACKING_AUTO, in, n, out, bit);
+}
+
+uint32_t bitpacking_max_bits_delta(const uint32_t *in, size_t n,
+                                   uint32_t initial, bitpacking_delta mode) {
+  const size_t k = delta_distance(mode);
+  uint32_t accumulator = 0;
+  for (size_t i = 0; i < n; i++) {
+    accumulator |= in[i] - (i >= k ? in[i - k] : initial);
+  }
+  return accumulator == 0 ? 0 : 32 - __builtin_clz(accumulator);
+}
+
+size_t bitpacking_pack_delta_with(bitpacking_backend backend,
+                                  const uint32_t *in, size_t n, uint32_t *out,
+                                  uint32_t bit, uint32_t initial,
+                                  bitpacking_delta mode) {
+  const implementation *impl = find(backend);
+  if (impl == nullptr || bit > 32 ||
+      (mode != BITPACKING_D1 && mode != BITPACKING_D4)) {
+    return size_t(-1);
+  }
+  const block_table &t = impl->table();
+  uint32_t last4[4] = {initial, initial, initial, initial};
+  const size_t blocks = n / BITPACKING_BLOCK_SIZE;
+  size_t written = (mode == BITPACKING_D1 ? t.pack_d1 : t.pack_d4)[bit](
+      in, blocks, out, last4);
+  written += pack_delta_tail(in + blocks * BITPACKING_BLOCK_SIZE,
+                             n % BITPACKING_BLOCK_SIZE, out + written, bit,
+                             last4, mode);
+  return written;
+}
+
+size_t bitpacking_unpack_delta_with(bitpacking_backend backend,
+                                    const uint32_t *in, size_t n,
+                                    uint32_t *out, uint32_t bit,
+                                    uint32_t initial, bitpacking_delta mode) {
+  const implementation *impl = find(backend);
+  if (impl == nullptr || bit > 32 ||
+      (mode != BITPACKING_D1 && mode != BITPACKING_D4)) {
+    return size_t(-1);
+  }
+  const block_table &t = impl->table();
+  uint32_t last4[4] = {initial, initial, initial, initial};
+  const size_t blocks = n / BITPACKING_BLOCK_SIZE;
+  size_t read = (mode == BITPACKING_D1 ? t.unpack_d1 : t.unpack_d4)[bit](
+      in, blocks, out, last4);
+  read += unpack_delta_tail(in + read, n % BITPACKING_BLOCK_SIZE,
+                            out + blocks * BITPACKING_BLOCK_SIZE, bit, last4,
+                            mode);
+  return read;
+}
+
+size_t bitpacking_pack_delta(const uint32_t *in, size_t n, uint32_t *out,
+                             uint32_t bit, uint32_t initial,
+                             bitpacking_delta mode) {
+  return bitpacking_pack_delta_with(BITPACKING_AUTO, in, n, out, bit, initial,
+                                    mode);
+}
+
+size_t bitpacking_unpack_delta(const uint32_t *in, size_t n, uint32_t *out,
+                               uint32_t bit, uint32_t initial,
+                               bitpacking_delta mode) {
+  return bitpacking_unpack_delta_with(BITPACKING_AUTO, in, n, out, bit,
+                                      initial, mode);
+}
+
+int bitpacking_backend_supported(bitpacking_backend backend) {
+  return find(backend) != nullptr;
+}
+
+bitpacking_backend bitpacking_active_backend(void) {
+  return active()->kind;
+}
+
+const char *bitpacking_backend_name(bitpacking_backend backend) {
+  if (backend == BITPACKING_AUTO) {
+    return active()->name;
+  }
+  return isa::name_of(implementations, backend);
+}
+
+} // extern "C"
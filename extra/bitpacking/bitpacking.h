@@ -0,0 +1,108 @@
+// Bit-packing codec for arrays of 32-bit integers.
+//
+// The kernels are those of 2012/03/06/how-fast-is-bit-packing/bitpacking.cpp
+// (__fastpack1..32 / __fastunpack1..32) and of extra/leonidunpacking.cpp
+// (__SIMD_fastpack1_32, unpackA..unpackE), generalized to every bit width and
+// every register width, behind one API. The best back end (scalar, SSE4.1,
+// AVX2, AVX-512) is picked at runtime with the cpuid code of extra/isa/isa.h.
+//
+// Format. Values are packed by blocks of 512 integers. Within a block, the
+// integers are spread over 16 interleaved lanes: integer i goes to lane
+// i % 16, and lane l packs its 32 integers exactly like __fastpack does,
+// into the words l, l + 16, l + 32... of the block. A block with bit width b
+// thus uses 16 * b words. A SIMD register of 4, 8 or 16 lanes handles 4, 8
+// or 16 lanes at once, so that all back ends read and write the very same
+// format: data packed on an AVX-512 box can be unpacked on any other box.
+// The last n % 512 integers are packed one after the other, in a plain
+// little-endian bit stream.
+//
+// All functions are usable from C and from C++.
+#ifndef BITPACKING_H
+#define BITPACKING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BITPACKING_BLOCK_SIZE 512
+
+typedef enum bitpacking_backend {
+  BITPACKING_AUTO = 0, // best supported back end
+  BITPACKING_SCALAR,
+  BITPACKING_SSE41,
+  BITPACKING_AVX2,
+  BITPACKING_AVX512
+} bitpacking_backend;
+
+// Number of 32-bit words needed to pack n integers with bit width bit.
+size_t bitpacking_packed_words(size_t n, uint32_t bit);
+
+// Smallest bit width that can represent all n values.
+uint32_t bitpacking_max_bits(const uint32_t *in, size_t n);
+
+// Packs the n values of in (only their bit least significant bits are
+// kept) into out, which must have room for bitpacking_packed_words(n, bit)
+// words. Returns the number of words written. bit must be in [0, 32].
+size_t bitpacking_pack(const uint32_t *in, size_t n, uint32_t *out,
+                       uint32_t bit);
+
+// Unpacks n values packed by bitpacking_pack. Returns the number of words
+// consumed.
+size_t bitpacking_unpack(const uint32_t *in, size_t n, uint32_t *out,
+                         uint32_t bit);
+
+// Same as above with an explicit back end. They return (size_t)-1 if the
+// back end is not supported by this processor.
+size_t bitpacking_pack_with(bitpacking_backend backend, const uint32_t *in,
+                            size_t n, uint32_t *out, uint32_t bit);
+size_t bitpacking_unpack_with(bitpacking_backend backend, const uint32_t *in,
+                              size_t n, uint32_t *out, uint32_t bit);
+
+// Differential coding fused with bit packing, for sorted arrays such as
+// posting lists. With BITPACKING_D1 we pack x[i] - x[i - 1], with
+// BITPACKING_D4 we pack x[i] - x[i - 4], which is cheaper to undo with SIMD
+// instructions but gives larger deltas. The values before x[0] are taken to
+// be 'initial'. The arithmetic wraps around, so unsorted input round-trips
+// as well. Unpacking computes the prefix sums in registers: the deltas are
+// never written out.
+typedef enum bitpacking_delta {
+  BITPACKING_D1 = 1,
+  BITPACKING_D4 = 4
+} bitpacking_delta;
+
+// Smallest bit width that can represent all the deltas.
+uint32_t bitpacking_max_bits_delta(const uint32_t *in, size_t n,
+                                   uint32_t initial, bitpacking_delta mode);
+
+// Same conventions as bitpacking_pack and bitpacking_unpack; (size_t)-1 on
+// bad arguments.
+size_t bitpacking_pack_delta(const uint32_t *in, size_t n, uint32_t *out,
+                             uint32_t bit, uint32_t initial,
+                             bitpacking_delta mode);
+size_t bitpacking_unpack_delta(const uint32_t *in, size_t n, uint32_t *out,
+                               uint32_t bit, uint32_t initial,
+                               bitpacking_delta mode);
+size_t bitpacking_pack_delta_with(bitpacking_backend backend,
+                                  const uint32_t *in, size_t n, uint32_t *out,
+                                  uint32_t bit, uint32_t initial,
+                                  bitpacking_delta mode);
+size_t bitpacking_unpack_delta_with(bitpacking_backend backend,
+                                    const uint32_t *in, size_t n,
+                                    uint32_t *out, uint32_t bit,
+                                    uint32_t initial, bitpacking_delta mode);
+
+// Whether the back end can run on this processor.
+int bitpacking_backend_supported(bitpacking_backend backend);
+
+// Back end picked by BITPACKING_AUTO, and its name.
+bitpacking_backend bitpacking_active_backend(void);
+const char *bitpacking_backend_name(bitpacking_backend backend);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // BITPACKING_H
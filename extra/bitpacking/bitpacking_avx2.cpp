@@ -0,0 +1,55 @@
+// AVX2 back end: eight lanes at a time.
+#include "bitpacking_kernels.h"
+
+#include <immintrin.h>
+
+namespace bitpacking {
+namespace {
+
+struct avx2_vector {
+  static const int lanes = 8;
+  typedef __m256i reg;
+  static reg load(const uint32_t *p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  }
+  static void store(uint32_t *p, reg x) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), x);
+  }
+  static reg zero() { return _mm256_setzero_si256(); }
+  static reg set1(uint32_t x) { return _mm256_set1_epi32(int(x)); }
+  static reg srli(reg x, int s) { return _mm256_srli_epi32(x, s); }
+  static reg slli(reg x, int s) { return _mm256_slli_epi32(x, s); }
+  static reg and_(reg x, reg y) { return _mm256_and_si256(x, y); }
+  static reg or_(reg x, reg y) { return _mm256_or_si256(x, y); }
+  static reg sub(reg x, reg y) { return _mm256_sub_epi32(x, y); }
+  static reg from_last4(const uint32_t *p) {
+    return from_last4_generic<avx2_vector>(p);
+  }
+  static void to_last4(reg x, uint32_t *p) {
+    to_last4_generic<avx2_vector>(x, p);
+  }
+  static reg prefix_sum_d1(reg x, reg previous) {
+    // prefix sums within the two 128-bit halves, then carry the low half
+    x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+    x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+    __m256i low_total = _mm256_shuffle_epi32(x, 0xFF);
+    x = _mm256_add_epi32(x, _mm256_permute2x128_si256(low_total, low_total,
+                                                      0x08));
+    return _mm256_add_epi32(
+        x, _mm256_permutevar8x32_epi32(previous, _mm256_set1_epi32(7)));
+  }
+  static reg prefix_sum_d4(reg x, reg previous) {
+    x = _mm256_add_epi32(x, _mm256_permute2x128_si256(x, x, 0x08));
+    return _mm256_add_epi32(
+        x, _mm256_permute2x128_si256(previous, previous, 0x11));
+  }
+};
+
+} // namespace
+
+const block_table &avx2_table() {
+  static const block_table table = make_table<avx2_vector>();
+  return table;
+}
+
+} // namespace bitpacking
@@ -0,0 +1,59 @@
+// AVX-512 back end: the sixteen lanes of a block in one register.
+#include "bitpacking_kernels.h"
+
+// GCC 12 warns about _mm512_undefined_epi32 inside its own shift intrinsics.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+
+namespace bitpacking {
+namespace {
+
+struct avx512_vector {
+  static const int lanes = 16;
+  typedef __m512i reg;
+  static reg load(const uint32_t *p) { return _mm512_loadu_si512(p); }
+  static void store(uint32_t *p, reg x) { _mm512_storeu_si512(p, x); }
+  static reg zero() { return _mm512_setzero_si512(); }
+  static reg set1(uint32_t x) { return _mm512_set1_epi32(int(x)); }
+  static reg srli(reg x, int s) { return _mm512_srli_epi32(x, s); }
+  static reg slli(reg x, int s) { return _mm512_slli_epi32(x, s); }
+  static reg and_(reg x, reg y) { return _mm512_and_si512(x, y); }
+  static reg or_(reg x, reg y) { return _mm512_or_si512(x, y); }
+  static reg sub(reg x, reg y) { return _mm512_sub_epi32(x, y); }
+  static reg from_last4(const uint32_t *p) {
+    return from_last4_generic<avx512_vector>(p);
+  }
+  static void to_last4(reg x, uint32_t *p) {
+    to_last4_generic<avx512_vector>(x, p);
+  }
+  // shifts the lanes up by S, filling with zeros
+  template <int S> static reg shift_lanes(reg x) {
+    return _mm512_alignr_epi32(x, _mm512_setzero_si512(), 16 - S);
+  }
+  static reg prefix_sum_d1(reg x, reg previous) {
+    x = _mm512_add_epi32(x, shift_lanes<1>(x));
+    x = _mm512_add_epi32(x, shift_lanes<2>(x));
+    x = _mm512_add_epi32(x, shift_lanes<4>(x));
+    x = _mm512_add_epi32(x, shift_lanes<8>(x));
+    return _mm512_add_epi32(
+        x, _mm512_permutexvar_epi32(_mm512_set1_epi32(15), previous));
+  }
+  static reg prefix_sum_d4(reg x, reg previous) {
+    x = _mm512_add_epi32(x, shift_lanes<4>(x));
+    x = _mm512_add_epi32(x, shift_lanes<8>(x));
+    return _mm512_add_epi32(x,
+                            _mm512_shuffle_i32x4(previous, previous, 0xFF));
+  }
+};
+
+} // namespace
+
+const block_table &avx512_table() {
+  static const block_table table = make_table<avx512_vector>();
+  return table;
+}
+
+} // namespace bitpacking
@@ -0,0 +1,387 @@
+// Block kernels shared by all back ends. Only the bitpacking_*.cpp files
+// include this header: each one instantiates the templates with its own
+// register type and is compiled with its own -m flags.
+//
+// A register type V provides
+//
+//   static const int lanes;           // 1, 4, 8 or 16
+//   typedef ... reg;
+//   static reg load(const uint32_t *); // lanes consecutive words
+//   static void store(uint32_t *, reg);
+//   static reg zero();
+//   static reg set1(uint32_t);
+//   static reg srli(reg, int), slli(reg, int);
+//   static reg and_(reg, reg), or_(reg, reg);
+//   static reg sub(reg, reg);
+//
+// and, for the delta kernels (not needed when lanes == 1),
+//
+//   static reg from_last4(const uint32_t *), to_last4(reg, uint32_t *);
+//   static reg prefix_sum_d1(reg delta, reg previous);
+//   static reg prefix_sum_d4(reg delta, reg previous);
+//
+// where the prefix sums add the deltas to the last one (D1) or four (D4)
+// values of the previous output vector.
+//
+// The kernels are __fastpack / __fastunpack from
+// 2012/03/06/how-fast-is-bit-packing/bitpacking.cpp, written once for all
+// bit widths: with the loops fully unrolled, the shift amounts are compile
+// time constants, as in the generated code. In extra/leonidunpacking.cpp,
+// unpackA..unpackE only differ in how the loads and stores are scheduled,
+// so we keep the straight form of unpackA and let the compiler schedule.
+#ifndef BITPACKING_KERNELS_H
+#define BITPACKING_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "bitpacking.h"
+
+namespace bitpacking {
+
+constexpr int block_lanes = 16;
+constexpr int lane_size = BITPACKING_BLOCK_SIZE / block_lanes; // 32
+
+typedef void (*block_function)(const uint32_t *__restrict__ in,
+                               uint32_t *__restrict__ out);
+
+// Whole-array delta kernels: 'blocks' blocks, last4 holds the four values
+// preceding the first one and is updated with the last four values.
+typedef size_t (*delta_function)(const uint32_t *__restrict__ in,
+                                 size_t blocks, uint32_t *__restrict__ out,
+                                 uint32_t *last4);
+
+// Where the packing kernel reads its 32 x lanes values from.
+template <class V> struct plain_source {
+  typename V::reg operator()(const uint32_t *p) const { return V::load(p); }
+};
+
+// Differential coding on the fly: we pack x[i] - x[i - K] without ever
+// writing the deltas (as deltaSIMD does in extra/unrolldeltasSIMD.cpp).
+template <class V, int K> struct delta_source {
+  typename V::reg operator()(const uint32_t *p) const {
+    return V::sub(V::load(p), V::load(p - K));
+  }
+};
+
+template <class V, uint32_t B, class Source>
+static inline void pack_block_from(const uint32_t *__restrict__ in,
+                                   uint32_t *__restrict__ out,
+                                   const Source &source) {
+  typedef typename V::reg reg;
+  for (int g = 0; g < block_lanes; g += V::lanes) {
+    const uint32_t *lin = in + g;
+    uint32_t *lout = out + g;
+    const reg mask = V::set1(B == 32 ? 0xFFFFFFFF : (1U << B) - 1);
+    reg acc = V::zero();
+    uint32_t shift = 0;
+#pragma GCC unroll 32
+    for (int i = 0; i < lane_size; i++) {
+      reg v = source(lin + block_lanes * i);
+      if (B < 32) {
+        v = V::and_(v, mask);
+      }
+      acc = (shift == 0) ? v : V::or_(acc, V::slli(v, shift));
+      shift += B;
+      if (shift >= 32) {
+        V::store(lout, acc);
+        lout += block_lanes;
+        shift -= 32;
+        acc = (shift == 0) ? V::zero() : V::srli(v, B - shift);
+      }
+    }
+  }
+}
+
+template <class V, uint32_t B>
+static inline void pack_block(const uint32_t *__restrict__ in,
+                              uint32_t *__restrict__ out) {
+  pack_block_from<V, B>(in, out, plain_source<V>());
+}
+
+// Where the unpacking kernel sends its values: the sink gets the values of
+// the block in order, V::lanes at a time.
+template <class V> struct store_sink {
+  uint32_t *out;
+  void operator()(typename V::reg v) {
+    V::store(out, v);
+    out += V::lanes;
+  }
+};
+
+// Inverse differential coding, in registers: the sink keeps the last output
+// vector and only ever stores final values (inverseDeltaSIMD and
+// inverseDelta in extra/unrolldeltasSIMD.cpp make a second pass instead).
+template <class V, int K, int lanes = V::lanes> struct prefix_sum_sink {
+  typedef typename V::reg reg;
+  uint32_t *out;
+  reg previous;
+  prefix_sum_sink(uint32_t *o, const uint32_t *last4)
+      : out(o), previous(V::from_last4(last4)) {}
+  void operator()(reg v) {
+    previous = (K == 1) ? V::prefix_sum_d1(v, previous)
+                        : V::prefix_sum_d4(v, previous);
+    V::store(out, previous);
+    out += V::lanes;
+  }
+  void save(uint32_t *last4) const { V::to_last4(previous, last4); }
+};
+
+// Scalar version: one value at a time, with the last four values at hand.
+template <class V, int K> struct prefix_sum_sink<V, K, 1> {
+  uint32_t *out;
+  uint32_t history[4];
+  prefix_sum_sink(uint32_t *o, const uint32_t *last4) : out(o) {
+    for (int i = 0; i < 4; i++) {
+      history[i] = last4[i];
+    }
+  }
+  void operator()(uint32_t v) {
+    uint32_t x = v + history[4 - K];
+    history[0] = history[1];
+    history[1] = history[2];
+    history[2] = history[3];
+    history[3] = x;
+    *out++ = x;
+  }
+  void save(uint32_t *last4) const {
+    for (int i = 0; i < 4; i++) {
+      last4[i] = history[i];
+    }
+  }
+};
+
+// Plain unpacking: one group of lanes after the other.
+template <class V, uint32_t B>
+static inline void unpack_block(const uint32_t *__restrict__ in,
+                                uint32_t *__restrict__ out) {
+  typedef typename V::reg reg;
+  if (B == 0) {
+    for (int i = 0; i < BITPACKING_BLOCK_SIZE; i += V::lanes) {
+      V::store(out + i, V::zero());
+    }
+    return;
+  }
+  for (int g = 0; g < block_lanes; g += V::lanes) {
+    const uint32_t *lin = in + g;
+    uint32_t *lout = out + g;
+    const reg mask = V::set1(B == 32 ? 0xFFFFFFFF : (1U << B) - 1);
+    reg w = V::load(lin);
+    lin += block_lanes;
+    uint32_t shift = 0;
+#pragma GCC unroll 32
+    for (int i = 0; i < lane_size; i++) {
+      reg v;
+      if (shift + B < 32) {
+        v = V::and_(V::srli(w, shift), mask);
+        shift += B;
+      } else if (shift + B == 32) {
+        v = V::srli(w, shift);
+        shift = 0;
+        if (i + 1 < lane_size) {
+          w = V::load(lin);
+          lin += block_lanes;
+        }
+      } else {
+        reg next = V::load(lin);
+        lin += block_lanes;
+        v = V::and_(V::or_(V::srli(w, shift), V::slli(next, 32 - shift)),
+                    mask);
+        w = next;
+        shift = shift + B - 32;
+      }
+      V::store(lout + block_lanes * i, v);
+    }
+  }
+}
+
+// With one lane at a time, interleaving the sixteen lanes would make for
+// huge functions: we unpack to a buffer that stays in L1 and read it back.
+template <class V, uint32_t B, class Sink>
+static inline void unpack_block_rows(const uint32_t *__restrict__ in,
+                                     Sink &sink, std::true_type) {
+  uint32_t buffer[BITPACKING_BLOCK_SIZE];
+  unpack_block<V, B>(in, buffer);
+  for (int i = 0; i < BITPACKING_BLOCK_SIZE; i++) {
+    sink(buffer[i]);
+  }
+}
+
+// The lanes are processed side by side (all the groups of row i, then row
+// i + 1...) so that the sink sees the values of the block in order.
+template <class V, uint32_t B, class Sink>
+static inline void unpack_block_rows(const uint32_t *__restrict__ in,
+                                     Sink &sink, std::false_type) {
+  typedef typename V::reg reg;
+  constexpr int groups = block_lanes / V::lanes;
+  if (B == 0) {
+    for (int i = 0; i < BITPACKING_BLOCK_SIZE; i += V::lanes) {
+      sink(V::zero());
+    }
+    return;
+  }
+  const reg mask = V::set1(B == 32 ? 0xFFFFFFFF : (1U << B) - 1);
+  reg w[groups];
+#pragma GCC unroll 16
+  for (int g = 0; g < groups; g++) {
+    w[g] = V::load(in + g * V::lanes);
+  }
+  const uint32_t *lin = in + block_lanes;
+  uint32_t shift = 0;
+#pragma GCC unroll 32
+  for (int i = 0; i < lane_size; i++) {
+    if (shift + B < 32) {
+#pragma GCC unroll 16
+      for (int g = 0; g < groups; g++) {
+        sink(V::and_(V::srli(w[g], shift), mask));
+      }
+      shift += B;
+    } else if (shift + B == 32) {
+#pragma GCC unroll 16
+      for (int g = 0; g < groups; g++) {
+        sink(V::srli(w[g], shift));
+      }
+      shift = 0;
+      if (i + 1 < lane_size) {
+#pragma GCC unroll 16
+        for (int g = 0; g < groups; g++) {
+          w[g] = V::load(lin + g * V::lanes);
+        }
+        lin += block_lanes;
+      }
+    } else {
+#pragma GCC unroll 16
+      for (int g = 0; g < groups; g++) {
+        reg next = V::load(lin + g * V::lanes);
+        sink(V::and_(V::or_(V::srli(w[g], shift), V::slli(next, 32 - shift)),
+                     mask));
+        w[g] = next;
+      }
+      lin += block_lanes;
+      shift = shift + B - 32;
+    }
+  }
+}
+
+// Unpacks a block and hands the values to the sink in order.
+template <class V, uint32_t B, class Sink>
+static inline void unpack_block_to(const uint32_t *__restrict__ in,
+                                   Sink &sink) {
+  unpack_block_rows<V, B>(in, sink,
+                          std::integral_constant<bool, V::lanes == 1>());
+}
+
+template <class V, uint32_t B, int K>
+static size_t pack_delta_blocks(const uint32_t *__restrict__ in,
+                                size_t blocks, uint32_t *__restrict__ out,
+                                uint32_t *last4) {
+  if (blocks == 0) {
+    return 0;
+  }
+  // The first block needs the values preceding the array: we go through a
+  // small buffer.
+  uint32_t first[BITPACKING_BLOCK_SIZE + 4];
+  for (int i = 0; i < 4; i++) {
+    first[i] = last4[i];
+  }
+  for (int i = 0; i < BITPACKING_BLOCK_SIZE; i++) {
+    first[i + 4] = in[i];
+  }
+  pack_block_from<V, B>(first + 4, out, delta_source<V, K>());
+  for (size_t k = 1; k < blocks; k++) {
+    pack_block_from<V, B>(in + k * BITPACKING_BLOCK_SIZE,
+                          out + k * block_lanes * B, delta_source<V, K>());
+  }
+  for (int i = 0; i < 4; i++) {
+    last4[i] = in[blocks * BITPACKING_BLOCK_SIZE - 4 + i];
+  }
+  return blocks * block_lanes * B;
+}
+
+template <class V, uint32_t B, int K>
+static size_t unpack_delta_blocks(const uint32_t *__restrict__ in,
+                                  size_t blocks, uint32_t *__restrict__ out,
+                                  uint32_t *last4) {
+  prefix_sum_sink<V, K> sink(out, last4);
+  for (size_t k = 0; k < blocks; k++) {
+    unpack_block_to<V, B>(in + k * block_lanes * B, sink);
+  }
+  sink.save(last4);
+  return blocks * block_lanes * B;
+}
+
+// One entry per bit width, 0 to 32.
+struct block_table {
+  block_function pack[33];
+  block_function unpack[33];
+  delta_function pack_d1[33];
+  delta_function pack_d4[33];
+  delta_function unpack_d1[33];
+  delta_function unpack_d4[33];
+};
+
+template <class V, size_t... B>
+static block_table make_table(std::index_sequence<B...>) {
+  return block_table{{pack_block<V, B>...},
+                     {unpack_block<V, B>...},
+                     {pack_delta_blocks<V, B, 1>...},
+                     {pack_delta_blocks<V, B, 4>...},
+                     {unpack_delta_blocks<V, B, 1>...},
+                     {unpack_delta_blocks<V, B, 4>...}};
+}
+
+template <class V> static block_table make_table() {
+  return make_table<V>(std::make_index_sequence<33>());
+}
+
+// Helpers for the register types with at least four lanes: the last four
+// values live in the top four lanes.
+template <class V>
+static inline typename V::reg from_last4_generic(const uint32_t *last4) {
+  uint32_t buffer[V::lanes] = {};
+  for (int i = 0; i < 4; i++) {
+    buffer[V::lanes - 4 + i] = last4[i];
+  }
+  return V::load(buffer);
+}
+
+template <class V>
+static inline void to_last4_generic(typename V::reg x, uint32_t *last4) {
+  uint32_t buffer[V::lanes];
+  V::store(buffer, x);
+  for (int i = 0; i < 4; i++) {
+    last4[i] = buffer[V::lanes - 4 + i];
+  }
+}
+
+// The kernels of each back end, see bitpacking_*.cpp.
+const block_table &scalar_table();
+const block_table &sse41_table();
+const block_table &avx2_table();
+const block_table &avx512_table();
+
+// Loops over whole blocks; returns the number of words written or read.
+static inline size_t pack_blocks(const block_table &t, const uint32_t *in,
+                                 size_t blocks, uint32_t *out, uint32_t bit) {
+  block_function f = t.pack[bit];
+  for (size_t k = 0; k < blocks; k++) {
+    f(in + k * BITPACKING_BLOCK_SIZE, out + k * block_lanes * bit);
+  }
+  return blocks * block_lanes * bit;
+}
+
+static inline size_t unpack_blocks(const block_table &t, const uint32_t *in,
+                                   size_t blocks, uint32_t *out,
+                                   uint32_t bit) {
+  block_function f = t.unpack[bit];
+  for (size_t k = 0; k < blocks; k++) {
+    f(in + k * block_lanes * bit, out + k * BITPACKING_BLOCK_SIZE);
+  }
+  return blocks * block_lanes * bit;
+}
+
+} // namespace bitpacking
+
+#endif // BITPACKING_KERNELS_H
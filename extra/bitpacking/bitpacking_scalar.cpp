@@ -0,0 +1,28 @@
+// Scalar back end: one lane at a time, as in __fastpack / __fastunpack.
+#include "bitpacking_kernels.h"
+
+namespace bitpacking {
+namespace {
+
+struct scalar_vector {
+  static const int lanes = 1;
+  typedef uint32_t reg;
+  static reg load(const uint32_t *p) { return *p; }
+  static void store(uint32_t *p, reg x) { *p = x; }
+  static reg zero() { return 0; }
+  static reg set1(uint32_t x) { return x; }
+  static reg srli(reg x, int s) { return x >> s; }
+  static reg slli(reg x, int s) { return x << s; }
+  static reg and_(reg x, reg y) { return x & y; }
+  static reg or_(reg x, reg y) { return x | y; }
+  static reg sub(reg x, reg y) { return x - y; }
+};
+
+} // namespace
+
+const block_table &scalar_table() {
+  static const block_table table = make_table<scalar_vector>();
+  return table;
+}
+
+} // namespace bitpacking
@@ -0,0 +1,47 @@
+// SSE back end: four lanes at a time, as in __SIMD_fastpack1_32 and unpackA
+// from extra/leonidunpacking.cpp. Compiled with -msse4.1, though the kernels
+// only need SSE2.
+#include "bitpacking_kernels.h"
+
+#include <immintrin.h>
+
+namespace bitpacking {
+namespace {
+
+struct sse_vector {
+  static const int lanes = 4;
+  typedef __m128i reg;
+  static reg load(const uint32_t *p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+  }
+  static void store(uint32_t *p, reg x) {
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p), x);
+  }
+  static reg zero() { return _mm_setzero_si128(); }
+  static reg set1(uint32_t x) { return _mm_set1_epi32(int(x)); }
+  static reg srli(reg x, int s) { return _mm_srli_epi32(x, s); }
+  static reg slli(reg x, int s) { return _mm_slli_epi32(x, s); }
+  static reg and_(reg x, reg y) { return _mm_and_si128(x, y); }
+  static reg or_(reg x, reg y) { return _mm_or_si128(x, y); }
+  static reg sub(reg x, reg y) { return _mm_sub_epi32(x, y); }
+  static reg from_last4(const uint32_t *p) { return load(p); }
+  static void to_last4(reg x, uint32_t *p) { store(p, x); }
+  static reg prefix_sum_d1(reg x, reg previous) {
+    x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+    x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+    return _mm_add_epi32(x, _mm_shuffle_epi32(previous, 0xFF));
+  }
+  // as in inverseDeltaSIMD
+  static reg prefix_sum_d4(reg x, reg previous) {
+    return _mm_add_epi32(x, previous);
+  }
+};
+
+} // namespace
+
+const block_table &sse41_table() {
+  static const block_table table = make_table<sse_vector>();
+  return table;
+}
+
+} // namespace bitpacking
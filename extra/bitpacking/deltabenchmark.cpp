@@ -0,0 +1,86 @@
+// Decoding sorted arrays: fused unpack + prefix sum versus unpacking the
+// deltas and then undoing them in a second pass, as in
+// extra/unrolldeltasSIMD.cpp. Reports ns per integer.
+#include "bitpacking.h"
+
+#include "../harness/harness.h"
+
+#include <immintrin.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// second pass, D1
+static void inverse_delta(uint32_t *data, size_t n, uint32_t initial) {
+  uint32_t previous = initial;
+  for (size_t i = 0; i < n; i++) {
+    previous = data[i] += previous;
+  }
+}
+
+// second pass, D4: inverseDeltaSIMD from extra/unrolldeltasSIMD.cpp
+static void inverse_delta_simd(uint32_t *data, size_t n, uint32_t initial) {
+  __m128i a = _mm_set1_epi32(int(initial));
+  size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    __m128i *p = reinterpret_cast<__m128i *>(data + i);
+    a = _mm_add_epi32(a, _mm_loadu_si128(p));
+    _mm_storeu_si128(p, a);
+  }
+  for (; i < n; i++) {
+    data[i] += i >= 4 ? data[i - 4] : initial;
+  }
+}
+
+int main(int argc, char **argv) {
+  size_t N = argc > 1 ? size_t(atoll(argv[1])) : 1U << 16;
+  std::mt19937 gen(1234);
+  std::vector<uint32_t> packed(bitpacking_packed_words(N, 32));
+  std::vector<uint32_t> recovered(N);
+  harness::options opts = harness::default_options();
+  printf("N = %zu, active back end: %s\n", N,
+         bitpacking_backend_name(bitpacking_active_backend()));
+  printf("gap bits\tmode\tbits\tfused (ns/int)\ttwo passes (ns/int)\n");
+  for (uint32_t gapbits : {2, 4, 8, 12, 16, 20}) {
+    std::vector<uint32_t> data(N);
+    uint32_t value = 0;
+    for (auto &x : data) {
+      value += uint32_t(gen()) & ((1U << gapbits) - 1);
+      x = value;
+    }
+    for (bitpacking_delta mode : {BITPACKING_D1, BITPACKING_D4}) {
+      uint32_t bit = bitpacking_max_bits_delta(data.data(), N, 0, mode);
+      bitpacking_pack_delta(data.data(), N, packed.data(), bit, 0, mode);
+      auto fused = harness::run("fused", N, [&] {
+        bitpacking_unpack_delta(packed.data(), N, recovered.data(), bit, 0,
+                                mode);
+      }, opts);
+      if (recovered != data) {
+        printf("bug!\n");
+        return EXIT_FAILURE;
+      }
+      auto twopasses = harness::run("two passes", N, [&] {
+        bitpacking_unpack(packed.data(), N, recovered.data(), bit);
+        if (mode == BITPACKING_D1) {
+          inverse_delta(recovered.data(), N, 0);
+        } else {
+          inverse_delta_simd(recovered.data(), N, 0);
+        }
+      }, opts);
+      if (recovered != data) {
+        printf("bug!\n");
+        return EXIT_FAILURE;
+      }
+      if (opts.format == HARNESS_TEXT) {
+        printf("%u\t\tD%d\t%u\t%.3f\t\t%.3f\n", gapbits, int(mode), bit,
+               fused.min() / N, twopasses.min() / N);
+      } else {
+        fused.report();
+        twopasses.report();
+      }
+    }
+  }
+  return EXIT_SUCCESS;
+}
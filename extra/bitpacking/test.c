@@ -0,0 +1,148 @@
+// Round-trip checks of the bit-packing codec, through the C interface,
+// for all bit widths, all back ends and lengths that are not multiples of
+// the block size.
+#include "bitpacking.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const bitpacking_backend backends[] = {
+    BITPACKING_SCALAR, BITPACKING_SSE41, BITPACKING_AVX2, BITPACKING_AVX512};
+
+static int check(size_t n, uint32_t bit) {
+  uint32_t mask = bit == 32 ? 0xFFFFFFFF : (1U << bit) - 1;
+  uint32_t *data = (uint32_t *)malloc((n + 1) * sizeof(uint32_t));
+  uint32_t *reference = (uint32_t *)malloc((n + 1) * 4 * sizeof(uint32_t));
+  uint32_t *packed = (uint32_t *)malloc((n + 1) * 4 * sizeof(uint32_t));
+  uint32_t *recovered = (uint32_t *)malloc((n + 1) * sizeof(uint32_t));
+  size_t words = bitpacking_packed_words(n, bit), i, b;
+  int ok = 1;
+  for (i = 0; i < n; i++) {
+    data[i] = (uint32_t)rand() ^ ((uint32_t)rand() << 16);
+  }
+  // the scalar code is the reference for the format
+  memset(reference, 0, (n + 1) * 4 * sizeof(uint32_t));
+  if (bitpacking_pack_with(BITPACKING_SCALAR, data, n, reference, bit) !=
+      words) {
+    printf("bad packed size n = %zu bit = %u\n", n, bit);
+    ok = 0;
+  }
+  for (b = 0; ok && b < sizeof(backends) / sizeof(backends[0]); b++) {
+    if (!bitpacking_backend_supported(backends[b])) {
+      continue;
+    }
+    memset(packed, 0, (n + 1) * 4 * sizeof(uint32_t));
+    bitpacking_pack_with(backends[b], data, n, packed, bit);
+    if (memcmp(packed, reference, (words + 1) * sizeof(uint32_t)) != 0) {
+      printf("%s: packed data differs, n = %zu bit = %u\n",
+             bitpacking_backend_name(backends[b]), n, bit);
+      ok = 0;
+      break;
+    }
+    recovered[n] = 0xdeadbeef;
+    if (bitpacking_unpack_with(backends[b], packed, n, recovered, bit) !=
+        words) {
+      printf("%s: bad unpacked size n = %zu bit = %u\n",
+             bitpacking_backend_name(backends[b]), n, bit);
+      ok = 0;
+      break;
+    }
+    for (i = 0; i < n; i++) {
+      if (recovered[i] != (data[i] & mask)) {
+        printf("%s: mismatch at %zu, n = %zu bit = %u\n",
+               bitpacking_backend_name(backends[b]), i, n, bit);
+        ok = 0;
+        break;
+      }
+    }
+    if (recovered[n] != 0xdeadbeef) {
+      printf("%s: overflow n = %zu bit = %u\n",
+             bitpacking_backend_name(backends[b]), n, bit);
+      ok = 0;
+    }
+  }
+  free(data);
+  free(reference);
+  free(packed);
+  free(recovered);
+  return ok;
+}
+
+// Sorted arrays with gaps below 2^(bit - 2), so that the D4 deltas fit.
+static int check_delta(size_t n, uint32_t bit, bitpacking_delta mode) {
+  uint32_t *data = (uint32_t *)malloc((n + 1) * sizeof(uint32_t));
+  uint32_t *reference = (uint32_t *)malloc((n + 1) * 4 * sizeof(uint32_t));
+  uint32_t *packed = (uint32_t *)malloc((n + 1) * 4 * sizeof(uint32_t));
+  uint32_t *recovered = (uint32_t *)malloc((n + 1) * sizeof(uint32_t));
+  uint32_t initial = 100, gap = bit < 3 ? 0 : (1U << (bit - 2)) - 1;
+  size_t words = bitpacking_packed_words(n, bit), i, b;
+  int ok = 1;
+  for (i = 0; i < n; i++) {
+    data[i] = (i == 0 ? initial : data[i - 1]) +
+              (gap == 0 ? 0 : (uint32_t)rand() % (gap + 1));
+  }
+  if (bitpacking_max_bits_delta(data, n, initial, mode) > bit) {
+    printf("bad test n = %zu bit = %u\n", n, bit);
+    return 0;
+  }
+  memset(reference, 0, (n + 1) * 4 * sizeof(uint32_t));
+  if (bitpacking_pack_delta_with(BITPACKING_SCALAR, data, n, reference, bit,
+                                 initial, mode) != words) {
+    printf("bad packed size n = %zu bit = %u\n", n, bit);
+    ok = 0;
+  }
+  for (b = 0; ok && b < sizeof(backends) / sizeof(backends[0]); b++) {
+    if (!bitpacking_backend_supported(backends[b])) {
+      continue;
+    }
+    memset(packed, 0, (n + 1) * 4 * sizeof(uint32_t));
+    bitpacking_pack_delta_with(backends[b], data, n, packed, bit, initial,
+                               mode);
+    if (memcmp(packed, reference, (words + 1) * sizeof(uint32_t)) != 0) {
+      printf("%s: D%d packed data differs, n = %zu bit = %u\n",
+             bitpacking_backend_name(backends[b]), (int)mode, n, bit);
+      ok = 0;
+      break;
+    }
+    if (bitpacking_unpack_delta_with(backends[b], packed, n, recovered, bit,
+                                     initial, mode) != words) {
+      printf("%s: bad unpacked size n = %zu bit = %u\n",
+             bitpacking_backend_name(backends[b]), n, bit);
+      ok = 0;
+      break;
+    }
+    for (i = 0; i < n; i++) {
+      if (recovered[i] != data[i]) {
+        printf("%s: D%d mismatch at %zu, n = %zu bit = %u\n",
+               bitpacking_backend_name(backends[b]), (int)mode, i, n, bit);
+        ok = 0;
+        break;
+      }
+    }
+  }
+  free(data);
+  free(reference);
+  free(packed);
+  free(recovered);
+  return ok;
+}
+
+int main(void) {
+  static const size_t lengths[] = {0, 1, 31, 32, 511, 512, 513, 1024, 5000};
+  uint32_t bit;
+  size_t l;
+  printf("active back end: %s\n",
+         bitpacking_backend_name(bitpacking_active_backend()));
+  for (bit = 0; bit <= 32; bit++) {
+    for (l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++) {
+      if (!check(lengths[l], bit) ||
+          !check_delta(lengths[l], bit, BITPACKING_D1) ||
+          !check_delta(lengths[l], bit, BITPACKING_D4)) {
+        return EXIT_FAILURE;
+      }
+    }
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,166 @@
+// Speed in GB/s of input over n bytes (256 KiB by default) of text: the
+// removal of white space as 2017/07/10/despacebenchmark.c measures it
+// (1% each of ' ', '\n' and '\r'), the removal of control characters and
+// the replacement of delimiters in log lines, the digits kept, and the
+// lines counted, with each back end. despace is the scalar loop of
+// 2017/07/10/despacer.h, out of place (the header also holds the NEON
+// code, so we cannot include it here).
+#include "bytefilter.h"
+
+#include "../harness/harness.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+namespace {
+
+size_t despace(const char *bytes, size_t howmany, char *out) {
+  size_t i = 0, pos = 0;
+  while (i < howmany) {
+    const char c = bytes[i++];
+    out[pos] = c;
+    pos += (c > 32 ? 1 : 0);
+  }
+  return pos;
+}
+
+std::string despace_text(size_t n, std::mt19937_64 &gen) {
+  std::string text(n, '\0');
+  for (char &c : text) {
+    const int r = int(gen() % 100);
+    c = r == 0 ? ' ' : r == 1 ? '\n' : r == 2 ? '\r' : char(33 + gen() % 94);
+  }
+  return text;
+}
+
+// lines of fields separated by ';', '|' or tabs, with a control character
+// in about one line in four
+std::string log_text(size_t n, std::mt19937_64 &gen) {
+  const char delimiters[] = ";|\t";
+  std::string text;
+  while (text.size() < n) {
+    for (int field = 0; field < 6; field++) {
+      const int length = 3 + int(gen() % 12);
+      for (int k = 0; k < length; k++) {
+        text += char(gen() % 3 == 0 ? '0' + gen() % 10 : 'a' + gen() % 26);
+      }
+      text += delimiters[gen() % 3];
+    }
+    if (gen() % 4 == 0) {
+      text += char(1 + gen() % 8);
+    }
+    text += '\n';
+  }
+  text.resize(n);
+  return text;
+}
+
+template <class F>
+bool time(const char *task, const char *name, const std::string &text,
+          size_t expected, F f, harness::options &opts) {
+  size_t size = 0;
+  auto r = harness::run(name, text.size(), [&] {
+    size = f();
+    harness::do_not_optimize(size);
+  }, opts);
+  if (opts.format == HARNESS_TEXT) {
+    printf("%-10s\t%-8s\t%.2f\n", task, name, text.size() / r.min());
+  } else {
+    r.report();
+  }
+  return size == expected;
+}
+
+// F(in, n, out, options) for each back end
+template <class F>
+bool run(const char *task, const std::string &text, size_t expected, F f,
+         harness::options &opts) {
+  const bytefilter::backend backends[] = {
+      bytefilter::backend::scalar, bytefilter::backend::sse,
+      bytefilter::backend::avx2, bytefilter::backend::avx512};
+  std::string out(text.size(), '\0');
+  bool ok = true;
+  for (bytefilter::backend b : backends) {
+    if (!bytefilter::backend_supported(b)) {
+      continue;
+    }
+    bytefilter::options o;
+    o.kernel = b;
+    ok &= time(task, bytefilter::backend_name(b), text, expected, [&] {
+      return f(text.data(), text.size(), &out[0], o);
+    }, opts);
+  }
+  return ok;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const size_t n = argc > 1 ? size_t(atoll(argv[1])) : 256 << 10;
+  std::mt19937_64 gen(1234);
+  harness::options opts = harness::default_options();
+  opts.repeat = 50;
+  printf("n = %zu, best back end: %s\n", n,
+         bytefilter::backend_name(bytefilter::active_backend()));
+  printf("task      \tback end\tGB/s\n");
+
+  const std::string spaced = despace_text(n, gen);
+  std::string out(n, '\0');
+  const size_t despaced = despace(spaced.data(), n, &out[0]);
+  bool ok = time("despace", "memcpy", spaced, n, [&] {
+    memcpy(&out[0], spaced.data(), n);
+    return n;
+  }, opts);
+  ok &= time("despace", "despace", spaced, despaced, [&] {
+    return despace(spaced.data(), n, &out[0]);
+  }, opts);
+  const bytefilter::byteset white = bytefilter::byteset::range(0, 32);
+  ok &= run("despace", spaced, despaced,
+            [&](const char *in, size_t size, char *to,
+                const bytefilter::options &o) {
+              return bytefilter::remove(in, size, to, white, o);
+            },
+            opts);
+
+  const std::string log = log_text(n, gen);
+  const bytefilter::byteset control =
+      bytefilter::byteset::range(0, 9) | bytefilter::byteset::range(11, 31) |
+      bytefilter::byteset::of("\x7f");
+  const bytefilter::byteset delimiters = bytefilter::byteset::of(";|\t");
+  const bytefilter::byteset digits = bytefilter::byteset::range('0', '9');
+  const bytefilter::byteset newline = bytefilter::byteset::of("\n");
+  ok &= run("control", log, n - bytefilter::count(log.data(), n, control),
+            [&](const char *in, size_t size, char *to,
+                const bytefilter::options &o) {
+              return bytefilter::remove(in, size, to, control, o);
+            },
+            opts);
+  ok &= run("delimiters", log, n,
+            [&](const char *in, size_t size, char *to,
+                const bytefilter::options &o) {
+              bytefilter::replace(in, size, to, delimiters, ',', o);
+              return size;
+            },
+            opts);
+  ok &= run("digits", log, bytefilter::count(log.data(), n, digits),
+            [&](const char *in, size_t size, char *to,
+                const bytefilter::options &o) {
+              return bytefilter::keep(in, size, to, digits, o);
+            },
+            opts);
+  ok &= run("lines", log, size_t(std::count(log.begin(), log.end(), '\n')),
+            [&](const char *in, size_t size, char *,
+                const bytefilter::options &o) {
+              return bytefilter::count(in, size, newline, o);
+            },
+            opts);
+  if (!ok) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,138 @@
+// Runtime dispatch, the tables of a set and the scalar back end.
+#include "bytefilter.h"
+#include "bytefilter_kernels.h"
+
+#include "../isa/dispatch.h"
+
+namespace bytefilter {
+
+classifier::classifier(const byteset &s) : low_rows(), high_rows() {
+  for (int b = 0; b < 256; b++) {
+    const bool in = s.contains(uint8_t(b));
+    member[b] = in ? 0xFF : 0;
+    if (in && b < 128) {
+      low_rows[b & 15] |= uint8_t(1 << (b >> 4));
+    } else if (in) {
+      high_rows[b & 15] |= uint8_t(1 << ((b >> 4) - 8));
+    }
+  }
+}
+
+namespace {
+
+struct implementation {
+  backend kind;
+  const char *name;
+  uint32_t required_instruction_sets;
+  const functions &(*table)();
+};
+
+const implementation scalar = {backend::scalar, "scalar", 0,
+                               scalar_functions};
+const implementation sse = {backend::sse, "sse", instruction_set::SSE42,
+                            sse_functions};
+const implementation avx2 = {backend::avx2, "avx2", instruction_set::AVX2,
+                             avx2_functions};
+const implementation avx512 = {
+    backend::avx512, "avx512",
+    instruction_set::AVX512F | instruction_set::AVX512BW |
+        instruction_set::AVX512VBMI | instruction_set::AVX512VBMI2,
+    avx512_functions};
+
+const implementation *const implementations[] = {&avx512, &avx2, &sse,
+                                                 &scalar};
+
+const implementation *best() {
+  static const implementation *best =
+      isa::first_supported(implementations, &scalar);
+  return best;
+}
+
+// nullptr if unknown or unsupported
+const implementation *find(backend kind) {
+  if (kind == backend::automatic) {
+    return best();
+  }
+  return isa::find(implementations, kind);
+}
+
+size_t scalar_remove(const uint8_t *in, size_t n, uint8_t *out,
+                     const classifier &c) {
+  return remove_bytes(in, 0, n, out, 0, c.member);
+}
+
+void scalar_replace(const uint8_t *in, size_t n, uint8_t *out,
+                    const classifier &c, uint8_t with) {
+  replace_bytes(in, 0, n, out, c.member, with);
+}
+
+size_t scalar_count(const uint8_t *in, size_t n, const classifier &c) {
+  return count_bytes(in, 0, n, c.member);
+}
+
+const uint8_t *bytes(const char *p) {
+  return reinterpret_cast<const uint8_t *>(p);
+}
+uint8_t *bytes(char *p) { return reinterpret_cast<uint8_t *>(p); }
+
+} // namespace
+
+const functions &scalar_functions() {
+  static const functions scalar = {scalar_remove, scalar_replace,
+                                   scalar_count};
+  return scalar;
+}
+
+bool backend_supported(backend b) { return find(b) != nullptr; }
+
+backend active_backend() { return best()->kind; }
+
+const char *backend_name(backend b) {
+  if (b == backend::automatic) {
+    return best()->name;
+  }
+  return isa::name_of(implementations, b);
+}
+
+size_t remove(const char *in, size_t n, char *out, const byteset &s,
+              const options &o) {
+  const implementation *impl = find(o.kernel);
+  return impl == nullptr
+             ? 0
+             : impl->table().remove(bytes(in), n, bytes(out), classifier(s));
+}
+
+size_t keep(const char *in, size_t n, char *out, const byteset &s,
+            const options &o) {
+  return remove(in, n, out, ~s, o);
+}
+
+size_t remove(char *data, size_t n, const byteset &s, const options &o) {
+  return remove(data, n, data, s, o);
+}
+
+size_t keep(char *data, size_t n, const byteset &s, const options &o) {
+  return remove(data, n, data, ~s, o);
+}
+
+void replace(const char *in, size_t n, char *out, const byteset &s,
+             char with, const options &o) {
+  const implementation *impl = find(o.kernel);
+  if (impl != nullptr) {
+    impl->table().replace(bytes(in), n, bytes(out), classifier(s),
+                          uint8_t(with));
+  }
+}
+
+void replace(char *data, size_t n, const byteset &s, char with,
+             const options &o) {
+  replace(data, n, data, s, with, o);
+}
+
+size_t count(const char *in, size_t n, const byteset &s, const options &o) {
+  const implementation *impl = find(o.kernel);
+  return impl == nullptr ? 0
+                         : impl->table().count(bytes(in), n, classifier(s));
+}
+
+} // namespace bytefilter
@@ -0,0 +1,125 @@
+// Removes, keeps or replaces the bytes of a class, any set of the 256 byte
+// values, with SSE, AVX2 or AVX-512 picked at runtime.
+//
+// 2017/07/03/despacer.h and 2017/07/10/despacer.h remove the bytes up to
+// ' ' on ARM: NEON compares 16 bytes with ' ' and the other bytes are
+// packed with shuffles from a table (mask_shuffle, 8 bytes at a time, or
+// the 1 MiB shufmask of bigtable.h, 16 at a time). Here the class is any
+// set: each byte of a vector is looked up in a 256-bit bitmap with three
+// 16-entry shuffles (two by the low nibble for the rows, one by the high
+// nibble for the bit), and the bytes that remain are packed 8 at a time
+// with a table of 256 shuffles (SSE, AVX2) or with vpcompressb (AVX-512
+// VBMI2).
+//
+//   const bytefilter::byteset control = bytefilter::byteset::range(0, 31);
+//   size = bytefilter::remove(data, size, control); // in place
+//   bytefilter::replace(data, size, bytefilter::byteset::of(";\t"), ',');
+#ifndef BYTEFILTER_H
+#define BYTEFILTER_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace bytefilter {
+
+struct functions; // of a back end, in bytefilter_kernels.h
+
+// A set of byte values.
+class byteset {
+public:
+  constexpr byteset() : bits_{0, 0, 0, 0} {}
+
+  // the bytes of a C string
+  static constexpr byteset of(const char *bytes) {
+    byteset s;
+    for (; *bytes != '\0'; bytes++) {
+      s.add(uint8_t(*bytes));
+    }
+    return s;
+  }
+
+  // first to last, both included
+  static constexpr byteset range(uint8_t first, uint8_t last) {
+    byteset s;
+    for (unsigned b = first; b <= last; b++) {
+      s.add(uint8_t(b));
+    }
+    return s;
+  }
+
+  constexpr byteset &add(uint8_t b) {
+    bits_[b >> 6] |= uint64_t(1) << (b & 63);
+    return *this;
+  }
+
+  constexpr bool contains(uint8_t b) const {
+    return (bits_[b >> 6] >> (b & 63)) & 1;
+  }
+
+  constexpr byteset operator|(const byteset &other) const {
+    byteset s;
+    for (int k = 0; k < 4; k++) {
+      s.bits_[k] = bits_[k] | other.bits_[k];
+    }
+    return s;
+  }
+
+  constexpr byteset operator~() const {
+    byteset s;
+    for (int k = 0; k < 4; k++) {
+      s.bits_[k] = ~bits_[k];
+    }
+    return s;
+  }
+
+private:
+  uint64_t bits_[4];
+};
+
+enum class backend {
+  automatic, // best supported one
+  scalar,
+  sse,    // SSE4.2
+  avx2,
+  avx512 // AVX-512 VBMI and VBMI2 (Ice Lake and up)
+};
+
+// Whether the back end can run on this processor, and its name.
+bool backend_supported(backend b);
+backend active_backend();
+const char *backend_name(backend b);
+
+struct options {
+  backend kernel = backend::automatic;
+};
+
+// Copies the bytes of in[0, n) that are not in s (remove) or that are in s
+// (keep) to out, in order, and returns how many. out may be in; otherwise
+// it must have room for n bytes, since the vector back ends store whole
+// vectors past the bytes that they keep. An unsupported back end writes
+// nothing and returns 0.
+size_t remove(const char *in, size_t n, char *out, const byteset &s,
+              const options &o = options());
+size_t keep(const char *in, size_t n, char *out, const byteset &s,
+            const options &o = options());
+
+// In place: data[0, returned value) holds the bytes that remain.
+size_t remove(char *data, size_t n, const byteset &s,
+              const options &o = options());
+size_t keep(char *data, size_t n, const byteset &s,
+            const options &o = options());
+
+// Copies in[0, n) to out (which may be in) with each byte in s replaced by
+// with, as when delimiters are made the same.
+void replace(const char *in, size_t n, char *out, const byteset &s,
+             char with, const options &o = options());
+void replace(char *data, size_t n, const byteset &s, char with,
+             const options &o = options());
+
+// The bytes of in[0, n) that are in s.
+size_t count(const char *in, size_t n, const byteset &s,
+             const options &o = options());
+
+} // namespace bytefilter
+
+#endif // BYTEFILTER_H
@@ -0,0 +1,105 @@
+// The lookup tables of a set, the functions of each back end and the loops
+// one byte at a time that all of them share. Only the bytefilter*.cpp files
+// include this header.
+#ifndef BYTEFILTER_KERNELS_H
+#define BYTEFILTER_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "bytefilter.h"
+
+namespace bytefilter {
+
+// A set as the vector back ends look it up: for the byte 16h + l,
+// low_rows[l] has bit h set if it is in the set and h < 8, high_rows[l]
+// has bit h - 8 set if it is in the set and h >= 8. member has one byte per
+// value, 0xFF in the set and 0 outside.
+struct classifier {
+  uint8_t low_rows[16];
+  uint8_t high_rows[16];
+  uint8_t member[256];
+
+  explicit classifier(const byteset &s);
+};
+
+// The bytes of in[0, n) in the set of c are removed or replaced; out may
+// be in.
+struct functions {
+  size_t (*remove)(const uint8_t *in, size_t n, uint8_t *out,
+                   const classifier &c);
+  void (*replace)(const uint8_t *in, size_t n, uint8_t *out,
+                  const classifier &c, uint8_t with);
+  size_t (*count)(const uint8_t *in, size_t n, const classifier &c);
+};
+
+const functions &scalar_functions();
+const functions &sse_functions();
+const functions &avx2_functions();
+const functions &avx512_functions();
+
+// In an unnamed namespace: each back end compiles its own copy with its
+// own instruction sets, so that the linker cannot pick the AVX2 copy for
+// the scalar back end.
+namespace {
+
+// For 8 bytes with bit k of index set when byte k is kept: shuffle[index]
+// moves the kept bytes to the front, in order, and length[index] counts
+// them. The mask_shuffle table of 2017/07/10/despacer.h, built by the
+// compiler; the unused entries are 0x80, which a shuffle makes zero.
+struct byte_packing {
+  uint8_t shuffle[256][8];
+  uint8_t length[256];
+
+  constexpr byte_packing() : shuffle(), length() {
+    for (int index = 0; index < 256; index++) {
+      int k = 0;
+      for (int b = 0; b < 8; b++) {
+        if ((index >> b) & 1) {
+          shuffle[index][k++] = uint8_t(b);
+        }
+      }
+      length[index] = uint8_t(k);
+      for (; k < 8; k++) {
+        shuffle[index][k] = 0x80;
+      }
+    }
+  }
+};
+
+constexpr byte_packing packing{};
+
+// The loops one byte at a time, from in[i] with pos bytes already kept;
+// they write out[pos] before deciding whether to keep it, as despace does.
+inline size_t remove_bytes(const uint8_t *in, size_t i, size_t n,
+                           uint8_t *out, size_t pos, const uint8_t *member) {
+  for (; i < n; i++) {
+    const uint8_t b = in[i];
+    out[pos] = b;
+    pos += member[b] == 0;
+  }
+  return pos;
+}
+
+inline void replace_bytes(const uint8_t *in, size_t i, size_t n,
+                          uint8_t *out, const uint8_t *member, uint8_t with) {
+  for (; i < n; i++) {
+    const uint8_t b = in[i];
+    out[i] = member[b] != 0 ? with : b;
+  }
+}
+
+inline size_t count_bytes(const uint8_t *in, size_t i, size_t n,
+                          const uint8_t *member) {
+  size_t count = 0;
+  for (; i < n; i++) {
+    count += member[in[i]] & 1;
+  }
+  return count;
+}
+
+} // namespace
+
+} // namespace bytefilter
+
+#endif // BYTEFILTER_KERNELS_H
@@ -0,0 +1,152 @@
+// Checks of every back end against plain loops: sets of every kind (empty,
+// full, ranges, random, one value in each row and column of the lookup)
+// over random bytes at every length up to 300 and over longer inputs,
+// out of place (without writing past n bytes) and in place.
+#include "bytefilter.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const bytefilter::backend backends[] = {
+    bytefilter::backend::automatic, bytefilter::backend::scalar,
+    bytefilter::backend::sse, bytefilter::backend::avx2,
+    bytefilter::backend::avx512};
+
+std::mt19937_64 gen(1234);
+
+// bytes drawn mostly from the set, or mostly from outside, or any
+std::string random_bytes(size_t n, const bytefilter::byteset &s) {
+  std::string data(n, '\0');
+  const int density = int(gen() % 4);
+  for (char &c : data) {
+    do {
+      c = char(gen());
+    } while (density != 0 && s.contains(uint8_t(c)) != (density == 1) &&
+             gen() % 8 != 0);
+  }
+  return data;
+}
+
+bool check(const std::string &data, const bytefilter::byteset &s,
+           bytefilter::backend b) {
+  std::string removed, kept, replaced = data;
+  size_t count = 0;
+  for (char &c : replaced) {
+    if (s.contains(uint8_t(c))) {
+      kept += c;
+      c = '#';
+      count++;
+    } else {
+      removed += c;
+    }
+  }
+  bytefilter::options o;
+  o.kernel = b;
+  const size_t n = data.size();
+  const std::string guard(64, '!');
+  std::string out = std::string(n, '?') + guard;
+  bool ok = bytefilter::remove(data.data(), n, &out[0], s, o) ==
+                removed.size() &&
+            out.compare(0, removed.size(), removed) == 0 &&
+            out.compare(n, guard.size(), guard) == 0;
+  out = std::string(n, '?') + guard;
+  ok = ok && bytefilter::keep(data.data(), n, &out[0], s, o) == kept.size() &&
+       out.compare(0, kept.size(), kept) == 0 &&
+       out.compare(n, guard.size(), guard) == 0;
+  out = std::string(n, '?') + guard;
+  bytefilter::replace(data.data(), n, &out[0], s, '#', o);
+  ok = ok && out == replaced + guard;
+  ok = ok && bytefilter::count(data.data(), n, s, o) == count;
+  std::string in_place = data;
+  ok = ok && bytefilter::remove(&in_place[0], n, s, o) == removed.size() &&
+       in_place.compare(0, removed.size(), removed) == 0;
+  in_place = data;
+  ok = ok && bytefilter::keep(&in_place[0], n, s, o) == kept.size() &&
+       in_place.compare(0, kept.size(), kept) == 0;
+  in_place = data;
+  bytefilter::replace(&in_place[0], n, s, '#', o);
+  ok = ok && in_place == replaced;
+  if (!ok) {
+    printf("bug: %s, %zu bytes\n", bytefilter::backend_name(b), n);
+  }
+  return ok;
+}
+
+bool check_all(const std::string &data, const bytefilter::byteset &s) {
+  for (bytefilter::backend b : backends) {
+    if (bytefilter::backend_supported(b) && !check(data, s, b)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<bytefilter::byteset> sets() {
+  std::vector<bytefilter::byteset> sets = {
+      bytefilter::byteset(), ~bytefilter::byteset(),
+      bytefilter::byteset::range(0, 32), bytefilter::byteset::of(" \t\r\n"),
+      bytefilter::byteset::range(0x80, 0xFF),
+      bytefilter::byteset::of(",;|") | bytefilter::byteset::range(0, 31)};
+  // one value per row and per column of the tables
+  for (int b = 0; b < 256; b += 17) {
+    sets.push_back(bytefilter::byteset().add(uint8_t(b)));
+  }
+  for (int k = 0; k < 20; k++) {
+    bytefilter::byteset s;
+    const int size = 1 + int(gen() % 128);
+    for (int j = 0; j < size; j++) {
+      s.add(uint8_t(gen()));
+    }
+    sets.push_back(s);
+  }
+  return sets;
+}
+
+bool check_sets() {
+  for (const bytefilter::byteset &s : sets()) {
+    for (size_t n = 0; n <= 300; n++) {
+      if (!check_all(random_bytes(n, s), s)) {
+        return false;
+      }
+    }
+    for (int k = 0; k < 5; k++) {
+      if (!check_all(random_bytes(1000 + gen() % 100000, s), s)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool check_byteset() {
+  constexpr bytefilter::byteset digits = bytefilter::byteset::range('0', '9');
+  static_assert(digits.contains('5') && !digits.contains('a'),
+                "constexpr byteset");
+  const bytefilter::byteset s = bytefilter::byteset::of("ab") | digits;
+  int count = 0;
+  for (int b = 0; b < 256; b++) {
+    count += s.contains(uint8_t(b));
+    if (s.contains(uint8_t(b)) == (~s).contains(uint8_t(b))) {
+      return false;
+    }
+  }
+  return count == 12;
+}
+
+} // namespace
+
+int main() {
+  printf("best back end: %s\n",
+         bytefilter::backend_name(bytefilter::active_backend()));
+  if (!check_byteset() || !check_sets()) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,165 @@
+// Nanoseconds per number and GB/s over 32 MB of CSV (four columns) of
+// three kinds: prices with two decimals, doubles printed with 17 digits,
+// and timestamps in milliseconds with microseconds after the point (13
+// digits before it, where reading eight digits at a time pays most). The
+// baselines: splitting into one std::string per field and giving each to
+// fast_float::from_chars, as 2021/03/24/benchmark.cpp does; strtod over
+// the buffer; and fast_float::from_chars over the buffer, with the same
+// loop as ours but its own reading of the digits. Then floatparse, to
+// double and to float, with one thread and more.
+#include "floatparse.h"
+
+#include "../../2021/03/24/include/fast_float/fast_float.h"
+#include "../harness/harness.h"
+
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::string make_csv(int kind, size_t size, std::mt19937_64 &gen) {
+  std::string csv;
+  char buffer[64];
+  while (csv.size() < size) {
+    for (int c = 0; c < 4; c++) {
+      if (kind == 0) {
+        snprintf(buffer, sizeof(buffer), "%.2f",
+                 double(gen() % 100000000) / 100);
+      } else if (kind == 1) {
+        snprintf(buffer, sizeof(buffer), "%.17g",
+                 double(gen() >> 11) / double(uint64_t(1) << 53) - 0.5);
+      } else {
+        snprintf(buffer, sizeof(buffer), "%llu.%03llu",
+                 (unsigned long long)(1600000000000 + gen() % 100000000000),
+                 (unsigned long long)(gen() % 1000));
+      }
+      csv += buffer;
+      csv += c == 3 ? '\n' : ',';
+    }
+  }
+  return csv;
+}
+
+size_t split_from_chars(const std::string &csv, double *out) {
+  std::vector<std::string> fields;
+  std::string field;
+  for (char c : csv) {
+    if (c == ',' || c == '\n') {
+      fields.push_back(field);
+      field.clear();
+    } else {
+      field += c;
+    }
+  }
+  size_t count = 0;
+  for (const std::string &f : fields) {
+    if (fast_float::from_chars(f.data(), f.data() + f.size(), out[count])
+            .ec != std::errc()) {
+      return 0;
+    }
+    count++;
+  }
+  return count;
+}
+
+size_t strtod_loop(const std::string &csv, double *out) {
+  const char *p = csv.c_str();
+  const char *const end = p + csv.size();
+  size_t count = 0;
+  while (p != end) {
+    char *next;
+    out[count++] = strtod(p, &next);
+    if (next == p || (*next != ',' && *next != '\n')) {
+      return 0;
+    }
+    p = next + 1;
+  }
+  return count;
+}
+
+size_t from_chars_loop(const std::string &csv, double *out) {
+  const char *p = csv.data();
+  const char *const end = p + csv.size();
+  size_t count = 0;
+  while (p != end) {
+    const auto r = fast_float::from_chars(p, end, out[count++]);
+    if (r.ec != std::errc() || (*r.ptr != ',' && *r.ptr != '\n')) {
+      return 0;
+    }
+    p = r.ptr + 1;
+  }
+  return count;
+}
+
+} // namespace
+
+int main() {
+  setlocale(LC_ALL, "C");
+  std::mt19937_64 gen(1234);
+  harness::options opts = harness::default_options();
+  opts.repeat = 5;
+  const char *kinds[] = {"prices", "17 digits", "timestamps"};
+  printf("%u hardware threads\n", std::thread::hardware_concurrency());
+  bool ok = true;
+  for (int kind = 0; kind < 3; kind++) {
+    const std::string csv = make_csv(kind, size_t(32) << 20, gen);
+    std::vector<double> out(floatparse::capacity(csv.size()));
+    std::vector<float> out32(out.size());
+    size_t numbers = 0;
+    for (char c : csv) {
+      numbers += c == ',' || c == '\n';
+    }
+    printf("%s: %zu MB, %zu numbers\n", kinds[kind], csv.size() >> 20,
+           numbers);
+    auto time = [&](const char *name, const std::function<size_t()> &f) {
+      auto r = harness::run(name, csv.size(), [&] {
+        const size_t count = f();
+        ok = ok && count == numbers;
+        harness::do_not_optimize(count);
+      }, opts);
+      if (opts.format != HARNESS_TEXT) {
+        r.report();
+      } else {
+        printf("  %-28s\t%8.2f ns/number\t%6.2f GB/s\n", name,
+               r.min() / numbers, csv.size() / r.min());
+      }
+    };
+    time("split + from_chars", [&] {
+      return split_from_chars(csv, out.data());
+    });
+    time("strtod", [&] { return strtod_loop(csv, out.data()); });
+    time("from_chars", [&] { return from_chars_loop(csv, out.data()); });
+    for (unsigned threads : {1u, 2u, 4u}) {
+      floatparse::options o;
+      o.threads = threads;
+      const std::string name =
+          "floatparse, " + std::to_string(threads) + " thread(s)";
+      time(name.c_str(), [&] {
+        return floatparse::parse(csv.data(), csv.size(), out.data(),
+                                 out.size(), o).count;
+      });
+    }
+    time("floatparse, float", [&] {
+      return floatparse::parse(csv.data(), csv.size(), out32.data(),
+                               out32.size()).count;
+    });
+    // the same doubles as fast_float
+    std::vector<double> reference(numbers);
+    from_chars_loop(csv, reference.data());
+    floatparse::parse(csv.data(), csv.size(), out.data(), out.size());
+    ok = ok && memcmp(reference.data(), out.data(),
+                      numbers * sizeof(double)) == 0;
+  }
+  if (!ok) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,290 @@
+// The scanner of floatparse.h, and its split between threads: the text is
+// cut after a newline (before a white space without a separator), so that
+// every piece starts at the start of a line, and the pieces after the
+// first go to buffers of their own, copied into the output once all
+// threads are done.
+#include "floatparse.h"
+
+#include "../../2021/03/24/include/fast_float/fast_float.h"
+#include "../parallel/parallel.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace floatparse {
+
+namespace {
+
+bool is_digit(char c) { return uint8_t(c - '0') < 10; }
+
+// white space that is not a newline
+bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// The digits at p, eight at a time with the SWAR code of
+// 2018/10/03/eightchartoi.c (which fast_float has), added to *mantissa.
+const char *read_digits(const char *p, const char *end, uint64_t *mantissa) {
+  uint64_t m = *mantissa;
+  while (end - p >= 8 && fast_float::is_made_of_eight_digits_fast(p)) {
+    m = m * 100000000 + fast_float::parse_eight_digits_unrolled(p);
+    p += 8;
+  }
+  while (p != end && is_digit(*p)) {
+    m = m * 10 + uint64_t(*p - '0');
+    p++;
+  }
+  *mantissa = m;
+  return p;
+}
+
+template <class T>
+const char *from_chars(const char *first, const char *end, T *value) {
+  const fast_float::from_chars_result r =
+      fast_float::from_chars(first, end, *value);
+  return r.ec == std::errc() ? r.ptr : nullptr;
+}
+
+// As fast_float::from_chars, once the digits are read: Clinger's fast path
+// when the mantissa and the power of ten are both exact, then the
+// Eisel-Lemire algorithm, then the slow path for the rare halfway cases.
+template <class T>
+void convert(bool negative, uint64_t mantissa, int64_t exponent,
+             const char *first, const char *last, T *value) {
+  typedef fast_float::binary_format<T> format;
+  if (format::min_exponent_fast_path() <= exponent &&
+      exponent <= format::max_exponent_fast_path() &&
+      mantissa <= format::max_mantissa_fast_path()) {
+    T v = T(mantissa);
+    if (exponent < 0) {
+      v = v / format::exact_power_of_ten(-exponent);
+    } else {
+      v = v * format::exact_power_of_ten(exponent);
+    }
+    *value = negative ? -v : v;
+    return;
+  }
+  fast_float::adjusted_mantissa am =
+      fast_float::compute_float<format>(exponent, mantissa);
+  if (am.power2 < 0) {
+    am = fast_float::parse_long_mantissa<format>(first, last);
+  }
+  fast_float::to_float(negative, am, *value);
+}
+
+// The number at p, which ends before the returned pointer; nullptr if
+// there is none. What has no digit (infinities, NaNs, errors) or more than
+// 19 of them goes to fast_float::from_chars.
+template <class T>
+const char *parse_number(const char *p, const char *end, T *value) {
+  const char *const first = p;
+  const bool negative = *p == '-';
+  p += negative;
+  const char *const start_digits = p;
+  uint64_t mantissa = 0;
+  p = read_digits(p, end, &mantissa);
+  const int64_t integer_digits = p - start_digits;
+  int64_t exponent = 0;
+  if (p != end && *p == '.') {
+    const char *const start_fraction = ++p;
+    p = read_digits(p, end, &mantissa);
+    exponent = start_fraction - p;
+  }
+  const int64_t digits = integer_digits - exponent;
+  if (digits == 0 || digits > 19) {
+    return from_chars(first, end, value);
+  }
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    const char *q = p + 1;
+    bool negative_exponent = false;
+    if (q != end && (*q == '-' || *q == '+')) {
+      negative_exponent = *q == '-';
+      q++;
+    }
+    // without digits, the 'e' is not part of the number
+    if (q != end && is_digit(*q)) {
+      int64_t e = 0;
+      for (; q != end && is_digit(*q); q++) {
+        if (e < 0x10000) {
+          e = 10 * e + (*q - '0');
+        }
+      }
+      exponent += negative_exponent ? -e : e;
+      p = q;
+    }
+  }
+  convert(negative, mantissa, exponent, first, p, value);
+  return p;
+}
+
+// Goes over the fields of [p, end) and can stop when the output is full,
+// to go on with another one.
+template <class T> class scanner {
+public:
+  scanner(const char *p, const char *end, const options &o)
+      : p_(p), end_(end), separator_(o.separator),
+        missing_as_nan_(o.missing_as_nan) {}
+
+  struct outcome {
+    status code;
+    size_t count;
+    const char *error; // when not ok
+  };
+
+  outcome run(T *out, size_t capacity) {
+    size_t count = 0;
+    for (;;) {
+      while (p_ != end_ && is_blank(*p_) && *p_ != separator_) {
+        p_++;
+      }
+      if (p_ == end_) {
+        break;
+      }
+      const char c = *p_;
+      if (c == '\n' || (separator_ != '\0' && c == separator_)) {
+        // an empty field before a separator at the start of a line, or
+        // before anything after a separator
+        if (need_field_ || (line_start_ && c != '\n')) {
+          if (!missing_as_nan_ || count == capacity) {
+            return {missing_as_nan_ ? status::full : status::missing, count,
+                    p_};
+          }
+          out[count++] = std::numeric_limits<T>::quiet_NaN();
+        }
+        need_field_ = c != '\n';
+        line_start_ = c == '\n';
+        p_++;
+        continue;
+      }
+      // two numbers without a separator
+      if (separator_ != '\0' && !need_field_ && !line_start_) {
+        return {status::invalid, count, p_};
+      }
+      if (count == capacity) {
+        return {status::full, count, p_};
+      }
+      const char *next = parse_number(p_, end_, &out[count]);
+      if (next == nullptr || (next != end_ && !is_delimiter(*next))) {
+        return {status::invalid, count, p_};
+      }
+      count++;
+      line_start_ = false;
+      // most often a separator follows: take it here
+      need_field_ = separator_ != '\0' && next != end_ && *next == separator_;
+      p_ = next + need_field_;
+    }
+    // a separator at the very end
+    if (need_field_) {
+      if (!missing_as_nan_ || count == capacity) {
+        return {missing_as_nan_ ? status::full : status::missing, count, p_};
+      }
+      out[count++] = std::numeric_limits<T>::quiet_NaN();
+      need_field_ = false;
+    }
+    return {status::ok, count, nullptr};
+  }
+
+private:
+  bool is_delimiter(char c) const {
+    return (separator_ != '\0' && c == separator_) || c == '\n' || is_blank(c);
+  }
+
+  const char *p_;
+  const char *const end_;
+  const char separator_;
+  const bool missing_as_nan_;
+  bool line_start_ = true; // no field yet on this line
+  bool need_field_ = false; // after a separator
+};
+
+// Where a piece may start, from p on: after a newline, or at a white space
+// when there is no separator; end if there is none.
+const char *next_cut(const char *p, const char *end, const options &o) {
+  if (o.separator != '\0') {
+    const void *newline = memchr(p, '\n', size_t(end - p));
+    return newline == nullptr ? end : static_cast<const char *>(newline) + 1;
+  }
+  while (p != end && !is_blank(*p) && *p != '\n') {
+    p++;
+  }
+  return p;
+}
+
+template <class T>
+result parse_pieces(const char *data, size_t n, T *out, size_t capacity,
+                    const options &o) {
+  const unsigned threads = parallel::thread_count(o.threads);
+  if (threads == 1 || n / threads < parallel::minimum_bytes) {
+    const auto r = scanner<T>(data, data + n, o).run(out, capacity);
+    return {r.code, r.count, r.code == status::ok ? 0 : size_t(r.error - data)};
+  }
+  std::vector<const char *> cuts = {data};
+  for (unsigned t = 1; t < threads; t++) {
+    cuts.push_back(next_cut(
+        std::max(cuts.back(), data + n / threads * t), data + n, o));
+  }
+  cuts.push_back(data + n);
+  // the first piece goes straight to out, the others to parts, which grow
+  std::vector<std::vector<T>> parts(threads);
+  std::vector<typename scanner<T>::outcome> outcomes(threads);
+  parallel::in_parallel(threads, [&](unsigned t) {
+    scanner<T> s(cuts[t], cuts[t + 1], o);
+    if (t == 0) {
+      outcomes[0] = s.run(out, capacity);
+      return;
+    }
+    std::vector<T> &part = parts[t];
+    part.resize(std::max<size_t>(1024, size_t(cuts[t + 1] - cuts[t]) / 16));
+    size_t count = 0;
+    for (;;) {
+      outcomes[t] = s.run(part.data() + count, part.size() - count);
+      count += outcomes[t].count;
+      if (outcomes[t].code != status::full || part.size() >= capacity) {
+        break;
+      }
+      part.resize(part.size() * 2);
+    }
+    outcomes[t].count = count;
+  });
+  size_t count = 0;
+  for (unsigned t = 0; t < threads; t++) {
+    auto r = outcomes[t];
+    if (t > 0) {
+      if (r.count > capacity - count ||
+          (r.code == status::full && r.count == capacity - count)) {
+        // over the capacity in this piece: again, straight to out, to find
+        // the field that does not fit
+        r = scanner<T>(cuts[t], cuts[t + 1], o)
+                .run(out + count, capacity - count);
+      } else {
+        std::copy(parts[t].begin(), parts[t].begin() + r.count, out + count);
+      }
+    }
+    count += r.count;
+    if (r.code != status::ok) {
+      return {r.code, count, size_t(r.error - data)};
+    }
+  }
+  return {status::ok, count, 0};
+}
+
+} // namespace
+
+size_t capacity(size_t n, const options &o) {
+  // a number takes a byte, and a delimiter unless it is the last; an
+  // empty field takes its separator only
+  return o.missing_as_nan && o.separator != '\0' ? n + 1 : n / 2 + 1;
+}
+
+result parse(const char *data, size_t n, double *out, size_t capacity,
+             const options &o) {
+  return parse_pieces(data, n, out, capacity, o);
+}
+
+result parse(const char *data, size_t n, float *out, size_t capacity,
+             const options &o) {
+  return parse_pieces(data, n, out, capacity, o);
+}
+
+} // namespace floatparse
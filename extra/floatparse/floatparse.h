@@ -0,0 +1,70 @@
+// Numbers in delimited text (CSV columns, lists separated by spaces or
+// newlines) parsed straight from the buffer into an array of double or
+// float, in one pass and without a std::string per number, optionally
+// with the buffer split between threads.
+//
+// 2021/03/24/benchmark.cpp gives fast_float::from_chars one std::string
+// at a time; reading a numeric CSV that way spends more time splitting and
+// allocating than converting. Here one loop finds the fields and reads
+// their digits, eight at a time with the SWAR code of
+// 2018/10/03/eightchartoi.c (as fast_float does for the digits after the
+// point, here for those before it as well), and gives the decimal
+// mantissa and exponent to the conversion of fast_float
+// (2021/03/24/include/fast_float), which makes the result exact. Numbers
+// with more than 19 digits, infinities and NaNs go to fast_float::from_chars.
+//
+//   std::vector<double> values(floatparse::capacity(size, o));
+//   floatparse::result r = floatparse::parse(text, size, values.data(),
+//                                            values.size(), o);
+//   if (r.code != floatparse::status::ok) printf("at byte %zu\n", r.error);
+//   values.resize(r.count);
+#ifndef FLOATPARSE_H
+#define FLOATPARSE_H
+
+#include <cstddef>
+
+namespace floatparse {
+
+struct options {
+  // Between the fields of a line, around which spaces and tabs do not
+  // count, unless one of them is the separator ('\t' for TSV); '\0' for
+  // fields separated by white space only.
+  char separator = ',';
+  // An empty field (",," or a separator at the start or the end of a line)
+  // gives a NaN instead of an error. Blank lines are never fields.
+  bool missing_as_nan = false;
+  // 0 for one per hardware thread.
+  unsigned threads = 1;
+};
+
+enum class status {
+  ok,
+  invalid, // a field that is not a number
+  missing, // an empty field, without missing_as_nan
+  full     // more numbers than the capacity of the output
+};
+
+struct result {
+  status code;
+  // Numbers stored: all of them, or those before the error.
+  size_t count;
+  // When not ok, the offset of the first field in error (the field that
+  // did not fit, for status::full).
+  size_t error;
+};
+
+// Enough room for the numbers of n bytes of text.
+size_t capacity(size_t n, const options &o = options());
+
+// Parses data[0, n) into out[0, count), in order. Lines may end with
+// "\n" or "\r\n". The numbers are those of fast_float::from_chars (and of
+// strtod, but for hexadecimal floats and a leading '+'), correctly
+// rounded.
+result parse(const char *data, size_t n, double *out, size_t capacity,
+             const options &o = options());
+result parse(const char *data, size_t n, float *out, size_t capacity,
+             const options &o = options());
+
+} // namespace floatparse
+
+#endif // FLOATPARSE_H
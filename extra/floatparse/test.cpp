@@ -0,0 +1,249 @@
+// Checks against strtod and strtof, which must give the same bits: numbers
+// of every shape (short, 17 digits, more than 19, exponents, subnormals,
+// overflows, infinities), then whole texts with commas, semicolons, tabs
+// or white space only, random spaces, CRLF and blank lines, with one thread
+// and with several; then errors, empty fields and a full output, with the
+// offsets and counts they must give.
+#include "floatparse.h"
+
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::mt19937_64 gen(1234);
+
+std::string random_number() {
+  char buffer[64];
+  const double x = std::ldexp(double(gen() >> 11), int(gen() % 200) - 100);
+  switch (gen() % 10) {
+  case 0:
+    snprintf(buffer, sizeof(buffer), "%.17g", x);
+    break;
+  case 1:
+    snprintf(buffer, sizeof(buffer), "%.6f", x / 1e20);
+    break;
+  case 2:
+    snprintf(buffer, sizeof(buffer), "%e", -x);
+    break;
+  case 3: // an integer, up to 20 digits
+    snprintf(buffer, sizeof(buffer), "%llu",
+             (unsigned long long)(gen() >> (gen() % 64)));
+    break;
+  case 4: // more digits than a 64-bit mantissa holds
+    snprintf(buffer, sizeof(buffer), "%llu%llu.%llu",
+             (unsigned long long)gen(), (unsigned long long)gen(),
+             (unsigned long long)(gen() % 1000));
+    break;
+  case 5: // subnormals and the edges of the range
+    snprintf(buffer, sizeof(buffer), "%.3ge%d", double(gen() % 1000) / 100,
+             int(gen() % 700) - 350);
+    break;
+  case 6: {
+    const char *special[] = {"0",    "-0",    ".5",    "5.",     "-.25",
+                             "1E+2", "1e-2",  "inf",   "-inf",   "1e400",
+                             "nan",  "0.0000000000000000000000123",
+                             "4.9406564584124654e-324", "3.4028236e38"};
+    return special[gen() % (sizeof(special) / sizeof(special[0]))];
+  }
+  default:
+    snprintf(buffer, sizeof(buffer), "%.*f", int(gen() % 10),
+             double(gen() % 100000000) / 100);
+  }
+  return buffer;
+}
+
+bool same(double a, double b) {
+  return std::isnan(a) ? std::isnan(b) : memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+bool same(float a, float b) {
+  return std::isnan(a) ? std::isnan(b) : memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+struct text {
+  std::string data;
+  std::vector<std::string> fields;
+  std::vector<size_t> offsets; // of the fields
+};
+
+// rows of numbers separated by separator ('\0': by white space)
+text make_text(size_t rows, char separator) {
+  text t;
+  for (size_t r = 0; r < rows; r++) {
+    if (gen() % 20 == 0) {
+      t.data += gen() % 2 ? "\n" : " \r\n";
+    }
+    const size_t columns = 1 + gen() % 6;
+    for (size_t c = 0; c < columns; c++) {
+      if (c > 0) {
+        t.data += std::string(gen() % 3, ' ');
+        t.data += separator == '\0' ? (gen() % 2 ? ' ' : '\t') : separator;
+      }
+      // tabs too, unless they are the separator
+      t.data += std::string(gen() % 2,
+                            separator != '\t' && gen() % 2 ? '\t' : ' ');
+      t.fields.push_back(random_number());
+      t.offsets.push_back(t.data.size());
+      t.data += t.fields.back();
+    }
+    if (r + 1 < rows || gen() % 2) {
+      t.data += gen() % 4 == 0 ? "\r\n" : "\n";
+    }
+  }
+  return t;
+}
+
+template <class T> T expected(const std::string &field);
+template <> double expected<double>(const std::string &field) {
+  return strtod(field.c_str(), nullptr);
+}
+template <> float expected<float>(const std::string &field) {
+  return strtof(field.c_str(), nullptr);
+}
+
+template <class T>
+bool check_text(const text &t, const floatparse::options &o) {
+  std::vector<T> out(floatparse::capacity(t.data.size(), o));
+  const floatparse::result r = floatparse::parse(
+      t.data.data(), t.data.size(), out.data(), out.size(), o);
+  bool ok = r.code == floatparse::status::ok && r.count == t.fields.size();
+  for (size_t k = 0; ok && k < t.fields.size(); k++) {
+    if (!same(out[k], expected<T>(t.fields[k]))) {
+      printf("bug: %s gives %.17g\n", t.fields[k].c_str(), double(out[k]));
+      ok = false;
+    }
+  }
+  if (!ok) {
+    printf("bug: %zu bytes, separator '%c', %u threads: %zu numbers of %zu\n",
+           t.data.size(), o.separator, o.threads, r.count, t.fields.size());
+  }
+  return ok;
+}
+
+bool check_texts() {
+  for (char separator : {',', ';', '\t', '\0'}) {
+    floatparse::options o;
+    o.separator = separator;
+    for (int k = 0; k < 200; k++) {
+      const text t = make_text(gen() % 50, separator);
+      if (!check_text<double>(t, o) || !check_text<float>(t, o)) {
+        return false;
+      }
+    }
+    // pieces of more than a megabyte, for the threads
+    const text big = make_text(200000, separator);
+    for (unsigned threads : {1u, 3u, 8u}) {
+      o.threads = threads;
+      if (!check_text<double>(big, o) || !check_text<float>(big, o)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+struct error_case {
+  const char *data;
+  char separator;
+  bool missing_as_nan;
+  size_t capacity;
+  floatparse::status code;
+  size_t count;
+  size_t error;
+};
+
+bool check_errors() {
+  using floatparse::status;
+  const error_case cases[] = {
+      {"1,2,x,3", ',', false, 10, status::invalid, 2, 4},
+      {"1,2.5.1", ',', false, 10, status::invalid, 1, 2},
+      {"1e,2", ',', false, 10, status::invalid, 0, 0},
+      {"--1", ',', false, 10, status::invalid, 0, 0},
+      {"+1", ',', false, 10, status::invalid, 0, 0},
+      {"0x10", ',', false, 10, status::invalid, 0, 0},
+      {"1 2", ',', false, 10, status::invalid, 1, 2},
+      {"1 2\n3", '\0', false, 10, status::ok, 3, 0},
+      {"1,2\n3", '\0', false, 10, status::invalid, 0, 0},
+      {"1,,2", ',', false, 10, status::missing, 1, 2},
+      {"1,,2", ',', true, 10, status::ok, 3, 0},
+      {",1", ',', false, 10, status::missing, 0, 0},
+      {",1", ',', true, 10, status::ok, 2, 0},
+      {"1,\n2", ',', false, 10, status::missing, 1, 2},
+      {"1,\r\n2", ',', true, 10, status::ok, 3, 0},
+      {"1,2,", ',', false, 10, status::missing, 2, 4},
+      {"1,2,", ',', true, 10, status::ok, 3, 0},
+      {",", ',', true, 10, status::ok, 2, 0},
+      {"\n\n 1 \r\n\r\n2\n", ',', false, 10, status::ok, 2, 0},
+      {"", ',', false, 0, status::ok, 0, 0},
+      {"1,2,3", ',', false, 2, status::full, 2, 4},
+      {"1,,3", ',', true, 1, status::full, 1, 2},
+      // TSV: the tabs are separators, not blanks
+      {"1\t\t2", '\t', false, 10, status::missing, 1, 2},
+      {"1\t\t2", '\t', true, 10, status::ok, 3, 0},
+      {"\t2", '\t', false, 10, status::missing, 0, 0},
+      {"\t2", '\t', true, 10, status::ok, 2, 0},
+      {"1\t2\t", '\t', false, 10, status::missing, 2, 4},
+      {"1 \t 2\n 3\t4 \n", '\t', false, 10, status::ok, 4, 0},
+      {"1 2\t3", '\t', false, 10, status::invalid, 1, 2},
+  };
+  for (const error_case &c : cases) {
+    floatparse::options o;
+    o.separator = c.separator;
+    o.missing_as_nan = c.missing_as_nan;
+    std::vector<double> out(c.capacity + 1);
+    const floatparse::result r =
+        floatparse::parse(c.data, strlen(c.data), out.data(), c.capacity, o);
+    if (r.code != c.code || r.count != c.count ||
+        (r.code != status::ok && r.error != c.error) ||
+        floatparse::capacity(strlen(c.data), o) < r.count) {
+      printf("bug: \"%s\" gives %d, %zu numbers, error at %zu\n", c.data,
+             int(r.code), r.count, r.error);
+      return false;
+    }
+  }
+  // an error or a full output late in a text cut between threads
+  const text t = make_text(200000, ',');
+  for (int k = 0; k < 10; k++) {
+    const size_t bad = t.fields.size() / 2 + gen() % (t.fields.size() / 2);
+    std::string data = t.data;
+    data.insert(t.offsets[bad], "x,");
+    floatparse::options o;
+    o.threads = 1 + k % 4;
+    std::vector<double> out(floatparse::capacity(data.size(), o));
+    floatparse::result r = floatparse::parse(data.data(), data.size(),
+                                             out.data(), out.size(), o);
+    if (r.code != floatparse::status::invalid || r.error != t.offsets[bad] ||
+        r.count != bad) {
+      printf("bug: error at %zu after %zu numbers, found at %zu after %zu\n",
+             t.offsets[bad], bad, r.error, r.count);
+      return false;
+    }
+    r = floatparse::parse(t.data.data(), t.data.size(), out.data(), bad, o);
+    if (r.code != floatparse::status::full || r.count != bad ||
+        r.error != t.offsets[bad]) {
+      printf("bug: full output, %u threads\n", o.threads);
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main() {
+  // strtod, the reference, must not use a decimal comma
+  setlocale(LC_ALL, "C");
+  if (!check_texts() || !check_errors()) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,39 @@
+// Shows the C interface of harness.h.
+#include "harness.h"
+
+typedef struct {
+  const uint32_t *data;
+  size_t length;
+  uint64_t sum;
+} sum_context;
+
+static void sum(void *ctx) {
+  sum_context *s = (sum_context *)ctx;
+  uint64_t answer = 0;
+  size_t i;
+  for (i = 0; i < s->length; i++) {
+    answer += s->data[i];
+  }
+  s->sum = answer;
+  harness_escape(&s->sum);
+}
+
+int main(void) {
+  size_t length = 1 << 16, i;
+  uint32_t *data = (uint32_t *)malloc(length * sizeof(uint32_t));
+  sum_context ctx;
+  harness_options opts = harness_default_options();
+  harness_result r;
+  for (i = 0; i < length; i++) {
+    data[i] = (uint32_t)(i * 2654435761u);
+  }
+  ctx.data = data;
+  ctx.length = length;
+  if (harness_run("sum (C)", length, sum, &ctx, &opts, &r) != 0) {
+    return EXIT_FAILURE;
+  }
+  harness_report(stdout, &r, opts.format);
+  harness_result_free(&r);
+  free(data);
+  return EXIT_SUCCESS;
+}
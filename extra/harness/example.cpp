@@ -0,0 +1,25 @@
+// Shows the C++ interface of harness.h.
+#include "harness.h"
+
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+int main() {
+  std::vector<uint32_t> data(1 << 16);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = uint32_t(i * 2654435761u);
+  }
+  harness::run("accumulate (C++)", data.size(), [&] {
+    harness::do_not_optimize(
+        std::accumulate(data.begin(), data.end(), uint64_t(0)));
+  }).report();
+  auto r = harness::run("accumulate (percentiles)", data.size(), [&] {
+    harness::do_not_optimize(
+        std::accumulate(data.begin(), data.end(), uint64_t(0)));
+  });
+  printf("min %.3f median %.3f p99 %.3f ns/item\n",
+         r.min() / r.volume(), r.median() / r.volume(),
+         r.percentile(0.99) / r.volume());
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,702 @@
+// Shared benchmarking harness.
+//
+// Most directories in this repository carry their own benchmark.h
+// (BEST_TIME, RDTSC_START...) or linux-perf-events.h (LinuxEvents<TYPE>).
+// The copies have drifted: some subtract the rdtsc overhead, some do not,
+// some report the minimum, others the average. This header is meant to be
+// the one copy new experiments include, from C or from C++:
+//
+//   #include "../../extra/harness/harness.h"
+//
+// It measures wall-clock time, the time-stamp counter and, on Linux, the
+// cycles/instructions/branch-misses/cache-misses hardware counters. Every
+// measurement has the cost of an empty run subtracted (measured the same
+// way, once per process), so numbers coming from different directories
+// can be compared. Results can be printed as text, CSV or JSON lines; the
+// format is picked by the HARNESS_FORMAT environment variable (text, csv,
+// json) unless the caller sets it explicitly.
+//
+// C usage:
+//
+//   static void run(void *ctx) { ... }
+//   harness_result r;
+//   harness_options opts = harness_default_options();
+//   harness_run("mykernel", n, run, &data, &opts, &r);
+//   harness_report(stdout, &r, opts.format);
+//   harness_result_free(&r);
+//
+// C++ usage:
+//
+//   auto r = harness::run("mykernel", n, [&] { ... });
+//   r.report();
+//
+//   // a sort of a fresh copy of input each time, as a row of a table
+//   harness::print_row("int32_t", 8, 14, harness::run_on_copy(
+//       "std::sort", input, out, [&] { std::sort(out.begin(), out.end()); }));
+//
+#ifndef HARNESS_H
+#define HARNESS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <asm/unistd.h>       // for __NR_perf_event_open
+#include <errno.h>            // for errno
+#include <linux/perf_event.h> // for perf event constants
+#include <sys/ioctl.h>        // for ioctl
+#include <unistd.h>           // for syscall
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// What we record for every run. The hardware counters come last so that
+// HARNESS_FIRST_COUNTER..HARNESS_METRIC_COUNT can be opened as one group.
+typedef enum harness_metric {
+  HARNESS_NS = 0,
+  HARNESS_TSC,
+  HARNESS_CYCLES,
+  HARNESS_INSTRUCTIONS,
+  HARNESS_BRANCH_MISSES,
+  HARNESS_CACHE_MISSES,
+  HARNESS_METRIC_COUNT
+} harness_metric;
+
+#define HARNESS_FIRST_COUNTER HARNESS_CYCLES
+#define HARNESS_COUNTER_COUNT (HARNESS_METRIC_COUNT - HARNESS_FIRST_COUNTER)
+
+static const char *const harness_metric_names[HARNESS_METRIC_COUNT] = {
+    "ns", "tsc", "cycles", "instructions", "branch_misses", "cache_misses"};
+
+typedef enum harness_format {
+  HARNESS_TEXT = 0,
+  HARNESS_CSV,
+  HARNESS_JSON
+} harness_format;
+
+/////////////////////
+// Timers
+/////////////////////
+
+// Serialized time-stamp counter reads, the same sequences the old
+// RDTSC_START/RDTSC_FINAL macros used. On other systems, we fall back
+// on a nanosecond clock.
+static inline uint64_t harness_ticks_start(void) {
+#if defined(__x86_64__)
+  uint32_t cyc_high, cyc_low;
+  __asm volatile("cpuid\n\t"
+                 "rdtsc\n\t"
+                 "mov %%edx, %0\n\t"
+                 "mov %%eax, %1\n\t"
+                 : "=r"(cyc_high), "=r"(cyc_low)::"%rax", "%rbx", "%rcx",
+                   "%rdx");
+  return ((uint64_t)cyc_high << 32) | cyc_low;
+#elif defined(__aarch64__)
+  uint64_t t;
+  __asm volatile("isb\n\tmrs %0, cntvct_el0" : "=r"(t)::"memory");
+  return t;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+#endif
+}
+
+static inline uint64_t harness_ticks_stop(void) {
+#if defined(__x86_64__)
+  uint32_t cyc_high, cyc_low;
+  __asm volatile("rdtscp\n\t"
+                 "mov %%edx, %0\n\t"
+                 "mov %%eax, %1\n\t"
+                 "cpuid\n\t"
+                 : "=r"(cyc_high), "=r"(cyc_low)::"%rax", "%rbx", "%rcx",
+                   "%rdx");
+  return ((uint64_t)cyc_high << 32) | cyc_low;
+#else
+  return harness_ticks_start();
+#endif
+}
+
+static inline uint64_t harness_nanoseconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+// Keeps the compiler from discarding a computation whose result is unused.
+static inline void harness_escape(const void *p) {
+  __asm volatile("" : : "g"(p) : "memory");
+}
+
+static inline void harness_clobber(void) { __asm volatile("" : : : "memory"); }
+
+/////////////////////
+// Hardware counters
+/////////////////////
+
+typedef struct harness_counters {
+  int fd[HARNESS_COUNTER_COUNT];
+  int working;
+} harness_counters;
+
+// Returns 1 if the counters are available. When they are not (no Linux,
+// perf_event_paranoid, virtual machine), we say so once on stderr and
+// the counter metrics are reported as unavailable.
+static inline int harness_counters_open(harness_counters *c) {
+  int i;
+  for (i = 0; i < HARNESS_COUNTER_COUNT; i++) {
+    c->fd[i] = -1;
+  }
+  c->working = 0;
+#ifdef __linux__
+  static const uint64_t configs[HARNESS_COUNTER_COUNT] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_BRANCH_MISSES, PERF_COUNT_HW_CACHE_MISSES};
+  struct perf_event_attr attribs;
+  int group = -1;
+  for (i = 0; i < HARNESS_COUNTER_COUNT; i++) {
+    memset(&attribs, 0, sizeof(attribs));
+    attribs.type = PERF_TYPE_HARDWARE;
+    attribs.size = sizeof(attribs);
+    attribs.config = configs[i];
+    attribs.disabled = 1;
+    attribs.exclude_kernel = 1;
+    attribs.exclude_hv = 1;
+    attribs.read_format = PERF_FORMAT_GROUP;
+    c->fd[i] = (int)syscall(__NR_perf_event_open, &attribs, 0 /* pid */,
+                            -1 /* cpu */, group, 0 /* flags */);
+    if (c->fd[i] == -1) {
+      static int warned = 0;
+      if (!warned) {
+        fprintf(stderr, "harness: perf_event_open: %s (counters disabled)\n",
+                strerror(errno));
+        warned = 1;
+      }
+      for (; i >= 0; i--) {
+        if (c->fd[i] != -1) {
+          close(c->fd[i]);
+        }
+        c->fd[i] = -1;
+      }
+      return 0;
+    }
+    if (group == -1) {
+      group = c->fd[i];
+    }
+  }
+  c->working = 1;
+#endif
+  return c->working;
+}
+
+static inline void harness_counters_close(harness_counters *c) {
+#ifdef __linux__
+  int i;
+  for (i = 0; i < HARNESS_COUNTER_COUNT; i++) {
+    if (c->fd[i] != -1) {
+      close(c->fd[i]);
+    }
+    c->fd[i] = -1;
+  }
+#endif
+  c->working = 0;
+}
+
+static inline void harness_counters_start(harness_counters *c) {
+#ifdef __linux__
+  if (c->working) {
+    ioctl(c->fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(c->fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+  }
+#else
+  (void)c;
+#endif
+}
+
+// Writes HARNESS_COUNTER_COUNT values; zeros if the counters do not work.
+static inline void harness_counters_stop(harness_counters *c, uint64_t *out) {
+  int i;
+#ifdef __linux__
+  if (c->working) {
+    // PERF_FORMAT_GROUP layout: nr, then one value per event
+    uint64_t buffer[HARNESS_COUNTER_COUNT + 1];
+    ioctl(c->fd[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    if (read(c->fd[0], buffer, sizeof(buffer)) == (ssize_t)sizeof(buffer)) {
+      for (i = 0; i < HARNESS_COUNTER_COUNT; i++) {
+        out[i] = buffer[i + 1];
+      }
+      return;
+    }
+  }
+#else
+  (void)c;
+#endif
+  for (i = 0; i < HARNESS_COUNTER_COUNT; i++) {
+    out[i] = 0;
+  }
+}
+
+/////////////////////
+// Runner
+/////////////////////
+
+typedef void (*harness_function)(void *ctx);
+
+typedef struct harness_options {
+  int warmup;   // untimed runs before the measurements
+  int repeat;   // timed runs
+  int counters; // try to use the hardware counters
+  harness_format format;
+} harness_options;
+
+typedef struct harness_sample {
+  uint64_t value[HARNESS_METRIC_COUNT];
+} harness_sample;
+
+typedef struct harness_result {
+  const char *name;
+  size_t volume; // number of items processed by one run (e.g., bytes)
+  int counters;  // whether the hardware counter metrics are meaningful
+  size_t count;
+  harness_sample *samples;
+} harness_result;
+
+static inline harness_format harness_format_from_env(void) {
+  const char *f = getenv("HARNESS_FORMAT");
+  if (f == NULL) {
+    return HARNESS_TEXT;
+  }
+  if (strcmp(f, "csv") == 0) {
+    return HARNESS_CSV;
+  }
+  if (strcmp(f, "json") == 0) {
+    return HARNESS_JSON;
+  }
+  return HARNESS_TEXT;
+}
+
+static inline harness_options harness_default_options(void) {
+  harness_options o;
+  o.warmup = 2;
+  o.repeat = 20;
+  o.counters = 1;
+  o.format = harness_format_from_env();
+  return o;
+}
+
+static inline void harness_measure_once(harness_function f, void *ctx,
+                                        harness_counters *c,
+                                        harness_sample *s) {
+  uint64_t ns, tsc;
+  harness_clobber();
+  harness_counters_start(c);
+  ns = harness_nanoseconds();
+  tsc = harness_ticks_start();
+  f(ctx);
+  tsc = harness_ticks_stop() - tsc;
+  ns = harness_nanoseconds() - ns;
+  harness_counters_stop(c, s->value + HARNESS_FIRST_COUNTER);
+  s->value[HARNESS_NS] = ns;
+  s->value[HARNESS_TSC] = tsc;
+}
+
+static void harness_empty_function(void *ctx) { harness_escape(ctx); }
+
+// Minimal cost of measuring nothing, per metric. It is computed once per
+// process (with and without counters) with the very same code path as the
+// real measurements.
+static inline const harness_sample *harness_overhead(harness_counters *c) {
+  static harness_sample overheads[2];
+  static int computed[2] = {0, 0};
+  harness_sample *overhead = &overheads[c->working ? 1 : 0];
+  if (!computed[c->working ? 1 : 0]) {
+    harness_sample s;
+    int i, m;
+    for (m = 0; m < HARNESS_METRIC_COUNT; m++) {
+      overhead->value[m] = UINT64_MAX;
+    }
+    for (i = 0; i < 1000; i++) {
+      harness_measure_once(harness_empty_function, NULL, c, &s);
+      for (m = 0; m < HARNESS_METRIC_COUNT; m++) {
+        if (s.value[m] < overhead->value[m]) {
+          overhead->value[m] = s.value[m];
+        }
+      }
+    }
+    computed[c->working ? 1 : 0] = 1;
+  }
+  return overhead;
+}
+
+// Runs f(ctx) opts->warmup times, then measures opts->repeat runs. The
+// caller owns r and must release it with harness_result_free. Returns 0 on
+// success, -1 if memory could not be allocated.
+static inline int harness_run(const char *name, size_t volume,
+                              harness_function f, void *ctx,
+                              const harness_options *opts, harness_result *r) {
+  harness_counters c;
+  const harness_sample *overhead;
+  int i, m;
+  int repeat = opts->repeat > 0 ? opts->repeat : 1;
+  r->name = name;
+  r->volume = volume;
+  r->count = 0;
+  r->samples = (harness_sample *)malloc(sizeof(harness_sample) * repeat);
+  if (r->samples == NULL) {
+    return -1;
+  }
+  r->counters = opts->counters ? harness_counters_open(&c) : 0;
+  if (!r->counters) {
+    c.working = 0;
+  }
+  overhead = harness_overhead(&c);
+  for (i = 0; i < opts->warmup; i++) {
+    f(ctx);
+  }
+  for (i = 0; i < repeat; i++) {
+    harness_sample *s = &r->samples[i];
+    harness_measure_once(f, ctx, &c, s);
+    for (m = 0; m < HARNESS_METRIC_COUNT; m++) {
+      s->value[m] =
+          s->value[m] > overhead->value[m] ? s->value[m] - overhead->value[m]
+                                           : 0;
+    }
+  }
+  r->count = (size_t)repeat;
+  if (r->counters) {
+    harness_counters_close(&c);
+  }
+  return 0;
+}
+
+static inline void harness_result_free(harness_result *r) {
+  free(r->samples);
+  r->samples = NULL;
+  r->count = 0;
+}
+
+/////////////////////
+// Statistics
+/////////////////////
+
+static int harness_compare_u64(const void *a, const void *b) {
+  uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+  return (x > y) - (x < y);
+}
+
+// Percentile p in [0,1] of one metric, with linear interpolation between
+// closest ranks: p = 0 is the minimum, p = 0.5 the median.
+static inline double harness_percentile(const harness_result *r,
+                                        harness_metric m, double p) {
+  uint64_t stack_buffer[64];
+  uint64_t *v = stack_buffer;
+  double rank, answer;
+  size_t i, lo;
+  if (r->count == 0) {
+    return 0;
+  }
+  if (r->count > 64) {
+    v = (uint64_t *)malloc(sizeof(uint64_t) * r->count);
+    if (v == NULL) {
+      return 0;
+    }
+  }
+  for (i = 0; i < r->count; i++) {
+    v[i] = r->samples[i].value[m];
+  }
+  qsort(v, r->count, sizeof(uint64_t), harness_compare_u64);
+  if (p < 0) {
+    p = 0;
+  }
+  if (p > 1) {
+    p = 1;
+  }
+  rank = p * (double)(r->count - 1);
+  lo = (size_t)rank;
+  answer = (double)v[lo];
+  if (lo + 1 < r->count) {
+    answer += (rank - (double)lo) * ((double)v[lo + 1] - (double)v[lo]);
+  }
+  if (v != stack_buffer) {
+    free(v);
+  }
+  return answer;
+}
+
+static inline double harness_min(const harness_result *r, harness_metric m) {
+  return harness_percentile(r, m, 0.0);
+}
+
+static inline double harness_median(const harness_result *r,
+                                    harness_metric m) {
+  return harness_percentile(r, m, 0.5);
+}
+
+static inline int harness_metric_available(const harness_result *r,
+                                           harness_metric m) {
+  return m < HARNESS_FIRST_COUNTER || r->counters;
+}
+
+/////////////////////
+// Reporting
+/////////////////////
+
+// Processor brand string, so that saved results say where they came from.
+static inline const char *harness_cpu_name(void) {
+  static char name[49];
+  if (name[0] == '\0') {
+#if defined(__x86_64__)
+    uint32_t regs[12];
+    uint32_t leaf;
+    for (leaf = 0; leaf < 3; leaf++) {
+      uint32_t a = 0x80000002 + leaf, b, c = 0, d;
+      __asm volatile("cpuid" : "+a"(a), "=b"(b), "+c"(c), "=d"(d));
+      regs[4 * leaf] = a;
+      regs[4 * leaf + 1] = b;
+      regs[4 * leaf + 2] = c;
+      regs[4 * leaf + 3] = d;
+    }
+    memcpy(name, regs, 48);
+    name[48] = '\0';
+#else
+    strcpy(name, "unknown");
+#endif
+  }
+  return name;
+}
+
+// Quotes, backslashes and control characters escaped (RFC 8259).
+static inline void harness_print_json_string(FILE *out, const char *s) {
+  fputc('"', out);
+  for (; *s; s++) {
+    switch (*s) {
+    case '"':
+      fputs("\\\"", out);
+      break;
+    case '\\':
+      fputs("\\\\", out);
+      break;
+    case '\n':
+      fputs("\\n", out);
+      break;
+    case '\r':
+      fputs("\\r", out);
+      break;
+    case '\t':
+      fputs("\\t", out);
+      break;
+    default:
+      if ((unsigned char)*s < 0x20) {
+        fprintf(out, "\\u%04x", (unsigned)(unsigned char)*s);
+      } else {
+        fputc(*s, out);
+      }
+    }
+  }
+  fputc('"', out);
+}
+
+// A quoted field, with its quotes doubled (RFC 4180).
+static inline void harness_print_csv_string(FILE *out, const char *s) {
+  fputc('"', out);
+  for (; *s; s++) {
+    if (*s == '"') {
+      fputc('"', out);
+    }
+    fputc(*s, out);
+  }
+  fputc('"', out);
+}
+
+// One JSON object per line (JSON lines), per-item values.
+static inline void harness_print_json(FILE *out, const harness_result *r) {
+  int m;
+  double volume = r->volume ? (double)r->volume : 1.0;
+  fprintf(out, "{\"name\": ");
+  harness_print_json_string(out, r->name);
+  fprintf(out, ", \"cpu\": ");
+  harness_print_json_string(out, harness_cpu_name());
+  fprintf(out, ", \"volume\": %zu, \"repeat\": %zu", r->volume, r->count);
+  for (m = 0; m < HARNESS_METRIC_COUNT; m++) {
+    fprintf(out, ", \"%s\": ", harness_metric_names[m]);
+    if (!harness_metric_available(r, (harness_metric)m)) {
+      fprintf(out, "null");
+      continue;
+    }
+    fprintf(out,
+            "{\"min\": %.4f, \"median\": %.4f, \"p90\": %.4f, "
+            "\"p99\": %.4f}",
+            harness_min(r, (harness_metric)m) / volume,
+            harness_median(r, (harness_metric)m) / volume,
+            harness_percentile(r, (harness_metric)m, 0.90) / volume,
+            harness_percentile(r, (harness_metric)m, 0.99) / volume);
+  }
+  fprintf(out, "}\n");
+}
+
+// CSV: one row per benchmark, min and median per item for every metric.
+// Unavailable counters are left empty.
+static inline void harness_print_csv(FILE *out, const harness_result *r,
+                                     int header) {
+  int m;
+  double volume = r->volume ? (double)r->volume : 1.0;
+  if (header) {
+    fprintf(out, "name,volume,repeat");
+    for (m = 0; m < HARNESS_METRIC_COUNT; m++) {
+      fprintf(out, ",%s_min,%s_median", harness_metric_names[m],
+              harness_metric_names[m]);
+    }
+    fprintf(out, "\n");
+  }
+  harness_print_csv_string(out, r->name);
+  fprintf(out, ",%zu,%zu", r->volume, r->count);
+  for (m = 0; m < HARNESS_METRIC_COUNT; m++) {
+    if (!harness_metric_available(r, (harness_metric)m)) {
+      fprintf(out, ",,");
+      continue;
+    }
+    fprintf(out, ",%.4f,%.4f", harness_min(r, (harness_metric)m) / volume,
+            harness_median(r, (harness_metric)m) / volume);
+  }
+  fprintf(out, "\n");
+}
+
+static inline void harness_print_text(FILE *out, const harness_result *r) {
+  double volume = r->volume ? (double)r->volume : 1.0;
+  fprintf(out, "%-40s: %8.3f ns/item (median %8.3f, p90 %8.3f)", r->name,
+          harness_min(r, HARNESS_NS) / volume,
+          harness_median(r, HARNESS_NS) / volume,
+          harness_percentile(r, HARNESS_NS, 0.90) / volume);
+  if (r->counters) {
+    double cycles = harness_min(r, HARNESS_CYCLES);
+    double instructions = harness_min(r, HARNESS_INSTRUCTIONS);
+    fprintf(out,
+            " %8.3f cycles/item %8.3f ins/item %5.2f ins/cycle"
+            " %8.4f bmiss/item %8.4f cmiss/item",
+            cycles / volume, instructions / volume,
+            cycles > 0 ? instructions / cycles : 0.0,
+            harness_min(r, HARNESS_BRANCH_MISSES) / volume,
+            harness_min(r, HARNESS_CACHE_MISSES) / volume);
+  } else {
+    fprintf(out, " %8.3f tsc/item", harness_min(r, HARNESS_TSC) / volume);
+  }
+  fprintf(out, "\n");
+}
+
+// The CSV header is printed the first time we report in CSV.
+static inline void harness_report(FILE *out, const harness_result *r,
+                                  harness_format format) {
+  static int csv_header_printed = 0;
+  switch (format) {
+  case HARNESS_CSV:
+    harness_print_csv(out, r, !csv_header_printed);
+    csv_header_printed = 1;
+    break;
+  case HARNESS_JSON:
+    harness_print_json(out, r);
+    break;
+  default:
+    harness_print_text(out, r);
+  }
+  fflush(out);
+}
+
+#ifdef __cplusplus
+} // extern "C"
+
+#include <algorithm>
+#include <type_traits>
+
+namespace harness {
+
+typedef harness_options options;
+
+inline options default_options() { return harness_default_options(); }
+
+template <class T> inline void do_not_optimize(const T &value) {
+  __asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Owns the samples of one benchmark.
+class result {
+public:
+  result(const harness_result &raw, harness_format f) : r(raw), format(f) {}
+  result(const result &) = delete;
+  result &operator=(const result &) = delete;
+  result(result &&o) noexcept : r(o.r), format(o.format) {
+    o.r.samples = nullptr;
+    o.r.count = 0;
+  }
+  ~result() { harness_result_free(&r); }
+
+  double min(harness_metric m = HARNESS_NS) const { return harness_min(&r, m); }
+  double median(harness_metric m = HARNESS_NS) const {
+    return harness_median(&r, m);
+  }
+  double percentile(double p, harness_metric m = HARNESS_NS) const {
+    return harness_percentile(&r, m, p);
+  }
+  bool available(harness_metric m) const {
+    return harness_metric_available(&r, m) != 0;
+  }
+  size_t volume() const { return r.volume; }
+  void report(FILE *out = stdout) const { harness_report(out, &r, format); }
+  harness_format report_format() const { return format; }
+  const harness_result &raw() const { return r; }
+
+private:
+  harness_result r;
+  harness_format format;
+};
+
+// Measures f(), which processes 'volume' items per call.
+template <class F>
+result run(const char *name, size_t volume, F &&f,
+           const options &opts = default_options()) {
+  typedef typename std::remove_reference<F>::type function_type;
+  harness_result r;
+  if (harness_run(
+          name, volume,
+          [](void *ctx) { (*static_cast<function_type *>(ctx))(); },
+          const_cast<void *>(static_cast<const void *>(&f)), &opts,
+          &r) != 0) {
+    r.count = 0;
+    r.samples = nullptr;
+  }
+  return result(r, opts.format);
+}
+
+// Measures f() on a fresh copy of input, made in out before each call, as
+// sorts and other in-place work need: the copy is part of the time.
+template <class Container, class F>
+result run_on_copy(const char *name, const Container &input, Container &out,
+                   F &&f, const options &opts = default_options()) {
+  return run(name, input.size(), [&] {
+    std::copy(input.begin(), input.end(), out.begin());
+    f();
+    do_not_optimize(out.data());
+  }, opts);
+}
+
+// A row of a text table: label and name padded to their columns, then the
+// minimum in ns per item. Other formats get the report of r.
+inline void print_row(const char *label, int label_width, int name_width,
+                      const result &r, FILE *out = stdout) {
+  if (r.report_format() != HARNESS_TEXT) {
+    r.report(out);
+    return;
+  }
+  fprintf(out, "%-*s\t%-*s\t%.3f\n", label_width, label, name_width,
+          r.raw().name, r.min() / r.volume());
+}
+
+} // namespace harness
+#endif // __cplusplus
+
+#endif // HARNESS_H
@@ -0,0 +1,270 @@
+// GB/s of hexadecimal text, decoded or encoded: 1 MiB of text at once,
+// and identifiers of 32 and 64 digits (MD5 and SHA-256 hashes) one call
+// each, 16,384 of them. The baselines are functions of
+// 2019/04/17/hexparse.cpp that decode one word, called over the whole
+// text: hex_to_u32_lookup and hex_to_u32_lookup_mayeut (4 digits with
+// tables of digits, which check them), hex_2bytes_lookup (2 digits at a
+// time in a table of 65,536 entries, which checks them too),
+// hex_to_u32_lee and hex_to_u64_sse_ver2 (arithmetic on 4 digits, SSSE3
+// on 16, neither checking). Then each back end, which checks.
+#include "hexcodec.h"
+
+#include "../harness/harness.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <tmmintrin.h>
+#include <vector>
+
+namespace {
+
+const hexcodec::backend backends[] = {hexcodec::backend::scalar,
+                                      hexcodec::backend::avx2,
+                                      hexcodec::backend::avx512};
+
+// The tables of hexparse.cpp, built here: digittoval, digittoval32 (the
+// value shifted by 12, 8, 4 and 0 bits at offsets 630, 420, 210 and 0,
+// 0xFFFFFFFF elsewhere) and lookup2 (two digits, as a 16-bit word).
+signed char digittoval[256];
+uint32_t digittoval32[886];
+uint32_t lookup2[65536];
+
+void init_tables() {
+  memset(digittoval, -1, sizeof(digittoval));
+  memset(digittoval32, 0xff, sizeof(digittoval32));
+  for (uint32_t i = 0; i < 65536; i++) {
+    lookup2[i] = uint32_t(-1);
+  }
+  const char *digits[] = {"0123456789abcdef", "0123456789ABCDEF"};
+  for (const char *d : digits) {
+    for (uint32_t v = 0; v < 16; v++) {
+      const uint8_t c = uint8_t(d[v]);
+      digittoval[c] = (signed char)v;
+      digittoval32[630 + c] = v << 12;
+      digittoval32[420 + c] = v << 8;
+      digittoval32[210 + c] = v << 4;
+      digittoval32[c] = v;
+    }
+  }
+  for (const char *high : digits) {
+    for (const char *low : digits) {
+      for (uint32_t v = 0; v < 256; v++) {
+        const uint8_t pair[2] = {uint8_t(high[v >> 4]), uint8_t(low[v & 15])};
+        uint16_t word;
+        memcpy(&word, pair, sizeof(word));
+        lookup2[word] = v;
+      }
+    }
+  }
+}
+
+// the high 16 bits set if not valid
+uint32_t hex_to_u32_lookup(const uint8_t *src) {
+  uint32_t v1 = digittoval[src[0]];
+  uint32_t v2 = digittoval[src[1]];
+  uint32_t v3 = digittoval[src[2]];
+  uint32_t v4 = digittoval[src[3]];
+  return static_cast<uint32_t>(v1 << 12 | v2 << 8 | v3 << 4 | v4);
+}
+
+uint32_t hex_to_u32_lookup_mayeut(const uint8_t *src) {
+  uint32_t v1 = static_cast<uint32_t>(digittoval32[630 + src[0]]);
+  uint32_t v2 = static_cast<uint32_t>(digittoval32[420 + src[1]]);
+  uint32_t v3 = static_cast<uint32_t>(digittoval32[210 + src[2]]);
+  uint32_t v4 = static_cast<uint32_t>(digittoval32[0 + src[3]]);
+  return v1 | v2 | v3 | v4;
+}
+
+uint32_t hex_2bytes_lookup(const uint8_t *src) {
+  uint16_t s12;
+  memcpy(&s12, src, sizeof(uint16_t));
+  uint32_t v1 = lookup2[s12];
+  uint16_t s34;
+  memcpy(&s34, src + 2, sizeof(uint16_t));
+  uint32_t v2 = lookup2[s34];
+  return v1 << 8 | v2;
+}
+
+// no error checking
+uint32_t hex_to_u32_lee(const uint8_t *src) {
+  uint32_t val;
+  memcpy(&val, src, 4);
+  val = (val & 0xf0f0f0f) + 9 * (val >> 6 & 0x1010101);
+  val = (val | val << 12) & 0xff00ff00;
+  return (val >> 24 | val) & 0xffff;
+}
+
+// no error checking (the error vector is computed and not used)
+uint64_t hex_to_u64_sse_ver2(const uint8_t *string) {
+  __m128i input = _mm_loadu_si128((const __m128i *)string);
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  const __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(input, 4), mask);
+  const __m128i lo_nibbles = _mm_and_si128(input, mask);
+  const __m128i upper_bound =
+      _mm_setr_epi8(-1, -1, -1, 9, 6, -1, 6, -1, -1, -1, -1, -1, -1, -1, -1,
+                    -1);
+  const __m128i hi = _mm_shuffle_epi8(upper_bound, hi_nibbles);
+  const __m128i shift = _mm_andnot_si128(hi, _mm_set1_epi8(9));
+  const __m128i result = _mm_add_epi8(lo_nibbles, shift);
+  const __m128i t3 = _mm_maddubs_epi16(result, _mm_set1_epi16(0x0110));
+  const __m128i t5 =
+      _mm_shuffle_epi8(t3, _mm_setr_epi8(14, 12, 10, 8, 6, 4, 2, 0, -1, -1, -1,
+                                         -1, -1, -1, -1, -1));
+  return _mm_cvtsi128_si64(t5);
+}
+
+// F over the text, 4 digits to 2 bytes; whether no word had an error bit
+template <uint32_t (*F)(const uint8_t *)>
+bool words(const uint8_t *in, size_t n, uint8_t *out) {
+  uint32_t error = 0;
+  for (size_t i = 0; i + 4 <= n; i += 4) {
+    const uint32_t v = F(in + i);
+    error |= v;
+    out[i / 2] = uint8_t(v >> 8);
+    out[i / 2 + 1] = uint8_t(v);
+  }
+  return (error >> 16) == 0;
+}
+
+bool sse_words(const uint8_t *in, size_t n, uint8_t *out) {
+  for (size_t i = 0; i + 16 <= n; i += 16) {
+    const uint64_t v = __builtin_bswap64(hex_to_u64_sse_ver2(in + i));
+    memcpy(out + i / 2, &v, sizeof(v));
+  }
+  return true;
+}
+
+struct decoder {
+  const char *name;
+  bool (*decode)(const uint8_t *in, size_t n, uint8_t *out);
+  bool checks;
+};
+
+const decoder baselines[] = {
+    {"lookup", words<hex_to_u32_lookup>, true},
+    {"mayeut", words<hex_to_u32_lookup_mayeut>, true},
+    {"2 bytes", words<hex_2bytes_lookup>, true},
+    {"lee", words<hex_to_u32_lee>, false},
+    {"sse ver2", sse_words, false}};
+
+// GB/s of text for f(), run over bytes of text
+template <class F>
+double time(const char *name, size_t bytes, F f, harness::options &opts) {
+  auto r = harness::run(name, bytes, f, opts);
+  if (opts.format != HARNESS_TEXT) {
+    r.report();
+  }
+  return bytes / r.min();
+}
+
+void print(const char *row, const double *gbs, int count) {
+  printf("%-20s", row);
+  for (int k = 0; k < count; k++) {
+    if (gbs[k] == 0) {
+      printf("\t%8s", "-");
+    } else {
+      printf("\t%8.2f", gbs[k]);
+    }
+  }
+  printf("\n");
+}
+
+// digits per call: the whole text, or identifiers of that many digits
+bool run(const char *row, const std::string &text, size_t digits,
+         harness::options &opts) {
+  bool ok = true;
+  const size_t n = text.size();
+  const uint8_t *in = reinterpret_cast<const uint8_t *>(text.data());
+  std::vector<uint8_t> out(n / 2 + 16), reference(n / 2);
+  hexcodec::decode(text.data(), n, reference.data());
+  double gbs[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  int k = 0;
+  for (const decoder &d : baselines) {
+    gbs[k++] = time(d.name, n, [&] {
+      bool valid = true;
+      for (size_t i = 0; i < n; i += digits) {
+        valid &= d.decode(in + i, digits, out.data() + i / 2);
+      }
+      harness::do_not_optimize(valid);
+      ok = ok && valid;
+    }, opts);
+    ok = ok && memcmp(out.data(), reference.data(), n / 2) == 0;
+  }
+  for (hexcodec::backend b : backends) {
+    hexcodec::options o;
+    o.kernel = b;
+    if (hexcodec::backend_supported(b)) {
+      gbs[k] = time(hexcodec::backend_name(b), n, [&] {
+        bool valid = true;
+        for (size_t i = 0; i < n; i += digits) {
+          valid &= hexcodec::decode(text.data() + i, digits,
+                                    out.data() + i / 2, o)
+                       .valid;
+        }
+        harness::do_not_optimize(valid);
+        ok = ok && valid;
+      }, opts);
+      ok = ok && memcmp(out.data(), reference.data(), n / 2) == 0;
+    }
+    k++;
+  }
+  if (opts.format == HARNESS_TEXT) {
+    print(row, gbs, k);
+  }
+  // and back
+  std::vector<char> encoded(n + 64);
+  double encoding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+  for (int j = 0; j < 3; j++) {
+    hexcodec::options o;
+    o.kernel = backends[j];
+    if (hexcodec::backend_supported(o.kernel)) {
+      encoding[5 + j] = time("encode", n, [&] {
+        for (size_t i = 0; i < n / 2; i += digits / 2) {
+          hexcodec::encode(reference.data() + i, digits / 2,
+                           encoded.data() + 2 * i, o);
+        }
+      }, opts);
+      ok = ok && memcmp(encoded.data(), text.data(), n) == 0;
+    }
+  }
+  if (opts.format == HARNESS_TEXT) {
+    const std::string encode_row =
+        std::string("encode") + (row + strlen("decode"));
+    print(encode_row.c_str(), encoding, 8);
+  }
+  return ok;
+}
+
+} // namespace
+
+int main() {
+  init_tables();
+  std::mt19937_64 gen(1234);
+  harness::options opts = harness::default_options();
+  opts.repeat = 50;
+  // in lower case, as most tools write them
+  std::string text(size_t(1) << 20, '0');
+  for (char &c : text) {
+    c = "0123456789abcdef"[gen() % 16];
+  }
+  if (opts.format == HARNESS_TEXT) {
+    printf("GB/s of text, best back end: %s\n",
+           hexcodec::backend_name(hexcodec::active_backend()));
+    printf("%-20s", "");
+    for (const decoder &d : baselines) {
+      printf("\t%8s", d.name);
+    }
+    printf("\t%8s\t%8s\t%8s\n", "scalar", "avx2", "avx512");
+  }
+  bool ok = run("decode, 1 MiB", text, text.size(), opts);
+  ok = run("decode, 32 digits", text.substr(0, 32 << 14), 32, opts) && ok;
+  ok = run("decode, 64 digits", text.substr(0, 64 << 14), 64, opts) && ok;
+  if (!ok) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+// Runtime dispatch and the scalar back end.
+#include "hexcodec.h"
+#include "hexcodec_kernels.h"
+
+#include "../isa/dispatch.h"
+
+namespace hexcodec {
+
+namespace {
+
+struct implementation {
+  backend kind;
+  const char *name;
+  uint32_t required_instruction_sets;
+  const functions &(*table)();
+};
+
+const implementation scalar = {backend::scalar, "scalar", 0,
+                               scalar_functions};
+const implementation avx2 = {backend::avx2, "avx2", instruction_set::AVX2,
+                             avx2_functions};
+const implementation avx512 = {
+    backend::avx512, "avx512",
+    instruction_set::AVX512 | instruction_set::AVX512VBMI, avx512_functions};
+
+const implementation *const implementations[] = {&avx512, &avx2, &scalar};
+
+const implementation *best() {
+  static const implementation *best =
+      isa::first_supported(implementations, &scalar);
+  return best;
+}
+
+// nullptr if unknown or unsupported
+const implementation *find(backend kind) {
+  if (kind == backend::automatic) {
+    return best();
+  }
+  return isa::find(implementations, kind);
+}
+
+// The functions of each back end, nullptr if unsupported, found once: an
+// identifier is 32 or 64 digits, and the calls many.
+const functions *table(backend kind) {
+  struct tables {
+    const functions *of[4];
+
+    tables() {
+      for (int k = 0; k < 4; k++) {
+        const implementation *impl = find(backend(k));
+        of[k] = impl == nullptr ? nullptr : &impl->table();
+      }
+    }
+  };
+  static const tables t;
+  return unsigned(kind) < 4 ? t.of[unsigned(kind)] : nullptr;
+}
+
+size_t scalar_decode(const uint8_t *in, size_t n, uint8_t *out) {
+  return decode_words(in, 0, n, out);
+}
+
+void scalar_encode(const uint8_t *in, size_t n, char *out,
+                   const char *digits) {
+  encode_bytes(in, 0, n, out, digits);
+}
+
+} // namespace
+
+const functions &scalar_functions() {
+  static const functions scalar = {scalar_decode, scalar_encode};
+  return scalar;
+}
+
+bool backend_supported(backend b) { return find(b) != nullptr; }
+
+backend active_backend() { return best()->kind; }
+
+const char *backend_name(backend b) {
+  if (b == backend::automatic) {
+    return best()->name;
+  }
+  return isa::name_of(implementations, b);
+}
+
+result decode(const char *in, size_t n, uint8_t *out, const options &o) {
+  const functions *f = table(o.kernel);
+  if (f == nullptr) {
+    return {false, 0, 0};
+  }
+  const size_t pairs = n & ~size_t(1);
+  const size_t end =
+      f->decode(reinterpret_cast<const uint8_t *>(in), pairs, out);
+  if (end < pairs) {
+    return {false, end, end / 2};
+  }
+  if (pairs < n) {
+    // a digit without its pair
+    return {false, pairs, pairs / 2};
+  }
+  return {true, n, n / 2};
+}
+
+size_t encode(const uint8_t *in, size_t n, char *out, const options &o) {
+  const functions *f = table(o.kernel);
+  if (f == nullptr) {
+    return 0;
+  }
+  f->encode(in, n, out, o.upper_case ? "0123456789ABCDEF" : "0123456789abcdef");
+  return 2 * n;
+}
+
+} // namespace hexcodec
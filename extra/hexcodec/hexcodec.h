@@ -0,0 +1,79 @@
+// Hexadecimal text to bytes and back, for buffers of any length, with
+// AVX2 or AVX-512 picked at runtime: decoding takes both cases, even
+// mixed, and reports the offset of the first character that is not a
+// hexadecimal digit.
+//
+// 2019/04/17/hexparse.cpp times functions that decode one word: 4 digits
+// with tables (hex_to_u32_lookup, hex_to_u32_lookup_mayeut,
+// hex_2bytes_lookup), with arithmetic (hex_to_u32_mula, with pext), or 16
+// digits with SSE (hex_to_u64_sse_ver2, after Wojciech Muła). The AVX2
+// back end is hex_to_u64_sse_ver2 over 32 digits at a time: the high
+// nibble of each character picks, with a shuffle, the bounds of its low
+// nibble, which validates it, and the value follows from the low nibble;
+// a multiply-add joins the nibbles. The AVX-512 back end looks the 64
+// characters of a vector up in a table of the 128 ASCII characters with
+// one byte permutation (VBMI). The scalar back end checks 8 characters
+// in a 64-bit word and converts them as hex_to_u32_lee does; it finishes
+// what the vectors leave, and where it finds an error looks each
+// character up in digittoval, as hex_to_u32_lookup does. Encoding splits
+// each byte into nibbles and looks them up in the 16 digits with a
+// shuffle.
+//
+//   uint8_t id[16];
+//   hexcodec::result r = hexcodec::decode(text, 32, id);
+//   if (!r.valid) printf("not hexadecimal at %zu\n", r.error);
+//   char back[32];
+//   hexcodec::encode(id, 16, back);
+#ifndef HEXCODEC_H
+#define HEXCODEC_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace hexcodec {
+
+struct functions; // of a back end, in hexcodec_kernels.h
+
+enum class backend {
+  automatic, // best supported one
+  scalar,
+  avx2,
+  avx512 // with VBMI (Ice Lake and up)
+};
+
+// Whether the back end can run on this processor, and its name.
+bool backend_supported(backend b);
+backend active_backend();
+const char *backend_name(backend b);
+
+struct options {
+  // 'A' to 'F' instead of 'a' to 'f' when encoding; decoding takes both.
+  bool upper_case = false;
+  backend kernel = backend::automatic;
+};
+
+struct result {
+  bool valid;
+  // When invalid, the offset of the first character that is not a
+  // hexadecimal digit, or n - 1 when n is odd and all others are digits;
+  // otherwise n.
+  size_t error;
+  // Bytes written: n / 2, or, when invalid, those of the pairs of digits
+  // before the error (error / 2).
+  size_t count;
+};
+
+// Decodes in[0, n) into out[0, n / 2), two digits to a byte, the first
+// the high nibble. out may be in (decoding in place). An unsupported back
+// end writes nothing and gives an error at 0.
+result decode(const char *in, size_t n, uint8_t *out,
+              const options &o = options());
+
+// Encodes in[0, n) into out[0, 2 n) and returns 2 n. An unsupported back
+// end writes nothing and returns 0.
+size_t encode(const uint8_t *in, size_t n, char *out,
+              const options &o = options());
+
+} // namespace hexcodec
+
+#endif // HEXCODEC_H
@@ -0,0 +1,122 @@
+// The AVX2 back end: hex_to_u64_sse_ver2 of 2019/04/17/hexparse.cpp (after
+// Wojciech Muła) over two vectors of 32 digits at a time. A vector with an
+// error goes to the scalar loop from its start, which finds the exact
+// offset and writes the pairs before it; so do the last digits. Encoding
+// goes 32 bytes at a time. Compiled with -mavx2.
+#include "hexcodec_kernels.h"
+
+#include <immintrin.h>
+
+namespace hexcodec {
+namespace {
+
+__m256i load(const uint8_t *p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
+void store(void *p, __m256i v) {
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+}
+
+// The 32 digits at p as nibbles, in 16-bit lanes with the first digit
+// high (16 a + b for the digits a, b), and whether they all are digits.
+__m256i nibble_pairs(const uint8_t *p, __m256i *error) {
+  const __m256i input = load(p);
+  const __m256i mask = _mm256_set1_epi8(0x0f);
+  const __m256i high_nibbles =
+      _mm256_and_si256(_mm256_srli_epi16(input, 4), mask);
+  const __m256i low_nibbles = _mm256_and_si256(input, mask);
+  // by the high nibble, the bounds of the low one: 0x30 for '0' to '9',
+  // 0x40 and 0x60 for 'A' to 'F' and 'a' to 'f'; none for the others
+  // (0xff is -1, below any low nibble)
+  const __m256i lower_bound = _mm256_setr_epi8(
+      -1, -1, -1, 0, 1, -1, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      0, 1, -1, 1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m256i upper_bound = _mm256_setr_epi8(
+      -1, -1, -1, 9, 6, -1, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+      9, 6, -1, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+  const __m256i lo = _mm256_shuffle_epi8(lower_bound, high_nibbles);
+  const __m256i hi = _mm256_shuffle_epi8(upper_bound, high_nibbles);
+  *error = _mm256_or_si256(
+      *error, _mm256_or_si256(_mm256_cmpgt_epi8(low_nibbles, hi),
+                              _mm256_cmpgt_epi8(lo, low_nibbles)));
+  // hi is 9 for digits, which stay as they are, and 6 for letters, which
+  // take 9 more: ~hi & 9
+  const __m256i values = _mm256_add_epi8(
+      low_nibbles, _mm256_andnot_si256(hi, _mm256_set1_epi8(9)));
+  return _mm256_maddubs_epi16(values, _mm256_set1_epi16(0x0110));
+}
+
+size_t avx2_decode(const uint8_t *in, size_t n, uint8_t *out) {
+  size_t i = 0;
+  for (; i + 64 <= n; i += 64) {
+    __m256i error = _mm256_setzero_si256();
+    const __m256i first = nibble_pairs(in + i, &error);
+    const __m256i second = nibble_pairs(in + i + 32, &error);
+    if (!_mm256_testz_si256(error, error)) {
+      break;
+    }
+    // the bytes of each 128-bit lane, then the lanes in order
+    const __m256i bytes = _mm256_permute4x64_epi64(
+        _mm256_packus_epi16(first, second), 0xd8);
+    store(out + i / 2, bytes);
+  }
+  // one more vector, for identifiers of 32 digits
+  if (i + 32 <= n) {
+    __m256i error = _mm256_setzero_si256();
+    const __m256i pairs = nibble_pairs(in + i, &error);
+    if (_mm256_testz_si256(error, error)) {
+      const __m256i bytes = _mm256_permute4x64_epi64(
+          _mm256_packus_epi16(pairs, pairs), 0xd8);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i / 2),
+                       _mm256_castsi256_si128(bytes));
+      i += 32;
+    }
+  }
+  return decode_words(in, i, n, out);
+}
+
+void avx2_encode(const uint8_t *in, size_t n, char *out,
+                 const char *digits) {
+  const __m256i table = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(digits)));
+  const __m256i mask = _mm256_set1_epi8(0x0f);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    const __m256i input = load(in + i);
+    const __m256i high = _mm256_shuffle_epi8(
+        table, _mm256_and_si256(_mm256_srli_epi16(input, 4), mask));
+    const __m256i low =
+        _mm256_shuffle_epi8(table, _mm256_and_si256(input, mask));
+    // bytes 0 to 7 and 16 to 23, then 8 to 15 and 24 to 31
+    const __m256i first = _mm256_unpacklo_epi8(high, low);
+    const __m256i second = _mm256_unpackhi_epi8(high, low);
+    store(out + 2 * i, _mm256_permute2x128_si256(first, second, 0x20));
+    store(out + 2 * i + 32, _mm256_permute2x128_si256(first, second, 0x31));
+  }
+  if (i + 16 <= n) {
+    const __m128i input =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+    const __m128i digits_table = _mm256_castsi256_si128(table);
+    const __m128i high = _mm_shuffle_epi8(
+        digits_table,
+        _mm_and_si128(_mm_srli_epi16(input, 4), _mm_set1_epi8(0x0f)));
+    const __m128i low = _mm_shuffle_epi8(
+        digits_table, _mm_and_si128(input, _mm_set1_epi8(0x0f)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i),
+                     _mm_unpacklo_epi8(high, low));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 2 * i + 16),
+                     _mm_unpackhi_epi8(high, low));
+    i += 16;
+  }
+  encode_bytes(in, i, n, out, digits);
+}
+
+} // namespace
+
+const functions &avx2_functions() {
+  static const functions avx2 = {avx2_decode, avx2_encode};
+  return avx2;
+}
+
+} // namespace hexcodec
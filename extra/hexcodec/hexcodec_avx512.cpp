@@ -0,0 +1,104 @@
+// The AVX-512 back end: each of 64 characters is looked up in a table of
+// the 128 ASCII characters (the value of a digit, 0x80 for the others)
+// with one byte permutation (VBMI), characters from 0x80 on being errors
+// as they are; a multiply-add joins the nibbles and vpmovwb packs them.
+// The last characters go through masked loads and stores. A vector with
+// an error goes to the scalar loop from its start, which finds the exact
+// offset. Compiled with -mavx512f -mavx512bw -mavx512vl -mavx512vbmi.
+#include "hexcodec_kernels.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+
+namespace hexcodec {
+namespace {
+
+// the values of the ASCII characters: 0x80 for those not digits
+struct ascii_values {
+  uint8_t of[128];
+
+  constexpr ascii_values() : of() {
+    for (int c = 0; c < 128; c++) {
+      of[c] = digit_value.of[c] < 0 ? 0x80 : uint8_t(digit_value.of[c]);
+    }
+  }
+};
+
+constexpr ascii_values ascii_value{};
+
+__mmask64 first(size_t count) {
+  return count == 0 ? 0 : ~__mmask64(0) >> (64 - count);
+}
+
+// The 64 digits of input as bytes (16 a + b for the digits a, b) in
+// order, and the characters that are not digits.
+__m256i decode_vector(__m512i input, __mmask64 *error) {
+  const __m512i table_low = _mm512_loadu_si512(ascii_value.of);
+  const __m512i table_high = _mm512_loadu_si512(ascii_value.of + 64);
+  const __m512i values =
+      _mm512_permutex2var_epi8(table_low, input, table_high);
+  *error = _mm512_movepi8_mask(_mm512_or_si512(values, input));
+  return _mm512_cvtepi16_epi8(
+      _mm512_maddubs_epi16(values, _mm512_set1_epi16(0x0110)));
+}
+
+size_t avx512_decode(const uint8_t *in, size_t n, uint8_t *out) {
+  size_t i = 0;
+  __mmask64 error;
+  for (; i + 64 <= n; i += 64) {
+    const __m256i bytes = decode_vector(_mm512_loadu_si512(in + i), &error);
+    if (error != 0) {
+      return decode_pairs(in, i, n, out);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i / 2), bytes);
+  }
+  const __mmask64 rest = first(n - i);
+  const __m256i bytes =
+      decode_vector(_mm512_maskz_loadu_epi8(rest, in + i), &error);
+  if ((error & rest) != 0) {
+    return decode_pairs(in, i, n, out);
+  }
+  _mm256_mask_storeu_epi8(out + i / 2, __mmask32(first((n - i) / 2)), bytes);
+  return n;
+}
+
+// The 32 bytes of input as 64 digits.
+__m512i encode_vector(__m256i input, __m512i table) {
+  // each byte in a 16-bit lane: the high nibble in the low byte, the low
+  // nibble in the high byte, as the digits go in memory
+  const __m512i words = _mm512_cvtepu8_epi16(input);
+  const __m512i nibbles = _mm512_or_si512(
+      _mm512_srli_epi16(words, 4),
+      _mm512_slli_epi16(_mm512_and_si512(words, _mm512_set1_epi16(0x0f)), 8));
+  return _mm512_shuffle_epi8(table, nibbles);
+}
+
+void avx512_encode(const uint8_t *in, size_t n, char *out,
+                   const char *digits) {
+  const __m512i table = _mm512_broadcast_i32x4(
+      _mm_loadu_si128(reinterpret_cast<const __m128i *>(digits)));
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    _mm512_storeu_si512(
+        out + 2 * i,
+        encode_vector(_mm256_loadu_si256(
+                          reinterpret_cast<const __m256i *>(in + i)),
+                      table));
+  }
+  const __mmask32 rest = __mmask32(first(n - i));
+  _mm512_mask_storeu_epi8(
+      out + 2 * i, first(2 * (n - i)),
+      encode_vector(_mm256_maskz_loadu_epi8(rest, in + i), table));
+}
+
+} // namespace
+
+const functions &avx512_functions() {
+  static const functions avx512 = {avx512_decode, avx512_encode};
+  return avx512;
+}
+
+} // namespace hexcodec
@@ -0,0 +1,135 @@
+// The functions of each back end, and the tables and scalar loops that
+// all of them share. Only the hexcodec*.cpp files include this header.
+#ifndef HEXCODEC_KERNELS_H
+#define HEXCODEC_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "hexcodec.h"
+
+namespace hexcodec {
+
+struct functions {
+  // in[0, n), n even: the offset of the first character that is not a
+  // digit, or n; the pairs before it are written to out.
+  size_t (*decode)(const uint8_t *in, size_t n, uint8_t *out);
+  // digits: the 16 digits, in lower or upper case
+  void (*encode)(const uint8_t *in, size_t n, char *out,
+                 const char *digits);
+};
+
+const functions &scalar_functions();
+const functions &avx2_functions();
+const functions &avx512_functions();
+
+// In an unnamed namespace: each back end compiles its own copy with its
+// own instruction sets, so that the linker cannot pick the AVX2 copy for
+// the scalar back end.
+namespace {
+
+// digittoval of 2019/04/17/hexparse.cpp: the value of a digit, -1 for
+// other characters
+struct digit_values {
+  int8_t of[256];
+
+  constexpr digit_values() : of() {
+    for (int c = 0; c < 256; c++) {
+      of[c] = c >= '0' && c <= '9'   ? int8_t(c - '0')
+              : c >= 'a' && c <= 'f' ? int8_t(c - 'a' + 10)
+              : c >= 'A' && c <= 'F' ? int8_t(c - 'A' + 10)
+                                     : int8_t(-1);
+    }
+  }
+};
+
+constexpr digit_values digit_value{};
+
+// Pairs in[i, n) one at a time, for what the vectors leave and where they
+// found an error.
+inline size_t decode_pairs(const uint8_t *in, size_t i, size_t n,
+                           uint8_t *out) {
+  for (; i < n; i += 2) {
+    const int high = digit_value.of[in[i]];
+    const int low = digit_value.of[in[i + 1]];
+    if ((high | low) < 0) {
+      return high < 0 ? i : i + 1;
+    }
+    out[i / 2] = uint8_t(high << 4 | low);
+  }
+  return n;
+}
+
+constexpr uint64_t packed_byte(uint8_t b) {
+  // replicate the byte 8 times
+  return uint64_t(b) * uint64_t(0x0101010101010101);
+}
+
+// 0x80 in the bytes of chars from first to last, from extra/asciicase
+inline uint64_t in_range(uint64_t chars, uint8_t first, uint8_t last) {
+  const uint64_t ascii_chars = chars & packed_byte(0x7f);
+  const uint64_t from_first = ascii_chars + packed_byte(uint8_t(128 - first));
+  const uint64_t after_last =
+      ascii_chars + packed_byte(uint8_t(128 - last - 1));
+  return (from_first ^ after_last) & ~chars & packed_byte(0x80);
+}
+
+// 8 digits at a time in a word, then pairs: checked with the ranges above
+// ('A' to 'F' and 'a' to 'f' are both 'a' to 'f' with bit 5 set), and
+// converted with the arithmetic of hex_to_u32_lee, which adds 9 to the low
+// nibble of letters.
+inline size_t decode_words(const uint8_t *in, size_t i, size_t n,
+                           uint8_t *out) {
+  for (; i + 8 <= n; i += 8) {
+    uint64_t chars;
+    memcpy(&chars, in + i, sizeof(chars));
+    const uint64_t digits = in_range(chars, '0', '9') |
+                            in_range(chars | packed_byte(0x20), 'a', 'f');
+    if (digits != packed_byte(0x80)) {
+      break;
+    }
+    const uint64_t nibbles = (chars & packed_byte(0x0f)) +
+                             9 * ((chars >> 6) & packed_byte(0x01));
+    // the first nibble of each pair high, in the even bytes, then packed
+    uint64_t bytes = ((nibbles << 4) | (nibbles >> 8)) & 0x00ff00ff00ff00ff;
+    bytes = (bytes | (bytes >> 8)) & 0x0000ffff0000ffff;
+    bytes = bytes | (bytes >> 16);
+    const uint32_t packed = uint32_t(bytes);
+    memcpy(out + i / 2, &packed, sizeof(packed));
+  }
+  return decode_pairs(in, i, n, out);
+}
+
+// 4 bytes at a time in a word, with digits[10] - '0' - 10 added to the
+// nibbles from 10 on, then one at a time.
+inline void encode_bytes(const uint8_t *in, size_t i, size_t n, char *out,
+                         const char *digits) {
+  const uint64_t letter = uint8_t(digits[10] - '0' - 10);
+  for (; i + 4 <= n; i += 4) {
+    uint32_t four;
+    memcpy(&four, in + i, sizeof(four));
+    // byte k in the 16-bit lane k
+    uint64_t lanes = (uint64_t(four) | (uint64_t(four) << 16)) &
+                     0x0000ffff0000ffff;
+    lanes = (lanes | (lanes << 8)) & 0x00ff00ff00ff00ff;
+    // the high nibble first in memory
+    const uint64_t nibbles = ((lanes >> 4) & 0x000f000f000f000f) |
+                             ((lanes & 0x000f000f000f000f) << 8);
+    const uint64_t above_nine =
+        ((nibbles + packed_byte(6)) >> 4) & packed_byte(0x01);
+    const uint64_t chars =
+        nibbles + packed_byte('0') + above_nine * letter;
+    memcpy(out + 2 * i, &chars, sizeof(chars));
+  }
+  for (; i < n; i++) {
+    out[2 * i] = digits[in[i] >> 4];
+    out[2 * i + 1] = digits[in[i] & 0xf];
+  }
+}
+
+} // namespace
+
+} // namespace hexcodec
+
+#endif // HEXCODEC_KERNELS_H
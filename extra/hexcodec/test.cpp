@@ -0,0 +1,162 @@
+// Checks of every back end at every length up to 300 and on longer
+// buffers: encoding in both cases against snprintf, decoding in random
+// case back to the bytes, in place too, and every one of the 256 byte
+// values at every offset of buffers up to a vector and more, which must
+// give the offset of the error and the bytes before it, or none; and odd
+// lengths.
+#include "hexcodec.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const hexcodec::backend backends[] = {
+    hexcodec::backend::automatic, hexcodec::backend::scalar,
+    hexcodec::backend::avx2, hexcodec::backend::avx512};
+
+std::mt19937_64 gen(1234);
+
+// memcmp, but not of the null pointers of empty vectors
+bool same_bytes(const void *x, const void *y, size_t n) {
+  return n == 0 || memcmp(x, y, n) == 0;
+}
+
+bool is_digit(char c) {
+  return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') ||
+         (c >= 'A' && c <= 'F');
+}
+
+std::string expected_encoding(const std::vector<uint8_t> &bytes,
+                              bool upper_case) {
+  std::string s;
+  char buffer[3];
+  for (uint8_t b : bytes) {
+    snprintf(buffer, sizeof(buffer), upper_case ? "%02X" : "%02x", b);
+    s += buffer;
+  }
+  return s;
+}
+
+bool check_round_trip(size_t n, hexcodec::backend b) {
+  hexcodec::options o;
+  o.kernel = b;
+  std::vector<uint8_t> bytes(n);
+  for (uint8_t &x : bytes) {
+    x = uint8_t(gen());
+  }
+  for (bool upper_case : {false, true}) {
+    o.upper_case = upper_case;
+    std::string text(2 * n + 64, '#');
+    if (hexcodec::encode(bytes.data(), n, &text[0], o) != 2 * n ||
+        text.substr(0, 2 * n) != expected_encoding(bytes, upper_case) ||
+        text.find_first_not_of('#', 2 * n) != std::string::npos) {
+      printf("bug: encoding %zu bytes, upper case %d\n", n, upper_case);
+      return false;
+    }
+  }
+  std::string text = expected_encoding(bytes, false);
+  for (char &c : text) {
+    if (c >= 'a' && gen() % 2) {
+      c = char(c - 32);
+    }
+  }
+  std::vector<uint8_t> out(n + 64, 0xee);
+  hexcodec::result r = hexcodec::decode(text.data(), 2 * n, out.data(), o);
+  bool ok = r.valid && r.error == 2 * n && r.count == n &&
+            same_bytes(out.data(), bytes.data(), n) && out[n] == 0xee;
+  // in place
+  std::string copy = text;
+  r = hexcodec::decode(copy.data(), 2 * n,
+                       reinterpret_cast<uint8_t *>(&copy[0]), o);
+  ok = ok && r.valid && same_bytes(copy.data(), bytes.data(), n);
+  if (!ok) {
+    printf("bug: decoding %zu bytes\n", n);
+  }
+  return ok;
+}
+
+// c at offset k of random digits of length n
+bool check_error(size_t n, size_t k, uint8_t c, hexcodec::backend b) {
+  hexcodec::options o;
+  o.kernel = b;
+  std::string text(n, '0');
+  for (char &x : text) {
+    x = "0123456789abcdefABCDEF"[gen() % 22];
+  }
+  text[k] = char(c);
+  std::vector<uint8_t> out(n / 2 + 1), reference(n / 2 + 1);
+  const hexcodec::result r = hexcodec::decode(text.data(), n, out.data(), o);
+  // what the scalar loop of the reference would do
+  size_t error = n;
+  for (size_t i = 0; i < n; i++) {
+    if (!is_digit(text[i])) {
+      error = i;
+      break;
+    }
+  }
+  if (error == n && n % 2 == 1) {
+    error = n - 1;
+  }
+  const bool valid = error == n;
+  for (size_t i = 0; i + 1 < error; i += 2) {
+    reference[i / 2] = uint8_t(std::stoi(text.substr(i, 2), nullptr, 16));
+  }
+  if (r.valid != valid || r.error != error || r.count != error / 2 ||
+      !same_bytes(out.data(), reference.data(), error / 2)) {
+    printf("bug: %s, byte 0x%02x at %zu of %zu gives %d, error %zu, %zu "
+           "bytes\n",
+           hexcodec::backend_name(b), c, k, n, r.valid, r.error, r.count);
+    return false;
+  }
+  return true;
+}
+
+bool check_backend(hexcodec::backend b) {
+  for (size_t n = 0; n <= 300; n++) {
+    if (!check_round_trip(n, b)) {
+      return false;
+    }
+  }
+  for (size_t n : {1000, 4096, 100000}) {
+    if (!check_round_trip(n, b)) {
+      return false;
+    }
+  }
+  for (size_t n = 1; n <= 300; n++) {
+    // every byte value at every offset up to a vector and a bit more, and
+    // around two and four vectors; elsewhere one at random
+    const bool all = n <= 80 || n == 127 || n == 128 || n == 129 ||
+                     n == 255 || n == 256;
+    for (size_t k = 0; k < n; k++) {
+      for (int c = 0; c < 256; c++) {
+        if (!check_error(n, k, all ? uint8_t(c) : uint8_t(gen()), b)) {
+          return false;
+        }
+        if (!all) {
+          break;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main() {
+  printf("best back end: %s\n",
+         hexcodec::backend_name(hexcodec::active_backend()));
+  for (hexcodec::backend b : backends) {
+    if (hexcodec::backend_supported(b) && !check_backend(b)) {
+      printf("bug!\n");
+      return EXIT_FAILURE;
+    }
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
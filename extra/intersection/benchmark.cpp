@@ -0,0 +1,97 @@
+// Intersection speed per algorithm and size ratio, in ns per value of the
+// small list, for random lists drawn from [0, 2^26), then a k-way
+// intersection.
+#include "intersection.h"
+
+#include "../harness/harness.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+static std::vector<uint32_t> random_list(size_t n, std::mt19937 &gen) {
+  std::uniform_int_distribution<uint32_t> draw(0, (1U << 26) - 1);
+  std::vector<uint32_t> list(n);
+  for (auto &v : list) {
+    v = draw(gen);
+  }
+  std::sort(list.begin(), list.end());
+  list.erase(std::unique(list.begin(), list.end()), list.end());
+  return list;
+}
+
+int main(int argc, char **argv) {
+  size_t large_size = argc > 1 ? size_t(atoll(argv[1])) : 1U << 20;
+  std::mt19937 gen(1234);
+  const intersection_algorithm algorithms[] = {
+      INTERSECTION_MERGE, INTERSECTION_SIMD, INTERSECTION_GALLOPING,
+      INTERSECTION_GROUPED_GALLOPING, INTERSECTION_AUTO};
+  harness::options opts = harness::default_options();
+  printf("large list: %zu values, simd back end: %s\n", large_size,
+         intersection_simd_backend());
+  printf("ratio\talgorithm        \tns/value of the small list\n");
+  const std::vector<uint32_t> large = random_list(large_size, gen);
+  std::vector<uint32_t> out(large.size());
+  for (size_t ratio = 1; ratio <= 4096 && ratio <= large_size; ratio *= 2) {
+    const std::vector<uint32_t> small = random_list(large_size / ratio, gen);
+    const size_t expected =
+        intersection_with(INTERSECTION_MERGE, small.data(), small.size(),
+                          large.data(), large.size(), nullptr);
+    for (intersection_algorithm algo : algorithms) {
+      if (!intersection_algorithm_supported(algo)) {
+        continue;
+      }
+      size_t size = 0;
+      auto r = harness::run(intersection_algorithm_name(algo), small.size(),
+                            [&] {
+        size = intersection_with(algo, small.data(), small.size(),
+                                 large.data(), large.size(), out.data());
+        harness::do_not_optimize(size);
+      }, opts);
+      if (size != expected) {
+        printf("bug!\n");
+        return EXIT_FAILURE;
+      }
+      if (opts.format == HARNESS_TEXT) {
+        printf("%zu\t%-17s\t%.3f\n", ratio, intersection_algorithm_name(algo),
+               r.min() / small.size());
+      } else {
+        r.report();
+      }
+    }
+  }
+  // k-way: lists of decreasing sizes, given in random order
+  std::vector<std::vector<uint32_t>> lists;
+  for (size_t n = large_size; n >= large_size / 64 && n > 0; n /= 4) {
+    lists.push_back(random_list(n, gen));
+  }
+  std::shuffle(lists.begin(), lists.end(), gen);
+  std::vector<const uint32_t *> pointers;
+  std::vector<size_t> sizes;
+  size_t total = 0;
+  for (const auto &list : lists) {
+    pointers.push_back(list.data());
+    sizes.push_back(list.size());
+    total += list.size();
+  }
+  auto many = harness::run("many", total, [&] {
+    size_t size = intersection_many(pointers.data(), sizes.data(),
+                                    lists.size(), out.data());
+    harness::do_not_optimize(size);
+  }, opts);
+  auto counting = harness::run("many (count)", total, [&] {
+    size_t size = intersection_many(pointers.data(), sizes.data(),
+                                    lists.size(), nullptr);
+    harness::do_not_optimize(size);
+  }, opts);
+  if (opts.format == HARNESS_TEXT) {
+    printf("%zu-way intersection: %.3f ns/value, counting: %.3f ns/value\n",
+           lists.size(), many.min() / total, counting.min() / total);
+  } else {
+    many.report();
+    counting.report();
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,205 @@
+// Runtime dispatch of the SIMD back ends, if this processor has any, the
+// choice of algorithm and the k-way intersection.
+#include "intersection.h"
+#include "intersection_kernels.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "../isa/dispatch.h"
+
+namespace intersections {
+namespace {
+
+struct implementation {
+  const char *name;
+  uint32_t required_instruction_sets;
+  simd_function (*function)();
+};
+
+const implementation avx512 = {"avx512", instruction_set::AVX512F,
+                               avx512_intersect};
+const implementation avx2 = {"avx2", instruction_set::AVX2, avx2_intersect};
+
+const implementation *const simd_implementations[] = {&avx512, &avx2};
+
+// nullptr when no back end is supported
+const implementation *best_simd() {
+  static const implementation *best =
+      isa::first_supported(simd_implementations);
+  return best;
+}
+
+// Size ratios (large over small) from which INTERSECTION_AUTO prefers grouped
+// galloping to the SIMD blocks or to the merge; measured with ./benchmark on
+// random lists (see the README). With fewer than four values in the small
+// list, there is no group to form and plain galloping is as good.
+constexpr size_t simd_ratio = 12;
+constexpr size_t merge_ratio = 2;
+constexpr size_t group = 4;
+
+template <class Sink>
+void run(intersection_algorithm algorithm, const uint32_t *a, size_t na,
+         const uint32_t *b, size_t nb, Sink &sink) {
+  // the galloping algorithms walk the small list
+  const bool swap = nb < na;
+  const uint32_t *small = swap ? b : a, *large = swap ? a : b;
+  const size_t ns = swap ? nb : na, nl = swap ? na : nb;
+  switch (algorithm) {
+  case INTERSECTION_GALLOPING:
+    gallop_from(small, ns, 0, large, nl, 0, sink);
+    break;
+  case INTERSECTION_GROUPED_GALLOPING:
+    grouped_gallop(small, ns, large, nl, sink);
+    break;
+  default:
+    merge_from(a, na, 0, b, nb, 0, sink);
+    break;
+  }
+}
+
+size_t pairwise(intersection_algorithm algorithm, const uint32_t *a,
+                size_t na, const uint32_t *b, size_t nb, uint32_t *out) {
+  if (algorithm == INTERSECTION_AUTO) {
+    algorithm = intersection_choose(na, nb);
+  }
+  if (na == 0 || nb == 0) {
+    return 0;
+  }
+  if (algorithm == INTERSECTION_SIMD) {
+    return best_simd()->function()(a, na, b, nb, out);
+  }
+  if (out == nullptr) {
+    counter sink = {0};
+    run(algorithm, a, na, b, nb, sink);
+    return sink.size();
+  }
+  writer sink = {out, 0};
+  run(algorithm, a, na, b, nb, sink);
+  return sink.size();
+}
+
+} // namespace
+} // namespace intersections
+
+using namespace intersections;
+
+extern "C" {
+
+intersection_algorithm intersection_choose(size_t na, size_t nb) {
+  const size_t small = std::min(na, nb), large = std::max(na, nb);
+  if (small < group) {
+    return INTERSECTION_GALLOPING;
+  }
+  const bool simd = best_simd() != nullptr;
+  if (large / small >= (simd ? simd_ratio : merge_ratio)) {
+    return INTERSECTION_GROUPED_GALLOPING;
+  }
+  return simd ? INTERSECTION_SIMD : INTERSECTION_MERGE;
+}
+
+int intersection_algorithm_supported(intersection_algorithm algorithm) {
+  switch (algorithm) {
+  case INTERSECTION_AUTO:
+  case INTERSECTION_MERGE:
+  case INTERSECTION_GALLOPING:
+  case INTERSECTION_GROUPED_GALLOPING:
+    return 1;
+  case INTERSECTION_SIMD:
+    return best_simd() != nullptr;
+  }
+  return 0;
+}
+
+const char *intersection_algorithm_name(intersection_algorithm algorithm) {
+  switch (algorithm) {
+  case INTERSECTION_AUTO:
+    return "auto";
+  case INTERSECTION_MERGE:
+    return "merge";
+  case INTERSECTION_SIMD:
+    return "simd";
+  case INTERSECTION_GALLOPING:
+    return "galloping";
+  case INTERSECTION_GROUPED_GALLOPING:
+    return "grouped galloping";
+  }
+  return "unknown";
+}
+
+const char *intersection_simd_backend(void) {
+  return best_simd() != nullptr ? best_simd()->name : "none";
+}
+
+size_t intersection_with(intersection_algorithm algorithm, const uint32_t *a,
+                         size_t na, const uint32_t *b, size_t nb,
+                         uint32_t *out) {
+  if (!intersection_algorithm_supported(algorithm)) {
+    return size_t(-1);
+  }
+  return pairwise(algorithm, a, na, b, nb, out);
+}
+
+size_t intersection(const uint32_t *a, size_t na, const uint32_t *b,
+                    size_t nb, uint32_t *out) {
+  return pairwise(INTERSECTION_AUTO, a, na, b, nb, out);
+}
+
+size_t intersection_count(const uint32_t *a, size_t na, const uint32_t *b,
+                          size_t nb) {
+  return pairwise(INTERSECTION_AUTO, a, na, b, nb, nullptr);
+}
+
+size_t intersection_many(const uint32_t *const *lists, const size_t *sizes,
+                         size_t k, uint32_t *out) {
+  if (k == 0) {
+    return 0;
+  }
+  // smallest first: every step is then as skewed as it can be, and the
+  // running result only shrinks
+  std::vector<size_t> order(k);
+  for (size_t i = 0; i < k; i++) {
+    order[i] = i;
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [sizes](size_t x, size_t y) { return sizes[x] < sizes[y]; });
+  const uint32_t *first = lists[order[0]];
+  size_t size = sizes[order[0]];
+  if (k == 1) {
+    if (out != nullptr && out != first) {
+      std::copy(first, first + size, out);
+    }
+    return size;
+  }
+  if (k == 2) {
+    return pairwise(INTERSECTION_AUTO, first, size, lists[order[1]],
+                    sizes[order[1]], out);
+  }
+  // Counting still needs the intermediate results; only the last step can
+  // skip the stores.
+  uint32_t *buffer = out;
+  if (buffer == nullptr) {
+    buffer = static_cast<uint32_t *>(malloc(std::max<size_t>(size, 1) *
+                                            sizeof(uint32_t)));
+    if (buffer == nullptr) {
+      return size_t(-1);
+    }
+  }
+  const uint32_t *current = first;
+  for (size_t i = 1; i + 1 < k && size != 0; i++) {
+    size = pairwise(INTERSECTION_AUTO, current, size, lists[order[i]],
+                    sizes[order[i]], buffer);
+    current = buffer;
+  }
+  if (size != 0) {
+    size = pairwise(INTERSECTION_AUTO, current, size, lists[order[k - 1]],
+                    sizes[order[k - 1]], out);
+  }
+  if (out == nullptr) {
+    free(buffer);
+  }
+  return size;
+}
+
+} // extern "C"
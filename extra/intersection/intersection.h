@@ -0,0 +1,75 @@
+// Intersection of sorted arrays of distinct 32-bit integers (posting
+// lists).
+//
+// The right algorithm depends on how the sizes compare:
+//
+//  - merge: the plain two-pointer walk, for lists of similar sizes;
+//  - simd: compare blocks of 8 (AVX2) or 16 (AVX-512) values all against
+//    all, and skip the block with the smallest maximum, also for lists of
+//    similar sizes, with the best back end picked at runtime;
+//  - galloping: for each value of the small list, an exponential then
+//    binary search in the large one (advanceUntil of
+//    extra/setoperations/intersections/groupedgalloping.c);
+//  - grouped galloping: the same, four values of the small list at a time
+//    with interleaved branch-free binary searches (binarySearch4 and
+//    batched_intersect_skewed_uint16 of that file), for very skewed sizes.
+//
+// INTERSECTION_AUTO picks one from the size ratio. The k-way intersection
+// starts from the two smallest lists and intersects the result with the
+// others, from the smallest to the largest.
+//
+// All functions are usable from C and from C++.
+#ifndef INTERSECTION_H
+#define INTERSECTION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum intersection_algorithm {
+  INTERSECTION_AUTO = 0,
+  INTERSECTION_MERGE,
+  INTERSECTION_SIMD,
+  INTERSECTION_GALLOPING,
+  INTERSECTION_GROUPED_GALLOPING
+} intersection_algorithm;
+
+// Writes the values common to a and b into out, which must have room for
+// min(na, nb) values and may be a or b itself. With out == NULL, only
+// counts. Returns the number of common values.
+size_t intersection(const uint32_t *a, size_t na, const uint32_t *b,
+                    size_t nb, uint32_t *out);
+size_t intersection_count(const uint32_t *a, size_t na, const uint32_t *b,
+                          size_t nb);
+
+// Same with an explicit algorithm; (size_t)-1 if it is not supported by this
+// processor.
+size_t intersection_with(intersection_algorithm algorithm, const uint32_t *a,
+                         size_t na, const uint32_t *b, size_t nb,
+                         uint32_t *out);
+
+// Intersection of the k lists (lists[i] has sizes[i] values). out must have
+// room for the size of the smallest list and may be that list; with
+// out == NULL, only counts. Returns the number of common values, or
+// (size_t)-1 if a temporary buffer cannot be allocated (count only).
+// With k == 0 the result is empty.
+size_t intersection_many(const uint32_t *const *lists, const size_t *sizes,
+                         size_t k, uint32_t *out);
+
+// Algorithm INTERSECTION_AUTO uses for lists of these sizes.
+intersection_algorithm intersection_choose(size_t na, size_t nb);
+
+int intersection_algorithm_supported(intersection_algorithm algorithm);
+const char *intersection_algorithm_name(intersection_algorithm algorithm);
+
+// Back end of INTERSECTION_SIMD: "avx512", "avx2" or "none".
+const char *intersection_simd_backend(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif // INTERSECTION_H
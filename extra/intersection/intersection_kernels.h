@@ -0,0 +1,186 @@
+// Pairwise intersection kernels. Only the intersection*.cpp files include
+// this header: the SIMD block kernels are compiled with their own -m flags.
+//
+// Every kernel takes a sink, which either writes the common values or only
+// counts them, so that the count-only mode costs no stores:
+//
+//   void add(uint32_t value);        // one common value
+//   uint32_t *reserve();             // where the next values go (or nullptr)
+//   void advance(size_t count);      // count values were written there
+//   size_t size() const;
+//
+// Writing is always behind reading: the output may be the first input.
+#ifndef INTERSECTION_KERNELS_H
+#define INTERSECTION_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "intersection.h"
+
+namespace intersections {
+
+struct writer {
+  uint32_t *out;
+  size_t pos;
+  void add(uint32_t value) { out[pos++] = value; }
+  uint32_t *reserve() { return out + pos; }
+  void advance(size_t count) { pos += count; }
+  size_t size() const { return pos; }
+};
+
+struct counter {
+  size_t pos;
+  void add(uint32_t) { pos++; }
+  uint32_t *reserve() { return nullptr; }
+  void advance(size_t count) { pos += count; }
+  size_t size() const { return pos; }
+};
+
+// The remaining values from a[ia], b[ib] on: a merge with few branches.
+template <class Sink>
+inline void merge_from(const uint32_t *a, size_t na, size_t ia,
+                       const uint32_t *b, size_t nb, size_t ib, Sink &sink) {
+  while (ia < na && ib < nb) {
+    const uint32_t va = a[ia], vb = b[ib];
+    if (va == vb) {
+      sink.add(va);
+    }
+    ia += va <= vb;
+    ib += vb <= va;
+  }
+}
+
+// Position of the first value >= min after pos, or length
+// (advanceUntil of groupedgalloping.c).
+inline size_t advance_until(const uint32_t *array, size_t pos, size_t length,
+                            uint32_t min) {
+  size_t lower = pos + 1;
+  if (lower >= length || array[lower] >= min) {
+    return lower;
+  }
+  size_t spansize = 1;
+  while (lower + spansize < length && array[lower + spansize] < min) {
+    spansize <<= 1;
+  }
+  size_t upper = lower + spansize < length ? lower + spansize : length - 1;
+  if (array[upper] == min) {
+    return upper;
+  }
+  if (array[upper] < min) {
+    return length;
+  }
+  // we know that the next-smallest span was too small
+  lower += spansize >> 1;
+  while (lower + 1 != upper) {
+    const size_t mid = (lower + upper) >> 1;
+    if (array[mid] == min) {
+      return mid;
+    } else if (array[mid] < min) {
+      lower = mid;
+    } else {
+      upper = mid;
+    }
+  }
+  return upper;
+}
+
+// intersect_skewed_uint16 of groupedgalloping.c, from small[is], large[il].
+template <class Sink>
+inline void gallop_from(const uint32_t *small, size_t ns, size_t is,
+                        const uint32_t *large, size_t nl, size_t il,
+                        Sink &sink) {
+  if (is >= ns || il >= nl) {
+    return;
+  }
+  uint32_t vl = large[il], vs = small[is];
+  for (;;) {
+    if (vl < vs) {
+      il = advance_until(large, il, nl, vs);
+      if (il == nl) {
+        break;
+      }
+      vl = large[il];
+    } else if (vs < vl) {
+      if (++is == ns) {
+        break;
+      }
+      vs = small[is];
+    } else {
+      sink.add(vs);
+      if (++is == ns) {
+        break;
+      }
+      vs = small[is];
+      il = advance_until(large, il, nl, vs);
+      if (il == nl) {
+        break;
+      }
+      vl = large[il];
+    }
+  }
+}
+
+// batched_intersect_skewed_uint16 of groupedgalloping.c: four branch-free
+// binary searches in lockstep (binarySearch4), so that their cache misses
+// overlap. Unlike there, the searches do not span the rest of the large
+// list: we first gallop to the lower bound of the last value of the group,
+// which bounds the window of all four. The values after the group are
+// larger, so the window of the next group starts at that lower bound.
+template <class Sink>
+inline void grouped_gallop(const uint32_t *small, size_t ns,
+                           const uint32_t *large, size_t nl, Sink &sink) {
+  size_t is = 0, il = 0;
+  while (is + 4 <= ns && il < nl) {
+    const uint32_t t0 = small[is], t1 = small[is + 1], t2 = small[is + 2],
+                   t3 = small[is + 3];
+    const uint32_t *base = large + il;
+    const uint32_t *b0 = base, *b1 = base, *b2 = base, *b3 = base;
+    const size_t left = nl - il;
+    // the window: the first span such that base[span - 1] >= t3, or left
+    size_t n = 1;
+    while (n < left && base[n - 1] < t3) {
+      n <<= 1;
+    }
+    n = n < left ? n : left;
+    while (n > 1) {
+      const size_t half = n >> 1;
+      b0 = (b0[half] < t0) ? b0 + half : b0;
+      b1 = (b1[half] < t1) ? b1 + half : b1;
+      b2 = (b2[half] < t2) ? b2 + half : b2;
+      b3 = (b3[half] < t3) ? b3 + half : b3;
+      n -= half;
+    }
+    const size_t i0 = size_t(*b0 < t0) + size_t(b0 - base);
+    const size_t i1 = size_t(*b1 < t1) + size_t(b1 - base);
+    const size_t i2 = size_t(*b2 < t2) + size_t(b2 - base);
+    const size_t i3 = size_t(*b3 < t3) + size_t(b3 - base);
+    if (i0 < left && base[i0] == t0) {
+      sink.add(t0);
+    }
+    if (i1 < left && base[i1] == t1) {
+      sink.add(t1);
+    }
+    if (i2 < left && base[i2] == t2) {
+      sink.add(t2);
+    }
+    if (i3 < left && base[i3] == t3) {
+      sink.add(t3);
+    }
+    is += 4;
+    il += i3 < left ? i3 : left;
+  }
+  gallop_from(small, ns, is, large, nl, il, sink);
+}
+
+// SIMD block kernels (intersection_avx2.cpp, intersection_avx512.cpp); with
+// out == nullptr, they only count.
+typedef size_t (*simd_function)(const uint32_t *a, size_t na,
+                                const uint32_t *b, size_t nb, uint32_t *out);
+
+simd_function avx2_intersect();
+simd_function avx512_intersect();
+
+} // namespace intersections
+
+#endif // INTERSECTION_KERNELS_H
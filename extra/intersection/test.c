@@ -0,0 +1,173 @@
+// Checks of the intersections, through the C interface: every algorithm on
+// lists of various sizes and overlaps, into a separate buffer, in place and
+// counting only, then k-way intersections.
+#include "intersection.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const intersection_algorithm algorithms[] = {
+    INTERSECTION_AUTO, INTERSECTION_MERGE, INTERSECTION_SIMD,
+    INTERSECTION_GALLOPING, INTERSECTION_GROUPED_GALLOPING};
+
+// n distinct sorted values, each of [0, universe) kept with probability
+// about n / universe
+static size_t fill(uint32_t *list, size_t n, uint32_t universe) {
+  size_t size = 0;
+  uint32_t v;
+  for (v = 0; v < universe && size < n; v++) {
+    if ((size_t)rand() % universe < n) {
+      list[size++] = v;
+    }
+  }
+  return size;
+}
+
+static size_t reference(const uint32_t *a, size_t na, const uint32_t *b,
+                        size_t nb, uint32_t *out) {
+  size_t i = 0, j = 0, pos = 0;
+  while (i < na && j < nb) {
+    if (a[i] < b[j]) {
+      i++;
+    } else if (b[j] < a[i]) {
+      j++;
+    } else {
+      out[pos++] = a[i];
+      i++;
+      j++;
+    }
+  }
+  return pos;
+}
+
+static int same(const uint32_t *x, size_t nx, const uint32_t *y, size_t ny) {
+  return nx == ny && (nx == 0 || memcmp(x, y, nx * sizeof(uint32_t)) == 0);
+}
+
+static int check_pair(const uint32_t *a, size_t na, const uint32_t *b,
+                      size_t nb) {
+  size_t smaller = na < nb ? na : nb;
+  uint32_t *expected = (uint32_t *)malloc((smaller + 1) * sizeof(uint32_t));
+  uint32_t *out = (uint32_t *)malloc((smaller + 1) * sizeof(uint32_t));
+  uint32_t *copy = (uint32_t *)malloc((na + nb + 1) * sizeof(uint32_t));
+  size_t count = reference(a, na, b, nb, expected), k, size;
+  int ok = 1;
+  for (k = 0; ok && k < sizeof(algorithms) / sizeof(algorithms[0]); k++) {
+    const intersection_algorithm algo = algorithms[k];
+    if (!intersection_algorithm_supported(algo)) {
+      continue;
+    }
+    size = intersection_with(algo, a, na, b, nb, out);
+    ok = same(out, size, expected, count);
+    if (ok) {
+      ok = intersection_with(algo, a, na, b, nb, NULL) == count;
+    }
+    if (ok) { // in place, over a copy of either list
+      memcpy(copy, a, na * sizeof(uint32_t));
+      size = intersection_with(algo, copy, na, b, nb, copy);
+      ok = same(copy, size, expected, count);
+    }
+    if (ok) {
+      memcpy(copy, b, nb * sizeof(uint32_t));
+      size = intersection_with(algo, a, na, copy, nb, copy);
+      ok = same(copy, size, expected, count);
+    }
+    if (!ok) {
+      printf("bad %s intersection, sizes %zu and %zu\n",
+             intersection_algorithm_name(algo), na, nb);
+    }
+  }
+  if (ok && intersection_count(a, na, b, nb) != count) {
+    printf("bad count, sizes %zu and %zu\n", na, nb);
+    ok = 0;
+  }
+  free(expected);
+  free(out);
+  free(copy);
+  return ok;
+}
+
+static int check_many(size_t k, uint32_t universe) {
+  uint32_t **lists = (uint32_t **)malloc(k * sizeof(uint32_t *));
+  size_t *sizes = (size_t *)malloc(k * sizeof(size_t));
+  uint32_t *expected, *out;
+  size_t i, count, size, smallest = 0;
+  int ok;
+  for (i = 0; i < k; i++) {
+    size_t n = (size_t)(rand() % 5000) + 1;
+    if (rand() % 4 == 0) {
+      n = (size_t)(rand() % 50);
+    }
+    lists[i] = (uint32_t *)malloc((n + 1) * sizeof(uint32_t));
+    sizes[i] = fill(lists[i], n, universe);
+    if (sizes[i] < sizes[smallest]) {
+      smallest = i;
+    }
+  }
+  expected = (uint32_t *)malloc((sizes[0] + 1) * sizeof(uint32_t));
+  out = (uint32_t *)malloc((sizes[smallest] + 1) * sizeof(uint32_t));
+  memcpy(expected, lists[0], sizes[0] * sizeof(uint32_t));
+  count = sizes[0];
+  for (i = 1; i < k; i++) {
+    count = reference(expected, count, lists[i], sizes[i], expected);
+  }
+  size = intersection_many((const uint32_t *const *)lists, sizes, k, out);
+  ok = same(out, size, expected, count);
+  if (ok) {
+    ok = intersection_many((const uint32_t *const *)lists, sizes, k, NULL) ==
+         count;
+  }
+  if (ok) { // in place, over the smallest list
+    size = intersection_many((const uint32_t *const *)lists, sizes, k,
+                             lists[smallest]);
+    ok = same(lists[smallest], size, expected, count);
+  }
+  if (!ok) {
+    printf("bad %zu-way intersection\n", k);
+  }
+  for (i = 0; i < k; i++) {
+    free(lists[i]);
+  }
+  free(lists);
+  free(sizes);
+  free(expected);
+  free(out);
+  return ok;
+}
+
+int main(void) {
+  static const size_t sizes[] = {0, 1, 3, 8, 15, 16, 17, 100, 1000, 20000};
+  static const uint32_t universes[] = {64, 1000, 100000};
+  size_t i, j, u, k;
+  printf("simd back end: %s\n", intersection_simd_backend());
+  for (u = 0; u < sizeof(universes) / sizeof(universes[0]); u++) {
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+      for (j = 0; j < sizeof(sizes) / sizeof(sizes[0]); j++) {
+        uint32_t *a = (uint32_t *)malloc((sizes[i] + 1) * sizeof(uint32_t));
+        uint32_t *b = (uint32_t *)malloc((sizes[j] + 1) * sizeof(uint32_t));
+        size_t na = fill(a, sizes[i], universes[u]);
+        size_t nb = fill(b, sizes[j], universes[u]);
+        int ok = check_pair(a, na, b, nb);
+        free(a);
+        free(b);
+        if (!ok) {
+          return EXIT_FAILURE;
+        }
+      }
+    }
+  }
+  for (k = 0; k < 200; k++) {
+    if (!check_many(k % 6 + 1, k % 2 ? 100000 : 10000)) {
+      return EXIT_FAILURE;
+    }
+  }
+  if (intersection_many(NULL, NULL, 0, NULL) != 0 ||
+      intersection_with((intersection_algorithm)42, NULL, 0, NULL, 0, NULL) !=
+          (size_t)-1) {
+    printf("bad edge cases\n");
+    return EXIT_FAILURE;
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,153 @@
+// Nanoseconds per number, over arrays of 16,384 numbers written with a
+// comma between them: snprintf and std::to_chars one number at a time as
+// the baselines, then each back end, then the length alone. The numbers:
+// random 64-bit words (almost all of 19 or 20 digits), 64-bit numbers of
+// 1 to 20 digits (as many of each length, so that the length is not
+// predictable), timestamps in milliseconds (13 digits), identifiers under
+// a million, and signed numbers of 1 to 9 digits (32 bits) and of 1 to
+// 18 (64 bits).
+#include "intformat.h"
+
+#include "../harness/harness.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const intformat::backend backends[] = {intformat::backend::scalar,
+                                       intformat::backend::avx2,
+                                       intformat::backend::avx512};
+
+constexpr size_t count = 16384;
+
+// ns per number of f(), which returns the bytes written
+template <class F>
+double time(const char *name, size_t expected, F f, harness::options &opts,
+            bool *ok) {
+  auto r = harness::run(name, expected, [&] {
+    const size_t bytes = f();
+    *ok = *ok && bytes == expected;
+    harness::do_not_optimize(bytes);
+  }, opts);
+  if (opts.format != HARNESS_TEXT) {
+    r.report();
+  }
+  return r.min() / count;
+}
+
+const char *conversion(uint32_t) { return "%" PRIu32; }
+const char *conversion(int32_t) { return "%" PRId32; }
+const char *conversion(uint64_t) { return "%" PRIu64; }
+const char *conversion(int64_t) { return "%" PRId64; }
+
+template <class T>
+bool run(const char *name, const std::vector<T> &values,
+         harness::options &opts) {
+  bool ok = true;
+  const size_t n = values.size();
+  const size_t expected = intformat::length(values.data(), n);
+  std::vector<char> out(intformat::max_length(n) + 32);
+  // snprintf, to_chars, three back ends, length
+  double ns[6] = {0, 0, 0, 0, 0, 0};
+  ns[0] = time("snprintf", expected, [&] {
+    char *p = out.data();
+    for (size_t i = 0; i < n; i++) {
+      p += snprintf(p, 24, conversion(values[i]), values[i]);
+      *p++ = ',';
+    }
+    return size_t(p - out.data()) - 1;
+  }, opts, &ok);
+  ns[1] = time("to_chars", expected, [&] {
+    char *p = out.data();
+    char *const end = p + out.size();
+    for (size_t i = 0; i < n; i++) {
+      p = std::to_chars(p, end, values[i]).ptr;
+      *p++ = ',';
+    }
+    return size_t(p - out.data()) - 1;
+  }, opts, &ok);
+  const std::string reference(out.data(), expected);
+  for (int j = 0; j < 3; j++) {
+    intformat::options o;
+    o.kernel = backends[j];
+    if (!intformat::backend_supported(o.kernel)) {
+      continue;
+    }
+    ns[j + 2] = time(intformat::backend_name(o.kernel), expected, [&] {
+      return intformat::format(values.data(), n, out.data(), o);
+    }, opts, &ok);
+    ok = ok && reference.compare(0, expected, out.data(), expected) == 0;
+  }
+  ns[5] = time("length", expected, [&] {
+    return intformat::length(values.data(), n);
+  }, opts, &ok);
+  if (opts.format == HARNESS_TEXT) {
+    printf("%-12s\t%6.2f", name, double(expected) / n - 1);
+    for (double t : ns) {
+      if (t == 0) {
+        printf("\t%8s", "-");
+      } else {
+        printf("\t%8.2f", t);
+      }
+    }
+    printf("\n");
+  }
+  return ok;
+}
+
+// a number of that many digits, the first not zero
+uint64_t random_digits(int digits, std::mt19937_64 &gen) {
+  uint64_t x = 1 + gen() % 9;
+  for (int d = 1; d < digits; d++) {
+    x = x * 10 + gen() % 10;
+  }
+  return x;
+}
+
+} // namespace
+
+int main() {
+  std::mt19937_64 gen(1234);
+  harness::options opts = harness::default_options();
+  opts.repeat = 50;
+  std::vector<uint64_t> words(count), lengths(count), timestamps(count);
+  std::vector<uint32_t> ids(count);
+  std::vector<int32_t> signed32(count);
+  std::vector<int64_t> signed64(count);
+  for (size_t i = 0; i < count; i++) {
+    words[i] = gen();
+    lengths[i] = random_digits(1 + int(i % 20), gen);
+    timestamps[i] = 1600000000000 + gen() % 100000000000;
+    ids[i] = uint32_t(gen() % 1000000);
+    const int32_t x = int32_t(random_digits(1 + int(gen() % 9), gen));
+    signed32[i] = gen() % 2 ? -x : x;
+    const int64_t y = int64_t(random_digits(1 + int(gen() % 18), gen));
+    signed64[i] = gen() % 2 ? -y : y;
+  }
+  std::shuffle(lengths.begin(), lengths.end(), gen);
+  if (opts.format == HARNESS_TEXT) {
+    printf("ns per number, best back end: %s\n",
+           intformat::backend_name(intformat::active_backend()));
+    printf("%-12s\t%6s\t%8s\t%8s\t%8s\t%8s\t%8s\t%8s\n", "numbers", "bytes",
+           "snprintf", "to_chars", "scalar", "avx2", "avx512", "length");
+  }
+  bool ok = run("uint64", words, opts);
+  ok = run("1-20 digits", lengths, opts) && ok;
+  ok = run("timestamps", timestamps, opts) && ok;
+  ok = run("ids", ids, opts) && ok;
+  ok = run("int32", signed32, opts) && ok;
+  ok = run("int64", signed64, opts) && ok;
+  if (!ok) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,137 @@
+// Runtime dispatch, the scalar (SWAR) back end and the lengths.
+#include "intformat.h"
+#include "intformat_kernels.h"
+
+#include "../isa/dispatch.h"
+
+namespace intformat {
+
+namespace {
+
+struct implementation {
+  backend kind;
+  const char *name;
+  uint32_t required_instruction_sets;
+  const functions &(*table)();
+};
+
+const implementation scalar = {backend::scalar, "scalar", 0,
+                               scalar_functions};
+const implementation avx2 = {backend::avx2, "avx2", instruction_set::AVX2,
+                             avx2_functions};
+const implementation avx512 = {backend::avx512, "avx512",
+                               instruction_set::AVX512F |
+                                   instruction_set::AVX512IFMA |
+                                   instruction_set::AVX512VBMI,
+                               avx512_functions};
+
+const implementation *const implementations[] = {&avx512, &avx2, &scalar};
+
+const implementation *best() {
+  static const implementation *best =
+      isa::first_supported(implementations, &scalar);
+  return best;
+}
+
+// nullptr if unknown or unsupported
+const implementation *find(backend kind) {
+  if (kind == backend::automatic) {
+    return best();
+  }
+  return isa::find(implementations, kind);
+}
+
+// The functions of each back end, nullptr if unsupported, found once: a
+// row of a table may be only a few numbers, and the calls many.
+const functions *table(backend kind) {
+  struct tables {
+    const functions *of[4];
+
+    tables() {
+      for (int k = 0; k < 4; k++) {
+        const implementation *impl = find(backend(k));
+        of[k] = impl == nullptr ? nullptr : &impl->table();
+      }
+    }
+  };
+  static const tables t;
+  return unsigned(kind) < 4 ? t.of[unsigned(kind)] : nullptr;
+}
+
+int width(uint32_t x) { return digit_count(x); }
+int width(uint64_t x) { return digit_count(x); }
+int width(int32_t x) { return (x < 0) + digit_count(magnitude(x)); }
+int width(int64_t x) { return (x < 0) + digit_count(magnitude(x)); }
+
+template <class T>
+size_t total_length(const T *values, size_t n, const options &o) {
+  if (n == 0) {
+    return 0;
+  }
+  size_t total = n - 1 + o.terminate;
+  for (size_t i = 0; i < n; i++) {
+    total += size_t(width(values[i]));
+  }
+  return total;
+}
+
+} // namespace
+
+const functions &scalar_functions() {
+  return formatters<scalar_writer>::table();
+}
+
+bool backend_supported(backend b) { return find(b) != nullptr; }
+
+backend active_backend() { return best()->kind; }
+
+const char *backend_name(backend b) {
+  if (b == backend::automatic) {
+    return best()->name;
+  }
+  return isa::name_of(implementations, b);
+}
+
+size_t length(const uint32_t *values, size_t n, const options &o) {
+  return total_length(values, n, o);
+}
+
+size_t length(const int32_t *values, size_t n, const options &o) {
+  return total_length(values, n, o);
+}
+
+size_t length(const uint64_t *values, size_t n, const options &o) {
+  return total_length(values, n, o);
+}
+
+size_t length(const int64_t *values, size_t n, const options &o) {
+  return total_length(values, n, o);
+}
+
+size_t format(const uint32_t *values, size_t n, char *out,
+              const options &o) {
+  const functions *f = table(o.kernel);
+  return f == nullptr ? 0
+                      : f->format_u32(values, n, out, o.separator, o.terminate);
+}
+
+size_t format(const int32_t *values, size_t n, char *out, const options &o) {
+  const functions *f = table(o.kernel);
+  return f == nullptr ? 0
+                      : f->format_i32(values, n, out, o.separator, o.terminate);
+}
+
+size_t format(const uint64_t *values, size_t n, char *out,
+              const options &o) {
+  const functions *f = table(o.kernel);
+  return f == nullptr ? 0
+                      : f->format_u64(values, n, out, o.separator, o.terminate);
+}
+
+size_t format(const int64_t *values, size_t n, char *out, const options &o) {
+  const functions *f = table(o.kernel);
+  return f == nullptr ? 0
+                      : f->format_i64(values, n, out, o.separator, o.terminate);
+}
+
+} // namespace intformat
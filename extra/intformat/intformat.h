@@ -0,0 +1,73 @@
+// Arrays of integers written as decimal text in one call, one separator
+// between them (a CSV column, a JSON array without its brackets), with
+// AVX2 or AVX-512 IFMA picked at runtime, and the exact length of the
+// output computed beforehand.
+//
+// 2021/11/17/convert.cpp compares about fifteen ways to write a number of
+// 16 digits, and 2022/03/24/convert.cpp adds one with AVX-512 IFMA. Here
+// the scalar back end is the SWAR code of Paul Khuong from the first, 8
+// digits in a 64-bit word; the AVX2 back end splits the number in four
+// with SSE2 (after Wojciech Muła) and gathers four digits at a time from a
+// table of 10,000 entries, as to_string_avx2 does; the AVX-512 back end is
+// to_string_avx512ifma. All of them write 16 digits and drop the leading
+// zeros with a shuffle picked by the number of digits, which comes from the
+// digit counts of 2021/05/28/digitcount.c and 2021/06/03/digitcount.c.
+//
+//   std::vector<char> text(intformat::length(ids, n));
+//   intformat::format(ids, n, text.data()); // "12,-5,7"
+#ifndef INTFORMAT_H
+#define INTFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace intformat {
+
+struct functions; // of a back end, in intformat_kernels.h
+
+enum class backend {
+  automatic, // best supported one
+  scalar,    // SWAR, 8 digits at a time
+  avx2,
+  avx512 // with IFMA and VBMI (Ice Lake and up)
+};
+
+// Whether the back end can run on this processor, and its name.
+bool backend_supported(backend b);
+backend active_backend();
+const char *backend_name(backend b);
+
+struct options {
+  // Between the numbers.
+  char separator = ',';
+  // The separator after the last number too, as a newline ends a line.
+  bool terminate = false;
+  backend kernel = backend::automatic;
+};
+
+// The bytes that format writes for values[0, n), exactly.
+size_t length(const uint32_t *values, size_t n, const options &o = options());
+size_t length(const int32_t *values, size_t n, const options &o = options());
+size_t length(const uint64_t *values, size_t n, const options &o = options());
+size_t length(const int64_t *values, size_t n, const options &o = options());
+
+// At least as many bytes as length gives for any n values: 20 digits, or
+// a sign and 19, and a separator.
+inline size_t max_length(size_t n) { return 21 * n; }
+
+// Writes values[0, n) to out, in decimal with a '-' for those below zero,
+// and returns the number of bytes written. out must have room for the
+// length above (format writes nothing beyond it). An unsupported back end
+// writes nothing and returns 0.
+size_t format(const uint32_t *values, size_t n, char *out,
+              const options &o = options());
+size_t format(const int32_t *values, size_t n, char *out,
+              const options &o = options());
+size_t format(const uint64_t *values, size_t n, char *out,
+              const options &o = options());
+size_t format(const int64_t *values, size_t n, char *out,
+              const options &o = options());
+
+} // namespace intformat
+
+#endif // INTFORMAT_H
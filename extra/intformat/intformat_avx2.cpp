@@ -0,0 +1,63 @@
+// The AVX2 back end: to_string_avx2 of 2021/11/17/convert.cpp. The number
+// is cut in two halves of 8 digits, and each half in two of 4 with SSE2
+// (after Wojciech Muła); one gather takes the four groups of 4 digits
+// from a table of 10,000 entries (the bigtable.h of that post, built here
+// when first needed), and a shuffle drops the leading zeros. Compiled
+// with -mavx2.
+#include "intformat_kernels.h"
+
+#include <immintrin.h>
+
+namespace intformat {
+namespace {
+
+// the 4 digits of k in ASCII, in the order of memory, at k
+struct four_digits {
+  uint32_t of[10000];
+
+  four_digits() {
+    for (uint32_t k = 0; k < 10000; k++) {
+      const char digits[4] = {char('0' + k / 1000), char('0' + k / 100 % 10),
+                              char('0' + k / 10 % 10), char('0' + k % 10)};
+      memcpy(&of[k], digits, sizeof(digits));
+    }
+  }
+};
+
+struct avx2_writer {
+  const uint32_t *table;
+
+  avx2_writer() {
+    static const four_digits t;
+    table = t.of;
+  }
+
+  void write(uint64_t x, int d, char *out) const {
+    // x = abcdefghijklmnop: [ ijklmnop | abcdefgh ] in 64-bit lanes
+    const __m128i halves =
+        _mm_set_epi64x(int64_t(x % ten_to_the_8), int64_t(x / ten_to_the_8));
+    // division by 10^4: multiplication by 0xd1b71759, shift by 45
+    const __m128i high =
+        _mm_srli_epi64(_mm_mul_epu32(halves, _mm_set1_epi32(0xd1b71759)), 45);
+    const __m128i low = _mm_sub_epi32(
+        halves, _mm_mul_epu32(high, _mm_set1_epi32(10000)));
+    // the four groups of 4 digits, first to last, in 32-bit lanes
+    const __m128i groups = _mm_or_si128(high, _mm_slli_epi64(low, 32));
+    const __m128i digits = _mm_i32gather_epi32(
+        reinterpret_cast<const int *>(table), groups, 4);
+    // byte k takes byte k + 16 - d
+    const __m128i from = _mm_add_epi8(
+        _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+        _mm_set1_epi8(char(16 - d)));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                     _mm_shuffle_epi8(digits, from));
+  }
+};
+
+} // namespace
+
+const functions &avx2_functions() {
+  return formatters<avx2_writer>::table();
+}
+
+} // namespace intformat
@@ -0,0 +1,65 @@
+// The AVX-512 back end: to_string_avx512ifma of 2022/03/24/convert.cpp.
+// For each half of 8 digits, one 52-bit multiplication (IFMA) per lane
+// gives the fraction n / 10^(8-k) for lane k, and a second one multiplies
+// it by 10 and keeps the digit in the upper half; a byte permutation
+// (VBMI) gathers the 16 digits and drops the leading zeros. Compiled with
+// -mavx512f -mavx512ifma -mavx512vbmi.
+#include "intformat_kernels.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+
+namespace intformat {
+namespace {
+
+/*
+From 2022/03/24/convert.cpp: the constants are ceil(2^52 / 10^(8-k)),
+fastmod in 52 bits (https://arxiv.org/abs/1902.01961). For 8 digits the
+second multiplication would overflow with ceil(2^52 / 10^8) = 0x2af31dd,
+so lane 0 takes 0x2af31dc and the bias 0x1A1A400, the smallest that does
+not underflow for 10^7:
+
+0x2af31dc * 10000000 = 0x19999996FD600
+(0x19999996FD600 + 0x1A1A400) * 10 = 0x1000000EAEC400
+*/
+struct avx512_writer {
+  void write(uint64_t x, int d, char *out) const {
+    const __m512i bias = _mm512_setr_epi64(0x1A1A400, 0, 0, 0, 0, 0, 0, 0);
+    const __m512i ten = _mm512_set1_epi64(10);
+    const __m512i ascii_zero = _mm512_set1_epi64('0');
+    const __m512i ifma_const = _mm512_setr_epi64(
+        0x00000000002af31dc, 0x0000000001ad7f29b, 0x0000000010c6f7a0c,
+        0x00000000a7c5ac472, 0x000000068db8bac72, 0x0000004189374bc6b,
+        0x0000028f5c28f5c29, 0x0000199999999999a);
+    const __m512i high = _mm512_set1_epi64(int64_t(x / ten_to_the_8));
+    const __m512i low = _mm512_set1_epi64(int64_t(x % ten_to_the_8));
+    const __m512i fraction_high = _mm512_madd52lo_epu64(bias, high, ifma_const);
+    const __m512i fraction_low = _mm512_madd52lo_epu64(bias, low, ifma_const);
+    // the digit k of each half in the low byte of lane k
+    const __m512i digits_high =
+        _mm512_madd52hi_epu64(ascii_zero, ten, fraction_high);
+    const __m512i digits_low =
+        _mm512_madd52hi_epu64(ascii_zero, ten, fraction_low);
+    // digit j of the 16 is at byte 8 j of the two registers; byte k takes
+    // digit k + 16 - d
+    const __m512i from = _mm512_zextsi128_si512(_mm_add_epi8(
+        _mm_setr_epi8(0, 8, 16, 24, 32, 40, 48, 56, 64, 72, 80, 88, 96, 104,
+                      112, 120),
+        _mm_set1_epi8(char(8 * (16 - d)))));
+    const __m512i digits =
+        _mm512_permutex2var_epi8(digits_high, from, digits_low);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out),
+                     _mm512_castsi512_si128(digits));
+  }
+};
+
+} // namespace
+
+const functions &avx512_functions() {
+  return formatters<avx512_writer>::table();
+}
+
+} // namespace intformat
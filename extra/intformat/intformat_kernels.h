@@ -0,0 +1,217 @@
+// The functions of each back end, the digit counts, and the loop that all
+// back ends share around their own way of writing up to 16 digits. Only
+// the intformat*.cpp files include this header.
+#ifndef INTFORMAT_KERNELS_H
+#define INTFORMAT_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "intformat.h"
+
+namespace intformat {
+
+struct functions {
+  size_t (*format_u32)(const uint32_t *values, size_t n, char *out,
+                       char separator, bool terminate);
+  size_t (*format_i32)(const int32_t *values, size_t n, char *out,
+                       char separator, bool terminate);
+  size_t (*format_u64)(const uint64_t *values, size_t n, char *out,
+                       char separator, bool terminate);
+  size_t (*format_i64)(const int64_t *values, size_t n, char *out,
+                       char separator, bool terminate);
+};
+
+const functions &scalar_functions();
+const functions &avx2_functions();
+const functions &avx512_functions();
+
+// In an unnamed namespace: each back end compiles its own copy with its
+// own instruction sets, so that the linker cannot pick the AVX2 copy for
+// the scalar back end.
+namespace {
+
+constexpr uint64_t ten_to_the_8 = 100000000;
+constexpr uint64_t ten_to_the_16 = 10000000000000000;
+
+inline int int_log2(uint64_t x) { return 63 - __builtin_clzll(x | 1); }
+
+// From 2021/05/28/digitcount.c, with 19/64 instead of 9/32 for log10(2):
+// the guess is the digit count or one less, and the table tells which.
+inline int digit_count(uint64_t x) {
+  static const uint64_t below[] = {9,
+                                   99,
+                                   999,
+                                   9999,
+                                   99999,
+                                   999999,
+                                   9999999,
+                                   99999999,
+                                   999999999,
+                                   9999999999,
+                                   99999999999,
+                                   999999999999,
+                                   9999999999999,
+                                   99999999999999,
+                                   999999999999999,
+                                   9999999999999999,
+                                   99999999999999999,
+                                   999999999999999999,
+                                   9999999999999999999u};
+  int y = (19 * int_log2(x)) >> 6;
+  y += x > below[y];
+  return y + 1;
+}
+
+// From 2021/06/03/digitcount.c (credit: kwillets): one addition carries
+// into the upper word exactly at the powers of ten.
+inline int digit_count(uint32_t x) {
+  static const uint64_t table[] = {
+      4294967296,  8589934582,  8589934582,  8589934582,  12884901788,
+      12884901788, 12884901788, 17179868184, 17179868184, 17179868184,
+      21474826480, 21474826480, 21474826480, 21474826480, 25769703776,
+      25769703776, 25769703776, 30063771072, 30063771072, 30063771072,
+      34349738368, 34349738368, 34349738368, 34349738368, 38554705664,
+      38554705664, 38554705664, 41949672960, 41949672960, 41949672960,
+      42949672960, 42949672960};
+  return int((x + table[int_log2(x)]) >> 32);
+}
+
+inline uint32_t magnitude(int32_t x) {
+  return x < 0 ? 0u - uint32_t(x) : uint32_t(x);
+}
+inline uint64_t magnitude(int64_t x) {
+  return x < 0 ? 0u - uint64_t(x) : uint64_t(x);
+}
+
+// Writer::write(x, d, out) writes the d digits of x < 10^16 to out[0, d),
+// and may write anything to out[d, 16).
+
+template <class Writer>
+char *write_value(const Writer &w, uint32_t x, char *p) {
+  const int d = digit_count(x);
+  w.write(x, d, p);
+  return p + d;
+}
+
+template <class Writer>
+char *write_value(const Writer &w, uint64_t x, char *p) {
+  if (x < ten_to_the_16) {
+    const int d = digit_count(x);
+    w.write(x, d, p);
+    return p + d;
+  }
+  // 17 to 20 digits: up to 4, then 16
+  const uint64_t high = x / ten_to_the_16;
+  const int d = digit_count(high);
+  w.write(high, d, p);
+  w.write(x % ten_to_the_16, 16, p + d);
+  return p + d + 16;
+}
+
+template <class Writer, class T>
+char *write_signed(const Writer &w, T x, char *p) {
+  *p = '-';
+  return write_value(w, magnitude(x), p + (x < 0));
+}
+
+template <class Writer> char *write_value(const Writer &w, int32_t x, char *p) {
+  return write_signed(w, x, p);
+}
+
+template <class Writer> char *write_value(const Writer &w, int64_t x, char *p) {
+  return write_signed(w, x, p);
+}
+
+// A number takes a digit and a separator at least, so with 8 numbers after
+// it 16 bytes follow its first digit: until then the writer may spill
+// past the digits, into what the next numbers overwrite. The last 8 go
+// through a buffer.
+template <class Writer, class T>
+size_t format_values(const Writer &w, const T *values, size_t n, char *out,
+                     char separator, bool terminate) {
+  char *p = out;
+  size_t i = 0;
+  for (; i + 8 < n; i++) {
+    p = write_value(w, values[i], p);
+    *p++ = separator;
+  }
+  for (; i < n; i++) {
+    char buffer[48];
+    const size_t count = size_t(write_value(w, values[i], buffer) - buffer);
+    memcpy(p, buffer, count);
+    p += count;
+    if (i + 1 < n || terminate) {
+      *p++ = separator;
+    }
+  }
+  return size_t(p - out);
+}
+
+// The functions of a back end whose writer is made by Writer().
+template <class Writer> struct formatters {
+  static size_t u32(const uint32_t *values, size_t n, char *out,
+                    char separator, bool terminate) {
+    return format_values(Writer(), values, n, out, separator, terminate);
+  }
+  static size_t i32(const int32_t *values, size_t n, char *out,
+                    char separator, bool terminate) {
+    return format_values(Writer(), values, n, out, separator, terminate);
+  }
+  static size_t u64(const uint64_t *values, size_t n, char *out,
+                    char separator, bool terminate) {
+    return format_values(Writer(), values, n, out, separator, terminate);
+  }
+  static size_t i64(const int64_t *values, size_t n, char *out,
+                    char separator, bool terminate) {
+    return format_values(Writer(), values, n, out, separator, terminate);
+  }
+  static const functions &table() {
+    static const functions f = {u32, i32, u64, i64};
+    return f;
+  }
+};
+
+// credit: Paul Khuong, from 2021/11/17/convert.cpp: the 8 digits of
+// hi * 10^4 + lo, in the order of memory, in a word
+inline uint64_t encode_ten_thousands(uint64_t hi, uint64_t lo) {
+  const uint64_t merged = hi | (lo << 32);
+  // truncated division by 100: 10486 / 2^20 ~= 1/100
+  const uint64_t top =
+      ((merged * 10486ULL) >> 20) & ((0x7FULL << 32) | 0x7FULL);
+  // the last 2 digits of each half
+  const uint64_t bot = merged - 100ULL * top;
+  // 4 radix-100 digits in little-endian order, each in 16 bits
+  const uint64_t hundreds = (bot << 16) + top;
+  // divide and mod by 10 all 4 radix-100 digits in parallel
+  uint64_t tens = (hundreds * 103ULL) >> 10;
+  tens &= (0xFULL << 48) | (0xFULL << 32) | (0xFULL << 16) | 0xFULL;
+  tens += (hundreds - 10ULL * tens) << 8;
+  return tens;
+}
+
+// the 8 digits of x < 10^8 in ASCII, in the order of memory
+inline uint64_t eight_digits(uint64_t x) {
+  return 0x3030303030303030 + encode_ten_thousands(x / 10000, x % 10000);
+}
+
+inline void store_word(char *p, uint64_t w) { memcpy(p, &w, sizeof(w)); }
+
+// Writes 8 bytes at a time; the leading zeros go with a shift.
+struct scalar_writer {
+  void write(uint64_t x, int d, char *out) const {
+    if (d <= 8) {
+      store_word(out, eight_digits(x) >> (8 * (8 - d)));
+      return;
+    }
+    store_word(out, eight_digits(x / ten_to_the_8) >> (8 * (16 - d)));
+    store_word(out + d - 8, eight_digits(x % ten_to_the_8));
+  }
+};
+
+} // namespace
+
+} // namespace intformat
+
+#endif // INTFORMAT_KERNELS_H
@@ -0,0 +1,152 @@
+// Checks of every back end against snprintf, for the four integer types:
+// the numbers around every power of ten and of two (where the digit
+// counts change), the extremes of each type, and random numbers of every
+// length; arrays of every size up to 40 (the last numbers take another
+// path) and longer ones, with several separators, with and without the
+// last one. The length must be exact and nothing may be written past it.
+#include "intformat.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const intformat::backend backends[] = {
+    intformat::backend::automatic, intformat::backend::scalar,
+    intformat::backend::avx2, intformat::backend::avx512};
+
+std::mt19937_64 gen(1234);
+
+std::string text(uint32_t x) { return std::to_string(x); }
+std::string text(int32_t x) { return std::to_string(x); }
+std::string text(uint64_t x) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%" PRIu64, x);
+  return buffer;
+}
+std::string text(int64_t x) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%" PRId64, x);
+  return buffer;
+}
+
+// Around the powers of ten and of two, the extremes, and some of every
+// digit count, in T.
+template <class T> std::vector<T> interesting() {
+  std::vector<uint64_t> magnitudes = {0, 1};
+  for (uint64_t p = 10;; p *= 10) {
+    magnitudes.insert(magnitudes.end(), {p - 1, p, p + 1});
+    if (p > std::numeric_limits<uint64_t>::max() / 10) {
+      break;
+    }
+  }
+  for (int k = 1; k < 64; k++) {
+    const uint64_t p = uint64_t(1) << k;
+    magnitudes.insert(magnitudes.end(), {p - 1, p, p + 1});
+  }
+  for (int digits = 1; digits <= 20; digits++) {
+    for (int k = 0; k < 100; k++) {
+      uint64_t x = 1 + gen() % 9;
+      for (int d = 1; d < digits; d++) {
+        x = x * 10 + gen() % 10;
+      }
+      magnitudes.push_back(x);
+    }
+  }
+  std::vector<T> values = {std::numeric_limits<T>::min(),
+                           std::numeric_limits<T>::max()};
+  for (uint64_t m : magnitudes) {
+    if (m <= uint64_t(std::numeric_limits<T>::max())) {
+      values.push_back(T(m));
+      if (std::numeric_limits<T>::is_signed) {
+        values.push_back(T(0 - m));
+      }
+    }
+  }
+  return values;
+}
+
+template <class T>
+bool check(const std::vector<T> &values, size_t n, intformat::backend b,
+           char separator, bool terminate) {
+  intformat::options o;
+  o.kernel = b;
+  o.separator = separator;
+  o.terminate = terminate;
+  std::string expected;
+  for (size_t i = 0; i < n; i++) {
+    expected += text(values[i]);
+    if (i + 1 < n || terminate) {
+      expected += separator;
+    }
+  }
+  const size_t length = intformat::length(values.data(), n, o);
+  // a canary after the length
+  std::string out(length + 64, '#');
+  const size_t written = intformat::format(values.data(), n, &out[0], o);
+  if (length != expected.size() || written != length ||
+      out.compare(0, length, expected) != 0 ||
+      out.find_first_not_of('#', length) != std::string::npos ||
+      intformat::max_length(n) < length) {
+    printf("bug: %s, %zu numbers (%zu bytes, length %zu, wrote %zu)\n",
+           intformat::backend_name(b), n, expected.size(), length, written);
+    return false;
+  }
+  return true;
+}
+
+template <class T> bool check_type() {
+  std::vector<T> values = interesting<T>();
+  std::shuffle(values.begin(), values.end(), gen);
+  for (intformat::backend b : backends) {
+    if (!intformat::backend_supported(b)) {
+      continue;
+    }
+    for (char separator : {',', '\n', ' '}) {
+      for (bool terminate : {false, true}) {
+        for (size_t n = 0; n <= 40; n++) {
+          std::vector<T> some(n), digits(n);
+          for (size_t i = 0; i < n; i++) {
+            some[i] = values[gen() % values.size()];
+            // one digit each, the least room after every number
+            digits[i] = T(gen() % 10);
+          }
+          if (!check(some, n, b, separator, terminate) ||
+              !check(digits, n, b, separator, terminate)) {
+            return false;
+          }
+        }
+        if (!check(values, values.size(), b, separator, terminate)) {
+          return false;
+        }
+      }
+    }
+    // every value alone
+    for (size_t i = 0; i < values.size(); i++) {
+      if (!check(std::vector<T>{values[i]}, 1, b, ',', false)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main() {
+  printf("best back end: %s\n",
+         intformat::backend_name(intformat::active_backend()));
+  if (!check_type<uint32_t>() || !check_type<int32_t>() ||
+      !check_type<uint64_t>() || !check_type<int64_t>()) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,86 @@
+// The AVX2 building blocks that the back ends under extra/ share: the
+// compression of 32-bit lanes (a permutation table and a masked store) and
+// the bitonic merge of two sorted vectors of 8 uint32_t. Only the files
+// compiled with -mavx2 -mpopcnt include it.
+#ifndef ISA_AVX2_H
+#define ISA_AVX2_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <immintrin.h>
+
+namespace avx2 {
+// Unnamed, like the kernels headers: every back end keeps its own copy.
+namespace {
+
+// permutation.lanes[mask] moves the 32-bit lanes selected by mask to the
+// front
+struct permutation_table {
+  uint32_t lanes[256][8];
+  permutation_table() {
+    for (int mask = 0; mask < 256; mask++) {
+      int k = 0;
+      for (int i = 0; i < 8; i++) {
+        if (mask & (1 << i)) {
+          lanes[mask][k++] = uint32_t(i);
+        }
+      }
+      while (k < 8) {
+        lanes[mask][k++] = 0;
+      }
+    }
+  }
+};
+
+const permutation_table permutation;
+
+// store_masks + 8 - k selects the first k 32-bit lanes
+const int32_t store_masks[16] = {-1, -1, -1, -1, -1, -1, -1, -1,
+                                 0,  0,  0,  0,  0,  0,  0,  0};
+
+// The 32-bit lanes of v selected by mask, written at out and counted;
+// nothing is written past them.
+inline size_t compress_epi32(void *out, __m256i v, unsigned mask) {
+  const int count = _mm_popcnt_u32(mask);
+  const __m256i packed = _mm256_permutevar8x32_epi32(
+      v, _mm256_loadu_si256(
+             reinterpret_cast<const __m256i *>(permutation.lanes[mask])));
+  _mm256_maskstore_epi32(
+      static_cast<int *>(out),
+      _mm256_loadu_si256(
+          reinterpret_cast<const __m256i *>(store_masks + 8 - count)),
+      packed);
+  return size_t(count);
+}
+
+// One stage of the bitonic merge: lanes distant by d, with the minimum
+// going to the lanes where bit d is clear (blend masks 0xF0, 0xCC, 0xAA).
+template <int blend> inline __m256i stage_epu32(__m256i v, __m256i index) {
+  const __m256i p = _mm256_permutevar8x32_epi32(v, index);
+  return _mm256_blend_epi32(_mm256_min_epu32(v, p), _mm256_max_epu32(v, p),
+                            blend);
+}
+
+// low and high sorted: low gets the 8 smallest of the 16 values, high the
+// 8 largest, both sorted. merge_8x8 of extra/avx512/multimerge.c, with a
+// reversal and three stages in place of the eight rotations.
+inline void merge_epu32(__m256i &low, __m256i &high) {
+  const __m256i reverse = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+  const __m256i by4 = _mm256_setr_epi32(4, 5, 6, 7, 0, 1, 2, 3);
+  const __m256i by2 = _mm256_setr_epi32(2, 3, 0, 1, 6, 7, 4, 5);
+  const __m256i by1 = _mm256_setr_epi32(1, 0, 3, 2, 5, 4, 7, 6);
+  const __m256i r = _mm256_permutevar8x32_epi32(high, reverse);
+  __m256i l = _mm256_min_epu32(low, r), h = _mm256_max_epu32(low, r);
+  l = stage_epu32<0xF0>(l, by4);
+  h = stage_epu32<0xF0>(h, by4);
+  l = stage_epu32<0xCC>(l, by2);
+  h = stage_epu32<0xCC>(h, by2);
+  low = stage_epu32<0xAA>(l, by1);
+  high = stage_epu32<0xAA>(h, by1);
+}
+
+} // namespace
+} // namespace avx2
+
+#endif // ISA_AVX2_H
@@ -0,0 +1,84 @@
+// The runtime dispatch of the libraries under extra/, after
+// 2020/07/16/test.cpp. A library describes each of its back ends by an
+// implementation with, at least,
+//
+//   struct implementation {
+//     backend kind;                       // its value of the library's enum
+//     const char *name;
+//     uint32_t required_instruction_sets; // of enum instruction_set
+//     ...                                 // its functions
+//   };
+//
+// lists them in priority order and takes the first one this processor
+// supports:
+//
+//   const implementation *const implementations[] = {&avx512, &avx2,
+//                                                    &scalar};
+//   static const implementation *best =
+//       isa::first_supported(implementations, &scalar);
+#ifndef ISA_DISPATCH_H
+#define ISA_DISPATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "isa.h"
+
+namespace isa {
+// In an unnamed namespace, as the detection of isa.h is static: each
+// library has its own copy.
+namespace {
+
+// Whether this processor has all the instruction sets.
+inline bool host_supports(uint32_t instruction_sets) {
+  static const uint32_t host = detect_supported_architectures();
+  return (host & instruction_sets) == instruction_sets;
+}
+
+template <class Implementation> bool supported(const Implementation &impl) {
+  return host_supports(impl.required_instruction_sets);
+}
+
+// The first implementation of list that this processor supports; fallback
+// (nullptr unless given) if there is none.
+template <class Implementation, size_t N>
+const Implementation *
+first_supported(const Implementation *const (&list)[N],
+                const Implementation *fallback = nullptr) {
+  for (const Implementation *impl : list) {
+    if (supported(*impl)) {
+      return impl;
+    }
+  }
+  return fallback;
+}
+
+// The implementation of list of that kind; nullptr if there is none or if
+// this processor does not support it.
+template <class Implementation, size_t N, class Kind>
+const Implementation *find(const Implementation *const (&list)[N],
+                           Kind kind) {
+  for (const Implementation *impl : list) {
+    if (impl->kind == kind) {
+      return supported(*impl) ? impl : nullptr;
+    }
+  }
+  return nullptr;
+}
+
+// The name of the implementation of list of that kind, supported or not;
+// "unknown" if there is none.
+template <class Implementation, size_t N, class Kind>
+const char *name_of(const Implementation *const (&list)[N], Kind kind) {
+  for (const Implementation *impl : list) {
+    if (impl->kind == kind) {
+      return impl->name;
+    }
+  }
+  return "unknown";
+}
+
+} // namespace
+} // namespace isa
+
+#endif // ISA_DISPATCH_H
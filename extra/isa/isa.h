@@ -0,0 +1,259 @@
+
+/* From
+https://github.com/endorno/pytorch/blob/master/torch/lib/TH/generic/simd/simd.h
+Highly modified.
+
+This is the detection code from 2020/07/16/isa.h, extended with SSE4.1 and
+the AVX-512 subsets, and with the XCR0 check so that we do not pick AVX2 or
+AVX-512 kernels when the operating system does not save the wide registers.
+The libraries under extra/ include it as "../isa/isa.h", or through
+"../isa/dispatch.h", which picks their back end.
+
+Copyright (c) 2016-     Facebook, Inc            (Adam Paszke)
+Copyright (c) 2014-     Facebook, Inc            (Soumith Chintala)
+Copyright (c) 2011-2014 Idiap Research Institute (Ronan Collobert)
+Copyright (c) 2012-2014 Deepmind Technologies    (Koray Kavukcuoglu)
+Copyright (c) 2011-2012 NEC Laboratories America (Koray Kavukcuoglu)
+Copyright (c) 2011-2013 NYU                      (Clement Farabet)
+Copyright (c) 2006-2010 NEC Laboratories America (Ronan Collobert, Leon Bottou,
+Iain Melvin, Jason Weston) Copyright (c) 2006      Idiap Research Institute
+(Samy Bengio) Copyright (c) 2001-2004 Idiap Research Institute (Ronan Collobert,
+Samy Bengio, Johnny Mariethoz)
+
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without
+modification, are permitted provided that the following conditions are met:
+
+1. Redistributions of source code must retain the above copyright
+   notice, this list of conditions and the following disclaimer.
+
+2. Redistributions in binary form must reproduce the above copyright
+   notice, this list of conditions and the following disclaimer in the
+   documentation and/or other materials provided with the distribution.
+
+3. Neither the names of Facebook, Deepmind Technologies, NYU, NEC Laboratories
+America and IDIAP Research Institute nor the names of its contributors may be
+   used to endorse or promote products derived from this software without
+   specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+POSSIBILITY OF SUCH DAMAGE.
+*/
+#ifndef ISADETECTION_H
+#define ISADETECTION_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(HAVE_GCC_GET_CPUID) && defined(USE_GCC_GET_CPUID)
+#include <cpuid.h>
+#endif
+
+enum instruction_set {
+  DEFAULT = 0x0,
+  NEON = 0x1,
+  AVX2 = 0x4,
+  SSE42 = 0x8,
+  PCLMULQDQ = 0x10,
+  BMI1 = 0x20,
+  BMI2 = 0x40,
+  SSE41 = 0x80,
+  AVX512F = 0x100,
+  AVX512DQ = 0x200,
+  AVX512BW = 0x400,
+  AVX512VL = 0x800,
+  AVX512IFMA = 0x1000,
+  AVX512VBMI = 0x2000,
+  AVX512VBMI2 = 0x4000,
+  AVX512BITALG = 0x8000,
+  AVX512VPOPCNTDQ = 0x10000,
+  // shorthand for what our AVX-512 kernels usually need (Skylake-X and up)
+  AVX512 = AVX512F | AVX512DQ | AVX512BW | AVX512VL,
+  // Ice Lake and up
+  AVX512ICL = AVX512 | AVX512VBMI | AVX512VBMI2 | AVX512BITALG |
+              AVX512VPOPCNTDQ
+};
+
+#if defined(__arm__) || defined(__aarch64__) // incl. armel, armhf, arm64
+
+#if defined(__ARM_NEON)
+
+static inline uint32_t detect_supported_architectures() {
+  return instruction_set::NEON;
+}
+
+#else // ARM without NEON
+
+static inline uint32_t detect_supported_architectures() {
+  return instruction_set::DEFAULT;
+}
+
+#endif
+
+#elif defined(__x86_64__) || defined(_M_AMD64) // x64
+
+namespace {
+// Can be found on Intel ISA Reference for CPUID
+constexpr uint32_t cpuid_avx2_bit = 1
+                                    << 5; ///< @private Bit 5 of EBX for EAX=0x7
+constexpr uint32_t cpuid_bmi1_bit = 1
+                                    << 3; ///< @private bit 3 of EBX for EAX=0x7
+constexpr uint32_t cpuid_bmi2_bit = 1
+                                    << 8; ///< @private bit 8 of EBX for EAX=0x7
+constexpr uint32_t cpuid_avx512f_bit =
+    1 << 16; ///< @private bit 16 of EBX for EAX=0x7
+constexpr uint32_t cpuid_avx512dq_bit =
+    1 << 17; ///< @private bit 17 of EBX for EAX=0x7
+constexpr uint32_t cpuid_avx512ifma_bit =
+    1 << 21; ///< @private bit 21 of EBX for EAX=0x7
+constexpr uint32_t cpuid_avx512bw_bit =
+    1 << 30; ///< @private bit 30 of EBX for EAX=0x7
+constexpr uint32_t cpuid_avx512vl_bit =
+    1U << 31; ///< @private bit 31 of EBX for EAX=0x7
+constexpr uint32_t cpuid_avx512vbmi_bit =
+    1 << 1; ///< @private bit 1 of ECX for EAX=0x7
+constexpr uint32_t cpuid_avx512vbmi2_bit =
+    1 << 6; ///< @private bit 6 of ECX for EAX=0x7
+constexpr uint32_t cpuid_avx512bitalg_bit =
+    1 << 12; ///< @private bit 12 of ECX for EAX=0x7
+constexpr uint32_t cpuid_avx512vpopcntdq_bit =
+    1 << 14; ///< @private bit 14 of ECX for EAX=0x7
+constexpr uint32_t cpuid_sse41_bit =
+    1 << 19; ///< @private bit 19 of ECX for EAX=0x1
+constexpr uint32_t cpuid_sse42_bit =
+    1 << 20; ///< @private bit 20 of ECX for EAX=0x1
+constexpr uint32_t cpuid_osxsave_bit =
+    1 << 27; ///< @private bit 27 of ECX for EAX=0x1
+// XCR0: SSE (1) and AVX (2) state, then the three AVX-512 states (5,6,7)
+constexpr uint64_t xcr0_avx_mask = 0x6;
+constexpr uint64_t xcr0_avx512_mask = 0xe6;
+constexpr uint32_t cpuid_pclmulqdq_bit =
+    1 << 1; ///< @private bit  1 of ECX for EAX=0x1
+} // namespace
+
+static inline void cpuid(uint32_t *eax, uint32_t *ebx, uint32_t *ecx,
+                         uint32_t *edx) {
+#if defined(_MSC_VER)
+  int cpu_info[4];
+  __cpuid(cpu_info, *eax);
+  *eax = cpu_info[0];
+  *ebx = cpu_info[1];
+  *ecx = cpu_info[2];
+  *edx = cpu_info[3];
+#elif defined(HAVE_GCC_GET_CPUID) && defined(USE_GCC_GET_CPUID)
+  uint32_t level = *eax;
+  __get_cpuid(level, eax, ebx, ecx, edx);
+#else
+  uint32_t a = *eax, b, c = *ecx, d;
+  asm volatile("cpuid\n\t" : "+a"(a), "=b"(b), "+c"(c), "=d"(d));
+  *eax = a;
+  *ebx = b;
+  *ecx = c;
+  *edx = d;
+#endif
+}
+
+static inline uint64_t xgetbv() {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  uint32_t xcr0_lo, xcr0_hi;
+  asm volatile("xgetbv\n\t" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+  return xcr0_lo | (uint64_t(xcr0_hi) << 32);
+#endif
+}
+
+static inline uint32_t detect_supported_architectures() {
+  uint32_t eax, ebx, ecx, edx;
+  uint32_t host_isa = 0x0;
+
+  // Does the OS save the AVX and AVX-512 registers?
+  eax = 0x1;
+  ecx = 0x0;
+  cpuid(&eax, &ebx, &ecx, &edx);
+  uint64_t xcr0 = (ecx & cpuid_osxsave_bit) ? xgetbv() : 0;
+  bool os_avx = (xcr0 & xcr0_avx_mask) == xcr0_avx_mask;
+  bool os_avx512 = (xcr0 & xcr0_avx512_mask) == xcr0_avx512_mask;
+
+  // ECX for EAX=0x7
+  eax = 0x7;
+  ecx = 0x0;
+  cpuid(&eax, &ebx, &ecx, &edx);
+  if (os_avx && (ebx & cpuid_avx2_bit)) {
+    host_isa |= instruction_set::AVX2;
+  }
+  if (os_avx512) {
+    if (ebx & cpuid_avx512f_bit) {
+      host_isa |= instruction_set::AVX512F;
+    }
+    if (ebx & cpuid_avx512dq_bit) {
+      host_isa |= instruction_set::AVX512DQ;
+    }
+    if (ebx & cpuid_avx512ifma_bit) {
+      host_isa |= instruction_set::AVX512IFMA;
+    }
+    if (ebx & cpuid_avx512bw_bit) {
+      host_isa |= instruction_set::AVX512BW;
+    }
+    if (ebx & cpuid_avx512vl_bit) {
+      host_isa |= instruction_set::AVX512VL;
+    }
+    if (ecx & cpuid_avx512vbmi_bit) {
+      host_isa |= instruction_set::AVX512VBMI;
+    }
+    if (ecx & cpuid_avx512vbmi2_bit) {
+      host_isa |= instruction_set::AVX512VBMI2;
+    }
+    if (ecx & cpuid_avx512bitalg_bit) {
+      host_isa |= instruction_set::AVX512BITALG;
+    }
+    if (ecx & cpuid_avx512vpopcntdq_bit) {
+      host_isa |= instruction_set::AVX512VPOPCNTDQ;
+    }
+  }
+  if (ebx & cpuid_bmi1_bit) {
+    host_isa |= instruction_set::BMI1;
+  }
+
+  if (ebx & cpuid_bmi2_bit) {
+    host_isa |= instruction_set::BMI2;
+  }
+
+  // EBX for EAX=0x1
+  eax = 0x1;
+  cpuid(&eax, &ebx, &ecx, &edx);
+
+  if (ecx & cpuid_sse41_bit) {
+    host_isa |= instruction_set::SSE41;
+  }
+
+  if (ecx & cpuid_sse42_bit) {
+    host_isa |= instruction_set::SSE42;
+  }
+
+  if (ecx & cpuid_pclmulqdq_bit) {
+    host_isa |= instruction_set::PCLMULQDQ;
+  }
+
+  return host_isa;
+}
+#else // fallback
+
+static inline uint32_t detect_supported_architectures() {
+  return instruction_set::DEFAULT;
+}
+
+#endif // end SIMD extension detection code
+
+#endif // ISADETECTION_H
@@ -0,0 +1,130 @@
+// Speed of the sorts of n rows of 128 bytes with a 64-bit key (1 million by
+// default), in ns per row: std::sort and std::stable_sort of the rows, of
+// pointers to the rows (in random order in memory) and of the C strings of
+// 2016/10/05/pointersort.cpp, against the key-cache sort, with one thread
+// and with one per hardware thread.
+#include "keysort.h"
+
+#include "../harness/harness.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct row {
+  uint64_t key;
+  char payload[120];
+};
+
+template <class T, class F>
+static void time(const char *data, const char *name,
+                 const std::vector<T> &input, std::vector<T> &out, F f,
+                 harness::options &opts) {
+  harness::print_row(data, 12, 16,
+                     harness::run_on_copy(name, input, out, f, opts));
+}
+
+static bool same_keys(const std::vector<row> &x, const std::vector<row> &y) {
+  for (size_t i = 0; i < x.size(); i++) {
+    if (x[i].key != y[i].key) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool run_rows(const std::vector<row> &input, harness::options &opts) {
+  const size_t n = input.size();
+  auto less = [](const row &x, const row &y) { return x.key < y.key; };
+  auto key = [](const row &r) { return r.key; };
+  std::vector<row> expected(input), out(n);
+  std::sort(expected.begin(), expected.end(), less);
+  time("row", "std::sort", input, out,
+       [&] { std::sort(out.begin(), out.end(), less); }, opts);
+  time("row", "std::stable_sort", input, out,
+       [&] { std::stable_sort(out.begin(), out.end(), less); }, opts);
+  keysort::options o;
+  time("row", "keysort", input, out,
+       [&] { keysort::sort(out.data(), n, key, o); }, opts);
+  bool ok = same_keys(out, expected);
+  o.threads = 0;
+  time("row", "keysort parallel", input, out,
+       [&] { keysort::sort(out.data(), n, key, o); }, opts);
+  return ok && same_keys(out, expected);
+}
+
+static bool run_pointers(const std::vector<row> &table,
+                         harness::options &opts) {
+  const size_t n = table.size();
+  std::vector<const row *> input;
+  for (const row &r : table) {
+    input.push_back(&r);
+  }
+  std::shuffle(input.begin(), input.end(), std::mt19937_64(1));
+  auto less = [](const row *x, const row *y) { return x->key < y->key; };
+  auto key = [](const row *r) { return r->key; };
+  std::vector<const row *> expected(input), out(n);
+  std::stable_sort(expected.begin(), expected.end(), less);
+  time("row *", "std::sort", input, out,
+       [&] { std::sort(out.begin(), out.end(), less); }, opts);
+  time("row *", "std::stable_sort", input, out,
+       [&] { std::stable_sort(out.begin(), out.end(), less); }, opts);
+  keysort::options o;
+  time("row *", "keysort", input, out,
+       [&] { keysort::sort(out.data(), n, key, o); }, opts);
+  bool ok = out == expected;
+  o.threads = 0;
+  time("row *", "keysort parallel", input, out,
+       [&] { keysort::sort(out.data(), n, key, o); }, opts);
+  return ok && out == expected;
+}
+
+static bool run_strings(size_t n, std::mt19937_64 &gen,
+                        harness::options &opts) {
+  std::vector<std::string> storage(n);
+  for (auto &s : storage) {
+    s = std::to_string(gen() % (n * 10));
+  }
+  std::vector<const char *> input;
+  for (const auto &s : storage) {
+    input.push_back(s.c_str());
+  }
+  auto less = [](const char *x, const char *y) { return strcmp(x, y) < 0; };
+  auto prefix = [](const char *s) { return keysort::prefix64(s); };
+  std::vector<const char *> expected(input), out(n);
+  std::stable_sort(expected.begin(), expected.end(), less);
+  time("const char *", "std::sort", input, out,
+       [&] { std::sort(out.begin(), out.end(), less); }, opts);
+  time("const char *", "std::stable_sort", input, out,
+       [&] { std::stable_sort(out.begin(), out.end(), less); }, opts);
+  keysort::options o;
+  time("const char *", "keysort", input, out,
+       [&] { keysort::sort(out.data(), n, prefix, less, o); }, opts);
+  return out == expected;
+}
+
+int main(int argc, char **argv) {
+  const size_t n = argc > 1 ? size_t(atoll(argv[1])) : 1000000;
+  std::mt19937_64 gen(1234);
+  harness::options opts = harness::default_options();
+  opts.repeat = 5;
+  printf("n = %zu, %u hardware threads\n", n,
+         std::thread::hardware_concurrency());
+  printf("data        \tsort            \tns/row\n");
+  std::vector<row> table(n);
+  for (size_t i = 0; i < n; i++) {
+    table[i].key = gen();
+    memset(table[i].payload, int(i), sizeof(table[i].payload));
+  }
+  if (!run_rows(table, opts) || !run_pointers(table, opts) ||
+      !run_strings(n, gen, opts)) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
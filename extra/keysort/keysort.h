@@ -0,0 +1,177 @@
+// Decorate-sort-undecorate ("key cache") sort for arrays of large objects,
+// or of pointers to them.
+//
+// 2016/10/05/pointersort.cpp shows that sorting through a comparator that
+// follows pointers costs several times more than sorting the values: every
+// comparison reads two objects that are not in cache. Here each object's
+// key, or a fixed-width prefix of it, is read once into an array of keys
+// and one of indexes, which the LSD radix sort of extra/radix/cpp sorts
+// together. When the key is only a prefix, the runs of equal prefixes are
+// then ordered by the full comparison. Last, the objects are permuted in
+// place by following the cycles of the permutation: each object moves once
+// and each cycle needs one temporary, instead of a copy of the array.
+//
+// Header-only, C++14 (-pthread):
+//
+//   keysort::sort(rows.data(), rows.size(),
+//                 [](const row &r) { return r.time; });
+//   keysort::sort(names.data(), names.size(),
+//                 [](const char *s) { return keysort::prefix64(s); },
+//                 [](const char *x, const char *y) {
+//                   return strcmp(x, y) < 0;
+//                 });
+#ifndef KEYSORT_H
+#define KEYSORT_H
+
+#include "../radix/cpp/radixsort.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace keysort {
+
+struct options {
+  unsigned threads = 1; // of the radix sort; 0: one per hardware thread
+};
+
+// The first 8 bytes of s[0, length), zero-padded, as a big-endian integer:
+// when prefix64(x) < prefix64(y), x comes before y for memcmp and strcmp
+// (as in cstr_cmp<8> of pointersort.cpp).
+inline uint64_t prefix64(const char *s, size_t length) {
+  uint64_t x = 0;
+  memcpy(&x, s, std::min(length, sizeof(x)));
+  return __builtin_bswap64(x);
+}
+
+// Same for a null-terminated string.
+inline uint64_t prefix64(const char *s) {
+  size_t length = 0;
+  while (length < 8 && s[length] != '\0') {
+    length++;
+  }
+  return prefix64(s, length);
+}
+
+// Moves objects[indexes[i]] to position i, for every i, one cycle of the
+// permutation at a time. indexes must be a permutation of [0, n); it is
+// overwritten (indexes[i] = i).
+template <class T, class I> void permute(T *objects, I *indexes, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    if (indexes[i] == I(i)) {
+      continue; // in place, or its cycle is done
+    }
+    T first = std::move(objects[i]);
+    size_t j = i;
+    for (;;) {
+      const size_t k = indexes[j];
+      indexes[j] = I(j);
+      if (k == i) {
+        break;
+      }
+      objects[j] = std::move(objects[k]);
+      j = k;
+    }
+    objects[j] = std::move(first);
+  }
+}
+
+namespace internal {
+
+// indexes[0, n): the stable sorting permutation by prefix(x), then
+// less(x, y) within the runs of equal prefixes (if Ties).
+template <bool Ties, class T, class Prefix, class Less, class I>
+void order(const T *objects, size_t n, Prefix prefix, Less less, I *indexes,
+           const options &o) {
+  typedef typename std::decay<decltype(prefix(objects[0]))>::type key_type;
+  std::vector<key_type> keys(n);
+  for (size_t i = 0; i < n; i++) {
+    keys[i] = prefix(objects[i]);
+    indexes[i] = I(i);
+  }
+  radix::options ro;
+  ro.threads = o.threads;
+  radix::sort(keys.data(), indexes, n, ro);
+  if (!Ties) {
+    return;
+  }
+  auto by_object = [objects, &less](I x, I y) {
+    return less(objects[x], objects[y]);
+  };
+  for (size_t begin = 0; begin < n;) {
+    size_t end = begin + 1;
+    // the same bits: -0.0 and +0.0 are different prefixes
+    while (end < n &&
+           memcmp(&keys[end], &keys[begin], sizeof(key_type)) == 0) {
+      end++;
+    }
+    if (end - begin > 1) {
+      std::stable_sort(indexes + begin, indexes + end, by_object);
+    }
+    begin = end;
+  }
+}
+
+template <bool Ties, class I, class T, class Prefix, class Less>
+void sort(T *objects, size_t n, Prefix prefix, Less less, const options &o) {
+  std::vector<I> indexes(n);
+  order<Ties>(objects, n, prefix, less, indexes.data(), o);
+  permute(objects, indexes.data(), n);
+}
+
+// less for sorts by the full key, never called
+struct no_ties {
+  template <class T> bool operator()(const T &, const T &) const {
+    return false;
+  }
+};
+
+} // namespace internal
+
+// indexes[i] = the index of the object that goes to position i when the
+// objects are sorted by key(x), a uint32_t, uint64_t, int32_t, int64_t,
+// float or double (as radix::sort orders them). Stable. I is an unsigned
+// integer type that holds n - 1, such as uint32_t or size_t.
+template <class T, class Key, class I>
+void order(const T *objects, size_t n, Key key, I *indexes,
+           const options &o = options()) {
+  internal::order<false>(objects, n, key, internal::no_ties(), indexes, o);
+}
+
+// Same when prefix(x) only orders part of the objects: runs of equal
+// prefixes are ordered by less. prefix must agree with less: whenever
+// prefix(x) < prefix(y), less(x, y).
+template <class T, class Prefix, class Less, class I>
+void order(const T *objects, size_t n, Prefix prefix, Less less, I *indexes,
+           const options &o = options()) {
+  internal::order<true>(objects, n, prefix, less, indexes, o);
+}
+
+// Sorts the objects by key(x), stably: order, then permute.
+template <class T, class Key>
+void sort(T *objects, size_t n, Key key, const options &o = options()) {
+  if (uint64_t(n) <= 0xFFFFFFFFULL) {
+    internal::sort<false, uint32_t>(objects, n, key, internal::no_ties(), o);
+  } else {
+    internal::sort<false, size_t>(objects, n, key, internal::no_ties(), o);
+  }
+}
+
+// Sorts the objects by prefix(x), then less, stably.
+template <class T, class Prefix, class Less>
+void sort(T *objects, size_t n, Prefix prefix, Less less,
+          const options &o = options()) {
+  if (uint64_t(n) <= 0xFFFFFFFFULL) {
+    internal::sort<true, uint32_t>(objects, n, prefix, less, o);
+  } else {
+    internal::sort<true, size_t>(objects, n, prefix, less, o);
+  }
+}
+
+} // namespace keysort
+
+#endif // KEYSORT_H
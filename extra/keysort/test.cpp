@@ -0,0 +1,146 @@
+// Checks against std::stable_sort: rows by an integer key with many ties,
+// pointers to rows, strings by their 8-byte prefix then strcmp (many share
+// the prefix), floating-point keys; all the lengths up to 300, then longer
+// arrays with one thread and with four. Then permute alone on random
+// permutations.
+#include "keysort.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::mt19937_64 gen(1234);
+
+struct row {
+  int64_t key;
+  double score;
+  uint32_t seq;
+  char payload[44];
+  bool operator==(const row &o) const { return seq == o.seq; }
+};
+
+std::vector<row> rows(size_t n, uint64_t range) {
+  std::vector<row> v(n);
+  for (size_t i = 0; i < n; i++) {
+    v[i].key = int64_t(gen() % range) - int64_t(range / 2);
+    v[i].score = double(int64_t(gen() % range) - int64_t(range / 2)) / 4;
+    v[i].seq = uint32_t(i);
+    memset(v[i].payload, int(i), sizeof(v[i].payload));
+  }
+  return v;
+}
+
+bool check_rows(size_t n, uint64_t range, const keysort::options &o) {
+  std::vector<row> input = rows(n, range), expected(input), out(input);
+  std::stable_sort(expected.begin(), expected.end(),
+                   [](const row &x, const row &y) { return x.key < y.key; });
+  keysort::sort(out.data(), n, [](const row &r) { return r.key; }, o);
+  bool ok = out == expected;
+  for (size_t i = 0; ok && i < n; i++) {
+    ok = out[i].payload[0] == char(out[i].seq);
+  }
+  // pointers, by a floating-point key
+  std::vector<const row *> pointers;
+  for (const row &r : input) {
+    pointers.push_back(&r);
+  }
+  std::vector<const row *> expected_pointers(pointers);
+  std::stable_sort(expected_pointers.begin(), expected_pointers.end(),
+                   [](const row *x, const row *y) {
+                     return x->score < y->score;
+                   });
+  keysort::sort(pointers.data(), n, [](const row *r) { return r->score; }, o);
+  ok = ok && pointers == expected_pointers;
+  // order alone, size_t indexes
+  std::vector<size_t> indexes(n);
+  keysort::order(input.data(), n, [](const row &r) { return r.key; },
+                 indexes.data(), o);
+  for (size_t i = 0; ok && i < n; i++) {
+    ok = input[indexes[i]].seq == expected[i].seq;
+  }
+  if (!ok) {
+    printf("bug: rows, n = %zu, %u threads\n", n, o.threads);
+  }
+  return ok;
+}
+
+bool check_strings(size_t n, const keysort::options &o) {
+  std::vector<std::string> storage(n);
+  for (auto &s : storage) {
+    // few distinct 8-byte prefixes, and some shorter strings
+    s = std::string(gen() % 10, char('a' + gen() % 2)) +
+        std::to_string(gen() % 1000);
+  }
+  std::vector<const char *> input;
+  for (const auto &s : storage) {
+    input.push_back(s.c_str());
+  }
+  auto less = [](const char *x, const char *y) { return strcmp(x, y) < 0; };
+  std::vector<const char *> expected(input), out(input);
+  std::stable_sort(expected.begin(), expected.end(), less);
+  keysort::sort(out.data(), n,
+                [](const char *s) { return keysort::prefix64(s); }, less, o);
+  if (out != expected) {
+    printf("bug: strings, n = %zu, %u threads\n", n, o.threads);
+    return false;
+  }
+  return true;
+}
+
+bool check_sort() {
+  keysort::options o;
+  for (size_t n = 0; n <= 300; n++) {
+    if (!check_rows(n, 7, o) || !check_rows(n, uint64_t(1) << 40, o) ||
+        !check_strings(n, o)) {
+      return false;
+    }
+  }
+  for (unsigned threads : {1u, 4u}) {
+    o.threads = threads;
+    if (!check_rows(400000, 1000, o) ||
+        !check_rows(400000, uint64_t(1) << 40, o) ||
+        !check_strings(400000, o)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool check_permute() {
+  for (size_t n : {size_t(0), size_t(1), size_t(2), size_t(1000)}) {
+    std::vector<uint32_t> indexes(n), values(n);
+    std::iota(indexes.begin(), indexes.end(), 0);
+    std::shuffle(indexes.begin(), indexes.end(), gen);
+    for (auto &v : values) {
+      v = uint32_t(gen());
+    }
+    std::vector<uint32_t> expected(n), out(values), order(indexes);
+    for (size_t i = 0; i < n; i++) {
+      expected[i] = values[indexes[i]];
+    }
+    keysort::permute(out.data(), order.data(), n);
+    if (out != expected) {
+      printf("bug: permute, n = %zu\n", n);
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main() {
+  if (!check_sort() || !check_permute()) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,109 @@
+// Speed of the merge of k sorted runs (256 by default) of random values,
+// 4 million values in total, in ns per value: a binary heap of the run heads
+// (std::priority_queue) against the tree with each back end, at both widths.
+#include "kwaymerge.h"
+
+#include "../harness/harness.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <queue>
+#include <random>
+#include <utility>
+#include <vector>
+
+template <class T>
+static size_t heap_merge(const std::vector<std::vector<T>> &runs, T *out) {
+  typedef std::pair<T, size_t> head; // value, run
+  std::priority_queue<head, std::vector<head>, std::greater<head>> heap;
+  std::vector<size_t> position(runs.size(), 0);
+  for (size_t i = 0; i < runs.size(); i++) {
+    if (!runs[i].empty()) {
+      heap.push(head(runs[i][0], i));
+    }
+  }
+  size_t n = 0;
+  while (!heap.empty()) {
+    const head h = heap.top();
+    heap.pop();
+    out[n++] = h.first;
+    const size_t p = ++position[h.second];
+    if (p < runs[h.second].size()) {
+      heap.push(head(runs[h.second][p], h.second));
+    }
+  }
+  return n;
+}
+
+template <class T>
+static bool run(size_t k, size_t total, std::mt19937_64 &gen,
+                harness::options &opts) {
+  std::vector<std::vector<T>> runs(k);
+  for (auto &r : runs) {
+    r.resize(total / k);
+    for (auto &v : r) {
+      v = T(gen());
+    }
+    std::sort(r.begin(), r.end());
+  }
+  std::vector<const T *> pointers;
+  std::vector<size_t> sizes;
+  for (const auto &r : runs) {
+    pointers.push_back(r.data());
+    sizes.push_back(r.size());
+  }
+  const size_t volume = k * (total / k);
+  std::vector<T> expected(volume), out(volume);
+  heap_merge(runs, expected.data());
+  auto r = harness::run("heap", volume, [&] {
+    heap_merge(runs, out.data());
+    harness::do_not_optimize(out.data());
+  }, opts);
+  if (opts.format == HARNESS_TEXT) {
+    printf("%zu\t%-6s\t%.3f\n", sizeof(T) * 8, "heap", r.min() / volume);
+  } else {
+    r.report();
+  }
+  const kwaymerge::backend backends[] = {kwaymerge::backend::scalar,
+                                         kwaymerge::backend::avx2,
+                                         kwaymerge::backend::avx512};
+  for (kwaymerge::backend b : backends) {
+    if (!kwaymerge::backend_supported(b)) {
+      continue;
+    }
+    kwaymerge::options o;
+    o.kernel = b;
+    auto rt = harness::run(kwaymerge::backend_name(b), volume, [&] {
+      kwaymerge::merge(pointers.data(), sizes.data(), k, out.data(), o);
+      harness::do_not_optimize(out.data());
+    }, opts);
+    if (out != expected) {
+      printf("bug!\n");
+      return false;
+    }
+    if (opts.format == HARNESS_TEXT) {
+      printf("%zu\t%-6s\t%.3f\n", sizeof(T) * 8, kwaymerge::backend_name(b),
+             rt.min() / volume);
+    } else {
+      rt.report();
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  const size_t k = argc > 1 ? size_t(atoll(argv[1])) : 256;
+  const size_t total = 4000000;
+  std::mt19937_64 gen(1234);
+  harness::options opts = harness::default_options();
+  printf("k = %zu runs, %zu values, best back end: %s\n", k, total,
+         kwaymerge::backend_name(kwaymerge::active_backend()));
+  printf("bits\tmerge\tns/value\n");
+  if (!run<uint32_t>(k, total, gen, opts) ||
+      !run<uint64_t>(k, total, gen, opts)) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,301 @@
+// Runtime dispatch, the scalar kernel and the tournament tree.
+#include "kwaymerge.h"
+#include "kwaymerge_kernels.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "../isa/dispatch.h"
+
+namespace kwaymerge {
+
+const functions &scalar_functions() {
+  static const functions scalar = {merge_scalar<uint32_t>,
+                                   merge_scalar<uint64_t>};
+  return scalar;
+}
+
+namespace {
+
+struct implementation {
+  backend kind;
+  const char *name;
+  uint32_t required_instruction_sets;
+  const functions &(*table)();
+};
+
+const implementation scalar = {backend::scalar, "scalar", 0,
+                               scalar_functions};
+const implementation avx2 = {backend::avx2, "avx2", instruction_set::AVX2,
+                             avx2_functions};
+const implementation avx512 = {backend::avx512, "avx512",
+                               instruction_set::AVX512F, avx512_functions};
+
+const implementation *const implementations[] = {&avx512, &avx2, &scalar};
+
+const implementation *best() {
+  static const implementation *best =
+      isa::first_supported(implementations, &scalar);
+  return best;
+}
+
+// nullptr if unknown or unsupported
+const implementation *find(backend kind) {
+  if (kind == backend::automatic) {
+    return best();
+  }
+  return isa::find(implementations, kind);
+}
+
+merge_function<uint32_t> pick(const functions &table, uint32_t) {
+  return table.merge32;
+}
+merge_function<uint64_t> pick(const functions &table, uint64_t) {
+  return table.merge64;
+}
+
+// A node of the tree. A leaf reads its source; an internal node merges its
+// two children into its buffer. Either way, [head, head + avail) are the
+// values ready to go up, and finished is set once nothing more will come.
+template <class T> struct node {
+  typename merger<T>::source *source = nullptr;
+  node *left = nullptr, *right = nullptr;
+  std::vector<T> buffer;
+  const T *head = nullptr;
+  size_t avail = 0;
+  bool finished = false;
+};
+
+template <class T> class tree {
+public:
+  tree(std::vector<typename merger<T>::source> &sources, size_t buffer,
+       merge_function<T> merge)
+      : merge(merge) {
+    const size_t k = sources.size();
+    nodes.resize(2 * k - 1);
+    std::vector<node<T> *> level(k);
+    for (size_t i = 0; i < k; i++) {
+      nodes[i].source = &sources[i];
+      level[i] = &nodes[i];
+    }
+    // level after level, as in multimerge.c; an odd node out moves up alone
+    size_t next = k;
+    while (level.size() > 1) {
+      std::vector<node<T> *> up;
+      for (size_t i = 0; i + 1 < level.size(); i += 2) {
+        node<T> &n = nodes[next++];
+        n.left = level[i];
+        n.right = level[i + 1];
+        n.buffer.resize(buffer);
+        up.push_back(&n);
+      }
+      if (level.size() % 2 == 1) {
+        up.push_back(level.back());
+      }
+      level.swap(up);
+    }
+    root = level[0];
+  }
+
+  node<T> &top() { return *root; }
+
+  // Called once n has handed out all its values.
+  void fill(node<T> &n) {
+    n.avail = 0;
+    if (n.source != nullptr) {
+      const T *chunk = nullptr;
+      const size_t count = (*n.source)(&chunk);
+      n.head = chunk;
+      n.avail = count;
+      n.finished = count == 0;
+      return;
+    }
+    node<T> &l = *n.left, &r = *n.right;
+    const size_t room = n.buffer.size();
+    size_t out = 0;
+    while (out < room) {
+      if (l.avail == 0 && !l.finished) {
+        fill(l);
+      }
+      if (r.avail == 0 && !r.finished) {
+        fill(r);
+      }
+      if (l.avail == 0 || r.avail == 0) {
+        if (out > 0) {
+          break;
+        }
+        node<T> &other = l.avail == 0 ? r : l;
+        if (other.avail == 0) {
+          n.finished = true;
+          return;
+        }
+        // one child is over: its sibling's values go up as they are
+        n.head = other.head;
+        n.avail = other.avail;
+        other.avail = 0;
+        return;
+      }
+      // nothing past the smallest last value of a child that goes on
+      size_t i = l.avail, j = r.avail;
+      if (!l.finished || !r.finished) {
+        const T *lend = l.head + l.avail, *rend = r.head + r.avail;
+        const T bound = !l.finished && (r.finished || lend[-1] <= rend[-1])
+                            ? lend[-1]
+                            : rend[-1];
+        i = size_t(std::upper_bound(l.head, lend, bound) - l.head);
+        j = size_t(std::upper_bound(r.head, rend, bound) - r.head);
+      }
+      if (i + j > room - out) {
+        // the room - out smallest values: a[0, i) and b[0, j) with ties
+        // taken from the left, as the merge does
+        const size_t k = room - out;
+        size_t lo = k > j ? k - j : 0, hi = std::min(k, i);
+        while (lo < hi) {
+          const size_t p = (lo + hi) / 2;
+          if (l.head[p] <= r.head[k - p - 1]) {
+            lo = p + 1;
+          } else {
+            hi = p;
+          }
+        }
+        i = lo;
+        j = k - lo;
+      }
+      merge(l.head, i, r.head, j, n.buffer.data() + out);
+      out += i + j;
+      l.head += i;
+      l.avail -= i;
+      r.head += j;
+      r.avail -= j;
+    }
+    n.head = n.buffer.data();
+    n.avail = out;
+  }
+
+private:
+  merge_function<T> merge;
+  std::vector<node<T>> nodes;
+  node<T> *root;
+};
+
+} // namespace
+
+bool backend_supported(backend b) { return find(b) != nullptr; }
+
+backend active_backend() { return best()->kind; }
+
+const char *backend_name(backend b) {
+  if (b == backend::automatic) {
+    return best()->name;
+  }
+  return isa::name_of(implementations, b);
+}
+
+template <class T>
+merger<T>::merger(sink output, const options &o)
+    : output(std::move(output)), settings(o) {}
+
+template <class T> merger<T>::~merger() {}
+
+template <class T> void merger<T>::add_run(const T *values, size_t count) {
+  bool given = false;
+  sources.push_back([values, count, given](const T **chunk) mutable {
+    if (given) {
+      return size_t(0);
+    }
+    given = true;
+    *chunk = values;
+    return count;
+  });
+}
+
+template <class T> void merger<T>::add_source(source s) {
+  sources.push_back(std::move(s));
+}
+
+template <class T> size_t merger<T>::run() {
+  const implementation *impl = find(settings.kernel);
+  if (impl == nullptr ||
+      (settings.policy == duplicates::drop_keys && sizeof(T) < 8)) {
+    sources.clear();
+    return size_t(-1);
+  }
+  if (sources.empty()) {
+    return 0;
+  }
+  tree<T> t(sources, std::max<size_t>(settings.buffer, 1),
+            pick(impl->table(), T()));
+  node<T> &root = t.top();
+  // the bits of a value that make it a duplicate
+  const T mask = settings.policy == duplicates::drop_keys
+                     ? T(~uint64_t(0xFFFFFFFF))
+                     : T(~T(0));
+  const bool drop = settings.policy != duplicates::keep;
+  std::vector<T> unique;
+  bool started = false;
+  T last = 0;
+  size_t delivered = 0;
+  for (;;) {
+    t.fill(root);
+    if (root.avail == 0) {
+      if (root.finished) {
+        break;
+      }
+      continue;
+    }
+    const T *values = root.head;
+    size_t count = root.avail;
+    if (drop) {
+      // branch-free: every value is written, and kept if it differs from
+      // the one before, across chunks
+      if (unique.size() < count) {
+        unique.resize(count);
+      }
+      size_t k = 0;
+      if (!started) {
+        unique[k++] = values[0];
+        last = values[0];
+        started = true;
+      }
+      for (size_t i = k; i < count; i++) {
+        const T v = values[i];
+        unique[k] = v;
+        k += (v & mask) != (last & mask);
+        last = v;
+      }
+      values = unique.data();
+      count = k;
+    }
+    if (count > 0) {
+      output(values, count);
+      delivered += count;
+    }
+  }
+  sources.clear();
+  return delivered;
+}
+
+template <class T>
+size_t merge(const T *const *runs, const size_t *sizes, size_t k, T *out,
+             const options &o) {
+  T *p = out;
+  merger<T> m(
+      [&p](const T *values, size_t count) {
+        memcpy(p, values, count * sizeof(T));
+        p += count;
+      },
+      o);
+  for (size_t i = 0; i < k; i++) {
+    m.add_run(runs[i], sizes[i]);
+  }
+  return m.run();
+}
+
+template class merger<uint32_t>;
+template class merger<uint64_t>;
+template size_t merge<uint32_t>(const uint32_t *const *, const size_t *,
+                                size_t, uint32_t *, const options &);
+template size_t merge<uint64_t>(const uint64_t *const *, const size_t *,
+                                size_t, uint64_t *, const options &);
+
+} // namespace kwaymerge
@@ -0,0 +1,104 @@
+// Merging of many sorted runs of uint32_t or uint64_t values, for instance
+// during the compaction of sorted files.
+//
+// extra/avx512/multimerge.c merges runs two by two with bitonic networks
+// (merge_8x8, merge_16x16), level after level, each level materializing all
+// of its output. Here the 2-way merges are the nodes of a tournament tree
+// that streams: each node owns a small buffer, fills it by merging what its
+// two children hold, and the root hands its buffer to a sink. Memory use
+// is about one buffer per run, whatever the size of the runs.
+//
+// A node merges only what it can emit safely: while a child can still
+// produce values, nothing larger than the last value it holds goes out.
+// Each merge then works on two finite sorted arrays, with a bitonic network
+// over AVX2 or AVX-512 vectors picked at runtime.
+//
+// Runs are arrays or sources that hand out chunks on demand. Records with
+// a 32-bit key and a 32-bit payload are uint64_t values (key_payload),
+// sorted by key then payload, and duplicates can be dropped by value or by
+// key.
+//
+//   kwaymerge::merger<uint32_t> m([&](const uint32_t *p, size_t n) {...});
+//   for (auto &run : runs) m.add_run(run.data(), run.size());
+//   m.run();
+#ifndef KWAYMERGE_H
+#define KWAYMERGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace kwaymerge {
+
+enum class backend {
+  automatic, // best supported one
+  scalar,
+  avx2,
+  avx512
+};
+
+// Whether the back end can run on this processor, and its name.
+bool backend_supported(backend b);
+backend active_backend();
+const char *backend_name(backend b);
+
+// A record: key in the high half, so that records sort by key, then by
+// payload.
+inline uint64_t key_payload(uint32_t key, uint32_t payload) {
+  return (uint64_t(key) << 32) | payload;
+}
+inline uint32_t key_of(uint64_t record) { return uint32_t(record >> 32); }
+inline uint32_t payload_of(uint64_t record) { return uint32_t(record); }
+
+enum class duplicates {
+  keep,
+  drop_values, // equal values go out once
+  drop_keys    // uint64_t only: records with equal keys go out once, the
+               // one with the smallest payload
+};
+
+struct options {
+  backend kernel = backend::automatic;
+  duplicates policy = duplicates::keep;
+  size_t buffer = 4096; // values held by each node of the tree
+};
+
+template <class T> class merger {
+public:
+  // Stores in *chunk the address of the next values of the run and returns
+  // their number, 0 at the end of the run. The values stay valid until the
+  // next call.
+  typedef std::function<size_t(const T **chunk)> source;
+  // Receives the next count merged values.
+  typedef std::function<void(const T *values, size_t count)> sink;
+
+  explicit merger(sink output, const options &o = options());
+  ~merger();
+  merger(const merger &) = delete;
+  merger &operator=(const merger &) = delete;
+
+  // The values are read in place during run().
+  void add_run(const T *values, size_t count);
+  void add_source(source s);
+
+  // Merges all the runs into the sink and returns the number of values
+  // delivered; the runs are then forgotten. (size_t)-1 if the back end is
+  // not supported, or if drop_keys is asked for uint32_t.
+  size_t run();
+
+private:
+  sink output;
+  options settings;
+  std::vector<source> sources;
+};
+
+// One call: merges runs[0..k) (sizes[i] values each) into out, which has
+// room for their total; returns the number of values written.
+template <class T>
+size_t merge(const T *const *runs, const size_t *sizes, size_t k, T *out,
+             const options &o = options());
+
+} // namespace kwaymerge
+
+#endif // KWAYMERGE_H
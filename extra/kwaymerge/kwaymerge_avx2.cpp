@@ -0,0 +1,72 @@
+// The 2-way merge with AVX2: merge_8x8 of multimerge.c, as a bitonic
+// network of three min/max stages after a reversal (in place of the eight
+// rotations), over 8 uint32_t (in ../isa/avx2.h) or 4 uint64_t. Compiled
+// with -mavx2.
+#include "kwaymerge_kernels.h"
+
+#include "../isa/avx2.h"
+
+namespace kwaymerge {
+namespace {
+
+struct ops32 {
+  typedef uint32_t value;
+  typedef __m256i vector;
+  static constexpr size_t lanes = 8;
+
+  static vector load(const value *p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  }
+  static void store(value *p, vector v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+  }
+  static void merge(vector &low, vector &high) {
+    avx2::merge_epu32(low, high);
+  }
+};
+
+// AVX2 has no unsigned 64-bit compare: the vectors hold the values with
+// their top bit flipped, from load to store, and compare signed.
+struct ops64 {
+  typedef uint64_t value;
+  typedef __m256i vector;
+  static constexpr size_t lanes = 4;
+
+  static vector flip() { return _mm256_set1_epi64x(int64_t(1ULL << 63)); }
+  static vector load(const value *p) {
+    return _mm256_xor_si256(
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), flip());
+  }
+  static void store(value *p, vector v) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(p),
+                        _mm256_xor_si256(v, flip()));
+  }
+  // lanes distant by d (permutation control), each taking its partner where
+  // that gives the minimum, or the maximum in the upper lanes
+  template <int control>
+  static vector stage(vector v, vector upper) {
+    const vector p = _mm256_permute4x64_epi64(v, control);
+    return _mm256_blendv_epi8(
+        v, p, _mm256_xor_si256(_mm256_cmpgt_epi64(v, p), upper));
+  }
+  static void merge(vector &low, vector &high) {
+    const vector r = _mm256_permute4x64_epi64(high, 0x1B);
+    const vector gt = _mm256_cmpgt_epi64(low, r);
+    vector l = _mm256_blendv_epi8(low, r, gt);
+    vector h = _mm256_blendv_epi8(r, low, gt);
+    const vector by2 = _mm256_setr_epi64x(0, 0, -1, -1);
+    const vector by1 = _mm256_setr_epi64x(0, -1, 0, -1);
+    l = stage<0x4E>(l, by2);
+    h = stage<0x4E>(h, by2);
+    low = stage<0xB1>(l, by1);
+    high = stage<0xB1>(h, by1);
+  }
+};
+
+const functions avx2 = {merge_blocks<ops32>, merge_blocks<ops64>};
+
+} // namespace
+
+const functions &avx2_functions() { return avx2; }
+
+} // namespace kwaymerge
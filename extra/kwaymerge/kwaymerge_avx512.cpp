@@ -0,0 +1,82 @@
+// The 2-way merge with AVX-512: merge_16x16 of multimerge.c, as a bitonic
+// network of four masked min/max stages after a reversal (in place of the
+// sixteen rotations), over 16 uint32_t or 8 uint64_t. Compiled with
+// -mavx512f.
+#include "kwaymerge_kernels.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+
+namespace kwaymerge {
+namespace {
+
+struct ops32 {
+  typedef uint32_t value;
+  typedef __m512i vector;
+  static constexpr size_t lanes = 16;
+
+  static vector load(const value *p) { return _mm512_loadu_si512(p); }
+  static void store(value *p, vector v) { _mm512_storeu_si512(p, v); }
+  // lanes distant by d; the maximum goes to the lanes where bit d is set
+  static vector stage(vector v, vector index, __mmask16 upper) {
+    const vector p = _mm512_permutexvar_epi32(index, v);
+    return _mm512_mask_max_epu32(_mm512_min_epu32(v, p), upper, v, p);
+  }
+  static void merge(vector &low, vector &high) {
+    const vector lane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
+                                          11, 12, 13, 14, 15);
+    const vector r = _mm512_permutexvar_epi32(
+        _mm512_xor_si512(lane, _mm512_set1_epi32(15)), high);
+    vector l = _mm512_min_epu32(low, r), h = _mm512_max_epu32(low, r);
+#pragma GCC unroll 4
+    for (int d = 8; d >= 1; d >>= 1) {
+      const vector index = _mm512_xor_si512(lane, _mm512_set1_epi32(d));
+      const __mmask16 upper =
+          _mm512_test_epi32_mask(lane, _mm512_set1_epi32(d));
+      l = stage(l, index, upper);
+      h = stage(h, index, upper);
+    }
+    low = l;
+    high = h;
+  }
+};
+
+struct ops64 {
+  typedef uint64_t value;
+  typedef __m512i vector;
+  static constexpr size_t lanes = 8;
+
+  static vector load(const value *p) { return _mm512_loadu_si512(p); }
+  static void store(value *p, vector v) { _mm512_storeu_si512(p, v); }
+  static vector stage(vector v, vector index, __mmask8 upper) {
+    const vector p = _mm512_permutexvar_epi64(index, v);
+    return _mm512_mask_max_epu64(_mm512_min_epu64(v, p), upper, v, p);
+  }
+  static void merge(vector &low, vector &high) {
+    const vector lane = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+    const vector r = _mm512_permutexvar_epi64(
+        _mm512_xor_si512(lane, _mm512_set1_epi64(7)), high);
+    vector l = _mm512_min_epu64(low, r), h = _mm512_max_epu64(low, r);
+#pragma GCC unroll 3
+    for (int d = 4; d >= 1; d >>= 1) {
+      const vector index = _mm512_xor_si512(lane, _mm512_set1_epi64(d));
+      const __mmask8 upper =
+          _mm512_test_epi64_mask(lane, _mm512_set1_epi64(d));
+      l = stage(l, index, upper);
+      h = stage(h, index, upper);
+    }
+    low = l;
+    high = h;
+  }
+};
+
+const functions avx512 = {merge_blocks<ops32>, merge_blocks<ops64>};
+
+} // namespace
+
+const functions &avx512_functions() { return avx512; }
+
+} // namespace kwaymerge
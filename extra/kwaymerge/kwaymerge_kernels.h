@@ -0,0 +1,106 @@
+// The 2-way merge of two finite sorted arrays, scalar and over the vector
+// operations that kwaymerge_avx2.cpp and kwaymerge_avx512.cpp provide.
+// Only the kwaymerge*.cpp files include this header.
+#ifndef KWAYMERGE_KERNELS_H
+#define KWAYMERGE_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "kwaymerge.h"
+
+namespace kwaymerge {
+
+// Writes the na + nb values of a and b, merged, into out.
+template <class T>
+using merge_function = void (*)(const T *a, size_t na, const T *b, size_t nb,
+                                T *out);
+
+struct functions {
+  merge_function<uint32_t> merge32;
+  merge_function<uint64_t> merge64;
+};
+
+const functions &scalar_functions();
+const functions &avx2_functions();
+const functions &avx512_functions();
+
+// Unnamed: kwaymerge.o and the vector back ends each compile their own
+// copy, none of which may end up in the others.
+namespace {
+
+// The serial tail of Merge_uint4, without branches in the loop.
+template <class T>
+void merge_scalar(const T *a, size_t na, const T *b, size_t nb, T *out) {
+  size_t i = 0, j = 0, k = 0;
+  while ((i < na) & (j < nb)) {
+    const T x = a[i], y = b[j];
+    const bool take_b = y < x;
+    out[k++] = take_b ? y : x;
+    i += !take_b;
+    j += take_b;
+  }
+  memcpy(out + k, a + i, (na - i) * sizeof(T));
+  k += na - i;
+  memcpy(out + k, b + j, (nb - j) * sizeof(T));
+}
+
+// Merge_uint4 of multimerge.c over vectors of Ops::lanes values: Ops
+// provides
+//
+//   vector load(const value *);
+//   void store(value *, vector);
+//   void merge(vector &low, vector &high); // both sorted: low gets the
+//                                           // smallest half, high the rest
+//
+// high carries the largest values from one step to the next; we load the
+// next block from the array whose next value is smaller. When an array has
+// no full block left, the carried values, the rest of that array and the
+// rest of the other one are merged by the scalar code.
+template <class Ops>
+void merge_blocks(const typename Ops::value *a, size_t na,
+                  const typename Ops::value *b, size_t nb,
+                  typename Ops::value *out) {
+  typedef typename Ops::value T;
+  typedef typename Ops::vector V;
+  constexpr size_t W = Ops::lanes;
+  if (na < W || nb < W) {
+    merge_scalar(a, na, b, nb, out);
+    return;
+  }
+  V low = Ops::load(a), high = Ops::load(b);
+  size_t i = W, j = W;
+  Ops::merge(low, high);
+  Ops::store(out, low);
+  out += W;
+  while (i + W <= na && j + W <= nb) {
+    V next;
+    if (a[i] <= b[j]) {
+      next = Ops::load(a + i);
+      i += W;
+    } else {
+      next = Ops::load(b + j);
+      j += W;
+    }
+    low = next;
+    Ops::merge(low, high);
+    Ops::store(out, low);
+    out += W;
+  }
+  // the carried values, with the array that has less than a block left
+  T carried[W], merged[2 * W];
+  Ops::store(carried, high);
+  const bool a_short = i + W > na;
+  const T *tail = a_short ? a + i : b + j;
+  const size_t tail_size = a_short ? na - i : nb - j;
+  merge_scalar(carried, W, tail, tail_size, merged);
+  merge_scalar(merged, W + tail_size, a_short ? b + j : a + i,
+               a_short ? nb - j : na - i, out);
+}
+
+} // namespace
+
+} // namespace kwaymerge
+
+#endif // KWAYMERGE_KERNELS_H
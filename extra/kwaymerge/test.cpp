@@ -0,0 +1,162 @@
+// Checks of every back end at both widths against std::sort of all the
+// values: random numbers of runs (including empty ones) of random lengths,
+// given as arrays or as sources that hand out chunks of odd sizes, with
+// small node buffers so that the tree cuts its merges often; then records
+// with key_payload and the two ways of dropping duplicates.
+#include "kwaymerge.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+const kwaymerge::backend backends[] = {
+    kwaymerge::backend::automatic, kwaymerge::backend::scalar,
+    kwaymerge::backend::avx2, kwaymerge::backend::avx512};
+
+template <class T> T base();
+template <> uint32_t base<uint32_t>() { return 0; }
+template <> uint64_t base<uint64_t>() { return 0x7FFFFFFFFFFFF000ULL; }
+
+// sorted values, with repeats, within a small range so that runs overlap
+template <class T> std::vector<T> generate(size_t length, uint32_t range) {
+  std::vector<T> run(length);
+  for (auto &v : run) {
+    v = base<T>() + T(uint32_t(rand()) % range);
+  }
+  std::sort(run.begin(), run.end());
+  return run;
+}
+
+template <class T>
+std::vector<T> merged(const std::vector<std::vector<T>> &runs,
+                      kwaymerge::options o, bool chunked, size_t *result) {
+  std::vector<T> out;
+  kwaymerge::merger<T> m(
+      [&out](const T *values, size_t count) {
+        out.insert(out.end(), values, values + count);
+      },
+      o);
+  for (const auto &run : runs) {
+    if (!chunked) {
+      m.add_run(run.data(), run.size());
+      continue;
+    }
+    const size_t step = 1 + uint32_t(rand()) % 37;
+    size_t position = 0;
+    m.add_source([&run, step, position](const T **chunk) mutable {
+      const size_t count = std::min(step, run.size() - position);
+      *chunk = run.data() + position;
+      position += count;
+      return count;
+    });
+  }
+  *result = m.run();
+  return out;
+}
+
+template <class T>
+bool check(const std::vector<std::vector<T>> &runs, const std::vector<T> &all,
+           kwaymerge::duplicates policy) {
+  for (kwaymerge::backend b : backends) {
+    if (!kwaymerge::backend_supported(b)) {
+      continue;
+    }
+    for (int chunked = 0; chunked < 2; chunked++) {
+      kwaymerge::options o;
+      o.kernel = b;
+      o.policy = policy;
+      o.buffer = 1 + uint32_t(rand()) % 100;
+      size_t result;
+      const std::vector<T> out = merged(runs, o, chunked != 0, &result);
+      if (out != all || result != all.size()) {
+        printf("bug: %s, %zu bits, %zu runs, buffer %zu, chunked %d\n",
+               kwaymerge::backend_name(b), sizeof(T) * 8, runs.size(),
+               o.buffer, chunked);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+template <class T> bool random_runs() {
+  for (int trial = 0; trial < 300; trial++) {
+    const size_t k = 1 + uint32_t(rand()) % (trial < 200 ? 12 : 300);
+    const uint32_t range = 1 + uint32_t(rand()) % 5000;
+    std::vector<std::vector<T>> runs;
+    std::vector<T> all;
+    for (size_t i = 0; i < k; i++) {
+      const size_t length =
+          uint32_t(rand()) % 4 == 0 ? 0 : uint32_t(rand()) % 500;
+      runs.push_back(generate<T>(length, range));
+      all.insert(all.end(), runs.back().begin(), runs.back().end());
+    }
+    std::sort(all.begin(), all.end());
+    if (!check(runs, all, kwaymerge::duplicates::keep)) {
+      return false;
+    }
+    all.erase(std::unique(all.begin(), all.end()), all.end());
+    if (!check(runs, all, kwaymerge::duplicates::drop_values)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool records() {
+  for (int trial = 0; trial < 100; trial++) {
+    const size_t k = 1 + uint32_t(rand()) % 50;
+    std::vector<std::vector<uint64_t>> runs(k);
+    std::vector<uint64_t> all;
+    for (auto &run : runs) {
+      run.resize(uint32_t(rand()) % 300);
+      for (auto &r : run) {
+        r = kwaymerge::key_payload(uint32_t(rand()) % 1000,
+                                   uint32_t(rand()) % 4);
+      }
+      std::sort(run.begin(), run.end());
+      all.insert(all.end(), run.begin(), run.end());
+    }
+    std::sort(all.begin(), all.end());
+    all.erase(std::unique(all.begin(), all.end(),
+                          [](uint64_t x, uint64_t y) {
+                            return kwaymerge::key_of(x) == kwaymerge::key_of(y);
+                          }),
+              all.end());
+    if (!check(runs, all, kwaymerge::duplicates::drop_keys)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool one_call() {
+  const std::vector<uint32_t> a = {1, 4, 9}, b = {}, c = {2, 3, 4, 10};
+  const uint32_t *runs[] = {a.data(), b.data(), c.data()};
+  const size_t sizes[] = {a.size(), b.size(), c.size()};
+  uint32_t out[7];
+  const uint32_t expected[] = {1, 2, 3, 4, 4, 9, 10};
+  kwaymerge::options o;
+  o.policy = kwaymerge::duplicates::drop_keys; // not for uint32_t
+  return kwaymerge::merge(runs, sizes, 3, out) == 7 &&
+         std::equal(out, out + 7, expected) &&
+         kwaymerge::merge(runs, sizes, 0, out) == 0 &&
+         kwaymerge::merge(runs, sizes, 3, out, o) == size_t(-1);
+}
+
+} // namespace
+
+int main() {
+  printf("best back end: %s\n",
+         kwaymerge::backend_name(kwaymerge::active_backend()));
+  if (!one_call() || !random_runs<uint32_t>() || !random_runs<uint64_t>() ||
+      !records()) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,154 @@
+// GB/s and nanoseconds per line over 64 MB of log lines (about 100 bytes
+// each), then of short lines (a number each, about 8 bytes), as a table
+// of line starts is made: by std::getline over a std::istringstream, as
+// 2019/07/26/getlines.cpp does, by a loop over memchr, and by each back
+// end, on one thread and on all of them. Then the lines of the index are
+// gone over, to sum their lengths. With a file name, the time to map and
+// index the file as well.
+#include "lineindex.h"
+
+#include "../harness/harness.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+const lineindex::backend backends[] = {lineindex::backend::scalar,
+                                       lineindex::backend::avx2,
+                                       lineindex::backend::avx512};
+
+std::string make_text(bool short_lines, size_t size, std::mt19937_64 &gen) {
+  std::string text;
+  char buffer[256];
+  while (text.size() < size) {
+    if (short_lines) {
+      snprintf(buffer, sizeof(buffer), "%d\n", int(gen() % 10000000));
+    } else {
+      snprintf(buffer, sizeof(buffer),
+               "2019-04-%02d %02d:%02d:%02d INFO GET /api/v2/items/%d "
+               "status=%d bytes=%d took=%dms%*s\n",
+               int(1 + gen() % 30), int(gen() % 24), int(gen() % 60),
+               int(gen() % 60), int(gen() % 100000), int(200 + gen() % 300),
+               int(gen() % 1000000), int(gen() % 1000), int(gen() % 60), "");
+    }
+    text += buffer;
+  }
+  return text;
+}
+
+// the starts as line_starts gives them, from the '\n' that memchr finds
+std::vector<uint64_t> memchr_starts(const std::string &text) {
+  std::vector<uint64_t> starts = {0};
+  const char *p = text.data();
+  const char *end = p + text.size();
+  const void *newline;
+  while ((newline = memchr(p, '\n', size_t(end - p))) != nullptr) {
+    p = static_cast<const char *>(newline) + 1;
+    starts.push_back(uint64_t(p - text.data()));
+  }
+  if (!text.empty() && text.back() != '\n') {
+    starts.push_back(text.size() + 1);
+  }
+  return starts;
+}
+
+size_t getline_lengths(const std::string &text) {
+  std::istringstream in(text);
+  std::string line;
+  size_t sum = 0;
+  while (std::getline(in, line)) {
+    sum += line.size();
+  }
+  return sum;
+}
+
+size_t index_lengths(const lineindex::index &lines) {
+  size_t sum = 0;
+  for (std::string_view l : lines) {
+    sum += l.size();
+  }
+  return sum;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::mt19937_64 gen(1234);
+  harness::options opts = harness::default_options();
+  opts.repeat = 5;
+  printf("best back end: %s\n",
+         lineindex::backend_name(lineindex::active_backend()));
+  bool ok = true;
+  for (bool short_lines : {false, true}) {
+    const std::string text = make_text(short_lines, size_t(64) << 20, gen);
+    const std::vector<uint64_t> expected = memchr_starts(text);
+    const size_t lines = expected.size() - 1;
+    printf("%s: %zu MB, %zu lines\n", short_lines ? "short lines" : "logs",
+           text.size() >> 20, lines);
+    auto time = [&](const char *name, const std::function<void()> &f) {
+      auto r = harness::run(name, text.size(), f, opts);
+      if (opts.format != HARNESS_TEXT) {
+        r.report();
+      } else {
+        printf("  %-28s\t%6.2f GB/s\t%8.2f ns/line\n", name,
+               text.size() / r.min(), r.min() / lines);
+      }
+    };
+    size_t sum = 0;
+    time("std::getline", [&] {
+      sum = getline_lengths(text);
+      harness::do_not_optimize(sum);
+    });
+    time("memchr", [&] {
+      harness::do_not_optimize(memchr_starts(text).size());
+    });
+    for (lineindex::backend b : backends) {
+      if (!lineindex::backend_supported(b)) {
+        continue;
+      }
+      const std::string name = lineindex::backend_name(b);
+      for (unsigned threads : {1u, 0u}) {
+        lineindex::options o;
+        o.kernel = b;
+        o.threads = threads;
+        time((name + (threads == 1 ? "" : ", threads")).c_str(), [&] {
+          const std::vector<uint64_t> starts =
+              lineindex::line_starts(text.data(), text.size(), o);
+          ok = ok && starts.size() == expected.size();
+          harness::do_not_optimize(starts.data());
+        });
+        ok = ok && lineindex::line_starts(text.data(), text.size(), o) ==
+                       expected;
+      }
+    }
+    const lineindex::index index(text.data(), text.size());
+    time("lines of the index", [&] {
+      const size_t lengths = index_lengths(index);
+      ok = ok && lengths == sum;
+      harness::do_not_optimize(lengths);
+    });
+  }
+  if (argc > 1) {
+    lineindex::options o;
+    o.threads = 0;
+    lineindex::file f;
+    auto r = harness::run("open", 1, [&] {
+      ok = ok && f.open(argv[1], o);
+    }, opts);
+    printf("%s: %zu MB, %zu lines, %.2f GB/s\n", argv[1], f.size() >> 20,
+           f.lines().size(), f.size() / r.min());
+  }
+  if (!ok) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
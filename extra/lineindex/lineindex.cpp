@@ -0,0 +1,256 @@
+// Runtime dispatch, the scalar back end, the split between threads and
+// the mapping of files.
+#include "lineindex.h"
+#include "lineindex_kernels.h"
+
+#include "../isa/dispatch.h"
+#include "../parallel/parallel.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lineindex {
+
+namespace {
+
+struct implementation {
+  backend kind;
+  const char *name;
+  uint32_t required_instruction_sets;
+  const functions &(*table)();
+};
+
+const implementation scalar = {backend::scalar, "scalar", 0,
+                               scalar_functions};
+// Every processor with BMI1 (tzcnt) has popcnt as well.
+const implementation avx2 = {
+    backend::avx2, "avx2", instruction_set::AVX2 | instruction_set::BMI1,
+    avx2_functions};
+const implementation avx512 = {
+    backend::avx512, "avx512",
+    instruction_set::AVX512 | instruction_set::BMI1, avx512_functions};
+
+const implementation *const implementations[] = {&avx512, &avx2, &scalar};
+
+const implementation *best() {
+  static const implementation *best =
+      isa::first_supported(implementations, &scalar);
+  return best;
+}
+
+// nullptr if unknown or unsupported
+const implementation *find(backend kind) {
+  if (kind == backend::automatic) {
+    return best();
+  }
+  return isa::find(implementations, kind);
+}
+
+// The functions of each back end, nullptr if unsupported, found once: an
+// index may be of a single short text, and the calls many.
+const functions *table(backend kind) {
+  struct function_tables {
+    const functions *of[4];
+
+    function_tables() {
+      for (int k = 0; k < 4; k++) {
+        const implementation *impl = find(backend(k));
+        of[k] = impl == nullptr ? nullptr : &impl->table();
+      }
+    }
+  };
+  static const function_tables t;
+  return unsigned(kind) < 4 ? t.of[unsigned(kind)] : nullptr;
+}
+
+constexpr uint64_t packed_byte(uint8_t b) {
+  // replicate the byte 8 times
+  return uint64_t(b) * uint64_t(0x0101010101010101);
+}
+
+// the high bits of the 8 bytes as 8 bits, the first byte lowest
+uint64_t gather_bits(uint64_t high_bits) {
+  return ((high_bits >> 7) * 0x0102040810204080) >> 56;
+}
+
+// The newlines of 8 bytes at a time, as in swarcount of
+// 2017/02/14/newlines.c, but with the exact test for zero bytes, whose
+// high bits are then the bits of the bitmap.
+size_t scalar_mark(const uint8_t *text, size_t words, uint64_t *bitmap) {
+  size_t count = 0;
+  for (size_t k = 0; k < words; k++) {
+    uint64_t bits = 0;
+    for (int j = 0; j < 8; j++) {
+      uint64_t v;
+      memcpy(&v, text + 64 * k + 8 * j, 8);
+      v ^= packed_byte('\n');
+      const uint64_t zeros =
+          ~(((v & packed_byte(0x7f)) + packed_byte(0x7f)) | v) &
+          packed_byte(0x80);
+      bits |= gather_bits(zeros) << (8 * j);
+    }
+    bitmap[k] = bits;
+    count += size_t(__builtin_popcountll(bits));
+  }
+  return count;
+}
+
+// The text goes through a bitmap of this many words at a time (64 kB of
+// text, 8 kB of bitmap), so that the offsets are counted before they are
+// decoded, into just as much room.
+constexpr size_t segment_words = 1024;
+
+// Appends the offset after each '\n' of text[begin, end) to starts. A
+// last block of less than 64 bytes goes through a block padded with zeros.
+void append_starts(const functions &f, const uint8_t *text, size_t begin,
+                   size_t end, std::vector<uint64_t> *starts) {
+  uint64_t bitmap[segment_words];
+  for (size_t i = begin; i < end; i += 64 * segment_words) {
+    const size_t bytes = std::min(end - i, 64 * segment_words);
+    size_t words = bytes / 64;
+    size_t count = f.mark(text + i, words, bitmap);
+    if (bytes % 64 != 0) {
+      uint8_t last[64] = {0};
+      memcpy(last, text + i + 64 * words, bytes % 64);
+      count += f.mark(last, 1, bitmap + words);
+      words++;
+    }
+    if (i == begin) {
+      // room for as many lines in each segment as in the first one, and
+      // some more
+      const size_t segments = (end - begin + bytes - 1) / bytes;
+      starts->reserve(starts->size() + segments * count + count / 8 +
+                      decode_slack);
+    }
+    const size_t size = starts->size();
+    starts->resize(size + count + decode_slack);
+    const uint64_t *written =
+        f.decode(bitmap, words, i + 1, starts->data() + size);
+    starts->resize(size_t(written - starts->data()));
+  }
+}
+
+} // namespace
+
+const functions &scalar_functions() {
+  static const functions functions = {scalar_mark, decode_words};
+  return functions;
+}
+
+bool backend_supported(backend b) { return find(b) != nullptr; }
+
+backend active_backend() { return best()->kind; }
+
+const char *backend_name(backend b) {
+  if (b == backend::automatic) {
+    return best()->name;
+  }
+  return isa::name_of(implementations, b);
+}
+
+// The whole blocks are split between the threads, the last one taking the
+// bytes after them as well; the first thread appends to the starts, the
+// others to parts of their own, copied after them.
+std::vector<uint64_t> line_starts(const char *data, size_t n,
+                                  const options &o) {
+  const functions *f = table(o.kernel);
+  if (f == nullptr) {
+    return {};
+  }
+  const uint8_t *text = reinterpret_cast<const uint8_t *>(data);
+  std::vector<uint64_t> starts = {0};
+  const size_t blocks = n / 64;
+  unsigned threads = parallel::thread_count(o.threads);
+  if (blocks * 64 / threads < parallel::minimum_bytes) {
+    threads = 1;
+  }
+  auto slice = [blocks, threads, n](unsigned t) {
+    return t == threads ? n : t * blocks / threads * 64;
+  };
+  std::vector<std::vector<uint64_t>> parts(threads);
+  parallel::in_parallel(threads, [&](unsigned t) {
+    append_starts(*f, text, slice(t), slice(t + 1),
+                  t == 0 ? &starts : &parts[t]);
+  });
+  size_t count = starts.size();
+  for (unsigned t = 1; t < threads; t++) {
+    count += parts[t].size();
+  }
+  starts.reserve(count + 1);
+  for (unsigned t = 1; t < threads; t++) {
+    starts.insert(starts.end(), parts[t].begin(), parts[t].end());
+  }
+  if (n > 0 && data[n - 1] != '\n') {
+    starts.push_back(n + 1);
+  }
+  return starts;
+}
+
+index::index(const char *data, size_t n, const options &o)
+    : data_(data), bytes_(n), starts_(line_starts(data, n, o)) {
+  if (starts_.empty()) {
+    starts_.push_back(0);
+  }
+}
+
+size_t index::line_of(uint64_t offset) const {
+  if (offset >= bytes_) {
+    return size();
+  }
+  return size_t(std::upper_bound(starts_.begin(), starts_.end(), offset) -
+                starts_.begin()) -
+         1;
+}
+
+bool file::open(const char *filename, const options &o) {
+  close();
+  if (table(o.kernel) == nullptr) {
+    errno = ENOTSUP;
+    return false;
+  }
+  // O_NONBLOCK: a FIFO would wait for a writer before being rejected
+  const int fd = ::open(filename, O_RDONLY | O_NONBLOCK);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat s;
+  void *mapping = nullptr;
+  int error = 0;
+  if (fstat(fd, &s) != 0) {
+    error = errno;
+  } else if (!S_ISREG(s.st_mode)) {
+    // pipes, sockets and devices have no size to map
+    error = S_ISDIR(s.st_mode) ? EISDIR : ENODEV;
+  } else if (s.st_size > 0 &&
+             (mapping = mmap(nullptr, size_t(s.st_size), PROT_READ,
+                             MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+    error = errno;
+  }
+  // the mapping stays without the descriptor
+  ::close(fd);
+  if (error != 0) {
+    errno = error;
+    return false;
+  }
+  data_ = static_cast<const char *>(mapping);
+  size_ = size_t(s.st_size);
+  lines_ = index(data_, size_, o);
+  return true;
+}
+
+void file::close() {
+  if (data_ != nullptr) {
+    munmap(const_cast<char *>(data_), size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+  lines_ = index();
+}
+
+} // namespace lineindex
@@ -0,0 +1,148 @@
+// The lines of a large text (a log of several GB, say) indexed once, in a
+// compact table of where each one starts, for random access and for
+// iteration without a copy: a file is mapped in memory rather than read,
+// and a line is a std::string_view into the mapping (C++17).
+//
+// 2017/02/14/newlines.c counts the newlines of a buffer (swarcount,
+// avxcount) and 2019/06/18/getline.cpp and 2019/07/26/getlines.cpp show
+// how slow std::getline is at going over them. Here the vectors (AVX2 or
+// AVX-512, picked at runtime) compare 64 bytes at a time with '\n' into
+// the bits of a bitmap, for 64 kB of text at a time, and the bitmap is
+// decoded into offsets as in extra/bitmapdecoding: the unrolled decoder of
+// 2022/05/10/bitmapdecoding.cpp, and on AVX-512 the compress of 8 offsets
+// at a time where the lines are short. The text may be split between
+// threads.
+//
+//   lineindex::file f;
+//   if (!f.open("access.log")) perror("access.log");
+//   printf("%zu lines\n", f.lines().size());
+//   std::string_view l = f.lines()[1000000];
+//   fwrite(l.data(), 1, l.size(), stdout);
+//   for (std::string_view l : f.lines()) { ... }
+#ifndef LINEINDEX_H
+#define LINEINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+namespace lineindex {
+
+struct functions; // of a back end, in lineindex_kernels.h
+
+enum class backend {
+  automatic, // best supported one
+  scalar,
+  avx2,
+  avx512
+};
+
+// Whether the back end can run on this processor, and its name.
+bool backend_supported(backend b);
+backend active_backend();
+const char *backend_name(backend b);
+
+struct options {
+  backend kernel = backend::automatic;
+  // 0 for one per hardware thread.
+  unsigned threads = 1;
+};
+
+// A line without its '\n' (a '\r' before it stays, as with std::getline),
+// in the text it was found in.
+using line = std::string_view;
+
+// Where the lines of data[0, n) start, in order, and one more entry, so
+// that line i is data[starts[i], starts[i + 1] - 1): that entry is n if
+// the text ends with '\n' and n + 1 if it does not. A text has a line for
+// each '\n', and one more if anything comes after the last one; an empty
+// text has none, and gives {0}. Empty for an unsupported back end.
+std::vector<uint64_t> line_starts(const char *data, size_t n,
+                                  const options &o = options());
+
+// The lines of a text that outlives the index.
+class index {
+public:
+  class iterator {
+  public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef lineindex::line value_type;
+    typedef ptrdiff_t difference_type;
+    typedef const lineindex::line *pointer;
+    typedef lineindex::line reference;
+
+    iterator(const index *lines, size_t i) : lines_(lines), i_(i) {}
+    lineindex::line operator*() const { return (*lines_)[i_]; }
+    iterator &operator++() {
+      i_++;
+      return *this;
+    }
+    iterator operator++(int) {
+      iterator before = *this;
+      i_++;
+      return before;
+    }
+    bool operator==(const iterator &other) const { return i_ == other.i_; }
+    bool operator!=(const iterator &other) const { return i_ != other.i_; }
+
+  private:
+    const index *lines_;
+    size_t i_;
+  };
+
+  index() = default;
+  // No lines for an unsupported back end.
+  index(const char *data, size_t n, const options &o = options());
+
+  size_t size() const { return starts_.size() - 1; }
+  bool empty() const { return size() == 0; }
+  lineindex::line operator[](size_t i) const {
+    return lineindex::line(data_ + starts_[i],
+                           size_t(starts_[i + 1] - starts_[i] - 1));
+  }
+  iterator begin() const { return iterator(this, 0); }
+  iterator end() const { return iterator(this, size()); }
+
+  // The line of the byte at offset (its '\n' included), size() for an
+  // offset past the text.
+  size_t line_of(uint64_t offset) const;
+  // As line_starts gives them.
+  const std::vector<uint64_t> &starts() const { return starts_; }
+
+private:
+  const char *data_ = nullptr;
+  size_t bytes_ = 0;
+  std::vector<uint64_t> starts_ = {0};
+};
+
+// A file mapped in memory, read only, and its lines, which point into the
+// mapping until the file is closed.
+class file {
+public:
+  file() = default;
+  file(const file &) = delete;
+  file &operator=(const file &) = delete;
+  ~file() { close(); }
+
+  // Closes what was open, then maps the file and indexes its lines; false,
+  // with errno set, if the file cannot be opened or mapped (ENOTSUP for an
+  // unsupported back end, EISDIR for a directory, ENODEV for a pipe, a
+  // device or anything else that is not a regular file).
+  bool open(const char *filename, const options &o = options());
+  void close();
+
+  const char *data() const { return data_; }
+  size_t size() const { return size_; } // bytes
+  const index &lines() const { return lines_; }
+
+private:
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+  index lines_;
+};
+
+} // namespace lineindex
+
+#endif // LINEINDEX_H
@@ -0,0 +1,38 @@
+// The AVX2 back end: the 64 bytes of a word in two vectors compared with
+// '\n', as in avxcount of 2017/02/14/newlines.c, and their bits gathered
+// with movemask; the decoder is the unrolled one, with tzcnt and popcnt.
+// Compiled with -mavx2 -mbmi -mpopcnt.
+#include "lineindex_kernels.h"
+
+#include <immintrin.h>
+
+namespace lineindex {
+namespace {
+
+size_t avx2_mark(const uint8_t *text, size_t words, uint64_t *bitmap) {
+  const __m256i newline = _mm256_set1_epi8('\n');
+  size_t count = 0;
+  for (size_t k = 0; k < words; k++) {
+    const __m256i low = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(text + 64 * k));
+    const __m256i high = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i *>(text + 64 * k + 32));
+    const uint64_t bits =
+        uint32_t(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, newline))) |
+        uint64_t(uint32_t(_mm256_movemask_epi8(
+            _mm256_cmpeq_epi8(high, newline))))
+            << 32;
+    bitmap[k] = bits;
+    count += size_t(_mm_popcnt_u64(bits));
+  }
+  return count;
+}
+
+} // namespace
+
+const functions &avx2_functions() {
+  static const functions functions = {avx2_mark, decode_words};
+  return functions;
+}
+
+} // namespace lineindex
@@ -0,0 +1,58 @@
+// The AVX-512 back end: the 64 bytes of a word compared with '\n' into a
+// mask (AVX512BW) that is the word itself. Words of more than 8 lines are
+// decoded as avx512_decoder of 2022/05/10/bitmapdecoding.cpp does, each
+// byte of the word the mask of a compress of 8 offsets; the others by the
+// unrolled decoder. Compiled with -mavx512f -mavx512bw -mbmi -mpopcnt.
+#include "lineindex_kernels.h"
+
+#include <immintrin.h>
+
+namespace lineindex {
+namespace {
+
+size_t avx512_mark(const uint8_t *text, size_t words, uint64_t *bitmap) {
+  const __m512i newline = _mm512_set1_epi8('\n');
+  size_t count = 0;
+  for (size_t k = 0; k < words; k++) {
+    const uint64_t bits = _mm512_cmpeq_epi8_mask(
+        _mm512_loadu_si512(text + 64 * k), newline);
+    bitmap[k] = bits;
+    count += size_t(_mm_popcnt_u64(bits));
+  }
+  return count;
+}
+
+// Each compress stores 8 offsets, of which the next one overwrites those
+// past its mask: decode_slack is enough for the last one.
+inline uint64_t *compress_word(uint64_t bits, uint64_t base, uint64_t *out) {
+  const __m512i eight = _mm512_set1_epi64(8);
+  __m512i offsets = _mm512_add_epi64(_mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7),
+                                     _mm512_set1_epi64(int64_t(base)));
+#pragma GCC unroll 8
+  for (int i = 0; i < 8; i++) {
+    const __mmask8 mask = __mmask8(bits >> (8 * i));
+    _mm512_storeu_si512(out, _mm512_maskz_compress_epi64(mask, offsets));
+    out += _mm_popcnt_u32(mask);
+    offsets = _mm512_add_epi64(offsets, eight);
+  }
+  return out;
+}
+
+uint64_t *avx512_decode(const uint64_t *bitmap, size_t words, uint64_t base,
+                        uint64_t *out) {
+  for (size_t k = 0; k < words; k++, base += 64) {
+    const uint64_t bits = bitmap[k];
+    out = _mm_popcnt_u64(bits) > 8 ? compress_word(bits, base, out)
+                                   : decode_word(bits, base, out);
+  }
+  return out;
+}
+
+} // namespace
+
+const functions &avx512_functions() {
+  static const functions functions = {avx512_mark, avx512_decode};
+  return functions;
+}
+
+} // namespace lineindex
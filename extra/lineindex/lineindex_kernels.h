@@ -0,0 +1,74 @@
+// The functions of each back end, and the decoder of bitmaps into offsets
+// that they share. Only the lineindex*.cpp files include this header.
+#ifndef LINEINDEX_KERNELS_H
+#define LINEINDEX_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "lineindex.h"
+
+namespace lineindex {
+
+// Entries a decoder may write past the last offset it gives.
+constexpr size_t decode_slack = 8;
+
+struct functions {
+  // Bit i of bitmap[k] set for a '\n' at text[64 * k + i], for the words
+  // 64-byte blocks of text; returns the number of bits set.
+  size_t (*mark)(const uint8_t *text, size_t words, uint64_t *bitmap);
+  // base + 64 * k + i for each bit i set in bitmap[k], in order, into out,
+  // which has room for them and decode_slack more; returns the end of the
+  // offsets written.
+  uint64_t *(*decode)(const uint64_t *bitmap, size_t words, uint64_t base,
+                      uint64_t *out);
+};
+
+const functions &scalar_functions();
+const functions &avx2_functions();
+const functions &avx512_functions();
+
+// In an unnamed namespace: each back end compiles its own copy with its
+// own instruction sets (tzcnt and popcnt for AVX2 and AVX-512).
+namespace {
+
+// The unrolled decoder of extra/bitmapdecoding (faster_decoder of
+// 2022/05/10/bitmapdecoding.cpp) with 64-bit offsets. Most words of a log
+// have no line or one, at random, so the first 2 offsets are written
+// whatever the number of bits, even none, without a branch; the next 6
+// only for more than 2. Bit 63 is or-ed in for the trailing zero counts
+// past the last bit, whose offsets are not kept.
+inline uint64_t *decode_word(uint64_t bits, uint64_t base, uint64_t *out) {
+  const size_t count = size_t(__builtin_popcountll(bits));
+  const uint64_t last = uint64_t(1) << 63;
+  out[0] = base + uint64_t(__builtin_ctzll(bits | last));
+  bits &= bits - 1;
+  out[1] = base + uint64_t(__builtin_ctzll(bits | last));
+  bits &= bits - 1;
+  if (count > 2) {
+#pragma GCC unroll 6
+    for (int i = 2; i < 8; i++) {
+      out[i] = base + uint64_t(__builtin_ctzll(bits | last));
+      bits &= bits - 1;
+    }
+    for (size_t i = 8; i < count; i++) {
+      out[i] = base + uint64_t(__builtin_ctzll(bits));
+      bits &= bits - 1;
+    }
+  }
+  return out + count;
+}
+
+inline uint64_t *decode_words(const uint64_t *bitmap, size_t words,
+                              uint64_t base, uint64_t *out) {
+  for (size_t k = 0; k < words; k++, base += 64) {
+    out = decode_word(bitmap[k], base, out);
+  }
+  return out;
+}
+
+} // namespace
+
+} // namespace lineindex
+
+#endif // LINEINDEX_KERNELS_H
@@ -0,0 +1,241 @@
+// Checks of every back end: texts by hand, then random texts of every
+// length up to 300 and longer ones, with lines of every length from none
+// to hundreds of bytes, whose starts must be those of a plain loop written
+// here and whose lines must be those of std::getline; texts large enough
+// to be split between threads; and files, mapped, but not directories or
+// devices.
+#include "lineindex.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+const lineindex::backend backends[] = {
+    lineindex::backend::automatic, lineindex::backend::scalar,
+    lineindex::backend::avx2, lineindex::backend::avx512};
+
+std::mt19937_64 gen(1234);
+
+std::vector<uint64_t> expected_starts(const std::string &s) {
+  std::vector<uint64_t> starts = {0};
+  for (size_t i = 0; i < s.size(); i++) {
+    if (s[i] == '\n') {
+      starts.push_back(i + 1);
+    }
+  }
+  if (!s.empty() && s.back() != '\n') {
+    starts.push_back(s.size() + 1);
+  }
+  return starts;
+}
+
+// The lines are string views into the text, through the iterator as well.
+static_assert(std::is_same<decltype(*lineindex::index().begin()),
+                           std::string_view>::value,
+              "the lines of an index are string views");
+
+// The lines of the index of text (s or a copy of it) against those of
+// std::getline, in order and one by one, pointing into text; every offset
+// against its line if all_offsets.
+bool check_lines(const std::string &s, const char *text,
+                 const lineindex::index &lines, bool all_offsets) {
+  std::istringstream in(s);
+  std::string expected;
+  size_t i = 0;
+  for (std::string_view l : lines) {
+    if (!std::getline(in, expected) || i >= lines.size() || l != expected ||
+        l.data() != text + lines.starts()[i] ||
+        lines[i].data() != l.data() || lines[i].size() != l.size()) {
+      printf("bug: line %zu\n", i);
+      return false;
+    }
+    i++;
+  }
+  if (std::getline(in, expected) || i != lines.size()) {
+    printf("bug: %zu lines\n", i);
+    return false;
+  }
+  for (size_t offset = 0; all_offsets && offset <= s.size(); offset++) {
+    const size_t line = lines.line_of(offset);
+    const bool ok =
+        offset == s.size()
+            ? line == lines.size()
+            : line < lines.size() && lines.starts()[line] <= offset &&
+                  offset < lines.starts()[line + 1];
+    if (!ok) {
+      printf("bug: byte %zu in line %zu\n", offset, line);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool check_text(const std::string &s, lineindex::backend b,
+                unsigned threads) {
+  lineindex::options o;
+  o.kernel = b;
+  o.threads = threads;
+  const lineindex::index lines(s.data(), s.size(), o);
+  if (lines.starts() != expected_starts(s) ||
+      lineindex::line_starts(s.data(), s.size(), o) != lines.starts()) {
+    printf("bug: %s, %u threads, %zu bytes, %zu lines\n",
+           lineindex::backend_name(b), threads, s.size(),
+           expected_starts(s).size() - 1);
+    return false;
+  }
+  if (!check_lines(s, s.data(), lines, s.size() <= 1000)) {
+    printf("bug: %s, %zu bytes\n", lineindex::backend_name(b), s.size());
+    return false;
+  }
+  return true;
+}
+
+bool check_examples(lineindex::backend b) {
+  struct example {
+    const char *text;
+    std::vector<std::string> lines;
+  };
+  const example examples[] = {
+      {"", {}},
+      {"\n", {""}},
+      {"a", {"a"}},
+      {"a\n", {"a"}},
+      {"a\nb", {"a", "b"}},
+      {"\n\n", {"", ""}},
+      {"a\r\nb\r\n", {"a\r", "b\r"}},
+      {"\n\nlast", {"", "", "last"}},
+  };
+  lineindex::options o;
+  o.kernel = b;
+  for (const example &e : examples) {
+    const lineindex::index lines(e.text, strlen(e.text), o);
+    bool ok = lines.size() == e.lines.size() &&
+              lines.empty() == e.lines.empty();
+    for (size_t i = 0; ok && i < lines.size(); i++) {
+      ok = lines[i] == e.lines[i];
+    }
+    if (!ok || !check_text(e.text, b, 1)) {
+      printf("bug: %s, \"%s\"\n", lineindex::backend_name(b), e.text);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Random text with n bytes, the lines about length bytes long, and now
+// and then runs of empty lines. A few bytes are those that differ from
+// '\n' by one bit, or by the high bit.
+std::string random_text(size_t n, size_t length) {
+  const char close[] = "\x0b\x08\x8a\x0e\x1a\xff";
+  std::string s;
+  while (s.size() < n) {
+    if (gen() % 16 == 0) {
+      s.append(gen() % 80, '\n');
+    }
+    const size_t size = gen() % (2 * length + 1);
+    for (size_t i = 0; i < size; i++) {
+      s += gen() % 32 == 0 ? close[gen() % (sizeof(close) - 1)]
+                           : char(' ' + gen() % 95);
+    }
+    s += gen() % 8 == 0 ? "\r\n" : "\n";
+  }
+  s.resize(n);
+  return s;
+}
+
+bool check_file(const std::string &s, lineindex::backend b) {
+  char name[] = "/tmp/lineindex_testXXXXXX";
+  const int fd = mkstemp(name);
+  if (fd < 0 || write(fd, s.data(), s.size()) != ssize_t(s.size())) {
+    printf("cannot write %s\n", name);
+    return false;
+  }
+  close(fd);
+  lineindex::options o;
+  o.kernel = b;
+  lineindex::file f;
+  bool ok = f.open(name, o) && f.size() == s.size() &&
+            (s.empty() || memcmp(f.data(), s.data(), s.size()) == 0) &&
+            f.lines().starts() == expected_starts(s) &&
+            check_lines(s, f.data(), f.lines(), false);
+  // again, after what was open is closed
+  ok = ok && f.open(name, o) && f.lines().starts() == expected_starts(s);
+  f.close();
+  ok = ok && f.data() == nullptr && f.lines().empty();
+  unlink(name);
+  if (!ok) {
+    printf("bug: %s, file of %zu bytes\n", lineindex::backend_name(b),
+           s.size());
+  }
+  return ok;
+}
+
+bool check_backend(lineindex::backend b) {
+  if (!check_examples(b)) {
+    return false;
+  }
+  for (size_t n = 0; n <= 300; n++) {
+    for (int t = 0; t < 20; t++) {
+      if (!check_text(random_text(n, size_t(1) << (gen() % 8)), b, 1)) {
+        return false;
+      }
+    }
+  }
+  // over several segments of bitmap
+  for (size_t length : {1, 4, 40, 1000, 100000}) {
+    if (!check_text(random_text(100000 + gen() % 100000, length), b, 1)) {
+      return false;
+    }
+  }
+  // split between threads, up to a piece each with no line
+  const std::string large = random_text((size_t(5) << 20) + 17, 60);
+  const std::string few = random_text((size_t(5) << 20) + 17, 1 << 20);
+  for (unsigned threads : {0u, 2u, 3u, 4u, 7u}) {
+    if (!check_text(large, b, threads) || !check_text(few, b, threads)) {
+      return false;
+    }
+  }
+  for (size_t n : {0, 1, 64, 1000, 100000}) {
+    if (!check_file(random_text(n, 40), b)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main() {
+  printf("best back end: %s\n",
+         lineindex::backend_name(lineindex::active_backend()));
+  for (lineindex::backend b : backends) {
+    if (lineindex::backend_supported(b) && !check_backend(b)) {
+      printf("bug!\n");
+      return EXIT_FAILURE;
+    }
+  }
+  lineindex::file f;
+  if (f.open("/nonexistent/lineindex") || errno != ENOENT) {
+    printf("bug: a file that does not exist\n");
+    return EXIT_FAILURE;
+  }
+  // not regular files: their size says nothing of what they hold
+  if (f.open("/") || errno != EISDIR ||
+      f.open("/dev/null") || errno != ENODEV) {
+    printf("bug: a directory or a device\n");
+    return EXIT_FAILURE;
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
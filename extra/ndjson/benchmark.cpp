@@ -0,0 +1,296 @@
+// Throughput of the pipeline over 256 MB of events: the 100 statuses of
+// 2020/12/13/twitter.json, one per line with a space after each colon and
+// comma (so that minify has work to do), over and over; or over the file
+// given as argument. For reference, first parse_many and simdjson::minify
+// over the whole buffer at once, as 2020/12/13/benchmark.cpp does over
+// twitter.json; then the pipeline, reading from memory (from the file if
+// there is one), with one or more parsers, smaller chunks and batches,
+// the thread of parse_many, a consumer that reads two fields and the
+// minifier. Each stage gets its GB/s over the time it was busy.
+#include "ndjson.h"
+
+#include "../harness/harness.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+// s, minified, with a space after each colon and comma outside strings
+std::string spaced(const std::string &s) {
+  std::string out;
+  bool in_string = false;
+  for (size_t i = 0; i < s.size(); i++) {
+    out += s[i];
+    if (in_string) {
+      if (s[i] == '\\') {
+        out += s[++i];
+      } else if (s[i] == '"') {
+        in_string = false;
+      }
+    } else if (s[i] == '"') {
+      in_string = true;
+    } else if (s[i] == ':' || s[i] == ',') {
+      out += ' ';
+    }
+  }
+  return out;
+}
+
+bool make_events(size_t size, std::string *text) {
+  simdjson::dom::parser parser;
+  simdjson::dom::array statuses;
+  if (parser.load("../../2020/12/13/twitter.json")["statuses"].get(statuses)) {
+    return false;
+  }
+  std::string lines;
+  for (simdjson::dom::element status : statuses) {
+    lines += spaced(simdjson::minify(status)) + "\n";
+  }
+  while (text->size() < size) {
+    *text += lines;
+  }
+  return true;
+}
+
+bool load(const char *filename, std::string *text) {
+  FILE *f = fopen(filename, "rb");
+  if (f == nullptr) {
+    return false;
+  }
+  char buffer[1 << 16];
+  while (size_t n = fread(buffer, 1, sizeof(buffer), f)) {
+    text->append(buffer, n);
+  }
+  fclose(f);
+  return true;
+}
+
+struct input {
+  const std::string &text;
+  const char *filename; // nullptr to read from memory
+
+  ndjson::report process(const ndjson::consumer &each,
+                         const ndjson::options &o) const {
+    if (filename != nullptr) {
+      return ndjson::process(filename, each, o);
+    }
+    size_t offset = 0;
+    return ndjson::process([&](char *buffer, size_t capacity) {
+      const size_t n = std::min(capacity, text.size() - offset);
+      memcpy(buffer, text.data() + offset, n);
+      offset += n;
+      return ptrdiff_t(n);
+    }, each, o);
+  }
+
+  ndjson::report minify(std::string *out, const ndjson::options &o) const {
+    size_t offset = 0, written = 0;
+    const ndjson::writer to_out = [&](const char *data, size_t n) {
+      memcpy(&(*out)[written], data, n);
+      written += n;
+      return true;
+    };
+    ndjson::report r;
+    if (filename != nullptr) {
+      FILE *f = fopen(filename, "rb");
+      if (f == nullptr) {
+        r.ok = false;
+        return r;
+      }
+      r = ndjson::minify([f](char *buffer, size_t capacity) {
+        return ptrdiff_t(fread(buffer, 1, capacity, f));
+      }, to_out, o);
+      fclose(f);
+    } else {
+      r = ndjson::minify([&](char *buffer, size_t capacity) {
+        const size_t n = std::min(capacity, text.size() - offset);
+        memcpy(buffer, text.data() + offset, n);
+        offset += n;
+        return ptrdiff_t(n);
+      }, to_out, o);
+    }
+    out->resize(written);
+    return r;
+  }
+};
+
+void print_stage(const ndjson::stage &s) {
+  if (s.seconds == 0) {
+    printf("\t%6s", "-");
+  } else {
+    printf("\t%6.2f", s.gigabytes_per_second());
+  }
+}
+
+// Runs f, which returns a report, and prints the GB/s of the fastest run
+// and of its stages; false on error or if documents differ.
+template <class F>
+bool time(const char *name, size_t bytes, size_t documents, F f,
+          harness::options &opts) {
+  ndjson::report best;
+  bool ok = true;
+  auto r = harness::run(name, bytes, [&] {
+    const ndjson::report report = f();
+    ok = ok && report.ok && report.documents == documents;
+    if (best.seconds == 0 || report.seconds < best.seconds) {
+      best = report;
+    }
+  }, opts);
+  if (opts.format != HARNESS_TEXT) {
+    r.report();
+  } else {
+    printf("%-34s\t%6.2f", name, bytes / r.min());
+    print_stage(best.read);
+    print_stage(best.parse);
+    print_stage(best.consume);
+    print_stage(best.minify);
+    print_stage(best.write);
+    printf("\n");
+  }
+  return ok;
+}
+
+// The fastest of the runs of f over the whole buffer, in GB/s.
+template <class F>
+bool time_whole(const char *name, size_t bytes, F f, harness::options &opts) {
+  bool ok = true;
+  auto r = harness::run(name, bytes, [&] { ok = f() && ok; }, opts);
+  if (opts.format != HARNESS_TEXT) {
+    r.report();
+  } else {
+    printf("%-34s\t%6.2f\n", name, bytes / r.min());
+  }
+  return ok;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::string text;
+  const char *filename = argc > 1 ? argv[1] : nullptr;
+  if (filename != nullptr ? !load(filename, &text)
+                          : !make_events(size_t(256) << 20, &text)) {
+    printf("cannot read %s\n",
+           filename != nullptr ? filename : "2020/12/13/twitter.json");
+    return EXIT_FAILURE;
+  }
+  text.reserve(text.size() + simdjson::SIMDJSON_PADDING);
+  const input in{text, filename};
+  harness::options opts = harness::default_options();
+  opts.repeat = 5;
+  // documents, from the pipeline with its defaults
+  const ndjson::report reference = in.process(nullptr, ndjson::options());
+  if (!reference.ok) {
+    printf("%s at byte %zu\n", reference.error.c_str(),
+           reference.error_offset);
+    return EXIT_FAILURE;
+  }
+  const size_t documents = reference.documents;
+  printf("%zu MB, %zu documents, %s, simdjson %s (%s), %u hardware "
+         "threads\n",
+         text.size() >> 20, documents,
+         filename != nullptr ? filename : "from memory",
+         STRINGIFY(SIMDJSON_VERSION),
+         simdjson::active_implementation->name().c_str(),
+         std::thread::hardware_concurrency());
+  printf("GB/s                              \twall\tread\tparse\tconsume"
+         "\tminify\twrite\n");
+  bool ok = true;
+  simdjson::dom::parser parser;
+  ok = time_whole("parse_many, one buffer", text.size(), [&] {
+    simdjson::dom::document_stream stream;
+    if (parser.parse_many(text.data(), text.size(),
+                          simdjson::dom::DEFAULT_BATCH_SIZE)
+            .get(stream)) {
+      return false;
+    }
+    size_t count = 0;
+    for (auto document : stream) {
+      count += document.error() == simdjson::SUCCESS;
+    }
+    return count == documents;
+  }, opts) && ok;
+  std::string out(text.size() + 64, '\0');
+  ok = time_whole("minify, one buffer", text.size(), [&] {
+    size_t length = 0;
+    return !simdjson::minify(text.data(), text.size(), &out[0], length);
+  }, opts) && ok;
+
+  struct config {
+    const char *name;
+    unsigned parsers;
+    size_t chunk_size;
+    size_t batch_size;
+    bool stage1_thread;
+  };
+  const size_t mb = 1 << 20;
+  const config configs[] = {
+      {"validate, 1 parser", 1, 4 * mb, simdjson::dom::DEFAULT_BATCH_SIZE,
+       false},
+      {"validate, 64 KiB chunks", 1, 64 << 10, 64 << 10, false},
+      {"validate, 64 KiB batches", 1, 4 * mb, 64 << 10, false},
+      {"validate, 32 MiB chunks", 1, 32 * mb,
+       simdjson::dom::DEFAULT_BATCH_SIZE, false},
+      {"validate, stage 1 thread", 1, 32 * mb,
+       simdjson::dom::DEFAULT_BATCH_SIZE, true},
+      {"validate, 2 parsers", 2, 4 * mb, simdjson::dom::DEFAULT_BATCH_SIZE,
+       false},
+      {"validate, 4 parsers", 4, 4 * mb, simdjson::dom::DEFAULT_BATCH_SIZE,
+       false}};
+  for (const config &c : configs) {
+    ndjson::options o;
+    o.parsers = c.parsers;
+    o.chunk_size = c.chunk_size;
+    o.batch_size = c.batch_size;
+    o.stage1_thread = c.stage1_thread;
+    ok = time(c.name, text.size(), documents,
+              [&] { return in.process(nullptr, o); }, opts) &&
+         ok;
+  }
+  // the followers of the authors, and the retweets, per parser
+  for (unsigned parsers : {1u, 2u}) {
+    ndjson::options o;
+    o.parsers = parsers;
+    std::vector<uint64_t> sums(parsers * 8, 0);
+    const ndjson::consumer each = [&sums](simdjson::dom::element status,
+                                          unsigned parser) {
+      uint64_t followers = 0, retweets = 0;
+      if (!status["user"]["followers_count"].get(followers) &&
+          !status["retweet_count"].get(retweets)) {
+        sums[parser * 8] += followers + retweets; // a cache line apart
+      }
+    };
+    ok = time(parsers == 1 ? "consume, 1 parser" : "consume, 2 parsers",
+              text.size(), documents, [&] { return in.process(each, o); },
+              opts) &&
+         ok;
+  }
+  for (unsigned parsers : {1u, 2u}) {
+    ndjson::options o;
+    o.parsers = parsers;
+    ok = time(parsers == 1 ? "minify, 1 parser" : "minify, 2 parsers",
+              text.size(), documents, [&] { return in.minify(&out, o); },
+              opts) &&
+         ok;
+  }
+  // the minified output holds the same documents, on fewer bytes
+  size_t offset = 0;
+  const ndjson::report again = ndjson::process(
+      [&](char *buffer, size_t capacity) {
+        const size_t n = std::min(capacity, out.size() - offset);
+        memcpy(buffer, out.data() + offset, n);
+        offset += n;
+        return ptrdiff_t(n);
+      },
+      nullptr, ndjson::options());
+  if (!ok || !again.ok || again.documents != documents ||
+      out.size() >= text.size()) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
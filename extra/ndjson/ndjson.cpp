@@ -0,0 +1,417 @@
+// The pipeline of ndjson.h. The chunks go around three queues: empty
+// (reader), full (parsers) and done (the calling thread, which puts them
+// back in input order with their sequence numbers). Each stage adds up
+// its own times and hands them over once, at the end.
+#include "ndjson.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ndjson {
+
+namespace {
+
+typedef std::chrono::steady_clock clock_type;
+
+double since(clock_type::time_point start) {
+  return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+// pop() waits for an item, and fails once the queue is closed and empty.
+template <class T> class queue {
+public:
+  void push(T item) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      items_.push_back(item);
+    }
+    ready_.notify_one();
+  }
+
+  bool pop(T *item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_.wait(lock, [this] { return !items_.empty() || closed_; });
+    if (items_.empty()) {
+      return false;
+    }
+    *item = items_.front();
+    items_.pop_front();
+    return true;
+  }
+
+  void close() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      closed_ = true;
+    }
+    ready_.notify_all();
+  }
+
+private:
+  std::mutex mutex_;
+  std::condition_variable ready_;
+  std::deque<T> items_;
+  bool closed_ = false;
+};
+
+// simdjson::minify stores whole blocks of 64 bytes, so its output needs
+// that much room after the last byte; then comes the newline.
+constexpr size_t minify_slack = 64 + 1;
+
+struct chunk {
+  chunk(size_t capacity, bool minifying)
+      : data(new char[capacity + simdjson::SIMDJSON_PADDING]),
+        out(minifying ? new char[capacity + minify_slack] : nullptr) {}
+
+  std::unique_ptr<char[]> data; // whole lines, then what simdjson may read
+  std::unique_ptr<char[]> out;  // the lines minified
+  size_t size = 0;
+  size_t out_size = 0;
+  size_t offset = 0;   // of data[0] in the input
+  size_t sequence = 0; // of the chunk in the input
+  size_t documents = 0;
+  simdjson::error_code error = simdjson::SUCCESS;
+  size_t error_offset = 0;
+};
+
+struct pipeline {
+  pipeline(const options &opts, const consumer *c, bool minifying)
+      : o(opts), each(c), minifying(minifying) {
+    if (o.parsers == 0) {
+      const unsigned hardware = std::thread::hardware_concurrency();
+      o.parsers = hardware == 0 ? 1 : hardware;
+    }
+    if (o.chunks == 0) {
+      o.chunks = o.parsers + 2;
+    }
+    for (unsigned k = 0; k < o.chunks; k++) {
+      chunks.emplace_back(new chunk(o.chunk_size, minifying));
+      empty.push(chunks.back().get());
+    }
+    running = o.parsers;
+  }
+
+  // Keeps the error that comes first in the input, and stops the reader.
+  void fail(size_t offset, const std::string &message) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (r.ok || offset < r.error_offset) {
+      r.ok = false;
+      r.error = message;
+      r.error_offset = offset;
+    }
+    stop = true;
+  }
+
+  void add(stage *to, const stage &from) {
+    std::lock_guard<std::mutex> lock(mutex);
+    to->bytes += from.bytes;
+    to->seconds += from.seconds;
+  }
+
+  options o;
+  const consumer *each; // nullptr to validate only
+  bool minifying;
+  std::vector<std::unique_ptr<chunk>> chunks;
+  queue<chunk *> empty, full, done;
+  std::atomic<bool> stop{false};
+  std::atomic<unsigned> running; // parsers, the last one closes done
+  std::mutex mutex;              // for r
+  report r;
+};
+
+// Fills the empty chunks with whole lines: the bytes after the last
+// newline of a chunk start the next one.
+void read_chunks(pipeline &p, const reader &input) {
+  std::string carried;
+  size_t offset = 0, sequence = 0;
+  stage read;
+  bool end = false;
+  chunk *c;
+  while (!end && p.empty.pop(&c)) {
+    if (p.stop) {
+      p.empty.push(c);
+      break;
+    }
+    memcpy(c->data.get(), carried.data(), carried.size());
+    size_t n = carried.size();
+    const auto start = clock_type::now();
+    while (n < p.o.chunk_size) {
+      const ptrdiff_t got = input(c->data.get() + n, p.o.chunk_size - n);
+      if (got <= 0) {
+        end = true;
+        if (got < 0) {
+          p.fail(offset + n, "cannot read the input");
+        }
+        break;
+      }
+      n += size_t(got);
+    }
+    read.seconds += since(start);
+    read.bytes += n - carried.size();
+    if (p.stop) {
+      p.empty.push(c);
+      break;
+    }
+    size_t size = n;
+    if (!end) {
+      const char *last =
+          static_cast<const char *>(memrchr(c->data.get(), '\n', n));
+      if (last == nullptr) {
+        p.fail(offset, "line longer than a chunk");
+        p.empty.push(c);
+        break;
+      }
+      size = size_t(last - c->data.get()) + 1;
+    }
+    carried.assign(c->data.get() + size, n - size);
+    if (size == 0) {
+      p.empty.push(c);
+      break;
+    }
+    c->size = size;
+    c->offset = offset;
+    c->sequence = sequence++;
+    offset += size;
+    p.full.push(c);
+  }
+  p.add(&p.r.read, read);
+  p.full.close();
+}
+
+// The lines of data[0, size) minified into out, each with its newline;
+// blank lines give nothing.
+size_t minify_lines(const char *data, size_t size, char *out) {
+  const char *line = data;
+  const char *const end = data + size;
+  size_t written = 0;
+  while (line < end) {
+    const char *newline =
+        static_cast<const char *>(memchr(line, '\n', size_t(end - line)));
+    const char *line_end = newline == nullptr ? end : newline;
+    size_t length = 0;
+    if (simdjson::minify(line, size_t(line_end - line), out + written,
+                         length) == simdjson::SUCCESS &&
+        length > 0) {
+      written += length;
+      out[written++] = '\n';
+    }
+    line = line_end + 1;
+  }
+  return written;
+}
+
+// The line of data[from, end) that holds the first error, found with
+// parser.parse over one line at a time; the documents before it go to
+// the consumer. When simdjson finds the error in the structure of a whole
+// batch, parse_many gives none of its documents and from is the start of
+// the batch.
+void find_error(pipeline &p, unsigned id, simdjson::dom::parser &parser,
+                chunk *c, size_t from, double *consuming) {
+  const char *line = c->data.get() + from;
+  const char *const end = c->data.get() + c->size;
+  while (line < end) {
+    const char *newline =
+        static_cast<const char *>(memchr(line, '\n', size_t(end - line)));
+    const char *line_end = newline == nullptr ? end : newline;
+    const size_t length = size_t(line_end - line);
+    simdjson::dom::element document;
+    // as parse_many would, for lines longer than a batch
+    const simdjson::error_code error =
+        length > p.o.batch_size
+            ? simdjson::CAPACITY
+            : parser.parse(line, length, false).get(document);
+    if (error && error != simdjson::EMPTY) {
+      c->error = error;
+      c->error_offset = c->offset + size_t(line - c->data.get());
+      return;
+    }
+    if (!error) {
+      c->documents++;
+      if (p.each != nullptr) {
+        const auto before = clock_type::now();
+        (*p.each)(document, id);
+        *consuming += since(before);
+      }
+    }
+    line = line_end + 1;
+  }
+  // every line parses alone: keep the error of parse_many
+  c->error_offset = c->offset + from;
+}
+
+void parse_chunks(pipeline &p, unsigned id) {
+  simdjson::dom::parser parser;
+#ifdef SIMDJSON_THREADS_ENABLED
+  parser.threaded = p.o.stage1_thread;
+#endif
+  stage parse, consume, minify;
+  chunk *c;
+  while (p.full.pop(&c)) {
+    c->documents = 0;
+    c->error = simdjson::SUCCESS;
+    c->out_size = 0;
+    const auto start = clock_type::now();
+    double consuming = 0;
+    simdjson::dom::document_stream stream;
+    c->error = parser.parse_many(c->data.get(), c->size, p.o.batch_size)
+                   .get(stream);
+    if (!c->error) {
+      for (auto it = stream.begin(); it != stream.end(); ++it) {
+        simdjson::dom::element document;
+        c->error = (*it).get(document);
+        if (c->error) {
+          find_error(p, id, parser, c, it.current_index(), &consuming);
+          break;
+        }
+        c->documents++;
+        if (p.each != nullptr) {
+          const auto before = clock_type::now();
+          (*p.each)(document, id);
+          consuming += since(before);
+        }
+      }
+    } else {
+      c->error_offset = c->offset;
+    }
+    parse.seconds += since(start) - consuming;
+    parse.bytes += c->size;
+    if (p.each != nullptr) {
+      consume.seconds += consuming;
+      consume.bytes += c->size;
+    }
+    if (p.minifying && !c->error) {
+      const auto before = clock_type::now();
+      c->out_size = minify_lines(c->data.get(), c->size, c->out.get());
+      minify.seconds += since(before);
+      minify.bytes += c->size;
+    }
+    p.done.push(c);
+  }
+  p.add(&p.r.parse, parse);
+  p.add(&p.r.consume, consume);
+  p.add(&p.r.minify, minify);
+  if (--p.running == 0) {
+    p.done.close();
+  }
+}
+
+// On the calling thread: the chunks in input order, up to the first error.
+void collect(pipeline &p, const writer *output) {
+  std::map<size_t, chunk *> waiting;
+  size_t next = 0, documents = 0;
+  bool failed = false;
+  stage write;
+  chunk *c;
+  while (p.done.pop(&c)) {
+    waiting[c->sequence] = c;
+    while (!waiting.empty() && waiting.begin()->first == next) {
+      c = waiting.begin()->second;
+      waiting.erase(waiting.begin());
+      next++;
+      if (!failed) {
+        documents += c->documents;
+        if (c->error) {
+          failed = true;
+          p.fail(c->error_offset, simdjson::error_message(c->error));
+        } else if (output != nullptr) {
+          const auto start = clock_type::now();
+          if (!(*output)(c->out.get(), c->out_size)) {
+            failed = true;
+            p.fail(c->offset, "cannot write the output");
+          }
+          write.seconds += since(start);
+          write.bytes += c->out_size;
+        }
+      }
+      p.empty.push(c);
+    }
+  }
+  p.add(&p.r.write, write);
+  p.r.documents = documents;
+}
+
+report run(const reader &input, const consumer *each, const writer *output,
+           const options &o) {
+  const auto start = clock_type::now();
+  pipeline p(o, each, output != nullptr);
+  std::thread reading(read_chunks, std::ref(p), std::cref(input));
+  std::vector<std::thread> parsing;
+  for (unsigned id = 0; id < p.o.parsers; id++) {
+    parsing.emplace_back(parse_chunks, std::ref(p), id);
+  }
+  collect(p, output);
+  reading.join();
+  for (std::thread &t : parsing) {
+    t.join();
+  }
+  p.r.seconds = since(start);
+  return p.r;
+}
+
+report cannot_open(const char *filename) {
+  report r;
+  r.ok = false;
+  r.error = std::string("cannot open ") + filename;
+  return r;
+}
+
+reader from_file(FILE *file) {
+  return [file](char *buffer, size_t capacity) -> ptrdiff_t {
+    const size_t got = fread(buffer, 1, capacity, file);
+    return got == 0 && ferror(file) ? -1 : ptrdiff_t(got);
+  };
+}
+
+} // namespace
+
+report process(const reader &input, const consumer &each, const options &o) {
+  return run(input, each ? &each : nullptr, nullptr, o);
+}
+
+report process(const char *filename, const consumer &each, const options &o) {
+  FILE *file = fopen(filename, "rb");
+  if (file == nullptr) {
+    return cannot_open(filename);
+  }
+  const report r = process(from_file(file), each, o);
+  fclose(file);
+  return r;
+}
+
+report minify(const reader &input, const writer &output, const options &o) {
+  return run(input, nullptr, &output, o);
+}
+
+report minify(const char *in_filename, const char *out_filename,
+              const options &o) {
+  FILE *in = fopen(in_filename, "rb");
+  if (in == nullptr) {
+    return cannot_open(in_filename);
+  }
+  FILE *out = fopen(out_filename, "wb");
+  if (out == nullptr) {
+    fclose(in);
+    return cannot_open(out_filename);
+  }
+  report r = minify(from_file(in), [out](const char *data, size_t n) {
+    return fwrite(data, 1, n, out) == n;
+  }, o);
+  fclose(in);
+  if (fclose(out) != 0 && r.ok) {
+    r.ok = false;
+    r.error = "cannot write the output";
+    r.error_offset = r.read.bytes;
+  }
+  return r;
+}
+
+} // namespace ndjson
@@ -0,0 +1,120 @@
+// Newline-delimited JSON (one document per line) through simdjson, as a
+// pipeline of three stages:
+//
+//   - one thread reads the input in large chunks, cut after their last
+//     newline (the line that goes on is carried into the next chunk);
+//   - parser threads each keep one simdjson::dom::parser for the whole
+//     run and give it the chunks with parse_many, which parses them in
+//     batches of options::batch_size bytes, reusing the same buffers for
+//     every batch and every chunk; a consumer sees each document there;
+//   - the calling thread takes the chunks back in input order, writes the
+//     minified lines if there are any and returns the buffers to the
+//     reader, so that at most options::chunks of them are ever allocated.
+//
+// 2020/12/13/benchmark.cpp times simdjson::minify and validation over one
+// buffer that fits in cache; this uses the same simdjson (0.7, amalgamated
+// in 2020/12/13, unmodified) over streams of any size, and reports the
+// throughput of each stage so that one can tell which one is too slow.
+//
+//   ndjson::report r = ndjson::process("events.ndjson",
+//       [](simdjson::dom::element event, unsigned parser) { ... });
+//   if (!r.ok) printf("%s at byte %zu\n", r.error.c_str(), r.error_offset);
+//
+//   ndjson::minify("events.ndjson", "events.min.ndjson");
+#ifndef NDJSON_H
+#define NDJSON_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+#include "../../2020/12/13/simdjson.h"
+
+namespace ndjson {
+
+// Fills buffer[0, capacity) with the next bytes of the input and returns
+// how many, 0 at the end and -1 on failure, as read(2) does.
+typedef std::function<ptrdiff_t(char *buffer, size_t capacity)> reader;
+
+// Writes data[0, n) to the output; false on failure, which stops the run.
+typedef std::function<bool(const char *data, size_t n)> writer;
+
+// Called once per document on the parser threads, several at a time when
+// there are several parsers: parser, in [0, parsers), tells which thread
+// calls, so that a consumer can keep one state per thread without locks.
+// The documents of a chunk come in order, but the chunks do not. The
+// element is valid only during the call.
+typedef std::function<void(simdjson::dom::element document, unsigned parser)>
+    consumer;
+
+struct options {
+  // Bytes read at a time: no line may be longer.
+  size_t chunk_size = size_t(4) << 20;
+  // Bytes that parse_many parses at a time: no document may be longer.
+  size_t batch_size = simdjson::dom::DEFAULT_BATCH_SIZE;
+  // Parser threads, 0 for one per hardware thread.
+  unsigned parsers = 1;
+  // Chunk buffers, 0 for parsers + 2: one being read, one being parsed per
+  // parser, one being written.
+  unsigned chunks = 0;
+  // Let parse_many find the structure of the next batch on a thread of its
+  // own while the parser goes over the current one. simdjson 0.7 gives
+  // that thread a parser of its own for every parse_many call, that is,
+  // for every chunk, so it is off unless chunks hold many batches.
+  bool stage1_thread = false;
+};
+
+// The time a stage was busy, summed over its threads, and the bytes it
+// went over.
+struct stage {
+  size_t bytes = 0;
+  double seconds = 0;
+
+  double gigabytes_per_second() const {
+    return seconds > 0 ? double(bytes) / seconds / 1e9 : 0;
+  }
+};
+
+struct report {
+  bool ok = true;
+  // The first error in the input: a document that does not parse, a line
+  // longer than a chunk, or a failure to read or to write. Its offset is
+  // that of the document in error or, when simdjson rejects a whole
+  // batch, of the batch.
+  std::string error;
+  size_t error_offset = 0;
+  // Documents before the first error. After an error the pipeline stops,
+  // but the chunks already given to the other parsers still go to the
+  // consumer.
+  size_t documents = 0;
+
+  stage read;    // in the reader
+  stage parse;   // parse_many, less the time in the consumer
+  stage consume; // in the consumer (bytes: those of the input)
+  stage minify;  // minify(): simdjson::minify of each line
+  stage write;   // in the writer, bytes written
+  double seconds = 0; // from start to end
+
+  double gigabytes_per_second() const {
+    return seconds > 0 ? double(read.bytes) / seconds / 1e9 : 0;
+  }
+};
+
+// Parses every document of the input; each goes to the consumer, if
+// there is one (an empty std::function only validates).
+report process(const reader &input, const consumer &each,
+               const options &o = options());
+report process(const char *filename, const consumer &each,
+               const options &o = options());
+
+// Parses every document of the input and writes them minified, one per
+// line, in input order. Blank lines are dropped, and the output stops
+// before the chunk that holds the first error.
+report minify(const reader &input, const writer &output,
+              const options &o = options());
+report minify(const char *in_filename, const char *out_filename,
+              const options &o = options());
+
+} // namespace ndjson
+
+#endif // NDJSON_H
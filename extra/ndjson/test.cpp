@@ -0,0 +1,257 @@
+// Checks of the pipeline against simdjson used one line at a time, on
+// generated events with spaces, escapes, blank lines, CRLF and no newline
+// at the end: with chunks so small that most lines straddle two reads,
+// several parsers, one buffer or many, batches of all sizes and input that
+// comes a few bytes at a time; then errors in the documents, in reading
+// and in writing, and the file functions.
+#include "ndjson.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+std::mt19937_64 gen(1234);
+
+std::string spaces() { return std::string(gen() % 3, ' '); }
+
+std::string event(uint64_t id) {
+  std::string e = "{" + spaces() + "\"id\":" + spaces() + std::to_string(id);
+  e += ", \"name\": \"user \\\"" + std::to_string(gen() % 1000) + "\\\"\\n\"";
+  e += ",\"tags\" : [";
+  const size_t tags = gen() % 20;
+  for (size_t k = 0; k < tags; k++) {
+    e += (k == 0 ? "" : ",") + spaces() + "\"t" + std::to_string(gen()) + "\"";
+  }
+  e += "], \"nested\": {\"a\": [1, 2.5, true, null]}" + spaces() + "}";
+  return e;
+}
+
+struct events {
+  std::string text;
+  std::vector<size_t> starts; // of each document
+  std::string minified;       // one line at a time by simdjson
+  uint64_t id_sum = 0;
+};
+
+events make_events(size_t count) {
+  events e;
+  std::vector<char> out;
+  for (size_t k = 0; k < count; k++) {
+    if (gen() % 10 == 0) {
+      e.text += gen() % 2 ? "\n" : "  \r\n";
+    }
+    const std::string line = event(k * 7 + 1);
+    e.starts.push_back(e.text.size());
+    e.text += line;
+    e.id_sum += k * 7 + 1;
+    out.resize(line.size() + 64);
+    size_t length = 0;
+    if (simdjson::minify(line.data(), line.size(), out.data(), length)) {
+      abort();
+    }
+    e.minified.append(out.data(), length);
+    e.minified += '\n';
+    if (k + 1 < count || gen() % 2) {
+      e.text += gen() % 4 == 0 ? "\r\n" : "\n";
+    }
+  }
+  return e;
+}
+
+// from memory, at most limit bytes per call
+ndjson::reader from(const std::string &text, size_t limit) {
+  auto offset = std::make_shared<size_t>(0);
+  return [&text, offset, limit](char *buffer, size_t capacity) -> ptrdiff_t {
+    const size_t n =
+        std::min(std::min(capacity, limit), text.size() - *offset);
+    memcpy(buffer, text.data() + *offset, n);
+    *offset += n;
+    return ptrdiff_t(n);
+  };
+}
+
+// The ids of every document, summed per parser then altogether.
+struct sum {
+  explicit sum(unsigned parsers) : per_parser(parsers, 0) {}
+
+  ndjson::consumer consumer() {
+    return [this](simdjson::dom::element document, unsigned parser) {
+      per_parser.at(parser) += uint64_t(int64_t(document["id"]));
+    };
+  }
+
+  uint64_t total() const {
+    uint64_t t = 0;
+    for (uint64_t s : per_parser) {
+      t += s;
+    }
+    return t;
+  }
+
+  std::vector<uint64_t> per_parser;
+};
+
+bool check(const events &e, const ndjson::options &o, size_t limit) {
+  sum ids(o.parsers);
+  const ndjson::report r = ndjson::process(from(e.text, limit),
+                                           ids.consumer(), o);
+  std::string out;
+  const ndjson::report m = ndjson::minify(
+      from(e.text, limit), [&out](const char *data, size_t n) {
+        out.append(data, n);
+        return true;
+      }, o);
+  const bool ok = r.ok && m.ok && r.documents == e.starts.size() &&
+                  m.documents == e.starts.size() && ids.total() == e.id_sum &&
+                  out == e.minified && r.read.bytes == e.text.size() &&
+                  m.write.bytes == out.size();
+  if (!ok) {
+    printf("bug: chunks of %zu bytes, batches of %zu, %u parsers, %u "
+           "buffers, reads of %zu bytes: %s\n",
+           o.chunk_size, o.batch_size, o.parsers, o.chunks, limit,
+           r.error.c_str());
+  }
+  return ok;
+}
+
+bool check_pipeline() {
+  const events e = make_events(3000);
+  const size_t chunk_sizes[] = {1024, 5000, 65536, size_t(4) << 20};
+  const size_t batch_sizes[] = {1024, 10000, simdjson::dom::DEFAULT_BATCH_SIZE};
+  for (size_t chunk_size : chunk_sizes) {
+    for (size_t batch_size : batch_sizes) {
+      for (unsigned parsers = 1; parsers <= 3; parsers += 2) {
+        for (unsigned chunks : {0u, 1u}) {
+          ndjson::options o;
+          o.chunk_size = chunk_size;
+          o.batch_size = batch_size;
+          o.parsers = parsers;
+          o.chunks = chunks;
+          o.stage1_thread = parsers == 3;
+          if (!check(e, o, chunks == 0 ? 97 : size_t(-1))) {
+            return false;
+          }
+        }
+      }
+    }
+  }
+  // empty inputs
+  ndjson::options o;
+  events blank;
+  blank.text = "\n \n\r\n";
+  return check(events(), o, size_t(-1)) && check(blank, o, size_t(-1));
+}
+
+// One document made invalid: the report gives it and those before it.
+bool check_errors() {
+  const size_t count = 2000;
+  const events e = make_events(count);
+  const char *breaks[] = {"tru", "{\"unclosed", "[1,]", "{\"a\" 1}"};
+  for (int k = 0; k < 40; k++) {
+    const size_t bad = gen() % count;
+    std::string text = e.text;
+    const size_t at = e.starts[bad];
+    text.insert(at, std::string(breaks[k % 4]) + "\n");
+    ndjson::options o;
+    o.chunk_size = 4096 << (k % 4);
+    o.batch_size = 2048 << (k % 3);
+    o.parsers = 1 + k % 3;
+    sum ids(o.parsers);
+    std::string out;
+    const ndjson::report r =
+        ndjson::process(from(text, size_t(-1)), ids.consumer(), o);
+    const ndjson::report m = ndjson::minify(
+        from(text, size_t(-1)), [&out](const char *data, size_t n) {
+          out.append(data, n);
+          return true;
+        }, o);
+    if (r.ok || m.ok || r.documents != bad || m.documents != bad ||
+        r.error_offset != at || m.error_offset != at ||
+        e.minified.compare(0, out.size(), out) != 0) {
+      printf("bug: error in document %zu at %zu, found after %zu at %zu: "
+             "%s\n",
+             bad, at, r.documents, r.error_offset, r.error.c_str());
+      return false;
+    }
+  }
+  // a line longer than a chunk, or than a batch
+  ndjson::options o;
+  o.chunk_size = 1024;
+  o.batch_size = 1024;
+  const std::string line = "[" + std::string(2000, '1') + "]\n";
+  if (ndjson::process(from(e.text.substr(0, e.starts[3]) + line, 100),
+                      nullptr, o).error_offset != e.starts[3]) {
+    return false;
+  }
+  o.chunk_size = 4096;
+  ndjson::report r =
+      ndjson::process(from(e.text.substr(0, e.starts[3]) + line, 100),
+                      nullptr, o);
+  if (r.ok || r.documents != 3 || r.error_offset != e.starts[3]) {
+    return false;
+  }
+  // failures to read and to write
+  o = ndjson::options();
+  o.chunk_size = 4096;
+  size_t calls = 0;
+  r = ndjson::process([&](char *buffer, size_t capacity) -> ptrdiff_t {
+    return ++calls == 3 ? -1 : from(e.text, 1000)(buffer, capacity);
+  }, nullptr, o);
+  if (r.ok || r.error != "cannot read the input") {
+    return false;
+  }
+  r = ndjson::minify(from(e.text, size_t(-1)),
+                     [](const char *, size_t) { return false; }, o);
+  return !r.ok && r.error == "cannot write the output" && r.error_offset == 0;
+}
+
+bool check_files() {
+  const events e = make_events(1000);
+  char in[] = "/tmp/ndjson_in_XXXXXX";
+  char out[] = "/tmp/ndjson_out_XXXXXX";
+  const int in_fd = mkstemp(in), out_fd = mkstemp(out);
+  if (in_fd < 0 || out_fd < 0) {
+    return false;
+  }
+  close(out_fd);
+  bool ok = write(in_fd, e.text.data(), e.text.size()) ==
+            ptrdiff_t(e.text.size());
+  close(in_fd);
+  ndjson::options o;
+  o.chunk_size = 10000;
+  std::atomic<size_t> documents{0};
+  const ndjson::report r = ndjson::process(
+      in, [&documents](simdjson::dom::element, unsigned) { documents++; }, o);
+  const ndjson::report m = ndjson::minify(in, out, o);
+  std::string minified;
+  if (FILE *f = fopen(out, "rb")) {
+    char buffer[4096];
+    while (size_t n = fread(buffer, 1, sizeof(buffer), f)) {
+      minified.append(buffer, n);
+    }
+    fclose(f);
+  }
+  ok = ok && r.ok && documents == e.starts.size() && m.ok &&
+       minified == e.minified &&
+       !ndjson::process("/nonexistent/ndjson", nullptr).ok;
+  unlink(in);
+  unlink(out);
+  return ok;
+}
+
+} // namespace
+
+int main() {
+  if (!check_pipeline() || !check_errors() || !check_files()) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,193 @@
+// Nanoseconds per number and GB/s over 32 MB of log lines such as
+//
+//   2019-04-17 10:20:30.25 INFO GET /api/v2/items/8412 status=200
+//   bytes=5123 took=3.25ms user=u_51 retries=-1
+//
+// (one line each, 11 numbers per line, "v2" and "u_51" not being any),
+// then of the same lines with a message of 80 characters after them, as
+// most logs have. The baselines: a plain scanner that looks at one
+// character at a time and reads the digits as it goes, and the same loop
+// handing each number to strtod, as a tokenizer would. Then each back
+// end, and each back end with every number converted by to_double.
+#include "numberscan.h"
+
+#include "../harness/harness.h"
+
+#include <clocale>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const numberscan::backend backends[] = {numberscan::backend::scalar,
+                                        numberscan::backend::avx2,
+                                        numberscan::backend::avx512};
+
+std::string make_log(bool message, size_t size, std::mt19937_64 &gen) {
+  const char *verbs[] = {"GET", "POST", "PUT"};
+  std::string log;
+  char buffer[256];
+  while (log.size() < size) {
+    snprintf(buffer, sizeof(buffer),
+             "2019-04-%02d %02d:%02d:%02d.%02d INFO %s /api/v2/items/%d "
+             "status=%d bytes=%d took=%d.%02dms user=u_%d retries=%d\n",
+             int(1 + gen() % 30), int(gen() % 24), int(gen() % 60),
+             int(gen() % 60), int(gen() % 100), verbs[gen() % 3],
+             int(gen() % 100000), gen() % 8 == 0 ? 404 : 200,
+             int(gen() % 1000000), int(gen() % 1000), int(gen() % 100),
+             int(gen() % 1000), int(gen() % 4) - 1);
+    log += buffer;
+    if (message) {
+      log.back() = ' ';
+      log += "msg=\"connection reset by peer while reading the response "
+             "header from upstream\"\n";
+    }
+  }
+  return log;
+}
+
+bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+bool is_word(char c) {
+  return is_digit(c) || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') ||
+         c == '_' || c == '.';
+}
+
+// One character at a time: the grammar of numberscan.h, the values as
+// int64_t, without the overflow checks. Gives the sum of the values.
+int64_t plain_scan(const std::string &log, size_t *count) {
+  const char *p = log.data();
+  const size_t n = log.size();
+  int64_t sum = 0;
+  size_t found = 0;
+  bool word_before = false;
+  for (size_t i = 0; i < n; i++) {
+    if (!is_digit(p[i]) || word_before) {
+      word_before = is_word(p[i]);
+      continue;
+    }
+    const bool negative =
+        i > 0 && p[i - 1] == '-' && (i == 1 || !is_word(p[i - 2]));
+    int64_t m = 0;
+    for (; i < n && is_digit(p[i]); i++) {
+      m = 10 * m + (p[i] - '0');
+    }
+    if (i + 1 < n && p[i] == '.' && is_digit(p[i + 1])) {
+      for (i++; i < n && is_digit(p[i]); i++) {
+        m = 10 * m + (p[i] - '0');
+      }
+    }
+    sum += negative ? -m : m;
+    found++;
+    i--;
+    word_before = true;
+  }
+  *count = found;
+  return sum;
+}
+
+// The same loop, with strtod reading each number.
+double strtod_scan(const std::string &log, size_t *count) {
+  const char *p = log.c_str();
+  const size_t n = log.size();
+  double sum = 0;
+  size_t found = 0;
+  for (size_t i = 0; i < n; i++) {
+    if (!is_digit(p[i]) || (i > 0 && is_word(p[i - 1]))) {
+      continue;
+    }
+    const bool sign = i > 0 && (p[i - 1] == '-' || p[i - 1] == '+') &&
+                      (i == 1 || !is_word(p[i - 2]));
+    char *end;
+    sum += strtod(p + i - sign, &end);
+    found++;
+    // past the number, and past an exponent strtod would have taken
+    i = size_t(end - p);
+    while (i < n && is_word(p[i])) {
+      i++;
+    }
+  }
+  *count = found;
+  return sum;
+}
+
+} // namespace
+
+int main() {
+  setlocale(LC_ALL, "C");
+  std::mt19937_64 gen(1234);
+  harness::options opts = harness::default_options();
+  opts.repeat = 5;
+  printf("best back end: %s\n",
+         numberscan::backend_name(numberscan::active_backend()));
+  bool ok = true;
+  for (bool message : {false, true}) {
+    const std::string log = make_log(message, size_t(32) << 20, gen);
+    size_t numbers = 0;
+    const int64_t sum = plain_scan(log, &numbers);
+    printf("%s: %zu MB, %zu numbers\n", message ? "with messages" : "lines",
+           log.size() >> 20, numbers);
+    auto time = [&](const char *name, const std::function<size_t()> &f) {
+      auto r = harness::run(name, log.size(), [&] {
+        const size_t count = f();
+        ok = ok && count == numbers;
+        harness::do_not_optimize(count);
+      }, opts);
+      if (opts.format != HARNESS_TEXT) {
+        r.report();
+      } else {
+        printf("  %-28s\t%8.2f ns/number\t%6.2f GB/s\n", name,
+               r.min() / numbers, log.size() / r.min());
+      }
+    };
+    time("one character at a time", [&] {
+      size_t count;
+      harness::do_not_optimize(plain_scan(log, &count));
+      return count;
+    });
+    time("strtod", [&] {
+      size_t count;
+      harness::do_not_optimize(strtod_scan(log, &count));
+      return count;
+    });
+    std::vector<numberscan::number> out(numberscan::capacity(log.size()));
+    for (numberscan::backend b : backends) {
+      if (!numberscan::backend_supported(b)) {
+        continue;
+      }
+      numberscan::options o;
+      o.kernel = b;
+      const std::string name = numberscan::backend_name(b);
+      time(name.c_str(), [&] {
+        return numberscan::scan(log.data(), log.size(), out.data(),
+                                out.size(), o).count;
+      });
+      time((name + ", to_double").c_str(), [&] {
+        const size_t count = numberscan::scan(log.data(), log.size(),
+                                              out.data(), out.size(), o)
+                                 .count;
+        double total = 0;
+        for (size_t i = 0; i < count; i++) {
+          total += numberscan::to_double(log.data(), out[i]);
+        }
+        harness::do_not_optimize(total);
+        return count;
+      });
+      int64_t values = 0;
+      for (size_t i = 0; i < numbers; i++) {
+        values += out[i].value;
+      }
+      ok = ok && values == sum;
+    }
+  }
+  if (!ok) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,156 @@
+// Runtime dispatch and the scalar back end.
+#include "numberscan.h"
+#include "numberscan_kernels.h"
+
+#include "../isa/dispatch.h"
+
+#include "../../2021/03/24/include/fast_float/fast_float.h"
+
+namespace numberscan {
+
+namespace {
+
+struct implementation {
+  backend kind;
+  const char *name;
+  uint32_t required_instruction_sets;
+  const functions &(*table)();
+};
+
+const implementation scalar = {backend::scalar, "scalar", 0,
+                               scalar_functions};
+const implementation avx2 = {backend::avx2, "avx2", instruction_set::AVX2,
+                             avx2_functions};
+const implementation avx512 = {backend::avx512, "avx512",
+                               instruction_set::AVX512, avx512_functions};
+
+const implementation *const implementations[] = {&avx512, &avx2, &scalar};
+
+const implementation *best() {
+  static const implementation *best =
+      isa::first_supported(implementations, &scalar);
+  return best;
+}
+
+// nullptr if unknown or unsupported
+const implementation *find(backend kind) {
+  if (kind == backend::automatic) {
+    return best();
+  }
+  return isa::find(implementations, kind);
+}
+
+// The functions of each back end, nullptr if unsupported, found once: a
+// buffer may be a single line, and the calls many.
+const functions *table(backend kind) {
+  struct function_tables {
+    const functions *of[4];
+
+    function_tables() {
+      for (int k = 0; k < 4; k++) {
+        const implementation *impl = find(backend(k));
+        of[k] = impl == nullptr ? nullptr : &impl->table();
+      }
+    }
+  };
+  static const function_tables t;
+  return unsigned(kind) < 4 ? t.of[unsigned(kind)] : nullptr;
+}
+
+constexpr uint64_t packed_byte(uint8_t b) {
+  // replicate the byte 8 times
+  return uint64_t(b) * uint64_t(0x0101010101010101);
+}
+
+// the high bits of the 8 bytes as 8 bits, the first byte lowest
+uint64_t gather_bits(uint64_t high_bits) {
+  return ((high_bits >> 7) * 0x0102040810204080) >> 56;
+}
+
+// The class of each character: 0x01 for digits, 0x02 for what is_word
+// takes, 0x04 for '.', 0x08 for '-' and '+', 0x10 for '-'.
+struct character_classes {
+  uint8_t of[256];
+
+  constexpr character_classes() : of() {
+    for (int c = 0; c < 256; c++) {
+      const bool digit = c >= '0' && c <= '9';
+      const bool letter = (c | 0x20) >= 'a' && (c | 0x20) <= 'z';
+      of[c] = uint8_t((digit ? 0x01 : 0) |
+                      (digit || letter || c == '_' || c == '.' ? 0x02 : 0) |
+                      (c == '.' ? 0x04 : 0) |
+                      (c == '-' || c == '+' ? 0x08 : 0) |
+                      (c == '-' ? 0x10 : 0));
+    }
+  }
+};
+
+constexpr character_classes classes;
+
+struct scalar_classifier {
+  static void classify(const uint8_t *chars, masks *m) {
+    uint64_t digits = 0, word = 0, points = 0, signs = 0, minus = 0;
+    for (int k = 0; k < 8; k++) {
+      uint64_t c = 0;
+      for (int j = 0; j < 8; j++) {
+        c |= uint64_t(classes.of[chars[8 * k + j]]) << (8 * j);
+      }
+      digits |= gather_bits((c << 7) & packed_byte(0x80)) << (8 * k);
+      word |= gather_bits((c << 6) & packed_byte(0x80)) << (8 * k);
+      points |= gather_bits((c << 5) & packed_byte(0x80)) << (8 * k);
+      signs |= gather_bits((c << 4) & packed_byte(0x80)) << (8 * k);
+      minus |= gather_bits((c << 3) & packed_byte(0x80)) << (8 * k);
+    }
+    *m = masks{digits, word, points, signs, minus};
+  }
+};
+
+} // namespace
+
+const functions &scalar_functions() {
+  return scanners<scalar_classifier>::table();
+}
+
+bool backend_supported(backend b) { return find(b) != nullptr; }
+
+backend active_backend() { return best()->kind; }
+
+const char *backend_name(backend b) {
+  if (b == backend::automatic) {
+    return best()->name;
+  }
+  return isa::name_of(implementations, b);
+}
+
+result scan(const char *text, size_t n, number *out, size_t capacity,
+            const options &o) {
+  const functions *f = table(o.kernel);
+  if (f == nullptr) {
+    return result{0, 0};
+  }
+  result r;
+  r.count = f->scan(reinterpret_cast<const uint8_t *>(text), n, out,
+                    capacity, &r.end);
+  return r;
+}
+
+// Clinger's fast path when the value and the power of ten are both exact,
+// as in extra/floatparse; fast_float::from_chars otherwise. The sign comes
+// from the text, as value has none for "-0" or "-0.0".
+double to_double(const char *text, const number &x) {
+  typedef fast_float::binary_format<double> format;
+  const uint64_t m = x.value < 0 ? 0 - uint64_t(x.value) : uint64_t(x.value);
+  if (!x.overflow && m <= format::max_mantissa_fast_path() &&
+      x.decimals <= format::max_exponent_fast_path()) {
+    const double v = double(m) / format::exact_power_of_ten(x.decimals);
+    return text[x.offset] == '-' ? -v : v;
+  }
+  const char *first = text + x.offset;
+  const char *const last = first + x.length;
+  first += *first == '+'; // which from_chars does not take
+  double value = 0;
+  fast_float::from_chars(first, last, value);
+  return value;
+}
+
+} // namespace numberscan
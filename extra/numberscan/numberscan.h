@@ -0,0 +1,93 @@
+// Every integer and decimal number in a text (a log, a report, anything
+// semi-structured), with its offset and value, in one pass over the
+// buffer and without a tokenizer, with AVX2 or AVX-512 picked at runtime.
+//
+// 2018/09/30/identifynumbers.c counts the 8-grams of digits of a text
+// and extra/numberparsing/experiments.c tells whether four or eight
+// characters are digits; here the vectors classify 64 characters at a
+// time into bit sets (digits, points, signs, and the characters that may
+// not come before a number), and the numbers and their signs start where
+// the bit sets say, all of those of the 64 characters at once. Each number
+// is then read with the SWAR code of 2018/10/03/eightchartoi.c, its end
+// and its point taken from the bit sets (those of the next 64 characters
+// are made first): up to eight digits with a single load whose leading
+// characters are masked off. The scalar back end makes the same bit sets
+// eight characters at a time from a table of character classes.
+//
+// A number is a run of digits with, optionally, a '.' and more digits,
+// and a '-' or a '+' right before it, unless that sign follows a letter,
+// a digit, a '_' or a '.'. Digits that follow a letter, a digit, a '_' or
+// a '.' are no number: none in "sha256", "v2" or ".5", one in "1.2.3"
+// (1.2). Whatever follows a number does not matter: "10ms" gives 10,
+// "2019-04-17" gives 2019, 4 and 17, "1e5" gives 1 (no exponents).
+//
+//   std::vector<numberscan::number> numbers(numberscan::capacity(n));
+//   numberscan::result r =
+//       numberscan::scan(text, n, numbers.data(), numbers.size());
+//   numbers.resize(r.count);
+//   for (const numberscan::number &x : numbers)
+//     printf("%zu: %g\n", x.offset, numberscan::to_double(text, x));
+#ifndef NUMBERSCAN_H
+#define NUMBERSCAN_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace numberscan {
+
+struct functions; // of a back end, in numberscan_kernels.h
+
+enum class backend {
+  automatic, // best supported one
+  scalar,
+  avx2,
+  avx512
+};
+
+// Whether the back end can run on this processor, and its name.
+bool backend_supported(backend b);
+backend active_backend();
+const char *backend_name(backend b);
+
+struct options {
+  backend kernel = backend::automatic;
+};
+
+struct number {
+  // of the sign, or of the first digit
+  size_t offset;
+  // The digits without the point, signed: 1250 for "12.50", -7 for "-0.7".
+  // 0 when overflow.
+  int64_t value;
+  // characters, the sign included
+  uint32_t length;
+  // digits after the point: the number is value / 10^decimals
+  uint16_t decimals;
+  // whether value does not fit in an int64_t
+  bool overflow;
+};
+
+struct result {
+  // Numbers stored.
+  size_t count;
+  // n when all of them are; otherwise the offset of the first number that
+  // did not fit, to scan on from (0 for an unsupported back end).
+  size_t end;
+};
+
+// Enough room for the numbers of n characters of text: each takes a digit
+// and a character between it and the next.
+inline size_t capacity(size_t n) { return (n + 1) / 2; }
+
+// Finds the numbers of text[0, n) and stores them in out[0, count), in
+// order, as many as capacity allows.
+result scan(const char *text, size_t n, number *out, size_t capacity,
+            const options &o = options());
+
+// The number as the closest double, as strtod would give it from
+// text[x.offset, x.offset + x.length).
+double to_double(const char *text, const number &x);
+
+} // namespace numberscan
+
+#endif // NUMBERSCAN_H
@@ -0,0 +1,54 @@
+// The AVX2 back end: the 64 characters in two vectors, each range checked
+// with a subtraction and an unsigned minimum (digits, and letters with bit
+// 5 set), '_', '.', '-' and '+' compared for, and the bytes of each bit
+// set gathered with movemask. Compiled with -mavx2.
+#include "numberscan_kernels.h"
+
+#include <immintrin.h>
+
+namespace numberscan {
+namespace {
+
+// 0xff in the bytes of chars from first to first + span
+__m256i in_range(__m256i chars, char first, char span) {
+  const __m256i offset = _mm256_sub_epi8(chars, _mm256_set1_epi8(first));
+  return _mm256_cmpeq_epi8(
+      _mm256_min_epu8(offset, _mm256_set1_epi8(span)), offset);
+}
+
+uint64_t bits(__m256i bytes) {
+  return uint32_t(_mm256_movemask_epi8(bytes));
+}
+
+struct avx2_classifier {
+  static void classify(const uint8_t *chars, masks *m) {
+    uint64_t digits = 0, word = 0, points = 0, signs = 0, minus_signs = 0;
+    for (int k = 0; k < 2; k++) {
+      const __m256i c =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(chars) + k);
+      const __m256i digit = in_range(c, '0', 9);
+      const __m256i point = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('.'));
+      const __m256i letter =
+          in_range(_mm256_or_si256(c, _mm256_set1_epi8(0x20)), 'a', 25);
+      const __m256i underscore = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('_'));
+      const __m256i minus = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('-'));
+      const __m256i plus = _mm256_cmpeq_epi8(c, _mm256_set1_epi8('+'));
+      digits |= bits(digit) << (32 * k);
+      word |= bits(_mm256_or_si256(_mm256_or_si256(digit, point),
+                                   _mm256_or_si256(letter, underscore)))
+              << (32 * k);
+      points |= bits(point) << (32 * k);
+      signs |= bits(_mm256_or_si256(minus, plus)) << (32 * k);
+      minus_signs |= bits(minus) << (32 * k);
+    }
+    *m = masks{digits, word, points, signs, minus_signs};
+  }
+};
+
+} // namespace
+
+const functions &avx2_functions() {
+  return scanners<avx2_classifier>::table();
+}
+
+} // namespace numberscan
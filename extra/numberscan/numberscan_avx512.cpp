@@ -0,0 +1,39 @@
+// The AVX-512 back end: the 64 characters in one vector, range checked
+// with a subtraction and an unsigned comparison, or compared, into masks
+// (AVX512BW) that are the bit sets themselves. Compiled with -mavx512f
+// -mavx512bw.
+#include "numberscan_kernels.h"
+
+#include <immintrin.h>
+
+namespace numberscan {
+namespace {
+
+__mmask64 in_range(__m512i chars, char first, char span) {
+  return _mm512_cmple_epu8_mask(
+      _mm512_sub_epi8(chars, _mm512_set1_epi8(first)),
+      _mm512_set1_epi8(span));
+}
+
+struct avx512_classifier {
+  static void classify(const uint8_t *chars, masks *m) {
+    const __m512i c = _mm512_loadu_si512(chars);
+    const __mmask64 digits = in_range(c, '0', 9);
+    const __mmask64 points = _mm512_cmpeq_epi8_mask(c, _mm512_set1_epi8('.'));
+    const __mmask64 word =
+        digits | points |
+        in_range(_mm512_or_si512(c, _mm512_set1_epi8(0x20)), 'a', 25) |
+        _mm512_cmpeq_epi8_mask(c, _mm512_set1_epi8('_'));
+    const __mmask64 minus = _mm512_cmpeq_epi8_mask(c, _mm512_set1_epi8('-'));
+    const __mmask64 plus = _mm512_cmpeq_epi8_mask(c, _mm512_set1_epi8('+'));
+    *m = masks{digits, word, points, minus | plus, minus};
+  }
+};
+
+} // namespace
+
+const functions &avx512_functions() {
+  return scanners<avx512_classifier>::table();
+}
+
+} // namespace numberscan
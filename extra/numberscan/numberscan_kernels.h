@@ -0,0 +1,277 @@
+// The functions of each back end, and the loop that all of them share
+// around their own way of classifying 64 characters: finding where the
+// numbers and their signs start, from the bit sets, and reading them.
+// Only the numberscan*.cpp files include this header.
+#ifndef NUMBERSCAN_KERNELS_H
+#define NUMBERSCAN_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "numberscan.h"
+
+namespace numberscan {
+
+struct functions {
+  // As scan, with *end for result::end: returns the count.
+  size_t (*scan)(const uint8_t *text, size_t n, number *out,
+                 size_t capacity, size_t *end);
+};
+
+const functions &scalar_functions();
+const functions &avx2_functions();
+const functions &avx512_functions();
+
+// What a back end makes of 64 characters: a bit for each, the first
+// character in bit 0.
+struct masks {
+  uint64_t digits;
+  // what digits may not follow to be a number: digits, letters, '_', '.'
+  uint64_t word;
+  uint64_t points; // '.'
+  uint64_t signs;  // '-' and '+'
+  uint64_t minus;  // '-'
+};
+
+// In an unnamed namespace: each back end compiles its own copy with its
+// own instruction sets, so that the linker cannot pick the AVX2 copy for
+// the scalar back end.
+namespace {
+
+inline bool is_digit(uint8_t c) { return uint8_t(c - '0') < 10; }
+
+// Travis Downs, from 2018/09/30/identifynumbers.c
+inline bool is_made_of_eight_digits(const uint8_t *chars) {
+  uint64_t val;
+  memcpy(&val, chars, 8);
+  return ((val & (val + 0x0606060606060606)) & 0xF0F0F0F0F0F0F0F0) ==
+         0x3030303030303030;
+}
+
+// From 2018/10/03/eightchartoi.c: the value of 8 digits less '0' each, the
+// first one in the low byte.
+inline uint32_t eight_digit_value(uint64_t val) {
+  const uint64_t byte10plus =
+      ((val * (1 + (0xa << 8))) >> 8) & 0x00FF00FF00FF00FF;
+  uint64_t short100plus =
+      ((byte10plus * (1 + (0x64 << 16))) >> 16) & 0x0000FFFF0000FFFF;
+  short100plus *= (1 + (10000ULL << 32));
+  return uint32_t(short100plus >> 32);
+}
+
+inline uint32_t parse_eight_digits(const uint8_t *chars) {
+  uint64_t val;
+  memcpy(&val, chars, 8);
+  return eight_digit_value(val - 0x3030303030303030);
+}
+
+// The value of the last count digits (0 to 8) of chars[0, 8): the
+// characters before them count as leading zeros.
+inline uint32_t parse_last_digits(const uint8_t *chars, size_t count) {
+  static const uint64_t last_bytes[] = {
+      0,
+      0xff00000000000000,
+      0xffff000000000000,
+      0xffffff0000000000,
+      0xffffffff00000000,
+      0xffffffffff000000,
+      0xffffffffffff0000,
+      0xffffffffffffff00,
+      0xffffffffffffffff};
+  uint64_t val;
+  memcpy(&val, chars, 8);
+  const uint64_t kept = last_bytes[count];
+  return eight_digit_value((val & kept) - (0x3030303030303030 & kept));
+}
+
+const uint64_t powers_of_ten[] = {1,      10,      100,      1000,
+                                  10000,  100000,  1000000,  10000000,
+                                  100000000};
+
+// The length of the run of digits at text[p, n), from the digit bit set
+// of the 64 characters at text[i] as far as it goes, then eight at a time.
+inline size_t run_length(const uint8_t *text, size_t p, size_t n, size_t i,
+                         uint64_t digits) {
+  size_t end = p;
+  if (p < i + 64) {
+    const uint64_t after = ~(digits >> (p - i));
+    end = after == 0 ? i + 64 : p + size_t(__builtin_ctzll(after));
+    if (end < i + 64) {
+      return end - p;
+    }
+  }
+  while (n - end >= 8 && is_made_of_eight_digits(text + end)) {
+    end += 8;
+  }
+  while (end < n && is_digit(text[end])) {
+    end++;
+  }
+  return end - p;
+}
+
+// The count digits of text[p] added to m: p >= 8 or p + count >= 8, so
+// that the last ones take a single load.
+inline uint64_t read_digits(const uint8_t *text, size_t p, size_t count,
+                            uint64_t m) {
+  for (; count >= 8; p += 8, count -= 8) {
+    m = m * 100000000 + parse_eight_digits(text + p);
+  }
+  if (count > 0) {
+    m = m * powers_of_ten[count] +
+        parse_last_digits(text + p + count - 8, count);
+  }
+  return m;
+}
+
+// Digit by digit, for the runs of more than 19 digits; false if they
+// overflow.
+inline bool read_long_digits(const uint8_t *text, size_t p, size_t count,
+                             uint64_t *m) {
+  for (; count > 0; p++, count--) {
+    if (__builtin_mul_overflow(*m, uint64_t(10), m) ||
+        __builtin_add_overflow(*m, uint64_t(text[p] - '0'), m)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The bits of here from bit on, then those of next: the 64 characters
+// from the one of that bit.
+inline uint64_t window(uint64_t here, uint64_t next, size_t bit) {
+  return (here >> bit) | (next << 1 << (63 - bit));
+}
+
+// The number whose first digit is text[s], after a sign if sign, in the
+// 64 characters at text[i] whose bit sets are here (and next, for the 64
+// after them), into *x field by field (a number built on the stack and
+// copied would be read back before its stores are done).
+inline void read_number(const uint8_t *text, size_t s, size_t n, size_t i,
+                        const masks &here, const masks &next, bool sign,
+                        bool negative, number *x) {
+  // Most numbers have up to 8 digits, and as many after a point: the bit
+  // sets from s on (those of the next 64 characters included) tell where
+  // they end without a look at the text, each part is a single load, and
+  // the digits after what may be the point are counted whether it is one
+  // or not, so that the only branch that depends on the number is on its
+  // decimals.
+  const size_t bit = s - i;
+  const uint64_t run = window(here.digits, next.digits, bit);
+  const size_t point = size_t(__builtin_ctzll(~run | (1ULL << 63)));
+  if (point <= 8 && s + point >= 8) {
+    const bool has_point =
+        (window(here.points, next.points, bit) >> point) & 1;
+    const size_t after = size_t(__builtin_ctzll(~(run >> (point + 1))));
+    const size_t decimals = has_point ? after : 0;
+    if (decimals <= 8) {
+      uint64_t m = parse_last_digits(text + s + point - 8, point);
+      if (decimals != 0) {
+        m = m * powers_of_ten[decimals] +
+            parse_last_digits(text + s + point + 1 + decimals - 8, decimals);
+      }
+      x->offset = s - sign;
+      x->value = negative ? int64_t(0 - m) : int64_t(m);
+      x->length = uint32_t(point + sign + (decimals != 0) + decimals);
+      x->decimals = uint16_t(decimals);
+      x->overflow = false;
+      return;
+    }
+  }
+  const size_t integer_digits = run_length(text, s, n, i, here.digits);
+  size_t end = s + integer_digits;
+  size_t decimals = 0;
+  if (n - end >= 2 && text[end] == '.' && is_digit(text[end + 1])) {
+    decimals = run_length(text, end + 1, n, i, here.digits);
+    end += 1 + decimals;
+  }
+  uint64_t m = 0;
+  bool fits = true;
+  if (integer_digits + decimals <= 19 && s + integer_digits >= 8) {
+    m = read_digits(text, s, integer_digits, 0);
+    m = read_digits(text, end - decimals, decimals, m);
+  } else {
+    fits = read_long_digits(text, s, integer_digits, &m) &&
+           read_long_digits(text, end - decimals, decimals, &m);
+  }
+  const bool overflow = !fits || m > uint64_t(INT64_MAX) + negative;
+  x->offset = s - sign;
+  x->value = overflow ? 0 : negative ? int64_t(0 - m) : int64_t(m);
+  x->length = uint32_t(end - s + sign);
+  x->decimals = uint16_t(decimals);
+  x->overflow = overflow;
+}
+
+// Classifier::classify(chars, &m) makes the bit sets of 64 characters.
+// Those of the next 64 are made before the numbers are read, for the
+// numbers that go on past the first 64. The characters past n go through
+// a buffer of spaces.
+template <class Classifier>
+void classify_from(const uint8_t *text, size_t i, size_t n, masks *m) {
+  if (n - i >= 64) {
+    Classifier::classify(text + i, m);
+  } else {
+    uint8_t buffer[64];
+    memset(buffer, ' ', sizeof(buffer));
+    memcpy(buffer, text + i, n - i);
+    Classifier::classify(buffer, m);
+  }
+}
+
+template <class Classifier>
+size_t scan_blocks(const uint8_t *text, size_t n, number *out,
+                   size_t capacity, size_t *end) {
+  size_t count = 0;
+  masks previous = {0, 0, 0, 0, 0};
+  masks next = previous;
+  if (n > 0) {
+    classify_from<Classifier>(text, 0, n, &next);
+  }
+  for (size_t i = 0; i < n; i += 64) {
+    const masks here = next;
+    next = masks{0, 0, 0, 0, 0};
+    if (n - i > 64) {
+      classify_from<Classifier>(text, i + 64, n, &next);
+    }
+    // the digits that do not follow a word character, and of those the
+    // ones after a sign that does not either
+    uint64_t starts =
+        here.digits & ~(here.word << 1 | previous.word >> 63);
+    const uint64_t signed_starts =
+        starts & (here.signs << 1 | previous.signs >> 63) &
+        ~(here.word << 2 | previous.word >> 62);
+    const uint64_t negative_starts =
+        signed_starts & (here.minus << 1 | previous.minus >> 63);
+    previous = here;
+    for (; starts != 0; starts &= starts - 1) {
+      const size_t bit = size_t(__builtin_ctzll(starts));
+      const bool sign = (signed_starts >> bit) & 1;
+      if (count == capacity) {
+        *end = i + bit - sign;
+        return count;
+      }
+      read_number(text, i + bit, n, i, here, next, sign,
+                  (negative_starts >> bit) & 1, &out[count++]);
+    }
+  }
+  *end = n;
+  return count;
+}
+
+// The functions of a back end whose classifier is Classifier.
+template <class Classifier> struct scanners {
+  static size_t scan(const uint8_t *text, size_t n, number *out,
+                     size_t capacity, size_t *end) {
+    return scan_blocks<Classifier>(text, n, out, capacity, end);
+  }
+  static const functions &table() {
+    static const functions f = {scan};
+    return f;
+  }
+};
+
+} // namespace
+
+} // namespace numberscan
+
+#endif // NUMBERSCAN_KERNELS_H
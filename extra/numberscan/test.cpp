@@ -0,0 +1,255 @@
+// Checks of every back end: numbers by hand (signs, decimals, what comes
+// before them, the limits of int64_t), then random texts of every length
+// up to 300 and longer ones, made of digits, points, signs, letters and
+// spaces, which must give what a plain scanner written here gives, the
+// same when scanned again from where a small output was full, and values
+// that strtod agrees with, signed zeros included.
+#include "numberscan.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const numberscan::backend backends[] = {
+    numberscan::backend::automatic, numberscan::backend::scalar,
+    numberscan::backend::avx2, numberscan::backend::avx512};
+
+std::mt19937_64 gen(1234);
+
+bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+bool is_word(char c) {
+  return is_digit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         c == '_' || c == '.';
+}
+
+// The grammar of numberscan.h, one character at a time, with 128-bit
+// arithmetic for the values.
+std::vector<numberscan::number> expected_numbers(const std::string &s) {
+  std::vector<numberscan::number> numbers;
+  const size_t n = s.size();
+  for (size_t i = 0; i < n; i++) {
+    if (!is_digit(s[i]) || (i > 0 && is_word(s[i - 1]))) {
+      continue;
+    }
+    numberscan::number x;
+    x.offset = i;
+    bool negative = false;
+    if (i > 0 && (s[i - 1] == '-' || s[i - 1] == '+') &&
+        (i == 1 || !is_word(s[i - 2]))) {
+      x.offset = i - 1;
+      negative = s[i - 1] == '-';
+    }
+    unsigned __int128 m = 0;
+    bool big = false;
+    size_t j = i;
+    for (; j < n && is_digit(s[j]); j++) {
+      m = 10 * m + unsigned(s[j] - '0');
+      big = big || m > ~uint64_t(0);
+    }
+    x.decimals = 0;
+    if (j + 1 < n && s[j] == '.' && is_digit(s[j + 1])) {
+      for (j++; j < n && is_digit(s[j]); j++) {
+        m = 10 * m + unsigned(s[j] - '0');
+        big = big || m > ~uint64_t(0);
+        x.decimals++;
+      }
+    }
+    const unsigned __int128 limit = uint64_t(INT64_MAX) + negative;
+    x.overflow = big || m > limit;
+    x.value = x.overflow ? 0 : negative ? int64_t(0 - uint64_t(m))
+                                        : int64_t(m);
+    x.length = uint32_t(j - x.offset);
+    numbers.push_back(x);
+    i = j - 1;
+  }
+  return numbers;
+}
+
+bool same(const numberscan::number &a, const numberscan::number &b) {
+  return a.offset == b.offset && a.value == b.value &&
+         a.length == b.length && a.decimals == b.decimals &&
+         a.overflow == b.overflow;
+}
+
+void print(const char *what, const numberscan::number &x) {
+  printf("  %s: offset %zu, value %lld, length %u, decimals %u, "
+         "overflow %d\n",
+         what, x.offset, (long long)x.value, x.length, x.decimals,
+         x.overflow);
+}
+
+// All the numbers of s, then again with room for k at a time.
+bool check_text(const std::string &s, numberscan::backend b, size_t k) {
+  numberscan::options o;
+  o.kernel = b;
+  const std::vector<numberscan::number> expected = expected_numbers(s);
+  std::vector<numberscan::number> numbers(numberscan::capacity(s.size()));
+  const numberscan::result r =
+      numberscan::scan(s.data(), s.size(), numbers.data(), numbers.size(), o);
+  bool ok = r.end == s.size() && r.count == expected.size();
+  for (size_t i = 0; ok && i < r.count; i++) {
+    if (!same(numbers[i], expected[i])) {
+      printf("bug: %s, number %zu of \"%s\"\n", numberscan::backend_name(b),
+             i, s.c_str());
+      print("found", numbers[i]);
+      print("expected", expected[i]);
+      return false;
+    }
+  }
+  if (!ok) {
+    printf("bug: %s, %zu numbers up to %zu of \"%s\", expected %zu\n",
+           numberscan::backend_name(b), r.count, r.end, s.c_str(),
+           expected.size());
+    return false;
+  }
+  // in pieces: the offsets from the start of each piece
+  std::vector<numberscan::number> pieces(k);
+  size_t start = 0, found = 0;
+  for (;;) {
+    const numberscan::result p = numberscan::scan(
+        s.data() + start, s.size() - start, pieces.data(), k, o);
+    for (size_t i = 0; i < p.count; i++, found++) {
+      pieces[i].offset += start;
+      if (found >= expected.size() || !same(pieces[i], expected[found])) {
+        printf("bug: %s, number %zu of \"%s\", %zu at a time\n",
+               numberscan::backend_name(b), found, s.c_str(), k);
+        return false;
+      }
+    }
+    if (start + p.end == s.size()) {
+      break;
+    }
+    if (p.count != k) {
+      printf("bug: %s, stopped at %zu of \"%s\" with room\n",
+             numberscan::backend_name(b), start + p.end, s.c_str());
+      return false;
+    }
+    start += p.end;
+  }
+  if (found != expected.size()) {
+    printf("bug: %s, %zu numbers of \"%s\", %zu at a time\n",
+           numberscan::backend_name(b), found, s.c_str(), k);
+    return false;
+  }
+  for (const numberscan::number &x : expected) {
+    const std::string token = s.substr(x.offset, x.length);
+    const double v = numberscan::to_double(s.data(), x);
+    const double expected_value = strtod(token.c_str(), nullptr);
+    if (v != expected_value ||
+        std::signbit(v) != std::signbit(expected_value)) { // -0.0
+      printf("bug: \"%s\" gives %.17g\n", token.c_str(), v);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool check_examples(numberscan::backend b) {
+  struct example {
+    const char *text;
+    std::vector<long long> values;
+  };
+  const example examples[] = {
+      {"", {}},
+      {"0", {0}},
+      {"42", {42}},
+      {"x=-5 y=+7", {-5, 7}},
+      {"sha256 v2 .5 _3", {}},
+      {"1.2.3", {12}},
+      {"10ms 3.5s", {10, 35}},
+      {"2019-04-17 10:20:30.25", {2019, 4, 17, 10, 20, 3025}},
+      {"1e5 1. -", {1, 1}},
+      {"a-5 --5 -+5 (-7)", {5, -5, 5, -7}},
+      {"-0.7 12.50", {-7, 1250}},
+      {"-0 -0.0 +0 -0.000", {0, 0, 0, 0}},
+      {"9223372036854775807 -9223372036854775808",
+       {INT64_MAX, INT64_MIN}},
+      {"9223372036854775808 -9223372036854775809 123456789012345678901",
+       {0, 0, 0}},
+      {"0000000000000000000000000001 0.00000000000000000000000001", {1, 1}},
+      {"\xc3\xa9" "5 \xff-6", {5, -6}},
+  };
+  numberscan::options o;
+  o.kernel = b;
+  for (const example &e : examples) {
+    const size_t n = strlen(e.text);
+    std::vector<numberscan::number> numbers(numberscan::capacity(n));
+    const numberscan::result r =
+        numberscan::scan(e.text, n, numbers.data(), numbers.size(), o);
+    bool ok = r.end == n && r.count == e.values.size();
+    for (size_t i = 0; ok && i < r.count; i++) {
+      ok = numbers[i].value == e.values[i];
+    }
+    if (!ok || !check_text(e.text, b, 1)) {
+      printf("bug: %s, \"%s\"\n", numberscan::backend_name(b), e.text);
+      return false;
+    }
+  }
+  return true;
+}
+
+// Random text with n characters, mostly digits in runs long enough to
+// cross vectors now and then.
+std::string random_text(size_t n) {
+  const char others[] = "..--+ _aZ\n\xe9";
+  std::string s;
+  while (s.size() < n) {
+    const int kind = int(gen() % 8);
+    if (kind < 4) {
+      const size_t digits = gen() % 4 == 0 ? gen() % 40 : gen() % 6;
+      for (size_t i = 0; i < digits; i++) {
+        s += char('0' + gen() % 10);
+      }
+    } else {
+      s += others[gen() % (sizeof(others) - 1)];
+    }
+  }
+  s.resize(n);
+  return s;
+}
+
+bool check_backend(numberscan::backend b) {
+  if (!check_examples(b)) {
+    return false;
+  }
+  for (size_t n = 0; n <= 300; n++) {
+    for (int t = 0; t < 20; t++) {
+      if (!check_text(random_text(n), b, 1 + gen() % 4)) {
+        return false;
+      }
+    }
+  }
+  for (int t = 0; t < 20; t++) {
+    if (!check_text(random_text(10000 + gen() % 1000), b, 1 + gen() % 100)) {
+      return false;
+    }
+  }
+  // a single number over several vectors
+  if (!check_text(std::string(200, '7') + "." + std::string(100, '0'), b,
+                  1)) {
+    return false;
+  }
+  return true;
+}
+
+} // namespace
+
+int main() {
+  printf("best back end: %s\n",
+         numberscan::backend_name(numberscan::active_backend()));
+  for (numberscan::backend b : backends) {
+    if (numberscan::backend_supported(b) && !check_backend(b)) {
+      printf("bug!\n");
+      return EXIT_FAILURE;
+    }
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,49 @@
+// The threads of the libraries under extra/ that split their work: each
+// takes the thread count of its options, 0 meaning one per hardware thread,
+// and runs f(t) on every slice t of its input:
+//
+//   unsigned threads = parallel::thread_count(o.threads);
+//   if (n / threads < parallel::minimum_values) {
+//     threads = 1;
+//   }
+//   parallel::in_parallel(threads, [&](unsigned t) { ... });
+#ifndef PARALLEL_PARALLEL_H
+#define PARALLEL_PARALLEL_H
+
+#include <stddef.h>
+
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+// Below this many values per thread, one thread sorts everything: starting
+// the threads would cost more than they save.
+constexpr size_t minimum_values = size_t(1) << 16;
+// Below this many bytes of text per thread, one thread reads everything.
+constexpr size_t minimum_bytes = size_t(1) << 20;
+
+// threads, or one per hardware thread if it is 0.
+inline unsigned thread_count(unsigned threads) {
+  if (threads != 0) {
+    return threads;
+  }
+  const unsigned hardware = std::thread::hardware_concurrency();
+  return hardware == 0 ? 1 : hardware;
+}
+
+// f(t) for t in [0, threads), t = 0 on the calling thread
+template <class F> void in_parallel(unsigned threads, F f) {
+  std::vector<std::thread> workers;
+  for (unsigned t = 1; t < threads; t++) {
+    workers.emplace_back(f, t);
+  }
+  f(0u);
+  for (auto &w : workers) {
+    w.join();
+  }
+}
+
+} // namespace parallel
+
+#endif // PARALLEL_PARALLEL_H
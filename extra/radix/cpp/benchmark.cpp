@@ -0,0 +1,116 @@
+// Speed of the sorts of n random keys (10 million by default), in ns per
+// key: std::sort against the radix sort with one write per value, with
+// write-combining buffers, and with one thread per hardware thread; then
+// keys that fit in 24 bits (most passes skipped) and keys with a payload.
+#include "radixsort.h"
+
+#include "../../harness/harness.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+template <class K> static K random_key(std::mt19937_64 &gen, uint64_t mask) {
+  return K(gen() & mask);
+}
+template <> float random_key<float>(std::mt19937_64 &gen, uint64_t mask) {
+  return float(int64_t(gen() & mask) - int64_t(mask / 2)) / 1024;
+}
+template <> double random_key<double>(std::mt19937_64 &gen, uint64_t mask) {
+  return double(int64_t(gen() & mask) - int64_t(mask / 2)) / 1024;
+}
+
+template <class T, class F>
+static void time(const char *type, const char *name,
+                 const std::vector<T> &input, std::vector<T> &out, F f,
+                 harness::options &opts) {
+  harness::print_row(type, 16, 10,
+                     harness::run_on_copy(name, input, out, f, opts));
+}
+
+template <class K>
+static bool run(const char *type, size_t n, uint64_t mask,
+                std::mt19937_64 &gen, harness::options &opts) {
+  std::vector<K> input(n), out(n);
+  for (auto &k : input) {
+    k = random_key<K>(gen, mask);
+  }
+  std::vector<K> expected(input);
+  std::sort(expected.begin(), expected.end());
+  time(type, "std::sort", input, out,
+       [&] { std::sort(out.begin(), out.end()); }, opts);
+  radix::options o;
+  o.write_combining = false;
+  time(type, "direct", input, out, [&] { radix::sort(out.data(), n, o); },
+       opts);
+  bool ok = out == expected;
+  o.write_combining = true;
+  time(type, "combining", input, out, [&] { radix::sort(out.data(), n, o); },
+       opts);
+  ok = ok && out == expected;
+  o.threads = 0;
+  time(type, "parallel", input, out, [&] { radix::sort(out.data(), n, o); },
+       opts);
+  ok = ok && out == expected;
+  if (!ok) {
+    printf("bug!\n");
+  }
+  return ok;
+}
+
+// 8-byte keys with a 4-byte row number
+static bool run_payload(size_t n, std::mt19937_64 &gen,
+                        harness::options &opts) {
+  typedef std::pair<uint64_t, uint32_t> pair;
+  std::vector<pair> input(n), out(n);
+  std::vector<uint64_t> keys(n);
+  std::vector<uint32_t> rows(n);
+  for (size_t i = 0; i < n; i++) {
+    input[i] = pair(gen(), uint32_t(i));
+  }
+  time("uint64_t+uint32_t", "std::sort", input, out, [&] {
+    std::sort(out.begin(), out.end(),
+              [](const pair &x, const pair &y) { return x.first < y.first; });
+  }, opts);
+  time("uint64_t+uint32_t", "combining", input, out, [&] {
+    for (size_t i = 0; i < n; i++) {
+      keys[i] = out[i].first;
+      rows[i] = out[i].second;
+    }
+    radix::sort(keys.data(), rows.data(), n);
+  }, opts);
+  std::sort(input.begin(), input.end());
+  for (size_t i = 0; i < n; i++) {
+    if (keys[i] != input[i].first || rows[i] != input[i].second) {
+      printf("bug!\n");
+      return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  const size_t n = argc > 1 ? size_t(atoll(argv[1])) : 10000000;
+  std::mt19937_64 gen(1234);
+  harness::options opts = harness::default_options();
+  opts.repeat = 3;
+  printf("n = %zu, %u hardware threads\n", n,
+         std::thread::hardware_concurrency());
+  printf("keys            \tsort      \tns/key\n");
+  const uint64_t all = ~uint64_t(0);
+  if (!run<uint32_t>("uint32_t", n, all, gen, opts) ||
+      !run<int32_t>("int32_t", n, all, gen, opts) ||
+      !run<float>("float", n, uint32_t(all), gen, opts) ||
+      !run<uint64_t>("uint64_t", n, all, gen, opts) ||
+      !run<uint64_t>("uint64_t (24-bit)", n, 0xFFFFFF, gen, opts) ||
+      !run<int64_t>("int64_t", n, all, gen, opts) ||
+      !run<double>("double", n, all, gen, opts) ||
+      !run_payload(n, gen, opts)) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
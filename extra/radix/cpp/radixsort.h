@@ -0,0 +1,327 @@
+// Least-significant-digit radix sort of uint32_t, uint64_t, int32_t,
+// int64_t, float and double keys (and of the other integer types of 32 or
+// 64 bits, such as long long), with or without a payload of any trivially
+// copyable type. The sort is stable.
+//
+// RadixSort.java (extra/radix/java) sorts int arrays by 8-bit digits after
+// subtracting Integer.MIN_VALUE. Here every key type is mapped to an
+// unsigned integer that sorts the same way: the sign bit flipped for signed
+// integers, and sign_flip of 2020/12/14/sort_float.cpp for floating-point
+// values (all bits flipped when negative). The keys are mapped in place
+// before the first pass and back after the last.
+//
+// All the histograms come from one read of the keys. A digit that is the
+// same for every key has a single bucket: its pass is skipped. The passes
+// that remain scatter through software write-combining buffers: each
+// bucket gathers a cache line of keys (and the matching payloads) before
+// it is copied out, so that the writes go to 256 lines at a time instead
+// of touching 256 streams value by value.
+// Payloads larger than a cache line move one by one.
+//
+// With options::threads > 1 and enough keys, the histograms and each
+// scatter are split by slices of the array: every thread counts the digits
+// of its slice, and writes them after those of the threads before it.
+//
+// Header-only, C++14 (-pthread):
+//
+//   radix::sort(keys.data(), keys.size());
+//   radix::sort(keys.data(), rows.data(), keys.size()); // rows follow keys
+#ifndef RADIXSORT_H
+#define RADIXSORT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "../../parallel/parallel.h"
+
+namespace radix {
+
+struct options {
+  unsigned threads = 1;        // 0: one per hardware thread
+  bool write_combining = true; // false: one write per value
+};
+
+namespace internal {
+
+// The unsigned integer U each key maps to, and the maps.
+template <class K> struct key_traits;
+
+template <> struct key_traits<uint32_t> {
+  typedef uint32_t bits;
+  static bits to_bits(uint32_t x) { return x; }
+  static uint32_t from_bits(bits x) { return x; }
+};
+template <> struct key_traits<uint64_t> {
+  typedef uint64_t bits;
+  static bits to_bits(uint64_t x) { return x; }
+  static uint64_t from_bits(bits x) { return x; }
+};
+template <> struct key_traits<int32_t> {
+  typedef uint32_t bits;
+  static bits to_bits(int32_t x) { return uint32_t(x) ^ 0x80000000U; }
+  static int32_t from_bits(bits x) { return int32_t(x ^ 0x80000000U); }
+};
+template <> struct key_traits<int64_t> {
+  typedef uint64_t bits;
+  static bits to_bits(int64_t x) {
+    return uint64_t(x) ^ 0x8000000000000000ULL;
+  }
+  static int64_t from_bits(bits x) {
+    return int64_t(x ^ 0x8000000000000000ULL);
+  }
+};
+// sign_flip of sort_float.cpp, and its inverse
+template <class F, class B> struct float_traits {
+  typedef B bits;
+  static constexpr B sign = B(1) << (8 * sizeof(B) - 1);
+  static bits to_bits(F x) {
+    B b;
+    memcpy(&b, &x, sizeof(b));
+    const B mask = (b & sign) ? B(~B(0)) : sign;
+    return b ^ mask;
+  }
+  static F from_bits(bits b) {
+    const B mask = (b & sign) ? sign : B(~B(0));
+    b ^= mask;
+    F x;
+    memcpy(&x, &b, sizeof(x));
+    return x;
+  }
+};
+template <> struct key_traits<float> : float_traits<float, uint32_t> {};
+template <> struct key_traits<double> : float_traits<double, uint64_t> {};
+
+template <size_t Size, bool Signed> struct fixed_width;
+template <> struct fixed_width<4, false> { typedef uint32_t type; };
+template <> struct fixed_width<8, false> { typedef uint64_t type; };
+template <> struct fixed_width<4, true> { typedef int32_t type; };
+template <> struct fixed_width<8, true> { typedef int64_t type; };
+
+// The other integer types, which are not one of the above though of the
+// same size (long long next to int64_t = long on LP64, long on LLP64): the
+// traits of the fixed-width type of their size and signedness.
+template <class K>
+struct key_traits
+    : key_traits<typename fixed_width<sizeof(K),
+                                      std::is_signed<K>::value>::type> {
+  static_assert(std::is_integral<K>::value,
+                "integer or floating-point keys");
+};
+
+constexpr size_t radix = 256;
+constexpr size_t cache_line = 64;
+
+// The histograms of all the digits of keys[begin, end).
+template <class U>
+void count_digits(const U *keys, size_t begin, size_t end, size_t *counts) {
+  for (size_t i = begin; i < end; i++) {
+    U u = keys[i];
+    for (size_t d = 0; d < sizeof(U); d++) {
+      counts[d * radix + (u & 0xFF)]++;
+      u >>= 8;
+    }
+  }
+}
+
+template <class U>
+void count_digit(const U *keys, size_t begin, size_t end, int shift,
+                 size_t *counts) {
+  for (size_t i = begin; i < end; i++) {
+    counts[(keys[i] >> shift) & 0xFF]++;
+  }
+}
+
+// Moves src[begin, end) (and the payloads) to dst, bucket b starting at
+// offsets[b]; offsets are advanced.
+template <bool Payload, class U, class V>
+void scatter_direct(const U *src, const V *src_values, size_t begin,
+                    size_t end, U *dst, V *dst_values, int shift,
+                    size_t *offsets) {
+  for (size_t i = begin; i < end; i++) {
+    const U u = src[i];
+    const size_t o = offsets[(u >> shift) & 0xFF]++;
+    dst[o] = u;
+    if (Payload) {
+      dst_values[o] = src_values[i];
+    }
+  }
+}
+
+// The same through a line of keys per bucket. A bucket's first flush stops
+// at a cache-line boundary of the destination, so that the later ones
+// write whole lines. The payloads of the line of bucket b go to
+// values[b * line, (b + 1) * line), on the heap: with payloads of up to a
+// cache line, the 256 lines take up to 256 kB.
+template <bool Payload, class U, class V>
+void scatter_combining(const U *src, const V *src_values, size_t begin,
+                       size_t end, U *dst, V *dst_values, int shift,
+                       size_t *offsets, V *values) {
+  constexpr size_t line = cache_line / sizeof(U);
+  alignas(cache_line) U keys[radix][line];
+  uint8_t fill[radix], limit[radix];
+  for (size_t b = 0; b < radix; b++) {
+    fill[b] = 0;
+    const uintptr_t address = uintptr_t(dst + offsets[b]);
+    limit[b] = uint8_t(line - (address / sizeof(U)) % line);
+  }
+  for (size_t i = begin; i < end; i++) {
+    const U u = src[i];
+    const size_t b = (u >> shift) & 0xFF;
+    const size_t f = fill[b];
+    keys[b][f] = u;
+    if (Payload) {
+      values[b * line + f] = src_values[i];
+    }
+    if (f + 1 == limit[b]) {
+      memcpy(dst + offsets[b], keys[b], limit[b] * sizeof(U));
+      if (Payload) {
+        memcpy(dst_values + offsets[b], values + b * line,
+               limit[b] * sizeof(V));
+      }
+      offsets[b] += limit[b];
+      fill[b] = 0;
+      limit[b] = uint8_t(line);
+    } else {
+      fill[b] = uint8_t(f + 1);
+    }
+  }
+  for (size_t b = 0; b < radix; b++) {
+    memcpy(dst + offsets[b], keys[b], fill[b] * sizeof(U));
+    if (Payload) {
+      memcpy(dst_values + offsets[b], values + b * line,
+             fill[b] * sizeof(V));
+    }
+    offsets[b] += fill[b];
+  }
+}
+
+template <bool Payload, class U, class V>
+void scatter(const U *src, const V *src_values, size_t begin, size_t end,
+             U *dst, V *dst_values, int shift, size_t *offsets,
+             bool combining, V *values) {
+  if (combining) {
+    scatter_combining<Payload>(src, src_values, begin, end, dst, dst_values,
+                               shift, offsets, values);
+  } else {
+    scatter_direct<Payload>(src, src_values, begin, end, dst, dst_values,
+                            shift, offsets);
+  }
+}
+
+// Sorts the n mapped keys, ping-ponging with the scratch arrays; the
+// result ends up in keys (and values).
+template <bool Payload, class U, class V>
+void lsd(U *keys, V *values, size_t n, const options &o) {
+  unsigned threads = parallel::thread_count(o.threads);
+  if (n / threads < parallel::minimum_values) {
+    threads = 1;
+  }
+  auto slice = [n, threads](unsigned t) { return t * n / threads; };
+  constexpr size_t digits = sizeof(U);
+  std::vector<size_t> counts(threads * digits * radix, 0);
+  parallel::in_parallel(threads, [&](unsigned t) {
+    count_digits(keys, slice(t), slice(t + 1),
+                 counts.data() + t * digits * radix);
+  });
+  std::vector<size_t> histograms(digits * radix, 0);
+  for (unsigned t = 0; t < threads; t++) {
+    for (size_t i = 0; i < digits * radix; i++) {
+      histograms[i] += counts[t * digits * radix + i];
+    }
+  }
+  std::vector<U> scratch(n);
+  std::vector<V> scratch_values(Payload ? n : 0);
+  U *src = keys, *dst = scratch.data();
+  V *src_values = values, *dst_values = scratch_values.data();
+  std::vector<size_t> offsets(threads * radix);
+  // Payloads larger than a cache line are whole lines already: they go
+  // straight to their place. The others get a line per bucket and thread.
+  constexpr size_t line = cache_line / sizeof(U);
+  const bool combining =
+      o.write_combining && (!Payload || sizeof(V) <= cache_line);
+  std::vector<V> lines(Payload && combining ? threads * radix * line : 0);
+  for (size_t d = 0; d < digits; d++) {
+    const size_t *histogram = histograms.data() + d * radix;
+    const int shift = int(8 * d);
+    if (n == 0 || histogram[(src[0] >> shift) & 0xFF] == n) {
+      continue; // a single bucket
+    }
+    if (threads == 1) {
+      size_t position = 0;
+      for (size_t b = 0; b < radix; b++) {
+        offsets[b] = position;
+        position += histogram[b];
+      }
+    } else {
+      std::fill(counts.begin(), counts.end(), 0);
+      parallel::in_parallel(threads, [&](unsigned t) {
+        count_digit(src, slice(t), slice(t + 1), shift,
+                    counts.data() + t * radix);
+      });
+      size_t position = 0;
+      for (size_t b = 0; b < radix; b++) {
+        for (unsigned t = 0; t < threads; t++) {
+          offsets[t * radix + b] = position;
+          position += counts[t * radix + b];
+        }
+      }
+    }
+    parallel::in_parallel(threads, [&](unsigned t) {
+      scatter<Payload>(src, src_values, slice(t), slice(t + 1), dst,
+                       dst_values, shift, offsets.data() + t * radix,
+                       combining,
+                       lines.empty() ? nullptr
+                                     : lines.data() + t * radix * line);
+    });
+    std::swap(src, dst);
+    std::swap(src_values, dst_values);
+  }
+  if (src != keys) {
+    memcpy(keys, src, n * sizeof(U));
+    if (Payload) {
+      memcpy(values, src_values, n * sizeof(V));
+    }
+  }
+}
+
+template <bool Payload, class K, class V>
+void sort(K *keys, V *values, size_t n, const options &o) {
+  typedef key_traits<K> traits;
+  typedef typename traits::bits U;
+  static_assert(sizeof(U) == sizeof(K), "keys map to integers of their size");
+  static_assert(std::is_trivially_copyable<V>::value,
+                "payloads are copied with memcpy");
+  for (size_t i = 0; i < n; i++) {
+    const U u = traits::to_bits(keys[i]);
+    memcpy(keys + i, &u, sizeof(u));
+  }
+  lsd<Payload>(reinterpret_cast<U *>(keys), values, n, o);
+  for (size_t i = 0; i < n; i++) {
+    U u;
+    memcpy(&u, keys + i, sizeof(u));
+    keys[i] = traits::from_bits(u);
+  }
+}
+
+} // namespace internal
+
+// Sorts the keys in increasing order. Floating-point keys follow the IEEE
+// total order: -NaN < -inf < ... < -0.0 < +0.0 < ... < +inf < +NaN.
+template <class K>
+void sort(K *keys, size_t n, const options &o = options()) {
+  internal::sort<false>(keys, static_cast<char *>(nullptr), n, o);
+}
+
+// Same, and values[i] moves with keys[i]; equal keys keep their order.
+template <class K, class V>
+void sort(K *keys, V *values, size_t n, const options &o = options()) {
+  internal::sort<true>(keys, values, n, o);
+}
+
+} // namespace radix
+
+#endif // RADIXSORT_H
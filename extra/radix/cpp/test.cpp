@@ -0,0 +1,180 @@
+// Checks of every key type, long and long long included (whichever of them
+// are not int64_t), against std::stable_sort, with and without payloads,
+// write-combining buffers and threads: all the lengths up to 300, then
+// longer arrays of random keys, keys that differ in a few bytes only
+// (skipped passes) and keys with few distinct values; then the order of
+// signed zeros, infinities and NaNs, and payloads of 4 kB.
+#include "radixsort.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <utility>
+#include <vector>
+
+namespace {
+
+std::mt19937_64 gen(1234);
+
+template <class K> K random_key(uint64_t mask) {
+  const uint64_t r = gen() & mask;
+  K k;
+  if (std::is_floating_point<K>::value) {
+    k = K(int64_t(r - mask / 2)) / K(16);
+  } else {
+    memcpy(&k, &r, sizeof(k)); // little endian: the low bytes of r
+  }
+  return k;
+}
+
+// what is kept of the random bits: all, the middle bytes only, or 3 bits
+const uint64_t masks[] = {~uint64_t(0), 0x0000FF00FF000000ULL, 7};
+
+struct row {
+  uint32_t id;
+  char tag[12];
+};
+
+template <class K>
+bool check(const std::vector<K> &input, const radix::options &o) {
+  std::vector<std::pair<K, uint32_t>> expected(input.size());
+  for (size_t i = 0; i < input.size(); i++) {
+    expected[i] = std::make_pair(input[i], uint32_t(i));
+  }
+  std::stable_sort(expected.begin(), expected.end(),
+                   [](const std::pair<K, uint32_t> &x,
+                      const std::pair<K, uint32_t> &y) {
+                     return x.first < y.first;
+                   });
+  std::vector<K> keys(input);
+  radix::sort(keys.data(), keys.size(), o);
+  bool ok = true;
+  for (size_t i = 0; ok && i < keys.size(); i++) {
+    ok = keys[i] == expected[i].first;
+  }
+  keys = input;
+  std::vector<row> rows(input.size());
+  for (size_t i = 0; i < rows.size(); i++) {
+    rows[i].id = uint32_t(i);
+    snprintf(rows[i].tag, sizeof(rows[i].tag), "row %zu", i % 1000);
+  }
+  radix::sort(keys.data(), rows.data(), keys.size(), o);
+  for (size_t i = 0; ok && i < keys.size(); i++) {
+    char tag[12];
+    snprintf(tag, sizeof(tag), "row %zu", size_t(expected[i].second % 1000));
+    ok = keys[i] == expected[i].first && rows[i].id == expected[i].second &&
+         strcmp(rows[i].tag, tag) == 0;
+  }
+  if (!ok) {
+    printf("bug: %zu-byte keys, n = %zu, %u threads, combining %d\n",
+           sizeof(K), input.size(), o.threads, int(o.write_combining));
+  }
+  return ok;
+}
+
+template <class K> bool check_type() {
+  for (int combining = 0; combining < 2; combining++) {
+    radix::options o;
+    o.write_combining = combining != 0;
+    for (size_t n = 0; n <= 300; n++) {
+      std::vector<K> keys(n);
+      for (auto &k : keys) {
+        k = random_key<K>(masks[n % 3]);
+      }
+      if (!check(keys, o)) {
+        return false;
+      }
+    }
+    for (uint64_t mask : masks) {
+      for (unsigned threads : {1u, 3u}) {
+        o.threads = threads;
+        std::vector<K> keys(threads == 1 ? 1 + gen() % 50000
+                                         : 200000 + gen() % 1000);
+        for (auto &k : keys) {
+          k = random_key<K>(mask);
+        }
+        if (!check(keys, o)) {
+          return false;
+        }
+      }
+      o.threads = 1;
+    }
+  }
+  return true;
+}
+
+// Payloads of 4 kB, larger than the write-combining lines, with the
+// default options: in place of a line per bucket, they move one by one.
+bool large_payloads() {
+  struct page {
+    uint32_t id;
+    char bytes[4092];
+  };
+  std::vector<uint32_t> keys(5000);
+  std::vector<page> pages(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    keys[i] = uint32_t(gen() % 1000);
+    pages[i].id = uint32_t(i);
+    memset(pages[i].bytes, int(i % 256), sizeof(pages[i].bytes));
+  }
+  std::vector<std::pair<uint32_t, uint32_t>> expected;
+  for (size_t i = 0; i < keys.size(); i++) {
+    expected.emplace_back(keys[i], uint32_t(i));
+  }
+  std::stable_sort(expected.begin(), expected.end(),
+                   [](const std::pair<uint32_t, uint32_t> &x,
+                      const std::pair<uint32_t, uint32_t> &y) {
+                     return x.first < y.first;
+                   });
+  radix::sort(keys.data(), pages.data(), keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    const page &p = pages[i];
+    if (keys[i] != expected[i].first || p.id != expected[i].second ||
+        p.bytes[0] != char(p.id % 256) ||
+        p.bytes[sizeof(p.bytes) - 1] != char(p.id % 256)) {
+      printf("bug: 4 kB payloads, at %zu\n", i);
+      return false;
+    }
+  }
+  return true;
+}
+
+// -NaN < -inf < -1 < -0 < +0 < 1 < inf < NaN
+template <class F> bool total_order() {
+  const F inf = std::numeric_limits<F>::infinity();
+  const F nan = std::numeric_limits<F>::quiet_NaN();
+  const F expected[] = {-nan, -inf, F(-1), F(-0.0), F(0.0), F(1), inf, nan};
+  std::vector<F> keys;
+  for (int copies = 0; copies < 10; copies++) {
+    keys.insert(keys.end(), std::begin(expected), std::end(expected));
+  }
+  std::shuffle(keys.begin(), keys.end(), gen);
+  radix::sort(keys.data(), keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    if (memcmp(&keys[i], &expected[i / 10], sizeof(F)) != 0) {
+      printf("bug: order of %g\n", double(keys[i]));
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main() {
+  if (!check_type<uint32_t>() || !check_type<uint64_t>() ||
+      !check_type<int32_t>() || !check_type<int64_t>() ||
+      !check_type<float>() || !check_type<double>() ||
+      !check_type<long long>() || !check_type<unsigned long long>() ||
+      !check_type<long>() || !check_type<unsigned long>() ||
+      !total_order<float>() || !total_order<double>() ||
+      !large_payloads()) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
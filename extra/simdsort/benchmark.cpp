@@ -0,0 +1,93 @@
+// Speed of the sorts of n random values (1 million by default), in ns per
+// value: std::sort and the timsort of 2016/09/28 against each back end, the
+// parallel mode with one thread per hardware thread, and argsort.
+#include "simdsort.h"
+
+#include "../harness/harness.h"
+#include "../../2016/09/28/timsort.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+template <class T> static T random_value(std::mt19937_64 &gen) {
+  return T(gen());
+}
+template <> float random_value<float>(std::mt19937_64 &gen) {
+  return float(int32_t(gen())) / 1024;
+}
+template <> double random_value<double>(std::mt19937_64 &gen) {
+  return double(int64_t(gen())) / 1024;
+}
+
+template <class T, class F>
+static void time(const char *type, const char *name,
+                 const std::vector<T> &input, std::vector<T> &out, F f,
+                 harness::options &opts) {
+  harness::print_row(type, 8, 14,
+                     harness::run_on_copy(name, input, out, f, opts));
+}
+
+template <class T>
+static bool run(const char *type, size_t n, std::mt19937_64 &gen,
+                harness::options &opts) {
+  std::vector<T> input(n), expected, out(n);
+  for (auto &v : input) {
+    v = random_value<T>(gen);
+  }
+  expected = input;
+  std::sort(expected.begin(), expected.end());
+  time(type, "std::sort", input, out,
+       [&] { std::sort(out.begin(), out.end()); }, opts);
+  time(type, "timsort", input, out,
+       [&] { gfx::timsort(out.begin(), out.end()); }, opts);
+  const simdsort::backend backends[] = {simdsort::backend::avx2,
+                                        simdsort::backend::avx512};
+  for (simdsort::backend b : backends) {
+    if (!simdsort::backend_supported(b)) {
+      continue;
+    }
+    simdsort::options o;
+    o.kernel = b;
+    time(type, simdsort::backend_name(b), input, out,
+         [&] { simdsort::sort(out.data(), n, o); }, opts);
+    if (out != expected) {
+      printf("bug!\n");
+      return false;
+    }
+  }
+  simdsort::options parallel;
+  parallel.threads = 0;
+  time(type, "parallel", input, out,
+       [&] { simdsort::sort(out.data(), n, parallel); }, opts);
+  if (out != expected) {
+    printf("bug!\n");
+    return false;
+  }
+  std::vector<size_t> indexes(n);
+  time(type, "argsort", input, out,
+       [&] { simdsort::argsort(out.data(), n, indexes.data()); }, opts);
+  return true;
+}
+
+int main(int argc, char **argv) {
+  const size_t n = argc > 1 ? size_t(atoll(argv[1])) : 1000000;
+  std::mt19937_64 gen(1234);
+  harness::options opts = harness::default_options();
+  opts.repeat = 5;
+  printf("n = %zu, best back end: %s, %u hardware threads\n", n,
+         simdsort::backend_name(simdsort::active_backend()),
+         std::thread::hardware_concurrency());
+  printf("type    \tsort          \tns/value\n");
+  if (!run<int32_t>("int32_t", n, gen, opts) ||
+      !run<uint32_t>("uint32_t", n, gen, opts) ||
+      !run<int64_t>("int64_t", n, gen, opts) ||
+      !run<float>("float", n, gen, opts) ||
+      !run<double>("double", n, gen, opts)) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
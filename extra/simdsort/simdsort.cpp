@@ -0,0 +1,323 @@
+// Runtime dispatch, the scalar back end, the conversions of each type to
+// int32_t or int64_t, argsort and the parallel sample sort.
+#include "simdsort.h"
+#include "simdsort_kernels.h"
+
+#include <atomic>
+#include <utility>
+#include <vector>
+
+#include "../isa/dispatch.h"
+#include "../parallel/parallel.h"
+
+namespace simdsort {
+
+const functions &scalar_functions() {
+  static const functions scalar = {
+      [](int32_t *values, size_t n) { std::sort(values, values + n); },
+      [](int64_t *values, size_t n) { std::sort(values, values + n); }};
+  return scalar;
+}
+
+namespace {
+
+struct implementation {
+  backend kind;
+  const char *name;
+  uint32_t required_instruction_sets;
+  const functions &(*table)();
+};
+
+const implementation scalar = {backend::scalar, "scalar", 0,
+                               scalar_functions};
+const implementation avx2 = {backend::avx2, "avx2", instruction_set::AVX2,
+                             avx2_functions};
+const implementation avx512 = {backend::avx512, "avx512",
+                               instruction_set::AVX512F, avx512_functions};
+
+const implementation *const implementations[] = {&avx512, &avx2, &scalar};
+
+const implementation *best() {
+  static const implementation *best =
+      isa::first_supported(implementations, &scalar);
+  return best;
+}
+
+// nullptr if unknown or unsupported
+const implementation *find(backend kind) {
+  if (kind == backend::automatic) {
+    return best();
+  }
+  return isa::find(implementations, kind);
+}
+
+sort_function<int32_t> pick(const functions &table, int32_t) {
+  return table.sort32;
+}
+sort_function<int64_t> pick(const functions &table, int64_t) {
+  return table.sort64;
+}
+
+// Sample sort. buckets - 1 splitters come from a sorted sample; each thread
+// finds the bucket of the values of its slice (a branch-free search over
+// the splitters) and counts them; each then copies its values to their
+// place in a buffer; finally the threads take the buckets one by one, sort
+// them in the buffer and copy them back. Many copies of the same value all
+// land in one bucket: the sort stays correct, but that bucket is sorted by
+// one thread.
+template <class T>
+void parallel_sort(T *a, size_t n, unsigned threads, sort_function<T> kernel) {
+  size_t buckets = 1;
+  while (buckets < 4 * size_t(threads) && buckets < 256) {
+    buckets *= 2;
+  }
+  const size_t oversampling = 32;
+  std::vector<T> sample(buckets * oversampling);
+  for (size_t i = 0; i < sample.size(); i++) {
+    sample[i] = a[(i * 2 + 1) * n / (2 * sample.size())];
+  }
+  kernel(sample.data(), sample.size());
+  std::vector<T> splitters(buckets);
+  for (size_t b = 0; b + 1 < buckets; b++) {
+    splitters[b] = sample[(b + 1) * oversampling];
+  }
+  std::vector<uint8_t> bucket_of(n);
+  std::vector<size_t> counts(threads * buckets, 0);
+  auto slice = [n, threads](unsigned t) { return t * n / threads; };
+  parallel::in_parallel(threads, [&](unsigned t) {
+    size_t *count = counts.data() + t * buckets;
+    const T *s = splitters.data();
+    for (size_t i = slice(t); i < slice(t + 1); i++) {
+      const T x = a[i];
+      // the number of splitters at most x
+      size_t b = 0;
+      for (size_t step = buckets / 2; step > 0; step /= 2) {
+        b += (s[b + step - 1] <= x) ? step : 0;
+      }
+      bucket_of[i] = uint8_t(b);
+      count[b]++;
+    }
+  });
+  // offsets[t * buckets + b]: where thread t writes into bucket b
+  std::vector<size_t> offsets(threads * buckets);
+  std::vector<size_t> starts(buckets + 1);
+  size_t position = 0;
+  for (size_t b = 0; b < buckets; b++) {
+    starts[b] = position;
+    for (unsigned t = 0; t < threads; t++) {
+      offsets[t * buckets + b] = position;
+      position += counts[t * buckets + b];
+    }
+  }
+  starts[buckets] = n;
+  std::vector<T> buffer(n);
+  parallel::in_parallel(threads, [&](unsigned t) {
+    size_t *offset = offsets.data() + t * buckets;
+    for (size_t i = slice(t); i < slice(t + 1); i++) {
+      buffer[offset[bucket_of[i]]++] = a[i];
+    }
+  });
+  std::atomic<size_t> next(0);
+  parallel::in_parallel(threads, [&](unsigned) {
+    for (size_t b; (b = next++) < buckets;) {
+      const size_t size = starts[b + 1] - starts[b];
+      kernel(buffer.data() + starts[b], size);
+      memcpy(a + starts[b], buffer.data() + starts[b], size * sizeof(T));
+    }
+  });
+}
+
+template <class T> bool sort_as(T *a, size_t n, const options &o) {
+  const implementation *impl = find(o.kernel);
+  if (impl == nullptr) {
+    return false;
+  }
+  const sort_function<T> kernel = pick(impl->table(), T());
+  const unsigned threads = parallel::thread_count(o.threads);
+  if (threads > 1 && n / threads >= parallel::minimum_values) {
+    parallel_sort(a, n, threads, kernel);
+  } else {
+    kernel(a, n);
+  }
+  return true;
+}
+
+// The order-preserving maps to signed integers; each is its own inverse.
+inline int32_t flip(uint32_t x) { return int32_t(x ^ 0x80000000U); }
+// negative values: all bits but the sign, so that larger magnitudes come
+// first
+inline int32_t flip(float x) {
+  int32_t bits;
+  memcpy(&bits, &x, sizeof(bits));
+  return bits ^ int32_t(uint32_t(bits >> 31) >> 1);
+}
+inline int64_t flip(double x) {
+  int64_t bits;
+  memcpy(&bits, &x, sizeof(bits));
+  return bits ^ int64_t(uint64_t(bits >> 63) >> 1);
+}
+inline void unflip(int32_t bits, uint32_t *x) {
+  *x = uint32_t(flip(uint32_t(bits)));
+}
+inline void unflip(int32_t bits, float *x) {
+  bits ^= int32_t(uint32_t(bits >> 31) >> 1);
+  memcpy(x, &bits, sizeof(bits));
+}
+inline void unflip(int64_t bits, double *x) {
+  bits ^= int64_t(uint64_t(bits >> 63) >> 1);
+  memcpy(x, &bits, sizeof(bits));
+}
+
+// Sorts the values of type U as the signed integers of the same size they
+// map to, in place.
+template <class I, class U>
+bool sort_flipped(U *values, size_t n, const options &o) {
+  static_assert(sizeof(I) == sizeof(U), "same size");
+  if (find(o.kernel) == nullptr) {
+    return false;
+  }
+  for (size_t i = 0; i < n; i++) {
+    const I bits = flip(values[i]);
+    memcpy(values + i, &bits, sizeof(bits));
+  }
+  I *as_integers = reinterpret_cast<I *>(values);
+  sort_as(as_integers, n, o);
+  for (size_t i = 0; i < n; i++) {
+    I bits;
+    memcpy(&bits, values + i, sizeof(bits));
+    unflip(bits, values + i);
+  }
+  return true;
+}
+
+inline int32_t key32(int32_t x) { return x; }
+template <class U> inline int32_t key32(U x) { return flip(x); }
+inline int64_t key64(int64_t x) { return x; }
+template <class U> inline int64_t key64(U x) { return flip(x); }
+
+// (key, index) pairs through std::sort, when the indexes do not fit in 32
+// bits.
+template <class U, class Key>
+void argsort_pairs(const U *keys, size_t n, size_t *indexes, Key key) {
+  std::vector<std::pair<decltype(key(keys[0])), size_t>> pairs(n);
+  for (size_t i = 0; i < n; i++) {
+    pairs[i] = std::make_pair(key(keys[i]), i);
+  }
+  std::sort(pairs.begin(), pairs.end());
+  for (size_t i = 0; i < n; i++) {
+    indexes[i] = pairs[i].second;
+  }
+}
+
+// The key in the high half, the index in the low half: the int64_t order
+// is the key order, then the index order.
+template <class U>
+bool argsort32(const U *keys, size_t n, size_t *indexes, const options &o) {
+  if (find(o.kernel) == nullptr) {
+    return false;
+  }
+  if (uint64_t(n) > 0xFFFFFFFFULL) {
+    argsort_pairs(keys, n, indexes, [](U x) { return key32(x); });
+    return true;
+  }
+  std::vector<int64_t> packed(n);
+  for (size_t i = 0; i < n; i++) {
+    packed[i] = int64_t((uint64_t(uint32_t(key32(keys[i]))) << 32) | i);
+  }
+  sort_as(packed.data(), n, o);
+  for (size_t i = 0; i < n; i++) {
+    indexes[i] = size_t(uint32_t(packed[i]));
+  }
+  return true;
+}
+
+// Two sorts of packed int64_t: first by the high half of the key (signed)
+// then the index, as argsort32 does; then each run of equal high halves by
+// the low half (unsigned, its top bit flipped) then the index. That is one
+// sort when the high halves all differ, two when they are all the same
+// (small integers).
+template <class U>
+bool argsort64(const U *keys, size_t n, size_t *indexes, const options &o) {
+  if (find(o.kernel) == nullptr) {
+    return false;
+  }
+  if (uint64_t(n) > 0xFFFFFFFFULL) {
+    argsort_pairs(keys, n, indexes, [](U x) { return key64(x); });
+    return true;
+  }
+  std::vector<int64_t> packed(n);
+  for (size_t i = 0; i < n; i++) {
+    const uint64_t high = uint64_t(key64(keys[i])) >> 32;
+    packed[i] = int64_t((high << 32) | i);
+  }
+  sort_as(packed.data(), n, o);
+  for (size_t begin = 0, end; begin < n; begin = end) {
+    const int64_t high = packed[begin] >> 32;
+    for (end = begin + 1; end < n && packed[end] >> 32 == high; end++) {
+    }
+    if (end - begin < 2) {
+      continue;
+    }
+    for (size_t i = begin; i < end; i++) {
+      const uint32_t index = uint32_t(packed[i]);
+      const uint32_t low = uint32_t(key64(keys[index])) ^ 0x80000000;
+      packed[i] = int64_t((uint64_t(low) << 32) | index);
+    }
+    sort_as(packed.data() + begin, end - begin, o);
+  }
+  for (size_t i = 0; i < n; i++) {
+    indexes[i] = size_t(uint32_t(packed[i]));
+  }
+  return true;
+}
+
+} // namespace
+
+bool backend_supported(backend b) { return find(b) != nullptr; }
+
+backend active_backend() { return best()->kind; }
+
+const char *backend_name(backend b) {
+  if (b == backend::automatic) {
+    return best()->name;
+  }
+  return isa::name_of(implementations, b);
+}
+
+bool sort(int32_t *values, size_t n, const options &o) {
+  return sort_as(values, n, o);
+}
+bool sort(uint32_t *values, size_t n, const options &o) {
+  return sort_flipped<int32_t>(values, n, o);
+}
+bool sort(int64_t *values, size_t n, const options &o) {
+  return sort_as(values, n, o);
+}
+bool sort(float *values, size_t n, const options &o) {
+  return sort_flipped<int32_t>(values, n, o);
+}
+bool sort(double *values, size_t n, const options &o) {
+  return sort_flipped<int64_t>(values, n, o);
+}
+
+bool argsort(const int32_t *keys, size_t n, size_t *indexes,
+             const options &o) {
+  return argsort32(keys, n, indexes, o);
+}
+bool argsort(const uint32_t *keys, size_t n, size_t *indexes,
+             const options &o) {
+  return argsort32(keys, n, indexes, o);
+}
+bool argsort(const int64_t *keys, size_t n, size_t *indexes,
+             const options &o) {
+  return argsort64(keys, n, indexes, o);
+}
+bool argsort(const float *keys, size_t n, size_t *indexes, const options &o) {
+  return argsort32(keys, n, indexes, o);
+}
+bool argsort(const double *keys, size_t n, size_t *indexes,
+             const options &o) {
+  return argsort64(keys, n, indexes, o);
+}
+
+} // namespace simdsort
@@ -0,0 +1,73 @@
+// Sorting of int32_t, uint32_t, int64_t, float and double arrays with
+// AVX2 or AVX-512, picked at runtime.
+//
+// sort.c partitions int32_t values around the last one, 8 at a time, with
+// a permutation table (avx_pivot_on_last_value). Here the same partition
+// works from both ends of the array, in place, with a median-of-nine pivot,
+// and the small pieces (up to 8 vectors) are sorted in registers by
+// sorting networks. Every type is sorted as int32_t or int64_t: unsigned
+// values have their sign bit flipped and floating-point values their other
+// bits flipped when negative, before and after.
+//
+// argsort gives the permutation that sorts the keys, keeping equal keys in
+// their order. With 32-bit keys, each key and its index are sorted together
+// as one int64_t.
+//
+// With options::threads > 1, large arrays are sample-sorted: the values are
+// spread into buckets by splitters taken from a sample, in parallel, and
+// the buckets are sorted in parallel, at the cost of a copy of the array.
+//
+//   simdsort::sort(values.data(), values.size());
+#ifndef SIMDSORT_H
+#define SIMDSORT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace simdsort {
+
+enum class backend {
+  automatic, // best supported one
+  scalar,    // std::sort
+  avx2,
+  avx512
+};
+
+// Whether the back end can run on this processor, and its name.
+bool backend_supported(backend b);
+backend active_backend();
+const char *backend_name(backend b);
+
+struct options {
+  backend kernel = backend::automatic;
+  unsigned threads = 1; // 0: one per hardware thread
+};
+
+// Sorts the values in place, in increasing order. Floating-point values
+// follow the IEEE total order: -NaN < -inf < ... < -0.0 < +0.0 < ... <
+// +inf < +NaN. Returns false, leaving the values alone, if the back end is
+// not supported.
+bool sort(int32_t *values, size_t n, const options &o = options());
+bool sort(uint32_t *values, size_t n, const options &o = options());
+bool sort(int64_t *values, size_t n, const options &o = options());
+bool sort(float *values, size_t n, const options &o = options());
+bool sort(double *values, size_t n, const options &o = options());
+
+// Writes into indexes[0, n) the positions of the keys in sorted order
+// (keys[indexes[0]] is the smallest), equal keys by position. The keys are
+// not modified. With 64-bit keys, (key, index) pairs are sorted by
+// std::sort whatever the back end: there is no room to pack them.
+bool argsort(const int32_t *keys, size_t n, size_t *indexes,
+             const options &o = options());
+bool argsort(const uint32_t *keys, size_t n, size_t *indexes,
+             const options &o = options());
+bool argsort(const int64_t *keys, size_t n, size_t *indexes,
+             const options &o = options());
+bool argsort(const float *keys, size_t n, size_t *indexes,
+             const options &o = options());
+bool argsort(const double *keys, size_t n, size_t *indexes,
+             const options &o = options());
+
+} // namespace simdsort
+
+#endif // SIMDSORT_H
@@ -0,0 +1,183 @@
+// The vector operations with AVX2: 8 lanes of int32_t or 4 of int64_t
+// (with min/max made of a signed compare and a blend). The partition is the
+// one of sort.c: a permutation table puts the values below the pivot
+// first, and the same vector is written at both free ends. Compiled with
+// -mavx2 -mpopcnt.
+#include "simdsort_kernels.h"
+
+#include <immintrin.h>
+
+namespace simdsort {
+namespace {
+
+// reverseshufflemask of sort.c, the other way around: lanes[mask] lists the
+// 32-bit lanes selected by mask, then the others. Built by the compiler:
+// nothing of this file runs before we know the processor has AVX2.
+struct permutation_table {
+  uint32_t lanes[256][8] = {};
+  constexpr permutation_table() {
+    for (int mask = 0; mask < 256; mask++) {
+      int k = 0;
+      for (int i = 0; i < 8; i++) {
+        if (mask & (1 << i)) {
+          lanes[mask][k++] = uint32_t(i);
+        }
+      }
+      for (int i = 0; i < 8; i++) {
+        if (!(mask & (1 << i))) {
+          lanes[mask][k++] = uint32_t(i);
+        }
+      }
+    }
+  }
+};
+
+constexpr permutation_table permutation;
+
+inline __m256i load(const void *p) {
+  return _mm256_loadu_si256(static_cast<const __m256i *>(p));
+}
+
+inline void store(void *p, __m256i v) {
+  _mm256_storeu_si256(static_cast<__m256i *>(p), v);
+}
+
+// the selected 32-bit lanes to the front, the others after; the vector
+// goes to both ends
+inline size_t split(__m256i v, unsigned mask32, void *left, void *right) {
+  const __m256i both =
+      _mm256_permutevar8x32_epi32(v, load(permutation.lanes[mask32]));
+  store(left, both);
+  store(right, both);
+  return size_t(_mm_popcnt_u32(mask32));
+}
+
+inline __m256i lane32() { return _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7); }
+
+// all ones in the 32-bit lanes i where (i & bit) != 0
+inline __m256i has(int bit) {
+  const __m256i b = _mm256_set1_epi32(bit);
+  return _mm256_cmpeq_epi32(_mm256_and_si256(lane32(), b), b);
+}
+
+struct ops32 {
+  typedef int32_t value;
+  typedef __m256i vector;
+  static constexpr size_t lanes = 8;
+
+  static vector load(const value *p) { return simdsort::load(p); }
+  static void store(value *p, vector v) { simdsort::store(p, v); }
+  static vector broadcast(value v) { return _mm256_set1_epi32(v); }
+
+  // lanes distant by d: the maximum goes to the lanes where bit d is set,
+  // the other way around where bit k is set (k = lanes: never)
+  static vector stage(vector v, int d, int k) {
+    const vector p = _mm256_permutevar8x32_epi32(
+        v, _mm256_xor_si256(lane32(), _mm256_set1_epi32(d)));
+    return _mm256_blendv_epi8(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p),
+                              _mm256_xor_si256(has(d), has(k)));
+  }
+  static void sort(vector &v) {
+#pragma GCC unroll 3
+    for (int k = 2; k <= 8; k *= 2) {
+#pragma GCC unroll 3
+      for (int d = k / 2; d >= 1; d /= 2) {
+        v = stage(v, d, k);
+      }
+    }
+  }
+  static void merge(vector &low, vector &high) {
+    const vector r = _mm256_permutevar8x32_epi32(
+        high, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+    vector l = _mm256_min_epi32(low, r), h = _mm256_max_epi32(low, r);
+#pragma GCC unroll 3
+    for (int d = 4; d >= 1; d /= 2) {
+      l = stage(l, d, 8);
+      h = stage(h, d, 8);
+    }
+    low = l;
+    high = h;
+  }
+  template <bool Le>
+  static size_t partition(vector v, vector pivot, value *left,
+                          value *right_end) {
+    const unsigned above = unsigned(
+        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(v, pivot))));
+    const unsigned below =
+        Le ? ~above & 0xFF
+           : unsigned(_mm256_movemask_ps(
+                 _mm256_castsi256_ps(_mm256_cmpgt_epi32(pivot, v))));
+    return split(v, below, left, right_end - lanes);
+  }
+};
+
+struct ops64 {
+  typedef int64_t value;
+  typedef __m256i vector;
+  static constexpr size_t lanes = 4;
+
+  static vector load(const value *p) { return simdsort::load(p); }
+  static void store(value *p, vector v) { simdsort::store(p, v); }
+  static vector broadcast(value v) { return _mm256_set1_epi64x(v); }
+
+  static void minmax(vector x, vector y, vector &mn, vector &mx) {
+    const vector gt = _mm256_cmpgt_epi64(x, y);
+    mn = _mm256_blendv_epi8(x, y, gt);
+    mx = _mm256_blendv_epi8(y, x, gt);
+  }
+  // as with ops32, over the pairs of 32-bit lanes
+  static vector stage(vector v, int d, int k) {
+    const vector p = _mm256_permutevar8x32_epi32(
+        v, _mm256_xor_si256(lane32(), _mm256_set1_epi32(2 * d)));
+    vector mn, mx;
+    minmax(v, p, mn, mx);
+    return _mm256_blendv_epi8(mn, mx, _mm256_xor_si256(has(2 * d), has(2 * k)));
+  }
+  static void sort(vector &v) {
+#pragma GCC unroll 2
+    for (int k = 2; k <= 4; k *= 2) {
+#pragma GCC unroll 2
+      for (int d = k / 2; d >= 1; d /= 2) {
+        v = stage(v, d, k);
+      }
+    }
+  }
+  static void merge(vector &low, vector &high) {
+    vector l, h;
+    minmax(low, _mm256_permute4x64_epi64(high, 0x1B), l, h);
+#pragma GCC unroll 2
+    for (int d = 2; d >= 1; d /= 2) {
+      l = stage(l, d, 4);
+      h = stage(h, d, 4);
+    }
+    low = l;
+    high = h;
+  }
+  // each 64-bit lane is two 32-bit lanes
+  static unsigned widen(unsigned mask) {
+    unsigned mask32 = 0;
+    for (int i = 0; i < 4; i++) {
+      mask32 |= ((mask >> i) & 1) * (3U << (2 * i));
+    }
+    return mask32;
+  }
+  template <bool Le>
+  static size_t partition(vector v, vector pivot, value *left,
+                          value *right_end) {
+    const unsigned above = unsigned(
+        _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(v, pivot))));
+    const unsigned below =
+        Le ? ~above & 0xF
+           : unsigned(_mm256_movemask_pd(
+                 _mm256_castsi256_pd(_mm256_cmpgt_epi64(pivot, v))));
+    return split(v, widen(below), left, right_end - lanes) / 2;
+  }
+};
+
+const functions avx2 = {vectorized::sort<ops32>, vectorized::sort<ops64>};
+
+} // namespace
+
+const functions &avx2_functions() { return avx2; }
+
+} // namespace simdsort
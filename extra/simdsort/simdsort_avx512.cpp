@@ -0,0 +1,133 @@
+// The vector operations with AVX-512: 16 lanes of int32_t or 8 of int64_t.
+// The networks use masked min/max; the partition compresses each side to
+// the front of a register and writes the right side with a masked store.
+// Compiled with -mavx512f -mpopcnt.
+#include "simdsort_kernels.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+
+namespace simdsort {
+namespace {
+
+struct ops32 {
+  typedef int32_t value;
+  typedef __m512i vector;
+  static constexpr size_t lanes = 16;
+
+  static vector load(const value *p) { return _mm512_loadu_si512(p); }
+  static void store(value *p, vector v) { _mm512_storeu_si512(p, v); }
+  static vector broadcast(value v) { return _mm512_set1_epi32(v); }
+
+  static vector lane() {
+    return _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13,
+                             14, 15);
+  }
+  // lanes distant by d: the maximum goes to the lanes where bit d is set,
+  // the other way around where bit k is set (k = lanes: never)
+  static vector stage(vector v, int d, int k) {
+    const vector index = _mm512_xor_si512(lane(), _mm512_set1_epi32(d));
+    const __mmask16 upper =
+        _mm512_test_epi32_mask(lane(), _mm512_set1_epi32(d)) ^
+        _mm512_test_epi32_mask(lane(), _mm512_set1_epi32(k));
+    const vector p = _mm512_permutexvar_epi32(index, v);
+    return _mm512_mask_max_epi32(_mm512_min_epi32(v, p), upper, v, p);
+  }
+  static void sort(vector &v) {
+#pragma GCC unroll 4
+    for (int k = 2; k <= 16; k *= 2) {
+#pragma GCC unroll 4
+      for (int d = k / 2; d >= 1; d /= 2) {
+        v = stage(v, d, k);
+      }
+    }
+  }
+  static void merge(vector &low, vector &high) {
+    const vector r = _mm512_permutexvar_epi32(
+        _mm512_xor_si512(lane(), _mm512_set1_epi32(15)), high);
+    vector l = _mm512_min_epi32(low, r), h = _mm512_max_epi32(low, r);
+#pragma GCC unroll 4
+    for (int d = 8; d >= 1; d /= 2) {
+      l = stage(l, d, 16);
+      h = stage(h, d, 16);
+    }
+    low = l;
+    high = h;
+  }
+  template <bool Le>
+  static size_t partition(vector v, vector pivot, value *left,
+                          value *right_end) {
+    const __mmask16 below = Le ? _mm512_cmple_epi32_mask(v, pivot)
+                               : _mm512_cmplt_epi32_mask(v, pivot);
+    const size_t count = size_t(_mm_popcnt_u32(below));
+    _mm512_storeu_si512(left, _mm512_maskz_compress_epi32(below, v));
+    _mm512_mask_storeu_epi32(
+        right_end - (lanes - count), __mmask16((1U << (lanes - count)) - 1),
+        _mm512_maskz_compress_epi32(__mmask16(~below), v));
+    return count;
+  }
+};
+
+struct ops64 {
+  typedef int64_t value;
+  typedef __m512i vector;
+  static constexpr size_t lanes = 8;
+
+  static vector load(const value *p) { return _mm512_loadu_si512(p); }
+  static void store(value *p, vector v) { _mm512_storeu_si512(p, v); }
+  static vector broadcast(value v) { return _mm512_set1_epi64(v); }
+
+  static vector lane() { return _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7); }
+  static vector stage(vector v, int d, int k) {
+    const vector index = _mm512_xor_si512(lane(), _mm512_set1_epi64(d));
+    const __mmask8 upper =
+        _mm512_test_epi64_mask(lane(), _mm512_set1_epi64(d)) ^
+        _mm512_test_epi64_mask(lane(), _mm512_set1_epi64(k));
+    const vector p = _mm512_permutexvar_epi64(index, v);
+    return _mm512_mask_max_epi64(_mm512_min_epi64(v, p), upper, v, p);
+  }
+  static void sort(vector &v) {
+#pragma GCC unroll 3
+    for (int k = 2; k <= 8; k *= 2) {
+#pragma GCC unroll 3
+      for (int d = k / 2; d >= 1; d /= 2) {
+        v = stage(v, d, k);
+      }
+    }
+  }
+  static void merge(vector &low, vector &high) {
+    const vector r = _mm512_permutexvar_epi64(
+        _mm512_xor_si512(lane(), _mm512_set1_epi64(7)), high);
+    vector l = _mm512_min_epi64(low, r), h = _mm512_max_epi64(low, r);
+#pragma GCC unroll 3
+    for (int d = 4; d >= 1; d /= 2) {
+      l = stage(l, d, 8);
+      h = stage(h, d, 8);
+    }
+    low = l;
+    high = h;
+  }
+  template <bool Le>
+  static size_t partition(vector v, vector pivot, value *left,
+                          value *right_end) {
+    const __mmask8 below = Le ? _mm512_cmple_epi64_mask(v, pivot)
+                              : _mm512_cmplt_epi64_mask(v, pivot);
+    const size_t count = size_t(_mm_popcnt_u32(below));
+    _mm512_storeu_si512(left, _mm512_maskz_compress_epi64(below, v));
+    _mm512_mask_storeu_epi64(
+        right_end - (lanes - count), __mmask8((1U << (lanes - count)) - 1),
+        _mm512_maskz_compress_epi64(__mmask8(~below), v));
+    return count;
+  }
+};
+
+const functions avx512 = {vectorized::sort<ops32>, vectorized::sort<ops64>};
+
+} // namespace
+
+const functions &avx512_functions() { return avx512; }
+
+} // namespace simdsort
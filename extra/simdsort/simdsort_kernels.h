@@ -0,0 +1,214 @@
+// The quicksort, written once over a set of vector operations that each of
+// simdsort_avx2.cpp and simdsort_avx512.cpp provides for int32_t and
+// int64_t. Only the simdsort*.cpp files include this header.
+#ifndef SIMDSORT_KERNELS_H
+#define SIMDSORT_KERNELS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "simdsort.h"
+
+namespace simdsort {
+
+template <class T> using sort_function = void (*)(T *values, size_t n);
+
+// One back end: sorts int32_t and int64_t arrays.
+struct functions {
+  sort_function<int32_t> sort32;
+  sort_function<int64_t> sort64;
+};
+
+const functions &scalar_functions();
+const functions &avx2_functions();
+const functions &avx512_functions();
+
+// Ops provides, for vectors of Ops::lanes values of type Ops::value:
+//
+//   vector load(const value *);
+//   void store(value *, vector);
+//   vector broadcast(value);
+//   void sort(vector &);                    // in increasing order
+//   void merge(vector &low, vector &high);  // both sorted: low gets the
+//                                           // smallest half, high the rest
+//   template <bool Le>
+//   size_t partition(vector v, vector pivot, value *left, value *right_end);
+//     // the values of v below the pivot (at most the pivot if Le) go to
+//     // left[0..count), the others end at right_end; returns count. Each
+//     // side may be written over a full vector, but the values that belong
+//     // to the other side are written after those of the left side.
+// In an unnamed namespace, since simdsort_avx2.cpp and simdsort_avx512.cpp
+// instantiate the same templates (pivot_of<int32_t>...) with different
+// instruction sets.
+namespace {
+namespace vectorized {
+
+// A piece of 2 to 8 vectors is sorted by a sorting network (Batcher's
+// odd-even merge sort) where each comparator merges two sorted vectors.
+constexpr size_t small_vectors = 8;
+
+template <class Ops>
+inline void exchange(typename Ops::vector *v, int i, int j) {
+  Ops::merge(v[i], v[j]);
+}
+
+// n <= small_vectors * lanes: the values are padded with the largest value
+// up to a power of two of vectors.
+template <class Ops> void small_sort(typename Ops::value *a, size_t n) {
+  typedef typename Ops::value T;
+  typedef typename Ops::vector V;
+  constexpr size_t W = Ops::lanes;
+  if (n <= 1) {
+    return;
+  }
+  const size_t count = n <= W ? 1 : n <= 2 * W ? 2 : n <= 4 * W ? 4 : 8;
+  T buffer[small_vectors * W];
+  memcpy(buffer, a, n * sizeof(T));
+  std::fill(buffer + n, buffer + count * W, std::numeric_limits<T>::max());
+  V v[small_vectors];
+  for (size_t i = 0; i < count; i++) {
+    v[i] = Ops::load(buffer + i * W);
+    Ops::sort(v[i]);
+  }
+  switch (count) {
+  case 2:
+    exchange<Ops>(v, 0, 1);
+    break;
+  case 4:
+    exchange<Ops>(v, 0, 1), exchange<Ops>(v, 2, 3);
+    exchange<Ops>(v, 0, 2), exchange<Ops>(v, 1, 3);
+    exchange<Ops>(v, 1, 2);
+    break;
+  case 8:
+    exchange<Ops>(v, 0, 1), exchange<Ops>(v, 2, 3);
+    exchange<Ops>(v, 4, 5), exchange<Ops>(v, 6, 7);
+    exchange<Ops>(v, 0, 2), exchange<Ops>(v, 1, 3);
+    exchange<Ops>(v, 4, 6), exchange<Ops>(v, 5, 7);
+    exchange<Ops>(v, 1, 2), exchange<Ops>(v, 5, 6);
+    exchange<Ops>(v, 0, 4), exchange<Ops>(v, 1, 5);
+    exchange<Ops>(v, 2, 6), exchange<Ops>(v, 3, 7);
+    exchange<Ops>(v, 2, 4), exchange<Ops>(v, 3, 5);
+    exchange<Ops>(v, 1, 2), exchange<Ops>(v, 3, 4);
+    exchange<Ops>(v, 5, 6);
+    break;
+  }
+  for (size_t i = 0; i < count; i++) {
+    Ops::store(buffer + i * W, v[i]);
+  }
+  memcpy(a, buffer, n * sizeof(T));
+}
+
+// avx_pivot_on_last_value of sort.c, from both ends: the first and last
+// vectors are put aside, which leaves a vector of free space at each end.
+// We read the next vector from the end with the least free space and write
+// its two parts at the free ends. n >= 2 * lanes. Returns the number of
+// values below the pivot (at most the pivot if Le), now at the front.
+template <class Ops, bool Le>
+size_t partition(typename Ops::value *a, size_t n, typename Ops::value pivot) {
+  typedef typename Ops::value T;
+  typedef typename Ops::vector V;
+  constexpr size_t W = Ops::lanes;
+  const V p = Ops::broadcast(pivot);
+  const V first = Ops::load(a), last = Ops::load(a + n - W);
+  size_t left = W, right = n - W; // [left, right) is still to be read
+  size_t store_left = 0, store_right = n;
+  while (right - left >= W) {
+    V v;
+    if (left - store_left <= store_right - right) {
+      v = Ops::load(a + left);
+      left += W;
+    } else {
+      right -= W;
+      v = Ops::load(a + right);
+    }
+    const size_t count =
+        Ops::template partition<Le>(v, p, a + store_left, a + store_right);
+    store_left += count;
+    store_right -= W - count;
+  }
+  // [store_left, store_right) is free once the rest is put aside
+  T rest[W];
+  const size_t r = right - left;
+  memcpy(rest, a + left, r * sizeof(T));
+  for (size_t i = 0; i < r; i++) {
+    const T x = rest[i];
+    const bool below = Le ? x <= pivot : x < pivot;
+    a[store_left] = x;
+    a[store_right - 1] = x;
+    store_left += below;
+    store_right -= !below;
+  }
+  // 2 * lanes free values, then lanes: the two parts never overlap
+  size_t count = Ops::template partition<Le>(first, p, a + store_left,
+                                             a + store_right);
+  store_left += count;
+  store_right -= W - count;
+  count = Ops::template partition<Le>(last, p, a + store_left,
+                                      a + store_right);
+  return store_left + count;
+}
+
+template <class T> inline const T &median3(const T &x, const T &y, const T &z) {
+  return x < y ? (y < z ? y : (x < z ? z : x)) : (x < z ? x : (y < z ? z : y));
+}
+
+// median of the medians of three groups of three values spread over a
+template <class T> T pivot_of(const T *a, size_t n) {
+  const size_t s = n / 9;
+  return median3(median3(a[0], a[s], a[2 * s]),
+                 median3(a[3 * s], a[4 * s], a[5 * s]),
+                 median3(a[6 * s], a[7 * s], a[n - 1]));
+}
+
+// The pivot is a value of the array, so that the values below it never
+// fill the array. When none is below it, it is the smallest value: we
+// partition again to put aside the values equal to it, so that many equal
+// values cannot make the sort quadratic. Past a depth of 2 log2(n), the
+// rest is heap-sorted, as in introsort.
+template <class Ops>
+void quicksort(typename Ops::value *a, size_t n, int budget) {
+  typedef typename Ops::value T;
+  while (n > small_vectors * Ops::lanes) {
+    if (budget-- == 0) {
+      std::make_heap(a, a + n);
+      std::sort_heap(a, a + n);
+      return;
+    }
+    const T pivot = pivot_of(a, n);
+    size_t m = partition<Ops, false>(a, n, pivot);
+    if (m == 0) {
+      m = partition<Ops, true>(a, n, pivot);
+      a += m;
+      n -= m;
+      continue;
+    }
+    // the smaller side first, so that the stack stays logarithmic
+    if (m < n - m) {
+      quicksort<Ops>(a, m, budget);
+      a += m;
+      n -= m;
+    } else {
+      quicksort<Ops>(a + m, n - m, budget);
+      n = m;
+    }
+  }
+  small_sort<Ops>(a, n);
+}
+
+template <class Ops> void sort(typename Ops::value *a, size_t n) {
+  int depth = 0;
+  for (size_t m = n; m > 1; m >>= 1) {
+    depth++;
+  }
+  quicksort<Ops>(a, n, 2 * depth);
+}
+
+} // namespace vectorized
+} // namespace
+
+} // namespace simdsort
+
+#endif // SIMDSORT_KERNELS_H
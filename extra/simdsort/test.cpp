@@ -0,0 +1,188 @@
+// Checks of every back end and type against std::sort: all the lengths up
+// to 300 (the sorting networks and the first partitions), then longer
+// arrays of random, few distinct, sorted, reversed and equal values, with
+// one thread and with four (the sample sort); then argsort, and the order
+// of signed zeros, infinities and NaNs; then argsort of 64-bit keys that
+// differ in their low halves only.
+#include "simdsort.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+const simdsort::backend backends[] = {
+    simdsort::backend::automatic, simdsort::backend::scalar,
+    simdsort::backend::avx2, simdsort::backend::avx512};
+
+std::mt19937_64 gen(1234);
+
+template <class T> T random_value(uint64_t range) {
+  const uint64_t r = gen() % range;
+  return T(std::is_signed<T>::value ? int64_t(r) - int64_t(range / 2)
+                                    : int64_t(r)) +
+         T(std::is_floating_point<T>::value ? 0.25 : 0);
+}
+template <> uint32_t random_value<uint32_t>(uint64_t range) {
+  // around 2^31, where a signed compare would go wrong
+  return uint32_t(0x80000000ULL - range / 2 + gen() % range);
+}
+
+enum pattern { random_values, few_values, increasing, decreasing, equal };
+
+template <class T> std::vector<T> generate(size_t n, pattern p) {
+  std::vector<T> v(n);
+  for (auto &x : v) {
+    x = random_value<T>(p == few_values ? 7 : uint64_t(1) << 30);
+  }
+  if (p == increasing || p == decreasing) {
+    std::sort(v.begin(), v.end());
+  }
+  if (p == decreasing) {
+    std::reverse(v.begin(), v.end());
+  }
+  if (p == equal) {
+    std::fill(v.begin(), v.end(), random_value<T>(100));
+  }
+  return v;
+}
+
+template <class T>
+bool check(const std::vector<T> &input, const simdsort::options &o) {
+  std::vector<T> expected(input), out(input);
+  std::sort(expected.begin(), expected.end());
+  if (!simdsort::sort(out.data(), out.size(), o) || out != expected) {
+    printf("bug: sort, %s, %zu bytes, n = %zu, %u threads\n",
+           simdsort::backend_name(o.kernel), sizeof(T), input.size(),
+           o.threads);
+    return false;
+  }
+  std::vector<size_t> indexes(input.size());
+  bool ok = simdsort::argsort(input.data(), input.size(), indexes.data(), o);
+  std::vector<bool> seen(input.size(), false);
+  for (size_t i = 0; ok && i < indexes.size(); i++) {
+    ok = indexes[i] < input.size() && !seen[indexes[i]] &&
+         input[indexes[i]] == expected[i] &&
+         (i == 0 || input[indexes[i - 1]] != input[indexes[i]] ||
+          indexes[i - 1] < indexes[i]);
+    seen[indexes[i]] = true;
+  }
+  if (!ok) {
+    printf("bug: argsort, %s, %zu bytes, n = %zu, %u threads\n",
+           simdsort::backend_name(o.kernel), sizeof(T), input.size(),
+           o.threads);
+  }
+  return ok;
+}
+
+template <class T> bool check_type() {
+  for (simdsort::backend b : backends) {
+    if (!simdsort::backend_supported(b)) {
+      continue;
+    }
+    simdsort::options o;
+    o.kernel = b;
+    for (size_t n = 0; n <= 300; n++) {
+      if (!check(generate<T>(n, random_values), o) ||
+          !check(generate<T>(n, few_values), o)) {
+        return false;
+      }
+    }
+    const pattern patterns[] = {random_values, few_values, increasing,
+                                decreasing, equal};
+    for (pattern p : patterns) {
+      for (int trial = 0; trial < 10; trial++) {
+        if (!check(generate<T>(1 + gen() % 20000, p), o)) {
+          return false;
+        }
+      }
+      o.threads = 4;
+      if (!check(generate<T>(300000 + gen() % 1000, p), o)) {
+        return false;
+      }
+      o.threads = 1;
+    }
+  }
+  return true;
+}
+
+template <class T> bool same_bits(const std::vector<T> &x, const T *y) {
+  return memcmp(x.data(), y, x.size() * sizeof(T)) == 0;
+}
+
+// -NaN < -inf < -1 < -0 < +0 < 1 < inf < NaN, whatever the back end
+template <class T> bool total_order() {
+  const T inf = std::numeric_limits<T>::infinity();
+  const T nan = std::numeric_limits<T>::quiet_NaN();
+  const T expected[] = {-nan, -inf, T(-1), T(-0.0), T(0.0), T(1), inf, nan};
+  for (simdsort::backend b : backends) {
+    if (!simdsort::backend_supported(b)) {
+      continue;
+    }
+    simdsort::options o;
+    o.kernel = b;
+    std::vector<T> v;
+    for (int copies = 0; copies < 40; copies++) { // past the networks
+      v.insert(v.end(), std::begin(expected), std::end(expected));
+    }
+    std::shuffle(v.begin(), v.end(), gen);
+    simdsort::sort(v.data(), v.size(), o);
+    for (size_t i = 0; i < v.size(); i++) {
+      if (!same_bits(std::vector<T>(1, v[i]), &expected[i / 40])) {
+        printf("bug: order of %g, %s\n", double(v[i]),
+               simdsort::backend_name(b));
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// 64-bit keys from a few high halves and random low halves, with their top
+// bit set or not: argsort orders the low halves of each run of equal high
+// halves on their own.
+template <class T> bool low_halves() {
+  const uint64_t highs[] = {0x00000000, 0x3FF00000, 0xBFF00000, 0xC0000000};
+  for (simdsort::backend b : backends) {
+    if (!simdsort::backend_supported(b)) {
+      continue;
+    }
+    simdsort::options o;
+    o.kernel = b;
+    for (size_t n : {2, 50, 1000, 100000}) {
+      std::vector<T> v(n);
+      for (auto &x : v) {
+        const uint64_t bits =
+            highs[gen() % 4] << 32 | uint32_t(gen() % 8 << 29 | gen() % 3);
+        memcpy(&x, &bits, sizeof(bits));
+      }
+      if (!check(v, o)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main() {
+  printf("best back end: %s\n",
+         simdsort::backend_name(simdsort::active_backend()));
+  if (!check_type<int32_t>() || !check_type<uint32_t>() ||
+      !check_type<int64_t>() || !check_type<float>() ||
+      !check_type<double>() || !total_order<float>() ||
+      !total_order<double>() || !low_halves<int64_t>() ||
+      !low_halves<double>()) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,74 @@
+// Speed of each operation and kernel at both widths, in ns per input value,
+// on two arrays of n values (1 million by default) with random gaps, so
+// that about one value in three is in both.
+#include "sortedsets.h"
+
+#include "../harness/harness.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+template <class T>
+static std::vector<T> generate(size_t n, std::mt19937_64 &gen) {
+  std::vector<T> array(n);
+  T last = 0;
+  for (auto &v : array) {
+    last += T(1 + gen() % 4);
+    v = last;
+  }
+  return array;
+}
+
+template <class T>
+static bool run(size_t n, std::mt19937_64 &gen, harness::options &opts) {
+  const std::vector<T> a = generate<T>(n, gen), b = generate<T>(n, gen);
+  std::vector<T> out(a.size() + b.size());
+  const sortedsets_kernel kernels[] = {SORTEDSETS_SCALAR, SORTEDSETS_AVX2,
+                                       SORTEDSETS_AVX512};
+  const sortedsets_operation operations[] = {
+      SORTEDSETS_UNION, SORTEDSETS_DIFFERENCE, SORTEDSETS_XOR};
+  for (sortedsets_operation operation : operations) {
+    const size_t expected =
+        sortedsets::compute(operation, SORTEDSETS_SCALAR, a.data(), a.size(),
+                            b.data(), b.size(), out.data());
+    for (sortedsets_kernel kernel : kernels) {
+      if (!sortedsets_kernel_supported(kernel)) {
+        continue;
+      }
+      size_t size = 0;
+      auto r = harness::run(sortedsets_operation_name(operation),
+                            a.size() + b.size(), [&] {
+        size = sortedsets::compute(operation, kernel, a.data(), a.size(),
+                                   b.data(), b.size(), out.data());
+        harness::do_not_optimize(out.data());
+      }, opts);
+      if (size != expected) {
+        printf("bug!\n");
+        return false;
+      }
+      if (opts.format == HARNESS_TEXT) {
+        printf("%zu\t%-10s\t%-6s\t%.3f\n", sizeof(T) * 8,
+               sortedsets_operation_name(operation),
+               sortedsets_kernel_name(kernel), r.min() / (a.size() + b.size()));
+      } else {
+        r.report();
+      }
+    }
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  size_t n = argc > 1 ? size_t(atoll(argv[1])) : 1000000;
+  std::mt19937_64 gen(1234);
+  harness::options opts = harness::default_options();
+  printf("n = %zu, best kernel: %s\n", n,
+         sortedsets_kernel_name(sortedsets_best_kernel()));
+  printf("bits\toperation \tkernel\tns/value\n");
+  if (!run<uint32_t>(n, gen, opts) || !run<uint64_t>(n, gen, opts)) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,149 @@
+// Runtime dispatch and the scalar kernel.
+#include "sortedsets.h"
+#include "sortedsets_kernels.h"
+
+#include "../isa/dispatch.h"
+
+namespace sortedsets {
+
+const functions &scalar_functions() {
+  static const functions scalar = {
+      union_scalar<uint32_t>, difference_scalar<uint32_t>,
+      xor_scalar<uint32_t>,   union_scalar<uint64_t>,
+      difference_scalar<uint64_t>, xor_scalar<uint64_t>};
+  return scalar;
+}
+
+namespace {
+
+struct implementation {
+  sortedsets_kernel kind;
+  const char *name;
+  uint32_t required_instruction_sets;
+  const functions &(*table)();
+};
+
+const implementation scalar = {SORTEDSETS_SCALAR, "scalar", 0,
+                               scalar_functions};
+const implementation avx2 = {SORTEDSETS_AVX2, "avx2", instruction_set::AVX2,
+                             avx2_functions};
+const implementation avx512 = {SORTEDSETS_AVX512, "avx512",
+                               instruction_set::AVX512F, avx512_functions};
+
+const implementation *const implementations[] = {&avx512, &avx2, &scalar};
+
+const implementation *best() {
+  static const implementation *best =
+      isa::first_supported(implementations, &scalar);
+  return best;
+}
+
+// nullptr if unknown or unsupported
+const implementation *find(sortedsets_kernel kernel) {
+  if (kernel == SORTEDSETS_AUTO) {
+    return best();
+  }
+  return isa::find(implementations, kernel);
+}
+
+template <class T>
+size_t compute(sortedsets_operation operation, sortedsets_kernel kernel,
+               const T *a, size_t na, const T *b, size_t nb, T *out,
+               set_function<T> functions::*union_function,
+               set_function<T> functions::*difference_function,
+               set_function<T> functions::*xor_function) {
+  const implementation *impl = find(kernel);
+  if (impl == nullptr) {
+    return size_t(-1);
+  }
+  const functions &table = impl->table();
+  switch (operation) {
+  case SORTEDSETS_UNION:
+    return (table.*union_function)(a, na, b, nb, out);
+  case SORTEDSETS_DIFFERENCE:
+    return (table.*difference_function)(a, na, b, nb, out);
+  case SORTEDSETS_XOR:
+    return (table.*xor_function)(a, na, b, nb, out);
+  }
+  return size_t(-1);
+}
+
+} // namespace
+} // namespace sortedsets
+
+using namespace sortedsets;
+
+extern "C" {
+
+size_t sortedsets_compute32(sortedsets_operation operation,
+                            sortedsets_kernel kernel, const uint32_t *a,
+                            size_t na, const uint32_t *b, size_t nb,
+                            uint32_t *out) {
+  return compute(operation, kernel, a, na, b, nb, out, &functions::union32,
+                 &functions::difference32, &functions::xor32);
+}
+
+size_t sortedsets_compute64(sortedsets_operation operation,
+                            sortedsets_kernel kernel, const uint64_t *a,
+                            size_t na, const uint64_t *b, size_t nb,
+                            uint64_t *out) {
+  return compute(operation, kernel, a, na, b, nb, out, &functions::union64,
+                 &functions::difference64, &functions::xor64);
+}
+
+size_t sortedsets_union32(const uint32_t *a, size_t na, const uint32_t *b,
+                          size_t nb, uint32_t *out) {
+  return best()->table().union32(a, na, b, nb, out);
+}
+
+size_t sortedsets_difference32(const uint32_t *a, size_t na,
+                               const uint32_t *b, size_t nb, uint32_t *out) {
+  return best()->table().difference32(a, na, b, nb, out);
+}
+
+size_t sortedsets_xor32(const uint32_t *a, size_t na, const uint32_t *b,
+                        size_t nb, uint32_t *out) {
+  return best()->table().xor32(a, na, b, nb, out);
+}
+
+size_t sortedsets_union64(const uint64_t *a, size_t na, const uint64_t *b,
+                          size_t nb, uint64_t *out) {
+  return best()->table().union64(a, na, b, nb, out);
+}
+
+size_t sortedsets_difference64(const uint64_t *a, size_t na,
+                               const uint64_t *b, size_t nb, uint64_t *out) {
+  return best()->table().difference64(a, na, b, nb, out);
+}
+
+size_t sortedsets_xor64(const uint64_t *a, size_t na, const uint64_t *b,
+                        size_t nb, uint64_t *out) {
+  return best()->table().xor64(a, na, b, nb, out);
+}
+
+int sortedsets_kernel_supported(sortedsets_kernel kernel) {
+  return find(kernel) != nullptr;
+}
+
+sortedsets_kernel sortedsets_best_kernel(void) { return best()->kind; }
+
+const char *sortedsets_kernel_name(sortedsets_kernel kernel) {
+  if (kernel == SORTEDSETS_AUTO) {
+    return "auto";
+  }
+  return isa::name_of(implementations, kernel);
+}
+
+const char *sortedsets_operation_name(sortedsets_operation operation) {
+  switch (operation) {
+  case SORTEDSETS_UNION:
+    return "union";
+  case SORTEDSETS_DIFFERENCE:
+    return "difference";
+  case SORTEDSETS_XOR:
+    return "xor";
+  }
+  return "unknown";
+}
+
+} // extern "C"
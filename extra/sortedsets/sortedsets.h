@@ -0,0 +1,127 @@
+// Union, difference and symmetric difference (xor) of sorted arrays of
+// distinct 32-bit or 64-bit unsigned integers.
+//
+// extra/simd/union/simdunion16.c, extra/simd/xor/xor16.c and
+// extra/simd/difference/diff16.c do this with SSE for uint16_t only. Here
+// the same algorithms work on uint32_t and uint64_t, with AVX2 or AVX-512
+// picked at runtime:
+//
+//  - union and xor push blocks of both arrays through a merge network
+//    (a bitonic merge of two sorted vectors, in place of the rotations of
+//    sse_merge), and write each sorted vector while dropping the repeated
+//    values (store_unique, store_unique_xor);
+//  - difference compares a block of a with blocks of b, all pairs, and
+//    writes the values of the block that were found in none of them.
+//
+// AVX2 lacks unsigned 64-bit min/max, so its 64-bit union and xor are the
+// scalar ones. The short tails go through the scalar algorithms, which are
+// also a kernel of their own (union2by2_branchless of
+// 2021/07/14/union2by2.cpp).
+// Nothing is written past the values returned: the output needs room for
+// na + nb values (na for the difference).
+//
+// All functions are usable from C and from C++.
+#ifndef SORTEDSETS_H
+#define SORTEDSETS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum sortedsets_kernel {
+  SORTEDSETS_AUTO = 0, // best supported kernel
+  SORTEDSETS_SCALAR,
+  SORTEDSETS_AVX2,
+  SORTEDSETS_AVX512
+} sortedsets_kernel;
+
+typedef enum sortedsets_operation {
+  SORTEDSETS_UNION = 0,
+  SORTEDSETS_DIFFERENCE, // values of a that are not in b
+  SORTEDSETS_XOR         // values in exactly one of a and b
+} sortedsets_operation;
+
+// Writes the result of the operation into out and returns its size, or
+// (size_t)-1 if the kernel is not supported by this processor. For the
+// difference, out may be a; otherwise out must not overlap the inputs.
+size_t sortedsets_compute32(sortedsets_operation operation,
+                            sortedsets_kernel kernel, const uint32_t *a,
+                            size_t na, const uint32_t *b, size_t nb,
+                            uint32_t *out);
+size_t sortedsets_compute64(sortedsets_operation operation,
+                            sortedsets_kernel kernel, const uint64_t *a,
+                            size_t na, const uint64_t *b, size_t nb,
+                            uint64_t *out);
+
+// Same with the best kernel.
+size_t sortedsets_union32(const uint32_t *a, size_t na, const uint32_t *b,
+                          size_t nb, uint32_t *out);
+size_t sortedsets_difference32(const uint32_t *a, size_t na,
+                               const uint32_t *b, size_t nb, uint32_t *out);
+size_t sortedsets_xor32(const uint32_t *a, size_t na, const uint32_t *b,
+                        size_t nb, uint32_t *out);
+size_t sortedsets_union64(const uint64_t *a, size_t na, const uint64_t *b,
+                          size_t nb, uint64_t *out);
+size_t sortedsets_difference64(const uint64_t *a, size_t na,
+                               const uint64_t *b, size_t nb, uint64_t *out);
+size_t sortedsets_xor64(const uint64_t *a, size_t na, const uint64_t *b,
+                        size_t nb, uint64_t *out);
+
+int sortedsets_kernel_supported(sortedsets_kernel kernel);
+// kernel picked by SORTEDSETS_AUTO
+sortedsets_kernel sortedsets_best_kernel(void);
+const char *sortedsets_kernel_name(sortedsets_kernel kernel);
+const char *sortedsets_operation_name(sortedsets_operation operation);
+
+#ifdef __cplusplus
+} // extern "C"
+
+namespace sortedsets {
+
+// The same operations, overloaded on the width:
+//
+//   size_t n = sortedsets::set_union(a.data(), a.size(), b.data(), b.size(),
+//                                    out.data());
+inline size_t set_union(const uint32_t *a, size_t na, const uint32_t *b,
+                        size_t nb, uint32_t *out) {
+  return sortedsets_union32(a, na, b, nb, out);
+}
+inline size_t set_union(const uint64_t *a, size_t na, const uint64_t *b,
+                        size_t nb, uint64_t *out) {
+  return sortedsets_union64(a, na, b, nb, out);
+}
+inline size_t set_difference(const uint32_t *a, size_t na, const uint32_t *b,
+                             size_t nb, uint32_t *out) {
+  return sortedsets_difference32(a, na, b, nb, out);
+}
+inline size_t set_difference(const uint64_t *a, size_t na, const uint64_t *b,
+                             size_t nb, uint64_t *out) {
+  return sortedsets_difference64(a, na, b, nb, out);
+}
+inline size_t set_xor(const uint32_t *a, size_t na, const uint32_t *b,
+                      size_t nb, uint32_t *out) {
+  return sortedsets_xor32(a, na, b, nb, out);
+}
+inline size_t set_xor(const uint64_t *a, size_t na, const uint64_t *b,
+                      size_t nb, uint64_t *out) {
+  return sortedsets_xor64(a, na, b, nb, out);
+}
+inline size_t compute(sortedsets_operation operation, sortedsets_kernel kernel,
+                      const uint32_t *a, size_t na, const uint32_t *b,
+                      size_t nb, uint32_t *out) {
+  return sortedsets_compute32(operation, kernel, a, na, b, nb, out);
+}
+inline size_t compute(sortedsets_operation operation, sortedsets_kernel kernel,
+                      const uint64_t *a, size_t na, const uint64_t *b,
+                      size_t nb, uint64_t *out) {
+  return sortedsets_compute64(operation, kernel, a, na, b, nb, out);
+}
+
+} // namespace sortedsets
+
+#endif // __cplusplus
+
+#endif // SORTEDSETS_H
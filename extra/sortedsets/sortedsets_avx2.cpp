@@ -0,0 +1,98 @@
+// The vector operations with AVX2: 8 lanes of uint32_t or 4 of uint64_t
+// (for the difference only, see below). Compressed values are moved to the
+// front with a permutation table and written with a masked store. Compiled
+// with -mavx2 -mpopcnt.
+#include "sortedsets_kernels.h"
+
+#include "../isa/avx2.h"
+
+namespace sortedsets {
+namespace {
+
+inline __m256i load(const void *p) {
+  return _mm256_loadu_si256(static_cast<const __m256i *>(p));
+}
+
+// [previous, current] shifted by k values of 'bytes' bytes
+template <int bytes>
+inline __m256i shift_in(__m256i previous, __m256i current) {
+  return _mm256_alignr_epi8(
+      current, _mm256_permute2x128_si256(previous, current, 0x21), 16 - bytes);
+}
+
+struct ops32 {
+  typedef uint32_t value;
+  typedef __m256i vector;
+  static constexpr size_t lanes = 8;
+
+  static vector load(const value *p) { return sortedsets::load(p); }
+  static vector broadcast(value v) { return _mm256_set1_epi32(int(v)); }
+
+  static void merge(vector &low, vector &high) {
+    avx2::merge_epu32(low, high);
+  }
+  static vector shift1(vector previous, vector current) {
+    return shift_in<4>(previous, current);
+  }
+  static vector shift2(vector previous, vector current) {
+    return shift_in<8>(previous, current);
+  }
+  static unsigned equal(vector x, vector y) {
+    return unsigned(
+        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(x, y))));
+  }
+  static unsigned found(vector a, vector b) {
+    const vector rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    vector eq = _mm256_cmpeq_epi32(a, b);
+#pragma GCC unroll 7
+    for (int r = 1; r < 8; r++) {
+      b = _mm256_permutevar8x32_epi32(b, rotate);
+      eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(a, b));
+    }
+    return unsigned(_mm256_movemask_ps(_mm256_castsi256_ps(eq)));
+  }
+  static size_t compress(value *out, vector v, unsigned mask) {
+    return avx2::compress_epi32(out, v, mask);
+  }
+};
+
+struct ops64 {
+  typedef uint64_t value;
+  typedef __m256i vector;
+  static constexpr size_t lanes = 4;
+
+  static vector load(const value *p) { return sortedsets::load(p); }
+  static unsigned found(vector a, vector b) {
+    vector eq = _mm256_cmpeq_epi64(a, b);
+#pragma GCC unroll 3
+    for (int r = 1; r < 4; r++) {
+      b = _mm256_permute4x64_epi64(b, 0x39);
+      eq = _mm256_or_si256(eq, _mm256_cmpeq_epi64(a, b));
+    }
+    return unsigned(_mm256_movemask_pd(_mm256_castsi256_pd(eq)));
+  }
+  // each 64-bit lane is two 32-bit lanes
+  static size_t compress(value *out, vector v, unsigned mask) {
+    unsigned mask32 = 0;
+    for (int i = 0; i < 4; i++) {
+      mask32 |= ((mask >> i) & 1) * (3U << (2 * i));
+    }
+    return avx2::compress_epi32(out, v, mask32) / 2;
+  }
+};
+
+// AVX2 has no unsigned 64-bit min/max. With 4 lanes and min/max emulated by
+// a sign flip, a signed compare and a blend, the merge network is one long
+// chain of dependent instructions for every 4 values: it came out about
+// twice slower than the scalar union and xor (./benchmark), so we keep
+// those. The all-pairs compares of the difference still win.
+const functions avx2 = {
+    blocks::union_blocks<ops32>, blocks::difference_blocks<ops32>,
+    blocks::xor_blocks<ops32>,   union_scalar<uint64_t>,
+    blocks::difference_blocks<ops64>, xor_scalar<uint64_t>};
+
+} // namespace
+
+const functions &avx2_functions() { return avx2; }
+
+} // namespace sortedsets
@@ -0,0 +1,131 @@
+// The vector operations with AVX-512: 16 lanes of uint32_t or 8 of
+// uint64_t, with masked min/max for the merge network, valignd/valignq for
+// the shifts and compress-stores. Compiled with -mavx512f -mpopcnt.
+#include "sortedsets_kernels.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+
+namespace sortedsets {
+namespace {
+
+struct ops32 {
+  typedef uint32_t value;
+  typedef __m512i vector;
+  static constexpr size_t lanes = 16;
+
+  static vector load(const value *p) { return _mm512_loadu_si512(p); }
+  static vector broadcast(value v) { return _mm512_set1_epi32(int(v)); }
+
+  // lanes distant by d; the maximum goes to the lanes where bit d is set
+  static vector stage(vector v, vector index, __mmask16 upper) {
+    const vector p = _mm512_permutexvar_epi32(index, v);
+    return _mm512_mask_max_epu32(_mm512_min_epu32(v, p), upper, v, p);
+  }
+  static void merge(vector &low, vector &high) {
+    const vector lane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
+                                          11, 12, 13, 14, 15);
+    const vector r = _mm512_permutexvar_epi32(
+        _mm512_xor_si512(lane, _mm512_set1_epi32(15)), high);
+    vector l = _mm512_min_epu32(low, r), h = _mm512_max_epu32(low, r);
+#pragma GCC unroll 4
+    for (int d = 8; d >= 1; d >>= 1) {
+      const vector index = _mm512_xor_si512(lane, _mm512_set1_epi32(d));
+      const __mmask16 upper =
+          _mm512_test_epi32_mask(lane, _mm512_set1_epi32(d));
+      l = stage(l, index, upper);
+      h = stage(h, index, upper);
+    }
+    low = l;
+    high = h;
+  }
+  static vector shift1(vector previous, vector current) {
+    return _mm512_alignr_epi32(current, previous, 15);
+  }
+  static vector shift2(vector previous, vector current) {
+    return _mm512_alignr_epi32(current, previous, 14);
+  }
+  static unsigned equal(vector x, vector y) {
+    return _mm512_cmpeq_epi32_mask(x, y);
+  }
+  static unsigned found(vector a, vector b) {
+    __mmask16 mask = _mm512_cmpeq_epi32_mask(a, b);
+#pragma GCC unroll 15
+    for (int r = 1; r < 16; r++) {
+      b = _mm512_alignr_epi32(b, b, 1);
+      mask = __mmask16(mask | _mm512_cmpeq_epi32_mask(a, b));
+    }
+    return mask;
+  }
+  static size_t compress(value *out, vector v, unsigned mask) {
+    _mm512_mask_compressstoreu_epi32(out, __mmask16(mask), v);
+    return size_t(_mm_popcnt_u32(mask));
+  }
+};
+
+struct ops64 {
+  typedef uint64_t value;
+  typedef __m512i vector;
+  static constexpr size_t lanes = 8;
+
+  static vector load(const value *p) { return _mm512_loadu_si512(p); }
+  static vector broadcast(value v) {
+    return _mm512_set1_epi64(static_cast<long long>(v));
+  }
+
+  static vector stage(vector v, vector index, __mmask8 upper) {
+    const vector p = _mm512_permutexvar_epi64(index, v);
+    return _mm512_mask_max_epu64(_mm512_min_epu64(v, p), upper, v, p);
+  }
+  static void merge(vector &low, vector &high) {
+    const vector lane = _mm512_setr_epi64(0, 1, 2, 3, 4, 5, 6, 7);
+    const vector r = _mm512_permutexvar_epi64(
+        _mm512_xor_si512(lane, _mm512_set1_epi64(7)), high);
+    vector l = _mm512_min_epu64(low, r), h = _mm512_max_epu64(low, r);
+#pragma GCC unroll 3
+    for (int d = 4; d >= 1; d >>= 1) {
+      const vector index = _mm512_xor_si512(lane, _mm512_set1_epi64(d));
+      const __mmask8 upper = _mm512_test_epi64_mask(lane, _mm512_set1_epi64(d));
+      l = stage(l, index, upper);
+      h = stage(h, index, upper);
+    }
+    low = l;
+    high = h;
+  }
+  static vector shift1(vector previous, vector current) {
+    return _mm512_alignr_epi64(current, previous, 7);
+  }
+  static vector shift2(vector previous, vector current) {
+    return _mm512_alignr_epi64(current, previous, 6);
+  }
+  static unsigned equal(vector x, vector y) {
+    return _mm512_cmpeq_epi64_mask(x, y);
+  }
+  static unsigned found(vector a, vector b) {
+    __mmask8 mask = _mm512_cmpeq_epi64_mask(a, b);
+#pragma GCC unroll 7
+    for (int r = 1; r < 8; r++) {
+      b = _mm512_alignr_epi64(b, b, 1);
+      mask = __mmask8(mask | _mm512_cmpeq_epi64_mask(a, b));
+    }
+    return mask;
+  }
+  static size_t compress(value *out, vector v, unsigned mask) {
+    _mm512_mask_compressstoreu_epi64(out, __mmask8(mask), v);
+    return size_t(_mm_popcnt_u32(mask));
+  }
+};
+
+const functions avx512 = {
+    blocks::union_blocks<ops32>, blocks::difference_blocks<ops32>,
+    blocks::xor_blocks<ops32>,   blocks::union_blocks<ops64>,
+    blocks::difference_blocks<ops64>, blocks::xor_blocks<ops64>};
+
+} // namespace
+
+const functions &avx512_functions() { return avx512; }
+
+} // namespace sortedsets
@@ -0,0 +1,282 @@
+// The scalar algorithms and the vector ones, written once over a set of
+// vector operations that each of sortedsets_avx2.cpp and
+// sortedsets_avx512.cpp provides for uint32_t and uint64_t. Only the
+// sortedsets*.cpp files include this header.
+#ifndef SORTEDSETS_KERNELS_H
+#define SORTEDSETS_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "sortedsets.h"
+
+namespace sortedsets {
+
+template <class T>
+using set_function = size_t (*)(const T *, size_t, const T *, size_t, T *);
+
+// One kernel: the three operations at both widths.
+struct functions {
+  set_function<uint32_t> union32, difference32, xor32;
+  set_function<uint64_t> union64, difference64, xor64;
+};
+
+const functions &scalar_functions();
+const functions &avx2_functions();
+const functions &avx512_functions();
+
+// Everything below is compiled once by each of sortedsets.cpp,
+// sortedsets_avx2.cpp and sortedsets_avx512.cpp with their own flags: in
+// an unnamed namespace, every object keeps its own copy.
+namespace {
+
+// union2by2_branchless of 2021/07/14/union2by2.cpp
+template <class T>
+size_t union_scalar(const T *a, size_t na, const T *b, size_t nb, T *out) {
+  size_t i = 0, j = 0, pos = 0;
+  while ((i < na) & (j < nb)) {
+    const T v1 = a[i], v2 = b[j];
+    out[pos++] = v1 <= v2 ? v1 : v2;
+    i += v1 <= v2;
+    j += v1 >= v2;
+  }
+  if (na > i) { // a, b or out may be null when empty
+    memmove(out + pos, a + i, (na - i) * sizeof(T));
+    pos += na - i;
+  }
+  if (nb > j) {
+    memmove(out + pos, b + j, (nb - j) * sizeof(T));
+    pos += nb - j;
+  }
+  return pos;
+}
+
+// Same idea: the smaller value is always written, but only kept when the
+// two values differ.
+template <class T>
+size_t xor_scalar(const T *a, size_t na, const T *b, size_t nb, T *out) {
+  size_t i = 0, j = 0, pos = 0;
+  while ((i < na) & (j < nb)) {
+    const T v1 = a[i], v2 = b[j];
+    out[pos] = v1 < v2 ? v1 : v2;
+    pos += v1 != v2;
+    i += v1 <= v2;
+    j += v1 >= v2;
+  }
+  if (na > i) { // a, b or out may be null when empty
+    memmove(out + pos, a + i, (na - i) * sizeof(T));
+    pos += na - i;
+  }
+  if (nb > j) {
+    memmove(out + pos, b + j, (nb - j) * sizeof(T));
+    pos += nb - j;
+  }
+  return pos;
+}
+
+// Writes the values of a[i..] not in b[j..] at out + pos; out may be a.
+template <class T>
+size_t difference_scalar_from(const T *a, size_t na, size_t i, const T *b,
+                              size_t nb, size_t j, T *out, size_t pos) {
+  while ((i < na) & (j < nb)) {
+    const T v1 = a[i], v2 = b[j];
+    out[pos] = v1;
+    pos += v1 < v2;
+    i += v1 <= v2;
+    j += v1 >= v2;
+  }
+  if (na > i) {
+    memmove(out + pos, a + i, (na - i) * sizeof(T));
+    pos += na - i;
+  }
+  return pos;
+}
+
+template <class T>
+size_t difference_scalar(const T *a, size_t na, const T *b, size_t nb,
+                         T *out) {
+  return difference_scalar_from(a, na, 0, b, nb, 0, out, 0);
+}
+
+// The vector algorithms. Ops provides, for vectors of Ops::lanes values of
+// type Ops::value:
+//
+//   vector load(const value *);
+//   vector broadcast(value);
+//   void merge(vector &low, vector &high); // both sorted: low gets the
+//                                           // smallest half, high the rest
+//   vector shift1(vector previous, vector current); // previous[lanes - 1],
+//   vector shift2(vector previous, vector current); // previous[lanes - 2],
+//                                     // previous[lanes - 1], current[0]...
+//   unsigned equal(vector, vector);  // bit i: lanes i are equal
+//   unsigned found(vector a, vector b); // bit i: a[i] is somewhere in b
+//   size_t compress(value *out, vector, unsigned mask); // selected lanes,
+//                                       // in order; nothing written past
+namespace blocks {
+
+// store_unique of simdunion16.c: the values of current that differ from
+// the one before them.
+template <class Ops>
+inline size_t store_unique(typename Ops::vector previous,
+                           typename Ops::vector current,
+                           typename Ops::value *out) {
+  const unsigned repeated =
+      Ops::equal(Ops::shift1(previous, current), current);
+  return Ops::compress(out, current, ~repeated & ((1U << Ops::lanes) - 1));
+}
+
+// store_unique_xor of xor16.c: one value late, so that each value can be
+// compared with both neighbours; writes previous[lanes - 1] and
+// current[0..lanes - 2] when they differ from both.
+template <class Ops>
+inline size_t store_unique_xor(typename Ops::vector previous,
+                               typename Ops::vector current,
+                               typename Ops::value *out) {
+  const typename Ops::vector middle = Ops::shift1(previous, current);
+  const unsigned repeated = Ops::equal(Ops::shift2(previous, current), middle) |
+                            Ops::equal(middle, current);
+  return Ops::compress(out, middle, ~repeated & ((1U << Ops::lanes) - 1));
+}
+
+// sse_unite_opti of simdunion16.c. Once one array runs out of full blocks,
+// what is left of the network joins the tail of that array in a small
+// buffer, which is then merged with the rest of the other array.
+template <class Ops, bool Xor>
+size_t merge_blocks(const typename Ops::value *a, size_t na,
+                    const typename Ops::value *b, size_t nb,
+                    typename Ops::value *out) {
+  typedef typename Ops::value T;
+  typedef typename Ops::vector V;
+  constexpr size_t W = Ops::lanes;
+  if (na < W || nb < W) {
+    return Xor ? xor_scalar(a, na, b, nb, out)
+               : union_scalar(a, na, b, nb, out);
+  }
+  T *const start = out;
+  const size_t blocks1 = na / W, blocks2 = nb / W;
+  size_t pos1 = 1, pos2 = 1;
+  V low = Ops::load(a), high = Ops::load(b);
+  Ops::merge(low, high);
+  // low[0] cannot be the largest value of the type, W - 1 values are larger
+  V last = Ops::broadcast(T(-1));
+  out += Xor ? store_unique_xor<Ops>(last, low, out)
+             : store_unique<Ops>(last, low, out);
+  last = low;
+  if (pos1 < blocks1 && pos2 < blocks2) {
+    T head1 = a[W * pos1], head2 = b[W * pos2];
+    V next;
+    for (;;) {
+      if (head1 <= head2) {
+        next = Ops::load(a + W * pos1);
+        if (++pos1 == blocks1) {
+          break;
+        }
+        head1 = a[W * pos1];
+      } else {
+        next = Ops::load(b + W * pos2);
+        if (++pos2 == blocks2) {
+          break;
+        }
+        head2 = b[W * pos2];
+      }
+      low = next;
+      Ops::merge(low, high);
+      out += Xor ? store_unique_xor<Ops>(last, low, out)
+                 : store_unique<Ops>(last, low, out);
+      last = low;
+    }
+    low = next;
+    Ops::merge(low, high);
+    out += Xor ? store_unique_xor<Ops>(last, low, out)
+               : store_unique<Ops>(last, low, out);
+    last = low;
+  }
+  // the network holds W values (and one undecided value with xor); the
+  // array that ran out of blocks has fewer than W left
+  T buffer[2 * W + 1], merged[3 * W + 1];
+  size_t size;
+  if (Xor) {
+    size = store_unique_xor<Ops>(last, high, buffer);
+    T top[W];
+    Ops::compress(top, high, (1U << W) - 1);
+    if (top[W - 1] != top[W - 2]) {
+      buffer[size++] = top[W - 1];
+    }
+  } else {
+    size = store_unique<Ops>(last, high, buffer);
+  }
+  const T *tail = pos1 == blocks1 ? a + W * pos1 : b + W * pos2;
+  const size_t tail_size = pos1 == blocks1 ? na - W * pos1 : nb - W * pos2;
+  const T *rest = pos1 == blocks1 ? b + W * pos2 : a + W * pos1;
+  const size_t rest_size = pos1 == blocks1 ? nb - W * pos2 : na - W * pos1;
+  size = Xor ? xor_scalar(buffer, size, tail, tail_size, merged)
+             : union_scalar(buffer, size, tail, tail_size, merged);
+  out += Xor ? xor_scalar(merged, size, rest, rest_size, out)
+             : union_scalar(merged, size, rest, rest_size, out);
+  return size_t(out - start);
+}
+
+template <class Ops>
+size_t union_blocks(const typename Ops::value *a, size_t na,
+                    const typename Ops::value *b, size_t nb,
+                    typename Ops::value *out) {
+  return merge_blocks<Ops, false>(a, na, b, nb, out);
+}
+
+template <class Ops>
+size_t xor_blocks(const typename Ops::value *a, size_t na,
+                  const typename Ops::value *b, size_t nb,
+                  typename Ops::value *out) {
+  return merge_blocks<Ops, true>(a, na, b, nb, out);
+}
+
+// difference_vector16 of diff16.c, with all-pairs compares in place of
+// _mm_cmpistrm. A block of a is written once the current block of b ends
+// past it; the values found in any of the blocks of b it met are left out.
+template <class Ops>
+size_t difference_blocks(const typename Ops::value *a, size_t na,
+                         const typename Ops::value *b, size_t nb,
+                         typename Ops::value *out) {
+  typedef typename Ops::value T;
+  typedef typename Ops::vector V;
+  constexpr size_t W = Ops::lanes;
+  constexpr unsigned all = (1U << W) - 1;
+  size_t i = 0, j = 0, pos = 0;
+  // the first block of b the current block of a was compared with
+  size_t j_start = 0;
+  if (na >= W && nb >= W) {
+    V va = Ops::load(a);
+    unsigned found = 0;
+    for (;;) {
+      found |= Ops::found(va, Ops::load(b + j));
+      const T amax = a[i + W - 1], bmax = b[j + W - 1];
+      if (bmax <= amax) {
+        j += W;
+      }
+      if (amax <= bmax) {
+        pos += Ops::compress(out + pos, va, ~found & all);
+        i += W;
+        j_start = j;
+        found = 0;
+        if (i + W > na) {
+          break;
+        }
+        va = Ops::load(a + i);
+      }
+      if (j + W > nb) {
+        break;
+      }
+    }
+  }
+  // the current block of a, if any, starts over with the scalar code
+  return difference_scalar_from(a, na, i, b, nb, j_start, out, pos);
+}
+
+} // namespace blocks
+
+} // namespace
+
+} // namespace sortedsets
+
+#endif // SORTEDSETS_KERNELS_H
@@ -0,0 +1,156 @@
+// Lookup speed of the two layouts against the searches of
+// extra/understandingbinsearch.c and extra/search/searchproposal1.c
+// (binary_search, branchless_binary_search, linear256_16) and
+// std::lower_bound, in ns per query: uint16_t arrays up to 65536 values as
+// in those files, then uint32_t and uint64_t arrays far beyond the caches.
+#include "staticindex.h"
+
+#include "../harness/harness.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+// good old bin. search (extra/understandingbinsearch.c)
+int32_t binary_search(const uint16_t *array, int32_t lenarray,
+                      uint16_t ikey) {
+  int32_t low = 0;
+  int32_t high = lenarray - 1;
+  while (low <= high) {
+    int32_t middleIndex = (low + high) >> 1;
+    int32_t middleValue = array[middleIndex];
+    if (middleValue < ikey) {
+      low = middleIndex + 1;
+    } else if (middleValue > ikey) {
+      high = middleIndex - 1;
+    } else {
+      return middleIndex;
+    }
+  }
+  return -(low + 1);
+}
+
+int32_t linear256_16(const uint16_t *array, int32_t length, uint16_t ikey) {
+  int32_t k = 0;
+  for (; k + 255 < length; k += 256) {
+    if (array[k + 255] >= ikey) {
+      break;
+    }
+  }
+  for (; k + 15 < length; k += 16) {
+    if (array[k + 15] >= ikey) {
+      break;
+    }
+  }
+  for (; k < length; k++) {
+    uint16_t val = array[k];
+    if (val >= ikey) {
+      if (val == ikey)
+        return k;
+      else
+        return -k - 1;
+    }
+  }
+  return -length - 1;
+}
+
+template <class T>
+int64_t branchless_binary_search(const T *source, size_t n, T target) {
+  const T *base = source;
+  if (n == 0)
+    return -1;
+  if (target > source[n - 1])
+    return -int64_t(n) - 1; // without this we have a buffer overrun
+  while (n > 1) {
+    size_t half = n >> 1;
+    base = (base[half] < target) ? &base[half] : base;
+    n -= half;
+  }
+  base += *base < target;
+  return *base == target ? base - source : source - base - 1;
+}
+
+template <class T, class F>
+void bench(const char *name, size_t queries, const std::vector<T> &keys,
+           const harness::options &opts, F search) {
+  auto r = harness::run(name, queries, [&] {
+    int64_t sum = 0;
+    for (T key : keys) {
+      sum += search(key);
+    }
+    harness::do_not_optimize(sum);
+  }, opts);
+  if (opts.format == HARNESS_TEXT) {
+    printf("\t%.1f", r.min() / queries);
+  } else {
+    r.report();
+  }
+}
+
+template <class T>
+void bench_size(size_t n, size_t queries, bool small,
+                const harness::options &opts) {
+  std::mt19937_64 gen(n);
+  std::vector<T> data(n);
+  for (auto &x : data) {
+    x = T(gen());
+  }
+  std::sort(data.begin(), data.end());
+  std::vector<T> keys(queries);
+  for (auto &k : keys) {
+    k = T(gen());
+  }
+  staticindex::eytzinger<T> e(data.data(), n);
+  staticindex::bplus<T> b(data.data(), n);
+  for (T k : keys) {
+    const int64_t expected =
+        branchless_binary_search(data.data(), data.size(), k);
+    if (e.find(k) != expected || b.find(k) != expected) {
+      printf("bug!\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  printf("%zu", n);
+  bench("std::lower_bound", queries, keys, opts, [&](T k) {
+    return std::lower_bound(data.begin(), data.end(), k) - data.begin();
+  });
+  if (small) {
+    bench("binary_search", queries, keys, opts, [&](T k) {
+      return binary_search((const uint16_t *)data.data(), int32_t(n),
+                           uint16_t(k));
+    });
+    bench("linear256_16", queries, keys, opts, [&](T k) {
+      return linear256_16((const uint16_t *)data.data(), int32_t(n),
+                          uint16_t(k));
+    });
+  }
+  bench("branchless", queries, keys, opts, [&](T k) {
+    return branchless_binary_search(data.data(), data.size(), k);
+  });
+  bench("eytzinger", queries, keys, opts, [&](T k) { return e.find(k); });
+  bench("bplus", queries, keys, opts, [&](T k) { return b.find(k); });
+  printf("\n");
+}
+
+int main() {
+  const size_t queries = 1 << 16;
+  harness::options opts = harness::default_options();
+  printf("active back end: %s\n",
+         staticindex::backend_name(staticindex::active_backend()));
+  printf("uint16_t\nsize\tstd\tbinary\tlinear\tbranchless\teytzinger\tbplus "
+         "(ns/query)\n");
+  for (size_t n = 128; n <= 65536; n *= 4) {
+    bench_size<uint16_t>(n, queries, true, opts);
+  }
+  printf("uint32_t\nsize\tstd\tbranchless\teytzinger\tbplus (ns/query)\n");
+  for (size_t n = 1 << 12; n <= (1 << 26); n *= 16) {
+    bench_size<uint32_t>(n, queries, false, opts);
+  }
+  printf("uint64_t\nsize\tstd\tbranchless\teytzinger\tbplus (ns/query)\n");
+  for (size_t n = 1 << 12; n <= (1 << 24); n *= 16) {
+    bench_size<uint64_t>(n, queries, false, opts);
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,210 @@
+// Layout builders, the Eytzinger search, the scalar node search and the
+// runtime dispatch.
+#include "staticindex.h"
+#include "staticindex_kernels.h"
+
+#include "../isa/dispatch.h"
+
+#include <limits>
+#include <new>
+
+namespace staticindex {
+namespace {
+
+struct implementation {
+  backend kind;
+  const char *name;
+  uint32_t required_instruction_sets;
+};
+
+const implementation avx512 = {
+    backend::avx512, "avx512",
+    instruction_set::AVX512F | instruction_set::AVX512BW};
+const implementation avx2 = {backend::avx2, "avx2", instruction_set::AVX2};
+const implementation scalar = {backend::scalar, "scalar", 0};
+
+const implementation *const implementations[] = {&avx512, &avx2, &scalar};
+
+const implementation *active() {
+  static const implementation *best =
+      isa::first_supported(implementations, &scalar);
+  return best;
+}
+
+// nullptr if unsupported
+const implementation *find_backend(backend b) {
+  if (b == backend::automatic) {
+    return active();
+  }
+  return isa::find(implementations, b);
+}
+
+template <class T> struct scalar_node {
+  static size_t count_less(const T *node, T key) {
+    size_t count = 0;
+    for (size_t i = 0; i < bplus<T>::node_keys; i++) {
+      count += node[i] < key;
+    }
+    return count;
+  }
+};
+
+template <class T> search_function<T> search_for(backend b) {
+  switch (b) {
+  case backend::avx512:
+    return avx512_search<T>();
+  case backend::avx2:
+    return avx2_search<T>();
+  default:
+    return scalar_search<T>();
+  }
+}
+
+// In-order filling of the breadth-first tree: tree[k] has children
+// tree[2k] and tree[2k + 1].
+template <class T>
+void fill_eytzinger(T *tree, size_t slots, const T *sorted, size_t n,
+                    size_t &i, size_t k) {
+  if (k > slots) {
+    return;
+  }
+  fill_eytzinger(tree, slots, sorted, n, i, 2 * k);
+  tree[k] = i < n ? sorted[i] : std::numeric_limits<T>::max();
+  i++;
+  fill_eytzinger(tree, slots, sorted, n, i, 2 * k + 1);
+}
+
+} // namespace
+
+template <> search_function<uint16_t> scalar_search<uint16_t>() {
+  return bplus_lower_bound<scalar_node, uint16_t>;
+}
+template <> search_function<uint32_t> scalar_search<uint32_t>() {
+  return bplus_lower_bound<scalar_node, uint32_t>;
+}
+template <> search_function<uint64_t> scalar_search<uint64_t>() {
+  return bplus_lower_bound<scalar_node, uint64_t>;
+}
+
+bool backend_supported(backend b) { return find_backend(b) != nullptr; }
+
+backend active_backend() { return active()->kind; }
+
+const char *backend_name(backend b) {
+  if (b == backend::automatic) {
+    return active()->name;
+  }
+  return isa::name_of(implementations, b);
+}
+
+namespace internal {
+
+template <class T> aligned_array<T> allocate(size_t count) {
+  void *p = nullptr;
+  if (posix_memalign(&p, 64, (count == 0 ? 1 : count) * sizeof(T)) != 0) {
+    throw std::bad_alloc();
+  }
+  return aligned_array<T>(static_cast<T *>(p));
+}
+
+} // namespace internal
+
+template <class T>
+eytzinger<T>::eytzinger(const T *sorted, size_t n_) : n(n_) {
+  levels = 0;
+  while ((size_t(1) << levels) - 1 < n) {
+    levels++;
+  }
+  slots = (size_t(1) << levels) - 1;
+  tree = internal::allocate<T>(slots + 1);
+  tree[0] = 0;
+  size_t i = 0;
+  fill_eytzinger(tree.get(), slots, sorted, n, i, 1);
+}
+
+template <class T> size_t eytzinger<T>::lower_bound(T key) const {
+  // The descendants of k a few levels down, 64 / sizeof(T) of them, fill
+  // one cache line (tree[0] starts a line): we fetch it while we walk
+  // there.
+  constexpr size_t ahead = 64 / sizeof(T);
+  const T *t = tree.get();
+  size_t k = 1;
+  for (size_t l = 0; l < levels; l++) {
+    __builtin_prefetch(t + k * ahead);
+    k = 2 * k + (t[k] < key);
+  }
+  // In a perfect tree, the leaf we end at, counted from the left, is the
+  // number of values smaller than key. Past n, these are padding.
+  const size_t rank = k - (size_t(1) << levels);
+  return rank < n ? rank : n;
+}
+
+template <class T> int64_t eytzinger<T>::find(T key) const {
+  const size_t rank = lower_bound(key);
+  if (rank == n) {
+    return -int64_t(n) - 1;
+  }
+  // the in-order rank-th slot: climb from the leaf past the right turns
+  size_t k = (size_t(1) << levels) + rank;
+  k >>= __builtin_ctzll(~uint64_t(k)) + 1;
+  return tree[k] == key ? int64_t(rank) : -int64_t(rank) - 1;
+}
+
+template <class T>
+bplus<T>::bplus(const T *sorted, size_t n_, backend b) : n(n_) {
+  const implementation *impl = find_backend(b);
+  search = impl == nullptr ? nullptr : search_for<T>(impl->kind);
+  // layer sizes in nodes, leaves first
+  size_t nodes[24];
+  size_t layers = 0;
+  nodes[layers++] = n == 0 ? 1 : (n + node_keys - 1) / node_keys;
+  while (nodes[layers - 1] > 1) {
+    nodes[layers] = (nodes[layers - 1] + node_keys - 1) / node_keys;
+    layers++;
+  }
+  total = 0;
+  for (size_t l = 0; l < layers; l++) {
+    shape.offsets[l] = total;
+    total += nodes[layers - 1 - l] * node_keys;
+  }
+  tree = internal::allocate<T>(total);
+  T *leaves = tree.get() + shape.offsets[layers - 1];
+  const size_t leaf_slots = nodes[0] * node_keys;
+  for (size_t i = 0; i < leaf_slots; i++) {
+    leaves[i] = i < n ? sorted[i] : std::numeric_limits<T>::max();
+  }
+  // inner key i of node j: the largest (last) key of child j * keys + i
+  for (size_t l = layers - 1; l-- > 0;) {
+    T *layer = tree.get() + shape.offsets[l];
+    const T *below = tree.get() + shape.offsets[l + 1];
+    const size_t children = nodes[layers - 2 - l];
+    const size_t slots = nodes[layers - 1 - l] * node_keys;
+    for (size_t c = 0; c < slots; c++) {
+      layer[c] = c < children ? below[c * node_keys + node_keys - 1]
+                              : std::numeric_limits<T>::max();
+    }
+  }
+  shape.tree = tree.get();
+  shape.layers = layers;
+  shape.n = n;
+  shape.last = n == 0 ? 0 : sorted[n - 1];
+}
+
+template <class T> size_t bplus<T>::lower_bound(T key) const {
+  return search(shape, key);
+}
+
+template <class T> int64_t bplus<T>::find(T key) const {
+  const size_t rank = search(shape, key);
+  const T *leaves = tree.get() + shape.offsets[shape.layers - 1];
+  return rank < n && leaves[rank] == key ? int64_t(rank) : -int64_t(rank) - 1;
+}
+
+template class eytzinger<uint16_t>;
+template class eytzinger<uint32_t>;
+template class eytzinger<uint64_t>;
+template class bplus<uint16_t>;
+template class bplus<uint32_t>;
+template class bplus<uint64_t>;
+
+} // namespace staticindex
@@ -0,0 +1,117 @@
+// Static, read-only search indexes over sorted arrays of uint16_t, uint32_t
+// or uint64_t.
+//
+// extra/understandingbinsearch.c, extra/simd/binsearch/simdbinsearch16.c and
+// extra/search/searchproposal1.c search the sorted array itself. Here we
+// build the array once into a layout that suits the memory system better:
+//
+//  - eytzinger: the values in breadth-first order of the binary search tree
+//    (the root, then its two children, then the four grand-children...),
+//    so that the next probes of a search share a cache line and can be
+//    prefetched a few levels ahead. The tree is padded to a perfect one,
+//    which makes the search free of branches and gives the sorted position
+//    directly from the leaf we end at.
+//  - bplus: a static B+ tree whose nodes are cache lines (32, 16 or 8
+//    keys). The leaves are the sorted array; each inner key is the largest
+//    key of a child. A node is searched with one or two vector compares
+//    (AVX2 or AVX-512, picked at runtime, as in locateEqual), so that a
+//    lookup touches one cache line per level.
+//
+// Both answer lower_bound (the position in the sorted array of the first
+// value >= key, or n) and find, which follows the convention of the
+// searches above: the position of key if present, -(lower_bound + 1)
+// otherwise.
+//
+//   std::vector<uint32_t> sorted = ...;
+//   staticindex::bplus<uint32_t> index(sorted.data(), sorted.size());
+//   size_t p = index.lower_bound(key);
+#ifndef STATICINDEX_H
+#define STATICINDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+
+namespace staticindex {
+
+enum class backend {
+  automatic, // best supported one
+  scalar,
+  avx2,
+  avx512
+};
+
+// Whether the back end can run on this processor, and its name.
+bool backend_supported(backend b);
+backend active_backend();
+const char *backend_name(backend b);
+
+namespace internal {
+
+struct free_deleter {
+  void operator()(void *p) const { free(p); }
+};
+
+// cache-line aligned storage
+template <class T> using aligned_array = std::unique_ptr<T[], free_deleter>;
+
+template <class T> aligned_array<T> allocate(size_t count);
+
+} // namespace internal
+
+template <class T> class eytzinger {
+public:
+  // sorted holds n values in non-decreasing order; it is copied.
+  eytzinger(const T *sorted, size_t n);
+
+  size_t lower_bound(T key) const;
+  int64_t find(T key) const;
+
+  size_t size() const { return n; }
+  // bytes used by the layout
+  size_t memory() const { return (slots + 1) * sizeof(T); }
+
+private:
+  internal::aligned_array<T> tree; // 1-based: tree[1] is the root
+  size_t n;
+  size_t slots;   // 2^levels - 1, the size of the perfect tree
+  size_t levels;
+};
+
+template <class T> class bplus {
+public:
+  // Values per node: one cache line.
+  static constexpr size_t node_keys = 64 / sizeof(T);
+
+  bplus(const T *sorted, size_t n, backend b = backend::automatic);
+
+  size_t lower_bound(T key) const;
+  int64_t find(T key) const;
+
+  size_t size() const { return n; }
+  size_t memory() const { return total * sizeof(T); }
+  // false if the requested back end is not supported
+  bool valid() const { return search != nullptr; }
+
+  // Root first; layer l starts at offsets[l] (in values). The leaves are
+  // the last layer.
+  struct layout {
+    const T *tree;
+    size_t layers;
+    size_t offsets[24];
+    size_t n;
+    T last; // largest value, or 0 when n == 0
+  };
+
+private:
+  internal::aligned_array<T> tree;
+  size_t n;
+  size_t total;
+  layout shape;
+  size_t (*search)(const layout &, T);
+};
+
+} // namespace staticindex
+
+#endif // STATICINDEX_H
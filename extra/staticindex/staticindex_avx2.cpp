@@ -0,0 +1,72 @@
+// AVX2 node search: a 64-byte node is two registers. AVX2 only compares
+// signed integers, so as in locateEqual we test key <= value with an
+// unsigned max (16 and 32 bits), or flip the sign bits (64 bits).
+#include "staticindex_kernels.h"
+
+#include <immintrin.h>
+
+namespace staticindex {
+namespace {
+
+template <class T> struct avx2_node;
+
+template <> struct avx2_node<uint16_t> {
+  static size_t count_less(const uint16_t *node, uint16_t key) {
+    const __m256i vkey = _mm256_set1_epi16(short(key));
+    const __m256i a = _mm256_load_si256((const __m256i *)node);
+    const __m256i b = _mm256_load_si256((const __m256i *)node + 1);
+    // value >= key
+    const __m256i ga = _mm256_cmpeq_epi16(_mm256_max_epu16(a, vkey), a);
+    const __m256i gb = _mm256_cmpeq_epi16(_mm256_max_epu16(b, vkey), b);
+    const uint64_t ge = uint32_t(_mm256_movemask_epi8(ga)) |
+                        (uint64_t(uint32_t(_mm256_movemask_epi8(gb))) << 32);
+    return 32 - size_t(_mm_popcnt_u64(ge)) / 2;
+  }
+};
+
+template <> struct avx2_node<uint32_t> {
+  static size_t count_less(const uint32_t *node, uint32_t key) {
+    const __m256i vkey = _mm256_set1_epi32(int(key));
+    const __m256i a = _mm256_load_si256((const __m256i *)node);
+    const __m256i b = _mm256_load_si256((const __m256i *)node + 1);
+    const __m256i ga = _mm256_cmpeq_epi32(_mm256_max_epu32(a, vkey), a);
+    const __m256i gb = _mm256_cmpeq_epi32(_mm256_max_epu32(b, vkey), b);
+    const uint32_t ge =
+        uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(ga))) |
+        (uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(gb))) << 8);
+    return 16 - size_t(_mm_popcnt_u32(ge));
+  }
+};
+
+template <> struct avx2_node<uint64_t> {
+  static size_t count_less(const uint64_t *node, uint64_t key) {
+    const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+    const __m256i vkey = _mm256_xor_si256(
+        _mm256_set1_epi64x(int64_t(key)), sign);
+    const __m256i a =
+        _mm256_xor_si256(_mm256_load_si256((const __m256i *)node), sign);
+    const __m256i b =
+        _mm256_xor_si256(_mm256_load_si256((const __m256i *)node + 1), sign);
+    // key > value
+    const __m256i la = _mm256_cmpgt_epi64(vkey, a);
+    const __m256i lb = _mm256_cmpgt_epi64(vkey, b);
+    const uint32_t lt =
+        uint32_t(_mm256_movemask_pd(_mm256_castsi256_pd(la))) |
+        (uint32_t(_mm256_movemask_pd(_mm256_castsi256_pd(lb))) << 4);
+    return size_t(_mm_popcnt_u32(lt));
+  }
+};
+
+} // namespace
+
+template <> search_function<uint16_t> avx2_search<uint16_t>() {
+  return bplus_lower_bound<avx2_node, uint16_t>;
+}
+template <> search_function<uint32_t> avx2_search<uint32_t>() {
+  return bplus_lower_bound<avx2_node, uint32_t>;
+}
+template <> search_function<uint64_t> avx2_search<uint64_t>() {
+  return bplus_lower_bound<avx2_node, uint64_t>;
+}
+
+} // namespace staticindex
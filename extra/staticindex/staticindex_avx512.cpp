@@ -0,0 +1,48 @@
+// AVX-512 node search: a 64-byte node is one register, and AVX-512 has
+// unsigned compares into a mask (16-bit lanes need AVX-512BW).
+#include "staticindex_kernels.h"
+
+#include <immintrin.h>
+
+namespace staticindex {
+namespace {
+
+template <class T> struct avx512_node;
+
+template <> struct avx512_node<uint16_t> {
+  static size_t count_less(const uint16_t *node, uint16_t key) {
+    const __mmask32 lt = _mm512_cmplt_epu16_mask(
+        _mm512_load_si512(node), _mm512_set1_epi16(short(key)));
+    return size_t(_mm_popcnt_u32(lt));
+  }
+};
+
+template <> struct avx512_node<uint32_t> {
+  static size_t count_less(const uint32_t *node, uint32_t key) {
+    const __mmask16 lt = _mm512_cmplt_epu32_mask(
+        _mm512_load_si512(node), _mm512_set1_epi32(int(key)));
+    return size_t(_mm_popcnt_u32(lt));
+  }
+};
+
+template <> struct avx512_node<uint64_t> {
+  static size_t count_less(const uint64_t *node, uint64_t key) {
+    const __mmask8 lt = _mm512_cmplt_epu64_mask(
+        _mm512_load_si512(node), _mm512_set1_epi64(int64_t(key)));
+    return size_t(_mm_popcnt_u32(lt));
+  }
+};
+
+} // namespace
+
+template <> search_function<uint16_t> avx512_search<uint16_t>() {
+  return bplus_lower_bound<avx512_node, uint16_t>;
+}
+template <> search_function<uint32_t> avx512_search<uint32_t>() {
+  return bplus_lower_bound<avx512_node, uint32_t>;
+}
+template <> search_function<uint64_t> avx512_search<uint64_t>() {
+  return bplus_lower_bound<avx512_node, uint64_t>;
+}
+
+} // namespace staticindex
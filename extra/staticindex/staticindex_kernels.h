@@ -0,0 +1,55 @@
+// The B+ tree search, shared by all back ends. Only the staticindex*.cpp
+// files include this header: each one provides its own node search and is
+// compiled with its own -m flags.
+//
+// A node search N<T> provides
+//
+//   static size_t count_less(const T *node, T key);
+//
+// the number of the bplus<T>::node_keys values of the (cache-line aligned)
+// node that are smaller than key. The values of a node are sorted, so this
+// is also the position of the first one that is not.
+#ifndef STATICINDEX_KERNELS_H
+#define STATICINDEX_KERNELS_H
+
+#include "staticindex.h"
+
+namespace staticindex {
+
+template <class T>
+using search_function = size_t (*)(const typename bplus<T>::layout &, T);
+
+template <template <class> class N, class T>
+size_t bplus_lower_bound(const typename bplus<T>::layout &shape, T key) {
+  // past the largest value, the descent would leave the tree
+  if (shape.n == 0 || key > shape.last) {
+    return shape.n;
+  }
+  constexpr size_t keys = bplus<T>::node_keys;
+  size_t node = 0;
+  for (size_t l = 0; l < shape.layers; l++) {
+    const T *p = shape.tree + shape.offsets[l] + node * keys;
+    node = node * keys + N<T>::count_less(p, key);
+  }
+  return node;
+}
+
+// One per back end, each defined for uint16_t, uint32_t and uint64_t in
+// its own file.
+template <class T> search_function<T> scalar_search();
+template <class T> search_function<T> avx2_search();
+template <class T> search_function<T> avx512_search();
+
+template <> search_function<uint16_t> scalar_search<uint16_t>();
+template <> search_function<uint32_t> scalar_search<uint32_t>();
+template <> search_function<uint64_t> scalar_search<uint64_t>();
+template <> search_function<uint16_t> avx2_search<uint16_t>();
+template <> search_function<uint32_t> avx2_search<uint32_t>();
+template <> search_function<uint64_t> avx2_search<uint64_t>();
+template <> search_function<uint16_t> avx512_search<uint16_t>();
+template <> search_function<uint32_t> avx512_search<uint32_t>();
+template <> search_function<uint64_t> avx512_search<uint64_t>();
+
+} // namespace staticindex
+
+#endif // STATICINDEX_KERNELS_H
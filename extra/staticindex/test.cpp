@@ -0,0 +1,92 @@
+// Compares both layouts, with every back end, to std::lower_bound, on
+// arrays with duplicates, the extreme values, and sizes around the node and
+// tree boundaries.
+#include "staticindex.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <vector>
+
+template <class T> int64_t expected_find(const std::vector<T> &v, T key) {
+  size_t p = size_t(std::lower_bound(v.begin(), v.end(), key) - v.begin());
+  return p < v.size() && v[p] == key ? int64_t(p) : -int64_t(p) - 1;
+}
+
+// random values in [0, range]
+template <class T> T draw(std::mt19937_64 &gen, T range) {
+  const uint64_t r = gen();
+  return range == std::numeric_limits<uint64_t>::max()
+             ? T(r)
+             : T(r % (uint64_t(range) + 1));
+}
+
+template <class T> bool check(size_t n, T range) {
+  std::mt19937_64 gen(n);
+  std::vector<T> data(n);
+  for (auto &x : data) {
+    x = draw(gen, range);
+  }
+  if (n > 2) {
+    data[0] = 0;
+    data[1] = std::numeric_limits<T>::max();
+  }
+  std::sort(data.begin(), data.end());
+  std::vector<T> keys = {0, 1, std::numeric_limits<T>::max(),
+                         T(std::numeric_limits<T>::max() - 1)};
+  for (size_t i = 0; i < 300; i++) {
+    keys.push_back(T(draw(gen, range) + 1));
+  }
+  for (T x : data) {
+    keys.push_back(x);
+  }
+  staticindex::eytzinger<T> e(data.data(), n);
+  const staticindex::backend backends[] = {staticindex::backend::scalar,
+                                           staticindex::backend::avx2,
+                                           staticindex::backend::avx512};
+  for (T key : keys) {
+    const int64_t f = expected_find(data, key);
+    const size_t lb = f < 0 ? size_t(-f - 1) : size_t(f);
+    if (e.lower_bound(key) != lb || e.find(key) != f) {
+      printf("eytzinger: mismatch n = %zu key = %llu\n", n,
+             (unsigned long long)key);
+      return false;
+    }
+  }
+  for (auto b : backends) {
+    if (!staticindex::backend_supported(b)) {
+      continue;
+    }
+    staticindex::bplus<T> t(data.data(), n, b);
+    for (T key : keys) {
+      const int64_t f = expected_find(data, key);
+      const size_t lb = f < 0 ? size_t(-f - 1) : size_t(f);
+      if (t.lower_bound(key) != lb || t.find(key) != f) {
+        printf("bplus (%s): mismatch n = %zu key = %llu\n",
+               staticindex::backend_name(b), n, (unsigned long long)key);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int main() {
+  const size_t sizes[] = {0,  1,   2,   3,   7,   8,    9,    15,   16,
+                          17, 31,  32,  33,  63,  64,   65,   255,  256,
+                          257, 511, 1000, 1023, 1024, 1025, 4096, 33000};
+  printf("active back end: %s\n",
+         staticindex::backend_name(staticindex::active_backend()));
+  for (size_t n : sizes) {
+    if (!check<uint16_t>(n, 65535) || !check<uint16_t>(n, 100) ||
+        !check<uint32_t>(n, 4294967295U) || !check<uint32_t>(n, 1000) ||
+        !check<uint64_t>(n, std::numeric_limits<uint64_t>::max()) ||
+        !check<uint64_t>(n, 1000)) {
+      return EXIT_FAILURE;
+    }
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
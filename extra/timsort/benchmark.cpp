@@ -0,0 +1,134 @@
+// Speed of the sorts of n 64-bit timestamps (4 million by default), in ns
+// per value: random, then an append-mostly log (sorted, but one value in a
+// hundred arrives up to a thousand positions late), then 64 sorted log
+// segments to merge. std::sort, std::stable_sort and the timsort of
+// 2016/09/28 against this one, with one thread and with one per hardware
+// thread. Then pointers to 64-byte rows, as in 2016/10/05/pointersort.cpp:
+// comparisons through the pointers against sort_by.
+#include "timsort.h"
+
+#include "../harness/harness.h"
+#include "../../2016/09/28/timsort.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <thread>
+#include <vector>
+
+template <class T, class F>
+static void time(const char *data, const char *name,
+                 const std::vector<T> &input, std::vector<T> &out, F f,
+                 harness::options &opts) {
+  harness::print_row(data, 10, 18,
+                     harness::run_on_copy(name, input, out, f, opts));
+}
+
+static bool run(const char *data, const std::vector<uint64_t> &input,
+                const std::vector<size_t> &segments, harness::options &opts) {
+  std::vector<uint64_t> expected(input), out(input.size());
+  std::sort(expected.begin(), expected.end());
+  time(data, "std::sort", input, out,
+       [&] { std::sort(out.begin(), out.end()); }, opts);
+  time(data, "std::stable_sort", input, out,
+       [&] { std::stable_sort(out.begin(), out.end()); }, opts);
+  time(data, "gfx::timsort", input, out,
+       [&] { gfx::timsort(out.begin(), out.end()); }, opts);
+  bool ok = out == expected;
+  timsort::options o;
+  time(data, "timsort", input, out,
+       [&] { timsort::sort(out.begin(), out.end(), o); }, opts);
+  ok = ok && out == expected;
+  if (!segments.empty()) {
+    time(data, "merge_runs", input, out, [&] {
+      timsort::merge_runs(out.begin(), out.end(), segments.data(),
+                          segments.size(), o);
+    }, opts);
+    ok = ok && out == expected;
+  }
+  o.threads = 0;
+  time(data, "timsort parallel", input, out,
+       [&] { timsort::sort(out.begin(), out.end(), o); }, opts);
+  ok = ok && out == expected;
+  if (!ok) {
+    printf("bug!\n");
+  }
+  return ok;
+}
+
+struct row {
+  uint64_t time;
+  char payload[56];
+};
+
+static bool run_pointers(const std::vector<uint64_t> &times,
+                         harness::options &opts) {
+  std::vector<row> table(times.size());
+  std::vector<row *> input;
+  for (size_t i = 0; i < times.size(); i++) {
+    table[i].time = times[i];
+    input.push_back(&table[i]);
+  }
+  // shuffle the rows, so that the pointers do not follow the addresses
+  std::shuffle(input.begin(), input.end(), std::mt19937_64(1));
+  std::vector<row *> expected(input), out(input.size());
+  auto earlier = [](const row *x, const row *y) { return x->time < y->time; };
+  auto time_of = [](const row *r) { return r->time; };
+  std::stable_sort(expected.begin(), expected.end(), earlier);
+  time("row *", "std::sort", input, out,
+       [&] { std::sort(out.begin(), out.end(), earlier); }, opts);
+  time("row *", "gfx::timsort", input, out,
+       [&] { gfx::timsort(out.begin(), out.end(), earlier); }, opts);
+  time("row *", "timsort", input, out,
+       [&] { timsort::sort(out.begin(), out.end(), earlier); }, opts);
+  bool ok = out == expected;
+  time("row *", "sort_by", input, out,
+       [&] { timsort::sort_by(out.begin(), out.end(), time_of); }, opts);
+  ok = ok && out == expected;
+  if (!ok) {
+    printf("bug!\n");
+  }
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  const size_t n = argc > 1 ? size_t(atoll(argv[1])) : 4000000;
+  std::mt19937_64 gen(1234);
+  harness::options opts = harness::default_options();
+  opts.repeat = 5;
+  printf("n = %zu, %u hardware threads\n", n,
+         std::thread::hardware_concurrency());
+  printf("data      \tsort              \tns/value\n");
+  std::vector<uint64_t> random(n), log(n), segmented(n);
+  for (auto &v : random) {
+    v = gen();
+  }
+  for (size_t i = 0; i < n; i++) {
+    log[i] = uint64_t(i) * 1000 + gen() % 1000;
+  }
+  for (size_t i = 0; i < n / 100; i++) {
+    const size_t j = gen() % n;
+    const size_t k = j >= 1000 ? j - gen() % 1000 : 0;
+    std::swap(log[j], log[k]);
+  }
+  const size_t runs = 64;
+  std::vector<size_t> segments(runs);
+  for (size_t r = 0; r < runs; r++) {
+    segments[r] = (r + 1) * n / runs - r * n / runs;
+  }
+  for (size_t i = 0; i < n; i++) {
+    segmented[i] = gen() % (n * 1000);
+  }
+  size_t start = 0;
+  for (size_t length : segments) {
+    std::sort(segmented.begin() + start, segmented.begin() + start + length);
+    start += length;
+  }
+  if (!run("random", random, {}, opts) || !run("log", log, {}, opts) ||
+      !run("segments", segmented, segments, opts) ||
+      !run_pointers(random, opts)) {
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
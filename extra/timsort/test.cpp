@@ -0,0 +1,243 @@
+// Checks against std::stable_sort of records whose sequence numbers reveal
+// any broken tie: all the lengths up to 300, then longer arrays of random,
+// few distinct, sorted, reversed, nearly sorted and sawtooth values, with
+// one thread and with four; then sort_by on pointers and move-only values,
+// merge_runs of presorted runs; and strings, with four threads.
+#include "timsort.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+std::mt19937_64 gen(1234);
+
+// no default constructor: the threaded merges cannot use a buffer
+struct record {
+  record(uint32_t k, uint32_t s) : key(k), seq(s) {}
+  uint32_t key;
+  uint32_t seq;
+  bool operator==(const record &o) const {
+    return key == o.key && seq == o.seq;
+  }
+};
+
+struct by_key {
+  bool operator()(const record &x, const record &y) const {
+    return x.key < y.key;
+  }
+};
+
+enum pattern {
+  random_values,
+  few_values,
+  increasing,
+  decreasing,
+  nearly_sorted,
+  sawtooth
+};
+
+std::vector<uint32_t> generate(size_t n, pattern p) {
+  std::vector<uint32_t> v(n);
+  for (auto &x : v) {
+    x = uint32_t(gen() % (p == few_values ? 7 : 1000000000));
+  }
+  if (p == increasing || p == nearly_sorted) {
+    std::sort(v.begin(), v.end());
+  }
+  if (p == decreasing) {
+    std::sort(v.begin(), v.end(), [](uint32_t x, uint32_t y) { return x > y; });
+  }
+  if (p == nearly_sorted && n > 0) {
+    for (size_t i = 0; i < n / 100 + 1; i++) { // late arrivals
+      std::swap(v[gen() % n], v[gen() % n]);
+    }
+  }
+  if (p == sawtooth) {
+    for (size_t i = 0; i < n; i++) {
+      v[i] = uint32_t(i % 1000 + gen() % 3);
+    }
+  }
+  return v;
+}
+
+std::vector<record> records(const std::vector<uint32_t> &keys) {
+  std::vector<record> v;
+  for (size_t i = 0; i < keys.size(); i++) {
+    v.emplace_back(keys[i], uint32_t(i));
+  }
+  return v;
+}
+
+bool check(const std::vector<uint32_t> &keys, const timsort::options &o) {
+  std::vector<record> expected = records(keys), out = expected;
+  std::stable_sort(expected.begin(), expected.end(), by_key());
+  timsort::sort(out.begin(), out.end(), by_key(), o);
+  bool ok = out == expected;
+  std::vector<uint32_t> values(keys), sorted(keys);
+  std::sort(sorted.begin(), sorted.end());
+  timsort::sort(values.begin(), values.end(), o);
+  ok = ok && values == sorted;
+  if (!ok) {
+    printf("bug: sort, n = %zu, %u threads\n", keys.size(), o.threads);
+  }
+  return ok;
+}
+
+bool check_sort() {
+  timsort::options o;
+  for (size_t n = 0; n <= 300; n++) {
+    if (!check(generate(n, random_values), o) ||
+        !check(generate(n, few_values), o)) {
+      return false;
+    }
+  }
+  const pattern patterns[] = {random_values, few_values,    increasing,
+                              decreasing,    nearly_sorted, sawtooth};
+  for (pattern p : patterns) {
+    for (int trial = 0; trial < 10; trial++) {
+      if (!check(generate(1 + gen() % 20000, p), o)) {
+        return false;
+      }
+    }
+    o.threads = 4;
+    if (!check(generate(300000 + gen() % 1000, p), o)) {
+      return false;
+    }
+    o.threads = 1;
+  }
+  return true;
+}
+
+struct row {
+  uint64_t time;
+  uint32_t seq;
+  char payload[52];
+};
+
+bool check_sort_by() {
+  for (unsigned threads : {1u, 4u}) {
+    timsort::options o;
+    o.threads = threads;
+    const std::vector<uint32_t> keys = generate(300000, nearly_sorted);
+    std::vector<row> table(keys.size());
+    std::vector<row *> pointers;
+    std::vector<std::unique_ptr<row>> owned;
+    for (size_t i = 0; i < keys.size(); i++) {
+      table[i].time = keys[i] / 16;
+      table[i].seq = uint32_t(i);
+      pointers.push_back(&table[i]);
+      owned.emplace_back(new row(table[i]));
+    }
+    auto time = [](const row *r) { return r->time; };
+    auto earlier = [](const row *x, const row *y) { return x->time < y->time; };
+    std::vector<row *> expected(pointers);
+    std::stable_sort(expected.begin(), expected.end(), earlier);
+    timsort::sort_by(pointers.begin(), pointers.end(), time, o);
+    bool ok = pointers == expected;
+    timsort::sort_by(owned.begin(), owned.end(),
+                     [](const std::unique_ptr<row> &r) { return r->time; },
+                     std::greater<uint64_t>(), o);
+    for (size_t i = 0; ok && i < owned.size(); i++) {
+      const row *e = expected[owned.size() - 1 - i];
+      ok = owned[i]->time == e->time &&
+           (i == 0 || owned[i - 1]->time != owned[i]->time ||
+            owned[i - 1]->seq < owned[i]->seq);
+    }
+    if (!ok) {
+      printf("bug: sort_by, %u threads\n", threads);
+      return false;
+    }
+  }
+  return true;
+}
+
+bool check_merge_runs() {
+  for (unsigned threads : {1u, 4u}) {
+    timsort::options o;
+    o.threads = threads;
+    for (size_t runs : {size_t(1), size_t(2), size_t(3), size_t(64)}) {
+      std::vector<size_t> lengths(runs);
+      std::vector<uint32_t> keys;
+      for (size_t r = 0; r < runs; r++) {
+        lengths[r] = r % 5 == 4 ? 0 : gen() % (600000 / runs);
+        std::vector<uint32_t> run = generate(lengths[r], few_values);
+        std::sort(run.begin(), run.end());
+        keys.insert(keys.end(), run.begin(), run.end());
+      }
+      std::vector<record> expected = records(keys), out = expected;
+      std::stable_sort(expected.begin(), expected.end(), by_key());
+      timsort::merge_runs(out.begin(), out.end(), lengths.data(), runs,
+                          by_key(), o);
+      std::vector<uint32_t> sorted(keys);
+      std::sort(sorted.begin(), sorted.end());
+      timsort::merge_runs(keys.begin(), keys.end(), lengths.data(), runs, o);
+      if (out != expected || keys != sorted) {
+        printf("bug: merge_runs, %zu runs, %u threads\n", runs, threads);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Values that are not trivially copyable, with strings longer than the
+// small-string buffer, which a merge leaves empty once moved from: sort,
+// sort_by on the strings, and merge_runs, with four threads.
+bool check_strings() {
+  typedef std::pair<std::string, int> named;
+  timsort::options o;
+  o.threads = 4;
+  const std::vector<uint32_t> keys = generate(300000, few_values);
+  std::vector<named> values;
+  for (size_t i = 0; i < keys.size(); i++) {
+    values.emplace_back("a key longer than any small string " +
+                            std::to_string(keys[i]),
+                        int(i));
+  }
+  auto by_name = [](const named &x, const named &y) {
+    return x.first < y.first;
+  };
+  std::vector<named> expected(values), out(values);
+  std::stable_sort(expected.begin(), expected.end(), by_name);
+  timsort::sort(out.begin(), out.end(), by_name, o);
+  bool ok = out == expected;
+  out = values;
+  timsort::sort_by(out.begin(), out.end(),
+                   [](const named &x) { return x.first; }, o);
+  ok = ok && out == expected;
+  std::vector<size_t> lengths = {values.size() / 3, values.size() / 4};
+  lengths.push_back(values.size() - lengths[0] - lengths[1]);
+  out = values;
+  expected = values;
+  for (size_t r = 0, start = 0; r < lengths.size(); start += lengths[r++]) {
+    std::stable_sort(out.begin() + start, out.begin() + start + lengths[r],
+                     by_name);
+  }
+  std::stable_sort(expected.begin(), expected.end(), by_name);
+  timsort::merge_runs(out.begin(), out.end(), lengths.data(), lengths.size(),
+                      by_name, o);
+  ok = ok && out == expected;
+  if (!ok) {
+    printf("bug: strings, %u threads\n", o.threads);
+  }
+  return ok;
+}
+
+} // namespace
+
+int main() {
+  if (!check_sort() || !check_sort_by() || !check_merge_runs() ||
+      !check_strings()) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
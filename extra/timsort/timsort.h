@@ -0,0 +1,690 @@
+// Timsort: a stable merge sort that takes the runs already in the data
+// (reversing the strictly descending ones), extends the short ones to
+// minrun values by binary insertion, and merges them as they come while the
+// lengths on its stack stay balanced. When one run keeps winning a merge,
+// the merge gallops: an exponential then binary search finds how many of
+// its values go next, and they are moved as a block. Nearly sorted input,
+// such as an append-mostly log, makes few long runs and few comparisons.
+//
+// This is gfx::timsort of 2016/09/28/timsort.hpp (also copied in
+// 2016/10/05) with three additions:
+//
+// - sort_by extracts each key once into an array of (key, index) pairs and
+//   sorts that, so that comparisons read contiguous keys instead of chasing
+//   pointers into the objects; each object then moves twice;
+// - merge_runs merges runs that the caller has already sorted (log
+//   segments, the outputs of other sorts) through the same stack;
+// - with options::threads > 1 and enough values, slices are sorted
+//   concurrently and the runs are merged pairwise, round by round. A round
+//   with fewer pairs than threads splits each merge between the threads at
+//   co-ranks: positions of the output whose sources are found by binary
+//   search.
+//
+// Header-only, C++14 (-pthread):
+//
+//   timsort::sort(v.begin(), v.end());
+//   timsort::sort_by(rows.begin(), rows.end(),
+//                    [](const row *r) { return r->time; });
+//   timsort::merge_runs(v.begin(), v.end(), lengths.data(), lengths.size());
+#ifndef TIMSORT_H
+#define TIMSORT_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../parallel/parallel.h"
+
+namespace timsort {
+
+struct options {
+  unsigned threads = 1; // 0: one per hardware thread
+};
+
+namespace internal {
+
+// Shorter inputs are sorted by binary insertion alone.
+constexpr ptrdiff_t min_merge = 32;
+// Wins in a row before a merge starts galloping.
+constexpr int min_gallop = 7;
+// The run stack and the galloping merges. Only comp(x, y) (x < y) is
+// called: x <= y is !comp(y, x).
+template <class It, class Compare> class merger {
+public:
+  typedef typename std::iterator_traits<It>::value_type value_type;
+  typedef typename std::iterator_traits<It>::difference_type diff_t;
+
+  explicit merger(Compare comp) : comp_(comp), min_gallop_(min_gallop) {}
+
+  // Pushes the sorted run [base, base + len), right after the previous one,
+  // and merges while the stack invariants do not hold.
+  void push(It base, diff_t len) {
+    runs_.push_back(run{base, len});
+    collapse();
+  }
+
+  // Merges everything on the stack.
+  void finish() {
+    while (runs_.size() > 1) {
+      size_t n = runs_.size() - 2;
+      if (n > 0 && runs_[n - 1].len < runs_[n + 1].len) {
+        n--;
+      }
+      merge_at(n);
+    }
+  }
+
+  // Merges the sorted runs [base1, base1 + len1) and
+  // [base1 + len1, base1 + len1 + len2) in place.
+  void merge(It base1, diff_t len1, diff_t len2) {
+    It base2 = base1 + len1;
+    // values of the first run that precede the second already stay
+    const diff_t k = gallop_right(*base2, base1, len1, 0);
+    base1 += k;
+    len1 -= k;
+    if (len1 == 0) {
+      return;
+    }
+    // and so do values of the second run after the first one's last
+    len2 = gallop_left(*(base1 + (len1 - 1)), base2, len2, len2 - 1);
+    if (len2 == 0) {
+      return;
+    }
+    if (len1 <= len2) {
+      merge_lo(base1, len1, base2, len2);
+    } else {
+      merge_hi(base1, len1, base2, len2);
+    }
+  }
+
+  // Sorts [lo, hi) knowing that [lo, start) is sorted.
+  static void binary_sort(It lo, It hi, It start, Compare comp) {
+    if (start == lo) {
+      ++start;
+    }
+    for (; start < hi; ++start) {
+      value_type pivot = std::move(*start);
+      const It pos = std::upper_bound(lo, start, pivot, comp);
+      std::move_backward(pos, start, start + 1);
+      *pos = std::move(pivot);
+    }
+  }
+
+  // The length of the run at lo, made ascending if it was strictly
+  // descending (reversing keeps the sort stable).
+  static diff_t count_run(It lo, It hi, Compare comp) {
+    It run_hi = lo + 1;
+    if (run_hi == hi) {
+      return 1;
+    }
+    if (comp(*run_hi, *lo)) {
+      ++run_hi;
+      while (run_hi < hi && comp(*run_hi, *(run_hi - 1))) {
+        ++run_hi;
+      }
+      std::reverse(lo, run_hi);
+    } else {
+      ++run_hi;
+      while (run_hi < hi && !comp(*run_hi, *(run_hi - 1))) {
+        ++run_hi;
+      }
+    }
+    return run_hi - lo;
+  }
+
+  // Between min_merge / 2 and min_merge, such that n / minrun is a power
+  // of two or a little less.
+  static diff_t min_run_length(diff_t n) {
+    diff_t r = 0;
+    while (n >= min_merge) {
+      r |= n & 1;
+      n >>= 1;
+    }
+    return n + r;
+  }
+
+private:
+  struct run {
+    It base;
+    diff_t len;
+  };
+
+  typedef typename std::vector<value_type>::iterator tmp_iterator;
+
+  void collapse() {
+    while (runs_.size() > 1) {
+      size_t n = runs_.size() - 2;
+      if ((n > 0 && runs_[n - 1].len <= runs_[n].len + runs_[n + 1].len) ||
+          (n > 1 && runs_[n - 2].len <= runs_[n - 1].len + runs_[n].len)) {
+        if (runs_[n - 1].len < runs_[n + 1].len) {
+          n--;
+        }
+        merge_at(n);
+      } else if (runs_[n].len <= runs_[n + 1].len) {
+        merge_at(n);
+      } else {
+        break;
+      }
+    }
+  }
+
+  // Merges runs i and i + 1 of the stack.
+  void merge_at(size_t i) {
+    const It base1 = runs_[i].base;
+    const diff_t len1 = runs_[i].len, len2 = runs_[i + 1].len;
+    runs_[i].len = len1 + len2;
+    if (i + 3 == runs_.size()) {
+      runs_[i + 1] = runs_[i + 2];
+    }
+    runs_.pop_back();
+    merge(base1, len1, len2);
+  }
+
+  // Where key goes in the sorted base[0, len), before the values equal to
+  // it; the search starts at hint and gallops away from it.
+  template <class Iter>
+  diff_t gallop_left(const value_type &key, Iter base, diff_t len,
+                     diff_t hint) {
+    diff_t last_ofs = 0, ofs = 1;
+    if (comp_(*(base + hint), key)) {
+      const diff_t max_ofs = len - hint;
+      while (ofs < max_ofs && comp_(*(base + (hint + ofs)), key)) {
+        last_ofs = ofs;
+        ofs = (ofs << 1) + 1;
+        if (ofs <= 0) { // overflow
+          ofs = max_ofs;
+        }
+      }
+      ofs = std::min(ofs, max_ofs);
+      last_ofs += hint;
+      ofs += hint;
+    } else {
+      const diff_t max_ofs = hint + 1;
+      while (ofs < max_ofs && !comp_(*(base + (hint - ofs)), key)) {
+        last_ofs = ofs;
+        ofs = (ofs << 1) + 1;
+        if (ofs <= 0) {
+          ofs = max_ofs;
+        }
+      }
+      ofs = std::min(ofs, max_ofs);
+      const diff_t tmp = last_ofs;
+      last_ofs = hint - ofs;
+      ofs = hint - tmp;
+    }
+    return std::lower_bound(base + (last_ofs + 1), base + ofs, key, comp_) -
+           base;
+  }
+
+  // The same, after the values equal to key.
+  template <class Iter>
+  diff_t gallop_right(const value_type &key, Iter base, diff_t len,
+                      diff_t hint) {
+    diff_t last_ofs = 0, ofs = 1;
+    if (comp_(key, *(base + hint))) {
+      const diff_t max_ofs = hint + 1;
+      while (ofs < max_ofs && comp_(key, *(base + (hint - ofs)))) {
+        last_ofs = ofs;
+        ofs = (ofs << 1) + 1;
+        if (ofs <= 0) {
+          ofs = max_ofs;
+        }
+      }
+      ofs = std::min(ofs, max_ofs);
+      const diff_t tmp = last_ofs;
+      last_ofs = hint - ofs;
+      ofs = hint - tmp;
+    } else {
+      const diff_t max_ofs = len - hint;
+      while (ofs < max_ofs && !comp_(key, *(base + (hint + ofs)))) {
+        last_ofs = ofs;
+        ofs = (ofs << 1) + 1;
+        if (ofs <= 0) { // overflow
+          ofs = max_ofs;
+        }
+      }
+      ofs = std::min(ofs, max_ofs);
+      last_ofs += hint;
+      ofs += hint;
+    }
+    return std::upper_bound(base + (last_ofs + 1), base + ofs, key, comp_) -
+           base;
+  }
+
+  // Merges from the front, the first run (the shorter) copied aside; the
+  // first value of the second run and the last of the first are known to
+  // move.
+  void merge_lo(It base1, diff_t len1, It base2, diff_t len2) {
+    copy_to_tmp(base1, len1);
+    tmp_iterator cursor1 = tmp_.begin();
+    It cursor2 = base2, dest = base1;
+    *(dest++) = std::move(*(cursor2++));
+    if (--len2 == 0) {
+      std::move(cursor1, cursor1 + len1, dest);
+      return;
+    }
+    if (len1 == 1) {
+      std::move(cursor2, cursor2 + len2, dest);
+      *(dest + len2) = std::move(*cursor1);
+      return;
+    }
+    int gallop = min_gallop_;
+    for (bool done = false; !done;) {
+      int count1 = 0, count2 = 0;
+      // one value at a time until a run wins gallop times in a row
+      do {
+        if (comp_(*cursor2, *cursor1)) {
+          *(dest++) = std::move(*(cursor2++));
+          count2++;
+          count1 = 0;
+          if (--len2 == 0) {
+            done = true;
+          }
+        } else {
+          *(dest++) = std::move(*(cursor1++));
+          count1++;
+          count2 = 0;
+          if (--len1 == 1) {
+            done = true;
+          }
+        }
+      } while (!done && (count1 | count2) < gallop);
+      // then blocks, while they stay long
+      while (!done) {
+        count1 = gallop_right(*cursor2, cursor1, len1, 0);
+        if (count1 != 0) {
+          dest = std::move(cursor1, cursor1 + count1, dest);
+          cursor1 += count1;
+          len1 -= count1;
+          if (len1 <= 1) {
+            done = true;
+            break;
+          }
+        }
+        *(dest++) = std::move(*(cursor2++));
+        if (--len2 == 0) {
+          done = true;
+          break;
+        }
+        count2 = gallop_left(*cursor1, cursor2, len2, 0);
+        if (count2 != 0) {
+          dest = std::move(cursor2, cursor2 + count2, dest);
+          cursor2 += count2;
+          len2 -= count2;
+          if (len2 == 0) {
+            done = true;
+            break;
+          }
+        }
+        *(dest++) = std::move(*(cursor1++));
+        if (--len1 == 1) {
+          done = true;
+          break;
+        }
+        gallop--;
+        if (count1 < min_gallop && count2 < min_gallop) {
+          break;
+        }
+      }
+      if (!done) {
+        // galloping did not pay: make it harder to enter
+        gallop = std::max(gallop, 0) + 2;
+      }
+    }
+    min_gallop_ = std::max(gallop, 1);
+    if (len1 == 1) {
+      std::move(cursor2, cursor2 + len2, dest);
+      *(dest + len2) = std::move(*cursor1);
+    } else {
+      assert(len1 > 1 && len2 == 0 && "the comparison is not a strict order");
+      std::move(cursor1, cursor1 + len1, dest);
+    }
+  }
+
+  // Merges from the back, the second run (the shorter) copied aside. The
+  // cursors point one past the next value to move.
+  void merge_hi(It base1, diff_t len1, It base2, diff_t len2) {
+    copy_to_tmp(base2, len2);
+    It cursor1 = base1 + len1, dest = base2 + len2;
+    tmp_iterator cursor2 = tmp_.begin() + len2;
+    *(--dest) = std::move(*(--cursor1));
+    if (--len1 == 0) {
+      std::move(tmp_.begin(), cursor2, dest - len2);
+      return;
+    }
+    if (len2 == 1) {
+      dest = std::move_backward(cursor1 - len1, cursor1, dest);
+      *(--dest) = std::move(*(--cursor2));
+      return;
+    }
+    int gallop = min_gallop_;
+    for (bool done = false; !done;) {
+      int count1 = 0, count2 = 0;
+      do {
+        if (comp_(*(cursor2 - 1), *(cursor1 - 1))) {
+          *(--dest) = std::move(*(--cursor1));
+          count1++;
+          count2 = 0;
+          if (--len1 == 0) {
+            done = true;
+          }
+        } else {
+          *(--dest) = std::move(*(--cursor2));
+          count2++;
+          count1 = 0;
+          if (--len2 == 1) {
+            done = true;
+          }
+        }
+      } while (!done && (count1 | count2) < gallop);
+      while (!done) {
+        count1 = len1 - gallop_right(*(cursor2 - 1), base1, len1, len1 - 1);
+        if (count1 != 0) {
+          dest = std::move_backward(cursor1 - count1, cursor1, dest);
+          cursor1 -= count1;
+          len1 -= count1;
+          if (len1 == 0) {
+            done = true;
+            break;
+          }
+        }
+        *(--dest) = std::move(*(--cursor2));
+        if (--len2 == 1) {
+          done = true;
+          break;
+        }
+        count2 = len2 - gallop_left(*(cursor1 - 1), tmp_.begin(), len2,
+                                    len2 - 1);
+        if (count2 != 0) {
+          dest = std::move_backward(cursor2 - count2, cursor2, dest);
+          cursor2 -= count2;
+          len2 -= count2;
+          if (len2 <= 1) {
+            done = true;
+            break;
+          }
+        }
+        *(--dest) = std::move(*(--cursor1));
+        if (--len1 == 0) {
+          done = true;
+          break;
+        }
+        gallop--;
+        if (count1 < min_gallop && count2 < min_gallop) {
+          break;
+        }
+      }
+      if (!done) {
+        gallop = std::max(gallop, 0) + 2;
+      }
+    }
+    min_gallop_ = std::max(gallop, 1);
+    if (len2 == 1) {
+      dest = std::move_backward(cursor1 - len1, cursor1, dest);
+      *(--dest) = std::move(*(--cursor2));
+    } else {
+      assert(len2 > 1 && len1 == 0 && "the comparison is not a strict order");
+      std::move(tmp_.begin(), cursor2, dest - len2);
+    }
+  }
+
+  void copy_to_tmp(It begin, diff_t len) {
+    tmp_.clear();
+    tmp_.reserve(len);
+    std::move(begin, begin + len, std::back_inserter(tmp_));
+  }
+
+  Compare comp_;
+  int min_gallop_; // adapts to the data, merge after merge
+  std::vector<value_type> tmp_;
+  std::vector<run> runs_;
+};
+
+template <class It, class Compare>
+void sort_serial(It lo, It hi, Compare comp) {
+  typedef merger<It, Compare> merger_type;
+  typedef typename merger_type::diff_t diff_t;
+  diff_t remaining = hi - lo;
+  if (remaining < 2) {
+    return;
+  }
+  if (remaining < min_merge) {
+    merger_type::binary_sort(lo, hi, lo + merger_type::count_run(lo, hi, comp),
+                             comp);
+    return;
+  }
+  merger_type m(comp);
+  const diff_t min_run = merger_type::min_run_length(remaining);
+  for (It cur = lo; remaining != 0;) {
+    diff_t len = merger_type::count_run(cur, hi, comp);
+    if (len < min_run) {
+      const diff_t force = std::min(remaining, min_run);
+      merger_type::binary_sort(cur, cur + force, cur + len, comp);
+      len = force;
+    }
+    m.push(cur, len);
+    cur += len;
+    remaining -= len;
+  }
+  m.finish();
+}
+
+// The co-rank of position k of the stable merge of a[0, n1) and b[0, n2):
+// the i such that its first k values are a[0, i) and b[0, k - i).
+template <class It, class Compare, class D>
+D co_rank(It a, D n1, It b, D n2, D k, Compare comp) {
+  D lo = std::max(D(0), k - n2), hi = std::min(k, n1);
+  while (lo < hi) {
+    const D i = lo + (hi - lo) / 2;
+    if (!comp(b[k - i - 1], a[i])) { // a[i] comes before b[k - i - 1]
+      lo = i + 1;
+    } else {
+      hi = i;
+    }
+  }
+  return lo;
+}
+
+// Merges [base, base + len1) and [base + len1, base + len1 + len2) with
+// threads threads, each writing a slice of the output to buffer.
+template <class It, class Compare, class D>
+void split_merge(It base, D len1, D len2, Compare comp, unsigned threads,
+                 std::vector<typename std::iterator_traits<It>::value_type>
+                     &buffer,
+                 std::true_type) {
+  It mid = base + len1, end = mid + len2;
+  // the values already in place, as in merger::merge
+  base = std::upper_bound(base, mid, *mid, comp);
+  if (base == mid) {
+    return;
+  }
+  end = std::lower_bound(mid, end, *(mid - 1), comp);
+  const D n1 = mid - base, n2 = end - mid, n = n1 + n2;
+  if (buffer.size() < size_t(n)) {
+    buffer.resize(n);
+  }
+  auto slice = [n, threads](unsigned t) { return D(n * t / threads); };
+  // All the split points first: once a thread moves its values out, the
+  // binary searches of the others must not compare them.
+  std::vector<D> splits(threads + 1);
+  splits[threads] = n1;
+  parallel::in_parallel(threads, [&](unsigned t) {
+    splits[t] = co_rank(base, n1, mid, n2, slice(t), comp);
+  });
+  parallel::in_parallel(threads, [&](unsigned t) {
+    const D k0 = slice(t), k1 = slice(t + 1);
+    const D i0 = splits[t], i1 = splits[t + 1];
+    std::merge(std::make_move_iterator(base + i0),
+               std::make_move_iterator(base + i1),
+               std::make_move_iterator(mid + (k0 - i0)),
+               std::make_move_iterator(mid + (k1 - i1)), buffer.begin() + k0,
+               comp);
+  });
+  parallel::in_parallel(threads, [&](unsigned t) {
+    std::move(buffer.begin() + slice(t), buffer.begin() + slice(t + 1),
+              base + slice(t));
+  });
+}
+
+// Values that cannot be default-constructed into a buffer: one thread.
+template <class It, class Compare, class D, class Buffer>
+void split_merge(It base, D len1, D len2, Compare comp, unsigned, Buffer &,
+                 std::false_type) {
+  merger<It, Compare>(comp).merge(base, len1, len2);
+}
+
+// Merges the consecutive sorted runs of the given lengths, pairwise, round
+// by round. In a round with as many pairs as threads, the threads take
+// whole merges; otherwise all of them work on each merge.
+template <class It, class Compare, class D>
+void merge_parallel(It first, std::vector<D> lengths, Compare comp,
+                    unsigned threads) {
+  typedef typename std::iterator_traits<It>::value_type value_type;
+  std::vector<value_type> buffer;
+  std::vector<It> starts;
+  while (lengths.size() > 1) {
+    starts.clear();
+    It position = first;
+    for (D len : lengths) {
+      starts.push_back(position);
+      position += len;
+    }
+    const size_t pairs = lengths.size() / 2;
+    if (pairs >= threads) {
+      std::atomic<size_t> next(0);
+      parallel::in_parallel(threads, [&](unsigned) {
+        merger<It, Compare> m(comp);
+        for (size_t p; (p = next++) < pairs;) {
+          m.merge(starts[2 * p], lengths[2 * p], lengths[2 * p + 1]);
+        }
+      });
+    } else {
+      for (size_t p = 0; p < pairs; p++) {
+        split_merge(starts[2 * p], lengths[2 * p], lengths[2 * p + 1], comp,
+                    threads, buffer,
+                    std::is_default_constructible<value_type>());
+      }
+    }
+    for (size_t p = 0; p < pairs; p++) {
+      lengths[p] = lengths[2 * p] + lengths[2 * p + 1];
+    }
+    if (lengths.size() % 2 != 0) {
+      lengths[pairs] = lengths.back();
+      lengths.resize(pairs + 1);
+    } else {
+      lengths.resize(pairs);
+    }
+  }
+}
+
+} // namespace internal
+
+// Same as std::stable_sort(first, last, comp).
+template <class It, class Compare>
+void sort(It first, It last, Compare comp, const options &o = options()) {
+  typedef typename std::iterator_traits<It>::difference_type diff_t;
+  const size_t n = size_t(last - first);
+  const unsigned threads = parallel::thread_count(o.threads);
+  if (threads == 1 || n / threads < parallel::minimum_values) {
+    internal::sort_serial(first, last, comp);
+    return;
+  }
+  auto slice = [n, threads](unsigned t) { return diff_t(t * n / threads); };
+  std::vector<diff_t> lengths(threads);
+  parallel::in_parallel(threads, [&](unsigned t) {
+    lengths[t] = slice(t + 1) - slice(t);
+    internal::sort_serial(first + slice(t), first + slice(t + 1), comp);
+  });
+  internal::merge_parallel(first, lengths, comp, threads);
+}
+
+template <class It> void sort(It first, It last, const options &o = options()) {
+  timsort::sort(first, last, std::less<>(), o);
+}
+
+// Same as sort(first, last, [](x, y) { return comp(key(x), key(y)); }),
+// calling key once per value. The keys are sorted with their indexes, then
+// the values are moved out in that order and back.
+template <class It, class Key, class Compare>
+void sort_by(It first, It last, Key key, Compare comp,
+             const options &o = options()) {
+  typedef typename std::iterator_traits<It>::value_type value_type;
+  typedef typename std::decay<decltype(key(*first))>::type key_type;
+  typedef std::pair<key_type, size_t> decorated;
+  const size_t n = size_t(last - first);
+  std::vector<decorated> keys;
+  keys.reserve(n);
+  for (size_t i = 0; i < n; i++) {
+    keys.emplace_back(key(first[i]), i);
+  }
+  timsort::sort(keys.begin(), keys.end(),
+       [comp](const decorated &x, const decorated &y) {
+         return comp(x.first, y.first);
+       },
+       o);
+  size_t i = 0;
+  while (i < n && keys[i].second == i) {
+    i++;
+  }
+  if (i == n) {
+    return; // already sorted
+  }
+  std::vector<value_type> sorted;
+  sorted.reserve(n - i);
+  for (size_t j = i; j < n; j++) {
+    sorted.push_back(std::move(first[keys[j].second]));
+  }
+  std::move(sorted.begin(), sorted.end(), first + i);
+}
+
+template <class It, class Key>
+void sort_by(It first, It last, Key key, const options &o = options()) {
+  timsort::sort_by(first, last, key, std::less<>(), o);
+}
+
+// Merges [first, last), made of runs sorted by comp of lengths[0],
+// lengths[1], ..., lengths[runs - 1] (adding up to last - first), into one
+// sorted run. Equal values keep their order, including across runs.
+template <class It, class Compare>
+void merge_runs(It first, It last, const size_t *lengths, size_t runs,
+                Compare comp, const options &o = options()) {
+  typedef typename std::iterator_traits<It>::difference_type diff_t;
+  const size_t n = size_t(last - first);
+  std::vector<diff_t> nonempty;
+  size_t total = 0;
+  for (size_t r = 0; r < runs; r++) {
+    if (lengths[r] != 0) {
+      nonempty.push_back(diff_t(lengths[r]));
+      total += lengths[r];
+    }
+  }
+  assert(total == n && "the run lengths add up to last - first");
+  (void)total;
+  const unsigned threads = parallel::thread_count(o.threads);
+  if (threads > 1 && n / threads >= parallel::minimum_values) {
+    internal::merge_parallel(first, nonempty, comp, threads);
+    return;
+  }
+  internal::merger<It, Compare> m(comp);
+  for (diff_t length : nonempty) {
+    m.push(first, length);
+    first += length;
+  }
+  m.finish();
+}
+
+template <class It>
+void merge_runs(It first, It last, const size_t *lengths, size_t runs,
+                const options &o = options()) {
+  timsort::merge_runs(first, last, lengths, runs, std::less<>(), o);
+}
+
+} // namespace timsort
+
+#endif // TIMSORT_H
@@ -0,0 +1,219 @@
+// Speed of the six conversions in GB/s of input, over texts of n
+// characters (1 million by default) made of words in the scripts of a few
+// languages, with spaces and punctuation as in running text, or over the
+// UTF-8 file given as argument: the length of the output, the validating
+// conversion with each back end, and the conversion of valid input with
+// the best back end.
+#include "transcode.h"
+
+#include "../harness/harness.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+struct corpus {
+  const char *name;
+  uint32_t first, last; // the letters
+  uint32_t extra_first, extra_last; // other letters, one in extra_every
+  int extra_every;
+  int word; // letters per word; 0 for no spaces
+};
+
+// Letters of ASCII, then of the script, then the punctuation of the
+// script, in words of a few letters.
+const corpus corpora[] = {
+    {"english", 'a', 'z', 'A', 'Z', 30, 5},
+    {"french", 'a', 'z', 0xE0, 0xFC, 20, 5},
+    {"russian", 0x430, 0x44F, 0x410, 0x42F, 30, 6},
+    {"arabic", 0x627, 0x64A, 0x660, 0x669, 40, 5},
+    {"hindi", 0x915, 0x939, 0x93E, 0x94C, 3, 4},
+    {"chinese", 0x4E00, 0x9FFF, 0x3001, 0x3002, 15, 0},
+    {"japanese", 0x3041, 0x3093, 0x4E00, 0x9FFF, 3, 0},
+    {"emoji", 'a', 'z', 0x1F600, 0x1F64F, 10, 5},
+};
+
+std::vector<uint32_t> generate(const corpus &c, size_t n,
+                               std::mt19937_64 &gen) {
+  std::vector<uint32_t> text;
+  while (text.size() < n) {
+    const int length =
+        c.word == 0 ? 20 + int(gen() % 20) : c.word / 2 + int(gen() % c.word);
+    for (int k = 0; k < length; k++) {
+      if (gen() % c.extra_every == 0) {
+        text.push_back(c.extra_first +
+                       uint32_t(gen() % (c.extra_last - c.extra_first + 1)));
+      } else {
+        text.push_back(c.first + uint32_t(gen() % (c.last - c.first + 1)));
+      }
+    }
+    text.push_back(gen() % 12 == 0 ? '.' : c.word == 0 ? '\n' : ' ');
+  }
+  text.resize(n);
+  return text;
+}
+
+bool load(const char *filename, std::string *text) {
+  FILE *f = fopen(filename, "rb");
+  if (f == nullptr) {
+    return false;
+  }
+  char buffer[1 << 16];
+  while (size_t n = fread(buffer, 1, sizeof(buffer), f)) {
+    text->append(buffer, n);
+  }
+  fclose(f);
+  return true;
+}
+
+// The characters of a UTF-8 text; false, with a message, if it is invalid.
+bool decode(const char *name, const std::string &utf8,
+            std::vector<uint32_t> *text) {
+  std::vector<char32_t> utf32(
+      transcode::utf32_length_from_utf8(utf8.data(), utf8.size()));
+  const transcode::result r =
+      transcode::utf8_to_utf32(utf8.data(), utf8.size(), utf32.data());
+  if (!r.valid) {
+    printf("%s: invalid UTF-8 at byte %zu\n", name, r.error);
+    return false;
+  }
+  text->assign(utf32.begin(), utf32.end());
+  return true;
+}
+
+struct encoded {
+  std::vector<char> utf8;
+  std::vector<char16_t> utf16;
+  std::vector<char32_t> utf32;
+};
+
+encoded encode(const std::vector<uint32_t> &text) {
+  encoded e;
+  e.utf32.assign(text.begin(), text.end());
+  e.utf8.resize(transcode::utf8_length_from_utf32(e.utf32.data(), text.size()));
+  transcode::utf32_to_utf8(e.utf32.data(), text.size(), e.utf8.data());
+  e.utf16.resize(
+      transcode::utf16_length_from_utf32(e.utf32.data(), text.size()));
+  transcode::utf32_to_utf16(e.utf32.data(), text.size(), e.utf16.data());
+  return e;
+}
+
+// GB/s of input; 0 for an unsupported back end
+template <class F>
+double speed(const char *name, size_t bytes, F f, harness::options &opts) {
+  auto r = harness::run(name, bytes, [&] {
+    harness::do_not_optimize(f());
+  }, opts);
+  if (opts.format != HARNESS_TEXT) {
+    r.report();
+  }
+  return bytes / r.min();
+}
+
+// One conversion with every back end, to out, compared with expected.
+template <class In, class Out, class Length, class Convert, class Valid>
+bool run(const char *data, const char *conversion, const std::vector<In> &in,
+         const std::vector<Out> &expected, Length length, Convert convert,
+         Valid valid, harness::options &opts) {
+  const size_t bytes = in.size() * sizeof(In);
+  std::vector<Out> out(expected.size());
+  double speeds[5] = {0, 0, 0, 0, 0};
+  speeds[0] = speed("length", bytes, [&] {
+    return length(in.data(), in.size(), transcode::options());
+  }, opts);
+  const transcode::backend backends[] = {transcode::backend::scalar,
+                                         transcode::backend::avx2,
+                                         transcode::backend::avx512};
+  bool ok = true;
+  for (int k = 0; k < 3; k++) {
+    transcode::options o;
+    o.kernel = backends[k];
+    if (!transcode::backend_supported(o.kernel)) {
+      continue;
+    }
+    speeds[k + 1] =
+        speed(transcode::backend_name(o.kernel), bytes, [&] {
+          return convert(in.data(), in.size(), out.data(), o).count;
+        }, opts);
+    ok = ok && out == expected;
+  }
+  speeds[4] = speed("valid", bytes, [&] {
+    return valid(in.data(), in.size(), out.data(), transcode::options());
+  }, opts);
+  ok = ok && out == expected;
+  if (opts.format == HARNESS_TEXT) {
+    printf("%-8s\t%-14s\t%6.2f\t%6.2f\t%6.2f\t%6.2f\t%6.2f\n", data,
+           conversion, speeds[0], speeds[1], speeds[2], speeds[3],
+           speeds[4]);
+  }
+  return ok;
+}
+
+// All six conversions of one text.
+bool run_all(const char *data, const encoded &e, harness::options &opts) {
+  return run(data, "utf8 to utf16", e.utf8, e.utf16,
+             transcode::utf16_length_from_utf8, transcode::utf8_to_utf16,
+             transcode::valid_utf8_to_utf16, opts) &&
+         run(data, "utf8 to utf32", e.utf8, e.utf32,
+             transcode::utf32_length_from_utf8, transcode::utf8_to_utf32,
+             transcode::valid_utf8_to_utf32, opts) &&
+         run(data, "utf16 to utf8", e.utf16, e.utf8,
+             transcode::utf8_length_from_utf16, transcode::utf16_to_utf8,
+             transcode::valid_utf16_to_utf8, opts) &&
+         run(data, "utf16 to utf32", e.utf16, e.utf32,
+             transcode::utf32_length_from_utf16, transcode::utf16_to_utf32,
+             transcode::valid_utf16_to_utf32, opts) &&
+         run(data, "utf32 to utf8", e.utf32, e.utf8,
+             transcode::utf8_length_from_utf32, transcode::utf32_to_utf8,
+             transcode::valid_utf32_to_utf8, opts) &&
+         run(data, "utf32 to utf16", e.utf32, e.utf16,
+             transcode::utf16_length_from_utf32, transcode::utf32_to_utf16,
+             transcode::valid_utf32_to_utf16, opts);
+}
+
+// The argument is a character count if it has only digits, else a file.
+int main(int argc, char **argv) {
+  const char *filename =
+      argc > 1 && strspn(argv[1], "0123456789") != strlen(argv[1])
+          ? argv[1]
+          : nullptr;
+  std::vector<uint32_t> file_text;
+  if (filename != nullptr) {
+    std::string utf8;
+    if (!load(filename, &utf8)) {
+      printf("cannot read %s\n", filename);
+      return EXIT_FAILURE;
+    }
+    if (!decode(filename, utf8, &file_text)) {
+      return EXIT_FAILURE;
+    }
+  }
+  const size_t n = filename != nullptr ? file_text.size()
+                   : argc > 1          ? size_t(atoll(argv[1]))
+                                       : 1000000;
+  std::mt19937_64 gen(1234);
+  harness::options opts = harness::default_options();
+  opts.repeat = 5;
+  printf("n = %zu characters, GB/s of input, best back end: %s\n", n,
+         transcode::backend_name(transcode::active_backend()));
+  printf("data    \tconversion    \tlength\tscalar\tavx2  \tavx512\tvalid\n");
+  if (filename != nullptr) {
+    const char *slash = strrchr(filename, '/');
+    if (!run_all(slash != nullptr ? slash + 1 : filename, encode(file_text),
+                 opts)) {
+      printf("bug!\n");
+      return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+  }
+  for (const corpus &c : corpora) {
+    if (!run_all(c.name, encode(generate(c, n, gen)), opts)) {
+      printf("bug!\n");
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,298 @@
+// Checks of every back end against plain encoders: the six conversions and
+// the six lengths of random text with characters of 1 to 4 bytes (and the
+// code points at the edges of each length), in outputs of the exact size,
+// and the errors of text made invalid at random places.
+#include "transcode.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const transcode::backend backends[] = {
+    transcode::backend::scalar, transcode::backend::avx2,
+    transcode::backend::avx512};
+
+std::mt19937_64 gen(1234);
+
+struct text {
+  std::vector<char> utf8;
+  std::vector<char16_t> utf16;
+  std::vector<char32_t> utf32;
+};
+
+text encode(const std::vector<uint32_t> &code_points) {
+  text t;
+  for (uint32_t c : code_points) {
+    t.utf32.push_back(c);
+    if (c < 0x80) {
+      t.utf8.push_back(char(c));
+    } else if (c < 0x800) {
+      t.utf8.push_back(char(0xC0 | (c >> 6)));
+      t.utf8.push_back(char(0x80 | (c & 0x3F)));
+    } else if (c < 0x10000) {
+      t.utf8.push_back(char(0xE0 | (c >> 12)));
+      t.utf8.push_back(char(0x80 | ((c >> 6) & 0x3F)));
+      t.utf8.push_back(char(0x80 | (c & 0x3F)));
+    } else {
+      t.utf8.push_back(char(0xF0 | (c >> 18)));
+      t.utf8.push_back(char(0x80 | ((c >> 12) & 0x3F)));
+      t.utf8.push_back(char(0x80 | ((c >> 6) & 0x3F)));
+      t.utf8.push_back(char(0x80 | (c & 0x3F)));
+    }
+    if (c < 0x10000) {
+      t.utf16.push_back(char16_t(c));
+    } else {
+      t.utf16.push_back(char16_t(0xD800 + ((c - 0x10000) >> 10)));
+      t.utf16.push_back(char16_t(0xDC00 + (c & 0x3FF)));
+    }
+  }
+  return t;
+}
+
+const uint32_t edges[] = {0,      0x7F,   0x80,    0x7FF,   0x800,
+                          0xD7FF, 0xE000, 0xFFFF,  0x10000, 0x10FFFF};
+
+// mostly ASCII when ascii is set, the lengths in equal parts otherwise
+std::vector<uint32_t> random_code_points(size_t n, bool ascii) {
+  std::vector<uint32_t> code_points;
+  while (code_points.size() < n) {
+    uint32_t c;
+    switch (gen() % (ascii ? 40 : 5)) {
+    case 1:
+      c = 0x80 + gen() % (0x800 - 0x80);
+      break;
+    case 2:
+      do {
+        c = 0x800 + gen() % (0x10000 - 0x800);
+      } while (c >= 0xD800 && c <= 0xDFFF);
+      break;
+    case 3:
+      c = 0x10000 + gen() % (0x110000 - 0x10000);
+      break;
+    case 4:
+      c = edges[gen() % 10];
+      break;
+    default:
+      c = gen() % 0x80;
+    }
+    code_points.push_back(c);
+  }
+  return code_points;
+}
+
+bool report(const char *what, transcode::backend b, size_t n) {
+  printf("bug: %s, %s, %zu units\n", what, transcode::backend_name(b), n);
+  return false;
+}
+
+// One conversion of valid input, validating and not, to an output of the
+// exact length.
+template <class In, class Out, class Length, class Convert, class Valid>
+bool check_conversion(const char *what, transcode::backend b,
+                      const std::vector<In> &in,
+                      const std::vector<Out> &expected, Length length,
+                      Convert convert, Valid valid) {
+  transcode::options o;
+  o.kernel = b;
+  if (length(in.data(), in.size(), o) != expected.size()) {
+    return report(what, b, in.size());
+  }
+  std::vector<Out> out(expected.size());
+  const transcode::result r = convert(in.data(), in.size(), out.data(), o);
+  if (!r.valid || r.error != in.size() || r.count != expected.size() ||
+      out != expected) {
+    return report(what, b, in.size());
+  }
+  std::fill(out.begin(), out.end(), Out(0));
+  if (valid(in.data(), in.size(), out.data(), o) != expected.size() ||
+      out != expected) {
+    return report(what, b, in.size());
+  }
+  return true;
+}
+
+bool check_valid(const std::vector<uint32_t> &code_points) {
+  const text t = encode(code_points);
+  for (transcode::backend b : backends) {
+    if (!transcode::backend_supported(b)) {
+      continue;
+    }
+    if (!check_conversion("utf8 to utf16", b, t.utf8, t.utf16,
+                          transcode::utf16_length_from_utf8,
+                          transcode::utf8_to_utf16,
+                          transcode::valid_utf8_to_utf16) ||
+        !check_conversion("utf8 to utf32", b, t.utf8, t.utf32,
+                          transcode::utf32_length_from_utf8,
+                          transcode::utf8_to_utf32,
+                          transcode::valid_utf8_to_utf32) ||
+        !check_conversion("utf16 to utf8", b, t.utf16, t.utf8,
+                          transcode::utf8_length_from_utf16,
+                          transcode::utf16_to_utf8,
+                          transcode::valid_utf16_to_utf8) ||
+        !check_conversion("utf16 to utf32", b, t.utf16, t.utf32,
+                          transcode::utf32_length_from_utf16,
+                          transcode::utf16_to_utf32,
+                          transcode::valid_utf16_to_utf32) ||
+        !check_conversion("utf32 to utf8", b, t.utf32, t.utf8,
+                          transcode::utf8_length_from_utf32,
+                          transcode::utf32_to_utf8,
+                          transcode::valid_utf32_to_utf8) ||
+        !check_conversion("utf32 to utf16", b, t.utf32, t.utf16,
+                          transcode::utf16_length_from_utf32,
+                          transcode::utf32_to_utf16,
+                          transcode::valid_utf32_to_utf16)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// One conversion of invalid input: the error where expected, and the
+// conversion without validation within its bound of factor * n units.
+template <class In, class Out, class Convert, class Valid>
+bool check_error(const char *what, transcode::backend b,
+                 const std::vector<In> &in, size_t error, size_t factor,
+                 Convert convert, Valid valid) {
+  transcode::options o;
+  o.kernel = b;
+  std::vector<Out> out(factor * in.size());
+  const transcode::result r = convert(in.data(), in.size(), out.data(), o);
+  if (r.valid || r.error != error ||
+      valid(in.data(), in.size(), out.data(), o) > out.size()) {
+    return report(what, b, in.size());
+  }
+  return true;
+}
+
+// the first invalid character of UTF-8, as in extra/utf8validate
+size_t utf8_error(const std::vector<char> &text) {
+  const size_t n = text.size();
+  size_t i = 0;
+  while (i < n) {
+    const uint8_t c = uint8_t(text[i]);
+    size_t length;
+    uint32_t code, minimum;
+    if (c < 0x80) {
+      i++;
+      continue;
+    } else if ((c & 0xE0) == 0xC0) {
+      length = 2, code = c & 0x1F, minimum = 0x80;
+    } else if ((c & 0xF0) == 0xE0) {
+      length = 3, code = c & 0x0F, minimum = 0x800;
+    } else if ((c & 0xF8) == 0xF0) {
+      length = 4, code = c & 0x07, minimum = 0x10000;
+    } else {
+      return i;
+    }
+    if (i + length > n) {
+      return i;
+    }
+    for (size_t k = 1; k < length; k++) {
+      if ((uint8_t(text[i + k]) & 0xC0) != 0x80) {
+        return i;
+      }
+      code = (code << 6) | (uint8_t(text[i + k]) & 0x3F);
+    }
+    if (code < minimum || code > 0x10FFFF ||
+        (code >= 0xD800 && code <= 0xDFFF)) {
+      return i;
+    }
+    i += length;
+  }
+  return n;
+}
+
+// the first unpaired surrogate of UTF-16
+size_t utf16_error(const std::vector<char16_t> &text) {
+  for (size_t i = 0; i < text.size(); i++) {
+    if ((text[i] & 0xF800) != 0xD800) {
+      continue;
+    }
+    if (text[i] >= 0xDC00 || i + 1 == text.size() ||
+        (text[i + 1] & 0xFC00) != 0xDC00) {
+      return i;
+    }
+    i++;
+  }
+  return text.size();
+}
+
+bool check_invalid(const std::vector<uint32_t> &code_points) {
+  if (code_points.empty()) {
+    return true;
+  }
+  text t = encode(code_points);
+  // UTF-8: a random byte somewhere
+  t.utf8[gen() % t.utf8.size()] = char(gen());
+  const size_t utf8_at = utf8_error(t.utf8);
+  // UTF-16: a surrogate somewhere, or a high one at the end
+  const size_t at =
+      gen() % 4 == 0 ? t.utf16.size() - 1 : gen() % t.utf16.size();
+  t.utf16[at] = char16_t(0xD800 + gen() % 0x800);
+  const size_t utf16_at = utf16_error(t.utf16);
+  // UTF-32: a surrogate or a value above U+10FFFF
+  const size_t utf32_at = gen() % t.utf32.size();
+  t.utf32[utf32_at] = gen() % 2 == 0 ? char32_t(0xD800 + gen() % 0x800)
+                                     : char32_t(0x110000 + gen() % 0xFFFF);
+  for (transcode::backend b : backends) {
+    if (!transcode::backend_supported(b)) {
+      continue;
+    }
+    if ((utf8_at < t.utf8.size() &&
+         (!check_error<char, char16_t>("invalid utf8 to utf16", b, t.utf8,
+                                       utf8_at, 2, transcode::utf8_to_utf16,
+                                       transcode::valid_utf8_to_utf16) ||
+          !check_error<char, char32_t>("invalid utf8 to utf32", b, t.utf8,
+                                       utf8_at, 1, transcode::utf8_to_utf32,
+                                       transcode::valid_utf8_to_utf32))) ||
+        (utf16_at < t.utf16.size() &&
+         (!check_error<char16_t, char>("invalid utf16 to utf8", b, t.utf16,
+                                     utf16_at, 3, transcode::utf16_to_utf8,
+                                     transcode::valid_utf16_to_utf8) ||
+        !check_error<char16_t, char32_t>(
+            "invalid utf16 to utf32", b, t.utf16, utf16_at, 1,
+            transcode::utf16_to_utf32, transcode::valid_utf16_to_utf32))) ||
+        !check_error<char32_t, char>("invalid utf32 to utf8", b, t.utf32,
+                                     utf32_at, 4, transcode::utf32_to_utf8,
+                                     transcode::valid_utf32_to_utf8) ||
+        !check_error<char32_t, char16_t>(
+            "invalid utf32 to utf16", b, t.utf32, utf32_at, 2,
+            transcode::utf32_to_utf16, transcode::valid_utf32_to_utf16)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main() {
+  printf("best back end: %s\n",
+         transcode::backend_name(transcode::active_backend()));
+  for (int trial = 0; trial < 3000; trial++) {
+    const std::vector<uint32_t> code_points =
+        random_code_points(gen() % 700, trial % 3 == 0);
+    if (!check_valid(code_points) || !check_invalid(code_points)) {
+      printf("bug!\n");
+      return EXIT_FAILURE;
+    }
+  }
+  // long runs of one length, which the vector loops take without a break
+  for (int width = 0; width < 4; width++) {
+    std::vector<uint32_t> code_points;
+    const uint32_t first[] = {0x20, 0x400, 0x4E00, 0x1F600};
+    for (uint32_t k = 0; k < 5000; k++) {
+      code_points.push_back(first[width] + k % 90);
+    }
+    if (!check_valid(code_points) || !check_invalid(code_points)) {
+      printf("bug!\n");
+      return EXIT_FAILURE;
+    }
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
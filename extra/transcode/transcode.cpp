@@ -0,0 +1,269 @@
+// Runtime dispatch and the scalar back end. UTF-8 input is validated by
+// extra/utf8validate with the back end of the same name.
+#include "transcode.h"
+#include "transcode_kernels.h"
+
+#include "../isa/dispatch.h"
+#include "../utf8validate/utf8validate.h"
+
+namespace transcode {
+
+namespace {
+
+struct implementation {
+  backend kind;
+  const char *name;
+  uint32_t required_instruction_sets;
+  const functions &(*table)();
+  utf8validate::backend validator;
+};
+
+const implementation scalar = {backend::scalar, "scalar", 0,
+                               scalar_functions,
+                               utf8validate::backend::scalar};
+const implementation avx2 = {backend::avx2, "avx2", instruction_set::AVX2,
+                             avx2_functions, utf8validate::backend::avx2};
+const implementation avx512 = {
+    backend::avx512, "avx512",
+    instruction_set::AVX512F | instruction_set::AVX512BW, avx512_functions,
+    utf8validate::backend::avx512};
+
+const implementation *const implementations[] = {&avx512, &avx2, &scalar};
+
+const implementation *best() {
+  static const implementation *best =
+      isa::first_supported(implementations, &scalar);
+  return best;
+}
+
+// nullptr if unknown or unsupported
+const implementation *find(backend kind) {
+  if (kind == backend::automatic) {
+    return best();
+  }
+  return isa::find(implementations, kind);
+}
+
+template <class Out>
+size_t scalar_valid_utf8_to(const uint8_t *in, size_t n, Out *out) {
+  return from_utf8(in, 0, n, n, out, 0).out;
+}
+
+template <bool Validate, class Out>
+position scalar_from_utf16(const uint16_t *in, size_t n, Out *out) {
+  return from_utf16<Validate>(in, 0, n, n, out, 0);
+}
+
+template <bool Validate, class Out>
+position scalar_from_utf32(const uint32_t *in, size_t n, Out *out) {
+  return from_utf32<Validate>(in, 0, n, out, 0);
+}
+
+const uint8_t *bytes(const char *p) {
+  return reinterpret_cast<const uint8_t *>(p);
+}
+uint8_t *bytes(char *p) { return reinterpret_cast<uint8_t *>(p); }
+const uint16_t *units(const char16_t *p) {
+  return reinterpret_cast<const uint16_t *>(p);
+}
+uint16_t *units(char16_t *p) { return reinterpret_cast<uint16_t *>(p); }
+const uint32_t *units(const char32_t *p) {
+  return reinterpret_cast<const uint32_t *>(p);
+}
+uint32_t *units(char32_t *p) { return reinterpret_cast<uint32_t *>(p); }
+
+result to_result(const position &p, size_t n) {
+  return p.valid ? result{true, n, p.out} : result{false, p.in, 0};
+}
+
+// validates UTF-8 with the validator of impl
+bool validate(const implementation &impl, const char *in, size_t n,
+              result *r) {
+  utf8validate::options o;
+  o.kernel = impl.validator;
+  const utf8validate::result v = utf8validate::validate(in, n, o);
+  *r = result{v.valid, v.error, 0};
+  return v.valid;
+}
+
+constexpr result unsupported = {false, 0, 0};
+
+} // namespace
+
+const functions &scalar_functions() {
+  static const functions functions = {
+      scalar_valid_utf8_to<uint16_t>,
+      scalar_valid_utf8_to<uint32_t>,
+      scalar_from_utf16<true, uint8_t>,
+      scalar_from_utf16<false, uint8_t>,
+      scalar_from_utf16<true, uint32_t>,
+      scalar_from_utf16<false, uint32_t>,
+      scalar_from_utf32<true, uint8_t>,
+      scalar_from_utf32<false, uint8_t>,
+      scalar_from_utf32<true, uint16_t>,
+      scalar_from_utf32<false, uint16_t>,
+      utf16_length_from_utf8,
+      utf32_length_from_utf8,
+      utf8_length_from_utf16,
+      utf32_length_from_utf16,
+      utf8_length_from_utf32,
+      utf16_length_from_utf32};
+  return functions;
+}
+
+bool backend_supported(backend b) { return find(b) != nullptr; }
+
+backend active_backend() { return best()->kind; }
+
+const char *backend_name(backend b) {
+  if (b == backend::automatic) {
+    return best()->name;
+  }
+  return isa::name_of(implementations, b);
+}
+
+result utf8_to_utf16(const char *in, size_t n, char16_t *out,
+                     const options &o) {
+  const implementation *impl = find(o.kernel);
+  result r = unsupported;
+  if (impl != nullptr && validate(*impl, in, n, &r)) {
+    r.count = impl->table().valid_utf8_to_utf16(bytes(in), n, units(out));
+  }
+  return r;
+}
+
+result utf8_to_utf32(const char *in, size_t n, char32_t *out,
+                     const options &o) {
+  const implementation *impl = find(o.kernel);
+  result r = unsupported;
+  if (impl != nullptr && validate(*impl, in, n, &r)) {
+    r.count = impl->table().valid_utf8_to_utf32(bytes(in), n, units(out));
+  }
+  return r;
+}
+
+result utf16_to_utf8(const char16_t *in, size_t n, char *out,
+                     const options &o) {
+  const implementation *impl = find(o.kernel);
+  return impl == nullptr
+             ? unsupported
+             : to_result(impl->table().utf16_to_utf8(units(in), n, bytes(out)),
+                         n);
+}
+
+result utf16_to_utf32(const char16_t *in, size_t n, char32_t *out,
+                      const options &o) {
+  const implementation *impl = find(o.kernel);
+  return impl == nullptr
+             ? unsupported
+             : to_result(impl->table().utf16_to_utf32(units(in), n, units(out)),
+                         n);
+}
+
+result utf32_to_utf8(const char32_t *in, size_t n, char *out,
+                     const options &o) {
+  const implementation *impl = find(o.kernel);
+  return impl == nullptr
+             ? unsupported
+             : to_result(impl->table().utf32_to_utf8(units(in), n, bytes(out)),
+                         n);
+}
+
+result utf32_to_utf16(const char32_t *in, size_t n, char16_t *out,
+                      const options &o) {
+  const implementation *impl = find(o.kernel);
+  return impl == nullptr
+             ? unsupported
+             : to_result(impl->table().utf32_to_utf16(units(in), n, units(out)),
+                         n);
+}
+
+size_t valid_utf8_to_utf16(const char *in, size_t n, char16_t *out,
+                           const options &o) {
+  const implementation *impl = find(o.kernel);
+  return impl == nullptr
+             ? 0
+             : impl->table().valid_utf8_to_utf16(bytes(in), n, units(out));
+}
+
+size_t valid_utf8_to_utf32(const char *in, size_t n, char32_t *out,
+                           const options &o) {
+  const implementation *impl = find(o.kernel);
+  return impl == nullptr
+             ? 0
+             : impl->table().valid_utf8_to_utf32(bytes(in), n, units(out));
+}
+
+size_t valid_utf16_to_utf8(const char16_t *in, size_t n, char *out,
+                           const options &o) {
+  const implementation *impl = find(o.kernel);
+  return impl == nullptr
+             ? 0
+             : impl->table().valid_utf16_to_utf8(units(in), n, bytes(out)).out;
+}
+
+size_t valid_utf16_to_utf32(const char16_t *in, size_t n, char32_t *out,
+                            const options &o) {
+  const implementation *impl = find(o.kernel);
+  return impl == nullptr
+             ? 0
+             : impl->table().valid_utf16_to_utf32(units(in), n, units(out)).out;
+}
+
+size_t valid_utf32_to_utf8(const char32_t *in, size_t n, char *out,
+                           const options &o) {
+  const implementation *impl = find(o.kernel);
+  return impl == nullptr
+             ? 0
+             : impl->table().valid_utf32_to_utf8(units(in), n, bytes(out)).out;
+}
+
+size_t valid_utf32_to_utf16(const char32_t *in, size_t n, char16_t *out,
+                            const options &o) {
+  const implementation *impl = find(o.kernel);
+  return impl == nullptr
+             ? 0
+             : impl->table().valid_utf32_to_utf16(units(in), n, units(out)).out;
+}
+
+size_t utf16_length_from_utf8(const char *in, size_t n, const options &o) {
+  const implementation *impl = find(o.kernel);
+  return impl == nullptr ? 0
+                         : impl->table().utf16_length_from_utf8(bytes(in), n);
+}
+
+size_t utf32_length_from_utf8(const char *in, size_t n, const options &o) {
+  const implementation *impl = find(o.kernel);
+  return impl == nullptr ? 0
+                         : impl->table().utf32_length_from_utf8(bytes(in), n);
+}
+
+size_t utf8_length_from_utf16(const char16_t *in, size_t n,
+                              const options &o) {
+  const implementation *impl = find(o.kernel);
+  return impl == nullptr ? 0
+                         : impl->table().utf8_length_from_utf16(units(in), n);
+}
+
+size_t utf32_length_from_utf16(const char16_t *in, size_t n,
+                               const options &o) {
+  const implementation *impl = find(o.kernel);
+  return impl == nullptr ? 0
+                         : impl->table().utf32_length_from_utf16(units(in), n);
+}
+
+size_t utf8_length_from_utf32(const char32_t *in, size_t n,
+                              const options &o) {
+  const implementation *impl = find(o.kernel);
+  return impl == nullptr ? 0
+                         : impl->table().utf8_length_from_utf32(units(in), n);
+}
+
+size_t utf16_length_from_utf32(const char32_t *in, size_t n,
+                               const options &o) {
+  const implementation *impl = find(o.kernel);
+  return impl == nullptr ? 0
+                         : impl->table().utf16_length_from_utf32(units(in), n);
+}
+
+} // namespace transcode
@@ -0,0 +1,111 @@
+// Conversions between UTF-8, UTF-16 and UTF-32 in all six directions, with
+// AVX2 or AVX-512 picked at runtime, and the lengths of the outputs.
+//
+// 2021/02/09/toutf16.c measures the simplest case, ASCII widened to
+// UTF-16; extra/unicode/codepoint.c encodes one code point at a time.
+// Here vectors of 8 (AVX2) or 16 (AVX-512) characters are decoded or
+// encoded at once: UTF-8 is decoded at every byte as if a character
+// started there and the code points of the lead bytes are compressed;
+// code points are encoded to UTF-8 in 32-bit lanes and the bytes of each
+// group of four are packed with one shuffle from a table of 256. Vectors
+// of ASCII, and of UTF-16 without surrogates, take shortcuts; what does
+// not fit (surrogate pairs, errors) goes one character at a time.
+//
+// UTF-16 and UTF-32 are in the byte order of the processor, without a BOM.
+//
+//   transcode::result r = transcode::utf8_to_utf16(in, n, out);
+//   if (!r.valid) printf("invalid character at %zu\n", r.error);
+//
+//   std::vector<char16_t> out(transcode::utf16_length_from_utf8(in, n));
+//   transcode::valid_utf8_to_utf16(in, n, out.data());
+#ifndef TRANSCODE_H
+#define TRANSCODE_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace transcode {
+
+struct functions; // of a back end, in transcode_kernels.h
+
+enum class backend {
+  automatic, // best supported one
+  scalar,
+  avx2,
+  avx512
+};
+
+// Whether the back end can run on this processor, and its name.
+bool backend_supported(backend b);
+backend active_backend();
+const char *backend_name(backend b);
+
+struct options {
+  backend kernel = backend::automatic;
+};
+
+struct result {
+  bool valid;
+  // When invalid, the offset (in input units) of the first character that
+  // is invalid or cut short; otherwise the input size.
+  size_t error;
+  // Output units written; 0 when invalid, and the output is then
+  // unspecified.
+  size_t count;
+};
+
+// The validating conversions: in[0, n) must be valid (UTF-8 as in
+// extra/utf8validate, UTF-16 with paired surrogates, UTF-32 code points up
+// to U+10FFFF and not surrogates). out must have room for the length that
+// the *_length_from_* functions below give. UTF-8 is validated by
+// extra/utf8validate first, then converted.
+result utf8_to_utf16(const char *in, size_t n, char16_t *out,
+                     const options &o = options());
+result utf8_to_utf32(const char *in, size_t n, char32_t *out,
+                     const options &o = options());
+result utf16_to_utf8(const char16_t *in, size_t n, char *out,
+                     const options &o = options());
+result utf16_to_utf32(const char16_t *in, size_t n, char32_t *out,
+                      const options &o = options());
+result utf32_to_utf8(const char32_t *in, size_t n, char *out,
+                     const options &o = options());
+result utf32_to_utf16(const char32_t *in, size_t n, char16_t *out,
+                      const options &o = options());
+
+// The conversions of input known to be valid; they return the output units
+// written. On invalid input the output is unspecified (an unpaired
+// surrogate is kept as it is, for instance), but they write at most
+// max_length(n) units: 2n from UTF-8 to UTF-16, n from UTF-8 to UTF-32 and
+// from UTF-16 to UTF-32, 3n from UTF-16 to UTF-8, 4n from UTF-32 to UTF-8
+// and 2n from UTF-32 to UTF-16. An unsupported back end writes nothing and
+// returns 0.
+size_t valid_utf8_to_utf16(const char *in, size_t n, char16_t *out,
+                           const options &o = options());
+size_t valid_utf8_to_utf32(const char *in, size_t n, char32_t *out,
+                           const options &o = options());
+size_t valid_utf16_to_utf8(const char16_t *in, size_t n, char *out,
+                           const options &o = options());
+size_t valid_utf16_to_utf32(const char16_t *in, size_t n, char32_t *out,
+                            const options &o = options());
+size_t valid_utf32_to_utf8(const char32_t *in, size_t n, char *out,
+                           const options &o = options());
+size_t valid_utf32_to_utf16(const char32_t *in, size_t n, char16_t *out,
+                            const options &o = options());
+
+// The output units of the conversion of valid input, without converting.
+size_t utf16_length_from_utf8(const char *in, size_t n,
+                              const options &o = options());
+size_t utf32_length_from_utf8(const char *in, size_t n,
+                              const options &o = options());
+size_t utf8_length_from_utf16(const char16_t *in, size_t n,
+                              const options &o = options());
+size_t utf32_length_from_utf16(const char16_t *in, size_t n,
+                               const options &o = options());
+size_t utf8_length_from_utf32(const char32_t *in, size_t n,
+                              const options &o = options());
+size_t utf16_length_from_utf32(const char32_t *in, size_t n,
+                               const options &o = options());
+
+} // namespace transcode
+
+#endif // TRANSCODE_H
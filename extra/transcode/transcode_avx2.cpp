@@ -0,0 +1,434 @@
+// The AVX2 back end: 8 characters per vector. Compiled with -mavx2
+// -mpopcnt.
+#include "transcode_kernels.h"
+
+#include <immintrin.h>
+
+namespace transcode {
+namespace {
+
+// For the compression of the 32-bit lanes set in an 8-bit mask:
+// _mm256_permutevar8x32_epi32 with index[mask] (widened) moves them first,
+// in order, and count[mask] counts them.
+struct lane_compression {
+  uint8_t index[256][8];
+  uint8_t count[256];
+
+  constexpr lane_compression() : index(), count() {
+    for (int mask = 0; mask < 256; mask++) {
+      int k = 0;
+      for (int lane = 0; lane < 8; lane++) {
+        if (mask & (1 << lane)) {
+          index[mask][k++] = uint8_t(lane);
+        }
+      }
+      count[mask] = uint8_t(k);
+      for (int lane = k; lane < 8; lane++) {
+        index[mask][lane] = 0;
+      }
+    }
+  }
+};
+
+constexpr lane_compression compression{};
+
+__m256i load(const void *p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
+__m128i load128(const void *p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+void store(void *p, __m256i v) {
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+}
+
+void store128(void *p, __m128i v) {
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+}
+
+// 32 bytes of ASCII
+void widen(const uint8_t *in, uint16_t *out) {
+  store(out, _mm256_cvtepu8_epi16(load128(in)));
+  store(out + 16, _mm256_cvtepu8_epi16(load128(in + 16)));
+}
+
+void widen(const uint8_t *in, uint32_t *out) {
+  for (int k = 0; k < 32; k += 8) {
+    store(out + k, _mm256_cvtepu8_epi32(_mm_loadl_epi64(
+                       reinterpret_cast<const __m128i *>(in + k))));
+  }
+}
+
+// The code points of the characters that would start at in[0, 8), from
+// in[0, 11): each 32-bit lane gets the 4 bytes from its position, and the
+// lead byte gives the length and which bits to keep.
+__m256i decode8(const uint8_t *in, __m256i *lead_length_minus_1) {
+  const __m256i gather = _mm256_setr_epi8(
+      0, 1, 2, 3, 1, 2, 3, 4, 2, 3, 4, 5, 3, 4, 5, 6, //
+      4, 5, 6, 7, 5, 6, 7, 8, 6, 7, 8, 9, 7, 8, 9, 10);
+  const __m256i x =
+      _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(load128(in)), gather);
+  const __m256i b0 = _mm256_and_si256(x, _mm256_set1_epi32(0xFF));
+  const __m256i ge2 = _mm256_cmpgt_epi32(b0, _mm256_set1_epi32(0xBF));
+  const __m256i ge3 = _mm256_cmpgt_epi32(b0, _mm256_set1_epi32(0xDF));
+  const __m256i ge4 = _mm256_cmpgt_epi32(b0, _mm256_set1_epi32(0xEF));
+  // the compare masks are -1
+  const __m256i length_minus_1 = _mm256_sub_epi32(
+      _mm256_setzero_si256(),
+      _mm256_add_epi32(_mm256_add_epi32(ge2, ge3), ge4));
+  // 0x7F, 0x1F, 0x0F, 0x07: 0xFF >> (1, 3, 4, 5)
+  const __m256i keep = _mm256_srlv_epi32(
+      _mm256_set1_epi32(0xFF),
+      _mm256_sub_epi32(
+          _mm256_add_epi32(_mm256_set1_epi32(1), length_minus_1), ge2));
+  // as if 4 bytes long, then shifted into place
+  const __m256i full = _mm256_or_si256(
+      _mm256_or_si256(
+          _mm256_slli_epi32(_mm256_and_si256(b0, keep), 18),
+          _mm256_slli_epi32(
+              _mm256_and_si256(x, _mm256_set1_epi32(0x3F00)), 4)),
+      _mm256_or_si256(
+          _mm256_srli_epi32(
+              _mm256_and_si256(x, _mm256_set1_epi32(0x3F0000)), 10),
+          _mm256_srli_epi32(
+              _mm256_and_si256(x, _mm256_set1_epi32(0x3F000000)), 24)));
+  // 6 * (3 - length_minus_1)
+  const __m256i unused = _mm256_sub_epi32(
+      _mm256_set1_epi32(18),
+      _mm256_add_epi32(_mm256_slli_epi32(length_minus_1, 2),
+                       _mm256_slli_epi32(length_minus_1, 1)));
+  *lead_length_minus_1 = length_minus_1;
+  return _mm256_srlv_epi32(full, unused);
+}
+
+// lanes whose byte is not a continuation byte
+int leads8(const uint8_t *in) {
+  const __m128i bytes =
+      _mm_loadl_epi64(reinterpret_cast<const __m128i *>(in));
+  const __m128i continuation =
+      _mm_cmpeq_epi8(_mm_and_si128(bytes, _mm_set1_epi8(char(0xC0))),
+                     _mm_set1_epi8(char(0x80)));
+  return ~_mm_movemask_epi8(continuation) & 0xFF;
+}
+
+__m256i compress(__m256i v, int mask) {
+  const __m256i index = _mm256_cvtepu8_epi32(_mm_loadl_epi64(
+      reinterpret_cast<const __m128i *>(compression.index[mask])));
+  return _mm256_permutevar8x32_epi32(v, index);
+}
+
+void put8(__m256i code_points, int mask, int count, uint32_t *out) {
+  (void)mask;
+  (void)count;
+  store(out, code_points);
+}
+
+// 8 code points to UTF-16: packed when all are in the BMP; otherwise the
+// ones above U+FFFF become surrogate pairs in their 32-bit lanes and each
+// group of four is packed with a shuffle from utf16_packing. The two
+// stores write up to 16 units.
+void put8(__m256i code_points, int pairs, int count, uint16_t *out) {
+  if (pairs == 0) {
+    const __m256i packed = _mm256_packus_epi32(code_points, code_points);
+    store128(out, _mm256_castsi256_si128(
+                      _mm256_permute4x64_epi64(packed, 0x08)));
+    return;
+  }
+  const __m256i above =
+      _mm256_cmpgt_epi32(code_points, _mm256_set1_epi32(0xFFFF));
+  const int mask =
+      _mm256_movemask_ps(_mm256_castsi256_ps(above)) & ((1 << count) - 1);
+  const __m256i high = _mm256_add_epi32(_mm256_srli_epi32(code_points, 10),
+                                        _mm256_set1_epi32(0xD800 - 0x40));
+  const __m256i low =
+      _mm256_or_si256(_mm256_and_si256(code_points, _mm256_set1_epi32(0x3FF)),
+                      _mm256_set1_epi32(0xDC00));
+  const __m256i units = _mm256_blendv_epi8(
+      code_points, _mm256_or_si256(high, _mm256_slli_epi32(low, 16)), above);
+  const __m256i shuffle = _mm256_inserti128_si256(
+      _mm256_castsi128_si256(load128(pair_packing.shuffle[mask & 15])),
+      load128(pair_packing.shuffle[mask >> 4]), 1);
+  const __m256i packed = _mm256_shuffle_epi8(units, shuffle);
+  store128(out, _mm256_castsi256_si128(packed));
+  store128(out + pair_packing.length[mask & 15],
+           _mm256_extracti128_si256(packed, 1));
+}
+
+// The vector loop stores 8 units (the garbage after the real ones is
+// overwritten later) and stops 40 bytes before the end: the valid UTF-8
+// after the window holds more than 8 characters, so the stores stay within
+// the output; 16 units with surrogate pairs, 72 bytes before the end. On
+// invalid input they stay within the n (UTF-32) or 2n (UTF-16) units of
+// the bound.
+template <class Out>
+size_t valid_utf8_to(const uint8_t *in, size_t n, Out *out) {
+  size_t i = 0, o = 0;
+  while (i + 48 <= n) {
+    if (_mm256_movemask_epi8(load(in + i)) == 0) {
+      widen(in + i, out + o);
+      i += 32;
+      o += 32;
+      continue;
+    }
+    __m256i length_minus_1;
+    const __m256i code_points = decode8(in + i, &length_minus_1);
+    const int mask = leads8(in + i);
+    const int count = compression.count[mask];
+    // leads of 4 bytes, which need surrogate pairs in UTF-16
+    const int pairs =
+        _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(
+            length_minus_1, _mm256_set1_epi32(3)))) & mask;
+    if (sizeof(Out) == 2 && pairs != 0 && i + 80 > n) {
+      // put8 could write past an output of the exact length
+      break;
+    }
+    put8(compress(code_points, mask), pairs, count, out + o);
+    o += sizeof(Out) == 4 ? size_t(count)
+                          : size_t(count + _mm_popcnt_u32(unsigned(pairs)));
+    i += 8;
+  }
+  return from_utf8(in, i, n, n, out, o).out;
+}
+
+// Encodes 8 code points as UTF-8 at out + o: each 32-bit lane gets the
+// bytes of its code point in order, and each group of four is packed with
+// a shuffle from utf8_packing. The two 16-byte stores write up to 12 bytes
+// of garbage after the real ones.
+size_t encode8(__m256i c, uint8_t *out) {
+  const __m256i ge2 = _mm256_cmpgt_epi32(c, _mm256_set1_epi32(0x7F));
+  const __m256i ge3 = _mm256_cmpgt_epi32(c, _mm256_set1_epi32(0x7FF));
+  const __m256i ge4 = _mm256_cmpgt_epi32(c, _mm256_set1_epi32(0xFFFF));
+  const __m256i length_minus_1 = _mm256_sub_epi32(
+      _mm256_setzero_si256(),
+      _mm256_add_epi32(_mm256_add_epi32(ge2, ge3), ge4));
+  const __m256i low6 = _mm256_set1_epi32(0x3F);
+  // the 3 continuation bytes a 4-byte character would have, in order
+  const __m256i continuations = _mm256_or_si256(
+      _mm256_set1_epi32(0x808080),
+      _mm256_or_si256(
+          _mm256_and_si256(_mm256_srli_epi32(c, 12), low6),
+          _mm256_or_si256(
+              _mm256_slli_epi32(
+                  _mm256_and_si256(_mm256_srli_epi32(c, 6), low6), 8),
+              _mm256_slli_epi32(_mm256_and_si256(c, low6), 16))));
+  // the last length - 1 of them: shifted by 8 * (3 - length_minus_1)
+  const __m256i kept = _mm256_srlv_epi32(
+      continuations,
+      _mm256_slli_epi32(
+          _mm256_sub_epi32(_mm256_set1_epi32(3), length_minus_1), 3));
+  const __m256i prefixes =
+      _mm256_setr_epi32(0x00, 0xC0, 0xE0, 0xF0, 0, 0, 0, 0);
+  const __m256i first = _mm256_or_si256(
+      _mm256_permutevar8x32_epi32(prefixes, length_minus_1),
+      _mm256_srlv_epi32(
+          c, _mm256_add_epi32(_mm256_slli_epi32(length_minus_1, 2),
+                              _mm256_slli_epi32(length_minus_1, 1))));
+  const __m256i bytes = _mm256_or_si256(first, _mm256_slli_epi32(kept, 8));
+  // the index of utf8_packing: bit 0 of length - 1 is ge2 ^ ge3 ^ ge4,
+  // bit 1 is ge3
+  const int m2 = _mm256_movemask_ps(_mm256_castsi256_ps(ge2));
+  const int m3 = _mm256_movemask_ps(_mm256_castsi256_ps(ge3));
+  const int m4 = _mm256_movemask_ps(_mm256_castsi256_ps(ge4));
+  const int odd = m2 ^ m3 ^ m4;
+  const int low = spread[odd & 15] | (spread[m3 & 15] << 1);
+  const int high = spread[odd >> 4] | (spread[m3 >> 4] << 1);
+  const __m256i shuffle = _mm256_inserti128_si256(
+      _mm256_castsi128_si256(load128(packing.shuffle[low])),
+      load128(packing.shuffle[high]), 1);
+  const __m256i packed = _mm256_shuffle_epi8(bytes, shuffle);
+  store128(out, _mm256_castsi256_si128(packed));
+  store128(out + packing.length[low], _mm256_extracti128_si256(packed, 1));
+  return packing.length[low] + packing.length[high];
+}
+
+bool has_surrogates(__m128i units) {
+  const __m128i surrogates =
+      _mm_cmpeq_epi16(_mm_and_si128(units, _mm_set1_epi16(short(0xF800))),
+                      _mm_set1_epi16(short(0xD800)));
+  return _mm_movemask_epi8(surrogates) != 0;
+}
+
+// The code points of in[0, 8) with surrogates, compressed, with zeros
+// after the *count real ones; in[8] may complete a pair. False if a
+// surrogate is unpaired.
+bool decode_pairs8(const uint16_t *in, __m256i *code_points, int *count,
+                   int *units) {
+  const __m256i u = _mm256_cvtepu16_epi32(load128(in));
+  const __m256i next = _mm256_cvtepu16_epi32(load128(in + 1));
+  const __m256i kind = _mm256_and_si256(u, _mm256_set1_epi32(0xFC00));
+  const __m256i high = _mm256_cmpeq_epi32(kind, _mm256_set1_epi32(0xD800));
+  const __m256i low = _mm256_cmpeq_epi32(kind, _mm256_set1_epi32(0xDC00));
+  uint32_t starts;
+  if (!pair_surrogates(
+          uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(high))),
+          uint32_t(_mm256_movemask_ps(_mm256_castsi256_ps(low))), 8, units,
+          &starts)) {
+    return false;
+  }
+  // 0x10000 + (u - 0xD800) * 0x400 + (next - 0xDC00)
+  const __m256i pairs = _mm256_add_epi32(
+      _mm256_slli_epi32(u, 10),
+      _mm256_sub_epi32(next, _mm256_set1_epi32((0xD800 << 10) + 0xDC00 -
+                                               0x10000)));
+  *count = compression.count[starts];
+  *code_points = _mm256_and_si256(
+      compress(_mm256_blendv_epi8(u, pairs, high), int(starts)),
+      _mm256_cmpgt_epi32(_mm256_set1_epi32(*count),
+                         _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)));
+  return true;
+}
+
+// 16 units of ASCII are packed; 8 units are decoded (with their surrogate
+// pairs) and encoded together; errors go one character at a time. The
+// loop stops 32 units before the end: each unit makes at least a byte,
+// which covers the garbage of encode8.
+template <bool Validate>
+position utf16_to_utf8(const uint16_t *in, size_t n, uint8_t *out) {
+  size_t i = 0, o = 0;
+  while (i + 32 <= n) {
+    const __m256i units = load(in + i);
+    if (_mm256_testz_si256(units, _mm256_set1_epi16(short(0xFF80)))) {
+      store128(out + o, _mm_packus_epi16(_mm256_castsi256_si128(units),
+                                         _mm256_extracti128_si256(units, 1)));
+      i += 16;
+      o += 16;
+      continue;
+    }
+    const __m128i half = _mm256_castsi256_si128(units);
+    if (!has_surrogates(half)) {
+      o += encode8(_mm256_cvtepu16_epi32(half), out + o);
+      i += 8;
+      continue;
+    }
+    __m256i code_points;
+    int count, taken;
+    if (decode_pairs8(in + i, &code_points, &count, &taken)) {
+      // the zeros after the real code points make a byte each
+      o += encode8(code_points, out + o) - (8 - count);
+      i += size_t(taken);
+      continue;
+    }
+    const position p = from_utf16<Validate>(in, i, i + 8, n, out, o);
+    if (!p.valid) {
+      return p;
+    }
+    i = p.in;
+    o = p.out;
+  }
+  return from_utf16<Validate>(in, i, n, n, out, o);
+}
+
+// With surrogate pairs, the code points are stored with a mask: the stores
+// are exact.
+template <bool Validate>
+position utf16_to_utf32(const uint16_t *in, size_t n, uint32_t *out) {
+  size_t i = 0, o = 0;
+  while (i + 16 <= n) {
+    const __m128i units = load128(in + i);
+    if (!has_surrogates(units)) {
+      store(out + o, _mm256_cvtepu16_epi32(units));
+      i += 8;
+      o += 8;
+      continue;
+    }
+    __m256i code_points;
+    int count, taken;
+    if (decode_pairs8(in + i, &code_points, &count, &taken)) {
+      _mm256_maskstore_epi32(
+          reinterpret_cast<int *>(out + o),
+          _mm256_cmpgt_epi32(_mm256_set1_epi32(count),
+                             _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)),
+          code_points);
+      i += size_t(taken);
+      o += size_t(count);
+      continue;
+    }
+    const position p = from_utf16<Validate>(in, i, i + 8, n, out, o);
+    if (!p.valid) {
+      return p;
+    }
+    i = p.in;
+    o = p.out;
+  }
+  return from_utf16<Validate>(in, i, n, n, out, o);
+}
+
+// code points above U+10FFFF or surrogates
+bool invalid8(__m256i c) {
+  const __m256i too_large = _mm256_xor_si256(
+      _mm256_cmpeq_epi32(_mm256_max_epu32(c, _mm256_set1_epi32(0x10FFFF)),
+                         _mm256_set1_epi32(0x10FFFF)),
+      _mm256_set1_epi32(-1));
+  const __m256i surrogate = _mm256_cmpeq_epi32(
+      _mm256_and_si256(c, _mm256_set1_epi32(int(0xFFFFF800))),
+      _mm256_set1_epi32(0xD800));
+  return !_mm256_testz_si256(_mm256_or_si256(too_large, surrogate),
+                             _mm256_set1_epi32(-1));
+}
+
+// As utf16_to_utf8: each code point makes at least a byte.
+template <bool Validate>
+position utf32_to_utf8(const uint32_t *in, size_t n, uint8_t *out) {
+  size_t i = 0, o = 0;
+  while (i + 24 <= n) {
+    const __m256i c = load(in + i);
+    if (Validate && invalid8(c)) {
+      return from_utf32<true>(in, i, i + 8, out, o);
+    }
+    o += encode8(c, out + o);
+    i += 8;
+  }
+  return from_utf32<Validate>(in, i, n, out, o);
+}
+
+template <bool Validate>
+position utf32_to_utf16(const uint32_t *in, size_t n, uint16_t *out) {
+  size_t i = 0, o = 0;
+  while (i + 8 <= n) {
+    const __m256i c = load(in + i);
+    const bool bmp =
+        _mm256_testz_si256(c, _mm256_set1_epi32(int(0xFFFF0000)));
+    if (bmp && !(Validate && invalid8(c))) {
+      put8(c, 0, 8, out + o);
+      i += 8;
+      o += 8;
+      continue;
+    }
+    // with surrogate pairs, 16 units: 16 code points after the window
+    // cover them
+    if (i + 24 <= n && !(Validate && invalid8(c))) {
+      put8(c, 1, 8, out + o);
+      i += 8;
+      o += 8 + size_t(_mm_popcnt_u32(unsigned(_mm256_movemask_ps(
+                   _mm256_castsi256_ps(_mm256_cmpgt_epi32(
+                       c, _mm256_set1_epi32(0xFFFF)))))));
+      continue;
+    }
+    const position p = from_utf32<Validate>(in, i, i + 8, out, o);
+    if (!p.valid) {
+      return p;
+    }
+    i = p.in;
+    o = p.out;
+  }
+  return from_utf32<Validate>(in, i, n, out, o);
+}
+
+} // namespace
+
+const functions &avx2_functions() {
+  static const functions avx2 = {
+      valid_utf8_to<uint16_t>, valid_utf8_to<uint32_t>,
+      utf16_to_utf8<true>,     utf16_to_utf8<false>,
+      utf16_to_utf32<true>,    utf16_to_utf32<false>,
+      utf32_to_utf8<true>,     utf32_to_utf8<false>,
+      utf32_to_utf16<true>,    utf32_to_utf16<false>,
+      utf16_length_from_utf8,  utf32_length_from_utf8,
+      utf8_length_from_utf16,  utf32_length_from_utf16,
+      utf8_length_from_utf32,  utf16_length_from_utf32};
+  return avx2;
+}
+
+} // namespace transcode
@@ -0,0 +1,406 @@
+// The AVX-512 back end: 16 characters per vector, with the compression of
+// AVX-512F and the byte shuffles of AVX-512BW. Compiled with -mavx512f
+// -mavx512bw -mpopcnt.
+#include "transcode_kernels.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+
+namespace transcode {
+namespace {
+
+__m512i load(const void *p) { return _mm512_loadu_si512(p); }
+
+__m256i load256(const void *p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+}
+
+__m128i load128(const void *p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+}
+
+void store(void *p, __m512i v) { _mm512_storeu_si512(p, v); }
+
+void store256(void *p, __m256i v) {
+  _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v);
+}
+
+void store128(void *p, __m128i v) {
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v);
+}
+
+// 64 bytes of ASCII
+void widen(const uint8_t *in, uint16_t *out) {
+  store(out, _mm512_cvtepu8_epi16(load256(in)));
+  store(out + 32, _mm512_cvtepu8_epi16(load256(in + 32)));
+}
+
+void widen(const uint8_t *in, uint32_t *out) {
+  for (int k = 0; k < 64; k += 16) {
+    store(out + k, _mm512_cvtepu8_epi32(load128(in + k)));
+  }
+}
+
+// The code points of the characters that would start at in[0, 16), from
+// in[0, 19): lane k of 16 bytes gets in[4k, 4k + 16), then each 32-bit
+// lane the 4 bytes from its position, as in transcode_avx2.cpp.
+__m512i decode16(const uint8_t *in, __m512i *lead_length_minus_1) {
+  const __m512i lanes = _mm512_permutexvar_epi32(
+      _mm512_setr_epi32(0, 1, 2, 3, 1, 2, 3, 4, 2, 3, 4, 5, 3, 4, 5, 6),
+      _mm512_zextsi256_si512(load256(in)));
+  const __m512i gather = _mm512_broadcast_i32x4(
+      _mm_setr_epi8(0, 1, 2, 3, 1, 2, 3, 4, 2, 3, 4, 5, 3, 4, 5, 6));
+  const __m512i x = _mm512_shuffle_epi8(lanes, gather);
+  const __m512i b0 = _mm512_and_si512(x, _mm512_set1_epi32(0xFF));
+  const __m512i one = _mm512_set1_epi32(1);
+  const __mmask16 ge2 = _mm512_cmpgt_epu32_mask(b0, _mm512_set1_epi32(0xBF));
+  const __mmask16 ge3 = _mm512_cmpgt_epu32_mask(b0, _mm512_set1_epi32(0xDF));
+  const __mmask16 ge4 = _mm512_cmpgt_epu32_mask(b0, _mm512_set1_epi32(0xEF));
+  const __m512i length_minus_1 = _mm512_add_epi32(
+      _mm512_add_epi32(_mm512_maskz_mov_epi32(ge2, one),
+                       _mm512_maskz_mov_epi32(ge3, one)),
+      _mm512_maskz_mov_epi32(ge4, one));
+  // 0x7F, 0x1F, 0x0F, 0x07: 0xFF >> (1, 3, 4, 5)
+  const __m512i keep = _mm512_srlv_epi32(
+      _mm512_set1_epi32(0xFF),
+      _mm512_mask_add_epi32(_mm512_add_epi32(one, length_minus_1), ge2,
+                            _mm512_add_epi32(one, length_minus_1), one));
+  const __m512i full = _mm512_or_si512(
+      _mm512_or_si512(
+          _mm512_slli_epi32(_mm512_and_si512(b0, keep), 18),
+          _mm512_slli_epi32(
+              _mm512_and_si512(x, _mm512_set1_epi32(0x3F00)), 4)),
+      _mm512_or_si512(
+          _mm512_srli_epi32(
+              _mm512_and_si512(x, _mm512_set1_epi32(0x3F0000)), 10),
+          _mm512_srli_epi32(
+              _mm512_and_si512(x, _mm512_set1_epi32(0x3F000000)), 24)));
+  // 6 * (3 - length_minus_1)
+  const __m512i unused = _mm512_sub_epi32(
+      _mm512_set1_epi32(18),
+      _mm512_add_epi32(_mm512_slli_epi32(length_minus_1, 2),
+                       _mm512_slli_epi32(length_minus_1, 1)));
+  *lead_length_minus_1 = length_minus_1;
+  return _mm512_srlv_epi32(full, unused);
+}
+
+// lanes whose byte is not a continuation byte
+__mmask16 leads16(const uint8_t *in) {
+  const __m128i bytes = load128(in);
+  const __m128i continuation = _mm_cmpeq_epi8(
+      _mm_and_si128(bytes, _mm_set1_epi8(char(0xC0))),
+      _mm_set1_epi8(char(0x80)));
+  return __mmask16(~_mm_movemask_epi8(continuation));
+}
+
+void put16(__m512i code_points, __mmask16 pairs, int count, uint32_t *out) {
+  (void)pairs;
+  (void)count;
+  store(out, code_points);
+}
+
+// 16 code points to UTF-16, as put8 of transcode_avx2.cpp: the four
+// stores of groups of four write up to 32 units.
+void put16(__m512i code_points, __mmask16 pairs, int count, uint16_t *out) {
+  if (pairs == 0) {
+    store256(out, _mm512_cvtepi32_epi16(code_points));
+    return;
+  }
+  const __mmask16 above =
+      _mm512_cmpgt_epu32_mask(code_points, _mm512_set1_epi32(0xFFFF));
+  const unsigned mask = above & ((1u << count) - 1);
+  const __m512i high = _mm512_add_epi32(_mm512_srli_epi32(code_points, 10),
+                                        _mm512_set1_epi32(0xD800 - 0x40));
+  const __m512i low =
+      _mm512_or_si512(_mm512_and_si512(code_points, _mm512_set1_epi32(0x3FF)),
+                      _mm512_set1_epi32(0xDC00));
+  const __m512i units = _mm512_mask_blend_epi32(
+      above, code_points, _mm512_or_si512(high, _mm512_slli_epi32(low, 16)));
+  int index[4];
+  for (int lane = 0; lane < 4; lane++) {
+    index[lane] = (mask >> (4 * lane)) & 15;
+  }
+  __m512i shuffle =
+      _mm512_castsi128_si512(load128(pair_packing.shuffle[index[0]]));
+  shuffle =
+      _mm512_inserti32x4(shuffle, load128(pair_packing.shuffle[index[1]]), 1);
+  shuffle =
+      _mm512_inserti32x4(shuffle, load128(pair_packing.shuffle[index[2]]), 2);
+  shuffle =
+      _mm512_inserti32x4(shuffle, load128(pair_packing.shuffle[index[3]]), 3);
+  const __m512i packed = _mm512_shuffle_epi8(units, shuffle);
+  store128(out, _mm512_castsi512_si128(packed));
+  out += pair_packing.length[index[0]];
+  store128(out, _mm512_extracti32x4_epi32(packed, 1));
+  out += pair_packing.length[index[1]];
+  store128(out, _mm512_extracti32x4_epi32(packed, 2));
+  out += pair_packing.length[index[2]];
+  store128(out, _mm512_extracti32x4_epi32(packed, 3));
+}
+
+// As in transcode_avx2.cpp, with vectors of 16 code points: the vector
+// loop stops 80 bytes before the end, 144 with surrogate pairs.
+template <class Out>
+size_t valid_utf8_to(const uint8_t *in, size_t n, Out *out) {
+  size_t i = 0, o = 0;
+  while (i + 96 <= n) {
+    if (_mm512_movepi8_mask(load(in + i)) == 0) {
+      widen(in + i, out + o);
+      i += 64;
+      o += 64;
+      continue;
+    }
+    __m512i length_minus_1;
+    const __m512i code_points = decode16(in + i, &length_minus_1);
+    const __mmask16 mask = leads16(in + i);
+    const int count = _mm_popcnt_u32(mask);
+    // leads of 4 bytes, which need surrogate pairs in UTF-16
+    const __mmask16 pairs = _mm512_mask_cmpeq_epi32_mask(
+        mask, length_minus_1, _mm512_set1_epi32(3));
+    if (sizeof(Out) == 2 && pairs != 0 && i + 160 > n) {
+      // put16 could write past an output of the exact length
+      break;
+    }
+    put16(_mm512_maskz_compress_epi32(mask, code_points), pairs, count,
+          out + o);
+    o += sizeof(Out) == 4 ? size_t(count)
+                          : size_t(count + _mm_popcnt_u32(pairs));
+    i += 16;
+  }
+  return from_utf8(in, i, n, n, out, o).out;
+}
+
+// Encodes 16 code points as UTF-8 at out + o, as encode8 of
+// transcode_avx2.cpp: the four 16-byte stores write up to 12 bytes of
+// garbage after the real ones.
+size_t encode16(__m512i c, uint8_t *out) {
+  const __mmask16 ge2 = _mm512_cmpgt_epu32_mask(c, _mm512_set1_epi32(0x7F));
+  const __mmask16 ge3 = _mm512_cmpgt_epu32_mask(c, _mm512_set1_epi32(0x7FF));
+  const __mmask16 ge4 =
+      _mm512_cmpgt_epu32_mask(c, _mm512_set1_epi32(0xFFFF));
+  const __m512i one = _mm512_set1_epi32(1);
+  const __m512i length_minus_1 = _mm512_add_epi32(
+      _mm512_add_epi32(_mm512_maskz_mov_epi32(ge2, one),
+                       _mm512_maskz_mov_epi32(ge3, one)),
+      _mm512_maskz_mov_epi32(ge4, one));
+  const __m512i low6 = _mm512_set1_epi32(0x3F);
+  // the 3 continuation bytes a 4-byte character would have, in order
+  const __m512i continuations = _mm512_or_si512(
+      _mm512_set1_epi32(0x808080),
+      _mm512_or_si512(
+          _mm512_and_si512(_mm512_srli_epi32(c, 12), low6),
+          _mm512_or_si512(
+              _mm512_slli_epi32(
+                  _mm512_and_si512(_mm512_srli_epi32(c, 6), low6), 8),
+              _mm512_slli_epi32(_mm512_and_si512(c, low6), 16))));
+  // the last length - 1 of them: shifted by 8 * (3 - length_minus_1)
+  const __m512i kept = _mm512_srlv_epi32(
+      continuations,
+      _mm512_slli_epi32(
+          _mm512_sub_epi32(_mm512_set1_epi32(3), length_minus_1), 3));
+  const __m512i prefixes = _mm512_setr_epi32(0x00, 0xC0, 0xE0, 0xF0, 0, 0,
+                                             0, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m512i first = _mm512_or_si512(
+      _mm512_permutexvar_epi32(length_minus_1, prefixes),
+      _mm512_srlv_epi32(
+          c, _mm512_add_epi32(_mm512_slli_epi32(length_minus_1, 2),
+                              _mm512_slli_epi32(length_minus_1, 1))));
+  const __m512i bytes = _mm512_or_si512(first, _mm512_slli_epi32(kept, 8));
+  // the indexes of utf8_packing: bit 0 of length - 1 is ge2 ^ ge3 ^ ge4,
+  // bit 1 is ge3
+  const unsigned odd = unsigned(ge2 ^ ge3 ^ ge4);
+  const unsigned m3 = ge3;
+  int index[4];
+  for (int lane = 0; lane < 4; lane++) {
+    index[lane] = spread[(odd >> (4 * lane)) & 15] |
+                  (spread[(m3 >> (4 * lane)) & 15] << 1);
+  }
+  __m512i shuffle = _mm512_castsi128_si512(load128(packing.shuffle[index[0]]));
+  shuffle = _mm512_inserti32x4(shuffle, load128(packing.shuffle[index[1]]), 1);
+  shuffle = _mm512_inserti32x4(shuffle, load128(packing.shuffle[index[2]]), 2);
+  shuffle = _mm512_inserti32x4(shuffle, load128(packing.shuffle[index[3]]), 3);
+  const __m512i packed = _mm512_shuffle_epi8(bytes, shuffle);
+  size_t length = 0;
+  store128(out, _mm512_castsi512_si128(packed));
+  length += packing.length[index[0]];
+  store128(out + length, _mm512_extracti32x4_epi32(packed, 1));
+  length += packing.length[index[1]];
+  store128(out + length, _mm512_extracti32x4_epi32(packed, 2));
+  length += packing.length[index[2]];
+  store128(out + length, _mm512_extracti32x4_epi32(packed, 3));
+  return length + packing.length[index[3]];
+}
+
+bool has_surrogates(__m256i units) {
+  return _mm256_movemask_epi8(_mm256_cmpeq_epi16(
+             _mm256_and_si256(units, _mm256_set1_epi16(short(0xF800))),
+             _mm256_set1_epi16(short(0xD800)))) != 0;
+}
+
+// As decode_pairs8 of transcode_avx2.cpp, over in[0, 17).
+bool decode_pairs16(const uint16_t *in, __m512i *code_points, int *count,
+                    int *units) {
+  const __m512i u = _mm512_cvtepu16_epi32(load256(in));
+  const __m512i next = _mm512_cvtepu16_epi32(load256(in + 1));
+  const __m512i kind = _mm512_and_si512(u, _mm512_set1_epi32(0xFC00));
+  const __mmask16 high =
+      _mm512_cmpeq_epi32_mask(kind, _mm512_set1_epi32(0xD800));
+  const __mmask16 low =
+      _mm512_cmpeq_epi32_mask(kind, _mm512_set1_epi32(0xDC00));
+  uint32_t starts;
+  if (!pair_surrogates(high, low, 16, units, &starts)) {
+    return false;
+  }
+  const __m512i pairs = _mm512_add_epi32(
+      _mm512_slli_epi32(u, 10),
+      _mm512_sub_epi32(next, _mm512_set1_epi32((0xD800 << 10) + 0xDC00 -
+                                               0x10000)));
+  *count = _mm_popcnt_u32(starts);
+  *code_points = _mm512_maskz_compress_epi32(
+      __mmask16(starts), _mm512_mask_blend_epi32(high, u, pairs));
+  return true;
+}
+
+// As in transcode_avx2.cpp: 32 units of ASCII are packed, 16 decoded (with
+// their surrogate pairs) and encoded together.
+template <bool Validate>
+position utf16_to_utf8(const uint16_t *in, size_t n, uint8_t *out) {
+  size_t i = 0, o = 0;
+  while (i + 48 <= n) {
+    const __m512i units = load(in + i);
+    if (_mm512_test_epi16_mask(units, _mm512_set1_epi16(short(0xFF80))) ==
+        0) {
+      store256(out + o, _mm512_cvtepi16_epi8(units));
+      i += 32;
+      o += 32;
+      continue;
+    }
+    const __m256i half = _mm512_castsi512_si256(units);
+    if (!has_surrogates(half)) {
+      o += encode16(_mm512_cvtepu16_epi32(half), out + o);
+      i += 16;
+      continue;
+    }
+    __m512i code_points;
+    int count, taken;
+    if (decode_pairs16(in + i, &code_points, &count, &taken)) {
+      // the zeros after the real code points make a byte each
+      o += encode16(code_points, out + o) - (16 - count);
+      i += size_t(taken);
+      continue;
+    }
+    const position p = from_utf16<Validate>(in, i, i + 16, n, out, o);
+    if (!p.valid) {
+      return p;
+    }
+    i = p.in;
+    o = p.out;
+  }
+  return from_utf16<Validate>(in, i, n, n, out, o);
+}
+
+template <bool Validate>
+position utf16_to_utf32(const uint16_t *in, size_t n, uint32_t *out) {
+  size_t i = 0, o = 0;
+  while (i + 32 <= n) {
+    const __m256i units = load256(in + i);
+    if (!has_surrogates(units)) {
+      store(out + o, _mm512_cvtepu16_epi32(units));
+      i += 16;
+      o += 16;
+      continue;
+    }
+    __m512i code_points;
+    int count, taken;
+    if (decode_pairs16(in + i, &code_points, &count, &taken)) {
+      _mm512_mask_storeu_epi32(out + o, __mmask16((1u << count) - 1),
+                               code_points);
+      i += size_t(taken);
+      o += size_t(count);
+      continue;
+    }
+    const position p = from_utf16<Validate>(in, i, i + 16, n, out, o);
+    if (!p.valid) {
+      return p;
+    }
+    i = p.in;
+    o = p.out;
+  }
+  return from_utf16<Validate>(in, i, n, n, out, o);
+}
+
+// code points above U+10FFFF or surrogates
+bool invalid16(__m512i c) {
+  const __mmask16 too_large =
+      _mm512_cmpgt_epu32_mask(c, _mm512_set1_epi32(0x10FFFF));
+  const __mmask16 surrogate = _mm512_cmpeq_epi32_mask(
+      _mm512_and_si512(c, _mm512_set1_epi32(int(0xFFFFF800))),
+      _mm512_set1_epi32(0xD800));
+  return (too_large | surrogate) != 0;
+}
+
+template <bool Validate>
+position utf32_to_utf8(const uint32_t *in, size_t n, uint8_t *out) {
+  size_t i = 0, o = 0;
+  while (i + 32 <= n) {
+    const __m512i c = load(in + i);
+    if (Validate && invalid16(c)) {
+      return from_utf32<true>(in, i, i + 16, out, o);
+    }
+    o += encode16(c, out + o);
+    i += 16;
+  }
+  return from_utf32<Validate>(in, i, n, out, o);
+}
+
+template <bool Validate>
+position utf32_to_utf16(const uint32_t *in, size_t n, uint16_t *out) {
+  size_t i = 0, o = 0;
+  while (i + 16 <= n) {
+    const __m512i c = load(in + i);
+    const bool bmp =
+        _mm512_test_epi32_mask(c, _mm512_set1_epi32(int(0xFFFF0000))) == 0;
+    if (bmp && !(Validate && invalid16(c))) {
+      store256(out + o, _mm512_cvtepi32_epi16(c));
+      i += 16;
+      o += 16;
+      continue;
+    }
+    // with surrogate pairs, 32 units: 32 code points after the window
+    // cover them
+    if (i + 48 <= n && !(Validate && invalid16(c))) {
+      put16(c, 1, 16, out + o);
+      i += 16;
+      o += 16 + size_t(_mm_popcnt_u32(
+                    _mm512_cmpgt_epu32_mask(c, _mm512_set1_epi32(0xFFFF))));
+      continue;
+    }
+    const position p = from_utf32<Validate>(in, i, i + 16, out, o);
+    if (!p.valid) {
+      return p;
+    }
+    i = p.in;
+    o = p.out;
+  }
+  return from_utf32<Validate>(in, i, n, out, o);
+}
+
+} // namespace
+
+const functions &avx512_functions() {
+  static const functions avx512 = {
+      valid_utf8_to<uint16_t>, valid_utf8_to<uint32_t>,
+      utf16_to_utf8<true>,     utf16_to_utf8<false>,
+      utf16_to_utf32<true>,    utf16_to_utf32<false>,
+      utf32_to_utf8<true>,     utf32_to_utf8<false>,
+      utf32_to_utf16<true>,    utf32_to_utf16<false>,
+      utf16_length_from_utf8,  utf32_length_from_utf8,
+      utf8_length_from_utf16,  utf32_length_from_utf16,
+      utf8_length_from_utf32,  utf16_length_from_utf32};
+  return avx512;
+}
+
+} // namespace transcode
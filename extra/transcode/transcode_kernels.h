@@ -0,0 +1,300 @@
+// The functions of each back end, the conversions one character at a time
+// that all of them share, and the tables of the vector back ends. Only the
+// transcode*.cpp files include this header.
+#ifndef TRANSCODE_KERNELS_H
+#define TRANSCODE_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "transcode.h"
+
+namespace transcode {
+
+// Where a conversion stopped: the input and output offsets, and whether
+// the input was valid (otherwise in is the offset of the bad character).
+struct position {
+  size_t in;
+  size_t out;
+  bool valid;
+};
+
+// The UTF-8 converters take valid input (the callers validate it with
+// extra/utf8validate first); the others validate unless their name starts
+// with valid_.
+struct functions {
+  size_t (*valid_utf8_to_utf16)(const uint8_t *in, size_t n, uint16_t *out);
+  size_t (*valid_utf8_to_utf32)(const uint8_t *in, size_t n, uint32_t *out);
+  position (*utf16_to_utf8)(const uint16_t *in, size_t n, uint8_t *out);
+  position (*valid_utf16_to_utf8)(const uint16_t *in, size_t n, uint8_t *out);
+  position (*utf16_to_utf32)(const uint16_t *in, size_t n, uint32_t *out);
+  position (*valid_utf16_to_utf32)(const uint16_t *in, size_t n,
+                                   uint32_t *out);
+  position (*utf32_to_utf8)(const uint32_t *in, size_t n, uint8_t *out);
+  position (*valid_utf32_to_utf8)(const uint32_t *in, size_t n, uint8_t *out);
+  position (*utf32_to_utf16)(const uint32_t *in, size_t n, uint16_t *out);
+  position (*valid_utf32_to_utf16)(const uint32_t *in, size_t n,
+                                   uint16_t *out);
+  size_t (*utf16_length_from_utf8)(const uint8_t *in, size_t n);
+  size_t (*utf32_length_from_utf8)(const uint8_t *in, size_t n);
+  size_t (*utf8_length_from_utf16)(const uint16_t *in, size_t n);
+  size_t (*utf32_length_from_utf16)(const uint16_t *in, size_t n);
+  size_t (*utf8_length_from_utf32)(const uint32_t *in, size_t n);
+  size_t (*utf16_length_from_utf32)(const uint32_t *in, size_t n);
+};
+
+const functions &scalar_functions();
+const functions &avx2_functions();
+const functions &avx512_functions();
+
+// In an unnamed namespace: each back end compiles its own copy with its
+// own instruction sets, so that the linker cannot pick the AVX2 copy for
+// the scalar back end.
+namespace {
+
+// Writes the code point c and returns the units written. Values above
+// U+10FFFF give 4 bytes or 2 units of garbage.
+inline size_t put(uint32_t c, uint8_t *out) {
+  if (c < 0x80) {
+    out[0] = uint8_t(c);
+    return 1;
+  }
+  if (c < 0x800) {
+    out[0] = uint8_t(0xC0 | (c >> 6));
+    out[1] = uint8_t(0x80 | (c & 0x3F));
+    return 2;
+  }
+  if (c < 0x10000) {
+    out[0] = uint8_t(0xE0 | (c >> 12));
+    out[1] = uint8_t(0x80 | ((c >> 6) & 0x3F));
+    out[2] = uint8_t(0x80 | (c & 0x3F));
+    return 3;
+  }
+  out[0] = uint8_t(0xF0 | ((c >> 18) & 0x07));
+  out[1] = uint8_t(0x80 | ((c >> 12) & 0x3F));
+  out[2] = uint8_t(0x80 | ((c >> 6) & 0x3F));
+  out[3] = uint8_t(0x80 | (c & 0x3F));
+  return 4;
+}
+
+inline size_t put(uint32_t c, uint16_t *out) {
+  if (c < 0x10000) {
+    out[0] = uint16_t(c);
+    return 1;
+  }
+  c -= 0x10000;
+  out[0] = uint16_t(0xD800 | ((c >> 10) & 0x3FF));
+  out[1] = uint16_t(0xDC00 | (c & 0x3FF));
+  return 2;
+}
+
+inline size_t put(uint32_t c, uint32_t *out) {
+  out[0] = c;
+  return 1;
+}
+
+// The conversions of the characters that start in in[i, stop), which may
+// end in in[stop, n), to out + o.
+
+// Continuation bytes where a character should start are skipped, and a
+// character cut short by the end ends the conversion.
+template <class Out>
+position from_utf8(const uint8_t *in, size_t i, size_t stop, size_t n,
+                   Out *out, size_t o) {
+  while (i < stop) {
+    const uint8_t b = in[i];
+    if (b < 0x80) {
+      out[o++] = b;
+      i++;
+      continue;
+    }
+    if (b < 0xC0) {
+      i++;
+      continue;
+    }
+    const size_t length = b < 0xE0 ? 2 : b < 0xF0 ? 3 : 4;
+    if (i + length > n) {
+      break;
+    }
+    uint32_t c = b & (0x7F >> length);
+    for (size_t k = 1; k < length; k++) {
+      c = (c << 6) | (in[i + k] & 0x3F);
+    }
+    o += put(c, out + o);
+    i += length;
+  }
+  return position{i, o, true};
+}
+
+// Without validation, an unpaired surrogate is converted as it is.
+template <bool Validate, class Out>
+position from_utf16(const uint16_t *in, size_t i, size_t stop, size_t n,
+                    Out *out, size_t o) {
+  while (i < stop) {
+    const uint32_t u = in[i];
+    if ((u & 0xF800) != 0xD800) {
+      o += put(u, out + o);
+      i++;
+    } else if (u < 0xDC00 && i + 1 < n && (in[i + 1] & 0xFC00) == 0xDC00) {
+      o += put(0x10000 + ((u - 0xD800) << 10) + (in[i + 1] - 0xDC00),
+               out + o);
+      i += 2;
+    } else if (Validate) {
+      return position{i, o, false};
+    } else {
+      o += put(u, out + o);
+      i++;
+    }
+  }
+  return position{i, o, true};
+}
+
+template <bool Validate, class Out>
+position from_utf32(const uint32_t *in, size_t i, size_t stop, Out *out,
+                    size_t o) {
+  for (; i < stop; i++) {
+    const uint32_t c = in[i];
+    if (Validate && (c > 0x10FFFF || (c & 0xFFFFF800) == 0xD800)) {
+      return position{i, o, false};
+    }
+    o += put(c, out + o);
+  }
+  return position{i, o, true};
+}
+
+// The lengths: plain loops that the compiler vectorizes with the
+// instruction sets of the back end.
+
+inline size_t utf32_length_from_utf8(const uint8_t *in, size_t n) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++) {
+    count += int8_t(in[i]) > -65; // not a continuation byte
+  }
+  return count;
+}
+
+inline size_t utf16_length_from_utf8(const uint8_t *in, size_t n) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++) {
+    count += (int8_t(in[i]) > -65) + (in[i] >= 0xF0);
+  }
+  return count;
+}
+
+inline size_t utf8_length_from_utf16(const uint16_t *in, size_t n) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++) {
+    // 2 for each half of a surrogate pair
+    count += 1 + (in[i] >= 0x80) + (in[i] >= 0x800) -
+             ((in[i] & 0xF800) == 0xD800);
+  }
+  return count;
+}
+
+inline size_t utf32_length_from_utf16(const uint16_t *in, size_t n) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++) {
+    count += (in[i] & 0xFC00) != 0xDC00;
+  }
+  return count;
+}
+
+inline size_t utf8_length_from_utf32(const uint32_t *in, size_t n) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++) {
+    count += 1 + (in[i] >= 0x80) + (in[i] >= 0x800) + (in[i] >= 0x10000);
+  }
+  return count;
+}
+
+inline size_t utf16_length_from_utf32(const uint32_t *in, size_t n) {
+  size_t count = 0;
+  for (size_t i = 0; i < n; i++) {
+    count += 1 + (in[i] >= 0x10000);
+  }
+  return count;
+}
+
+// For the encoding of four code points of 1 to 4 bytes of UTF-8 in the
+// four 32-bit lanes of a 16-byte vector: with index = sum of
+// (bytes - 1) << (2 * lane), shuffle[index] gathers the bytes in order and
+// length[index] counts them.
+struct utf8_packing {
+  uint8_t shuffle[256][16];
+  uint8_t length[256];
+
+  constexpr utf8_packing() : shuffle(), length() {
+    for (int index = 0; index < 256; index++) {
+      int k = 0;
+      for (int lane = 0; lane < 4; lane++) {
+        const int bytes = ((index >> (2 * lane)) & 3) + 1;
+        for (int b = 0; b < bytes; b++) {
+          shuffle[index][k++] = uint8_t(4 * lane + b);
+        }
+      }
+      length[index] = uint8_t(k);
+      for (; k < 16; k++) {
+        shuffle[index][k] = 0x80;
+      }
+    }
+  }
+};
+
+constexpr utf8_packing packing{};
+
+// The bits of a nibble spread to the even bits of a byte, to interleave
+// two masks of four lanes into an index of utf8_packing.
+constexpr uint8_t spread[16] = {0x00, 0x01, 0x04, 0x05, 0x10, 0x11,
+                                0x14, 0x15, 0x40, 0x41, 0x44, 0x45,
+                                0x50, 0x51, 0x54, 0x55};
+
+// The same for four code points of 1 or 2 units of UTF-16 (a code point,
+// or a high surrogate and a low one above it): bit k of the index is set
+// when lane k holds a pair; the lengths count units.
+struct utf16_packing {
+  uint8_t shuffle[16][16];
+  uint8_t length[16];
+
+  constexpr utf16_packing() : shuffle(), length() {
+    for (int index = 0; index < 16; index++) {
+      int k = 0;
+      for (int lane = 0; lane < 4; lane++) {
+        const int bytes = (index >> lane) & 1 ? 4 : 2;
+        for (int b = 0; b < bytes; b++) {
+          shuffle[index][k++] = uint8_t(4 * lane + b);
+        }
+      }
+      length[index] = uint8_t(k / 2);
+      for (; k < 16; k++) {
+        shuffle[index][k] = 0x80;
+      }
+    }
+  }
+};
+
+constexpr utf16_packing pair_packing{};
+
+// For a window of width units of UTF-16 with high and low surrogates at
+// the bits of high and low: false if one is unpaired; otherwise *units
+// is the units that the window takes (a high surrogate at the end waits
+// for the next window) and *starts has the bits of the units that start a
+// character.
+inline bool pair_surrogates(uint32_t high, uint32_t low, int width,
+                            int *units, uint32_t *starts) {
+  const uint32_t all = (1u << width) - 1;
+  uint32_t window = all;
+  *units = width;
+  if (high >> (width - 1)) {
+    window >>= 1;
+    *units = width - 1;
+  }
+  *starts = window & ~low;
+  // a high surrogate before the one that waits is unpaired
+  return (low & window) == (((high & window) << 1) & all);
+}
+
+} // namespace
+
+} // namespace transcode
+
+#endif // TRANSCODE_KERNELS_H
@@ -0,0 +1,117 @@
+// Speed of UTF-8 validation in GB/s over n bytes of text (16 MiB by
+// default): ASCII, and text whose characters are mostly 2, 3 or 4 bytes
+// long, with each back end (scalar is the DFA of 2018/05/08/checkutf8.c),
+// with one thread per hardware thread, and as a stream of 64 KiB chunks.
+#include "utf8validate.h"
+
+#include "../harness/harness.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+
+static std::string random_text(size_t n, int width, std::mt19937_64 &gen) {
+  std::string text;
+  while (text.size() < n) {
+    // one ASCII character in 8, the others of the given width
+    const int w = gen() % 8 == 0 ? 1 : width;
+    uint32_t c;
+    if (w == 1) {
+      c = 0x20 + gen() % 0x5F;
+    } else if (w == 2) {
+      c = 0x80 + gen() % (0x800 - 0x80);
+    } else if (w == 3) {
+      do {
+        c = 0x800 + gen() % (0x10000 - 0x800);
+      } while (c >= 0xD800 && c <= 0xDFFF);
+    } else {
+      c = 0x10000 + gen() % (0x110000 - 0x10000);
+    }
+    if (c < 0x80) {
+      text += char(c);
+    } else if (c < 0x800) {
+      text += char(0xC0 | (c >> 6));
+      text += char(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+      text += char(0xE0 | (c >> 12));
+      text += char(0x80 | ((c >> 6) & 0x3F));
+      text += char(0x80 | (c & 0x3F));
+    } else {
+      text += char(0xF0 | (c >> 18));
+      text += char(0x80 | ((c >> 12) & 0x3F));
+      text += char(0x80 | ((c >> 6) & 0x3F));
+      text += char(0x80 | (c & 0x3F));
+    }
+  }
+  return text;
+}
+
+template <class F>
+static bool time(const char *data, const char *name, const std::string &text,
+                 F f, harness::options &opts) {
+  bool valid = false;
+  auto r = harness::run(name, text.size(), [&] {
+    valid = f();
+    harness::do_not_optimize(valid);
+  }, opts);
+  if (opts.format == HARNESS_TEXT) {
+    printf("%-8s\t%-16s\t%.2f\n", data, name, text.size() / r.min());
+  } else {
+    r.report();
+  }
+  return valid;
+}
+
+static bool run(const char *data, const std::string &text,
+                harness::options &opts) {
+  bool ok = true;
+  const utf8validate::backend backends[] = {utf8validate::backend::scalar,
+                                            utf8validate::backend::avx2,
+                                            utf8validate::backend::avx512};
+  for (utf8validate::backend b : backends) {
+    if (!utf8validate::backend_supported(b)) {
+      continue;
+    }
+    utf8validate::options o;
+    o.kernel = b;
+    ok &= time(data, utf8validate::backend_name(b), text, [&] {
+      return utf8validate::validate(text.data(), text.size(), o).valid;
+    }, opts);
+  }
+  utf8validate::options o;
+  o.threads = 0;
+  ok &= time(data, "parallel", text, [&] {
+    return utf8validate::validate(text.data(), text.size(), o).valid;
+  }, opts);
+  utf8validate::validator v;
+  ok &= time(data, "stream 64 KiB", text, [&] {
+    v.reset();
+    for (size_t i = 0; i < text.size(); i += 65536) {
+      v.update(text.data() + i, std::min(text.size() - i, size_t(65536)));
+    }
+    return v.finish().valid;
+  }, opts);
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  const size_t n = argc > 1 ? size_t(atoll(argv[1])) : 16 << 20;
+  std::mt19937_64 gen(1234);
+  harness::options opts = harness::default_options();
+  opts.repeat = 5;
+  printf("n = %zu, %u hardware threads, best back end: %s\n", n,
+         std::thread::hardware_concurrency(),
+         utf8validate::backend_name(utf8validate::active_backend()));
+  printf("data    \tvalidator       \tGB/s\n");
+  if (!run("ascii", random_text(n, 1, gen), opts) ||
+      !run("2 bytes", random_text(n, 2, gen), opts) ||
+      !run("3 bytes", random_text(n, 3, gen), opts) ||
+      !run("4 bytes", random_text(n, 4, gen), opts)) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,232 @@
+// Checks of every back end against a plain decoder: the sequences of
+// 2018/05/08/checkutf8.c, every pair of bytes and many triples placed across
+// the 64-byte blocks, random text of one- to four-byte characters with
+// random corruptions, threads, and streams fed in random chunks.
+#include "utf8validate.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+const utf8validate::backend backends[] = {
+    utf8validate::backend::automatic, utf8validate::backend::scalar,
+    utf8validate::backend::avx2, utf8validate::backend::avx512};
+
+std::mt19937_64 gen(1234);
+
+// the first byte of the first invalid or incomplete character, or n
+size_t reference(const std::string &text) {
+  const uint8_t *s = reinterpret_cast<const uint8_t *>(text.data());
+  const size_t n = text.size();
+  size_t i = 0;
+  while (i < n) {
+    const uint8_t c = s[i];
+    size_t length;
+    uint32_t code, minimum;
+    if (c < 0x80) {
+      i++;
+      continue;
+    } else if ((c & 0xE0) == 0xC0) {
+      length = 2, code = c & 0x1F, minimum = 0x80;
+    } else if ((c & 0xF0) == 0xE0) {
+      length = 3, code = c & 0x0F, minimum = 0x800;
+    } else if ((c & 0xF8) == 0xF0) {
+      length = 4, code = c & 0x07, minimum = 0x10000;
+    } else {
+      return i;
+    }
+    if (i + length > n) {
+      return i;
+    }
+    for (size_t k = 1; k < length; k++) {
+      if ((s[i + k] & 0xC0) != 0x80) {
+        return i;
+      }
+      code = (code << 6) | (s[i + k] & 0x3F);
+    }
+    if (code < minimum || code > 0x10FFFF ||
+        (code >= 0xD800 && code <= 0xDFFF)) {
+      return i;
+    }
+    i += length;
+  }
+  return n;
+}
+
+bool check(const std::string &text, utf8validate::backend b,
+           unsigned threads = 1) {
+  const size_t expected = reference(text);
+  utf8validate::options o;
+  o.kernel = b;
+  o.threads = threads;
+  const utf8validate::result r =
+      utf8validate::validate(text.data(), text.size(), o);
+  bool ok = r.valid == (expected == text.size()) && r.error == expected;
+  // as a stream, in chunks of random sizes
+  utf8validate::validator v(o);
+  for (size_t i = 0; i < text.size();) {
+    const size_t chunk = std::min(text.size() - i, size_t(gen() % 150));
+    v.update(text.data() + i, chunk);
+    i += chunk;
+  }
+  const utf8validate::result s = v.finish();
+  ok = ok && s.valid == r.valid && s.error == r.error;
+  if (!ok) {
+    printf("bug: %s, %zu bytes, %u threads: expected %zu, got %zu and %zu\n",
+           utf8validate::backend_name(b), text.size(), threads, expected,
+           r.error, s.error);
+  }
+  return ok;
+}
+
+bool check_all(const std::string &text, unsigned threads = 1) {
+  for (utf8validate::backend b : backends) {
+    if (utf8validate::backend_supported(b) && !check(text, b, threads)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool check_sequences() {
+  const char *good[] = {"a", "\xc3\xb1", "\xe2\x82\xa1", "\xf0\x90\x8c\xbc"};
+  const char *bad[] = {"\xc3\x28",         "\xa0\xa1",
+                       "\xe2\x28\xa1",     "\xe2\x82\x28",
+                       "\xf0\x28\x8c\xbc", "\xf0\x90\x28\xbc",
+                       "\xf0\x28\x8c\x28"};
+  for (const char *s : good) {
+    if (reference(s) != strlen(s) || !check_all(s)) {
+      return false;
+    }
+  }
+  for (const char *s : bad) {
+    if (reference(s) == strlen(s) || !check_all(s)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Every pair of bytes, and triples of a lead and two bytes around the
+// boundaries of the continuation ranges, ending at the end of a block,
+// across it, and at the end of the input.
+bool check_small() {
+  const uint8_t interesting[] = {0x00, 0x41, 0x7F, 0x80, 0x8F, 0x90, 0x9F,
+                                 0xA0, 0xBF, 0xC0, 0xC2, 0xDF, 0xE0, 0xED,
+                                 0xEF, 0xF0, 0xF4, 0xF5, 0xFF};
+  for (size_t at : {size_t(0), size_t(61), size_t(62), size_t(63)}) {
+    for (unsigned x = 0; x < 256; x++) {
+      for (unsigned y = 0; y < 256; y++) {
+        std::string text(at, 'a');
+        text += char(x);
+        text += char(y);
+        if (!check_all(text) || !check_all(text + "bcd")) {
+          return false;
+        }
+      }
+    }
+    for (unsigned x = 0xC0; x < 256; x++) {
+      for (uint8_t y : interesting) {
+        for (uint8_t z : interesting) {
+          std::string text(at, 'a');
+          text += char(x);
+          text += char(y);
+          text += char(z);
+          if (!check_all(text) || !check_all(text + "\x80\x80xyz")) {
+            return false;
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// n bytes or a few more of valid characters of 1 to 4 bytes, mostly ASCII
+// when ascii is set
+std::string random_text(size_t n, bool ascii) {
+  std::string text;
+  while (text.size() < n) {
+    uint32_t c;
+    switch (gen() % (ascii ? 40 : 4)) {
+    case 1:
+      c = 0x80 + gen() % (0x800 - 0x80);
+      break;
+    case 2:
+      do {
+        c = 0x800 + gen() % (0x10000 - 0x800);
+      } while (c >= 0xD800 && c <= 0xDFFF);
+      break;
+    case 3:
+      c = 0x10000 + gen() % (0x110000 - 0x10000);
+      break;
+    default:
+      c = gen() % 0x80;
+    }
+    if (c < 0x80) {
+      text += char(c);
+    } else if (c < 0x800) {
+      text += char(0xC0 | (c >> 6));
+      text += char(0x80 | (c & 0x3F));
+    } else if (c < 0x10000) {
+      text += char(0xE0 | (c >> 12));
+      text += char(0x80 | ((c >> 6) & 0x3F));
+      text += char(0x80 | (c & 0x3F));
+    } else {
+      text += char(0xF0 | (c >> 18));
+      text += char(0x80 | ((c >> 12) & 0x3F));
+      text += char(0x80 | ((c >> 6) & 0x3F));
+      text += char(0x80 | (c & 0x3F));
+    }
+  }
+  return text;
+}
+
+bool check_random() {
+  for (int trial = 0; trial < 2000; trial++) {
+    std::string text = random_text(gen() % 1000, trial % 2 == 0);
+    if (!check_all(text)) {
+      return false;
+    }
+    if (text.empty()) {
+      continue;
+    }
+    const int corruptions = int(gen() % 3) + 1;
+    for (int k = 0; k < corruptions; k++) {
+      text[gen() % text.size()] = char(gen());
+    }
+    if (!check_all(text) || !check_all(text.substr(0, text.size() - 1))) {
+      return false;
+    }
+  }
+  // long inputs with threads, errors near the seams of the segments
+  for (int trial = 0; trial < 6; trial++) {
+    std::string text = random_text(8 << 20, trial % 2 == 0);
+    if (trial > 1) {
+      const size_t seam = text.size() / 4 * (trial - 1);
+      text[seam - 2 + gen() % 4] = char(0x80 | gen());
+    }
+    if (!check_all(text, 4)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main() {
+  printf("best back end: %s\n",
+         utf8validate::backend_name(utf8validate::active_backend()));
+  if (!check_sequences() || !check_small() || !check_random()) {
+    printf("bug!\n");
+    return EXIT_FAILURE;
+  }
+  printf("ok\n");
+  return EXIT_SUCCESS;
+}
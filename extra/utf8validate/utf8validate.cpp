@@ -0,0 +1,292 @@
+// Runtime dispatch, the scalar back end, the search for the position of an
+// error, the threaded validate and the streaming validator.
+#include "utf8validate.h"
+#include "utf8validate_kernels.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "../isa/dispatch.h"
+#include "../parallel/parallel.h"
+
+namespace utf8validate {
+
+namespace {
+
+// The DFA of 2018/05/08/checkutf8.c:
+// Copyright (c) 2008-2010 Bjoern Hoehrmann <bjoern@hoehrmann.de>
+// See http://bjoern.hoehrmann.de/utf-8/decoder/dfa/ for details.
+constexpr uint32_t accept = 0;
+constexpr uint32_t reject = 1;
+
+// the class of each byte
+constexpr uint8_t utf8d[256] = {
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0, // 00..1f
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0, // 20..3f
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0, // 40..5f
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0, // 60..7f
+    1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+    1,   1,   9,   9,   9,   9,   9,   9,   9,   9,   9,   9,   9,   9,
+    9,   9,   9,   9, // 80..9f
+    7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,
+    7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,   7,
+    7,   7,   7,   7, // a0..bf
+    8,   8,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,
+    2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,   2,
+    2,   2,   2,   2, // c0..df
+    0xa, 0x3, 0x3, 0x3, 0x3, 0x3, 0x3, 0x3,
+    0x3, 0x3, 0x3, 0x3, 0x3, 0x4, 0x3, 0x3, // e0..ef
+    0xb, 0x6, 0x6, 0x6, 0x5, 0x8, 0x8, 0x8,
+    0x8, 0x8, 0x8, 0x8, 0x8, 0x8, 0x8, 0x8 // f0..ff
+};
+
+// the next state, by state and class
+constexpr uint8_t utf8d_transition[144] = {
+    0x0, 0x1, 0x2, 0x3, 0x5, 0x8, 0x7, 0x1, 0x1, 0x1, 0x4,
+    0x6, 0x1, 0x1, 0x1, 0x1, // s0..s0
+    1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+    1,   1,   1,   1,   1,   1,   0,   1,   1,   1,   1,
+    1,   0,   1,   0,   1,   1,   1,   1,   1,   1, // s1..s2
+    1,   2,   1,   1,   1,   1,   1,   2,   1,   2,   1,
+    1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+    1,   2,   1,   1,   1,   1,   1,   1,   1,   1, // s3..s4
+    1,   2,   1,   1,   1,   1,   1,   1,   1,   2,   1,
+    1,   1,   1,   1,   1,   1,   1,   1,   1,   1,   1,
+    1,   3,   1,   3,   1,   1,   1,   1,   1,   1, // s5..s6
+    1,   3,   1,   1,   1,   1,   1,   3,   1,   3,   1,
+    1,   1,   1,   1,   1,   1,   3,   1,   1,   1,   1,
+    1,   1,   1,   1,   1,   1,   1,   1,   1,   1, // s7..s8
+};
+
+inline uint32_t next_state(uint32_t state, uint8_t byte) {
+  return utf8d_transition[16 * state + utf8d[byte]];
+}
+
+inline bool is_continuation(uint8_t byte) { return (byte & 0xC0) == 0x80; }
+
+// Where to start decoding so as to check everything from block b of data,
+// as an offset from data: the lead byte among the 3 bytes before the block
+// (at negative offsets, those of previous), if any. Everything before the
+// block has been checked, so that a character that began earlier and is
+// not cut short there ended before the block.
+ptrdiff_t restart(const uint8_t *previous, const uint8_t *data, size_t b) {
+  for (ptrdiff_t i = ptrdiff_t(b) - 1; i >= ptrdiff_t(b) - 3; i--) {
+    const uint8_t byte = i < 0 ? previous[3 + i] : data[i];
+    if (!is_continuation(byte)) {
+      return i;
+    }
+  }
+  return ptrdiff_t(b);
+}
+
+// The position, as an offset from data (negative inside previous), of the
+// first character that is invalid or cut short by the end of data[0, n),
+// decoding from the restart point of block b; n if there is none.
+ptrdiff_t locate(const uint8_t *previous, const uint8_t *data, size_t n,
+                 size_t b) {
+  uint32_t state = accept;
+  ptrdiff_t start = 0;
+  for (ptrdiff_t i = restart(previous, data, b); i < ptrdiff_t(n); i++) {
+    if (state == accept) {
+      start = i;
+    }
+    state = next_state(state, i < 0 ? previous[3 + i] : data[i]);
+    if (state == reject) {
+      return start;
+    }
+  }
+  return state == accept ? ptrdiff_t(n) : start;
+}
+
+size_t scalar_check(const uint8_t *data, size_t n, const uint8_t *previous) {
+  uint32_t state = accept;
+  for (ptrdiff_t i = restart(previous, data, 0); i < 0; i++) {
+    state = next_state(state, previous[3 + i]);
+  }
+  if (state == reject) {
+    return 0;
+  }
+  for (size_t i = 0; i < n; i++) {
+    state = next_state(state, data[i]);
+    if (state == reject) {
+      return i & ~size_t(63);
+    }
+  }
+  return n;
+}
+
+struct implementation {
+  backend kind;
+  const char *name;
+  uint32_t required_instruction_sets;
+  const functions &(*table)();
+};
+
+const implementation scalar = {backend::scalar, "scalar", 0,
+                               scalar_functions};
+const implementation avx2 = {backend::avx2, "avx2", instruction_set::AVX2,
+                             avx2_functions};
+const implementation avx512 = {
+    backend::avx512, "avx512",
+    instruction_set::AVX512F | instruction_set::AVX512BW, avx512_functions};
+
+const implementation *const implementations[] = {&avx512, &avx2, &scalar};
+
+const implementation *best() {
+  static const implementation *best =
+      isa::first_supported(implementations, &scalar);
+  return best;
+}
+
+// nullptr if unknown or unsupported
+const implementation *find(backend kind) {
+  if (kind == backend::automatic) {
+    return best();
+  }
+  return isa::find(implementations, kind);
+}
+
+constexpr uint8_t nothing_before[3] = {0, 0, 0};
+
+} // namespace
+
+const functions &scalar_functions() {
+  static const functions functions = {scalar_check};
+  return functions;
+}
+
+bool backend_supported(backend b) { return find(b) != nullptr; }
+
+backend active_backend() { return best()->kind; }
+
+const char *backend_name(backend b) {
+  if (b == backend::automatic) {
+    return best()->name;
+  }
+  return isa::name_of(implementations, b);
+}
+
+// The whole blocks are split between the threads; each segment starts
+// from the 3 bytes before it, so that the characters across the seams are
+// checked by the segment where they end. The last bytes are checked in a
+// block padded with zeros (ASCII), which also shows a last character cut
+// short.
+result validate(const char *data, size_t n, const options &o) {
+  const implementation *impl = find(o.kernel);
+  if (impl == nullptr) {
+    return result{false, 0};
+  }
+  const check_function check = impl->table().check;
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+  const size_t blocks = n / 64;
+  unsigned threads = parallel::thread_count(o.threads);
+  if (blocks * 64 / threads < parallel::minimum_bytes) {
+    threads = 1;
+  }
+  auto slice = [blocks, threads](unsigned t) {
+    return t * blocks / threads * 64;
+  };
+  std::vector<size_t> errors(threads);
+  parallel::in_parallel(threads, [&](unsigned t) {
+    const size_t begin = slice(t), end = slice(t + 1);
+    const uint8_t *previous = begin == 0 ? nothing_before : bytes + begin - 3;
+    errors[t] = begin + check(bytes + begin, end - begin, previous);
+  });
+  for (unsigned t = 0; t < threads; t++) {
+    if (errors[t] != slice(t + 1)) {
+      return result{false,
+                    size_t(locate(nothing_before, bytes, n, errors[t]))};
+    }
+  }
+  const size_t tail = blocks * 64;
+  const uint8_t *previous = tail == 0 ? nothing_before : bytes + tail - 3;
+  uint8_t last[64] = {0};
+  std::copy(bytes + tail, bytes + n, last);
+  if (check(last, 64, previous) != 64) {
+    return result{false, size_t(ptrdiff_t(tail) +
+                                locate(previous, bytes + tail, n - tail, 0))};
+  }
+  return result{true, n};
+}
+
+validator::validator(const options &o) {
+  const implementation *impl = find(o.kernel);
+  table_ = impl == nullptr ? nullptr : &impl->table();
+  reset();
+}
+
+void validator::reset() {
+  std::fill(previous_, previous_ + 3, 0);
+  pending_ = 0;
+  consumed_ = 0;
+  size_ = 0;
+  failed_ = table_ == nullptr;
+  error_ = 0;
+}
+
+// Checks n more bytes, n a multiple of the block size.
+bool validator::check(const uint8_t *data, size_t n) {
+  const size_t b = table_->check(data, n, previous_);
+  if (b != n) {
+    failed_ = true;
+    error_ = size_t(ptrdiff_t(consumed_) + locate(previous_, data, n, b));
+    return false;
+  }
+  std::copy(data + n - 3, data + n, previous_);
+  consumed_ += n;
+  return true;
+}
+
+bool validator::update(const char *data, size_t n) {
+  if (failed_) {
+    return false;
+  }
+  size_ += n;
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+  if (pending_ > 0) {
+    const size_t taken = std::min(n, block - pending_);
+    std::copy(bytes, bytes + taken, buffer_ + pending_);
+    pending_ += taken;
+    bytes += taken;
+    n -= taken;
+    if (pending_ < block) {
+      return true;
+    }
+    pending_ = 0;
+    if (!check(buffer_, block)) {
+      return false;
+    }
+  }
+  const size_t whole = n / block * block;
+  if (whole > 0 && !check(bytes, whole)) {
+    return false;
+  }
+  std::copy(bytes + whole, bytes + n, buffer_);
+  pending_ = n - whole;
+  return true;
+}
+
+result validator::finish() {
+  if (table_ == nullptr) {
+    return result{false, 0};
+  }
+  if (!failed_) {
+    std::fill(buffer_ + pending_, buffer_ + block, 0);
+    if (table_->check(buffer_, block, previous_) != block) {
+      failed_ = true;
+      error_ = size_t(ptrdiff_t(consumed_) +
+                      locate(previous_, buffer_, pending_, 0));
+    }
+  }
+  return failed_ ? result{false, error_} : result{true, size_};
+}
+
+} // namespace utf8validate
@@ -0,0 +1,100 @@
+// UTF-8 validation with AVX2 or AVX-512, picked at runtime, that reports
+// where the first error is, over a whole buffer (optionally split between
+// threads) or over a stream fed chunk by chunk.
+//
+// 2018/05/15/simdutf8check.h checks 16 bytes at a time with SSE by
+// computing the length of each character from its lead byte and comparing
+// ranges. Here each byte is checked against the three bytes before it
+// with three 16-entry tables (the "lookup" algorithm of Keiser and Lemire,
+// which simdjson uses): the high nibble of the previous byte, its low
+// nibble and the high nibble of the current byte each give a set of the
+// errors that are still possible, and an error shows when the three sets
+// share one. A separate check makes sure that the second and third bytes
+// after a three- or four-byte lead are continuations. Blocks of ASCII
+// skip all of this.
+//
+// The scalar back end, and the search for the exact position once a block
+// shows an error, use the DFA of Bjoern Hoehrmann from
+// 2018/05/08/checkutf8.c.
+//
+//   utf8validate::result r = utf8validate::validate(data, size);
+//   if (!r.valid) printf("invalid at byte %zu\n", r.error);
+//
+//   utf8validate::validator v;
+//   while (size_t n = read(...)) if (!v.update(buffer, n)) break;
+//   utf8validate::result r = v.finish();
+#ifndef UTF8VALIDATE_H
+#define UTF8VALIDATE_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace utf8validate {
+
+struct functions; // of a back end, in utf8validate_kernels.h
+
+enum class backend {
+  automatic, // best supported one
+  scalar,
+  avx2,
+  avx512
+};
+
+// Whether the back end can run on this processor, and its name.
+bool backend_supported(backend b);
+backend active_backend();
+const char *backend_name(backend b);
+
+struct options {
+  backend kernel = backend::automatic;
+  unsigned threads = 1; // validate: 0 for one per hardware thread
+};
+
+struct result {
+  bool valid;
+  // When invalid, the offset of the first byte of the first character that
+  // is invalid or cut short (an unexpected continuation byte is a
+  // character of its own); otherwise the number of bytes.
+  size_t error;
+};
+
+// Validates data[0, n). An unsupported back end gives an invalid result
+// with error = 0 and backend_supported() false; check it first.
+result validate(const char *data, size_t n, const options &o = options());
+
+// Validates a stream given in chunks of any size: no byte is read twice
+// except those of an error. options::threads is ignored.
+class validator {
+public:
+  explicit validator(const options &o = options());
+
+  // Validates the next n bytes; false once an error has been found (the
+  // bytes after it are ignored).
+  bool update(const char *data, size_t n);
+
+  // The end of the stream: the last character must be complete. The
+  // validator can then be reset() for another stream.
+  result finish();
+  void reset();
+
+  // Bytes given so far.
+  size_t size() const { return size_; }
+
+private:
+  static constexpr size_t block = 64;
+
+  bool check(const uint8_t *data, size_t n);
+
+  const functions *table_; // nullptr if the back end is not supported
+  uint8_t previous_[3];    // the 3 bytes before the next block
+  uint8_t buffer_[block];
+  size_t pending_;  // bytes in buffer_, less than a block
+  size_t consumed_; // bytes checked, a multiple of the block size
+  size_t size_;
+  bool failed_;
+  size_t error_;
+};
+
+} // namespace utf8validate
+
+#endif // UTF8VALIDATE_H
@@ -0,0 +1,46 @@
+// The lookup algorithm with AVX2: two 32-byte vectors per block, the tables
+// in both 16-byte lanes. Compiled with -mavx2.
+#include "utf8validate_kernels.h"
+
+#include <immintrin.h>
+
+namespace utf8validate {
+namespace {
+
+struct ops {
+  typedef __m256i vector;
+  static constexpr size_t bytes = 32;
+
+  static vector load(const uint8_t *p) {
+    return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p));
+  }
+  static vector table(const uint8_t *t) {
+    return _mm256_broadcastsi128_si256(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(t)));
+  }
+  static vector lookup(vector t, vector x) { return _mm256_shuffle_epi8(t, x); }
+  static vector high_nibbles(vector v) {
+    return _mm256_and_si256(_mm256_srli_epi16(v, 4), _mm256_set1_epi8(0x0F));
+  }
+  static vector set1(uint8_t x) { return _mm256_set1_epi8(char(x)); }
+  static vector and_(vector x, vector y) { return _mm256_and_si256(x, y); }
+  static vector or_(vector x, vector y) { return _mm256_or_si256(x, y); }
+  static vector xor_(vector x, vector y) { return _mm256_xor_si256(x, y); }
+  static vector subs(vector x, vector y) { return _mm256_subs_epu8(x, y); }
+  template <int N> static vector prev(vector input, vector previous) {
+    // the high lane of previous, then the low lane of input
+    const vector shifted = _mm256_permute2x128_si256(previous, input, 0x21);
+    return _mm256_alignr_epi8(input, shifted, 16 - N);
+  }
+  static bool is_ascii(vector v) { return _mm256_movemask_epi8(v) == 0; }
+  static bool nonzero(vector v) { return !_mm256_testz_si256(v, v); }
+};
+
+} // namespace
+
+const functions &avx2_functions() {
+  static const functions avx2 = {check_blocks<ops>};
+  return avx2;
+}
+
+} // namespace utf8validate
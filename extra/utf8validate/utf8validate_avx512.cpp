@@ -0,0 +1,51 @@
+// The lookup algorithm with AVX-512: one 64-byte vector per block, the
+// tables in the four 16-byte lanes; the shifts by one to three bytes cross
+// lanes through a permutation of 64-bit words. Compiled with -mavx512f
+// -mavx512bw.
+#include "utf8validate_kernels.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#include <immintrin.h>
+#pragma GCC diagnostic pop
+
+namespace utf8validate {
+namespace {
+
+struct ops {
+  typedef __m512i vector;
+  static constexpr size_t bytes = 64;
+
+  static vector load(const uint8_t *p) { return _mm512_loadu_si512(p); }
+  static vector table(const uint8_t *t) {
+    return _mm512_broadcast_i32x4(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(t)));
+  }
+  static vector lookup(vector t, vector x) { return _mm512_shuffle_epi8(t, x); }
+  static vector high_nibbles(vector v) {
+    return _mm512_and_si512(_mm512_srli_epi16(v, 4), _mm512_set1_epi8(0x0F));
+  }
+  static vector set1(uint8_t x) { return _mm512_set1_epi8(char(x)); }
+  static vector and_(vector x, vector y) { return _mm512_and_si512(x, y); }
+  static vector or_(vector x, vector y) { return _mm512_or_si512(x, y); }
+  static vector xor_(vector x, vector y) { return _mm512_xor_si512(x, y); }
+  static vector subs(vector x, vector y) { return _mm512_subs_epu8(x, y); }
+  template <int N> static vector prev(vector input, vector previous) {
+    // lane i - 1 of input in lane i, the last lane of previous in lane 0
+    const vector shifted = _mm512_permutex2var_epi64(
+        input, _mm512_set_epi64(5, 4, 3, 2, 1, 0, 15, 14), previous);
+    return _mm512_alignr_epi8(input, shifted, 16 - N);
+  }
+  static bool is_ascii(vector v) { return _mm512_movepi8_mask(v) == 0; }
+  static bool nonzero(vector v) { return _mm512_test_epi64_mask(v, v) != 0; }
+};
+
+} // namespace
+
+const functions &avx512_functions() {
+  static const functions avx512 = {check_blocks<ops>};
+  return avx512;
+}
+
+} // namespace utf8validate
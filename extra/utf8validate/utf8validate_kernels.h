@@ -0,0 +1,190 @@
+// The lookup algorithm over the vector operations that
+// utf8validate_avx2.cpp and utf8validate_avx512.cpp provide, and the
+// functions of each back end. Only the utf8validate*.cpp files include
+// this header.
+#ifndef UTF8VALIDATE_KERNELS_H
+#define UTF8VALIDATE_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "utf8validate.h"
+
+namespace utf8validate {
+
+// Checks data[0, n), n a multiple of 64, which follows the bytes
+// previous[0], previous[1] and previous[2]. Returns the offset of the first
+// 64-byte block where an error shows, or n. An error shows in the block of
+// the byte that makes it certain: a character cut short at the end of the
+// range shows in the next block.
+typedef size_t (*check_function)(const uint8_t *data, size_t n,
+                                 const uint8_t *previous);
+
+struct functions {
+  check_function check;
+};
+
+const functions &scalar_functions();
+const functions &avx2_functions();
+const functions &avx512_functions();
+
+namespace lookup {
+
+// The errors that a pair of bytes (previous, current) can make; bit 7 is
+// also set for the continuation byte after a continuation byte, which
+// check_vector expects after three- and four-byte leads.
+constexpr uint8_t too_short = 1 << 0; // 11______ 0_______, 11______ 11______
+constexpr uint8_t too_long = 1 << 1;   // 0_______ 10______
+constexpr uint8_t overlong_3 = 1 << 2; // 11100000 100_____
+constexpr uint8_t too_large = 1 << 3;  // 11110100 1001____ and above
+constexpr uint8_t surrogate = 1 << 4;  // 11101101 101_____
+constexpr uint8_t overlong_2 = 1 << 5; // 1100000_ 10______
+constexpr uint8_t too_large_1000 = 1 << 6; // 11110101 1000____ and above
+constexpr uint8_t overlong_4 = 1 << 6;     // 11110000 1000____
+constexpr uint8_t two_continuations = 1 << 7; // 10______ 10______
+// the errors decided by the high nibble of the previous byte alone
+constexpr uint8_t carry = too_short | too_long | two_continuations;
+
+// by the high nibble of the previous byte
+constexpr uint8_t byte_1_high[16] = {
+    too_long, too_long, too_long, too_long, // 0_______
+    too_long, too_long, too_long, too_long,
+    two_continuations, two_continuations, two_continuations, // 10______
+    two_continuations,
+    too_short | overlong_2,                           // 1100____
+    too_short,                                        // 1101____
+    too_short | overlong_3 | surrogate,               // 1110____
+    too_short | too_large | too_large_1000 | overlong_4 // 1111____
+};
+
+// by the low nibble of the previous byte
+constexpr uint8_t byte_1_low[16] = {
+    carry | overlong_3 | overlong_2 | overlong_4, // ____0000
+    carry | overlong_2,                           // ____0001
+    carry,                                        // ____001_
+    carry,
+    carry | too_large,                  // ____0100
+    carry | too_large | too_large_1000, // ____0101
+    carry | too_large | too_large_1000, // ____011_
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000, // ____1___
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000 | surrogate, // ____1101
+    carry | too_large | too_large_1000,
+    carry | too_large | too_large_1000};
+
+// by the high nibble of the current byte
+constexpr uint8_t byte_2_high[16] = {
+    too_short, too_short, too_short, too_short, // 0_______
+    too_short, too_short, too_short, too_short,
+    too_long | overlong_2 | two_continuations | overlong_3 |
+        too_large_1000 | overlong_4, // 1000____
+    too_long | overlong_2 | two_continuations | overlong_3 |
+        too_large, // 1001____
+    too_long | overlong_2 | two_continuations | surrogate |
+        too_large, // 101_____
+    too_long | overlong_2 | two_continuations | surrogate | too_large,
+    too_short, too_short, too_short, too_short // 11______
+};
+
+// A block that ends with one of these bytes at these places cuts a
+// character short (byte > maximum).
+constexpr uint8_t incomplete_maximum[64] = {
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 0xF0 - 1, 0xE0 - 1,
+    0xC0 - 1};
+
+} // namespace lookup
+
+// Ops provides, over vectors of Ops::bytes bytes (32 or 64):
+//
+//   vector load(const uint8_t *);
+//   vector table(const uint8_t *t);    // t[0, 16) in each 16-byte lane
+//   vector lookup(vector t, vector x); // t[x] bytewise, x < 16
+//   vector high_nibbles(vector);
+//   vector set1(uint8_t);
+//   vector and_(vector, vector), or_(vector, vector), xor_(vector, vector);
+//   vector subs(vector, vector);       // saturated unsigned bytes
+//   template <int N> vector prev(vector input, vector previous);
+//                                      // input shifted N bytes later,
+//                                      // the last N of previous first
+//   bool is_ascii(vector);
+//   bool nonzero(vector);
+
+// Nonzero where the bytes of input, after those of previous, are not
+// valid UTF-8.
+template <class Ops>
+typename Ops::vector check_vector(typename Ops::vector input,
+                                  typename Ops::vector previous) {
+  typedef typename Ops::vector vector;
+  const vector low_nibble = Ops::set1(0x0F);
+  const vector prev1 = Ops::template prev<1>(input, previous);
+  const vector byte_1_high = Ops::lookup(Ops::table(lookup::byte_1_high),
+                                         Ops::high_nibbles(prev1));
+  const vector byte_1_low = Ops::lookup(Ops::table(lookup::byte_1_low),
+                                        Ops::and_(prev1, low_nibble));
+  const vector byte_2_high = Ops::lookup(Ops::table(lookup::byte_2_high),
+                                         Ops::high_nibbles(input));
+  const vector special =
+      Ops::and_(Ops::and_(byte_1_high, byte_1_low), byte_2_high);
+  // bit 7 where the byte 2 or 3 places back is a three- or four-byte lead:
+  // exactly there must the two_continuations bit be set
+  const vector prev2 = Ops::template prev<2>(input, previous);
+  const vector prev3 = Ops::template prev<3>(input, previous);
+  const vector must_continue =
+      Ops::or_(Ops::subs(prev2, Ops::set1(0xE0 - 0x80)),
+               Ops::subs(prev3, Ops::set1(0xF0 - 0x80)));
+  return Ops::xor_(Ops::and_(must_continue, Ops::set1(0x80)), special);
+}
+
+template <class Ops>
+typename Ops::vector incomplete(typename Ops::vector v) {
+  return Ops::subs(
+      v, Ops::load(lookup::incomplete_maximum + 64 - Ops::bytes));
+}
+
+template <class Ops>
+size_t check_blocks(const uint8_t *data, size_t n, const uint8_t *previous) {
+  typedef typename Ops::vector vector;
+  constexpr size_t count = 64 / Ops::bytes;
+  uint8_t before[Ops::bytes] = {0};
+  memcpy(before + Ops::bytes - 3, previous, 3);
+  vector prev = Ops::load(before);
+  vector prev_incomplete = incomplete<Ops>(prev);
+  for (size_t i = 0; i < n; i += 64) {
+    vector in[count];
+    vector all = Ops::load(data + i);
+    in[0] = all;
+    for (size_t k = 1; k < count; k++) {
+      in[k] = Ops::load(data + i + k * Ops::bytes);
+      all = Ops::or_(all, in[k]);
+    }
+    vector error;
+    if (Ops::is_ascii(all)) {
+      error = prev_incomplete;
+      prev_incomplete = Ops::set1(0);
+    } else {
+      error = check_vector<Ops>(in[0], prev);
+      for (size_t k = 1; k < count; k++) {
+        error = Ops::or_(error, check_vector<Ops>(in[k], in[k - 1]));
+      }
+      prev_incomplete = incomplete<Ops>(in[count - 1]);
+    }
+    if (Ops::nonzero(error)) {
+      return i;
+    }
+    prev = in[count - 1];
+  }
+  return n;
+}
+
+} // namespace utf8validate
+
+#endif // UTF8VALIDATE_KERNELS_H